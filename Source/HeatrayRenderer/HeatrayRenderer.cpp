@@ -16,6 +16,7 @@
 #include "Scene/SphereMeshProvider.h"
 #include "Session/Session.h"
 
+#include <RLWrapper/MemoryTracker.h>
 #include <RLWrapper/PixelPackBuffer.h>
 
 #include <Utility/FileDialog.h>
@@ -27,8 +28,13 @@
 #include "imgui/imgui.h"
 #include <FreeImage/FreeImage.h>
 
+#include <algorithm>
 #include <assert.h>
+#include <cctype>
+#include <chrono>
+#include <filesystem>
 #include <fstream>
+#include <future>
 #include <string_view>
 
 bool HeatrayRenderer::init(const GLint windowWidth, const GLint windowHeight)
@@ -41,6 +47,15 @@ bool HeatrayRenderer::init(const GLint windowWidth, const GLint windowHeight)
     m_renderWindowParams.height = windowHeight;
     m_renderer.init(m_renderWindowParams.width, m_renderWindowParams.height);
 
+    // Shaders edited while Heatray is running are rebuilt without reloading the scene.
+    {
+        std::error_code error;
+        const char* shaderDirectory = std::filesystem::exists("Resources/shaders", error) ? "Resources/shaders" : "../Resources/shaders";
+        if (!m_shaderWatcher.start(shaderDirectory, ".rlsl")) {
+            LOG_WARNING("Shader hot reloading is disabled");
+        }
+    }
+
     // Next setup OpenGL display data.
     {
         glewInit();
@@ -86,6 +101,12 @@ bool HeatrayRenderer::init(const GLint windowWidth, const GLint windowHeight)
 
 void HeatrayRenderer::destroy()
 {
+    if (m_renderService) {
+        m_renderService->stop();
+    }
+
+    m_shaderWatcher.stop();
+
     // Run a job to destroy any possible RL objects we may have created.
     m_renderer.destroy();
 
@@ -112,11 +133,19 @@ void HeatrayRenderer::resize(const GLint newWindowWidth, const GLint newWindowHe
     m_justResized = true;
 }
 
-void HeatrayRenderer::changeScene(const std::string &sceneName, const bool moveCamera)
+void HeatrayRenderer::changeScene(const std::string &sceneName, const bool moveCamera, const bool loadInBackground)
 {
     m_groundPlane.exists = false;
     m_sceneTransform = SceneTransform();
     m_renderOptions.scene = sceneName;
+    m_loadedScene.name = sceneName;
+    m_loadedScene.units = m_sceneUnits;
+    m_loadedScene.textureOptions = m_textureLoadOptions;
+    m_loadedScene.vertexFormat = m_vertexFormat;
+    m_loadedScene.meshOptimization = m_meshOptimization;
+    m_loadedScene.generateLods = m_generateLods;
+    m_sceneHasLods = false;
+    m_sceneSimplified = false;
 
     LOG_INFO("Loading scene: %s", sceneName.c_str());
 
@@ -285,15 +314,44 @@ void HeatrayRenderer::changeScene(const std::string &sceneName, const bool moveC
             }
         });
     } else {
-        m_renderer.loadScene([this, sceneName, moveCamera](std::shared_ptr<Scene> scene) {
-            scene->loadFromDisk(sceneName, (m_sceneUnits == SceneUnits::kCentimeters));
+        util::TextureLoadOptions textureOptions = m_textureLoadOptions;
+        VertexFormat vertexFormat = m_vertexFormat;
+        MeshOptimization meshOptimization = m_meshOptimization;
+        bool generateLods = m_generateLods;
+        bool convertToMeters = (m_sceneUnits == SceneUnits::kCentimeters);
+        if (!loadInBackground) {
+            m_renderer.loadScene([this, sceneName, moveCamera, convertToMeters, textureOptions, vertexFormat, meshOptimization, generateLods](std::shared_ptr<Scene> scene) {
+                scene->setTextureLoadOptions(textureOptions);
+                scene->loadFromDisk(sceneName, convertToMeters, VertexLayout::kInterleaved, vertexFormat, meshOptimization, true, generateLods);
+                m_sceneHasLods = scene->setSimplified(false);
+
+                // We'll automatically setup camera and AABB info if requested to do so.
+                if (moveCamera) {
+                    m_sceneAABB = scene->aabb();
+                    updateCameraFromAABB();
+                }
+            });
+            return;
+        }
 
-            // We'll automatically setup camera and AABB info if requested to do so.
-            if (moveCamera) {
-                m_sceneAABB = scene->aabb();
-                updateCameraFromAABB();
-            }
-        });
+        // The current scene keeps rendering while the new one is read from disk and built up a chunk at a time, render()
+        // restarts the accumulation once it has been swapped in.
+        m_renderer.loadSceneInBackground(
+            [sceneName, convertToMeters, textureOptions, vertexFormat, meshOptimization, generateLods](SceneLoadProgress& progress, uint64_t generation) {
+                return Scene::importFromDisk(sceneName, convertToMeters, VertexLayout::kInterleaved, vertexFormat, meshOptimization, true,
+                                             generateLods, textureOptions, generation, &progress);
+            },
+            [this, moveCamera, textureOptions](std::shared_ptr<Scene> scene, std::shared_ptr<SceneImport> /*sceneImport*/) {
+                scene->setTextureLoadOptions(textureOptions);
+                m_sceneHasLods = scene->setSimplified(false);
+
+                // We'll automatically setup camera and AABB info if requested to do so.
+                if (moveCamera) {
+                    m_sceneAABB = scene->aabb();
+                }
+                m_sceneSwapMovesCamera = moveCamera;
+                m_sceneSwapped = true;
+            });
     }
 }
 
@@ -359,9 +417,43 @@ void HeatrayRenderer::render()
         saveScreenshot();
     }
 
+    updateRenderService();
+
     m_resetRequested |= renderUI() | m_cameraUpdated;
+
+    // Trace the simplified meshes while the camera is moving and go back to full detail once it comes to rest.
+    if (m_cameraUpdated) {
+        m_cameraRestTimer.restart();
+        if (!m_sceneSimplified && m_sceneHasLods) {
+            m_renderer.modifyScene([](std::shared_ptr<Scene> scene) {
+                scene->setSimplified(true);
+            });
+            m_sceneSimplified = true;
+        }
+    } else if (m_sceneSimplified && (m_cameraRestTimer.getElapsedTime() > kCameraRestTime)) {
+        m_renderer.modifyScene([](std::shared_ptr<Scene> scene) {
+            scene->setSimplified(false);
+        });
+        m_sceneSimplified = false;
+        m_resetRequested = true;
+    }
     m_cameraUpdated = false;
 
+    // A scene loaded in the background has replaced the previous one, start accumulating it from scratch.
+    if (m_sceneSwapped.exchange(false)) {
+        if (m_sceneSwapMovesCamera) {
+            updateCameraFromAABB();
+        }
+        m_resetRequested = true;
+    }
+
+    // The watcher holds back bursts of writes so that a save results in a single reload.
+    std::vector<std::string> changedShaders = m_shaderWatcher.poll();
+    if (!changedShaders.empty()) {
+        m_renderer.reloadShaders(std::move(changedShaders));
+        m_resetRequested = true;
+    }
+
     // Kick the raytracer if necessary.
     if (!m_justResized && // Don't kick the renderer if we've just resized.
         ((!m_renderingFrame && (m_currentPass < m_totalPasses)) || // If we haven't yet rendered all passes and are not currently rendering a pass.
@@ -581,110 +673,130 @@ void HeatrayRenderer::writeSessionFile(const std::string_view filename)
     session.writeSessionFile(filename);
 }
 
-void HeatrayRenderer::readSessionFile(const std::string_view filename)
+bool HeatrayRenderer::readSessionFile(const std::string_view filename, const SessionOverrides& overrides, bool reuseLoadedScene)
 {
+    // Bad overrides are rejected before the session file replaces any of the current session variables.
     Session session;
-    if (session.parseSessionFile(filename)) {
-        // RenderOptions.
-        {
-            // General.
-            session.getVariableValue(Session::SessionVariable::kInteractiveMode, m_renderOptions.enableInteractiveMode);
-            session.getVariableValue(Session::SessionVariable::kInteractiveMode, m_renderOptions.enableOfflineMode);
-            session.getVariableValue(Session::SessionVariable::kMaxRenderPasses, m_renderOptions.maxRenderPasses);
-            session.getVariableValue(Session::SessionVariable::kMaxRayDepth, m_renderOptions.maxRayDepth);
-            session.getVariableValue(Session::SessionVariable::kMaxChannelValue, m_renderOptions.maxChannelValue);
-            session.getVariableValue(Session::SessionVariable::kScene, m_renderOptions.scene);
-            uint32_t tmp = 0;
-            session.getVariableValue(Session::SessionVariable::kSampleMode, tmp);
-            m_renderOptions.sampleMode = static_cast<PassGenerator::RenderOptions::SampleMode>(tmp);
-            session.getVariableValue(Session::SessionVariable::kBokehShape, tmp);
-            m_renderOptions.bokehShape = static_cast<PassGenerator::RenderOptions::BokehShape>(tmp);
-
-            // Environment.
-            {
-                session.getVariableValue(Session::SessionVariable::kEnvironmentMap, m_renderOptions.environment.map);
-                session.getVariableValue(Session::SessionVariable::kEnvironmentBuiltIn, m_renderOptions.environment.builtInMap);
-                session.getVariableValue(Session::SessionVariable::kEnvironmentExposureCompensation, m_renderOptions.environment.exposureCompensation);
-                session.getVariableValue(Session::SessionVariable::kEnvironmentThetaRotation, m_renderOptions.environment.thetaRotation);
-                session.getVariableValue(Session::SessionVariable::kEnvironmentMapSolidColorX, m_renderOptions.environment.solidColor.x);
-                session.getVariableValue(Session::SessionVariable::kEnvironmentMapSolidColorY, m_renderOptions.environment.solidColor.y);
-                session.getVariableValue(Session::SessionVariable::kEnvironmentMapSolidColorZ, m_renderOptions.environment.solidColor.z);
-            }
+    if (!session.validateVariableValues(overrides) || !session.parseSessionFile(filename) || !session.setVariableValues(overrides)) {
+        return false;
+    }
 
-            // Camera.
-            {
-                session.getVariableValue(Session::SessionVariable::kCameraAspectRatio, m_renderOptions.camera.aspectRatio);
-                session.getVariableValue(Session::SessionVariable::kCameraFocusDistance, m_renderOptions.camera.focusDistance);
-                session.getVariableValue(Session::SessionVariable::kCameraFocalLength, m_renderOptions.camera.focalLength);
-                session.getVariableValue(Session::SessionVariable::kCameraApertureRadius, m_renderOptions.camera.apertureRadius);
-                session.getVariableValue(Session::SessionVariable::kCameraFStop, m_renderOptions.camera.fstop);
-            }
-        }
+    // RenderOptions.
+    {
+        // General.
+        session.getVariableValue(Session::SessionVariable::kInteractiveMode, m_renderOptions.enableInteractiveMode);
+        session.getVariableValue(Session::SessionVariable::kInteractiveMode, m_renderOptions.enableOfflineMode);
+        session.getVariableValue(Session::SessionVariable::kMaxRenderPasses, m_renderOptions.maxRenderPasses);
+        session.getVariableValue(Session::SessionVariable::kMaxRayDepth, m_renderOptions.maxRayDepth);
+        session.getVariableValue(Session::SessionVariable::kMaxChannelValue, m_renderOptions.maxChannelValue);
+        session.getVariableValue(Session::SessionVariable::kScene, m_renderOptions.scene);
+        uint32_t tmp = 0;
+        session.getVariableValue(Session::SessionVariable::kSampleMode, tmp);
+        m_renderOptions.sampleMode = static_cast<PassGenerator::RenderOptions::SampleMode>(tmp);
+        session.getVariableValue(Session::SessionVariable::kBokehShape, tmp);
+        m_renderOptions.bokehShape = static_cast<PassGenerator::RenderOptions::BokehShape>(tmp);
 
-        // Camera.
+        // Environment.
         {
-            session.getVariableValue(Session::SessionVariable::kOrbitDistance, m_camera.orbitCamera.distance);
-            session.getVariableValue(Session::SessionVariable::kOrbitPhi, m_camera.orbitCamera.phi);
-            session.getVariableValue(Session::SessionVariable::kOrbitTheta, m_camera.orbitCamera.theta);
-            session.getVariableValue(Session::SessionVariable::kOrbitTargetX, m_camera.orbitCamera.target.x);
-            session.getVariableValue(Session::SessionVariable::kOrbitTargetY, m_camera.orbitCamera.target.y);
-            session.getVariableValue(Session::SessionVariable::kOrbitTargetZ, m_camera.orbitCamera.target.z);
-            session.getVariableValue(Session::SessionVariable::kOrbitMaxDistance, m_camera.orbitCamera.max_distance);
+            session.getVariableValue(Session::SessionVariable::kEnvironmentMap, m_renderOptions.environment.map);
+            session.getVariableValue(Session::SessionVariable::kEnvironmentBuiltIn, m_renderOptions.environment.builtInMap);
+            session.getVariableValue(Session::SessionVariable::kEnvironmentExposureCompensation, m_renderOptions.environment.exposureCompensation);
+            session.getVariableValue(Session::SessionVariable::kEnvironmentThetaRotation, m_renderOptions.environment.thetaRotation);
+            session.getVariableValue(Session::SessionVariable::kEnvironmentMapSolidColorX, m_renderOptions.environment.solidColor.x);
+            session.getVariableValue(Session::SessionVariable::kEnvironmentMapSolidColorY, m_renderOptions.environment.solidColor.y);
+            session.getVariableValue(Session::SessionVariable::kEnvironmentMapSolidColorZ, m_renderOptions.environment.solidColor.z);
         }
 
-        // Scene.
-        {
-            uint32_t tmp = 0;
-            session.getVariableValue(Session::SessionVariable::kUnits, tmp);
-            m_sceneUnits = static_cast<SceneUnits>(tmp);
-            session.getVariableValue(Session::SessionVariable::kAABB_MinX, m_sceneAABB.min.x);
-            session.getVariableValue(Session::SessionVariable::kAABB_MinY, m_sceneAABB.min.y);
-            session.getVariableValue(Session::SessionVariable::kAABB_MinZ, m_sceneAABB.min.z);
-            session.getVariableValue(Session::SessionVariable::kAABB_MaxX, m_sceneAABB.max.x);
-            session.getVariableValue(Session::SessionVariable::kAABB_MaxY, m_sceneAABB.max.y);
-            session.getVariableValue(Session::SessionVariable::kAABB_MaxZ, m_sceneAABB.max.z);
-            session.getVariableValue(Session::SessionVariable::kRotationYaw, m_sceneTransform.yaw);
-            session.getVariableValue(Session::SessionVariable::kRotationPitch, m_sceneTransform.pitch);
-            session.getVariableValue(Session::SessionVariable::kRotationRoll, m_sceneTransform.roll);
-            session.getVariableValue(Session::SessionVariable::kScale, m_sceneTransform.scale);
-        }
-
-        // Post processing.
-        {
-            session.getVariableValue(Session::SessionVariable::kTonemapEnable, m_post_processing_params.tonemapping_enabled);
-            session.getVariableValue(Session::SessionVariable::kExposure, m_post_processing_params.exposure);
-            session.getVariableValue(Session::SessionVariable::kBrightness, m_post_processing_params.brightness);
-            session.getVariableValue(Session::SessionVariable::kContrast, m_post_processing_params.contrast);
-            session.getVariableValue(Session::SessionVariable::kHue, m_post_processing_params.hue);
-            session.getVariableValue(Session::SessionVariable::kSaturation, m_post_processing_params.saturation);
-            session.getVariableValue(Session::SessionVariable::kVibrance, m_post_processing_params.vibrance);
-            session.getVariableValue(Session::SessionVariable::kRed, m_post_processing_params.red);
-            session.getVariableValue(Session::SessionVariable::kGreen, m_post_processing_params.green);
-            session.getVariableValue(Session::SessionVariable::kBlue, m_post_processing_params.blue);
-            session.getVariableValue(Session::SessionVariable::kVignetteIntensity, m_post_processing_params.vignetteIntensity);
-            session.getVariableValue(Session::SessionVariable::kVignetteFalloff, m_post_processing_params.vignetteFalloff);
-        }
-
-        // Now actually process the parameters. NOTE: we do not allow the camera to be reset because we want to use
-        // the values present in the session file.
-        changeScene(m_renderOptions.scene, false);
-        
-        // Ensure that the proper transform is applied to the scene AABB and the scene itself.
+        // Camera.
         {
-            m_renderer.modifyScene([this](std::shared_ptr<Scene> scene) {
-                glm::mat4 transform = m_sceneTransform.transform();
-                scene->applyTransform(transform);
-                
-                if (m_sceneAABB.valid()) {
-                    m_sceneAABB.transform = transform;
-                    updateCameraFromAABB();
-                }
-            });
+            session.getVariableValue(Session::SessionVariable::kCameraAspectRatio, m_renderOptions.camera.aspectRatio);
+            session.getVariableValue(Session::SessionVariable::kCameraFocusDistance, m_renderOptions.camera.focusDistance);
+            session.getVariableValue(Session::SessionVariable::kCameraFocalLength, m_renderOptions.camera.focalLength);
+            session.getVariableValue(Session::SessionVariable::kCameraApertureRadius, m_renderOptions.camera.apertureRadius);
+            session.getVariableValue(Session::SessionVariable::kCameraFStop, m_renderOptions.camera.fstop);
         }
-        
-        // NOTE: most everything is handled automatically during a reset.
-        resetRenderer();
     }
+
+    // Camera.
+    {
+        session.getVariableValue(Session::SessionVariable::kOrbitDistance, m_camera.orbitCamera.distance);
+        session.getVariableValue(Session::SessionVariable::kOrbitPhi, m_camera.orbitCamera.phi);
+        session.getVariableValue(Session::SessionVariable::kOrbitTheta, m_camera.orbitCamera.theta);
+        session.getVariableValue(Session::SessionVariable::kOrbitTargetX, m_camera.orbitCamera.target.x);
+        session.getVariableValue(Session::SessionVariable::kOrbitTargetY, m_camera.orbitCamera.target.y);
+        session.getVariableValue(Session::SessionVariable::kOrbitTargetZ, m_camera.orbitCamera.target.z);
+        session.getVariableValue(Session::SessionVariable::kOrbitMaxDistance, m_camera.orbitCamera.max_distance);
+    }
+
+    // Scene.
+    {
+        uint32_t tmp = 0;
+        session.getVariableValue(Session::SessionVariable::kUnits, tmp);
+        m_sceneUnits = static_cast<SceneUnits>(tmp);
+        session.getVariableValue(Session::SessionVariable::kAABB_MinX, m_sceneAABB.min.x);
+        session.getVariableValue(Session::SessionVariable::kAABB_MinY, m_sceneAABB.min.y);
+        session.getVariableValue(Session::SessionVariable::kAABB_MinZ, m_sceneAABB.min.z);
+        session.getVariableValue(Session::SessionVariable::kAABB_MaxX, m_sceneAABB.max.x);
+        session.getVariableValue(Session::SessionVariable::kAABB_MaxY, m_sceneAABB.max.y);
+        session.getVariableValue(Session::SessionVariable::kAABB_MaxZ, m_sceneAABB.max.z);
+        session.getVariableValue(Session::SessionVariable::kRotationYaw, m_sceneTransform.yaw);
+        session.getVariableValue(Session::SessionVariable::kRotationPitch, m_sceneTransform.pitch);
+        session.getVariableValue(Session::SessionVariable::kRotationRoll, m_sceneTransform.roll);
+        session.getVariableValue(Session::SessionVariable::kScale, m_sceneTransform.scale);
+    }
+
+    // Post processing.
+    {
+        session.getVariableValue(Session::SessionVariable::kTonemapEnable, m_post_processing_params.tonemapping_enabled);
+        session.getVariableValue(Session::SessionVariable::kExposure, m_post_processing_params.exposure);
+        session.getVariableValue(Session::SessionVariable::kBrightness, m_post_processing_params.brightness);
+        session.getVariableValue(Session::SessionVariable::kContrast, m_post_processing_params.contrast);
+        session.getVariableValue(Session::SessionVariable::kHue, m_post_processing_params.hue);
+        session.getVariableValue(Session::SessionVariable::kSaturation, m_post_processing_params.saturation);
+        session.getVariableValue(Session::SessionVariable::kVibrance, m_post_processing_params.vibrance);
+        session.getVariableValue(Session::SessionVariable::kRed, m_post_processing_params.red);
+        session.getVariableValue(Session::SessionVariable::kGreen, m_post_processing_params.green);
+        session.getVariableValue(Session::SessionVariable::kBlue, m_post_processing_params.blue);
+        session.getVariableValue(Session::SessionVariable::kVignetteIntensity, m_post_processing_params.vignetteIntensity);
+        session.getVariableValue(Session::SessionVariable::kVignetteFalloff, m_post_processing_params.vignetteFalloff);
+    }
+
+    // Now actually process the parameters. NOTE: we do not allow the camera to be reset because we want to use
+    // the values present in the session file. The scene is loaded synchronously so that the scene transform below
+    // is applied to it.
+    if (!reuseLoadedScene ||
+        (m_loadedScene.name != m_renderOptions.scene) ||
+        (m_loadedScene.units != m_sceneUnits) ||
+        (m_loadedScene.textureOptions != m_textureLoadOptions) ||
+        (m_loadedScene.vertexFormat != m_vertexFormat) ||
+        (m_loadedScene.meshOptimization != m_meshOptimization) ||
+        (m_loadedScene.generateLods != m_generateLods)) {
+        changeScene(m_renderOptions.scene, false, false);
+    } else {
+        LOG_INFO("Reusing loaded scene: %s", m_renderOptions.scene.c_str());
+    }
+    
+    // Ensure that the proper transform is applied to the scene AABB and the scene itself.
+    {
+        m_renderer.modifyScene([this](std::shared_ptr<Scene> scene) {
+            glm::mat4 transform = m_sceneTransform.transform();
+            scene->applyTransform(transform);
+            
+            if (m_sceneAABB.valid()) {
+                m_sceneAABB.transform = transform;
+                updateCameraFromAABB();
+            }
+
+            // A checkpoint of this session is picked up once the session has been applied, not by a reset that is still in flight.
+            m_renderer.resumeCheckpointOnNextReset();
+            m_sessionSceneStateHash = scene->stateHash();
+        });
+    }
+    
+    // NOTE: most everything is handled automatically during a reset.
+    resetRenderer();
+
+    return true;
 }
 
 bool HeatrayRenderer::renderMaterialEditor(std::shared_ptr<Material> material)
@@ -775,20 +887,21 @@ bool HeatrayRenderer::renderMaterialEditor(std::shared_ptr<Material> material)
         }
 
         if (materialChanged) {
-            m_renderer.runOpenRLTask([this, pbrMaterial, texturePath, textureType]() {
+            util::TextureLoadOptions textureOptions = m_textureLoadOptions;
+            m_renderer.runOpenRLTask([this, pbrMaterial, texturePath, textureType, textureOptions]() {
                 if (texturePath.empty() == false) {
                     switch (textureType) {
                     case TextureType::kBaseColor:
-                        pbrMaterial->parameters().baseColorTexture = util::loadTexture(texturePath.c_str(), true, true);
+                        pbrMaterial->parameters().baseColorTexture = util::loadTexture(texturePath.c_str(), true, true, textureOptions);
                         break;
                     case TextureType::kMetallicRoughness:
-                        pbrMaterial->parameters().metallicRoughnessTexture = util::loadTexture(texturePath.c_str(), true, false);
+                        pbrMaterial->parameters().metallicRoughnessTexture = util::loadTexture(texturePath.c_str(), true, false, textureOptions);
                         break;
                     case TextureType::kClearCoat:
-                        pbrMaterial->parameters().clearCoatTexture = util::loadTexture(texturePath.c_str(), true, false);
+                        pbrMaterial->parameters().clearCoatTexture = util::loadTexture(texturePath.c_str(), true, false, textureOptions);
                         break;
                     case TextureType::kClearCoatRoughness:
-                        pbrMaterial->parameters().clearCoatRoughnessTexture = util::loadTexture(texturePath.c_str(), true, false);
+                        pbrMaterial->parameters().clearCoatRoughnessTexture = util::loadTexture(texturePath.c_str(), true, false, textureOptions);
                         break;
                     default:
                         break;
@@ -850,14 +963,15 @@ bool HeatrayRenderer::renderMaterialEditor(std::shared_ptr<Material> material)
         }
 
         if (materialChanged) {
-            m_renderer.runOpenRLTask([this, glassMaterial, texturePath, textureType]() {
+            util::TextureLoadOptions textureOptions = m_textureLoadOptions;
+            m_renderer.runOpenRLTask([this, glassMaterial, texturePath, textureType, textureOptions]() {
                 if (texturePath.empty() == false) {
                     switch (textureType) {
                     case TextureType::kBaseColor:
-                        glassMaterial->parameters().baseColorTexture = util::loadTexture(texturePath.c_str(), true, true);
+                        glassMaterial->parameters().baseColorTexture = util::loadTexture(texturePath.c_str(), true, true, textureOptions);
                         break;
                     case TextureType::kMetallicRoughness:
-                        glassMaterial->parameters().metallicRoughnessTexture = util::loadTexture(texturePath.c_str(), true, false);
+                        glassMaterial->parameters().metallicRoughnessTexture = util::loadTexture(texturePath.c_str(), true, false, textureOptions);
                         break;
                     default:
                         break;
@@ -960,6 +1074,15 @@ bool HeatrayRenderer::renderUI()
         ImGui::Text("Pass time(s): %f\n", m_currentPassTime);
         ImGui::Text("Total render time(s): %f\n", m_totalRenderTime);
     }
+    if (m_renderer.sceneLoadPending()) {
+        const SceneLoadProgress& progress = m_renderer.sceneLoadProgress();
+        uint32_t textureCount = progress.textureCount;
+        uint32_t texturesDecoded = progress.texturesDecoded;
+        ImGui::Text("Loading scene: %s\n", SceneLoadProgress::stageName(progress.stage));
+        ImGui::Text("Meshes: %u Textures: %u/%u (%.1f MB)\n", uint32_t(progress.meshCount), texturesDecoded, textureCount,
+                    double(progress.bytesLoaded) / (1024.0 * 1024.0));
+        ImGui::ProgressBar((textureCount > 0) ? (float(texturesDecoded) / float(textureCount)) : 0.0f);
+    }
     if (ImGui::CollapsingHeader("Session")) {
         ImGui::PushID("Session_Save");
         if (ImGui::Button("Save")) {
@@ -1010,6 +1133,10 @@ bool HeatrayRenderer::renderUI()
             if (ImGui::SliderFloat("Max channel value", &(m_renderOptions.maxChannelValue), 0.0f, 10.0f)) {
                 shouldResetRenderer = true;
             }
+            ImGui::Checkbox("Enable checkpoints", &m_renderOptions.checkpoint.enabled);
+            if (m_renderOptions.checkpoint.enabled) {
+                ImGui::SliderInt("Passes per checkpoint", (int*)(&m_renderOptions.checkpoint.passInterval), 1, 256);
+            }
         }
         {
             static constexpr std::string_view options[] = { "Pseudo-random", "Halton", "Hammersley", "Blue Noise", "Sobol", };
@@ -1099,6 +1226,44 @@ bool HeatrayRenderer::renderUI()
             m_sceneUnits = SceneUnits::kCentimeters;
         }
 
+        // Texture limits only apply to scenes and textures loaded after they are changed.
+        {
+            static constexpr uint32_t maxDimensions[] = { 0, 8192, 4096, 2048, 1024, 512 };
+            static constexpr const char* maxDimensionNames[] = { "No Limit", "8192", "4096", "2048", "1024", "512" };
+            int currentDimension = 0;
+            for (int iOption = 0; iOption < int(sizeof(maxDimensions) / sizeof(maxDimensions[0])); ++iOption) {
+                if (maxDimensions[iOption] == m_textureLoadOptions.maxDimension) {
+                    currentDimension = iOption;
+                }
+            }
+            if (ImGui::Combo("Max Texture Size", &currentDimension, maxDimensionNames, int(sizeof(maxDimensions) / sizeof(maxDimensions[0])))) {
+                m_textureLoadOptions.maxDimension = maxDimensions[currentDimension];
+            }
+
+            static constexpr const char* storageNames[] = { "Source", "8-bit", "32-bit Float" };
+            int currentStorage = static_cast<int>(m_textureLoadOptions.storage);
+            if (ImGui::Combo("Texture Storage", &currentStorage, storageNames, int(sizeof(storageNames) / sizeof(storageNames[0])))) {
+                m_textureLoadOptions.storage = static_cast<util::TextureStorage>(currentStorage);
+            }
+        }
+
+        // Quantized normals, tangents and texture coordinates use less memory for large scenes.
+        bool compactVertices = (m_vertexFormat == VertexFormat::kCompact);
+        if (ImGui::Checkbox("Compact Vertices", &compactVertices)) {
+            m_vertexFormat = compactVertices ? VertexFormat::kCompact : VertexFormat::kFloat;
+        }
+
+        // Reordering the triangles and vertices of each mesh improves the memory locality of the geometry.
+        static constexpr const char* meshOptimizationNames[] = { "None", "Vertex Cache", "Spatial" };
+        int currentMeshOptimization = static_cast<int>(m_meshOptimization);
+        if (ImGui::Combo("Mesh Optimization", &currentMeshOptimization, meshOptimizationNames,
+                         int(sizeof(meshOptimizationNames) / sizeof(meshOptimizationNames[0])))) {
+            m_meshOptimization = static_cast<MeshOptimization>(currentMeshOptimization);
+        }
+
+        // Simplified meshes keep the camera responsive in large scenes, the full detail meshes are traced again once it stops.
+        ImGui::Checkbox("Interactive LODs", &m_generateLods);
+
         static constexpr std::string_view options[] = { "Sphere Array", "Multi-Material", "Editable PBR Material", "Editable Glass Material", "Load Custom..."};
         static constexpr size_t NUM_OPTIONS = sizeof(options) / sizeof(options[0]);
         static constexpr size_t CUSTOM_OPTION_INDEX = NUM_OPTIONS - 1;
@@ -1173,9 +1338,12 @@ bool HeatrayRenderer::renderUI()
             }
             m_renderer.modifyScene([this, deleteGroundPlane](std::shared_ptr<Scene> scene) {
                 if (deleteGroundPlane) {
-                    scene->removeMesh(m_groundPlane.meshIndex);
+                    scene->removeMesh(m_groundPlane.mesh);
                 } else {
-                    size_t planeSize = std::max(size_t(1), size_t(m_sceneAABB.radius())) * 5;
+                    // The plane is added below the scene transform so it is placed relative to the untransformed scene.
+                    util::AABB sceneAABB = m_sceneAABB;
+                    sceneAABB.transform = glm::mat4(1.0f);
+                    size_t planeSize = std::max(size_t(1), size_t(sceneAABB.radius())) * 5;
                     PlaneMeshProvider planeMeshProvider(planeSize, planeSize, "Ground Plane");
 
                     std::shared_ptr<PhysicallyBasedMaterial> material = std::make_shared<PhysicallyBasedMaterial>("Ground Plane");
@@ -1185,9 +1353,9 @@ bool HeatrayRenderer::renderUI()
                     params.baseColor = glm::vec3(0.9f);
                     params.specularF0 = 0.2f;
                     params.forceEnableAllTextures = true;
-                    glm::mat4 translation = glm::translate(glm::mat4(1.0f), glm::vec3(0.0f, m_sceneAABB.bottom(), 0.0f));
+                    glm::mat4 translation = glm::translate(glm::mat4(1.0f), glm::vec3(0.0f, sceneAABB.bottom(), 0.0f));
 
-                    m_groundPlane.meshIndex = scene->addMesh(&planeMeshProvider, { material }, translation);
+                    m_groundPlane.mesh = scene->addMesh(&planeMeshProvider, { material }, translation);
                 }
 
                 resetRenderer();
@@ -1253,7 +1421,7 @@ bool HeatrayRenderer::renderUI()
                 if (ImGui::Selectable(NONE.data(), false)) {
                     currentlySelectedMaterial.reset();
                 } else {
-                    const std::vector<Mesh>& sceneData = m_renderer.scene()->meshes();
+                    const Scene::Meshes& sceneData = m_renderer.scene()->meshes();
                     for (auto& mesh : sceneData) {
                         for (auto& material : mesh.materials()) {
                             if (ImGui::Selectable(material->name().data(), false)) {
@@ -1475,6 +1643,33 @@ bool HeatrayRenderer::renderUI()
         }
         ImGui::PopID();
     }
+    if (ImGui::CollapsingHeader("GPU memory")) {
+        constexpr size_t kTopConsumerCount = 16;
+        constexpr double kBytesToMB = 1.0 / (1024.0 * 1024.0);
+
+        openrl::MemoryTracker& tracker = openrl::MemoryTracker::instance();
+        openrl::MemoryTracker::Report report = tracker.report(kTopConsumerCount);
+        ImGui::Text("Total: %.2f MB in %zu allocations", double(report.totalBytes) * kBytesToMB, report.totalAllocations);
+        for (size_t ii = 0; ii < openrl::MemoryTracker::kCategoryCount; ++ii) {
+            ImGui::BulletText("%s: %.2f MB (%zu)", openrl::MemoryTracker::categoryName(openrl::MemoryTracker::Category(ii)),
+                              double(report.categoryBytes[ii]) * kBytesToMB, report.categoryAllocations[ii]);
+        }
+        if (ImGui::TreeNode("Largest consumers")) {
+            for (const openrl::MemoryTracker::Consumer& consumer : report.topConsumers) {
+                ImGui::Text("%8.2f MB  %s", double(consumer.sizeInBytes) * kBytesToMB, consumer.tag.c_str());
+                if (ImGui::IsItemHovered()) {
+                    ImGui::SetTooltip("%s, %zu allocation(s)", openrl::MemoryTracker::categoryName(consumer.category), consumer.allocationCount);
+                }
+            }
+            ImGui::TreePop();
+        }
+        if (ImGui::Button("Write Report")) {
+            std::vector<std::string> names = util::SaveFileDialog("json");
+            if (!names.empty() && !tracker.writeReport(names[0], kTopConsumerCount)) {
+                LOG_ERROR("Unable to write the GPU memory report to %s", names[0].c_str());
+            }
+        }
+    }
     if (ImGui::CollapsingHeader("Developer")) {
         if (ImGui::Button("Generate MultiScatter LUT")) {
             generateMultiScatterTexture();
@@ -1607,6 +1802,106 @@ void HeatrayRenderer::resetRenderer()
     m_totalRenderTime = 0.0f;
 }
 
+bool HeatrayRenderer::startRenderService(uint16_t port, const std::string& outputDirectory)
+{
+    m_renderService = std::make_unique<RenderService>();
+    if (!m_renderService->start(outputDirectory, port)) {
+        m_renderService.reset();
+        return false;
+    }
+    return true;
+}
+
+void HeatrayRenderer::updateRenderService()
+{
+    if (!m_renderService) {
+        return;
+    }
+
+    if (m_serviceJob) {
+        if (m_currentPass != m_serviceJob->reportedPass) {
+            m_serviceJob->reportedPass = m_currentPass;
+            m_renderService->reportProgress(m_serviceJob->id, m_currentPass, m_totalPasses);
+        }
+
+        // The job is done once the final pass has been copied into the display texture.
+        bool finalPassDisplayed = !m_renderingFrame &&
+                                  !m_resetRequested &&
+                                  !m_renderOptions.resetInternalState &&
+                                  (m_currentPass >= m_totalPasses) &&
+                                  !m_shouldCopyPixels.test() &&
+                                  !m_renderer.sceneLoadPending() &&
+                                  !m_sceneSwapped;
+        if (finalPassDisplayed) {
+            m_screenshotPath = m_serviceJob->outputPath;
+            bool success = saveScreenshot();
+            m_renderService->reportComplete(m_serviceJob->id, success, success ? m_screenshotPath : "Unable to write output image");
+
+            // Hand the renderer back the way the job found it.
+            m_renderOptions.enableInteractiveMode = m_serviceJob->interactiveMode;
+            m_renderOptions.enableOfflineMode = m_serviceJob->offlineMode;
+            m_hdrScreenshot = m_serviceJob->hdrScreenshot;
+            m_screenshotPath = m_serviceJob->screenshotPath;
+            m_serviceJob.reset();
+            resetRenderer();
+        }
+    }
+
+    // Jobs are not picked up while a scene is loading, and the loaded scene is only reused if nothing
+    // (materials, lights, transforms) was edited since the last session was applied to it. The scene
+    // lives on the OpenRL thread, so it is compared there and the job starts in a later frame rather
+    // than the UI waiting for the tasks queued ahead of the comparison.
+    if (!m_serviceJob && !m_pendingServiceJob && !m_renderer.sceneLoadPending()) {
+        if (std::optional<RenderService::Job> job = m_renderService->popJob()) {
+            auto sceneUnchanged = std::make_shared<std::promise<bool>>();
+            m_pendingServiceJobSceneUnchanged = sceneUnchanged->get_future();
+            m_pendingServiceJob = std::move(job);
+            m_renderer.runOpenRLTask([this, sceneUnchanged]() {
+                sceneUnchanged->set_value(m_renderer.scene()->stateHash() == m_sessionSceneStateHash);
+            });
+        }
+    }
+
+    // Only start the job once the renderer is idle so that no stale pass is attributed to it.
+    if (m_pendingServiceJob && !m_renderingFrame &&
+        (m_pendingServiceJobSceneUnchanged.wait_for(std::chrono::seconds(0)) == std::future_status::ready)) {
+        const bool reuseLoadedScene = m_pendingServiceJobSceneUnchanged.get();
+        RenderService::Job job = std::move(*m_pendingServiceJob);
+        m_pendingServiceJob.reset();
+        startServiceJob(job, reuseLoadedScene);
+    }
+}
+
+void HeatrayRenderer::startServiceJob(const RenderService::Job& job, bool reuseLoadedScene)
+{
+    LOG_INFO("Starting render service job %llu: %s", static_cast<unsigned long long>(job.id), job.sessionPath.c_str());
+
+    ServiceJob serviceJob;
+    serviceJob.id = job.id;
+    serviceJob.outputPath = job.outputPath;
+    serviceJob.interactiveMode = m_renderOptions.enableInteractiveMode;
+    serviceJob.offlineMode = m_renderOptions.enableOfflineMode;
+    serviceJob.hdrScreenshot = m_hdrScreenshot;
+    serviceJob.screenshotPath = m_screenshotPath;
+
+    if (!readSessionFile(job.sessionPath, job.overrides, reuseLoadedScene)) {
+        m_renderService->reportComplete(job.id, false, "Unable to read session file or apply overrides");
+        return;
+    }
+
+    // Service jobs render every pixel each pass so that progress can be reported per pass.
+    m_renderOptions.enableInteractiveMode = false;
+    m_renderOptions.enableOfflineMode = false;
+    resetRenderer();
+
+    // Float formats get the raw radiance, everything else gets the tonemapped display.
+    std::string extension = std::filesystem::path(job.outputPath).extension().string();
+    std::transform(extension.begin(), extension.end(), extension.begin(), [](unsigned char c) { return char(std::tolower(c)); });
+    m_hdrScreenshot = (extension == ".exr") || (extension == ".hdr") || (extension == ".tif") || (extension == ".tiff");
+
+    m_serviceJob = serviceJob;
+}
+
 void FreeImageErrorHandler(FREE_IMAGE_FORMAT fif, const char* message) {
     LOG_ERROR("FreeImage*** ");
     if (fif != FIF_UNKNOWN) {
@@ -1616,7 +1911,7 @@ void FreeImageErrorHandler(FREE_IMAGE_FORMAT fif, const char* message) {
     LOG_ERROR("***");
 }
 
-void HeatrayRenderer::saveScreenshot()
+bool HeatrayRenderer::saveScreenshot()
 {
     FreeImage_Initialise();
     FreeImage_SetOutputMessage(FreeImageErrorHandler);
@@ -1656,7 +1951,8 @@ void HeatrayRenderer::saveScreenshot()
         glReadPixels(UI_WINDOW_WIDTH * scale, 0, m_pixelDimensions.x * scale, m_pixelDimensions.y * scale, GL_BGR, GL_UNSIGNED_BYTE, pixelData);
     }
 
-    FreeImage_Save(FreeImage_GetFIFFromFilename(m_screenshotPath.c_str()), bitmap, m_screenshotPath.c_str(), 0);
+    bool saved = (FreeImage_Save(FreeImage_GetFIFFromFilename(m_screenshotPath.c_str()), bitmap, m_screenshotPath.c_str(), 0) != FALSE);
     FreeImage_DeInitialise();
     m_shouldSaveScreenshot = false;
+    return saved;
 }
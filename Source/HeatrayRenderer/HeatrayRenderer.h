@@ -22,16 +22,24 @@
 #include "OrbitCamera.h"
 #include "PassGenerator.h"
 #include "Scene/Scene.h"
+#include "Service/RenderService.h"
 
 #include <Utility/FileIO.h>
+#include <Utility/FileWatcher.h>
 #include <Utility/AABB.h>
+#include <Utility/TextureLoader.h>
+#include <Utility/Timer.h>
 
 #include <glm/glm/mat4x4.hpp>
 #include <glm/glm/gtx/euler_angles.hpp>
 #include <glm/glm/gtc/matrix_transform.hpp>
 
 #include <atomic>
+#include <future>
 #include <memory>
+#include <optional>
+#include <utility>
+#include <vector>
 
 // Forward declarations.
 class Material;
@@ -66,8 +74,11 @@ public:
 
     //-------------------------------------------------------------------------
     // Load a new scene from disk. If 'moveCamera' is true, the camera will be
-    // moved to a new location based on the size of the new scene.
-    void changeScene(const std::string &sceneName, bool moveCamera);
+    // moved to a new location based on the size of the new scene. If
+    // 'loadInBackground' is true then the current scene keeps rendering until
+    // the new one has been read from disk, otherwise it is loaded before any
+    // subsequent OpenRL job runs.
+    void changeScene(const std::string &sceneName, bool moveCamera, bool loadInBackground = true);
 
     //-------------------------------------------------------------------------
     // Load a new environment map to use for image-based lighting.
@@ -85,6 +96,12 @@ public:
     // Reset the renderer's internal state.
     void resetRenderer();
 
+    //-------------------------------------------------------------------------
+    // Start accepting render jobs from local clients (see RenderService.h).
+    // Jobs are rendered one at a time in between interactive use of the UI
+    // and can only write their images into 'outputDirectory'.
+    bool startRenderService(uint16_t port, const std::string& outputDirectory);
+
     // Fixed pixel width of the ImGui UI.
     static constexpr size_t UI_WINDOW_WIDTH = 500;
 
@@ -96,10 +113,18 @@ private:
     void resizeGLData();
     void generateSequenceVisualizationData(int sequenceIndex, int renderPasses, bool aperture);
     bool renderUI();
-    void saveScreenshot();
+    bool saveScreenshot();
 
+    //-------------------------------------------------------------------------
+    // Session overrides are applied on top of the values read from the session
+    // file. If 'reuseLoadedScene' is true and the session refers to the scene
+    // that is already loaded then the scene is not reloaded from disk.
+    using SessionOverrides = std::vector<std::pair<std::string, std::string>>;
     void writeSessionFile(const std::string_view filename);
-    void readSessionFile(const std::string_view filename);
+    bool readSessionFile(const std::string_view filename, const SessionOverrides& overrides = {}, bool reuseLoadedScene = false);
+
+    void updateRenderService();
+    void startServiceJob(const RenderService::Job& job, bool reuseLoadedScene);
 
     struct PostProcessingParams {
         bool tonemapping_enabled = false;
@@ -304,6 +329,21 @@ private:
         kCentimeters
     };
     SceneUnits m_sceneUnits = SceneUnits::kMeters;
+    util::TextureLoadOptions m_textureLoadOptions; // Applied to all textures loaded for the scene and its materials.
+    VertexFormat m_vertexFormat = VertexFormat::kFloat; // Format of the vertex data of scenes loaded from disk.
+    MeshOptimization m_meshOptimization = MeshOptimization::kNone; // Reordering applied to the meshes of scenes loaded from disk.
+    bool m_generateLods = false; // Trace simplified meshes while the camera is moving, opt in since it costs load time and memory.
+
+    // Scene most recently passed to changeScene(), used to avoid reloading it for render service jobs.
+    struct LoadedScene {
+        std::string name;
+        SceneUnits units = SceneUnits::kMeters;
+        util::TextureLoadOptions textureOptions;
+        VertexFormat vertexFormat = VertexFormat::kFloat;
+        MeshOptimization meshOptimization = MeshOptimization::kNone;
+        bool generateLods = false;
+    } m_loadedScene;
+    uint64_t m_sessionSceneStateHash = 0; // Scene::stateHash() once the last session was applied, only accessed on the OpenRL thread.
 
     float m_currentPassTime = 0.0f;
     float m_totalRenderTime = 0.0f;
@@ -312,16 +352,47 @@ private:
     bool m_hdrScreenshot = false;
     bool m_shouldSaveScreenshot = false;
 
+    std::unique_ptr<RenderService> m_renderService = nullptr;
+    struct ServiceJob {
+        uint64_t id = 0;
+        std::string outputPath;
+        size_t reportedPass = 0;
+
+        // Interactive state replaced by the job, restored once it is done.
+        bool interactiveMode = false;
+        bool offlineMode = false;
+        bool hdrScreenshot = false;
+        std::string screenshotPath;
+    };
+    std::optional<ServiceJob> m_serviceJob; // Render service job currently being rendered.
+
+    // Job taken from the service that starts once the OpenRL thread has compared the
+    // scene against the last applied session (see startServiceJob()).
+    std::optional<RenderService::Job> m_pendingServiceJob;
+    std::future<bool> m_pendingServiceJobSceneUnchanged;
+
     util::AABB m_sceneAABB;
 
     struct GroundPlane {
-        size_t meshIndex = 0;
+        Scene::MeshHandle mesh;
         bool exists = false;
     } m_groundPlane;
 
     bool m_cameraUpdated = false;
+
+    // The simplified meshes are traced from the first camera update until the camera has been at rest for kCameraRestTime.
+    static constexpr float kCameraRestTime = 0.25f; // In seconds.
+    util::Timer m_cameraRestTimer;
+    bool m_sceneSimplified = false;
+    std::atomic<bool> m_sceneHasLods = false; // Set on the OpenRL thread once a scene with simplified meshes is loaded.
     float m_distanceScale = 1.0f;
 
+    // Set on the OpenRL thread once a scene loaded in the background has been swapped in.
+    std::atomic<bool> m_sceneSwapped = false;
+    std::atomic<bool> m_sceneSwapMovesCamera = false;
+
+    util::FileWatcher m_shaderWatcher; // Reports edited shader files so that the programs built from them can be rebuilt.
+
     bool renderMaterialEditor(std::shared_ptr<Material> material);
     bool renderLightEditor(std::shared_ptr<Light> light);
     
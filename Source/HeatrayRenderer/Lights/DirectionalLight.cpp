@@ -2,7 +2,6 @@
 
 #include <RLWrapper/Shader.h>
 #include <RLWrapper/Program.h>
-#include <Utility/ShaderCodeLoader.h>
 #include <Utility/StringUtils.h>
 
 #include <glm/glm/glm.hpp>
@@ -10,20 +9,17 @@
 
 #include <assert.h>
 #include <cstring>
-#include <sstream>
 
 static constexpr float WATTS_TO_LUMENS = 683.0f;
 static constexpr float LUMENS_TO_WATTS = 1.0f / 683.0f;
 
 DirectionalLight::DirectionalLight(const std::string_view name, size_t lightIndex, std::shared_ptr<openrl::Buffer> lightBuffer)
-: Light(name, Light::Type::kDirectional)
+: Light(name, Light::Type::kDirectional, "directionalLight.rlsl", "DirectionalLight")
 , m_lightIndex(lightIndex)
 {
     // Setup the environment light OpenRL data.
 
-    std::stringstream defines;
-    ShaderLightingDefines::appendLightingShaderDefines(defines);
-    m_program = util::buildProgram("passthrough.rlsl", "directionalLight.rlsl", "DirectionalLight", defines.str());
+    m_program = buildProgram();
     assert(m_program);
 
     // Create the primitive and associate the program with it.
@@ -31,7 +27,7 @@ DirectionalLight::DirectionalLight(const std::string_view name, size_t lightInde
     m_primitive->attachProgram(m_program);
 
     // Initialize the uniforms to a default state.
-    setUniforms();
+    resolveUniforms();
 
     m_params.color = glm::vec3(1.0f);
     m_params.illuminance = WATTS_TO_LUMENS * glm::pi<float>(); // We specify a default intensity of 1 watt * π.
@@ -77,6 +73,12 @@ glm::vec3 DirectionalLight::calculateDirection()
     return glm::normalize(direction) * -1.0f;
 }
 
+void DirectionalLight::resolveUniforms()
+{
+    m_lightIndexUniform = m_program->uniform("lightIndex");
+    setUniforms();
+}
+
 void DirectionalLight::setUniforms() const
 {
     assert(m_primitive);
@@ -84,6 +86,6 @@ void DirectionalLight::setUniforms() const
 
     m_primitive->bind();
     m_program->bind();
-    m_program->set1i(m_program->getUniformLocation("lightIndex"), (int)m_lightIndex);
+    m_program->set1i(m_lightIndexUniform, (int)m_lightIndex);
     m_primitive->unbind();
 }
@@ -4,22 +4,18 @@
 #include <RLWrapper/Shader.h>
 #include <RLWrapper/Program.h>
 #include <RLWrapper/Texture.h>
-#include <Utility/ShaderCodeLoader.h>
 #include <Utility/TextureLoader.h>
 
 #include <glm/glm/glm.hpp>
 
 #include <assert.h>
-#include <sstream>
 
 EnvironmentLight::EnvironmentLight(const std::string_view name, std::shared_ptr<openrl::Buffer> lightBuffer)
-: Light(name, Light::Type::kEnvironment)
+: Light(name, Light::Type::kEnvironment, "environmentLight.rlsl", "Environment Light")
 {
     // Setup the environment light OpenRL data.
 
-    std::stringstream defines;
-    ShaderLightingDefines::appendLightingShaderDefines(defines);
-    m_program = util::buildProgram("passthrough.rlsl", "environmentLight.rlsl", "Environment Light", defines.str());
+    m_program = buildProgram();
     assert(m_program);
 
     // Create the primitive and associate the program with it.
@@ -64,7 +60,7 @@ void EnvironmentLight::enableSolidColor(const glm::vec3& color)
         sampler.wrapS = RL_CLAMP_TO_EDGE;
         sampler.wrapT = RL_CLAMP_TO_EDGE;
 
-        m_texture = openrl::Texture::create(&color.x, desc, sampler, false);
+        m_texture = openrl::Texture::create(&color.x, desc, sampler, false, "Environment solid color");
 
         m_textureSourcePath = std::string(SOLID_COLOR);
         m_solidColor = color;
@@ -92,7 +88,7 @@ void EnvironmentLight::copyToLightBuffer(EnvironmentLightBuffer* buffer)
     } else {
         buffer->texture = RL_NULL_TEXTURE;
     }
-    buffer->exposureCompensation = std::powf(2.0f, m_exposureCompensation);
+    buffer->exposureCompensation = std::pow(2.0f, m_exposureCompensation);
     buffer->thetaRotation = m_thetaRotation;
     buffer->primitive = m_primitive->primitive();
 }
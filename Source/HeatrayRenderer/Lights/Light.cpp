@@ -0,0 +1,27 @@
+#include "Light.h"
+
+#include <Utility/ShaderCodeLoader.h>
+
+#include <sstream>
+
+bool Light::rebuild()
+{
+    // Keep rendering with the previous program if the edited shader code doesn't build.
+    std::shared_ptr<openrl::Program> program = buildProgram();
+    if (!program) {
+        return false;
+    }
+
+    m_program = std::move(program);
+    m_primitive = openrl::Primitive::create();
+    m_primitive->attachProgram(m_program);
+    resolveUniforms();
+    return true;
+}
+
+std::shared_ptr<openrl::Program> Light::buildProgram() const
+{
+    std::stringstream defines;
+    ShaderLightingDefines::appendLightingShaderDefines(defines);
+    return util::buildProgram(m_vertexShader, m_rayShader, m_programName, defines.str());
+}
@@ -26,19 +26,48 @@ public:
         kSpot
     };
 
-    explicit Light(const std::string_view name, const Type type)
-        : m_name(name)
-        , m_type(type) {}
     virtual ~Light() = default;
 
     std::shared_ptr<openrl::Program> program() const { return m_program; }
     std::shared_ptr<openrl::Primitive> primitive() const { return m_primitive; }
     std::string_view name() const { return m_name; }
     Type type() const { return m_type; }
+
+    //-------------------------------------------------------------------------
+    // Returns true if the program of this light is built from the shader file
+    // 'shader' (relative to the shader directory).
+    bool usesShader(const std::string_view shader) const { return (shader == m_vertexShader) || (shader == m_rayShader); }
+
+    //-------------------------------------------------------------------------
+    // Build the program again from the current shader code and give the light
+    // a new primitive that uses it. The light buffers and any blocks bound to
+    // the previous program have to be set up again, see
+    // Lighting::reloadShaders(). Returns false and keeps the previous program
+    // and primitive if the shaders fail to build.
+    bool rebuild();
 protected:
+    static constexpr char const * m_vertexShader = "passthrough.rlsl";
+
+    explicit Light(const std::string_view name, const Type type, const std::string_view rayShader, const std::string_view programName)
+        : m_name(name)
+        , m_type(type)
+        , m_rayShader(rayShader)
+        , m_programName(programName) {}
+
+    //-------------------------------------------------------------------------
+    // Build a program from the shaders of this light, nullptr if they fail to
+    // build.
+    std::shared_ptr<openrl::Program> buildProgram() const;
+
+    //-------------------------------------------------------------------------
+    // Resolve and set the uniforms of a freshly built m_program.
+    virtual void resolveUniforms() {}
+
     std::shared_ptr<openrl::Primitive> m_primitive = nullptr;
     std::shared_ptr<openrl::Program> m_program = nullptr;
 
     const std::string m_name;
     const Type m_type;
+    const std::string_view m_rayShader; // Shader file with the ray shader code of this light.
+    const std::string_view m_programName;
 };
@@ -50,6 +50,7 @@ public:
     // keep the buffer tightly packed.
     void updateLightIndex(const size_t newLightIndex);
 private:
+    void resolveUniforms() override;
     void setUniforms() const;
 
     Params m_params;
@@ -57,4 +58,5 @@ private:
     // This represents the index of this light within the global buffer
     // of all directional lights.
     size_t m_lightIndex = 0;  
+    openrl::UniformHandle m_lightIndexUniform; // Where m_lightIndex goes in m_program.
 };
@@ -8,6 +8,7 @@
 #pragma once
 
 #include <RLWrapper/Primitive.h>
+#include <RLWrapper/Program.h>
 
 #define GLM_FORCE_SWIZZLE
 #include <glm/glm/glm.hpp>
@@ -30,6 +31,27 @@ struct ShaderLightingDefines {
     }
 };
 
+//-------------------------------------------------------------------------
+// Indices of the lighting uniform blocks in one program. Resolved once when
+// the program is built so that binding the lighting buffers to its primitives
+// doesn't look the blocks up by name.
+struct LightingUniformBlocks {
+    openrl::UniformBlockHandle environmentLight;
+    openrl::UniformBlockHandle directionalLights;
+    openrl::UniformBlockHandle pointLights;
+    openrl::UniformBlockHandle spotLights;
+
+    static LightingUniformBlocks resolve(const openrl::Program& program)
+    {
+        LightingUniformBlocks blocks;
+        blocks.environmentLight = program.uniformBlock("EnvironmentLight");
+        blocks.directionalLights = program.uniformBlock("DirectionalLights");
+        blocks.pointLights = program.uniformBlock("PointLights");
+        blocks.spotLights = program.uniformBlock("SpotLights");
+        return blocks;
+    }
+};
+
 struct EnvironmentLightBuffer {
     RLtexture texture = RL_NULL_TEXTURE;
     float exposureCompensation = 0.0f;
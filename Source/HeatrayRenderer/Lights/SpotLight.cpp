@@ -2,7 +2,6 @@
 
 #include <RLWrapper/Shader.h>
 #include <RLWrapper/Program.h>
-#include <Utility/ShaderCodeLoader.h>
 #include <Utility/StringUtils.h>
 
 #include <glm/glm/glm.hpp>
@@ -11,20 +10,17 @@
 
 #include <assert.h>
 #include <cstring>
-#include <sstream>
 
 static constexpr float WATTS_TO_LUMENS = 683.0f;
 static constexpr float LUMENS_TO_WATTS = 1.0f / 683.0f;
 
 SpotLight::SpotLight(const std::string_view name, size_t lightIndex, std::shared_ptr<openrl::Buffer> lightBuffer)
-: Light(name, Light::Type::kSpot)
+: Light(name, Light::Type::kSpot, "spotLight.rlsl", "SpotLight")
 , m_lightIndex(lightIndex)
 {
     // Setup the environment light OpenRL data.
 
-    std::stringstream defines;
-    ShaderLightingDefines::appendLightingShaderDefines(defines);
-    m_program = util::buildProgram("passthrough.rlsl", "spotLight.rlsl", "SpotLight", defines.str());
+    m_program = buildProgram();
     assert(m_program);
 
     // Create the primitive and associate the program with it.
@@ -32,7 +28,7 @@ SpotLight::SpotLight(const std::string_view name, size_t lightIndex, std::shared
     m_primitive->attachProgram(m_program);
 
     // Initialize the uniforms to a default state.
-    setUniforms();
+    resolveUniforms();
 
     m_params.color = glm::vec3(1.0f);
     m_params.luminousIntensity = WATTS_TO_LUMENS * (glm::pi<float>() * glm::pi<float>()); // We specify a default intensity of 1 watt * π^2.
@@ -47,7 +43,7 @@ void SpotLight::copyToLightBuffer(SpotLightsBuffer* buffer)
     
     buffer->positions[m_lightIndex] = m_params.position;
     buffer->directions[m_lightIndex] = calculateDirection();
-    buffer->angles[m_lightIndex] = glm::vec2(std::cosf(m_params.innerAngle), std::cosf(m_params.outerAngle));
+    buffer->angles[m_lightIndex] = glm::vec2(std::cos(m_params.innerAngle), std::cos(m_params.outerAngle));
     buffer->primitives[m_lightIndex] = m_primitive->primitive();
 
     // We convert from photometric to radiometric units for the shader.
@@ -90,6 +86,12 @@ glm::vec3 SpotLight::calculateDirection()
     return glm::normalize(direction);
 }
 
+void SpotLight::resolveUniforms()
+{
+    m_lightIndexUniform = m_program->uniform("lightIndex");
+    setUniforms();
+}
+
 void SpotLight::setUniforms() const
 {
     assert(m_primitive);
@@ -97,6 +99,6 @@ void SpotLight::setUniforms() const
 
     m_primitive->bind();
     m_program->bind();
-    m_program->set1i(m_program->getUniformLocation("lightIndex"), (int)m_lightIndex);
+    m_program->set1i(m_lightIndexUniform, (int)m_lightIndex);
     m_primitive->unbind();
 }
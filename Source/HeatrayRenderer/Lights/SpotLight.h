@@ -59,6 +59,7 @@ public:
     void updateLightIndex(const size_t newLightIndex);
 private:
     glm::vec3 calculateDirection();
+    void resolveUniforms() override;
     void setUniforms() const;
 
     Params m_params;
@@ -66,4 +67,5 @@ private:
     // This represents the index of this light within the global buffer
     // of all directional lights.
     size_t m_lightIndex = 0;  
+    openrl::UniformHandle m_lightIndexUniform; // Where m_lightIndex goes in m_program.
 };
@@ -33,7 +33,7 @@ void GlassMaterial::build()
 
     // Load the parameters into the uniform block buffer.
     assert(m_constants == nullptr);
-    m_constants = openrl::Buffer::create(RL_UNIFORM_BLOCK_BUFFER, nullptr, sizeof(ShaderParams), "Glass uniform block");
+    m_constants = openrl::Buffer::create(RL_UNIFORM_BLOCK_BUFFER, nullptr, sizeof(ShaderParams), m_name + " uniform block");
     modify();
     assert(m_constants->valid());
 
@@ -59,10 +59,16 @@ void GlassMaterial::build()
             hasNormalmap = true;
             shaderPrefix << "#define HAS_NORMALMAP\n";
         }
+        if (m_enableCompactVertices) {
+            shaderPrefix << "#define COMPACT_VERTICES\n";
+        }
+        if (m_enableTangentHandedness) {
+            shaderPrefix << "#define TANGENT_HANDEDNESS\n";
+        }
     }
 
-    // Loadup the shader code.
-    // TODO: this should use some kind of shader cache.
+    // Loadup the shader code. Materials that end up with the same defines share a single program, their parameters
+    // stay separate since the uniform block is bound per primitive.
     if (hasTextures) {
         if (hasNormalmap) {
             shaderPrefix << "#define USE_TANGENT_SPACE\n";
@@ -71,18 +77,29 @@ void GlassMaterial::build()
     }
 
     LOG_INFO("Building shader: %s with flags:\n%s", m_shader, shaderPrefix.str().c_str());
-    m_program = util::buildProgram(m_vertexShader, m_shader, "Glass", shaderPrefix.str());
+    m_program = util::buildSharedProgram(m_vertexShader, m_shader, "Glass", shaderPrefix.str());
+    if (m_program) {
+        resolveUniforms();
+    }
 
     // NOTE: the association of the program and the uniform block needs to happen in the calling code.
     // This is because there is no RLprimitive at the material level to properly bind.
 }
 
-void GlassMaterial::rebuild()
+bool GlassMaterial::rebuild()
 {
-    m_program.reset();
-    m_constants.reset();
+    // Keep rendering with the previous program if the edited shader code doesn't build.
+    std::shared_ptr<openrl::Program> program = std::move(m_program);
+    std::shared_ptr<openrl::Buffer> constants = std::move(m_constants);
 
+    // build() only resolves m_uniforms again if the new program was built.
     build();
+    if (!m_program) {
+        m_program = std::move(program);
+        m_constants = std::move(constants);
+        return false;
+    }
+    return true;
 }
 
 void GlassMaterial::modify()
@@ -124,3 +141,18 @@ void GlassMaterial::modify()
 
     m_constants->modify(&shaderParams, sizeof(ShaderParams));
 }
+
+uint64_t GlassMaterial::parameterHash() const
+{
+    uint64_t hash = util::FNV1a(m_params.baseColor);
+    auto combine = [&hash](uint64_t value) { hash = util::hashCombine(hash, value); };
+
+    combine(textureHash(m_params.baseColorTexture));
+    combine(textureHash(m_params.normalmap));
+    combine(textureHash(m_params.metallicRoughnessTexture));
+    combine(util::FNV1a(m_params.roughness));
+    combine(util::FNV1a(m_params.ior));
+    combine(util::FNV1a(m_params.density));
+    combine(util::FNV1a(m_params.forceEnableAllTextures));
+    return hash;
+}
@@ -7,10 +7,15 @@
 
 #pragma once
 
+#include "../Lights/ShaderLightingDefines.h"
+
 #include <RLWrapper/Buffer.h>
 #include <RLWrapper/Program.h>
+#include <RLWrapper/Texture.h>
+#include <Utility/Hash.h>
 
 #include <memory>
+#include <stdint.h>
 
 class Material
 {
@@ -26,8 +31,19 @@ public:
         , m_type(type) {}
     virtual ~Material() = default;
 
+    //-------------------------------------------------------------------------
+    // Uniforms that are set on every primitive drawn with this material,
+    // resolved once whenever the program is (re)built.
+    struct Uniforms {
+        openrl::UniformHandle worldFromEntity;
+        openrl::UniformHandle texCoordTransform;
+        openrl::UniformBlockHandle material; // Takes the buffer returned by uniformBlock().
+        LightingUniformBlocks lighting;
+    };
+
     std::shared_ptr<openrl::Program> program() { return m_program; }
     std::shared_ptr<openrl::Buffer> uniformBlock() { return m_constants; }
+    const Uniforms &uniforms() const { return m_uniforms; }
     const std::string_view name() const { return m_name; }
     Type type() const { return m_type; }
 
@@ -38,24 +54,68 @@ public:
 
     //-------------------------------------------------------------------------
     // Completely destroys all internal data and rebuilds it from scratch, 
-    // including reloading any shader data.
-    virtual void rebuild() = 0;
+    // including reloading any shader data. Returns false and keeps the
+    // previous program and uniform block if the shaders fail to build.
+    virtual bool rebuild() = 0;
 
     //-------------------------------------------------------------------------
     // Upload parameter changes to OpenRL.
     virtual void modify() = 0;
 
+    //-------------------------------------------------------------------------
+    // Hash of the parameters that affect the rendered image, textures are
+    // identified by their names. Stable between runs of Heatray.
+    virtual uint64_t parameterHash() const = 0;
+
     //-------------------------------------------------------------------------
     // Tell any complied shader code for this material to include support
     // for vertex colors.
     void enableVertexColors() { m_enableVertexColors = true; }
+
+    //-------------------------------------------------------------------------
+    // Tell any compiled shader code for this material to expect the quantized
+    // vertex attributes of VertexFormat::kCompact.
+    void enableCompactVertices() { m_enableCompactVertices = true; }
+
+    //-------------------------------------------------------------------------
+    // Tell any compiled shader code for this material that tangents have four
+    // components with the handedness of the bitangent in w, and that no
+    // bitangents are supplied.
+    void enableTangentHandedness() { m_enableTangentHandedness = true; }
+
+    //-------------------------------------------------------------------------
+    // Returns true if the program of this material is built from the shader
+    // file 'shader' (relative to the shader directory).
+    bool usesShader(const std::string_view shader) const { return (shader == m_vertexShader) || (shader == rayShader()); }
 protected:
     static constexpr char const * m_vertexShader = "vertex.rlsl";
 
+    //-------------------------------------------------------------------------
+    // Shader file with the ray shader code of this material.
+    virtual const std::string_view rayShader() const = 0;
+
+    //-------------------------------------------------------------------------
+    // Resolve m_uniforms for a freshly built m_program.
+    void resolveUniforms()
+    {
+        m_uniforms.worldFromEntity = m_program->uniform("worldFromEntity");
+        m_uniforms.texCoordTransform = m_program->uniform("texCoordTransform");
+        m_uniforms.material = m_program->uniformBlock("Material"); // Yeah - this is saying all shader's should use the name "Material" for their uniform blocks.
+        m_uniforms.lighting = LightingUniformBlocks::resolve(*m_program);
+    }
+
+    static uint64_t textureHash(const std::shared_ptr<openrl::Texture>& texture)
+    {
+        return texture ? util::FNV1a(texture->name().data(), texture->name().size()) : 0;
+    }
+
     std::shared_ptr<openrl::Buffer>  m_constants = nullptr; // Constants used by this material. Will be uploaded as a uniform block to the corresponding shader.
     std::shared_ptr<openrl::Program> m_program   = nullptr; // Shader representing this material.
+    Uniforms m_uniforms; // Handles into m_program.
 
     bool m_enableVertexColors = false;
+    bool m_enableCompactVertices = false;
+    bool m_enableTangentHandedness = false;
 
     const std::string m_name;
     Type m_type;
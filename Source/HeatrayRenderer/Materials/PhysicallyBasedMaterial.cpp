@@ -42,7 +42,7 @@ void PhysicallyBasedMaterial::build()
 
     // Load the parameters into the uniform block buffer.
     assert(m_constants == nullptr);
-    m_constants = openrl::Buffer::create(RL_UNIFORM_BLOCK_BUFFER, nullptr, sizeof(ShaderParams), "PhysicallyBased uniform block");
+    m_constants = openrl::Buffer::create(RL_UNIFORM_BLOCK_BUFFER, nullptr, sizeof(ShaderParams), m_name + " uniform block");
     modify();
     assert(m_constants->valid());
 
@@ -97,11 +97,17 @@ void PhysicallyBasedMaterial::build()
             if (m_enableVertexColors) {
                 shaderPrefix << "#define VERTEX_COLORS\n";
             }
+            if (m_enableCompactVertices) {
+                shaderPrefix << "#define COMPACT_VERTICES\n";
+            }
+            if (m_enableTangentHandedness) {
+                shaderPrefix << "#define TANGENT_HANDEDNESS\n";
+            }
         }
     }
 
-    // Loadup the shader code.
-    // TODO: this should use some kind of shader cache.
+    // Loadup the shader code. Materials that end up with the same defines share a single program, their parameters
+    // stay separate since the uniform block is bound per primitive.
     if (hasTextures) {
         if (hasNormalmap) {
             shaderPrefix << "#define USE_TANGENT_SPACE\n";
@@ -110,18 +116,29 @@ void PhysicallyBasedMaterial::build()
     }
 
     LOG_INFO("Building shader: %s with flags:\n%s", m_shader, shaderPrefix.str().c_str());
-    m_program = util::buildProgram(m_vertexShader, m_shader, "PhysicallyBased", shaderPrefix.str());
+    m_program = util::buildSharedProgram(m_vertexShader, m_shader, "PhysicallyBased", shaderPrefix.str());
+    if (m_program) {
+        resolveUniforms();
+    }
 
     // NOTE: the association of the program and the uniform block needs to happen in the calling code.
     // This is because there is no RLprimitive at the material level to properly bind.
 }
 
-void PhysicallyBasedMaterial::rebuild()
+bool PhysicallyBasedMaterial::rebuild()
 {
-    m_program.reset();
-    m_constants.reset();
+    // Keep rendering with the previous program if the edited shader code doesn't build.
+    std::shared_ptr<openrl::Program> program = std::move(m_program);
+    std::shared_ptr<openrl::Buffer> constants = std::move(m_constants);
 
+    // build() only resolves m_uniforms again if the new program was built.
     build();
+    if (!m_program) {
+        m_program = std::move(program);
+        m_constants = std::move(constants);
+        return false;
+    }
+    return true;
 }
 
 void PhysicallyBasedMaterial::modify()
@@ -188,4 +205,28 @@ void PhysicallyBasedMaterial::modify()
     shaderParams.multiscatterLUT = m_multiscatterLUT->texture();
 
     m_constants->modify(&shaderParams, sizeof(ShaderParams));
-}
\ No newline at end of file
+}
+
+uint64_t PhysicallyBasedMaterial::parameterHash() const
+{
+    uint64_t hash = util::FNV1a(m_params.baseColor);
+    auto combine = [&hash](uint64_t value) { hash = util::hashCombine(hash, value); };
+
+    combine(textureHash(m_params.baseColorTexture));
+    combine(textureHash(m_params.emissiveTexture));
+    combine(textureHash(m_params.normalmap));
+    combine(textureHash(m_params.metallicRoughnessTexture));
+    combine(textureHash(m_params.clearCoatTexture));
+    combine(textureHash(m_params.clearCoatRoughnessTexture));
+    combine(textureHash(m_params.clearCoatNormalmap));
+    combine(util::FNV1a(m_params.emissiveColor));
+    combine(util::FNV1a(m_params.roughness));
+    combine(util::FNV1a(m_params.metallic));
+    combine(util::FNV1a(m_params.specularF0));
+    combine(util::FNV1a(m_params.clearCoat));
+    combine(util::FNV1a(m_params.clearCoatRoughness));
+    combine(util::FNV1a(m_params.doubleSided));
+    combine(util::FNV1a(m_params.alphaMask));
+    combine(util::FNV1a(m_params.forceEnableAllTextures));
+    return hash;
+}
\ No newline at end of file
@@ -41,13 +41,16 @@ public:
     };
 
     void build() override;
-    void rebuild() override;
+    bool rebuild() override;
     void modify() override;
+    uint64_t parameterHash() const override;
 
     Parameters& parameters() { return m_params;  }
 
 private:
     static constexpr char const * m_shader = "physicallyBased.rlsl"; // Shader file with corresponding material code.
+    const std::string_view rayShader() const override { return m_shader; }
+
     std::shared_ptr<openrl::Texture> m_multiscatterLUT = nullptr;
     std::shared_ptr<openrl::Texture> m_dummyTexture = nullptr;
 
@@ -11,8 +11,12 @@
 #include <RLWrapper/Texture.h>
 #include <Utility/BlueNoise.h>
 #include <Utility/FileIO.h>
+#include <Utility/Hash.h>
+#include <Utility/Log.h>
+#include <Utility/MappedFile.h>
 #include <Utility/Random.h>
 #include <Utility/ShaderCodeLoader.h>
+#include <Utility/TextureCache.h>
 #include <Utility/TextureLoader.h>
 #include <Utility/Timer.h>
 
@@ -21,6 +25,7 @@
 
 #include <algorithm>
 #include <assert.h>
+#include <filesystem>
 #include <string>
 
 PassGenerator::~PassGenerator()
@@ -92,6 +97,22 @@ void PassGenerator::init(const RLint renderWidth, const RLint renderHeight)
     };
     m_jobProcessor.init(std::move(runJob));
 
+    // Scene imports only touch the disk and the CPU, the result is handed to the OpenRL thread once it is ready.
+    auto runSceneImport = [this](BackgroundSceneLoad& load) {
+        if (load.generation != m_sceneGeneration) {
+            --m_pendingSceneLoads; // Superseded before it even started.
+            return false;
+        }
+
+        m_sceneLoadProgress.reset();
+        m_sceneLoadProgress.stage = SceneLoadProgress::Stage::kImporting;
+        std::shared_ptr<SceneImport> sceneImport = load.importCallback(m_sceneLoadProgress, load.generation);
+
+        runOpenRLTask([this, load, sceneImport]() { runAddSceneImportTask(load, sceneImport, nullptr); });
+        return false;
+    };
+    m_sceneImporter.init(std::move(runSceneImport));
+
     WindowSize size(renderWidth, renderHeight);
     Job job(JobType::kInit, std::make_any<WindowSize>(size));
     m_jobProcessor.addTask(std::move(job));
@@ -99,6 +120,10 @@ void PassGenerator::init(const RLint renderWidth, const RLint renderHeight)
 
 void PassGenerator::destroy()
 {
+    // Scenes that are still being imported are no longer needed.
+    ++m_sceneGeneration;
+    m_sceneImporter.deinit();
+
     Job job(JobType::kDestroy, std::make_any<void*>(nullptr));
     m_jobProcessor.addTask(std::move(job));
 
@@ -124,11 +149,23 @@ void PassGenerator::renderPass(const RenderOptions& newOptions, PassCompleteCall
 void PassGenerator::loadScene(LoadSceneCallback callback, bool clearOldScene)
 {
     m_loadSceneCallback = callback;
+    ++m_sceneGeneration; // Supersedes any background load that has not been added yet.
 
     Job job(JobType::kLoadScene, std::make_any<bool>(clearOldScene));
     m_jobProcessor.addTask(std::move(job));
 }
 
+void PassGenerator::loadSceneInBackground(ImportSceneCallback importCallback, AddImportCallback addCallback)
+{
+    BackgroundSceneLoad load;
+    load.generation = ++m_sceneGeneration;
+    load.importCallback = std::move(importCallback);
+    load.addCallback = std::move(addCallback);
+
+    ++m_pendingSceneLoads;
+    m_sceneImporter.addTask(std::move(load));
+}
+
 void PassGenerator::changeLighting(LightingCallback callback)
 {
     Job job(JobType::kChangeLighting, std::make_any<LightingCallback>(callback));
@@ -147,6 +184,30 @@ void PassGenerator::runOpenRLTask(OpenRLTask task)
     m_jobProcessor.addTask(std::move(job));
 }
 
+void PassGenerator::reloadShaders(std::vector<std::string> changedFiles)
+{
+    runOpenRLTask([this, changedFiles = std::move(changedFiles)]() {
+        std::vector<std::string> shaders = util::invalidateShaderSources(changedFiles);
+        if (shaders.empty()) {
+            LOG_INFO("No loaded shader depends on the changed shader files");
+            return;
+        }
+        for (const std::string& shader : shaders) {
+            LOG_INFO("Reloading shader %s", shader.c_str());
+        }
+
+        if (std::find(shaders.begin(), shaders.end(), kFrameShader) != shaders.end()) {
+            // Keep rendering with the old frame program if the new one doesn't compile.
+            if (!buildFrameProgram()) {
+                LOG_ERROR("Unable to rebuild the frame program, keeping the previous one");
+            }
+        }
+        m_scene->reloadShaders(shaders);
+        m_scene->lighting()->reloadShaders(shaders);
+        util::flushShaderCache();
+    });
+}
+
 void PassGenerator::generateSequenceOffsets(const RLint renderWidth, const RLint renderHeight)
 {
     // Generate the random sequence used in the frame shader when generating primary rays
@@ -155,7 +216,7 @@ void PassGenerator::generateSequenceOffsets(const RLint renderWidth, const RLint
     randomValues.resize(renderWidth * renderHeight);
     util::sobol(randomValues.data(), (uint32_t)randomValues.size(), 0);
     
-    m_sequenceOffsetsBuffer = openrl::Buffer::create(RL_UNIFORM_BLOCK_BUFFER, randomValues.data(), sizeof(glm::vec2) * randomValues.size());
+    m_sequenceOffsetsBuffer = openrl::Buffer::create(RL_UNIFORM_BLOCK_BUFFER, randomValues.data(), sizeof(glm::vec2) * randomValues.size(), "Sequence offsets uniform block");
 }
 
 bool PassGenerator::runInitJob(const RLint renderWidth, const RLint renderHeight)
@@ -184,7 +245,7 @@ bool PassGenerator::runInitJob(const RLint renderWidth, const RLint renderHeight
         sampler.minFilter = RL_NEAREST;
         sampler.magFilter = RL_NEAREST;
 
-        m_fboTexture = openrl::Texture::create(nullptr, desc, sampler, false);
+        m_fboTexture = openrl::Texture::create(nullptr, desc, sampler, false, "Framebuffer color");
         m_fbo->addAttachment(m_fboTexture, RL_COLOR_ATTACHMENT0);
 
         assert(m_fbo->valid());
@@ -236,31 +297,8 @@ bool PassGenerator::runInitJob(const RLint renderWidth, const RLint renderHeight
     }
 
     // Load the perspective camera frame shader for generating primary rays.
-    {
-        std::stringstream defines;
-        ShaderLightingDefines::appendLightingShaderDefines(defines);
-
-        std::vector<std::string> shaderSource;
-        shaderSource.push_back(defines.str());
-        util::loadShaderSourceFile("perspective.rlsl", shaderSource);
-        std::shared_ptr<openrl::Shader> frameShader = openrl::Shader::createFromMultipleStrings(shaderSource, openrl::Shader::ShaderType::kFrame, "Perspective Frame Shader");
-        if (!frameShader) {
-            return false;
-        }
-
-        m_frameProgram = openrl::Program::create();
-        m_frameProgram->attach(frameShader);
-        if (!m_frameProgram->link("Perspecive Frame Shader")) {
-            return false;
-        }
-
-        // Heatray uses the null primitive as the frame primitive.
-        RLFunc(rlBindPrimitive(RL_PRIMITIVE, RL_NULL_PRIMITIVE));
-        m_frameProgram->bind();
-        m_frameProgram->setUniformBlock(m_frameProgram->getUniformBlockIndex("RandomSequences"), m_randomSequences->buffer());
-        m_frameProgram->setUniformBlock(m_frameProgram->getUniformBlockIndex("RandomSequenceMetadata"), m_randomSequencesMetadata->buffer());
-        m_frameProgram->setUniformBlock(m_frameProgram->getUniformBlockIndex("Globals"), m_globalData->buffer());
-        m_scene->lighting()->bindLightingBuffersToProgram(m_frameProgram);
+    if (!buildFrameProgram()) {
+        return false;
     }
 
     // Generate the block pixel offsets for interactive rendering.
@@ -290,14 +328,60 @@ bool PassGenerator::runInitJob(const RLint renderWidth, const RLint renderHeight
         desc.width = RenderOptions::kInteractiveBlockSize.x;
         desc.height = RenderOptions::kInteractiveBlockSize.y;
 
-        m_interactiveBlockCoordsTexture = openrl::Texture::create(coords.data(), desc, sampler, false);
+        m_interactiveBlockCoordsTexture = openrl::Texture::create(coords.data(), desc, sampler, false, "Interactive block coordinates");
     }
 
     generateSequenceOffsets(renderWidth, renderHeight);
+    util::flushShaderCache();
 
     return true;
 }
 
+bool PassGenerator::buildFrameProgram()
+{
+    std::stringstream defines;
+    ShaderLightingDefines::appendLightingShaderDefines(defines);
+
+    std::vector<std::string> shaderSource;
+    shaderSource.push_back(defines.str());
+    util::loadShaderSourceFile(kFrameShader, shaderSource);
+    std::shared_ptr<openrl::Shader> frameShader = openrl::Shader::createFromMultipleStrings(shaderSource, openrl::Shader::ShaderType::kFrame, "Perspective Frame Shader");
+    if (!frameShader) {
+        return false;
+    }
+
+    std::shared_ptr<openrl::Program> frameProgram = openrl::Program::create();
+    frameProgram->attach(frameShader);
+    if (!frameProgram->link("Perspecive Frame Shader")) {
+        return false;
+    }
+
+    // Heatray uses the null primitive as the frame primitive.
+    RLFunc(rlBindPrimitive(RL_PRIMITIVE, RL_NULL_PRIMITIVE));
+    frameProgram->bind();
+    frameProgram->setUniformBlock(frameProgram->getUniformBlockIndex("RandomSequences"), m_randomSequences->buffer());
+    frameProgram->setUniformBlock(frameProgram->getUniformBlockIndex("RandomSequenceMetadata"), m_randomSequencesMetadata->buffer());
+    frameProgram->setUniformBlock(frameProgram->getUniformBlockIndex("Globals"), m_globalData->buffer());
+    m_scene->lighting()->bindLightingBuffersToProgram(frameProgram);
+
+    // Resolve everything that is set every pass up front.
+    m_frameUniforms.fovTan = frameProgram->uniform("fovTan");
+    m_frameUniforms.aspectRatio = frameProgram->uniform("aspectRatio");
+    m_frameUniforms.focusDistance = frameProgram->uniform("focusDistance");
+    m_frameUniforms.apertureRadius = frameProgram->uniform("apertureRadius");
+    m_frameUniforms.viewMatrix = frameProgram->uniform("viewMatrix");
+    m_frameUniforms.blockSize = frameProgram->uniform("blockSize");
+    m_frameUniforms.currentBlockPixelSample = frameProgram->uniform("currentBlockPixelSample");
+    m_frameUniforms.interactiveMode = frameProgram->uniform("interactiveMode");
+    m_frameUniforms.interactiveBlockSamplesTexture = frameProgram->uniform("interactiveBlockSamplesTexture");
+    m_frameUniforms.maxSampleIndex = frameProgram->uniform("maxSampleIndex");
+    m_frameUniforms.apertureSamples = frameProgram->uniformBlock("ApertureSamples");
+    m_frameUniforms.sequenceOffsets = frameProgram->uniformBlock("SequenceOffsets");
+
+    m_frameProgram = std::move(frameProgram);
+    return true;
+}
+
 void PassGenerator::runResizeJob(const RLint newRenderWidth, const RLint newRenderHeight)
 {
     // Set the new viewport.
@@ -336,7 +420,11 @@ void PassGenerator::runRenderFrameJob(const RenderOptions& newOptions)
         (newOptions.enableOfflineMode != m_renderOptions.enableOfflineMode) ||
         (newOptions.resetInternalState)) {
         resetRenderingState(newOptions);
+        m_sceneReplaced = false;
     }
+
+    // Checkpoint settings can change at any time without resetting the accumulation.
+    m_renderOptions.checkpoint = newOptions.checkpoint;
     
     constexpr glm::vec2 sensorDimensions(36.0f, 24.0f); // Dimensions of 35mm film.
     // https://en.wikipedia.org/wiki/Angle_of_view#Calculating_a_camera's_angle_of_view
@@ -355,18 +443,18 @@ void PassGenerator::runRenderFrameJob(const RenderOptions& newOptions)
         
         m_frameProgram->bind();
         float fovTan = std::tanf(fovY * 0.5f);
-        m_frameProgram->set1f(m_frameProgram->getUniformLocation("fovTan"), fovTan);
-        m_frameProgram->set1f(m_frameProgram->getUniformLocation("aspectRatio"), m_renderOptions.camera.aspectRatio);
-        m_frameProgram->set1f(m_frameProgram->getUniformLocation("focusDistance"), m_renderOptions.camera.focusDistance);
-        m_frameProgram->set1f(m_frameProgram->getUniformLocation("apertureRadius"), m_renderOptions.camera.apertureRadius);
-        m_frameProgram->setMatrix4fv(m_frameProgram->getUniformLocation("viewMatrix"), &(m_renderOptions.camera.viewMatrix[0][0]));
-        m_frameProgram->set2iv(m_frameProgram->getUniformLocation("blockSize"), &m_renderOptions.kInteractiveBlockSize.x);
-        m_frameProgram->set2iv(m_frameProgram->getUniformLocation("currentBlockPixelSample"), &m_currentBlockPixelSample.x);
-        m_frameProgram->set1i(m_frameProgram->getUniformLocation("interactiveMode"), m_renderOptions.enableInteractiveMode ? 1 : 0);
-        m_frameProgram->setUniformBlock(m_frameProgram->getUniformBlockIndex("ApertureSamples"), m_apertureSamplesBuffer->buffer());
-        m_frameProgram->setTexture(m_frameProgram->getUniformLocation("interactiveBlockSamplesTexture"), m_interactiveBlockCoordsTexture);
-        m_frameProgram->set1f(m_frameProgram->getUniformLocation("maxSampleIndex"), float(m_renderOptions.maxRenderPasses));
-        m_frameProgram->setUniformBlock(m_frameProgram->getUniformBlockIndex("SequenceOffsets"), m_sequenceOffsetsBuffer->buffer());
+        m_frameProgram->set1f(m_frameUniforms.fovTan, fovTan);
+        m_frameProgram->set1f(m_frameUniforms.aspectRatio, m_renderOptions.camera.aspectRatio);
+        m_frameProgram->set1f(m_frameUniforms.focusDistance, m_renderOptions.camera.focusDistance);
+        m_frameProgram->set1f(m_frameUniforms.apertureRadius, m_renderOptions.camera.apertureRadius);
+        m_frameProgram->setMatrix4fv(m_frameUniforms.viewMatrix, &(m_renderOptions.camera.viewMatrix[0][0]));
+        m_frameProgram->set2iv(m_frameUniforms.blockSize, &m_renderOptions.kInteractiveBlockSize.x);
+        m_frameProgram->set2iv(m_frameUniforms.currentBlockPixelSample, &m_currentBlockPixelSample.x);
+        m_frameProgram->set1i(m_frameUniforms.interactiveMode, m_renderOptions.enableInteractiveMode ? 1 : 0);
+        m_frameProgram->setUniformBlock(m_frameUniforms.apertureSamples, m_apertureSamplesBuffer->buffer());
+        m_frameProgram->setTexture(m_frameUniforms.interactiveBlockSamplesTexture, m_interactiveBlockCoordsTexture);
+        m_frameProgram->set1f(m_frameUniforms.maxSampleIndex, float(m_renderOptions.maxRenderPasses));
+        m_frameProgram->setUniformBlock(m_frameUniforms.sequenceOffsets, m_sequenceOffsetsBuffer->buffer());
         
         // In interactive mode, we now move to the next pixel sample within a block of pixels.
         if (m_renderOptions.enableInteractiveMode) {
@@ -393,6 +481,16 @@ void PassGenerator::runRenderFrameJob(const RenderOptions& newOptions)
             m_resultPixels->setPixelData(*m_fboTexture);
         }
 
+        // The options still describe the previous scene until the client resets for the one swapped in.
+        if (m_renderOptions.checkpoint.enabled && !m_renderOptions.debugPassRendering && !m_sceneReplaced &&
+            (m_currentSampleIndex != m_lastCheckpointSampleIndex) &&
+            (((m_currentSampleIndex % std::max(m_renderOptions.checkpoint.passInterval, 1u)) == 0) || (m_currentSampleIndex == m_renderOptions.maxRenderPasses))) {
+            if (!jobCompleted) {
+                m_resultPixels->setPixelData(*m_fboTexture);
+            }
+            writeCheckpoint();
+        }
+
         // Let the client know that a frame has been completed.
         float passTime = timer.dt();
         m_passCompleteCallback(jobCompleted, m_resultPixels, passTime, m_currentSampleIndex);
@@ -409,10 +507,60 @@ void PassGenerator::runLoadSceneJob(bool clearOldScene)
     }
     
     m_loadSceneCallback(m_scene);
+    util::flushShaderCache();
+    m_resumeCheckpoint = true;
+}
+
+void PassGenerator::runAddSceneImportTask(const BackgroundSceneLoad& load, std::shared_ptr<SceneImport> sceneImport, std::shared_ptr<Scene> stagingScene)
+{
+    if (load.generation != m_sceneGeneration) {
+        // Nothing but the staging scene refers to what has been added so far.
+        LOG_INFO("Discarding a scene load that was superseded while %s", stagingScene ? "adding it" : "importing");
+    } else {
+        if (!stagingScene) {
+            m_sceneLoadProgress.stage = SceneLoadProgress::Stage::kCreatingResources;
+            stagingScene = m_scene->createSibling();
+            stagingScene->beginImport(sceneImport);
+        }
+
+        if (!stagingScene->continueImport()) {
+            // Behind any render jobs queued while this chunk was added.
+            runOpenRLTask([this, load, sceneImport, stagingScene]() { runAddSceneImportTask(load, sceneImport, stagingScene); });
+            return;
+        }
+
+        // The lights are shared with the current scene, so they are only replaced along with it.
+        stagingScene->replaceLights(sceneImport->lightRecords);
+        {
+            std::lock_guard<std::mutex> lock(m_sceneMutex);
+            m_scene.swap(stagingScene);
+        }
+        stagingScene.reset(); // Frees the previous scene without holding up scene().
+
+        // Nothing accumulated for the previous scene may blend into the new one, and the render options
+        // (which the checkpoint hash covers) only catch up with the reset the client requests in response.
+        m_currentSampleIndex = 0;
+        m_currentBlockPixelSample = glm::ivec2(0, 0);
+        m_lastCheckpointSampleIndex = 0;
+        rlClear(RL_COLOR_BUFFER_BIT);
+        m_sceneReplaced = true;
+
+        load.addCallback(m_scene, sceneImport);
+        util::flushShaderCache();
+        m_resumeCheckpoint = true;
+        m_sceneLoadProgress.stage = SceneLoadProgress::Stage::kDone;
+    }
+
+    // Textures prefetched by this load (or an earlier abandoned one) that were not used are no longer needed.
+    util::TextureCache::instance().releasePrefetched(load.generation);
+    --m_pendingSceneLoads;
 }
 
 void PassGenerator::runDestroyJob()
 {
+    m_checkpoint.finish();
+    util::flushShaderCache(); // Shaders built outside of scene loads, e.g. for new lights.
+
     m_fbo.reset();
     m_fboTexture.reset();
     m_globalData.reset();
@@ -424,7 +572,11 @@ void PassGenerator::runDestroyJob()
     m_interactiveBlockCoordsTexture.reset();
     m_sequenceOffsetsBuffer.reset();
 
-    m_scene.reset();
+    {
+        std::lock_guard<std::mutex> lock(m_sceneMutex);
+        m_scene.reset();
+    }
+    util::TextureCache::instance().clear();
 
     m_resultPixels->unmapPixelData();
     m_resultPixels.reset();
@@ -574,6 +726,107 @@ void PassGenerator::resetRenderingState(const RenderOptions& newOptions)
     // Finally get all of the new render options.
     m_renderOptions = newOptions;
     m_renderOptions.resetInternalState = false;
+
+    // Hashing every material and light is not free, so only do it when there is a checkpoint to match.
+    m_renderStateHashValid = false;
+    m_lastCheckpointSampleIndex = m_currentSampleIndex;
+
+    // Only the first reset after startup or a scene/session load picks up a checkpoint, any other reset starts over.
+    if (m_resumeCheckpoint.exchange(false) && m_renderOptions.checkpoint.enabled && !m_renderOptions.debugPassRendering) {
+        resumeFromCheckpoint();
+    }
+}
+
+uint64_t PassGenerator::renderStateHash(const RenderOptions& options) const
+{
+    // Only state which affects the accumulated image contributes to the hash. Everything is
+    // hashed by value so that the result is stable between runs of Heatray.
+    uint64_t hash = util::FNV1a(options.scene.data(), options.scene.size());
+    auto combine = [&hash](uint64_t value) { hash = util::hashCombine(hash, value); };
+
+    combine(util::FNV1a(options.environment.map.data(), options.environment.map.size()));
+    combine(util::FNV1a(options.environment.solidColor));
+    combine(util::FNV1a(options.environment.builtInMap));
+    combine(util::FNV1a(options.environment.exposureCompensation));
+    combine(util::FNV1a(options.environment.thetaRotation));
+
+    combine(util::FNV1a(options.camera.aspectRatio));
+    combine(util::FNV1a(options.camera.focusDistance));
+    combine(util::FNV1a(options.camera.focalLength));
+    combine(util::FNV1a(options.camera.apertureRadius));
+    combine(util::FNV1a(options.camera.viewMatrix));
+
+    combine(util::FNV1a(options.enableInteractiveMode));
+    combine(util::FNV1a(options.maxRenderPasses));
+    combine(util::FNV1a(options.maxRayDepth));
+    combine(util::FNV1a(options.maxChannelValue));
+    combine(util::FNV1a(options.sampleMode));
+    combine(util::FNV1a(options.bokehShape));
+    combine(util::FNV1a(options.debugVisMode));
+
+    // Includes material and light edits made through the UI.
+    combine(m_scene->stateHash());
+
+    return hash;
+}
+
+std::string PassGenerator::checkpointPath() const
+{
+    if (!m_renderOptions.checkpoint.path.empty()) {
+        return m_renderOptions.checkpoint.path;
+    }
+    return (std::filesystem::path(util::userCacheDirectory()) / "heatray.checkpoint").string();
+}
+
+void PassGenerator::writeCheckpoint()
+{
+    assert(!m_resultPixels->mapped());
+
+    RenderCheckpoint::Header header;
+    header.width = m_resultPixels->width();
+    header.height = m_resultPixels->height();
+    header.sampleIndex = m_currentSampleIndex;
+    header.blockPixelSampleX = m_currentBlockPixelSample.x;
+    header.blockPixelSampleY = m_currentBlockPixelSample.y;
+    if (!m_renderStateHashValid) {
+        m_renderStateHash = renderStateHash(m_renderOptions);
+        m_renderStateHashValid = true;
+    }
+    header.stateHash = m_renderStateHash;
+
+    // Copy the pixels out of the PBO so that the file can be written while rendering continues.
+    const size_t numFloats = size_t(header.width) * size_t(header.height) * openrl::PixelPackBuffer::kNumChannels;
+    const float* pixelData = m_resultPixels->mapPixelData();
+    std::vector<float> pixels(pixelData, pixelData + numFloats);
+    m_resultPixels->unmapPixelData();
+
+    m_checkpoint.writeAsync(checkpointPath(), header, std::move(pixels));
+    m_lastCheckpointSampleIndex = m_currentSampleIndex;
+}
+
+bool PassGenerator::resumeFromCheckpoint()
+{
+    // Make sure that any in-flight checkpoint has landed on disk before looking for one.
+    m_checkpoint.finish();
+
+    m_renderStateHash = renderStateHash(m_renderOptions);
+    m_renderStateHashValid = true;
+
+    const std::string path = checkpointPath();
+    util::MappedFile file;
+    RenderCheckpoint::Header header;
+    const float* pixels = nullptr;
+    if (!RenderCheckpoint::open(path, m_renderStateHash, m_fboTexture->width(), m_fboTexture->height(), file, header, pixels)) {
+        return false;
+    }
+
+    m_fboTexture->setData(pixels);
+    m_currentSampleIndex = header.sampleIndex;
+    m_currentBlockPixelSample = glm::ivec2(header.blockPixelSampleX, header.blockPixelSampleY);
+    m_lastCheckpointSampleIndex = m_currentSampleIndex;
+
+    LOG_INFO("Resumed rendering from checkpoint %s at pass %u", path.c_str(), m_currentSampleIndex);
+    return true;
 }
 
 void PassGenerator::changeEnvironment(const RenderOptions::Environment &newEnv)
@@ -642,7 +895,7 @@ void PassGenerator::generateRandomSequences(const RLint sampleCount, RenderOptio
         SequenceMetadata metadata;
         metadata.sequenceLength = sampleCount;
         metadata.numSequences = kNumRandomSequences;
-        m_randomSequencesMetadata = openrl::Buffer::create(RL_UNIFORM_BLOCK_BUFFER, &metadata, sizeof(SequenceMetadata));
+        m_randomSequencesMetadata = openrl::Buffer::create(RL_UNIFORM_BLOCK_BUFFER, &metadata, sizeof(SequenceMetadata), "Random sequences metadata uniform block");
     } else {
         m_randomSequences->modify(values.data(), sizeof(SequenceBlockData) * totalNumberOfSamples);
         
@@ -676,7 +929,7 @@ void PassGenerator::generateRandomSequences(const RLint sampleCount, RenderOptio
         }
 
         if (!m_apertureSamplesBuffer) {
-            m_apertureSamplesBuffer = openrl::Buffer::create(RL_UNIFORM_BLOCK_BUFFER, values.data(), sizeof(glm::vec2) * totalNumberOfSamples);
+            m_apertureSamplesBuffer = openrl::Buffer::create(RL_UNIFORM_BLOCK_BUFFER, values.data(), sizeof(glm::vec2) * totalNumberOfSamples, "Aperture samples uniform block");
         } else {
             m_apertureSamplesBuffer->modify(values.data(), sizeof(glm::vec2) * totalNumberOfSamples);
         }
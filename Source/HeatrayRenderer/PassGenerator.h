@@ -8,6 +8,10 @@
 
 #pragma once
 
+#include "RenderCheckpoint.h"
+#include "Scene/SceneLoadProgress.h"
+
+#include <RLWrapper/Program.h>
 #include <Utility/AsyncTaskQueue.h>
 
 #include <glm/glm/mat4x4.hpp>
@@ -15,9 +19,12 @@
 #include <OpenRL/OpenRL.h>
 
 #include <any>
+#include <atomic>
 #include <functional>
 #include <memory>
+#include <mutex>
 #include <string>
+#include <string_view>
 #include <vector>
 
 // Forward declarations.
@@ -25,12 +32,12 @@ namespace openrl {
     class Buffer;
     class Framebuffer;
     class PixelPackBuffer;
-    class Program;
     class Texture;
 } // namespace openrl.
 class EnvironmentLight;
 class Lighting;
 class Scene;
+struct SceneImport;
    
 class PassGenerator              
 {
@@ -147,6 +154,14 @@ public:
         // result is for that single pass.
         bool debugPassRendering = false;
         int debugPassIndex = 0;
+
+        // Periodically saves the accumulation to disk so that a render can be resumed
+        // if the process exits. Changing these values does not reset the renderer.
+        struct Checkpoint {
+            bool enabled = false;
+            std::string path; // Defaults to "heatray.checkpoint" in util::userCacheDirectory() if empty.
+            uint32_t passInterval = 16; // Number of completed passes between checkpoints.
+        } checkpoint;
     };
     
     //-------------------------------------------------------------------------
@@ -172,6 +187,36 @@ public:
     using LoadSceneCallback = std::function<void(std::shared_ptr<Scene> scene)>;
     void loadScene(LoadSceneCallback callback, bool clearOldScene = true);
 
+    //-------------------------------------------------------------------------
+    // Load new scene data without stalling rendering. 'importCallback' is
+    // invoked on a separate thread to read the scene from disk (e.g. via
+    // Scene::importFromDisk()) while the current scene keeps rendering, and
+    // should report its progress to the supplied SceneLoadProgress. It is
+    // also given the generation of the load to prefetch its textures for, see
+    // util::TextureCache::prefetch(). Once it returns, the import is added to
+    // a separate scene on the OpenRL thread one chunk per job (see
+    // Scene::beginImport()) so that the current scene keeps rendering
+    // untouched in between. Once all of it has been added that scene replaces
+    // the current one along with its lights, the accumulation starts over
+    // and 'addCallback' is invoked on the OpenRL thread. No checkpoints are
+    // written from then on until the next reset. Loads that are superseded by
+    // a later call to this function or loadScene() before they are completely
+    // added are discarded along with their scene. Either way the textures
+    // prefetched for the load are released from the cache afterwards unless
+    // they were used.
+    using ImportSceneCallback = std::function<std::shared_ptr<SceneImport>(SceneLoadProgress& progress, uint64_t generation)>;
+    using AddImportCallback = std::function<void(std::shared_ptr<Scene> scene, std::shared_ptr<SceneImport> sceneImport)>;
+    void loadSceneInBackground(ImportSceneCallback importCallback, AddImportCallback addCallback);
+
+    //-------------------------------------------------------------------------
+    // True while a load started by loadSceneInBackground() has not been
+    // added to the scene yet. Can be called from any thread.
+    bool sceneLoadPending() const { return m_pendingSceneLoads > 0; }
+
+    //-------------------------------------------------------------------------
+    // Progress of the most recent background scene load.
+    const SceneLoadProgress& sceneLoadProgress() const { return m_sceneLoadProgress; }
+
     //-------------------------------------------------------------------------
     // Change the scene lighting via a user-supplied callback.
     using LightingCallback = std::function<void(std::shared_ptr<Lighting> lighting)>;
@@ -188,7 +233,25 @@ public:
     using OpenRLTask = std::function<void()>;
     void runOpenRLTask(OpenRLTask task);
 
-    std::shared_ptr<Scene> scene() const { return m_scene; }
+    //-------------------------------------------------------------------------
+    // Rebuild the programs of the frame shader and of the scene materials and
+    // lights that are built from any of 'changedFiles' (shader files relative
+    // to the shader directory) or include one of them. Runs on the OpenRL
+    // thread, the renderer should be reset afterwards.
+    void reloadShaders(std::vector<std::string> changedFiles);
+
+    //-------------------------------------------------------------------------
+    // Resume from the checkpoint of the matching render state (if any) on the
+    // next reset, e.g. after a session was loaded into the current scene.
+    // Scene loads and startup do this on their own. Can be called from any
+    // thread.
+    void resumeCheckpointOnNextReset() { m_resumeCheckpoint = true; }
+
+    std::shared_ptr<Scene> scene() const
+    {
+        std::lock_guard<std::mutex> lock(m_sceneMutex);
+        return m_scene;
+    }
 
     static constexpr RLint kNumRandomSequences = 16;    
 private:
@@ -203,6 +266,11 @@ private:
     void generateRandomSequences(const RLint sampleCount, RenderOptions::SampleMode sampleMode, RenderOptions::BokehShape bokehShape);
     void resetRenderingState(const RenderOptions& newOptions);
     void generateSequenceOffsets(const RLint renderWidth, const RLint renderHeight);
+    uint64_t renderStateHash(const RenderOptions& options) const;
+    std::string checkpointPath() const;
+    void writeCheckpoint();
+    bool resumeFromCheckpoint();
+    bool buildFrameProgram();
 
     bool runInitJob(const RLint renderWidth, const RLint renderHeight);
     void runResizeJob(const RLint newRenderWidth, const RLint newRenderHeight);
@@ -215,8 +283,25 @@ private:
     std::shared_ptr<openrl::Framebuffer> m_fbo = nullptr;          // Framebuffer object used for rendering to.
     std::shared_ptr <openrl::Texture>    m_fboTexture = nullptr;   // Color buffer attached to the main framebuffer object.
 
+    static constexpr std::string_view kFrameShader = "perspective.rlsl";
     std::shared_ptr <openrl::Program> m_frameProgram = nullptr; // Current frame program used for generating primary rays.
 
+    // Uniforms of the frame program that are set every pass.
+    struct FrameUniforms {
+        openrl::UniformHandle fovTan;
+        openrl::UniformHandle aspectRatio;
+        openrl::UniformHandle focusDistance;
+        openrl::UniformHandle apertureRadius;
+        openrl::UniformHandle viewMatrix;
+        openrl::UniformHandle blockSize;
+        openrl::UniformHandle currentBlockPixelSample;
+        openrl::UniformHandle interactiveMode;
+        openrl::UniformHandle interactiveBlockSamplesTexture;
+        openrl::UniformHandle maxSampleIndex;
+        openrl::UniformBlockHandle apertureSamples;
+        openrl::UniformBlockHandle sequenceOffsets;
+    } m_frameUniforms;
+
     std::shared_ptr<openrl::PixelPackBuffer> m_resultPixels = nullptr; // Pixels from all previous passes since the last framebuffer clear.
 
     std::shared_ptr<EnvironmentLight> m_environmentLight = nullptr;
@@ -255,6 +340,22 @@ private:
 
     util::AsyncTaskQueue<Job> m_jobProcessor; // Used to process all jobs on the OpenRL thread.
 
+    struct BackgroundSceneLoad {
+        uint64_t generation = 0; // Value of m_sceneGeneration when the load was requested.
+        ImportSceneCallback importCallback;
+        AddImportCallback addCallback;
+    };
+
+    // Adds the next chunk of 'sceneImport' to 'stagingScene' (creating it and beginning the import first if it is null)
+    // and queues the following one behind the jobs submitted in the meantime, so that adding a large scene doesn't stall
+    // rendering. The last chunk swaps the staging scene in for m_scene.
+    void runAddSceneImportTask(const BackgroundSceneLoad& load, std::shared_ptr<SceneImport> sceneImport, std::shared_ptr<Scene> stagingScene);
+
+    util::AsyncTaskQueue<BackgroundSceneLoad> m_sceneImporter; // Imports scenes for loadSceneInBackground() off of the OpenRL thread.
+    std::atomic<uint64_t> m_sceneGeneration = 0; // Incremented by every scene load, only the latest one is added to the scene.
+    std::atomic<uint32_t> m_pendingSceneLoads = 0;
+    SceneLoadProgress m_sceneLoadProgress;
+
     RenderOptions m_renderOptions;
 
     glm::ivec2 m_currentBlockPixelSample = glm::ivec2(0, 0);
@@ -295,8 +396,16 @@ private:
     std::shared_ptr<openrl::Buffer> m_globalData = nullptr;
 
     std::shared_ptr<Scene> m_scene = nullptr; // All loaded scene data.
+    mutable std::mutex m_sceneMutex; // Guards swapping m_scene against scene(), the OpenRL thread reads it freely.
 
     // 2D pixel coordinates used when determine which pixel within a block
     // should sample when in interactive mode.
     std::shared_ptr<openrl::Texture> m_interactiveBlockCoordsTexture = nullptr;
+
+    RenderCheckpoint m_checkpoint; // Writes checkpoints of the accumulation on a separate thread.
+    uint64_t m_renderStateHash = 0; // Hash of the state that produced the current accumulation.
+    bool m_renderStateHashValid = false; // The hash is only computed while checkpoints are enabled.
+    unsigned int m_lastCheckpointSampleIndex = 0;
+    std::atomic<bool> m_resumeCheckpoint = true; // Set at startup and by scene/session loads, consumed by the next reset.
+    bool m_sceneReplaced = false; // A background load swapped the scene in since the last reset, holds back checkpoints.
 };
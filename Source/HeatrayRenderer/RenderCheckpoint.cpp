@@ -0,0 +1,113 @@
+#include "RenderCheckpoint.h"
+
+#include <Utility/FileIO.h>
+#include <Utility/Log.h>
+#include <Utility/Timer.h>
+
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+
+RenderCheckpoint::RenderCheckpoint()
+{
+    m_writer.init([](WriteJob& job) {
+        write(job);
+        return false;
+    });
+}
+
+RenderCheckpoint::~RenderCheckpoint()
+{
+    m_writer.deinit();
+}
+
+void RenderCheckpoint::writeAsync(const std::string& path, const Header& header, std::vector<float>&& pixels)
+{
+    WriteJob job;
+    job.path = path;
+    job.header = header;
+    job.header.pixelDataOffset = kPixelDataAlignment;
+    job.header.pixelDataSize = pixels.size() * sizeof(float);
+    job.pixels = std::make_shared<const std::vector<float>>(std::move(pixels));
+    m_writer.addTask(std::move(job));
+}
+
+bool RenderCheckpoint::write(const WriteJob& job)
+{
+    util::Timer timer(true);
+
+    std::string tempPath = job.path + ".tmp";
+    {
+        std::ofstream fout(tempPath, std::ios::binary | std::ios::trunc);
+        if (!fout) {
+            LOG_ERROR("Unable to open checkpoint file %s for writing", tempPath.c_str());
+            return false;
+        }
+
+        static_assert(sizeof(Header) <= kPixelDataAlignment, "Checkpoint header must fit before the pixel data");
+        std::vector<char> headerBlock(kPixelDataAlignment, 0);
+        memcpy(headerBlock.data(), &job.header, sizeof(Header));
+
+        fout.write(headerBlock.data(), headerBlock.size());
+        fout.write(reinterpret_cast<const char*>(job.pixels->data()), job.header.pixelDataSize);
+        fout.close();
+        if (!fout) {
+            LOG_ERROR("Failed to write checkpoint file %s", tempPath.c_str());
+            std::error_code error;
+            std::filesystem::remove(tempPath, error);
+            return false;
+        }
+    }
+
+    // Replace the previous checkpoint only once the new one is completely on disk. Without
+    // the sync a crash could persist the rename before the data it points to.
+    std::error_code error;
+    if (!util::syncFile(tempPath)) {
+        LOG_ERROR("Unable to flush checkpoint file %s to disk", tempPath.c_str());
+        std::filesystem::remove(tempPath, error);
+        return false;
+    }
+    std::filesystem::rename(tempPath, job.path, error);
+    if (error) {
+        LOG_ERROR("Unable to move checkpoint into place at %s: %s", job.path.c_str(), error.message().c_str());
+        std::filesystem::remove(tempPath, error);
+        return false;
+    }
+    util::syncDirectory(std::filesystem::path(job.path).parent_path().string());
+
+    LOG_INFO("Wrote checkpoint at pass %u to %s in %f seconds", job.header.sampleIndex, job.path.c_str(), timer.stop());
+    return true;
+}
+
+bool RenderCheckpoint::open(const std::string& path, uint64_t stateHash, int32_t width, int32_t height,
+                            util::MappedFile& file, Header& header, const float*& pixels)
+{
+    if (!file.open(path)) {
+        return false;
+    }
+
+    if (file.size() < sizeof(Header)) {
+        LOG_WARNING("Ignoring truncated checkpoint %s", path.c_str());
+        file.close();
+        return false;
+    }
+
+    memcpy(&header, file.data(), sizeof(Header));
+    if ((header.magic != kMagic) || (header.version != kVersion)) {
+        LOG_WARNING("Ignoring checkpoint %s with an unsupported format", path.c_str());
+        file.close();
+        return false;
+    }
+
+    const uint64_t expectedPixelDataSize = uint64_t(width) * uint64_t(height) * 4 * sizeof(float);
+    if ((header.stateHash != stateHash) || (header.width != width) || (header.height != height) ||
+        (header.pixelDataSize != expectedPixelDataSize) ||
+        (header.pixelDataOffset + header.pixelDataSize > file.size())) {
+        // The checkpoint belongs to a different render.
+        file.close();
+        return false;
+    }
+
+    pixels = reinterpret_cast<const float*>(file.data() + header.pixelDataOffset);
+    return true;
+}
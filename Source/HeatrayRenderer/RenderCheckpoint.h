@@ -0,0 +1,75 @@
+//
+//  RenderCheckpoint.h
+//  Heatray
+//
+//  Saves and restores the progressive accumulation buffer so that long
+//  renders can be resumed after the process exits.
+//
+//
+
+#pragma once
+
+#include <Utility/AsyncTaskQueue.h>
+#include <Utility/MappedFile.h>
+
+#include <memory>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+class RenderCheckpoint
+{
+public:
+    //-------------------------------------------------------------------------
+    // On-disk header of a checkpoint file. The raw RGBA float accumulation
+    // follows at 'pixelDataOffset', which is page aligned so that the pixel
+    // data can be used straight out of a memory mapping.
+    struct Header {
+        uint32_t magic = kMagic;
+        uint32_t version = kVersion;
+        int32_t width = 0;  // In pixels.
+        int32_t height = 0; // In pixels.
+        uint32_t sampleIndex = 0;
+        int32_t blockPixelSampleX = 0;
+        int32_t blockPixelSampleY = 0;
+        uint32_t padding = 0;
+        uint64_t stateHash = 0; // Hash of the render options and scene that produced the accumulation.
+        uint64_t pixelDataOffset = kPixelDataAlignment; // In bytes from the start of the file.
+        uint64_t pixelDataSize = 0; // In bytes.
+    };
+
+    static constexpr uint32_t kMagic = 0x4B435248; // 'HRCK'.
+    static constexpr uint32_t kVersion = 1;
+    static constexpr uint64_t kPixelDataAlignment = 4096;
+
+    RenderCheckpoint();
+    ~RenderCheckpoint();
+
+    //-------------------------------------------------------------------------
+    // Queue a checkpoint to be written to 'path' on the internal writer
+    // thread. The file is first written to a temporary path and then renamed
+    // so that a partially written checkpoint never replaces a valid one.
+    void writeAsync(const std::string& path, const Header& header, std::vector<float>&& pixels);
+
+    //-------------------------------------------------------------------------
+    // Stall the calling thread until all queued checkpoints have been written.
+    void finish() { m_writer.finish(); }
+
+    //-------------------------------------------------------------------------
+    // Memory map the checkpoint at 'path'. Returns true if the checkpoint
+    // exists and was produced with the same state hash and dimensions. On
+    // success 'pixels' points into 'file' and remains valid while it is open.
+    static bool open(const std::string& path, uint64_t stateHash, int32_t width, int32_t height,
+                     util::MappedFile& file, Header& header, const float*& pixels);
+
+private:
+    struct WriteJob {
+        std::string path;
+        Header header;
+        std::shared_ptr<const std::vector<float>> pixels; // Shared so that queueing the job does not copy the pixels.
+    };
+
+    static bool write(const WriteJob& job);
+
+    util::AsyncTaskQueue<WriteJob> m_writer;
+};
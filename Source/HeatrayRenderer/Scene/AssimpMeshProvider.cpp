@@ -2,17 +2,15 @@
 
 #include "AssimpMeshProvider.h"
 
-#include "Lighting.h"
-
-#include "HeatrayRenderer/Lights/DirectionalLight.h"
-#include "HeatrayRenderer/Lights/PointLight.h"
-#include "HeatrayRenderer/Lights/SpotLight.h"
-#include "HeatrayRenderer/Materials/GlassMaterial.h"
-#include "HeatrayRenderer/Materials/PhysicallyBasedMaterial.h"
 #include "Utility/AABB.h"
+#include "Utility/Hash.h"
 #include "Utility/Log.h"
-#include "Utility/TextureLoader.h"
+#include "Utility/MeshOptimizer.h"
+#include "Utility/ParallelFor.h"
+#include "Utility/Timer.h"
+#include "Utility/VertexQuantization.h"
 
+#include "assimp/DefaultIOSystem.h"
 #include "assimp/GltfMaterial.h"
 #include "glm/glm/glm.hpp"
 #include "glm/glm/gtc/constants.hpp"
@@ -21,9 +19,16 @@
 #include "glm/glm/gtx/euler_angles.hpp"
 #include "glm/glm/gtx/transform.hpp"
 
+#include <algorithm>
+#include <array>
 #include <assert.h>
+#include <cstring>
 #include <filesystem>
+#include <limits>
 #include <memory>
+#include <memory_resource>
+#include <type_traits>
+#include <unordered_map>
 
 class AssimpLogToCoutStream : public Assimp::LogStream
 {
@@ -33,6 +38,26 @@ public:
     virtual void write(const char* message) { LOG_INFO("Assimp: %s", message); }
 };
 
+// Records every file Assimp opens so that caches of the import can be invalidated when any of them change.
+class RecordingIOSystem : public Assimp::DefaultIOSystem
+{
+public:
+    explicit RecordingIOSystem(std::vector<std::string>& files) : m_files(files) {}
+
+    using Assimp::DefaultIOSystem::Open;
+    Assimp::IOStream* Open(const char* file, const char* mode) override
+    {
+        Assimp::IOStream* stream = Assimp::DefaultIOSystem::Open(file, mode);
+        if (stream) {
+            m_files.emplace_back(file);
+        }
+        return stream;
+    }
+
+private:
+    std::vector<std::string>& m_files;
+};
+
 glm::mat4x4 getFullTransform(aiScene const *scene, const aiString &nodeName, const bool convertToMeters)
 {
     // Walk up the tree until we find the root, concatenating transforms along the way.
@@ -62,29 +87,34 @@ glm::mat4x4 getFullTransform(aiScene const *scene, const aiString &nodeName, con
     return finalTransform;
 }
 
-AssimpMeshProvider::AssimpMeshProvider(const std::string_view filename, bool convertToMeters, std::shared_ptr<Lighting> lighting)
+AssimpMeshProvider::AssimpMeshProvider(const std::string_view filename, bool convertToMeters, VertexLayout vertexLayout, VertexFormat vertexFormat,
+                                       MeshOptimization meshOptimization)
 : MeshProvider(filename)
 , m_filename(std::move(filename))
 , m_convertToMeters(convertToMeters)
+, m_vertexLayout(vertexLayout)
+, m_vertexFormat(vertexFormat)
+, m_meshOptimization(meshOptimization)
 {
-    LoadScene(m_filename, lighting);
+    LoadScene(m_filename);
     
     LOG_INFO("Scene AABB (min): %f %f %f", m_sceneAABB.min.x, m_sceneAABB.min.y, m_sceneAABB.min.z);
     LOG_INFO("Scene AABB (max): %f %f %f", m_sceneAABB.max.x, m_sceneAABB.max.y, m_sceneAABB.max.z);
 }
 
-void AssimpMeshProvider::ProcessNode(const aiScene * scene, const aiNode * node, const aiMatrix4x4 & parentTransform, int level)
+void AssimpMeshProvider::ProcessNode(const aiScene * scene, const aiNode * node, const aiMatrix4x4 & parentTransform, int level,
+                                     std::pmr::vector<std::pmr::vector<glm::mat4x4>> & meshTransforms)
 {
     aiMatrix4x4 transform = parentTransform * node->mTransformation;
 
-    // Set the mesh transforms for this node.
+    // Record the mesh transforms for this node. A mesh referenced by several nodes gets one transform per node.
     for (unsigned int ii = 0; ii < node->mNumMeshes; ++ii) {
         // glm is column major, assimp is row major;
-        glm::mat4x4 *submeshTransform = &m_submeshes[node->mMeshes[ii]].localTransform;
-        *submeshTransform = glm::mat4x4(transform.a1, transform.b1, transform.c1, transform.d1,
-                                        transform.a2, transform.b2, transform.c2, transform.d2,
-                                        transform.a3, transform.b3, transform.c3, transform.d3,
-                                        transform.a4, transform.b4, transform.c4, transform.d4);
+        glm::mat4x4 submeshTransform = glm::mat4x4(transform.a1, transform.b1, transform.c1, transform.d1,
+                                                   transform.a2, transform.b2, transform.c2, transform.d2,
+                                                   transform.a3, transform.b3, transform.c3, transform.d3,
+                                                   transform.a4, transform.b4, transform.c4, transform.d4);
+        meshTransforms[node->mMeshes[ii]].push_back(submeshTransform);
 
         // Determine the transformed AABB for this node in order to calculate the final scene AABB.
         {
@@ -92,288 +122,510 @@ void AssimpMeshProvider::ProcessNode(const aiScene * scene, const aiNode * node,
             glm::vec4 aabb_min = glm::vec4(node_aabb.mMin.x, node_aabb.mMin.y, node_aabb.mMin.z, 1.0f);
             glm::vec4 aabb_max = glm::vec4(node_aabb.mMax.x, node_aabb.mMax.y, node_aabb.mMax.z, 1.0f);
 
-            m_sceneAABB.expand(*submeshTransform * aabb_min);
-            m_sceneAABB.expand(*submeshTransform * aabb_max);
+            m_sceneAABB.expand(submeshTransform * aabb_min);
+            m_sceneAABB.expand(submeshTransform * aabb_max);
         }
     }
     
     for (unsigned int ii = 0; ii < node->mNumChildren; ++ii) {
-        ProcessNode(scene, node->mChildren[ii], transform, level + 1);
+        ProcessNode(scene, node->mChildren[ii], transform, level + 1, meshTransforms);
     }
 }
 
-void AssimpMeshProvider::ProcessMesh(aiMesh const * mesh)
+void AssimpMeshProvider::ProcessInstances(const std::pmr::vector<std::pmr::vector<glm::mat4x4>> & meshTransforms)
 {
-    Submesh submesh;
-
-    if (mesh->HasPositions()) {
-        LOG_INFO("Positions: %u", mesh->mNumVertices);
-        VertexAttribute & attribute = submesh.vertexAttributes[submesh.vertexAttributeCount];
-        attribute.usage = VertexAttributeUsage_Position;
-        attribute.buffer = (int)m_vertexBuffers.size();
-        attribute.componentCount = 3;
-        attribute.size = sizeof(float);
-        attribute.offset = 0;
-        attribute.stride = 3 * sizeof(float);
+    // The first reference to a mesh uses its existing submesh and every further reference becomes an
+    // additional submesh sharing the same vertex and index buffers. Meshes that are never referenced
+    // keep an identity transform.
+    const size_t meshCount = m_submeshes.size();
+    size_t instanceCount = 0;
+    for (size_t meshIndex = 0; meshIndex < meshCount; ++meshIndex) {
+        const std::pmr::vector<glm::mat4x4> & transforms = meshTransforms[meshIndex];
+        for (size_t ii = 0; ii < transforms.size(); ++ii) {
+            if (ii == 0) {
+                m_submeshes[meshIndex].localTransform = transforms[ii];
+            } else {
+                Submesh instance = m_submeshes[meshIndex];
+                instance.localTransform = transforms[ii];
+                m_submeshes.push_back(std::move(instance));
+                ++instanceCount;
+            }
+        }
+    }
 
-        m_vertexBuffers.push_back(std::vector<float>());
-        std::vector<float> & vertexBuffer = m_vertexBuffers.back();
-        vertexBuffer.reserve(mesh->mNumVertices * 3);
+    if (instanceCount > 0) {
+        LOG_INFO("Added %zu mesh instances sharing the geometry of %zu meshes", instanceCount, meshCount);
+    }
+}
 
-        for (uint32_t iVertex = 0; iVertex < mesh->mNumVertices; ++iVertex) {
-            glm::vec3 position(mesh->mVertices[iVertex].x, mesh->mVertices[iVertex].y, mesh->mVertices[iVertex].z);
-            vertexBuffer.push_back(position.x);
-            vertexBuffer.push_back(position.y);
-            vertexBuffer.push_back(position.z);
-        }
+size_t AssimpMeshProvider::VertexComponentCount(aiMesh const * mesh) const
+{
+    // Compact attributes pack two 16bit components into the space of one float.
+    const bool compact = (m_vertexFormat == VertexFormat::kCompact);
+
+    size_t count = 0;
+    count += mesh->HasPositions() ? 3 : 0;
+    count += mesh->HasNormals() ? (compact ? 1 : 3) : 0;
+    count += mesh->HasTextureCoords(0) ? (compact ? 1 : mesh->mNumUVComponents[0]) : 0;
+    count += mesh->HasTangentsAndBitangents() ? (compact ? 1 : 6) : 0;
+    count += mesh->HasVertexColors(0) ? 3 : 0;
+    return count;
+}
 
-        ++submesh.vertexAttributeCount;
+size_t AssimpMeshProvider::VertexBufferCount(aiMesh const * mesh) const
+{
+    if (m_vertexLayout == VertexLayout::kInterleaved) {
+        return (VertexComponentCount(mesh) > 0) ? 1 : 0;
     }
-    if (mesh->HasNormals()) {
-        LOG_INFO("Normals: %u", mesh->mNumVertices);
-        VertexAttribute & attribute = submesh.vertexAttributes[submesh.vertexAttributeCount];
-        attribute.usage = VertexAttributeUsage_Normal;
-        attribute.buffer = (int)m_vertexBuffers.size();
-        attribute.componentCount = 3;
-        attribute.size = sizeof(float);
-        attribute.offset = 0;
-        attribute.stride = 3 * sizeof(float);
 
-        m_vertexBuffers.push_back(std::vector<float>());
-        std::vector<float> & vertexBuffer = m_vertexBuffers.back();
-        vertexBuffer.reserve(mesh->mNumVertices * 3);
+    size_t count = 0;
+    count += mesh->HasPositions() ? 1 : 0;
+    count += mesh->HasNormals() ? 1 : 0;
+    count += mesh->HasTextureCoords(0) ? 1 : 0;
+    count += mesh->HasTangentsAndBitangents() ? ((m_vertexFormat == VertexFormat::kCompact) ? 1 : 2) : 0;
+    count += mesh->HasVertexColors(0) ? 1 : 0;
+    return count;
+}
 
-        for (uint32_t iVertex = 0; iVertex < mesh->mNumVertices; ++iVertex) {
-            glm::vec3 normal(mesh->mNormals[iVertex].x, mesh->mNormals[iVertex].y, mesh->mNormals[iVertex].z);
-            vertexBuffer.push_back(normal.x);
-            vertexBuffer.push_back(normal.y);
-            vertexBuffer.push_back(normal.z);
-        }
+namespace {
+
+//-------------------------------------------------------------------------
+// Copy the first 'componentCount' floats of each element in 'source' into
+// 'destination', where consecutive vertices are 'stride' floats apart. If
+// 'order' is not empty then vertex ii of 'destination' is read from vertex
+// order[ii] of 'source'. Tightly packed destinations in source order are
+// copied with a single memcpy.
+template<class T>
+void copyVertexData(const T * source, uint32_t vertexCount, uint32_t componentCount, float * destination, size_t stride,
+                    const std::pmr::vector<uint32_t> & order)
+{
+    static_assert((sizeof(T) % sizeof(float)) == 0, "Assimp must be built with single precision floats");
+    assert((componentCount * sizeof(float)) <= sizeof(T));
 
-        ++submesh.vertexAttributeCount;
+    if ((sizeof(T) == (componentCount * sizeof(float))) && (stride == componentCount) && order.empty()) {
+        std::memcpy(destination, source, vertexCount * sizeof(T));
+        return;
     }
-    if (mesh->HasTextureCoords(0)) {
-        LOG_INFO("UVs: %u", mesh->mNumVertices);
-        size_t positionsByteCount = mesh->mNumVertices * mesh->mNumUVComponents[0] * sizeof(float);
-
-        VertexAttribute & attribute = submesh.vertexAttributes[submesh.vertexAttributeCount];
-        attribute.usage = VertexAttributeUsage_TexCoord;
-        attribute.buffer = (int)m_vertexBuffers.size();
-        attribute.componentCount = mesh->mNumUVComponents[0];
-        attribute.size = sizeof(float);
-        attribute.offset = 0;
-        attribute.stride = mesh->mNumUVComponents[0] * sizeof(float);
 
-        m_vertexBuffers.push_back(std::vector<float>());
-        std::vector<float> & vertexBuffer = m_vertexBuffers.back();
-        vertexBuffer.reserve(mesh->mNumVertices * mesh->mNumUVComponents[0]);
+    const size_t componentBytes = componentCount * sizeof(float);
+    for (uint32_t iVertex = 0; iVertex < vertexCount; ++iVertex) {
+        const uint32_t sourceVertex = order.empty() ? iVertex : order[iVertex];
+        std::memcpy(destination + iVertex * stride, &source[sourceVertex], componentBytes);
+    }
+}
 
-        for (uint32_t iVertex = 0; iVertex < mesh->mNumVertices; ++iVertex) {
-            for (uint32_t iComponent = 0; iComponent < mesh->mNumUVComponents[0]; ++iComponent) {
-                vertexBuffer.push_back(mesh->mTextureCoords[0][iVertex][iComponent]);
-            }
-        }
+//-------------------------------------------------------------------------
+// Split every polygon of 'mesh' into a fan of triangles and write their
+// indices to 'indices'. Faces with fewer than 3 indices are skipped.
+template<class Index>
+void triangulate(aiMesh const * mesh, Index * indices)
+{
+    for (unsigned int iFace = 0; iFace < mesh->mNumFaces; ++iFace) {
+        auto & face = mesh->mFaces[iFace];
 
-        ++submesh.vertexAttributeCount;
+        for (unsigned int iSubFace = 2; iSubFace < face.mNumIndices; ++iSubFace) {
+            *indices++ = Index(face.mIndices[0]);
+            *indices++ = Index(face.mIndices[iSubFace-1]);
+            *indices++ = Index(face.mIndices[iSubFace]);
+        }
     }
-    if (mesh->HasTangentsAndBitangents()) {
-        LOG_INFO("Tangents/Bitangents: %u", mesh->mNumVertices);
-        // Tangents.
-        {
-            VertexAttribute& attribute = submesh.vertexAttributes[submesh.vertexAttributeCount];
-            attribute.usage = VertexAttributeUsage_Tangents;
-            attribute.buffer = (int)m_vertexBuffers.size();
-            attribute.componentCount = 3;
-            attribute.size = sizeof(float);
-            attribute.offset = 0;
-            attribute.stride = 3 * sizeof(float);
-
-            m_vertexBuffers.push_back(std::vector<float>());
-            std::vector<float>& vertexBuffer = m_vertexBuffers.back();
-            vertexBuffer.reserve(mesh->mNumVertices * 3);
-
-            for (uint32_t iVertex = 0; iVertex < mesh->mNumVertices; ++iVertex) {
-                glm::vec3 tangent(mesh->mTangents[iVertex].x, mesh->mTangents[iVertex].y, mesh->mTangents[iVertex].z);
-                vertexBuffer.push_back(tangent.x);
-                vertexBuffer.push_back(tangent.y);
-                vertexBuffer.push_back(tangent.z);
-            }
+}
+
+} // namespace.
+
+void AssimpMeshProvider::ProcessMesh(aiMesh const * mesh, size_t meshIndex, size_t firstVertexBuffer)
+{
+    // Every mesh writes into its own preallocated slots (submesh, index buffer and a contiguous
+    // run of vertex buffers) so that meshes can be converted concurrently and still end up in
+    // the same order as the serial conversion.
+    Submesh & submesh = m_submeshes[meshIndex];
+    const uint32_t vertexCount = mesh->mNumVertices;
 
-            ++submesh.vertexAttributeCount;
+    // Faces with fewer than 3 indices are points or lines and are not rendered.
+    size_t indexCount = 0;
+    for (unsigned int ff = 0; ff < mesh->mNumFaces; ++ff) {
+        if (mesh->mFaces[ff].mNumIndices >= 3) {
+            indexCount += (mesh->mFaces[ff].mNumIndices - 2) * 3;
         }
+    }
 
-        // Bitangents.
-        {
-            VertexAttribute& attribute = submesh.vertexAttributes[submesh.vertexAttributeCount];
-            attribute.usage = VertexAttributeUsage_Bitangents;
-            attribute.buffer = (int)m_vertexBuffers.size();
-            attribute.componentCount = 3;
-            attribute.size = sizeof(float);
-            attribute.offset = 0;
-            attribute.stride = 3 * sizeof(float);
-
-            m_vertexBuffers.push_back(std::vector<float>());
-            std::vector<float>& vertexBuffer = m_vertexBuffers.back();
-            vertexBuffer.reserve(mesh->mNumVertices * 3);
-
-            for (uint32_t iVertex = 0; iVertex < mesh->mNumVertices; ++iVertex) {
-                // Assimp often gives garbage bitangents, so we calculate our own here.
-                glm::vec3 normal(mesh->mNormals[iVertex].x, mesh->mNormals[iVertex].y, mesh->mNormals[iVertex].z);
-                glm::vec3 tangent(mesh->mTangents[iVertex].x, mesh->mTangents[iVertex].y, mesh->mTangents[iVertex].z);
-                glm::vec3 bitangent = glm::cross(normal, tangent);
-                vertexBuffer.push_back(bitangent.x);
-                vertexBuffer.push_back(bitangent.y);
-                vertexBuffer.push_back(bitangent.z);
-            }
+    // The triangles are reordered before any vertex data is written so that the vertices can be
+    // written in the order the reordered triangles first use them. The optimizer tables only live
+    // as long as the conversion of this mesh, on the worker converting it (see m_arena).
+    std::pmr::monotonic_buffer_resource scratch;
+    std::pmr::vector<uint32_t> optimizedIndices(&scratch);
+    std::pmr::vector<uint32_t> vertexOrder(&scratch); // Output vertex ii is read from vertex vertexOrder[ii] of the mesh.
+    if ((m_meshOptimization != MeshOptimization::kNone) && (indexCount > 0)) {
+        optimizedIndices.resize(indexCount);
+        triangulate(mesh, optimizedIndices.data());
+        if ((m_meshOptimization == MeshOptimization::kSpatial) && mesh->HasPositions()) {
+            util::sortTrianglesSpatially(optimizedIndices.data(), indexCount, &mesh->mVertices[0].x, sizeof(aiVector3D) / sizeof(float),
+                                         &scratch);
+        } else {
+            util::optimizeVertexCache(optimizedIndices.data(), indexCount, vertexCount, util::kDefaultVertexCacheSize, &scratch);
+        }
 
-            ++submesh.vertexAttributeCount;
+        const std::pmr::vector<uint32_t> remap = util::optimizeVertexFetch(optimizedIndices.data(), indexCount, vertexCount, &scratch);
+        vertexOrder.resize(vertexCount);
+        for (uint32_t iVertex = 0; iVertex < vertexCount; ++iVertex) {
+            vertexOrder[remap[iVertex]] = iVertex;
         }
     }
+    auto sourceVertex = [&vertexOrder](uint32_t iVertex) { return vertexOrder.empty() ? iVertex : vertexOrder[iVertex]; };
+
+    // With the interleaved layout every attribute lives in a single buffer, one vertex after
+    // another. Otherwise each attribute gets its own tightly packed buffer.
+    const bool interleaved = (m_vertexLayout == VertexLayout::kInterleaved);
+    const size_t vertexStride = VertexComponentCount(mesh); // In floats.
+    if (interleaved && (vertexStride > 0)) {
+        m_vertexBuffers[firstVertexBuffer].resize(size_t(vertexCount) * vertexStride);
+    }
 
-    if (mesh->HasVertexColors(0)) {
-        LOG_INFO("Vertex Colors: %u", mesh->mNumVertices);
-        VertexAttribute& attribute = submesh.vertexAttributes[submesh.vertexAttributeCount];
-        attribute.usage = VertexAttributeUsage_Colors;
-        attribute.buffer = (int)m_vertexBuffers.size();
-        attribute.componentCount = 3;
-        attribute.size = sizeof(float);
+    size_t vertexBufferIndex = firstVertexBuffer;
+    size_t interleavedOffset = 0; // In floats.
+
+    struct AttributeData {
+        float * data = nullptr;
+        size_t stride = 0; // In floats.
+    };
+    auto addAttribute = [&](VertexAttributeUsage usage, uint32_t componentCount,
+                            VertexAttributeType type = VertexAttributeType::kFloat) -> AttributeData {
+        VertexAttribute & attribute = submesh.vertexAttributes[submesh.vertexAttributeCount++];
+        attribute.usage = usage;
+        attribute.type = type;
+        attribute.componentCount = componentCount;
+        attribute.size = (type == VertexAttributeType::kFloat) ? sizeof(float) : sizeof(uint16_t);
+
+        // Space taken by the attribute in floats, 16bit components are always used in pairs.
+        const uint32_t floatCount = (componentCount * attribute.size) / sizeof(float);
+
+        if (interleaved) {
+            attribute.buffer = (int)firstVertexBuffer;
+            attribute.offset = interleavedOffset * sizeof(float);
+            attribute.stride = int(vertexStride * sizeof(float));
+
+            AttributeData result = { m_vertexBuffers[firstVertexBuffer].data() + interleavedOffset, vertexStride };
+            interleavedOffset += floatCount;
+            return result;
+        }
+
+        attribute.buffer = (int)vertexBufferIndex;
         attribute.offset = 0;
-        attribute.stride = 3 * sizeof(float);
+        attribute.stride = int(floatCount * sizeof(float));
 
-        m_vertexBuffers.push_back(std::vector<float>());
-        std::vector<float>& vertexBuffer = m_vertexBuffers.back();
-        vertexBuffer.reserve(mesh->mNumVertices * 3);
+        std::pmr::vector<float> & vertexBuffer = m_vertexBuffers[vertexBufferIndex++];
+        vertexBuffer.resize(size_t(vertexCount) * floatCount);
+        return { vertexBuffer.data(), floatCount };
+    };
 
-        for (uint32_t iVertex = 0; iVertex < mesh->mNumVertices; ++iVertex) {
-            glm::vec3 color(mesh->mColors[0][iVertex].r, mesh->mColors[0][iVertex].g, mesh->mColors[0][iVertex].b);
-            vertexBuffer.push_back(color.x);
-            vertexBuffer.push_back(color.y);
-            vertexBuffer.push_back(color.z);
+    // Write a pair of 16bit components into the float sized slot of each vertex.
+    auto writePairs = [vertexCount, &sourceVertex](const AttributeData & attribute, auto && encode) {
+        for (uint32_t iVertex = 0; iVertex < vertexCount; ++iVertex) {
+            auto pair = encode(sourceVertex(iVertex));
+            std::memcpy(attribute.data + iVertex * attribute.stride, pair.data(), sizeof(float));
         }
+    };
+    auto octahedral = [](const aiVector3D & v) { return util::encodeOctahedralSnorm16(glm::vec3(v.x, v.y, v.z)); };
+    const bool compact = (m_vertexFormat == VertexFormat::kCompact);
 
-        ++submesh.vertexAttributeCount;
-
-        // Tell the associated material to enable vertex colors.
-        m_materials[mesh->mMaterialIndex]->enableVertexColors();
+    if (mesh->HasPositions()) {
+        AttributeData positions = addAttribute(VertexAttributeUsage_Position, 3);
+        copyVertexData(mesh->mVertices, vertexCount, 3, positions.data, positions.stride, vertexOrder);
     }
-
-    size_t indexCount = 0;
-    for (unsigned int ff = 0; ff < mesh->mNumFaces; ++ff) {
-        indexCount += (mesh->mFaces[ff].mNumIndices - 2) * 3;
+    if (mesh->HasNormals()) {
+        if (compact) {
+            AttributeData normals = addAttribute(VertexAttributeUsage_Normal, 2, VertexAttributeType::kShort);
+            writePairs(normals, [&](uint32_t iVertex) { return octahedral(mesh->mNormals[iVertex]); });
+        } else {
+            AttributeData normals = addAttribute(VertexAttributeUsage_Normal, 3);
+            copyVertexData(mesh->mNormals, vertexCount, 3, normals.data, normals.stride, vertexOrder);
+        }
     }
+    if (mesh->HasTextureCoords(0)) {
+        if (compact) {
+            // Quantize relative to the bounds of this mesh's texture coordinates, the shader undoes the mapping.
+            glm::vec2 uvMin(std::numeric_limits<float>::max());
+            glm::vec2 uvMax(-std::numeric_limits<float>::max());
+            for (uint32_t iVertex = 0; iVertex < vertexCount; ++iVertex) {
+                glm::vec2 uv(mesh->mTextureCoords[0][iVertex].x, mesh->mTextureCoords[0][iVertex].y);
+                uvMin = glm::min(uvMin, uv);
+                uvMax = glm::max(uvMax, uv);
+            }
+            submesh.texCoordTransform = util::texCoordTransform(uvMin, uvMax);
 
-    m_indexBuffers.push_back(std::vector<int>());
-    std::vector<int> & indexBuffer = m_indexBuffers.back();
-    indexBuffer.reserve(indexCount);
+            AttributeData uvs = addAttribute(VertexAttributeUsage_TexCoord, 2, VertexAttributeType::kUnsignedShort);
+            writePairs(uvs, [&](uint32_t iVertex) {
+                const glm::vec2 uv(mesh->mTextureCoords[0][iVertex].x, mesh->mTextureCoords[0][iVertex].y);
+                return util::quantizeTexCoord(uv, submesh.texCoordTransform);
+            });
+        } else {
+            const uint32_t componentCount = mesh->mNumUVComponents[0];
+            AttributeData uvs = addAttribute(VertexAttributeUsage_TexCoord, componentCount);
+            copyVertexData(mesh->mTextureCoords[0], vertexCount, componentCount, uvs.data, uvs.stride, vertexOrder);
+        }
+    }
+    if (mesh->HasTangentsAndBitangents() && compact) {
+        // The bitangent is always cross(normal, tangent) so the shader rebuilds it from the other two.
+        AttributeData tangents = addAttribute(VertexAttributeUsage_Tangents, 2, VertexAttributeType::kShort);
+        writePairs(tangents, [&](uint32_t iVertex) { return octahedral(mesh->mTangents[iVertex]); });
+    } else if (mesh->HasTangentsAndBitangents()) {
+        AttributeData tangents = addAttribute(VertexAttributeUsage_Tangents, 3);
+        copyVertexData(mesh->mTangents, vertexCount, 3, tangents.data, tangents.stride, vertexOrder);
+
+        AttributeData bitangents = addAttribute(VertexAttributeUsage_Bitangents, 3);
+        for (uint32_t iVertex = 0; iVertex < vertexCount; ++iVertex) {
+            // Assimp often gives garbage bitangents, so we calculate our own here.
+            const uint32_t source = sourceVertex(iVertex);
+            glm::vec3 normal(mesh->mNormals[source].x, mesh->mNormals[source].y, mesh->mNormals[source].z);
+            glm::vec3 tangent(mesh->mTangents[source].x, mesh->mTangents[source].y, mesh->mTangents[source].z);
+            glm::vec3 bitangent = glm::cross(normal, tangent);
+
+            float * destination = bitangents.data + iVertex * bitangents.stride;
+            destination[0] = bitangent.x;
+            destination[1] = bitangent.y;
+            destination[2] = bitangent.z;
+        }
+    }
+    if (mesh->HasVertexColors(0)) {
+        // The associated material has vertex colors enabled once all meshes are converted
+        // since materials are shared between meshes. Only RGB is used.
+        AttributeData colors = addAttribute(VertexAttributeUsage_Colors, 3);
+        copyVertexData(mesh->mColors[0], vertexCount, 3, colors.data, colors.stride, vertexOrder);
+    }
+    assert(!interleaved || (interleavedOffset == vertexStride));
+    assert(interleaved || (vertexBufferIndex == firstVertexBuffer + VertexBufferCount(mesh)));
 
-    LOG_INFO("Building vertex indices...");
-    for (unsigned int iFace = 0; iFace < mesh->mNumFaces; ++iFace) {
-        auto & face = mesh->mFaces[iFace];
+    submesh.indexType = indexTypeForVertexCount(vertexCount);
+    std::pmr::vector<uint8_t> & indexBuffer = m_indexBuffers[meshIndex];
+    indexBuffer.resize(indexCount * indexSize(submesh.indexType));
 
-        for (unsigned int iSubFace = 2; iSubFace < face.mNumIndices; ++iSubFace) {
-            indexBuffer.push_back(face.mIndices[0]);
-            indexBuffer.push_back(face.mIndices[iSubFace-1]);
-            indexBuffer.push_back(face.mIndices[iSubFace]);
+    auto writeIndices = [&](auto * indices) {
+        if (optimizedIndices.empty()) {
+            triangulate(mesh, indices);
+        } else {
+            std::copy(optimizedIndices.begin(), optimizedIndices.end(), indices);
         }
+    };
+    if (submesh.indexType == IndexType::kUInt16) {
+        writeIndices(reinterpret_cast<uint16_t *>(indexBuffer.data()));
+    } else {
+        writeIndices(reinterpret_cast<uint32_t *>(indexBuffer.data()));
     }
-    LOG_INFO("\tDONE");
 
     submesh.drawMode = DrawMode::Triangles;
     submesh.elementCount = indexCount;
-    submesh.indexBuffer = m_indexBuffers.size() - 1;
+    submesh.indexBuffer = meshIndex;
     submesh.indexOffset = 0;
     submesh.materialIndex = mesh->mMaterialIndex;
     submesh.name = std::string(mesh->mName.C_Str());
-    m_submeshes.push_back(submesh);
 }
 
-void AssimpMeshProvider::ProcessGlassMaterial(aiMaterial const* material)
+void AssimpMeshProvider::ProcessMeshes(aiScene const * scene)
 {
-    std::string name = material->GetName().C_Str();
-    std::shared_ptr<GlassMaterial> glassMaterial = std::make_shared<GlassMaterial>(name);
-    GlassMaterial::Parameters& params = glassMaterial->parameters();
-    params.baseColor = { 1.0f, 1.0f, 1.0f };
-    params.density = 0.05f;
-    params.ior = 1.33f;
-    params.roughness = 0.0f;
+    util::Timer timer(true);
+
+    // Bookkeeping that is only needed until the meshes have been converted and deduplicated.
+    std::pmr::monotonic_buffer_resource scratch;
+
+    // Assign every mesh its output slots up front so the conversion order (and therefore the
+    // buffer indices referenced by each submesh) does not depend on thread scheduling.
+    std::pmr::vector<size_t> firstVertexBuffers(scene->mNumMeshes, &scratch);
+    size_t vertexBufferCount = 0;
+    for (unsigned int ii = 0; ii < scene->mNumMeshes; ++ii) {
+        firstVertexBuffers[ii] = vertexBufferCount;
+        vertexBufferCount += VertexBufferCount(scene->mMeshes[ii]);
+    }
 
-    material->Get(AI_MATKEY_ROUGHNESS_FACTOR, params.roughness);
-    material->Get(AI_MATKEY_REFRACTI, params.ior);
+    m_vertexBuffers.resize(vertexBufferCount);
+    m_indexBuffers.resize(scene->mNumMeshes);
+    m_submeshes.resize(scene->mNumMeshes);
 
-    aiColor3D color;
-    if (material->Get(AI_MATKEY_BASE_COLOR, color) == aiReturn_SUCCESS) {
-        params.baseColor = glm::vec3(color.r, color.g, color.b);
+    util::parallelFor(scene->mNumMeshes, [&](size_t meshIndex, size_t /*workerIndex*/) {
+        ProcessMesh(scene->mMeshes[meshIndex], meshIndex, firstVertexBuffers[meshIndex]);
+    });
+
+    // Tell the associated materials to enable vertex colors.
+    for (unsigned int ii = 0; ii < scene->mNumMeshes; ++ii) {
+        aiMesh const * mesh = scene->mMeshes[ii];
+        if (mesh->HasVertexColors(0)) {
+            m_materialRecords[mesh->mMaterialIndex].vertexColors = true;
+        }
     }
 
-    // Textures.
-    {
-        auto filePath = std::filesystem::path(m_filename);
-        auto fileParent = filePath.parent_path();
-
-        // We overlap the loading of texture data off disk with the generation of
-        // mipmaps from the most recently loaded texture.
-        struct TextureTask {
-            std::future<util::LoadedTexture> future;
-            std::shared_ptr<openrl::Texture>* texture = nullptr;
-        };
-
-        TextureTask textureTasks[2];
-        enum TaskID {
-            kStaging = 0, // Texture task has been launched.
-            kLoading      // Texture is loading or possibly fully loaded.
-        };
-        auto checkTextureTasks = [&textureTasks]() {
-            if (textureTasks[kLoading].texture) {
-                util::LoadedTexture loadedTexture = textureTasks[kLoading].future.get();
-                if (loadedTexture.pixels) {
-                    *(textureTasks[kLoading].texture) = openrl::Texture::create(loadedTexture.pixels.get(), loadedTexture.desc, loadedTexture.sampler, true);
-                }
-                textureTasks[kLoading].texture = nullptr;
+    DeduplicateMeshes(scene, firstVertexBuffers);
+
+    float conversionTime = timer.stop();
+
+    size_t vertexBytes = 0;
+    for (const std::pmr::vector<float>& vertexBuffer : m_vertexBuffers) {
+        vertexBytes += vertexBuffer.size() * sizeof(float);
+    }
+    LOG_INFO("Converted %u meshes into %zu %s %s vertex buffers (%.2f MB) on %zu threads in %f seconds", scene->mNumMeshes, m_vertexBuffers.size(),
+             (m_vertexLayout == VertexLayout::kInterleaved) ? "interleaved" : "separate",
+             (m_vertexFormat == VertexFormat::kCompact) ? "compact" : "float", float(vertexBytes) / (1024.0f * 1024.0f),
+             util::parallelWorkerCount(scene->mNumMeshes), conversionTime);
+    if (m_meshOptimization != MeshOptimization::kNone) {
+        LOG_INFO("Reordered the triangles and vertices of every mesh for %s locality",
+                 (m_meshOptimization == MeshOptimization::kSpatial) ? "spatial" : "vertex cache");
+    }
+    LOG_INFO("Mesh arena holds %zu allocations (%.2f MB)", m_arena.allocationCount(), double(m_arena.bytesAllocated()) / (1024.0 * 1024.0));
+}
+
+void AssimpMeshProvider::DeduplicateMeshes(aiScene const * scene, const std::pmr::vector<size_t> & firstVertexBuffers)
+{
+    const size_t meshCount = scene->mNumMeshes;
+    std::pmr::monotonic_buffer_resource scratch; // Freed before the provider is used, see m_arena.
+
+    // Relative layout of a submesh, independent of which buffers it was written to.
+    auto sameLayout = [this, &firstVertexBuffers](size_t a, size_t b) {
+        const Submesh & submeshA = m_submeshes[a];
+        const Submesh & submeshB = m_submeshes[b];
+        if ((submeshA.vertexAttributeCount != submeshB.vertexAttributeCount) || (submeshA.elementCount != submeshB.elementCount) ||
+            (submeshA.indexType != submeshB.indexType) || (submeshA.drawMode != submeshB.drawMode)) {
+            return false;
+        }
+        for (int ii = 0; ii < submeshA.vertexAttributeCount; ++ii) {
+            const VertexAttribute & attributeA = submeshA.vertexAttributes[ii];
+            const VertexAttribute & attributeB = submeshB.vertexAttributes[ii];
+            if ((attributeA.usage != attributeB.usage) || (attributeA.componentCount != attributeB.componentCount) ||
+                (attributeA.size != attributeB.size) || (attributeA.offset != attributeB.offset) || (attributeA.stride != attributeB.stride) ||
+                (size_t(attributeA.buffer) - firstVertexBuffers[a] != size_t(attributeB.buffer) - firstVertexBuffers[b])) {
+                return false;
             }
-        };
+        }
+        return true;
+    };
 
-        aiString assimpPath;
-        if (material->GetTexture(AI_MATKEY_BASE_COLOR_TEXTURE, &assimpPath) == aiReturn_SUCCESS) {
-            auto texturePath = (fileParent / assimpPath.C_Str()).string();
-            textureTasks[kStaging].future = util::loadTextureAsync(texturePath.c_str(), true, true);
-            textureTasks[kStaging].texture = &params.baseColorTexture;
-            std::swap(textureTasks[kStaging], textureTasks[kLoading]);
+    // Hash the geometry of every mesh so that only meshes with matching hashes need to be compared.
+    std::pmr::vector<uint64_t> hashes(meshCount, &scratch);
+    util::parallelFor(meshCount, [&](size_t meshIndex, size_t /*workerIndex*/) {
+        uint64_t hash = util::FNV1a(reinterpret_cast<const char *>(m_indexBuffers[meshIndex].data()), m_indexBuffers[meshIndex].size());
+        for (size_t ii = 0; ii < VertexBufferCount(scene->mMeshes[meshIndex]); ++ii) {
+            const std::pmr::vector<float> & vertexBuffer = m_vertexBuffers[firstVertexBuffers[meshIndex] + ii];
+            hash = util::hashCombine(size_t(hash), util::FNV1a(reinterpret_cast<const char *>(vertexBuffer.data()), vertexBuffer.size() * sizeof(float)));
         }
-        else if (material->GetTextureCount(aiTextureType_DIFFUSE) > 0) {
-            material->GetTexture(aiTextureType_DIFFUSE, 0, &assimpPath);
-            auto texturePath = (fileParent / assimpPath.C_Str()).string();
-            textureTasks[kStaging].future = util::loadTextureAsync(texturePath.c_str(), true, true);
-            textureTasks[kStaging].texture = &params.baseColorTexture;
-            std::swap(textureTasks[kStaging], textureTasks[kLoading]);
+        hashes[meshIndex] = hash;
+    });
+
+    std::pmr::vector<size_t> canonicalMesh(meshCount, &scratch);
+    std::pmr::unordered_map<uint64_t, std::pmr::vector<size_t>> meshesByHash(&scratch);
+    size_t duplicateCount = 0;
+    for (size_t meshIndex = 0; meshIndex < meshCount; ++meshIndex) {
+        canonicalMesh[meshIndex] = meshIndex;
+        std::pmr::vector<size_t> & candidates = meshesByHash[hashes[meshIndex]];
+        const size_t bufferCount = VertexBufferCount(scene->mMeshes[meshIndex]);
+        for (size_t candidate : candidates) {
+            bool identical = sameLayout(candidate, meshIndex) && (m_indexBuffers[candidate] == m_indexBuffers[meshIndex]);
+            for (size_t ii = 0; identical && (ii < bufferCount); ++ii) {
+                identical = (m_vertexBuffers[firstVertexBuffers[candidate] + ii] == m_vertexBuffers[firstVertexBuffers[meshIndex] + ii]);
+            }
+            if (identical) {
+                canonicalMesh[meshIndex] = candidate;
+                break;
+            }
         }
 
-        if (material->GetTextureCount(aiTextureType_NORMALS) > 0) {
-            aiString normalTexturePath;
-            material->GetTexture(aiTextureType_NORMALS, 0, &normalTexturePath);
-            auto texturePath = (fileParent / normalTexturePath.C_Str()).string();
-            textureTasks[kStaging].future = util::loadTextureAsync(texturePath.c_str(), true, false);
-            textureTasks[kStaging].texture = &params.normalmap;
-            checkTextureTasks();
-            std::swap(textureTasks[kStaging], textureTasks[kLoading]);
+        if (canonicalMesh[meshIndex] == meshIndex) {
+            candidates.push_back(meshIndex);
+        } else {
+            ++duplicateCount;
         }
+    }
 
-        if (material->GetTexture(AI_MATKEY_GLTF_PBRMETALLICROUGHNESS_METALLICROUGHNESS_TEXTURE, &assimpPath) == aiReturn_SUCCESS) {
-            auto texturePath = (fileParent / assimpPath.C_Str()).string();
-            textureTasks[kStaging].future = util::loadTextureAsync(texturePath.c_str(), true, false);
-            textureTasks[kStaging].texture = &params.metallicRoughnessTexture;
-            checkTextureTasks();
-            std::swap(textureTasks[kStaging], textureTasks[kLoading]);
+    if (duplicateCount == 0) {
+        return;
+    }
+
+    // Point the duplicates at the buffers of the mesh they match and then drop the buffers nothing refers to anymore.
+    size_t savedBytes = 0;
+    std::pmr::vector<bool> vertexBufferUsed(m_vertexBuffers.size(), true, &scratch);
+    std::pmr::vector<bool> indexBufferUsed(m_indexBuffers.size(), true, &scratch);
+    for (size_t meshIndex = 0; meshIndex < meshCount; ++meshIndex) {
+        const size_t canonical = canonicalMesh[meshIndex];
+        if (canonical == meshIndex) {
+            continue;
         }
 
-        // Ensure the final loaded texture gets uploaded to OpenRL.
-        checkTextureTasks();
+        Submesh & submesh = m_submeshes[meshIndex];
+        for (int ii = 0; ii < submesh.vertexAttributeCount; ++ii) {
+            VertexAttribute & attribute = submesh.vertexAttributes[ii];
+            attribute.buffer = int(size_t(attribute.buffer) - firstVertexBuffers[meshIndex] + firstVertexBuffers[canonical]);
+        }
+        for (size_t ii = 0; ii < VertexBufferCount(scene->mMeshes[meshIndex]); ++ii) {
+            vertexBufferUsed[firstVertexBuffers[meshIndex] + ii] = false;
+            savedBytes += m_vertexBuffers[firstVertexBuffers[meshIndex] + ii].size() * sizeof(float);
+        }
+        indexBufferUsed[submesh.indexBuffer] = false;
+        savedBytes += m_indexBuffers[submesh.indexBuffer].size();
+        submesh.indexBuffer = m_submeshes[canonical].indexBuffer;
     }
 
-    m_materials.push_back(glassMaterial);
+    auto compact = [&scratch](auto & buffers, const std::pmr::vector<bool> & used) {
+        std::pmr::vector<size_t> remap(buffers.size(), 0, &scratch);
+        size_t count = 0;
+        for (size_t ii = 0; ii < buffers.size(); ++ii) {
+            if (used[ii]) {
+                remap[ii] = count;
+                if (count != ii) {
+                    buffers[count] = std::move(buffers[ii]);
+                }
+                ++count;
+            }
+        }
+        buffers.resize(count);
+        return remap;
+    };
+    const std::pmr::vector<size_t> vertexBufferRemap = compact(m_vertexBuffers, vertexBufferUsed);
+    const std::pmr::vector<size_t> indexBufferRemap = compact(m_indexBuffers, indexBufferUsed);
+    for (Submesh & submesh : m_submeshes) {
+        for (int ii = 0; ii < submesh.vertexAttributeCount; ++ii) {
+            submesh.vertexAttributes[ii].buffer = int(vertexBufferRemap[submesh.vertexAttributes[ii].buffer]);
+        }
+        submesh.indexBuffer = indexBufferRemap[submesh.indexBuffer];
+    }
+
+    LOG_INFO("Found %zu meshes with identical geometry, sharing their buffers saved %.2f MB", duplicateCount,
+             double(savedBytes) / (1024.0 * 1024.0));
+}
+
+void AssimpMeshProvider::ProcessGlassMaterial(aiMaterial const* material, MaterialRecord& record)
+{
+    record.type = Material::Type::Glass;
+    record.baseColor = { 1.0f, 1.0f, 1.0f };
+    record.density = 0.05f;
+    record.ior = 1.33f;
+    record.roughness = 0.0f;
+
+    material->Get(AI_MATKEY_ROUGHNESS_FACTOR, record.roughness);
+    material->Get(AI_MATKEY_REFRACTI, record.ior);
+
+    aiColor3D color;
+    if (material->Get(AI_MATKEY_BASE_COLOR, color) == aiReturn_SUCCESS) {
+        record.baseColor = glm::vec3(color.r, color.g, color.b);
+    }
+
+    // Textures.
+    aiString assimpPath;
+    if (material->GetTexture(AI_MATKEY_BASE_COLOR_TEXTURE, &assimpPath) == aiReturn_SUCCESS) {
+        record.textures.push_back({ MaterialRecord::TextureSlot::kBaseColor, assimpPath.C_Str(), true });
+    } else if (material->GetTextureCount(aiTextureType_DIFFUSE) > 0) {
+        material->GetTexture(aiTextureType_DIFFUSE, 0, &assimpPath);
+        record.textures.push_back({ MaterialRecord::TextureSlot::kBaseColor, assimpPath.C_Str(), true });
+    }
+    if (material->GetTextureCount(aiTextureType_NORMALS) > 0) {
+        material->GetTexture(aiTextureType_NORMALS, 0, &assimpPath);
+        record.textures.push_back({ MaterialRecord::TextureSlot::kNormalmap, assimpPath.C_Str(), false });
+    }
+    if (material->GetTexture(AI_MATKEY_GLTF_PBRMETALLICROUGHNESS_METALLICROUGHNESS_TEXTURE, &assimpPath) == aiReturn_SUCCESS) {
+        record.textures.push_back({ MaterialRecord::TextureSlot::kMetallicRoughness, assimpPath.C_Str(), false });
+    }
 }
 
 void AssimpMeshProvider::ProcessMaterial(aiMaterial const * material)
 {
+    MaterialRecord& record = m_materialRecords.emplace_back();
+    record.name = material->GetName().C_Str();
+
     // Check to see if we should be processing this material as glass.
     {
         aiString mode;
@@ -383,149 +635,84 @@ void AssimpMeshProvider::ProcessMaterial(aiMaterial const * material)
         if ((strcmp(mode.C_Str(), "BLEND") == 0) ||
             (transmissionFactor != 0.0f)) {
             // This is a transparent material.
-            ProcessGlassMaterial(material);
+            ProcessGlassMaterial(material, record);
             return;
         }
     }
 
-    std::string name = material->GetName().C_Str();
-    std::shared_ptr<PhysicallyBasedMaterial> pbrMaterial = std::make_shared<PhysicallyBasedMaterial>(name);
-    PhysicallyBasedMaterial::Parameters& params = pbrMaterial->parameters();
-
-    params.metallic = 0.0f;
-    params.roughness = 1.0f;
-    params.baseColor = { 1.0f, 1.0f, 1.0f };
-    params.specularF0 = 0.5f;
+    record.type = Material::Type::PBR;
+    record.metallic = 0.0f;
+    record.roughness = 1.0f;
+    record.baseColor = { 1.0f, 1.0f, 1.0f };
+    record.specularF0 = 0.5f;
 
     // Check to see if this material wants to perform alpha masking.
     {
         aiString mode;
         material->Get(AI_MATKEY_GLTF_ALPHAMODE, mode);
         if (strcmp(mode.C_Str(), "MASK") == 0) {
-            params.alphaMask = true;
+            record.alphaMask = true;
         }
     }
 
     aiColor3D color;
     if (material->Get(AI_MATKEY_BASE_COLOR, color) == aiReturn_SUCCESS) {
-        params.baseColor = glm::vec3(color.r, color.g, color.b);
+        record.baseColor = glm::vec3(color.r, color.g, color.b);
     } else if (material->Get(AI_MATKEY_COLOR_DIFFUSE, color) == aiReturn_SUCCESS) {
-        params.baseColor = glm::vec3(color.r, color.g, color.b);
+        record.baseColor = glm::vec3(color.r, color.g, color.b);
     } else if (material->Get(AI_MATKEY_COLOR_SPECULAR, color) == aiReturn_SUCCESS) {
-        params.baseColor = glm::vec3(color.r, color.g, color.b);
+        record.baseColor = glm::vec3(color.r, color.g, color.b);
     }
 
-    material->Get(AI_MATKEY_METALLIC_FACTOR, params.metallic);
-    material->Get(AI_MATKEY_ROUGHNESS_FACTOR, params.roughness);
-    material->Get(AI_MATKEY_CLEARCOAT_FACTOR, params.clearCoat);
-    material->Get(AI_MATKEY_CLEARCOAT_ROUGHNESS_FACTOR, params.clearCoatRoughness);
+    material->Get(AI_MATKEY_METALLIC_FACTOR, record.metallic);
+    material->Get(AI_MATKEY_ROUGHNESS_FACTOR, record.roughness);
+    material->Get(AI_MATKEY_CLEARCOAT_FACTOR, record.clearCoat);
+    material->Get(AI_MATKEY_CLEARCOAT_ROUGHNESS_FACTOR, record.clearCoatRoughness);
     if (material->Get(AI_MATKEY_COLOR_EMISSIVE, color) == aiReturn_SUCCESS) {
-        params.emissiveColor = glm::vec3(color.r, color.g, color.b);
+        record.emissiveColor = glm::vec3(color.r, color.g, color.b);
     }
-    material->Get(AI_MATKEY_TWOSIDED, params.doubleSided);
+    material->Get(AI_MATKEY_TWOSIDED, record.doubleSided);
 
     {
         float ior = 0.0f;
         if (material->Get(AI_MATKEY_REFRACTI, ior) == aiReturn_SUCCESS) {
-            params.specularF0 = std::powf((1.0f - ior) / (1.0f + ior), 2.0f);
+            record.specularF0 = std::pow((1.0f - ior) / (1.0f + ior), 2.0f);
         } else {
-            material->Get(AI_MATKEY_SPECULAR_FACTOR, params.specularF0);
+            material->Get(AI_MATKEY_SPECULAR_FACTOR, record.specularF0);
         }
     }
 
-    auto filePath = std::filesystem::path(m_filename);
-    auto fileParent = filePath.parent_path();
-
-    // We overlap the loading of texture data off disk with the generation of
-    // mipmaps from the most recently loaded texture.
-    struct TextureTask {
-        std::future<util::LoadedTexture> future;
-        std::shared_ptr<openrl::Texture> *texture = nullptr;
-    };
-
-    TextureTask textureTasks[2];
-    enum TaskID { 
-        kStaging = 0, // Texture task has been launched.
-        kLoading      // Texture is loading or possibly fully loaded.
-    };
-    auto checkTextureTasks = [&textureTasks]() {
-        if (textureTasks[kLoading].texture) {
-            util::LoadedTexture loadedTexture = textureTasks[kLoading].future.get();
-            if (loadedTexture.pixels) {
-                *(textureTasks[kLoading].texture) = openrl::Texture::create(loadedTexture.pixels.get(), loadedTexture.desc, loadedTexture.sampler, true);
-            }
-            textureTasks[kLoading].texture = nullptr;
-        }
-    };
-
+    // Textures.
     aiString fileTexturePath;
     if (material->GetTexture(AI_MATKEY_BASE_COLOR_TEXTURE, &fileTexturePath) == aiReturn_SUCCESS) {
-        auto texturePath = (fileParent / fileTexturePath.C_Str()).string();
-        textureTasks[kStaging].future = util::loadTextureAsync(texturePath.c_str(), true, true);
-        textureTasks[kStaging].texture = &params.baseColorTexture;
-        std::swap(textureTasks[kStaging], textureTasks[kLoading]);
+        record.textures.push_back({ MaterialRecord::TextureSlot::kBaseColor, fileTexturePath.C_Str(), true });
     } else if (material->GetTextureCount(aiTextureType_DIFFUSE) > 0) {
         material->GetTexture(aiTextureType_DIFFUSE, 0, &fileTexturePath);
-        auto texturePath = (fileParent / fileTexturePath.C_Str()).string();
-        textureTasks[kStaging].future = util::loadTextureAsync(texturePath.c_str(), true, true);
-        textureTasks[kStaging].texture = &params.baseColorTexture;
-        std::swap(textureTasks[kStaging], textureTasks[kLoading]);
+        record.textures.push_back({ MaterialRecord::TextureSlot::kBaseColor, fileTexturePath.C_Str(), true });
     }
     if (material->GetTextureCount(aiTextureType_EMISSIVE) > 0) {
-        aiString emissiveTexturePath;
-        material->GetTexture(aiTextureType_EMISSIVE, 0, &emissiveTexturePath);
-        auto texturePath = (fileParent / emissiveTexturePath.C_Str()).string();
-        textureTasks[kStaging].future = util::loadTextureAsync(texturePath.c_str(), true, true);
-        textureTasks[kStaging].texture = &params.emissiveTexture;
-        checkTextureTasks();
-        std::swap(textureTasks[kStaging], textureTasks[kLoading]);
-    }
-    aiString fileRoughnessMetallicTexture;
-    if (material->GetTexture(AI_MATKEY_GLTF_PBRMETALLICROUGHNESS_METALLICROUGHNESS_TEXTURE, &fileRoughnessMetallicTexture) == aiReturn_SUCCESS) {
-        auto texturePath = (fileParent / fileRoughnessMetallicTexture.C_Str()).string();
-        textureTasks[kStaging].future = util::loadTextureAsync(texturePath.c_str(), true, false);
-        textureTasks[kStaging].texture = &params.metallicRoughnessTexture;
-        checkTextureTasks();
-        std::swap(textureTasks[kStaging], textureTasks[kLoading]);
+        material->GetTexture(aiTextureType_EMISSIVE, 0, &fileTexturePath);
+        record.textures.push_back({ MaterialRecord::TextureSlot::kEmissive, fileTexturePath.C_Str(), true });
+    }
+    if (material->GetTexture(AI_MATKEY_GLTF_PBRMETALLICROUGHNESS_METALLICROUGHNESS_TEXTURE, &fileTexturePath) == aiReturn_SUCCESS) {
+        record.textures.push_back({ MaterialRecord::TextureSlot::kMetallicRoughness, fileTexturePath.C_Str(), false });
     }
     if (material->GetTextureCount(aiTextureType_NORMALS) > 0) {
-        aiString normalTexturePath;
-        material->GetTexture(aiTextureType_NORMALS, 0, &normalTexturePath);
-        auto texturePath = (fileParent / normalTexturePath.C_Str()).string();
-        textureTasks[kStaging].future = util::loadTextureAsync(texturePath.c_str(), true, false);
-        textureTasks[kStaging].texture = &params.normalmap;
-        checkTextureTasks();
-        std::swap(textureTasks[kStaging], textureTasks[kLoading]);
+        material->GetTexture(aiTextureType_NORMALS, 0, &fileTexturePath);
+        record.textures.push_back({ MaterialRecord::TextureSlot::kNormalmap, fileTexturePath.C_Str(), false });
     }
     if (material->GetTexture(AI_MATKEY_CLEARCOAT_TEXTURE, &fileTexturePath) == aiReturn_SUCCESS) {
-        auto texturePath = (fileParent / fileTexturePath.C_Str()).string();
-        textureTasks[kStaging].future = util::loadTextureAsync(texturePath.c_str(), true, false);
-        textureTasks[kStaging].texture = &params.clearCoatTexture;
-        checkTextureTasks();
-        std::swap(textureTasks[kStaging], textureTasks[kLoading]);
+        record.textures.push_back({ MaterialRecord::TextureSlot::kClearCoat, fileTexturePath.C_Str(), false });
     }
     if (material->GetTexture(AI_MATKEY_CLEARCOAT_ROUGHNESS_TEXTURE, &fileTexturePath) == aiReturn_SUCCESS) {
-        auto texturePath = (fileParent / fileTexturePath.C_Str()).string();
-        textureTasks[kStaging].future = util::loadTextureAsync(texturePath.c_str(), true, false);
-        textureTasks[kStaging].texture = &params.clearCoatRoughnessTexture;
-        checkTextureTasks();
-        std::swap(textureTasks[kStaging], textureTasks[kLoading]);
+        record.textures.push_back({ MaterialRecord::TextureSlot::kClearCoatRoughness, fileTexturePath.C_Str(), false });
     }
     if (material->GetTexture(AI_MATKEY_CLEARCOAT_NORMAL_TEXTURE, &fileTexturePath) == aiReturn_SUCCESS) {
-        auto texturePath = (fileParent / fileTexturePath.C_Str()).string();
-        textureTasks[kStaging].future = util::loadTextureAsync(texturePath.c_str(), true, false);
-        textureTasks[kStaging].texture = &params.clearCoatNormalmap;
-        checkTextureTasks();
-        std::swap(textureTasks[kStaging], textureTasks[kLoading]);
+        record.textures.push_back({ MaterialRecord::TextureSlot::kClearCoatNormalmap, fileTexturePath.C_Str(), false });
     }
-
-    // Ensure the final loaded texture gets uploaded to OpenRL.
-    checkTextureTasks();
-
-    m_materials.push_back(pbrMaterial);
 }
 
-void AssimpMeshProvider::ProcessLight(aiLight const* light, std::shared_ptr<Lighting> lighting, const aiScene* scene)
+void AssimpMeshProvider::ProcessLight(aiLight const* light, const aiScene* scene)
 {
     // Build the transform for this light following the scene all the way back to the root.
     // In Assimp, the only way to get a scene node for a given light is to search for the node by the name
@@ -550,8 +737,10 @@ void AssimpMeshProvider::ProcessLight(aiLight const* light, std::shared_ptr<Ligh
     }
 
     if (light->mType == aiLightSourceType::aiLightSource_POINT) {
-        std::shared_ptr<PointLight> newLight = lighting->addPointLight(light->mName.C_Str());
-        PointLight::Params params;
+        LightRecord& record = m_lightRecords.emplace_back();
+        record.type = Light::Type::kPoint;
+        record.name = light->mName.C_Str();
+        PointLight::Params& params = record.point;
 
         // Light position.
         {
@@ -567,12 +756,11 @@ void AssimpMeshProvider::ProcessLight(aiLight const* light, std::shared_ptr<Ligh
             params.luminousIntensity = glm::length(assimpColor);
             params.color = assimpColor / params.luminousIntensity;
         }
-
-        newLight->setParams(params);
-        lighting->updateLight(newLight);
     } else if (light->mType == aiLightSource_DIRECTIONAL) {
-        std::shared_ptr<DirectionalLight> newLight = lighting->addDirectionalLight(light->mName.C_Str());
-        DirectionalLight::Params params;
+        LightRecord& record = m_lightRecords.emplace_back();
+        record.type = Light::Type::kDirectional;
+        record.name = light->mName.C_Str();
+        DirectionalLight::Params& params = record.directional;
 
         // Orientation.
         {
@@ -605,12 +793,11 @@ void AssimpMeshProvider::ProcessLight(aiLight const* light, std::shared_ptr<Ligh
             params.illuminance = glm::length(assimpColor);
             params.color = assimpColor / params.illuminance;
         }
-
-        newLight->setParams(params);
-        lighting->updateLight(newLight);
     } else if (light->mType == aiLightSource_SPOT) {
-        std::shared_ptr<SpotLight> newLight = lighting->addSpotLight(light->mName.C_Str());
-        SpotLight::Params params;
+        LightRecord& record = m_lightRecords.emplace_back();
+        record.type = Light::Type::kSpot;
+        record.name = light->mName.C_Str();
+        SpotLight::Params& params = record.spot;
 
         // Light position.
         {
@@ -655,13 +842,24 @@ void AssimpMeshProvider::ProcessLight(aiLight const* light, std::shared_ptr<Ligh
             params.innerAngle = light->mAngleInnerCone;
             params.outerAngle = light->mAngleOuterCone;
         }
-
-        newLight->setParams(params);
-        lighting->updateLight(newLight);
     }
 }
 
-void AssimpMeshProvider::LoadScene(const std::string_view filename, std::shared_ptr<Lighting> lighting)
+unsigned int AssimpMeshProvider::postProcessFlags()
+{
+    return aiProcess_JoinIdenticalVertices |
+           aiProcess_FixInfacingNormals    |
+           aiProcess_GenUVCoords           |
+           aiProcess_OptimizeMeshes        |
+           aiProcess_CalcTangentSpace      |
+           aiProcess_GenBoundingBoxes      |
+           aiProcess_Triangulate           |
+           aiProcess_GenSmoothNormals      |
+           aiProcess_TransformUVCoords     |
+           aiProcess_GlobalScale;
+}
+
+void AssimpMeshProvider::LoadScene(const std::string_view filename)
 {
     static bool assimpLoggerInitialized = false;
 
@@ -673,25 +871,23 @@ void AssimpMeshProvider::LoadScene(const std::string_view filename, std::shared_
     AssimpLogToCoutStream stream;
     Assimp::DefaultLogger::get()->attachStream(&stream, 0xFF);
 
+    // Outlives the importer, which owns the IO system recording into it.
+    std::vector<std::string> openedFiles;
     Assimp::Importer importer;
-    unsigned int postProcessFlags =
-    aiProcess_JoinIdenticalVertices |
-    aiProcess_FixInfacingNormals    |
-    aiProcess_GenUVCoords           |
-    aiProcess_OptimizeMeshes        |
-    aiProcess_CalcTangentSpace      |
-    aiProcess_GenBoundingBoxes      |
-    aiProcess_Triangulate           |
-    aiProcess_GenSmoothNormals      |
-    aiProcess_TransformUVCoords     |
-    aiProcess_GlobalScale;
 
     // Tell Assimp to apply the proper scene scale based on what the user has requested.
     // NOTE: it's assumed that if the user wants to convert to meters (the Heatray default)
     // then the model is originally in centimeters.
     importer.SetPropertyFloat(AI_CONFIG_GLOBAL_SCALE_FACTOR_KEY, m_convertToMeters ? 0.01f : 1.0f);
 
-    const aiScene * scene = importer.ReadFile(filename.data(), postProcessFlags);
+    importer.SetIOHandler(new RecordingIOSystem(openedFiles));
+
+    const aiScene * scene = importer.ReadFile(filename.data(), postProcessFlags());
+    for (const std::string& file : openedFiles) {
+        if ((file != filename) && (std::find(m_importedFiles.begin(), m_importedFiles.end(), file) == m_importedFiles.end())) {
+            m_importedFiles.push_back(file);
+        }
+    }
     LOG_INFO("Scene imported by assimp!");
 
     if (scene) {
@@ -701,21 +897,20 @@ void AssimpMeshProvider::LoadScene(const std::string_view filename, std::shared_
             ProcessMaterial(material);
         }
 
-        for (unsigned int ii = 0; ii < scene->mNumMeshes; ++ii) {
-            aiMesh const * mesh = scene->mMeshes[ii];
-            LOG_INFO("Processing mesh %s", mesh->mName.C_Str());
-            ProcessMesh(mesh);
-        }
+        ProcessMeshes(scene);
 
         for (unsigned int ii = 0; ii < scene->mNumLights; ++ii) {
             aiLight const * light = scene->mLights[ii];
             LOG_INFO("Processing light %s", light->mName.C_Str());
-            ProcessLight(light, lighting, scene);
+            ProcessLight(light, scene);
         }
 
         aiMatrix4x4 identity;
         LOG_INFO("Processing scene transforms...");
-        ProcessNode(scene, scene->mRootNode, identity, 0);
+        std::pmr::monotonic_buffer_resource scratch;
+        std::pmr::vector<std::pmr::vector<glm::mat4x4>> meshTransforms(scene->mNumMeshes, &scratch);
+        ProcessNode(scene, scene->mRootNode, identity, 0, meshTransforms);
+        ProcessInstances(meshTransforms);
         LOG_INFO("\tDONE");
     } else {
         LOG_ERROR("Error: No scene found in asset.\n");
@@ -1,9 +1,10 @@
 #pragma once
 
 #include "MeshProvider.h"
+#include "SceneRecords.h"
 
-#include <HeatrayRenderer/Materials/Material.h>
 #include <Utility/AABB.h>
+#include <Utility/Arena.h>
 
 #include "assimp/DefaultLogger.hpp"
 #include "assimp/Importer.hpp"
@@ -12,18 +13,16 @@
 #include "assimp/postprocess.h"
 #include "glm/glm/glm.hpp"
 
-#include <memory>
+#include <memory_resource>
 #include <string>
 #include <string_view>
 #include <vector>
 
-// Forward includes.
-class Lighting;
-
 class AssimpMeshProvider : public MeshProvider
 {
 public:
-    explicit AssimpMeshProvider(const std::string_view filename, bool convertToMeters, std::shared_ptr<Lighting> lighting);
+    explicit AssimpMeshProvider(const std::string_view filename, bool convertToMeters, VertexLayout vertexLayout = VertexLayout::kInterleaved,
+                                VertexFormat vertexFormat = VertexFormat::kFloat, MeshOptimization meshOptimization = MeshOptimization::kNone);
     virtual ~AssimpMeshProvider() = default;
 
     size_t GetVertexBufferCount() override
@@ -48,7 +47,7 @@ public:
 
     size_t GetIndexBufferSize(size_t bufferIndex) override
     {
-        return m_indexBuffers[bufferIndex].size() * sizeof(int);
+        return m_indexBuffers[bufferIndex].size();
     }
 
     void FillIndexBuffer(size_t bufferIndex, uint8_t *buffer) override
@@ -66,32 +65,65 @@ public:
         return m_submeshes[submeshIndex];
     }
 
-    std::vector<std::shared_ptr<Material>> & GetMaterials()
-    {
-        return m_materials;
-    }
-
+    const std::vector<MaterialRecord>& materialRecords() const { return m_materialRecords; }
+    const std::vector<LightRecord>& lightRecords() const { return m_lightRecords; }
     const util::AABB& sceneAABB() const { return m_sceneAABB; }
 
+    //-------------------------------------------------------------------------
+    // The files other than the asset itself that Assimp read during the
+    // import, e.g. the .bin of a glTF or the .mtl of an OBJ.
+    const std::vector<std::string>& importedFiles() const { return m_importedFiles; }
+
+    //-------------------------------------------------------------------------
+    // Assimp post-processing steps applied to every imported scene. Anything
+    // derived from the imported data must be invalidated if these change.
+    static unsigned int postProcessFlags();
+
 private:
-    void LoadScene(const std::string_view filename, std::shared_ptr<Lighting> lighting);
-    void ProcessMesh(aiMesh const * mesh);
-    void ProcessGlassMaterial(aiMaterial const* material);
+    void LoadScene(const std::string_view filename);
+    size_t VertexComponentCount(aiMesh const * mesh) const;
+    size_t VertexBufferCount(aiMesh const * mesh) const;
+    void ProcessMeshes(aiScene const * scene);
+    void ProcessMesh(aiMesh const * mesh, size_t meshIndex, size_t firstVertexBuffer);
+    void DeduplicateMeshes(aiScene const * scene, const std::pmr::vector<size_t> & firstVertexBuffers);
+    void ProcessGlassMaterial(aiMaterial const* material, MaterialRecord& record);
     void ProcessMaterial(aiMaterial const * material);
-    void ProcessLight(aiLight const * light, std::shared_ptr<Lighting> lighting, const aiScene* scene);
-    void ProcessNode(aiScene const * scene, const aiNode * node, const aiMatrix4x4 & parentTransform, int level);
+    void ProcessLight(aiLight const * light, const aiScene* scene);
+    void ProcessNode(aiScene const * scene, const aiNode * node, const aiMatrix4x4 & parentTransform, int level,
+                     std::pmr::vector<std::pmr::vector<glm::mat4x4>> & meshTransforms);
+    void ProcessInstances(const std::pmr::vector<std::pmr::vector<glm::mat4x4>> & meshTransforms);
 
     std::string m_filename;
 
-    std::vector<std::vector<float>> m_vertexBuffers;
+    std::vector<std::string> m_importedFiles;
 
-    std::vector<std::vector<int>> m_indexBuffers;
+    // Backs the vertex and index buffers, which are all released together with the provider. Assimp
+    // imports the whole scene at once so this provider is a single chunk, large Assimp assets are
+    // loaded a chunk at a time once they have been written to the scene cache.
+    // Data that is only needed during one step of the conversion (the optimizer tables of a mesh,
+    // the deduplication and node bookkeeping) comes from a std::pmr::monotonic_buffer_resource local
+    // to that step instead. The arena never frees anything before the provider is destroyed, so it
+    // would keep the tables of every mesh next to the buffers, and the local resources don't take the
+    // lock of the arena for every allocation made by the parallelFor() workers.
+    util::Arena m_arena;
+
+    std::pmr::vector<std::pmr::vector<float>> m_vertexBuffers{ &m_arena };
+
+    std::pmr::vector<std::pmr::vector<uint8_t>> m_indexBuffers{ &m_arena }; // 16 or 32bit indices depending on the submesh IndexType.
 
     std::vector<Submesh> m_submeshes;
 
-    std::vector<std::shared_ptr<Material>> m_materials;
+    std::vector<MaterialRecord> m_materialRecords;
+
+    std::vector<LightRecord> m_lightRecords;
 
     bool m_convertToMeters = false;
 
+    VertexLayout m_vertexLayout = VertexLayout::kInterleaved;
+
+    VertexFormat m_vertexFormat = VertexFormat::kFloat;
+
+    MeshOptimization m_meshOptimization = MeshOptimization::kNone;
+
     util::AABB m_sceneAABB;
 };
@@ -0,0 +1,666 @@
+#include "GltfMeshProvider.h"
+
+#include <Utility/Json.h>
+#include <Utility/Log.h>
+#include <Utility/Timer.h>
+
+#include <glm/glm/glm.hpp>
+#include <glm/glm/gtc/constants.hpp>
+#include <glm/glm/gtc/matrix_transform.hpp>
+#include <glm/glm/gtc/quaternion.hpp>
+#include <glm/glm/gtx/euler_angles.hpp>
+
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <filesystem>
+
+namespace {
+
+constexpr uint32_t kGlbMagic = 0x46546C67;     // 'glTF'.
+constexpr uint32_t kGlbVersion = 2;
+constexpr uint32_t kGlbChunkJson = 0x4E4F534A; // 'JSON'.
+constexpr uint32_t kGlbChunkBinary = 0x004E4942; // 'BIN\0'.
+
+// Accessor component types.
+constexpr int kComponentUnsignedShort = 5123;
+constexpr int kComponentUnsignedInt = 5125;
+constexpr int kComponentFloat = 5126;
+
+// Primitive modes.
+constexpr int kModeTriangles = 4;
+constexpr int kModeTriangleStrip = 5;
+
+// Extensions which only add data that can safely be ignored when they are required.
+constexpr std::string_view kIgnorableExtensions[] = { "KHR_materials_emissive_strength" };
+
+struct GlbHeader {
+    uint32_t magic = 0;
+    uint32_t version = 0;
+    uint32_t length = 0;
+};
+
+struct GlbChunkHeader {
+    uint32_t length = 0;
+    uint32_t type = 0;
+};
+
+//-------------------------------------------------------------------------
+// Element 'index' of 'array' or nullptr if it does not exist.
+const util::JsonValue* element(const util::JsonValue& array, size_t index)
+{
+    return (array.isArray() && (index < array.size())) ? &array[index] : nullptr;
+}
+
+glm::vec3 readVec3(const util::JsonValue& array, const glm::vec3& fallback)
+{
+    if (!array.isArray() || (array.size() < 3)) {
+        return fallback;
+    }
+    return glm::vec3(array[size_t(0)].asFloat(), array[size_t(1)].asFloat(), array[size_t(2)].asFloat());
+}
+
+int componentCount(const std::string& type)
+{
+    if (type == "SCALAR") {
+        return 1;
+    } else if (type == "VEC2") {
+        return 2;
+    } else if (type == "VEC3") {
+        return 3;
+    } else if (type == "VEC4") {
+        return 4;
+    }
+    return 0;
+}
+
+size_t componentSize(int componentType)
+{
+    switch (componentType) {
+        case 5120: // BYTE
+        case 5121: // UNSIGNED_BYTE
+            return 1;
+        case 5122: // SHORT
+        case kComponentUnsignedShort:
+            return 2;
+        case kComponentUnsignedInt:
+        case kComponentFloat:
+            return 4;
+        default:
+            return 0;
+    }
+}
+
+//-------------------------------------------------------------------------
+// URIs in glTF are percent-encoded, e.g. spaces in file names become %20.
+std::string decodeUri(const std::string& uri)
+{
+    std::string decoded;
+    decoded.reserve(uri.size());
+    for (size_t ii = 0; ii < uri.size(); ++ii) {
+        if ((uri[ii] == '%') && (ii + 2 < uri.size()) && isxdigit(uri[ii + 1]) && isxdigit(uri[ii + 2])) {
+            decoded.push_back(char(std::stoi(uri.substr(ii + 1, 2), nullptr, 16)));
+            ii += 2;
+        } else {
+            decoded.push_back(uri[ii]);
+        }
+    }
+    return decoded;
+}
+
+glm::mat4 nodeTransform(const util::JsonValue& node)
+{
+    const util::JsonValue& matrix = node["matrix"];
+    if (matrix.isArray() && (matrix.size() == 16)) {
+        // glTF matrices are column major, just like glm.
+        glm::mat4 transform;
+        for (size_t ii = 0; ii < 16; ++ii) {
+            transform[ii / 4][ii % 4] = matrix[ii].asFloat();
+        }
+        return transform;
+    }
+
+    glm::vec3 translation = readVec3(node["translation"], glm::vec3(0.0f));
+    glm::vec3 scale = readVec3(node["scale"], glm::vec3(1.0f));
+    glm::quat rotation(1.0f, 0.0f, 0.0f, 0.0f);
+    const util::JsonValue& quaternion = node["rotation"];
+    if (quaternion.isArray() && (quaternion.size() == 4)) {
+        // glTF stores quaternions as xyzw.
+        rotation = glm::quat(quaternion[size_t(3)].asFloat(), quaternion[size_t(0)].asFloat(), quaternion[size_t(1)].asFloat(),
+                             quaternion[size_t(2)].asFloat());
+    }
+    return glm::translate(glm::mat4(1.0f), translation) * glm::mat4_cast(rotation) * glm::scale(glm::mat4(1.0f), scale);
+}
+
+//-------------------------------------------------------------------------
+// Spherical angles of a light pointing down its local -Z axis with +Y up,
+// computed the same way as for lights imported with Assimp.
+void lightOrientation(const glm::mat4& transform, float& phi, float& theta)
+{
+    glm::vec4 yAxis = glm::vec4(0.0f, 1.0f, 0.0f, 1.0f);
+    glm::vec4 zAxis = glm::vec4(0.0f, 0.0f, -1.0f, 1.0f);
+    glm::vec4 xAxis = glm::vec4(glm::cross(glm::vec3(yAxis), glm::vec3(zAxis)), 1.0f);
+    glm::mat4x4 localTransform = glm::mat4x4(xAxis, yAxis, zAxis, glm::vec4(0.0f, 0.0f, 0.0f, 1.0f));
+
+    glm::mat4x4 finalTransform = transform * localTransform;
+    float roll = 0.0f;
+    float pitch = 0.0f;
+    float yaw = 0.0f;
+    glm::extractEulerAngleXYZ(finalTransform, pitch, yaw, roll);
+
+    phi = std::clamp(yaw, 0.0f, glm::two_pi<float>());
+    theta = std::clamp(pitch, -glm::half_pi<float>(), glm::half_pi<float>());
+}
+
+} // namespace.
+
+bool GltfMeshProvider::isGltf(const std::string_view path)
+{
+    std::string extension = std::filesystem::path(path).extension().string();
+    std::transform(extension.begin(), extension.end(), extension.begin(), [](unsigned char c) { return char(tolower(c)); });
+    return (extension == ".gltf") || (extension == ".glb");
+}
+
+bool GltfMeshProvider::open(const std::string_view path, bool convertToMeters)
+{
+    util::Timer timer(true);
+
+    util::MappedFile& asset = m_files.emplace_back();
+    if (!asset.open(path)) {
+        LOG_WARNING("Unable to open glTF asset %s", std::string(path).c_str());
+        return false;
+    }
+
+    // A .glb holds the JSON document followed by an optional binary chunk, a .gltf is just the JSON.
+    std::string_view json(reinterpret_cast<const char*>(asset.data()), asset.size());
+    BufferRange binaryChunk;
+    GlbHeader header;
+    if (asset.size() >= sizeof(GlbHeader)) {
+        memcpy(&header, asset.data(), sizeof(GlbHeader));
+    }
+    if (header.magic == kGlbMagic) {
+        if ((header.version != kGlbVersion) || (header.length > asset.size())) {
+            LOG_WARNING("glTF binary %s is not a valid glTF 2.0 file", std::string(path).c_str());
+            return false;
+        }
+
+        json = std::string_view();
+        size_t offset = sizeof(GlbHeader);
+        while (offset + sizeof(GlbChunkHeader) <= header.length) {
+            GlbChunkHeader chunk;
+            memcpy(&chunk, asset.data() + offset, sizeof(GlbChunkHeader));
+            offset += sizeof(GlbChunkHeader);
+            if (chunk.length > header.length - offset) {
+                break;
+            }
+            if ((chunk.type == kGlbChunkJson) && json.empty()) {
+                json = std::string_view(reinterpret_cast<const char*>(asset.data() + offset), chunk.length);
+            } else if ((chunk.type == kGlbChunkBinary) && (binaryChunk.data == nullptr)) {
+                binaryChunk = { asset.data() + offset, chunk.length };
+            }
+            offset += chunk.length;
+        }
+    }
+
+    util::JsonValue document;
+    std::string error;
+    if (!util::JsonValue::parse(json, document, &error)) {
+        LOG_WARNING("Unable to parse glTF asset %s: %s", std::string(path).c_str(), error.c_str());
+        return false;
+    }
+
+    const util::JsonValue& required = document["extensionsRequired"];
+    for (size_t ii = 0; ii < required.size(); ++ii) {
+        const std::string& extension = required[ii].asString();
+        if (std::find(std::begin(kIgnorableExtensions), std::end(kIgnorableExtensions), extension) == std::end(kIgnorableExtensions)) {
+            LOG_INFO("glTF asset %s requires unsupported extension %s", std::string(path).c_str(), extension.c_str());
+            return false;
+        }
+    }
+
+    // Texture transforms are not applied here, so assets that use them at all are left to Assimp.
+    const util::JsonValue& used = document["extensionsUsed"];
+    for (size_t ii = 0; ii < used.size(); ++ii) {
+        if (used[ii].asString() == "KHR_texture_transform") {
+            LOG_INFO("glTF asset %s uses KHR_texture_transform which requires Assimp", std::string(path).c_str());
+            return false;
+        }
+    }
+
+    const std::string assetDirectory = std::filesystem::path(path).parent_path().string();
+    if (!mapBuffers(document, assetDirectory, binaryChunk)) {
+        return false;
+    }
+
+    const util::JsonValue& materials = document["materials"];
+    for (size_t ii = 0; ii < materials.size(); ++ii) {
+        processMaterial(document, materials[ii]);
+    }
+
+    const util::JsonValue& meshes = document["meshes"];
+    std::vector<ProcessedMesh> processedMeshes(meshes.size());
+    for (size_t ii = 0; ii < meshes.size(); ++ii) {
+        if (!processMesh(document, ii, processedMeshes[ii])) {
+            return false;
+        }
+    }
+
+    // NOTE: just like for Assimp it's assumed that if the user wants to convert to meters (the Heatray default)
+    // then the model is originally in centimeters.
+    const glm::mat4 rootTransform = glm::scale(glm::mat4(1.0f), glm::vec3(convertToMeters ? 0.01f : 1.0f));
+
+    const util::JsonValue* scene = element(document["scenes"], document["scene"].asSize(0));
+    if (scene) {
+        const util::JsonValue& nodes = (*scene)["nodes"];
+        for (size_t ii = 0; ii < nodes.size(); ++ii) {
+            processNode(document, nodes[ii].asSize(), rootTransform, processedMeshes, 0);
+        }
+    }
+
+    if (m_submeshes.empty()) {
+        LOG_INFO("glTF asset %s does not contain any supported geometry", std::string(path).c_str());
+        return false;
+    }
+
+    size_t mappedBytes = 0;
+    for (const util::MappedFile& file : m_files) {
+        mappedBytes += file.size();
+    }
+    size_t vertexBytes = 0;
+    for (const BufferRange& buffer : m_vertexBuffers) {
+        vertexBytes += buffer.size;
+    }
+    size_t indexBytes = 0;
+    for (const BufferRange& buffer : m_indexBuffers) {
+        indexBytes += buffer.size;
+    }
+    LOG_INFO("Mapped glTF asset %s (%.2f MB) with %zu submeshes, %.2f MB of vertices and %.2f MB of indices in %f seconds",
+             std::string(path).c_str(), double(mappedBytes) / (1024.0 * 1024.0), m_submeshes.size(),
+             double(vertexBytes) / (1024.0 * 1024.0), double(indexBytes) / (1024.0 * 1024.0), timer.stop());
+    LOG_INFO("Scene AABB (min): %f %f %f", m_sceneAABB.min.x, m_sceneAABB.min.y, m_sceneAABB.min.z);
+    LOG_INFO("Scene AABB (max): %f %f %f", m_sceneAABB.max.x, m_sceneAABB.max.y, m_sceneAABB.max.z);
+
+    SplitIntoChunks(util::MappedFile::kStreamChunkSize);
+    return true;
+}
+
+bool GltfMeshProvider::mapBuffers(const util::JsonValue& document, const std::string_view assetDirectory, const BufferRange& binaryChunk)
+{
+    const util::JsonValue& buffers = document["buffers"];
+    for (size_t ii = 0; ii < buffers.size(); ++ii) {
+        const util::JsonValue& buffer = buffers[ii];
+        const size_t byteLength = buffer["byteLength"].asSize();
+
+        BufferRange range;
+        if (!buffer.contains("uri")) {
+            // Only the first buffer of a .glb may refer to the binary chunk.
+            if ((ii != 0) || (binaryChunk.data == nullptr)) {
+                LOG_WARNING("glTF buffer %zu has no data", ii);
+                return false;
+            }
+            range = binaryChunk;
+        } else {
+            const std::string& uri = buffer["uri"].asString();
+            if (uri.rfind("data:", 0) == 0) {
+                LOG_INFO("glTF buffer %zu is embedded as base64 which requires Assimp", ii);
+                return false;
+            }
+
+            const std::string bufferPath = (std::filesystem::path(assetDirectory) / decodeUri(uri)).string();
+            util::MappedFile& file = m_files.emplace_back();
+            if (!file.open(bufferPath)) {
+                LOG_WARNING("Unable to open glTF buffer %s", bufferPath.c_str());
+                return false;
+            }
+            range = { file.data(), file.size() };
+        }
+
+        if (byteLength > range.size) {
+            LOG_WARNING("glTF buffer %zu is truncated", ii);
+            return false;
+        }
+        range.size = byteLength;
+        m_buffers.push_back(range);
+    }
+    return true;
+}
+
+bool GltfMeshProvider::resolveAccessor(const util::JsonValue& document, size_t accessorIndex, AccessorView& view) const
+{
+    const util::JsonValue* accessor = element(document["accessors"], accessorIndex);
+    if (!accessor || !accessor->contains("bufferView") || accessor->contains("sparse")) {
+        // Accessors without a buffer view are all zeros, sparse ones need to be expanded. Both require a copy.
+        return false;
+    }
+
+    view.bufferView = (*accessor)["bufferView"].asSize();
+    view.offset = (*accessor)["byteOffset"].asSize(0);
+    view.count = (*accessor)["count"].asSize(0);
+    view.componentType = (*accessor)["componentType"].asInt(0);
+    view.componentCount = componentCount((*accessor)["type"].asString());
+
+    const util::JsonValue* bufferView = element(document["bufferViews"], view.bufferView);
+    const size_t elementSize = componentSize(view.componentType) * size_t(view.componentCount);
+    if (!bufferView || (elementSize == 0) || (view.count == 0)) {
+        return false;
+    }
+
+    const size_t buffer = (*bufferView)["buffer"].asSize();
+    const size_t viewOffset = (*bufferView)["byteOffset"].asSize(0);
+    const size_t viewLength = (*bufferView)["byteLength"].asSize(0);
+    view.stride = (*bufferView)["byteStride"].asInt(0);
+    if (view.stride == 0) {
+        view.stride = int(elementSize);
+    }
+
+    return (buffer < m_buffers.size()) && (viewOffset <= m_buffers[buffer].size) && (viewLength <= m_buffers[buffer].size - viewOffset) &&
+           (view.offset + size_t(view.stride) * (view.count - 1) + elementSize <= viewLength);
+}
+
+size_t GltfMeshProvider::vertexBufferForView(const util::JsonValue& document, size_t bufferView)
+{
+    auto [entry, inserted] = m_vertexBufferViews.emplace(bufferView, m_vertexBuffers.size());
+    if (inserted) {
+        // Views have been validated by resolveAccessor().
+        const util::JsonValue& view = document["bufferViews"][bufferView];
+        const BufferRange& buffer = m_buffers[view["buffer"].asSize()];
+        m_vertexBuffers.push_back({ buffer.data + view["byteOffset"].asSize(0), view["byteLength"].asSize() });
+    }
+    return entry->second;
+}
+
+size_t GltfMeshProvider::indexBufferForView(const util::JsonValue& document, size_t bufferView)
+{
+    auto [entry, inserted] = m_indexBufferViews.emplace(bufferView, m_indexBuffers.size());
+    if (inserted) {
+        const util::JsonValue& view = document["bufferViews"][bufferView];
+        const BufferRange& buffer = m_buffers[view["buffer"].asSize()];
+        m_indexBuffers.push_back({ buffer.data + view["byteOffset"].asSize(0), view["byteLength"].asSize() });
+    }
+    return entry->second;
+}
+
+bool GltfMeshProvider::processMesh(const util::JsonValue& document, size_t meshIndex, ProcessedMesh& mesh)
+{
+    struct AttributeSemantic {
+        const char* name;
+        VertexAttributeUsage usage;
+        int minComponents;
+        int componentCount; // As exposed to the shaders.
+    };
+    static constexpr AttributeSemantic kSemantics[] = {
+        { "POSITION",   VertexAttributeUsage_Position, 3, 3 },
+        { "NORMAL",     VertexAttributeUsage_Normal,   3, 3 },
+        { "TEXCOORD_0", VertexAttributeUsage_TexCoord, 2, 2 },
+        { "TANGENT",    VertexAttributeUsage_Tangents, 4, 4 }, // w holds the handedness of the bitangent.
+        { "COLOR_0",    VertexAttributeUsage_Colors,   3, 3 },
+    };
+
+    const util::JsonValue& gltfMesh = document["meshes"][meshIndex];
+    const util::JsonValue& primitives = gltfMesh["primitives"];
+    const std::string meshName = gltfMesh["name"].isString() ? gltfMesh["name"].asString() : ("Mesh " + std::to_string(meshIndex));
+
+    for (size_t ii = 0; ii < primitives.size(); ++ii) {
+        const util::JsonValue& primitive = primitives[ii];
+        const util::JsonValue& attributes = primitive["attributes"];
+
+        const int mode = primitive["mode"].asInt(kModeTriangles);
+        if ((mode != kModeTriangles) && (mode != kModeTriangleStrip)) {
+            LOG_WARNING("Skipping primitive %zu of %s with unsupported mode %d", ii, meshName.c_str(), mode);
+            continue;
+        }
+        if (!attributes.contains("POSITION") || !attributes.contains("NORMAL") || !primitive.contains("indices")) {
+            LOG_INFO("Primitive %zu of %s needs generated normals or indices which requires Assimp", ii, meshName.c_str());
+            return false;
+        }
+
+        Submesh submesh;
+        submesh.name = meshName + "_" + std::to_string(ii);
+        submesh.drawMode = (mode == kModeTriangles) ? DrawMode::Triangles : DrawMode::TriangleStrip;
+
+        if (primitive.contains("material")) {
+            submesh.materialIndex = primitive["material"].asInt();
+        } else {
+            if (m_defaultMaterial == -1) {
+                m_defaultMaterial = int(m_materialRecords.size());
+                m_materialRecords.emplace_back().name = "Default";
+                m_materialNeedsTangents.push_back(false);
+            }
+            submesh.materialIndex = m_defaultMaterial;
+        }
+        if ((submesh.materialIndex < 0) || (size_t(submesh.materialIndex) >= m_materialRecords.size())) {
+            LOG_WARNING("Primitive %zu of %s refers to a missing material", ii, meshName.c_str());
+            return false;
+        }
+        if (m_materialNeedsTangents[submesh.materialIndex] && !attributes.contains("TANGENT")) {
+            LOG_INFO("Primitive %zu of %s needs generated tangents which requires Assimp", ii, meshName.c_str());
+            return false;
+        }
+
+        for (const AttributeSemantic& semantic : kSemantics) {
+            const util::JsonValue* accessorIndex = attributes.find(semantic.name);
+            if (!accessorIndex) {
+                continue;
+            }
+
+            AccessorView view;
+            if (!resolveAccessor(document, accessorIndex->asSize(), view) || (view.componentType != kComponentFloat) ||
+                (view.componentCount < semantic.minComponents) || ((view.stride % sizeof(float)) != 0)) {
+                LOG_INFO("%s of primitive %zu of %s is not stored as floats which requires Assimp", semantic.name, ii, meshName.c_str());
+                return false;
+            }
+
+            VertexAttribute& attribute = submesh.vertexAttributes[submesh.vertexAttributeCount++];
+            attribute.usage = semantic.usage;
+            attribute.componentCount = semantic.componentCount;
+            attribute.size = sizeof(float);
+            attribute.buffer = int(vertexBufferForView(document, view.bufferView));
+            attribute.offset = view.offset;
+            attribute.stride = view.stride;
+
+            if (semantic.usage == VertexAttributeUsage_Position) {
+                // Position accessors are required to have bounds.
+                const util::JsonValue& accessor = document["accessors"][accessorIndex->asSize()];
+                mesh.bounds.expand(readVec3(accessor["min"], glm::vec3(0.0f)));
+                mesh.bounds.expand(readVec3(accessor["max"], glm::vec3(0.0f)));
+            }
+            if (semantic.usage == VertexAttributeUsage_TexCoord) {
+                // Textures are loaded flipped vertically and Assimp flips V of glTF texture coordinates to match.
+                // The coordinates are used straight from the buffer here, so the shader flips them instead.
+                submesh.texCoordTransform = glm::vec4(1.0f, -1.0f, 0.0f, 1.0f);
+            }
+            if (semantic.usage == VertexAttributeUsage_Colors) {
+                m_materialRecords[submesh.materialIndex].vertexColors = true;
+            }
+        }
+
+        AccessorView indices;
+        if (!resolveAccessor(document, primitive["indices"].asSize(), indices) || (indices.componentCount != 1) ||
+            ((indices.componentType != kComponentUnsignedShort) && (indices.componentType != kComponentUnsignedInt)) ||
+            (size_t(indices.stride) != componentSize(indices.componentType))) {
+            LOG_INFO("Indices of primitive %zu of %s are not 16 or 32bit which requires Assimp", ii, meshName.c_str());
+            return false;
+        }
+        submesh.indexBuffer = indexBufferForView(document, indices.bufferView);
+        submesh.indexOffset = indices.offset;
+        submesh.elementCount = indices.count;
+        submesh.indexType = (indices.componentType == kComponentUnsignedShort) ? IndexType::kUInt16 : IndexType::kUInt32;
+
+        mesh.submeshes.push_back(std::move(submesh));
+    }
+    return true;
+}
+
+std::string GltfMeshProvider::textureUri(const util::JsonValue& document, const util::JsonValue& textureInfo) const
+{
+    const util::JsonValue* texture = element(document["textures"], textureInfo["index"].asSize(SIZE_MAX));
+    const util::JsonValue* image = texture ? element(document["images"], (*texture)["source"].asSize(SIZE_MAX)) : nullptr;
+    if (!image) {
+        return std::string();
+    }
+    if (!image->contains("uri") || ((*image)["uri"].asString().rfind("data:", 0) == 0)) {
+        LOG_WARNING("Embedded glTF images are not supported - skipping texture");
+        return std::string();
+    }
+    return decodeUri((*image)["uri"].asString());
+}
+
+void GltfMeshProvider::processMaterial(const util::JsonValue& document, const util::JsonValue& material)
+{
+    MaterialRecord& record = m_materialRecords.emplace_back();
+    record.name = material["name"].asString();
+
+    const util::JsonValue& pbr = material["pbrMetallicRoughness"];
+    const util::JsonValue& extensions = material["extensions"];
+
+    auto addTexture = [&](const util::JsonValue& textureInfo, MaterialRecord::TextureSlot slot, bool convertToLinear) {
+        if (textureInfo.isObject()) {
+            std::string uri = textureUri(document, textureInfo);
+            if (!uri.empty()) {
+                record.textures.push_back({ slot, std::move(uri), convertToLinear });
+            }
+        }
+    };
+
+    const util::JsonValue& baseColorFactor = pbr["baseColorFactor"];
+    record.baseColor = readVec3(baseColorFactor, glm::vec3(1.0f));
+    record.roughness = pbr["roughnessFactor"].asFloat(1.0f);
+
+    const util::JsonValue* ior = extensions.find("KHR_materials_ior");
+    const util::JsonValue* transmission = extensions.find("KHR_materials_transmission");
+    const std::string& alphaMode = material["alphaMode"].asString();
+
+    // The same rules as for Assimp decide which materials are glass.
+    if ((alphaMode == "BLEND") || (transmission && ((*transmission)["transmissionFactor"].asFloat(0.0f) != 0.0f))) {
+        record.type = Material::Type::Glass;
+        record.density = 0.05f;
+        record.ior = ior ? (*ior)["ior"].asFloat(1.5f) : 1.33f;
+
+        addTexture(pbr["baseColorTexture"], MaterialRecord::TextureSlot::kBaseColor, true);
+        addTexture(material["normalTexture"], MaterialRecord::TextureSlot::kNormalmap, false);
+        addTexture(pbr["metallicRoughnessTexture"], MaterialRecord::TextureSlot::kMetallicRoughness, false);
+    } else {
+        record.type = Material::Type::PBR;
+        record.metallic = pbr["metallicFactor"].asFloat(1.0f);
+        record.alphaMask = (alphaMode == "MASK");
+        record.doubleSided = material["doubleSided"].asBool(false);
+
+        float emissiveStrength = 1.0f;
+        if (const util::JsonValue* strength = extensions.find("KHR_materials_emissive_strength")) {
+            emissiveStrength = (*strength)["emissiveStrength"].asFloat(1.0f);
+        }
+        record.emissiveColor = readVec3(material["emissiveFactor"], glm::vec3(0.0f)) * emissiveStrength;
+
+        if (ior) {
+            float value = (*ior)["ior"].asFloat(1.5f);
+            record.specularF0 = std::pow((1.0f - value) / (1.0f + value), 2.0f);
+        } else if (const util::JsonValue* specular = extensions.find("KHR_materials_specular")) {
+            record.specularF0 = (*specular)["specularFactor"].asFloat(record.specularF0);
+        }
+
+        addTexture(pbr["baseColorTexture"], MaterialRecord::TextureSlot::kBaseColor, true);
+        addTexture(material["emissiveTexture"], MaterialRecord::TextureSlot::kEmissive, true);
+        addTexture(pbr["metallicRoughnessTexture"], MaterialRecord::TextureSlot::kMetallicRoughness, false);
+        addTexture(material["normalTexture"], MaterialRecord::TextureSlot::kNormalmap, false);
+
+        if (const util::JsonValue* clearCoat = extensions.find("KHR_materials_clearcoat")) {
+            record.clearCoat = (*clearCoat)["clearcoatFactor"].asFloat(0.0f);
+            record.clearCoatRoughness = (*clearCoat)["clearcoatRoughnessFactor"].asFloat(0.0f);
+            addTexture((*clearCoat)["clearcoatTexture"], MaterialRecord::TextureSlot::kClearCoat, false);
+            addTexture((*clearCoat)["clearcoatRoughnessTexture"], MaterialRecord::TextureSlot::kClearCoatRoughness, false);
+            addTexture((*clearCoat)["clearcoatNormalTexture"], MaterialRecord::TextureSlot::kClearCoatNormalmap, false);
+        }
+    }
+
+    // Normal maps need tangents which are only generated by Assimp.
+    bool needsTangents = false;
+    for (const MaterialRecord::Texture& texture : record.textures) {
+        needsTangents |= (texture.slot == MaterialRecord::TextureSlot::kNormalmap) ||
+                         (texture.slot == MaterialRecord::TextureSlot::kClearCoatNormalmap);
+    }
+    m_materialNeedsTangents.push_back(needsTangents);
+}
+
+void GltfMeshProvider::processNode(const util::JsonValue& document, size_t nodeIndex, const glm::mat4& parentTransform,
+                                   const std::vector<ProcessedMesh>& meshes, int depth)
+{
+    // glTF does not allow cycles but guard against malformed assets anyway.
+    static constexpr int kMaxDepth = 256;
+    const util::JsonValue* node = element(document["nodes"], nodeIndex);
+    if (!node || (depth > kMaxDepth)) {
+        return;
+    }
+
+    const glm::mat4 transform = parentTransform * nodeTransform(*node);
+
+    const size_t meshIndex = (*node)["mesh"].asSize(SIZE_MAX);
+    if (meshIndex < meshes.size()) {
+        const ProcessedMesh& mesh = meshes[meshIndex];
+        for (const Submesh& submesh : mesh.submeshes) {
+            m_submeshes.push_back(submesh);
+            m_submeshes.back().localTransform = transform;
+        }
+
+        // Determine the transformed AABB for this node in order to calculate the final scene AABB.
+        if (!mesh.submeshes.empty()) {
+            for (int corner = 0; corner < 8; ++corner) {
+                glm::vec3 point((corner & 1) ? mesh.bounds.max.x : mesh.bounds.min.x,
+                                (corner & 2) ? mesh.bounds.max.y : mesh.bounds.min.y,
+                                (corner & 4) ? mesh.bounds.max.z : mesh.bounds.min.z);
+                m_sceneAABB.expand(transform * glm::vec4(point, 1.0f));
+            }
+        }
+    }
+
+    const util::JsonValue& lights = document["extensions"]["KHR_lights_punctual"]["lights"];
+    if (const util::JsonValue* light = element(lights, (*node)["extensions"]["KHR_lights_punctual"]["light"].asSize(SIZE_MAX))) {
+        processLight(*light, transform);
+    }
+
+    const util::JsonValue& children = (*node)["children"];
+    for (size_t ii = 0; ii < children.size(); ++ii) {
+        processNode(document, children[ii].asSize(), transform, meshes, depth + 1);
+    }
+}
+
+void GltfMeshProvider::processLight(const util::JsonValue& light, const glm::mat4& transform)
+{
+    const std::string& type = light["type"].asString();
+
+    // Assimp combines the intensity and color together and the lights it imports separate them back out
+    // assuming that the color can not be greater than 1 for any channel. The same is done here so that
+    // both loaders produce identical lights.
+    glm::vec3 combinedColor = readVec3(light["color"], glm::vec3(1.0f)) * light["intensity"].asFloat(1.0f);
+    float intensity = glm::length(combinedColor);
+    glm::vec3 color = (intensity > 0.0f) ? (combinedColor / intensity) : glm::vec3(1.0f);
+
+    glm::vec3 position = transform * glm::vec4(0.0f, 0.0f, 0.0f, 1.0f);
+
+    if (type == "point") {
+        LightRecord& record = m_lightRecords.emplace_back();
+        record.type = Light::Type::kPoint;
+        record.name = light["name"].asString();
+        record.point.position = position;
+        record.point.luminousIntensity = intensity;
+        record.point.color = color;
+    } else if (type == "directional") {
+        LightRecord& record = m_lightRecords.emplace_back();
+        record.type = Light::Type::kDirectional;
+        record.name = light["name"].asString();
+        lightOrientation(transform, record.directional.orientation.phi, record.directional.orientation.theta);
+        record.directional.illuminance = intensity;
+        record.directional.color = color;
+    } else if (type == "spot") {
+        LightRecord& record = m_lightRecords.emplace_back();
+        record.type = Light::Type::kSpot;
+        record.name = light["name"].asString();
+        record.spot.position = position;
+        lightOrientation(transform, record.spot.orientation.phi, record.spot.orientation.theta);
+        record.spot.luminousIntensity = intensity;
+        record.spot.color = color;
+
+        const util::JsonValue& spot = light["spot"];
+        record.spot.innerAngle = spot["innerConeAngle"].asFloat(0.0f);
+        record.spot.outerAngle = spot["outerConeAngle"].asFloat(glm::quarter_pi<float>());
+    }
+}
@@ -0,0 +1,96 @@
+//
+//  GltfMeshProvider.h
+//  Heatray
+//
+//  Loads glTF 2.0 (.gltf and .glb) assets without going through Assimp. The
+//  asset and its buffers are memory mapped and the vertex and index data is
+//  exposed to Mesh directly from the mapping, so it is only copied once when
+//  filling the OpenRL buffers. The copy is streamed in chunks so that only a
+//  chunk of each buffer is resident in host memory at a time.
+//
+//
+
+#pragma once
+
+#include "MappedMeshProvider.h"
+#include "SceneRecords.h"
+
+#include <Utility/AABB.h>
+#include <Utility/MappedFile.h>
+
+#include <glm/glm/mat4x4.hpp>
+
+#include <stdint.h>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+// Forward declarations.
+namespace util {
+class JsonValue;
+} // namespace util.
+
+class GltfMeshProvider : public MappedMeshProvider
+{
+public:
+    explicit GltfMeshProvider(const std::string_view name) : MappedMeshProvider(name) {}
+    virtual ~GltfMeshProvider() = default;
+
+    //-------------------------------------------------------------------------
+    // Returns true if 'path' names a glTF asset based on its extension.
+    static bool isGltf(const std::string_view path);
+
+    //-------------------------------------------------------------------------
+    // Memory map the asset at 'path' along with any external buffers it
+    // references. Returns false if the asset could not be read or uses
+    // features that are not supported here (e.g. embedded base64 buffers,
+    // compressed geometry or normal maps without tangents), in which case it
+    // should be loaded with Assimp instead.
+    bool open(const std::string_view path, bool convertToMeters);
+
+    const std::vector<MaterialRecord>& materialRecords() const { return m_materialRecords; }
+    const std::vector<LightRecord>& lightRecords() const { return m_lightRecords; }
+    const util::AABB& sceneAABB() const { return m_sceneAABB; }
+
+private:
+    // Location of the elements of a glTF accessor within one of its buffer views.
+    struct AccessorView {
+        size_t bufferView = 0;
+        size_t offset = 0; // In bytes from the start of the buffer view.
+        size_t count = 0;
+        int componentType = 0;
+        int componentCount = 0;
+        int stride = 0; // In bytes.
+    };
+
+    // Submeshes for the primitives of a glTF mesh, instanced by every node that refers to it.
+    struct ProcessedMesh {
+        std::vector<Submesh> submeshes;
+        util::AABB bounds; // In the space of the mesh.
+    };
+
+    bool mapBuffers(const util::JsonValue& document, const std::string_view assetDirectory, const BufferRange& binaryChunk);
+    bool resolveAccessor(const util::JsonValue& document, size_t accessorIndex, AccessorView& view) const;
+    bool processMesh(const util::JsonValue& document, size_t meshIndex, ProcessedMesh& mesh);
+    void processMaterial(const util::JsonValue& document, const util::JsonValue& material);
+    void processNode(const util::JsonValue& document, size_t nodeIndex, const glm::mat4& parentTransform,
+                     const std::vector<ProcessedMesh>& meshes, int depth);
+    void processLight(const util::JsonValue& light, const glm::mat4& transform);
+
+    std::string textureUri(const util::JsonValue& document, const util::JsonValue& textureInfo) const;
+    size_t vertexBufferForView(const util::JsonValue& document, size_t bufferView);
+    size_t indexBufferForView(const util::JsonValue& document, size_t bufferView);
+
+    std::vector<util::MappedFile> m_files; // The asset followed by any external buffers.
+    std::vector<BufferRange> m_buffers;    // Data of each glTF buffer.
+
+    std::unordered_map<size_t, size_t> m_vertexBufferViews; // glTF buffer view -> vertex buffer.
+    std::unordered_map<size_t, size_t> m_indexBufferViews;  // glTF buffer view -> index buffer.
+
+    std::vector<MaterialRecord> m_materialRecords;
+    std::vector<bool> m_materialNeedsTangents; // Parallel to the materials of the asset.
+    int m_defaultMaterial = -1; // Added for primitives without a material.
+    std::vector<LightRecord> m_lightRecords;
+    util::AABB m_sceneAABB;
+};
@@ -7,8 +7,11 @@
 
 #include <RLWrapper/Buffer.h>
 #include <RLWrapper/Program.h>
+#include <Utility/Hash.h>
 #include <Utility/Log.h>
 
+#include <algorithm>
+
 Lighting::Lighting()
 {
     m_environment.buffer = openrl::Buffer::create(RL_ARRAY_BUFFER, nullptr, sizeof(EnvironmentLightBuffer), "Environment Light Buffer");
@@ -86,38 +89,49 @@ void Lighting::clearAllButEnvironment()
 }
 
 void Lighting::bindLightingBuffersToProgram(const std::shared_ptr<openrl::Program> program)
+{
+    bindLightingBuffersToProgram(*program, LightingUniformBlocks::resolve(*program));
+}
+
+void Lighting::bindLightingBuffersToProgram(const openrl::Program &program, const LightingUniformBlocks &blocks)
 {
     // Environment Light.
-    {
-        RLint blockIndex = program->getUniformBlockIndex("EnvironmentLight");
-        if (blockIndex != -1) {
-            program->setUniformBlock(blockIndex, m_environment.buffer->buffer());
-        }
+    if (blocks.environmentLight.valid()) {
+        program.setUniformBlock(blocks.environmentLight, m_environment.buffer->buffer());
     }
 
     // Directional lights.
-    {
-        RLint blockIndex = program->getUniformBlockIndex("DirectionalLights");
-        if (blockIndex != -1) {
-            program->setUniformBlock(blockIndex, m_directional.buffer->buffer());
-        }
+    if (blocks.directionalLights.valid()) {
+        program.setUniformBlock(blocks.directionalLights, m_directional.buffer->buffer());
     }
 
     // Point lights.
-    {
-        RLint blockIndex = program->getUniformBlockIndex("PointLights");
-        if (blockIndex != -1) {
-            program->setUniformBlock(blockIndex, m_point.buffer->buffer());
-        }
+    if (blocks.pointLights.valid()) {
+        program.setUniformBlock(blocks.pointLights, m_point.buffer->buffer());
     }
 
     // Spot lights.
-    {
-        RLint blockIndex = program->getUniformBlockIndex("SpotLights");
-        if (blockIndex != -1) {
-            program->setUniformBlock(blockIndex, m_spot.buffer->buffer());
-        }
+    if (blocks.spotLights.valid()) {
+        program.setUniformBlock(blocks.spotLights, m_spot.buffer->buffer());
+    }
+}
+
+uint64_t Lighting::stateHash() const
+{
+    // The light parameters only hold floats so they can be hashed as raw bytes.
+    uint64_t hash = util::FNV1a(m_directional.count);
+    for (int ii = 0; ii < m_directional.count; ++ii) {
+        hash = util::hashCombine(hash, util::FNV1a(m_directional.lights[ii]->params()));
     }
+    hash = util::hashCombine(hash, util::FNV1a(m_point.count));
+    for (int ii = 0; ii < m_point.count; ++ii) {
+        hash = util::hashCombine(hash, util::FNV1a(m_point.lights[ii]->params()));
+    }
+    hash = util::hashCombine(hash, util::FNV1a(m_spot.count));
+    for (int ii = 0; ii < m_spot.count; ++ii) {
+        hash = util::hashCombine(hash, util::FNV1a(m_spot.lights[ii]->params()));
+    }
+    return hash;
 }
 
 void Lighting::updateLight(std::shared_ptr<Light> light)
@@ -160,6 +174,47 @@ void Lighting::removeLight(std::shared_ptr<Light> light)
     };
 }
 
+void Lighting::reloadShaders(const std::vector<std::string> &shaders)
+{
+    auto reloadLight = [this, &shaders](std::shared_ptr<Light> light) {
+        if (!std::any_of(shaders.begin(), shaders.end(), [&light](const std::string &shader) { return light->usesShader(shader); })) {
+            return;
+        }
+
+        LOG_INFO("Rebuilding light %s", std::string(light->name()).c_str());
+        if (!light->rebuild()) {
+            LOG_ERROR("Unable to rebuild light %s, keeping the previous program", std::string(light->name()).c_str());
+            return;
+        }
+
+        // Set up the new program and primitive the same way as when the light was added.
+        light->primitive()->bind();
+        light->program()->bind();
+        bindLightingBuffersToProgram(light->program());
+        light->primitive()->unbind();
+
+        // Points the lighting buffer at the new primitive.
+        updateLight(light);
+
+        if (m_lightCreatedCallback) {
+            m_lightCreatedCallback(light);
+        }
+    };
+
+    if (m_environment.light) {
+        reloadLight(m_environment.light);
+    }
+    for (int ii = 0; ii < m_directional.count; ++ii) {
+        reloadLight(m_directional.lights[ii]);
+    }
+    for (int ii = 0; ii < m_point.count; ++ii) {
+        reloadLight(m_point.lights[ii]);
+    }
+    for (int ii = 0; ii < m_spot.count; ++ii) {
+        reloadLight(m_spot.lights[ii]);
+    }
+}
+
 std::shared_ptr<EnvironmentLight> Lighting::addEnvironmentLight()
 {
     m_environment.light = std::shared_ptr<EnvironmentLight>(new EnvironmentLight("Environment", m_environment.buffer));
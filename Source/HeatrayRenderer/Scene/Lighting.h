@@ -11,6 +11,7 @@
 #include <HeatrayRenderer/Lights/ShaderLightingDefines.h>
 
 #include <functional>
+#include <string>
 #include <vector>
 
 // Forward declarations.
@@ -43,6 +44,11 @@ public:
     // Binds the internal lighting buffers to an OpenRL program.
     void bindLightingBuffersToProgram(const std::shared_ptr<openrl::Program> program);
 
+    //-------------------------------------------------------------------------
+    // Same as above for a program whose lighting blocks have already been
+    // resolved, e.g. the program of a material.
+    void bindLightingBuffersToProgram(const openrl::Program &program, const LightingUniformBlocks &blocks);
+
     //-------------------------------------------------------------------------
     // Install a callback that is always invoked whenever a new light is created.
     using LightCreatedCallback = std::function<void(std::shared_ptr<Light> light)>;
@@ -56,6 +62,13 @@ public:
     // Remove a light, deleting its resources from OpenRL as well.
     void removeLight(std::shared_ptr<Light> light);
 
+    //-------------------------------------------------------------------------
+    // Rebuild every light whose program uses one of 'shaders' (relative to
+    // the shader directory) so that edited shaders take effect, see
+    // Light::rebuild(). Lights whose shaders fail to build keep their
+    // previous program.
+    void reloadShaders(const std::vector<std::string> &shaders);
+
     std::shared_ptr<DirectionalLight> addDirectionalLight(const std::string_view name);
     const std::shared_ptr<DirectionalLight>* directionalLights() const { return &(m_directional.lights[0]); }
     void updateDirectionalLight(std::shared_ptr<DirectionalLight> light);
@@ -75,6 +88,11 @@ public:
     void removeEnvironmentLight();
     void updateEnvironmentLight(std::shared_ptr<EnvironmentLight> light);
 
+    //-------------------------------------------------------------------------
+    // Hash of the parameters of all directional, point and spot lights. The
+    // environment light is not included. Stable between runs of Heatray.
+    uint64_t stateHash() const;
+
 private:
     struct Environment {
         std::shared_ptr<EnvironmentLight> light = nullptr;
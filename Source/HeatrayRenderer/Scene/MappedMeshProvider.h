@@ -0,0 +1,91 @@
+//
+//  MappedMeshProvider.h
+//  Heatray
+//
+//  Base for providers whose vertex and index buffers are ranges of memory
+//  mapped files (see util::MappedFile). Buffers are streamed out of the
+//  mapping when they are filled and evicted again once their chunk is
+//  released, so only a chunk of each buffer is resident in host memory at
+//  a time. Derived providers just fill in the buffer ranges and submeshes.
+//
+//
+
+#pragma once
+
+#include "MeshProvider.h"
+
+#include <Utility/MappedFile.h>
+
+#include <stdint.h>
+#include <string_view>
+#include <vector>
+
+class MappedMeshProvider : public MeshProvider
+{
+public:
+    explicit MappedMeshProvider(const std::string_view name) : MeshProvider(name) {}
+    virtual ~MappedMeshProvider() = default;
+
+    size_t GetVertexBufferCount() override
+    {
+        return m_vertexBuffers.size();
+    }
+
+    size_t GetVertexBufferSize(size_t bufferIndex) override
+    {
+        return m_vertexBuffers[bufferIndex].size;
+    }
+
+    void FillVertexBuffer(size_t bufferIndex, uint8_t *buffer) override
+    {
+        util::MappedFile::streamCopy(buffer, m_vertexBuffers[bufferIndex].data, m_vertexBuffers[bufferIndex].size);
+    }
+
+    size_t GetIndexBufferCount() override
+    {
+        return m_indexBuffers.size();
+    }
+
+    size_t GetIndexBufferSize(size_t bufferIndex) override
+    {
+        return m_indexBuffers[bufferIndex].size;
+    }
+
+    void FillIndexBuffer(size_t bufferIndex, uint8_t *buffer) override
+    {
+        util::MappedFile::streamCopy(buffer, m_indexBuffers[bufferIndex].data, m_indexBuffers[bufferIndex].size);
+    }
+
+    size_t GetSubmeshCount() override
+    {
+        return m_submeshes.size();
+    }
+
+    Submesh GetSubmesh(size_t submeshIndex) override
+    {
+        return m_submeshes[submeshIndex];
+    }
+
+    void ReleaseChunk(size_t chunkIndex) override
+    {
+        // Also drops the partial pages at the ends of each buffer that streaming them left behind.
+        const Chunk chunk = GetChunk(chunkIndex);
+        for (size_t ii = chunk.firstVertexBuffer; ii < chunk.firstVertexBuffer + chunk.vertexBufferCount; ++ii) {
+            util::MappedFile::evict(m_vertexBuffers[ii].data, m_vertexBuffers[ii].size);
+        }
+        for (size_t ii = chunk.firstIndexBuffer; ii < chunk.firstIndexBuffer + chunk.indexBufferCount; ++ii) {
+            util::MappedFile::evict(m_indexBuffers[ii].data, m_indexBuffers[ii].size);
+        }
+    }
+
+protected:
+    struct BufferRange {
+        const uint8_t* data = nullptr;
+        size_t size = 0; // In bytes.
+    };
+
+    // Ranges within the mapped files owned by the derived provider.
+    std::vector<BufferRange> m_vertexBuffers;
+    std::vector<BufferRange> m_indexBuffers;
+    std::vector<Submesh> m_submeshes;
+};
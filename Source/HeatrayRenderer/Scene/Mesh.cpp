@@ -1,5 +1,6 @@
 #include "Mesh.h"
 
+#include "MeshLod.h"
 #include "MeshProvider.h"
 
 #include <HeatrayRenderer/Materials/Material.h>
@@ -12,50 +13,103 @@
 #include <glm/glm/glm.hpp>
 #include <glm/glm/gtc/matrix_transform.hpp>
 
+#include <algorithm>
+#include <assert.h>
+
 Mesh::Mesh(MeshProvider* meshProvider,
            std::vector<std::shared_ptr<Material>> &materials,
            std::function<void(const std::shared_ptr<openrl::Program>)> &materialCreatedCallback, 
-           const glm::mat4 &transform)
+           const glm::mat4 &transform,
+           const MeshLod *lod,
+           Upload upload)
 {
     m_materials = std::move(materials);
 
+    // Materials used by quantized submeshes or submeshes with four component tangents need shaders that
+    // decode the vertex attributes.
+    for (int ii = 0; ii < meshProvider->GetSubmeshCount(); ++ii) {
+        MeshProvider::Submesh submesh = meshProvider->GetSubmesh(ii);
+        bool compact = false;
+        bool tangentHandedness = false;
+        for (int jj = 0; jj < submesh.vertexAttributeCount; ++jj) {
+            const VertexAttribute& attribute = submesh.vertexAttributes[jj];
+            compact |= (attribute.type != VertexAttributeType::kFloat);
+            tangentHandedness |= (attribute.usage == VertexAttributeUsage_Tangents) && (attribute.componentCount == 4);
+        }
+        size_t materialIndex = (submesh.materialIndex != -1) ? submesh.materialIndex : (m_materials.size() > 1 ? ii : 0);
+        if (compact) {
+            m_materials[materialIndex]->enableCompactVertices();
+        } else if (tangentHandedness) {
+            m_materials[materialIndex]->enableTangentHandedness();
+        }
+    }
+
     // Build the materials.
     for (auto& material : m_materials) {
         material->build();
     }
 
     LOG_INFO("Building Mesh data for Provider %s", meshProvider->name().data());
-    size_t vertexBufferCount = meshProvider->GetVertexBufferCount();
-    for (size_t ii = 0; ii < vertexBufferCount; ++ii) {
-        std::shared_ptr<openrl::Buffer> buffer = openrl::Buffer::create(RL_ARRAY_BUFFER, nullptr, meshProvider->GetVertexBufferSize(ii), "Vertex Buffer");
+    m_provider = meshProvider;
+    m_lod = lod;
+    m_transform = transform;
+    m_vertexBuffers.resize(meshProvider->GetVertexBufferCount());
+    m_indexBuffers.resize(meshProvider->GetIndexBufferCount());
+    m_submeshes.reserve(meshProvider->GetSubmeshCount());
+    m_sources.reserve(meshProvider->GetSubmeshCount());
+
+    if (lod) {
+        assert(lod->submeshes().size() == size_t(meshProvider->GetSubmeshCount()));
+        const std::string simplifiedIndexBufferName = std::string(meshProvider->name()) + " simplified index buffer";
+        for (const std::vector<uint8_t> &indices : lod->indexBuffers()) {
+            std::shared_ptr<openrl::Buffer> buffer = openrl::Buffer::create(RL_ELEMENT_ARRAY_BUFFER, indices.data(), indices.size(), simplifiedIndexBufferName);
+            m_simplifiedIndexBuffers.push_back(std::move(buffer));
+        }
+    }
+
+    if (upload == Upload::kAll) {
+        while (!complete()) {
+            uploadNextChunk(materialCreatedCallback);
+        }
+    }
+}
+
+void Mesh::uploadNextChunk(const std::function<void(const std::shared_ptr<openrl::Program>)> &materialCreatedCallback)
+{
+    assert(!complete());
+    MeshProvider *meshProvider = m_provider;
+    const MeshProvider::Chunk chunk = meshProvider->GetChunk(m_nextChunk);
+
+    const std::string vertexBufferName = std::string(meshProvider->name()) + " vertex buffer";
+    const std::string indexBufferName = std::string(meshProvider->name()) + " index buffer";
+    for (size_t ii = chunk.firstVertexBuffer; ii < chunk.firstVertexBuffer + chunk.vertexBufferCount; ++ii) {
+        std::shared_ptr<openrl::Buffer> buffer = openrl::Buffer::create(RL_ARRAY_BUFFER, nullptr, meshProvider->GetVertexBufferSize(ii), vertexBufferName);
         buffer->bind();
         uint8_t * mapping = buffer->mapBuffer<uint8_t>(RL_READ_WRITE);
         meshProvider->FillVertexBuffer(ii, mapping);
         buffer->unmapBuffer();
-        m_vertexBuffers.push_back(std::move(buffer));
+        m_vertexBuffers[ii] = std::move(buffer);
     }
 
-    size_t indexBufferCount = meshProvider->GetIndexBufferCount();
-    for (size_t ii = 0; ii < indexBufferCount; ++ii) {
+    for (size_t ii = chunk.firstIndexBuffer; ii < chunk.firstIndexBuffer + chunk.indexBufferCount; ++ii) {
         size_t numIndices = meshProvider->GetIndexBufferSize(ii);
         if (numIndices == 0) {
             LOG_WARNING("Found a 0-sized index buffer - skipping.");
-            m_indexBuffers.push_back(nullptr);
             continue;
         }
 
-        std::shared_ptr<openrl::Buffer> buffer = openrl::Buffer::create(RL_ELEMENT_ARRAY_BUFFER, nullptr, numIndices, "Index Buffer");
+        std::shared_ptr<openrl::Buffer> buffer = openrl::Buffer::create(RL_ELEMENT_ARRAY_BUFFER, nullptr, numIndices, indexBufferName);
         buffer->bind();
         uint8_t * mapping = buffer->mapBuffer<uint8_t>(RL_READ_WRITE);
         meshProvider->FillIndexBuffer(ii, mapping);
         buffer->unmapBuffer();
-        m_indexBuffers.push_back(std::move(buffer));
+        m_indexBuffers[ii] = std::move(buffer);
     }
 
-    m_submeshes.resize(meshProvider->GetSubmeshCount());
-    for (int ii = 0; ii < meshProvider->GetSubmeshCount(); ++ii) {
+    for (size_t ii = chunk.firstSubmesh; ii < chunk.firstSubmesh + chunk.submeshCount; ++ii) {
+        assert(ii == m_submeshes.size());
         MeshProvider::Submesh submesh = meshProvider->GetSubmesh(ii);
-        Mesh::Submesh & rlSubmesh = m_submeshes[ii];
+        Mesh::Submesh & rlSubmesh = m_submeshes.emplace_back();
 
         // If submesh material index is set, use it to look up the material
         if (submesh.materialIndex != -1) {
@@ -65,101 +119,197 @@ Mesh::Mesh(MeshProvider* meshProvider,
             rlSubmesh.material = m_materials.size() > 1 ? m_materials[ii] : m_materials[0];
         }
 
-        std::shared_ptr<Material> material = rlSubmesh.material;
+        rlSubmesh.transform = submesh.localTransform * m_transform;
+        switch (submesh.drawMode) {
+            case DrawMode::Triangles:
+                rlSubmesh.mode = RL_TRIANGLES;
+                break;
+            case DrawMode::TriangleStrip:
+                rlSubmesh.mode = RL_TRIANGLE_STRIP;
+                break;
+            default:
+                LOG_ERROR("Unsupported draw mode for submesh %s!\n", submesh.name.c_str());
+                break;
+        }
 
-        rlSubmesh.primitive = openrl::Primitive::create();
-        rlSubmesh.primitive->attachProgram(material->program());
-        rlSubmesh.primitive->bind();
+        rlSubmesh.elementCount = submesh.elementCount;
+        rlSubmesh.offset = submesh.indexOffset;
+        rlSubmesh.indexType = (submesh.indexType == IndexType::kUInt16) ? RL_UNSIGNED_SHORT : RL_UNSIGNED_INT;
+        m_indexBytes += submesh.elementCount * indexSize(submesh.indexType);
+        m_indexBytes32 += submesh.elementCount * sizeof(uint32_t);
 
-        // If this material has a uniform block, bind it here.
-        RLint uniformBlockIndex = material->program()->getUniformBlockIndex("Material"); // Yeah - this is saying all shader's should use the name "Material" for their uniform blocks.
-        if (uniformBlockIndex != -1) {
-            material->program()->setUniformBlock(uniformBlockIndex, material->uniformBlock()->buffer());
+        SubmeshSource &source = m_sources.emplace_back();
+        source.submesh = std::move(submesh);
+        if (m_lod && (m_lod->submeshes()[ii].indexBuffer != MeshLod::kFullDetail)) {
+            const MeshLod::Submesh &lodSubmesh = m_lod->submeshes()[ii];
+            source.simplifiedIndexBuffer = lodSubmesh.indexBuffer;
+            source.simplifiedElementCount = lodSubmesh.elementCount;
+            source.simplifiedIndexType = (lodSubmesh.indexType == IndexType::kUInt16) ? RL_UNSIGNED_SHORT : RL_UNSIGNED_INT;
         }
+        createPrimitives(ii, materialCreatedCallback);
+    }
 
-        // Let the system setup any required data for this primitive.
-        materialCreatedCallback(material->program());
-
-        int worldFromEntityLocation = material->program()->getUniformLocation("worldFromEntity");
+    // Everything of the chunk now lives in OpenRL.
+    meshProvider->ReleaseChunk(m_nextChunk);
+    if (++m_nextChunk == meshProvider->GetChunkCount()) {
+        LOG_INFO("Index data for %s: %.2f MB (%.2f MB saved by 16bit indices)", meshProvider->name().data(),
+                 double(m_indexBytes) / (1024.0 * 1024.0), double(m_indexBytes32 - m_indexBytes) / (1024.0 * 1024.0));
+        m_provider = nullptr;
+        m_lod = nullptr;
+    }
+}
 
-        rlSubmesh.transform = submesh.localTransform * transform;
-        float determinant = glm::determinant(rlSubmesh.transform);
-        if (determinant < 0.0) {
-            rlFrontFace(RL_CW);
-        } else {
-            rlFrontFace(RL_CCW);
+void Mesh::rebuildPrimitives(const std::vector<std::shared_ptr<Material>> &materials,
+                             const std::function<void(const std::shared_ptr<openrl::Program>)> &materialCreatedCallback)
+{
+    for (size_t ii = 0; ii < m_submeshes.size(); ++ii) {
+        if (std::find(materials.begin(), materials.end(), m_submeshes[ii].material) != materials.end()) {
+            createPrimitives(ii, materialCreatedCallback);
         }
+    }
+}
 
-        // If this material is setup to do alpha masking (and is a PBR material), then tell RL that this is not an occluder so that
-        // occlusion rays will still run the shader code.
-        if (material->type() == Material::Type::PBR) {
-            std::shared_ptr<PhysicallyBasedMaterial> pbrMaterial = std::static_pointer_cast<PhysicallyBasedMaterial>(material);
-            if (pbrMaterial->parameters().alphaMask) {
-                rlPrimitiveParameter1i(RL_PRIMITIVE, RL_PRIMITIVE_IS_OCCLUDER, RL_FALSE);
-            }
+void Mesh::createPrimitives(size_t submeshIndex, const std::function<void(const std::shared_ptr<openrl::Program>)> &materialCreatedCallback)
+{
+    Submesh &rlSubmesh = m_submeshes[submeshIndex];
+    const SubmeshSource &source = m_sources[submeshIndex];
+
+    if (m_indexBuffers[source.submesh.indexBuffer]) {
+        LOG_INFO("\tSubmitting %s to OpenRL", source.submesh.name.c_str());
+        rlSubmesh.primitive = createPrimitive(rlSubmesh, source.submesh, m_indexBuffers[source.submesh.indexBuffer], rlSubmesh.elementCount,
+                                              rlSubmesh.indexType, rlSubmesh.offset, materialCreatedCallback);
+    } else {
+        rlSubmesh.primitive = openrl::Primitive::create();
+        rlSubmesh.primitive->attachProgram(rlSubmesh.material->program());
+    }
+
+    // Only one of the two versions is visible at a time, see setSimplified().
+    if (source.simplifiedIndexBuffer != SubmeshSource::kNoSimplifiedIndexBuffer) {
+        rlSubmesh.simplifiedPrimitive = createPrimitive(rlSubmesh, source.submesh, m_simplifiedIndexBuffers[source.simplifiedIndexBuffer],
+                                                        source.simplifiedElementCount, source.simplifiedIndexType, 0, materialCreatedCallback);
+        rlSubmesh.simplifiedPrimitive->bind();
+        RLFunc(rlPrimitiveParameter1i(RL_PRIMITIVE, RL_PRIMITIVE_IS_VISIBLE, m_simplified ? RL_TRUE : RL_FALSE));
+        if (m_simplified) {
+            rlSubmesh.primitive->bind();
+            RLFunc(rlPrimitiveParameter1i(RL_PRIMITIVE, RL_PRIMITIVE_IS_VISIBLE, RL_FALSE));
         }
+        rlSubmesh.simplifiedPrimitive->unbind();
+    }
+}
 
-        material->program()->setMatrix4fv(worldFromEntityLocation, &(rlSubmesh.transform[0][0]));
+// Both the full detail and the simplified primitive of a submesh are set up the same way, they only differ in the indices
+// they draw.
+std::shared_ptr<openrl::Primitive> Mesh::createPrimitive(const Submesh &rlSubmesh, const MeshProvider::Submesh &submesh,
+                                                         const std::shared_ptr<openrl::Buffer> &indexBuffer, size_t elementCount,
+                                                         RLenum indexType, size_t offset,
+                                                         const std::function<void(const std::shared_ptr<openrl::Program>)> &materialCreatedCallback)
+{
+    const std::shared_ptr<Material> &material = rlSubmesh.material;
+    const Material::Uniforms &uniforms = material->uniforms();
 
-        for (int jj = 0; jj < submesh.vertexAttributeCount; ++jj) {
-            auto & attribute = submesh.vertexAttributes[jj];
-            int attributeLocation = -1;
-            switch (attribute.usage) {
-                case VertexAttributeUsage_Position:
-                    attributeLocation = material->program()->getAttributeLocation("positionAttribute");
-                    break;
-                case VertexAttributeUsage_Normal:
-                    attributeLocation = material->program()->getAttributeLocation("normalAttribute");
-                    break;
-                case VertexAttributeUsage_TexCoord:
-                    attributeLocation = material->program()->getAttributeLocation("texCoordAttribute");
-                    break;
-                case VertexAttributeUsage_Tangents:
-                    attributeLocation = material->program()->getAttributeLocation("tangentAttribute");
-                    break;
-                case VertexAttributeUsage_Bitangents:
-                    attributeLocation = material->program()->getAttributeLocation("bitangentAttribute");
-                    break;
-                case VertexAttributeUsage_Colors:
-                    attributeLocation = material->program()->getAttributeLocation("colorAttribute");
-                    break;
-                default:
-                    LOG_ERROR("Unknown vertex attribute usage %d for submesh %s\n", attribute.usage, submesh.name.c_str());
-            }
-            if (attributeLocation != -1) {
-                m_vertexBuffers[attribute.buffer]->setAsVertexAttribute(attributeLocation, attribute.componentCount, RL_FLOAT, attribute.stride, attribute.offset);
-            }
+    std::shared_ptr<openrl::Primitive> primitive = openrl::Primitive::create();
+    primitive->attachProgram(material->program());
+    primitive->bind();
+
+    // If this material has a uniform block, bind it here.
+    if (uniforms.material.valid()) {
+        material->program()->setUniformBlock(uniforms.material, material->uniformBlock()->buffer());
+    }
+
+    // Let the system setup any required data for this primitive.
+    materialCreatedCallback(material->program());
+
+    float determinant = glm::determinant(rlSubmesh.transform);
+    if (determinant < 0.0) {
+        rlFrontFace(RL_CW);
+    } else {
+        rlFrontFace(RL_CCW);
+    }
+
+    // If this material is setup to do alpha masking (and is a PBR material), then tell RL that this is not an occluder so that
+    // occlusion rays will still run the shader code.
+    if (material->type() == Material::Type::PBR) {
+        std::shared_ptr<PhysicallyBasedMaterial> pbrMaterial = std::static_pointer_cast<PhysicallyBasedMaterial>(material);
+        if (pbrMaterial->parameters().alphaMask) {
+            rlPrimitiveParameter1i(RL_PRIMITIVE, RL_PRIMITIVE_IS_OCCLUDER, RL_FALSE);
         }
-        
-        switch (submesh.drawMode) {
-            case DrawMode::Triangles:
-                rlSubmesh.mode = RL_TRIANGLES;
+    }
+
+    material->program()->setMatrix4fv(uniforms.worldFromEntity, &(rlSubmesh.transform[0][0]));
+
+    if (uniforms.texCoordTransform.valid()) {
+        material->program()->set4fv(uniforms.texCoordTransform, &(submesh.texCoordTransform[0]));
+    }
+
+    for (int jj = 0; jj < submesh.vertexAttributeCount; ++jj) {
+        auto & attribute = submesh.vertexAttributes[jj];
+        int attributeLocation = -1;
+        switch (attribute.usage) {
+            case VertexAttributeUsage_Position:
+                attributeLocation = material->program()->getAttributeLocation("positionAttribute");
                 break;
-            case DrawMode::TriangleStrip:
-                rlSubmesh.mode = RL_TRIANGLE_STRIP;
+            case VertexAttributeUsage_Normal:
+                attributeLocation = material->program()->getAttributeLocation("normalAttribute");
                 break;
-            default:
-                LOG_ERROR("Unsupported draw mode for submesh %s!\n", submesh.name.c_str());
+            case VertexAttributeUsage_TexCoord:
+                attributeLocation = material->program()->getAttributeLocation("texCoordAttribute");
+                break;
+            case VertexAttributeUsage_Tangents:
+                attributeLocation = material->program()->getAttributeLocation("tangentAttribute");
+                break;
+            case VertexAttributeUsage_Bitangents:
+                attributeLocation = material->program()->getAttributeLocation("bitangentAttribute");
                 break;
+            case VertexAttributeUsage_Colors:
+                attributeLocation = material->program()->getAttributeLocation("colorAttribute");
+                break;
+            default:
+                LOG_ERROR("Unknown vertex attribute usage %d for submesh %s\n", attribute.usage, submesh.name.c_str());
         }
+        if (attributeLocation != -1) {
+            RLenum dataType = RL_FLOAT;
+            if (attribute.type == VertexAttributeType::kShort) {
+                dataType = RL_SHORT;
+            } else if (attribute.type == VertexAttributeType::kUnsignedShort) {
+                dataType = RL_UNSIGNED_SHORT;
+            }
+            const RLboolean normalized = (dataType == RL_FLOAT) ? RL_FALSE : RL_TRUE;
+            m_vertexBuffers[attribute.buffer]->setAsVertexAttribute(attributeLocation, attribute.componentCount, dataType, attribute.stride, attribute.offset, normalized);
+        }
+    }
 
-        rlSubmesh.elementCount = submesh.elementCount;
-        rlSubmesh.offset = submesh.indexOffset;
-        
-        if (m_indexBuffers[submesh.indexBuffer]) {
-            LOG_INFO("\tSubmitting %s to OpenRL", submesh.name.c_str());
-            m_indexBuffers[submesh.indexBuffer]->bind();
-            RLFunc(rlDrawElements(rlSubmesh.mode, rlSubmesh.elementCount, RL_UNSIGNED_INT, rlSubmesh.offset));
-            rlSubmesh.primitive->unbind();
+    indexBuffer->bind();
+    RLFunc(rlDrawElements(rlSubmesh.mode, elementCount, indexType, offset));
+    primitive->unbind();
+    return primitive;
+}
+
+bool Mesh::setSimplified(bool simplified)
+{
+    m_simplified = simplified;
+    bool hasSimplifiedSubmeshes = false;
+    for (const Submesh &submesh : m_submeshes) {
+        if (!submesh.simplifiedPrimitive) {
+            continue;
         }
+
+        submesh.primitive->bind();
+        RLFunc(rlPrimitiveParameter1i(RL_PRIMITIVE, RL_PRIMITIVE_IS_VISIBLE, simplified ? RL_FALSE : RL_TRUE));
+        submesh.simplifiedPrimitive->bind();
+        RLFunc(rlPrimitiveParameter1i(RL_PRIMITIVE, RL_PRIMITIVE_IS_VISIBLE, simplified ? RL_TRUE : RL_FALSE));
+        submesh.simplifiedPrimitive->unbind();
+        hasSimplifiedSubmeshes = true;
     }
+    return hasSimplifiedSubmeshes;
 }
 
 void Mesh::destroy()
 {
     m_vertexBuffers.clear();
     m_indexBuffers.clear();
+    m_simplifiedIndexBuffers.clear();
     m_submeshes.clear();
+    m_sources.clear();
     m_materials.clear();
 }
 
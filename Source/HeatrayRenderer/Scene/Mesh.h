@@ -9,6 +9,8 @@
 
 #pragma once
 
+#include "MeshProvider.h"
+
 #include <glm/glm/mat4x4.hpp>
 
 #include <OpenRL/rl.h>
@@ -23,7 +25,7 @@ class Buffer;
 class Primitive;
 class Program;
 } // namespace openrl.
-class MeshProvider;
+class MeshLod;
 class Material;
 
 class Mesh
@@ -31,12 +33,32 @@ class Mesh
 public:
     Mesh() = delete;
 
+    // How the constructor submits the geometry of the provider.
+    enum class Upload {
+        kAll,     // Everything, the provider is not needed afterwards.
+        kChunked  // Nothing, see uploadNextChunk().
+    };
+
+    //-------------------------------------------------------------------------
+    // If 'lod' is supplied (it must have been generated for 'meshProvider')
+    // then its simplified submeshes are submitted as well, see setSimplified().
     Mesh(MeshProvider *meshProvider,
            std::vector<std::shared_ptr<Material>> &materials, 
            std::function<void(const std::shared_ptr<openrl::Program>)> & materialCreatedCallback,
-           const glm::mat4 &transform);
+           const glm::mat4 &transform,
+           const MeshLod *lod = nullptr,
+           Upload upload = Upload::kAll);
     ~Mesh() = default;
 
+    //-------------------------------------------------------------------------
+    // Upload the buffers of the next chunk of the provider (see
+    // MeshProvider::GetChunk()), create the primitives of its submeshes and
+    // release the chunk from the provider. The submeshes are appended to
+    // submeshes(). Until the mesh is complete() the provider and 'lod' passed
+    // to the constructor must stay alive.
+    void uploadNextChunk(const std::function<void(const std::shared_ptr<openrl::Program>)> &materialCreatedCallback);
+    bool complete() const { return m_provider == nullptr; }
+
     // TODO:  Add accessors and stuff to mutate a RLMesh.  Right now it serves the
     // purpose of making sure all the RL resources get cleaned up and not much else!
 
@@ -44,23 +66,65 @@ public:
 
     bool valid() const { return m_indexBuffers.size() > 0; }
 
+    //-------------------------------------------------------------------------
+    // Trace the simplified submeshes instead of the full detail ones (where
+    // there are any). Returns false if this mesh has no simplified submeshes.
+    bool setSimplified(bool simplified);
+
+    //-------------------------------------------------------------------------
+    // Recreate the primitives of all submeshes using one of 'materials' so
+    // that they pick up the programs those materials have been rebuilt with.
+    void rebuildPrimitives(const std::vector<std::shared_ptr<Material>> &materials,
+                           const std::function<void(const std::shared_ptr<openrl::Program>)> &materialCreatedCallback);
+
     const std::vector<std::shared_ptr<Material>>& materials() const { return m_materials;  }
     
     struct Submesh {
         std::shared_ptr<openrl::Primitive> primitive = nullptr;
+        std::shared_ptr<openrl::Primitive> simplifiedPrimitive = nullptr; // Hidden unless the mesh is simplified.
         size_t elementCount = 0;
         size_t offset = 0;
         RLenum mode = 0;
+        RLenum indexType = RL_UNSIGNED_INT;
         std::shared_ptr<Material> material = nullptr;
         glm::mat4 transform = glm::mat4(1.0f);
     };
     const std::vector<Submesh> &submeshes() const { return m_submeshes; }
 
 private:
+    // Everything besides the material that is needed to (re)create the primitives of a submesh.
+    struct SubmeshSource {
+        static constexpr size_t kNoSimplifiedIndexBuffer = ~size_t(0);
+
+        MeshProvider::Submesh submesh;
+        size_t simplifiedIndexBuffer = kNoSimplifiedIndexBuffer; // Into m_simplifiedIndexBuffers.
+        size_t simplifiedElementCount = 0;
+        RLenum simplifiedIndexType = RL_UNSIGNED_INT;
+    };
+
+    void createPrimitives(size_t submeshIndex, const std::function<void(const std::shared_ptr<openrl::Program>)> &materialCreatedCallback);
+    std::shared_ptr<openrl::Primitive> createPrimitive(const Submesh &rlSubmesh, const MeshProvider::Submesh &submesh,
+                                                       const std::shared_ptr<openrl::Buffer> &indexBuffer, size_t elementCount,
+                                                       RLenum indexType, size_t offset,
+                                                       const std::function<void(const std::shared_ptr<openrl::Program>)> &materialCreatedCallback);
+
     std::vector<std::shared_ptr<openrl::Buffer>> m_vertexBuffers;
     std::vector<std::shared_ptr<openrl::Buffer>> m_indexBuffers;
+    std::vector<std::shared_ptr<openrl::Buffer>> m_simplifiedIndexBuffers;
 
     std::vector<Submesh> m_submeshes;
+    std::vector<SubmeshSource> m_sources; // One per submesh.
+    bool m_simplified = false;
 
     std::vector<std::shared_ptr<Material>> m_materials;
+
+    // Only set while chunks are left to upload.
+    MeshProvider *m_provider = nullptr;
+    const MeshLod *m_lod = nullptr;
+    glm::mat4 m_transform = glm::mat4(1.0f);
+    size_t m_nextChunk = 0;
+
+    // Size of all submesh indices as submitted and as they would be if they were all 32bit.
+    size_t m_indexBytes = 0;
+    size_t m_indexBytes32 = 0;
 };
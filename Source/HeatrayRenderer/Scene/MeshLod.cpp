@@ -0,0 +1,301 @@
+#include "MeshLod.h"
+
+#include <Utility/BinaryStream.h>
+#include <Utility/Hash.h>
+#include <Utility/Log.h>
+#include <Utility/MappedFile.h>
+#include <Utility/MeshOptimizer.h>
+#include <Utility/ParallelFor.h>
+#include <Utility/Timer.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <memory_resource>
+#include <tuple>
+#include <unordered_map>
+
+namespace {
+
+//-------------------------------------------------------------------------
+// Indices and positions of a submesh. Submeshes with the same geometry
+// (e.g. instances) share their simplified indices.
+struct Geometry {
+    size_t indexBuffer = 0;
+    size_t indexOffset = 0; // In bytes.
+    size_t elementCount = 0;
+    IndexType indexType = IndexType::kUInt32;
+    size_t positionBuffer = 0;
+    size_t positionOffset = 0; // In bytes.
+    size_t positionStride = 0; // In bytes.
+
+    auto tie() const { return std::tie(indexBuffer, indexOffset, elementCount, indexType, positionBuffer, positionOffset, positionStride); }
+    bool operator<(const Geometry& other) const { return tie() < other.tie(); }
+};
+
+bool simplifiable(const MeshProvider::Submesh& submesh, Geometry& geometry)
+{
+    if ((submesh.drawMode != DrawMode::Triangles) || ((submesh.elementCount / 3) < MeshLod::kMinTriangleCount) ||
+        ((submesh.indexOffset % indexSize(submesh.indexType)) != 0)) {
+        return false;
+    }
+
+    for (int ii = 0; ii < submesh.vertexAttributeCount; ++ii) {
+        const VertexAttribute& attribute = submesh.vertexAttributes[ii];
+        if (attribute.usage != VertexAttributeUsage_Position) {
+            continue;
+        }
+        if ((attribute.type != VertexAttributeType::kFloat) || (attribute.componentCount < 3) || (attribute.buffer < 0) ||
+            ((attribute.offset % sizeof(float)) != 0) || ((attribute.stride % sizeof(float)) != 0)) {
+            return false;
+        }
+
+        geometry.indexBuffer = submesh.indexBuffer;
+        geometry.indexOffset = submesh.indexOffset;
+        geometry.elementCount = submesh.elementCount;
+        geometry.indexType = submesh.indexType;
+        geometry.positionBuffer = size_t(attribute.buffer);
+        geometry.positionOffset = attribute.offset;
+        geometry.positionStride = (attribute.stride > 0) ? size_t(attribute.stride) : (attribute.componentCount * sizeof(float));
+        return true;
+    }
+    return false;
+}
+
+} // namespace.
+
+std::shared_ptr<MeshLod> MeshLod::generate(MeshProvider& provider, float triangleRatio, float maxError)
+{
+    util::Timer timer(true);
+
+    std::shared_ptr<MeshLod> lod = std::make_shared<MeshLod>();
+    lod->m_submeshes.resize(provider.GetSubmeshCount());
+
+    // Gather the distinct geometry of all submeshes that are worth simplifying, grouped by the vertex
+    // buffer holding their positions so that every vertex buffer is only read once.
+    std::map<Geometry, size_t> geometryIndices;
+    std::vector<Geometry> geometries;
+    std::vector<size_t> submeshGeometries(lod->m_submeshes.size(), kFullDetail);
+    for (size_t ii = 0; ii < lod->m_submeshes.size(); ++ii) {
+        Geometry geometry;
+        if (simplifiable(provider.GetSubmesh(ii), geometry)) {
+            auto [iter, inserted] = geometryIndices.emplace(geometry, geometries.size());
+            if (inserted) {
+                geometries.push_back(geometry);
+            }
+            submeshGeometries[ii] = iter->second;
+        }
+    }
+
+    std::unordered_map<size_t, std::vector<size_t>> geometriesByBuffer;
+    for (size_t ii = 0; ii < geometries.size(); ++ii) {
+        geometriesByBuffer[geometries[ii].positionBuffer].push_back(ii);
+    }
+    std::vector<std::vector<size_t>> groups;
+    groups.reserve(geometriesByBuffer.size());
+    for (auto& group : geometriesByBuffer) {
+        groups.push_back(std::move(group.second));
+    }
+
+    std::vector<std::vector<uint8_t>> simplifiedIndices(geometries.size());
+    std::atomic<size_t> sourceTriangles = 0;
+    std::atomic<size_t> simplifiedTriangles = 0;
+    util::parallelFor(groups.size(), [&](size_t groupIndex, size_t /*workerIndex*/) {
+        const std::vector<size_t>& group = groups[groupIndex];
+
+        std::vector<uint8_t> vertexData(provider.GetVertexBufferSize(geometries[group.front()].positionBuffer));
+        provider.FillVertexBuffer(geometries[group.front()].positionBuffer, vertexData.data());
+
+        std::vector<uint8_t> indexData;
+        size_t loadedIndexBuffer = kFullDetail;
+        std::vector<uint32_t> indices;
+        for (size_t geometryIndex : group) {
+            const Geometry& geometry = geometries[geometryIndex];
+            if (loadedIndexBuffer != geometry.indexBuffer) {
+                indexData.resize(provider.GetIndexBufferSize(geometry.indexBuffer));
+                provider.FillIndexBuffer(geometry.indexBuffer, indexData.data());
+                loadedIndexBuffer = geometry.indexBuffer;
+            }
+
+            const size_t elementSize = indexSize(geometry.indexType);
+            if ((geometry.indexOffset + geometry.elementCount * elementSize) > indexData.size()) {
+                continue;
+            }
+            indices.resize(geometry.elementCount);
+            const uint8_t* source = indexData.data() + geometry.indexOffset;
+            for (size_t ii = 0; ii < indices.size(); ++ii) {
+                if (geometry.indexType == IndexType::kUInt16) {
+                    uint16_t index;
+                    std::memcpy(&index, source + ii * sizeof(uint16_t), sizeof(uint16_t));
+                    indices[ii] = index;
+                } else {
+                    std::memcpy(&indices[ii], source + ii * sizeof(uint32_t), sizeof(uint32_t));
+                }
+            }
+
+            // Every referenced position has to lie within the vertex buffer.
+            const size_t vertexCount = size_t(*std::max_element(indices.begin(), indices.end())) + 1;
+            if ((geometry.positionOffset + (vertexCount - 1) * geometry.positionStride + 3 * sizeof(float)) > vertexData.size()) {
+                continue;
+            }
+
+            const float* positions = reinterpret_cast<const float*>(vertexData.data() + geometry.positionOffset);
+            const size_t targetIndexCount = size_t(float(indices.size() / 3) * triangleRatio) * 3;
+            std::pmr::monotonic_buffer_resource scratch; // The simplifier tables of this submesh.
+            const size_t indexCount = util::simplifyMesh(indices.data(), indices.size(), positions, vertexCount,
+                                                         geometry.positionStride / sizeof(float), targetIndexCount, maxError, nullptr, &scratch);
+
+            // Tracing a second copy of nearly the same geometry is not worth the memory.
+            if (indexCount > (indices.size() * 9 / 10)) {
+                continue;
+            }
+
+            std::vector<uint8_t>& result = simplifiedIndices[geometryIndex];
+            result.resize(indexCount * elementSize);
+            for (size_t ii = 0; ii < indexCount; ++ii) {
+                if (geometry.indexType == IndexType::kUInt16) {
+                    const uint16_t index = uint16_t(indices[ii]);
+                    std::memcpy(result.data() + ii * sizeof(uint16_t), &index, sizeof(uint16_t));
+                } else {
+                    std::memcpy(result.data() + ii * sizeof(uint32_t), &indices[ii], sizeof(uint32_t));
+                }
+            }
+            sourceTriangles += geometry.elementCount / 3;
+            simplifiedTriangles += indexCount / 3;
+        }
+    });
+
+    // Only keep the geometry that was actually simplified.
+    std::vector<size_t> indexBuffers(geometries.size(), kFullDetail);
+    for (size_t ii = 0; ii < geometries.size(); ++ii) {
+        if (!simplifiedIndices[ii].empty()) {
+            indexBuffers[ii] = lod->m_indexBuffers.size();
+            lod->m_indexBuffers.push_back(std::move(simplifiedIndices[ii]));
+        }
+    }
+    size_t simplifiedSubmeshes = 0;
+    for (size_t ii = 0; ii < lod->m_submeshes.size(); ++ii) {
+        const size_t geometryIndex = submeshGeometries[ii];
+        if ((geometryIndex == kFullDetail) || (indexBuffers[geometryIndex] == kFullDetail)) {
+            continue;
+        }
+        Submesh& submesh = lod->m_submeshes[ii];
+        submesh.indexBuffer = indexBuffers[geometryIndex];
+        submesh.indexType = geometries[geometryIndex].indexType;
+        submesh.elementCount = lod->m_indexBuffers[submesh.indexBuffer].size() / indexSize(submesh.indexType);
+        ++simplifiedSubmeshes;
+    }
+
+    LOG_INFO("Simplified %zu of %zu submeshes of %s from %zu to %zu triangles on %zu threads in %f seconds", simplifiedSubmeshes,
+             lod->m_submeshes.size(), provider.name().data(), sourceTriangles.load(), simplifiedTriangles.load(),
+             util::parallelWorkerCount(groups.size()), timer.stop());
+    return lod;
+}
+
+uint64_t MeshLod::cacheKey(uint64_t sceneKey)
+{
+    uint64_t key = util::hashCombine(sceneKey, kVersion);
+    key = util::hashCombine(key, kDefaultTriangleRatio);
+    key = util::hashCombine(key, kDefaultMaxError);
+    key = util::hashCombine(key, kMinTriangleCount);
+    return key;
+}
+
+std::shared_ptr<MeshLod> MeshLod::load(const std::string& path, uint64_t key)
+{
+    util::MappedFile file;
+    if ((key == 0) || !file.open(path)) {
+        return nullptr;
+    }
+
+    util::BinaryReader reader(file.data(), file.size());
+    uint32_t magic = 0;
+    uint32_t version = 0;
+    uint64_t fileKey = 0;
+    if (!reader.read(magic) || !reader.read(version) || !reader.read(fileKey) || (magic != kMagic) || (version != kVersion) || (fileKey != key)) {
+        LOG_INFO("LOD cache %s is out of date - ignoring it", path.c_str());
+        return nullptr;
+    }
+
+    std::shared_ptr<MeshLod> lod = std::make_shared<MeshLod>();
+    uint64_t count = 0;
+    bool valid = reader.read(count) && (count <= reader.remaining());
+    if (valid) {
+        lod->m_indexBuffers.resize(size_t(count));
+        for (std::vector<uint8_t>& indexBuffer : lod->m_indexBuffers) {
+            uint64_t size = 0;
+            const uint8_t* data = (reader.read(size) && (size <= reader.remaining())) ? reader.readBytes(size_t(size)) : nullptr;
+            valid = valid && (data != nullptr);
+            if (valid) {
+                indexBuffer.assign(data, data + size);
+            }
+        }
+    }
+    valid = valid && reader.read(count) && (count <= reader.remaining());
+    if (valid) {
+        lod->m_submeshes.resize(size_t(count));
+        for (Submesh& submesh : lod->m_submeshes) {
+            uint64_t indexBuffer = 0;
+            uint64_t elementCount = 0;
+            uint32_t indexType = 0;
+            valid = valid && reader.read(indexBuffer) && reader.read(elementCount) && reader.read(indexType) &&
+                    ((indexType == uint32_t(IndexType::kUInt16)) || (indexType == uint32_t(IndexType::kUInt32)));
+            submesh.indexBuffer = (indexBuffer == ~uint64_t(0)) ? kFullDetail : size_t(indexBuffer);
+            submesh.elementCount = size_t(elementCount);
+            submesh.indexType = IndexType(indexType);
+            valid = valid && ((submesh.indexBuffer == kFullDetail) || ((submesh.indexBuffer < lod->m_indexBuffers.size()) &&
+                              ((submesh.elementCount * indexSize(submesh.indexType)) <= lod->m_indexBuffers[submesh.indexBuffer].size())));
+        }
+    }
+
+    if (!valid || !reader.valid()) {
+        LOG_WARNING("LOD cache %s is corrupt - ignoring it", path.c_str());
+        return nullptr;
+    }
+    LOG_INFO("Read %zu simplified index buffers from %s", lod->m_indexBuffers.size(), path.c_str());
+    return lod;
+}
+
+bool MeshLod::write(const std::string& path, uint64_t key) const
+{
+    util::BinaryWriter writer;
+    writer.write(kMagic);
+    writer.write(kVersion);
+    writer.write(key);
+    writer.write(uint64_t(m_indexBuffers.size()));
+    for (const std::vector<uint8_t>& indexBuffer : m_indexBuffers) {
+        writer.write(uint64_t(indexBuffer.size()));
+        writer.writeBytes(indexBuffer.data(), indexBuffer.size());
+    }
+    writer.write(uint64_t(m_submeshes.size()));
+    for (const Submesh& submesh : m_submeshes) {
+        writer.write((submesh.indexBuffer == kFullDetail) ? ~uint64_t(0) : uint64_t(submesh.indexBuffer));
+        writer.write(uint64_t(submesh.elementCount));
+        writer.write(uint32_t(submesh.indexType));
+    }
+
+    std::string tempPath = path + ".tmp";
+    {
+        std::ofstream fout(tempPath, std::ios::binary | std::ios::trunc);
+        fout.write(reinterpret_cast<const char*>(writer.buffer().data()), writer.size());
+        fout.close();
+        if (!fout) {
+            LOG_WARNING("Failed to write LOD cache %s", tempPath.c_str());
+            std::error_code error;
+            std::filesystem::remove(tempPath, error);
+            return false;
+        }
+    }
+
+    std::error_code error;
+    std::filesystem::rename(tempPath, path, error);
+    if (error) {
+        LOG_WARNING("Unable to move LOD cache into place at %s: %s", path.c_str(), error.message().c_str());
+        std::filesystem::remove(tempPath, error);
+        return false;
+    }
+    return true;
+}
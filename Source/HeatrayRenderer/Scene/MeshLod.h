@@ -0,0 +1,64 @@
+//
+//  MeshLod.h
+//  Heatray
+//
+//  Simplified index buffers for the submeshes of a MeshProvider. They index
+//  the same vertex buffers as the full detail submeshes and are traced
+//  instead of them while the camera is moving.
+//
+//
+
+#pragma once
+
+#include "MeshProvider.h"
+
+#include <memory>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+class MeshLod
+{
+public:
+    static constexpr uint32_t kMagic = 0x444F4C48; // 'HLOD'.
+    static constexpr uint32_t kVersion = 1;
+    static constexpr char const * kFileExtension = ".hrlod";
+
+    static constexpr float kDefaultTriangleRatio = 0.25f; // Fraction of the triangles of each submesh to keep.
+    static constexpr float kDefaultMaxError = 0.01f; // Relative to the extent of each submesh.
+    static constexpr size_t kMinTriangleCount = 4096; // Smaller submeshes are always traced at full detail.
+
+    //-------------------------------------------------------------------------
+    // Simplify every triangle submesh of 'provider' with util::simplifyMesh().
+    // Submeshes that share their geometry are only simplified once and
+    // different geometry is simplified in parallel.
+    static std::shared_ptr<MeshLod> generate(MeshProvider& provider, float triangleRatio = kDefaultTriangleRatio,
+                                             float maxError = kDefaultMaxError);
+
+    //-------------------------------------------------------------------------
+    // Key identifying the LODs generated with the default settings for a
+    // scene imported with the scene cache key 'sceneKey'.
+    static uint64_t cacheKey(uint64_t sceneKey);
+
+    //-------------------------------------------------------------------------
+    // Read LODs previously written with write(). Returns nullptr if the file
+    // does not exist, is corrupt or was written with a different key.
+    static std::shared_ptr<MeshLod> load(const std::string& path, uint64_t key);
+    bool write(const std::string& path, uint64_t key) const;
+
+    static constexpr size_t kFullDetail = ~size_t(0);
+
+    struct Submesh {
+        size_t indexBuffer = kFullDetail; // Into indexBuffers(), kFullDetail if the submesh was not simplified.
+        size_t elementCount = 0;
+        IndexType indexType = IndexType::kUInt32;
+    };
+
+    // One entry per submesh of the provider the LODs were generated for.
+    const std::vector<Submesh>& submeshes() const { return m_submeshes; }
+    const std::vector<std::vector<uint8_t>>& indexBuffers() const { return m_indexBuffers; }
+
+private:
+    std::vector<Submesh> m_submeshes;
+    std::vector<std::vector<uint8_t>> m_indexBuffers;
+};
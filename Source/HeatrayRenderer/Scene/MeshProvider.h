@@ -12,15 +12,23 @@
 //  Vertex format is usage-based, and is a list of vertex attributes with
 //  buffer index, type, offset, stride, and size.
 //
+//  Providers can also hand out their data in chunks, each one a range of
+//  submeshes along with the vertex and index buffers only they use. A
+//  consumer that copies one chunk at a time and releases it afterwards
+//  never needs the data of more than one chunk at once.
+//
 //
 
 #pragma once
 
 #include <glm/glm/mat4x4.hpp>
+#include <glm/glm/vec4.hpp>
 
+#include <algorithm>
 #include <stddef.h>
 #include <stdint.h>
 #include <string>
+#include <vector>
 
 enum class DrawMode {
     Triangles,
@@ -38,11 +46,69 @@ enum VertexAttributeUsage {
     VertexAttributeUsageCount,
 };
 
+//-------------------------------------------------------------------------
+// How a provider arranges the attributes of a submesh within its vertex
+// buffers. The VertexAttribute buffer/offset/stride fields always describe
+// the actual arrangement, so consumers do not need to check this.
+enum class VertexLayout {
+    kSeparate,    // One tightly packed buffer per attribute.
+    kInterleaved, // All attributes of a submesh share one buffer, one vertex after another.
+};
+
+//-------------------------------------------------------------------------
+// How a provider encodes vertex attributes. The VertexAttribute type field
+// always describes the actual encoding.
+enum class VertexFormat {
+    kFloat,   // Every attribute is stored as 32bit floats.
+    kCompact, // Octahedral 16bit normals and tangents, 16bit texture coordinates
+              // and no bitangents (they are rebuilt from the normal and tangent).
+};
+
+//-------------------------------------------------------------------------
+// How a provider reorders the triangles and vertices of a submesh while it
+// imports them. The geometry itself is unchanged.
+enum class MeshOptimization {
+    kNone,        // Keep the order of the asset.
+    kVertexCache, // Order triangles for vertex cache reuse, then vertices by first use.
+    kSpatial,     // Order triangles along a Morton curve through their centroids, then vertices by first use.
+};
+
+//-------------------------------------------------------------------------
+// Data type of each component of a vertex attribute. The 16bit types are
+// normalized to [-1, 1] and [0, 1] respectively when read by a shader.
+enum class VertexAttributeType {
+    kFloat,
+    kShort,
+    kUnsignedShort,
+};
+
+//-------------------------------------------------------------------------
+// Data type of the indices of a submesh. 16bit indices halve the size of the
+// index buffer and are used whenever every vertex of the submesh can be
+// addressed with them.
+enum class IndexType {
+    kUInt16,
+    kUInt32,
+};
+
+inline size_t indexSize(IndexType type)
+{
+    return (type == IndexType::kUInt16) ? sizeof(uint16_t) : sizeof(uint32_t);
+}
+
+//-------------------------------------------------------------------------
+// Smallest index type able to address 'vertexCount' vertices.
+inline IndexType indexTypeForVertexCount(size_t vertexCount)
+{
+    return (vertexCount <= size_t(UINT16_MAX) + 1) ? IndexType::kUInt16 : IndexType::kUInt32;
+}
+
 struct VertexAttribute {
     VertexAttributeUsage usage = VertexAttributeUsage_Position;
+    VertexAttributeType type = VertexAttributeType::kFloat;
     int buffer = -1;
     int componentCount = 0;
-    int size = 0;
+    int size = 0; // In bytes, of a single component.
     size_t offset = 0;
     int stride = 0;
 };
@@ -54,14 +120,30 @@ public:
         int vertexAttributeCount = 0;
         VertexAttribute vertexAttributes[VertexAttributeUsageCount];
         size_t indexBuffer = 0;
-        size_t indexOffset = 0;
+        size_t indexOffset = 0; // In bytes.
         size_t elementCount = 0;
+        IndexType indexType = IndexType::kUInt32;
         DrawMode drawMode = DrawMode::Triangles;
         int materialIndex = -1;
         glm::mat4 localTransform = glm::mat4(1.0f);
+        glm::vec4 texCoordTransform = glm::vec4(1.0f, 1.0f, 0.0f, 0.0f); // Scale (xy) and offset (zw) applied to the texture coordinates by the shader, e.g. to restore quantized ones.
         std::string name;
     };
 
+    // Submeshes [firstSubmesh, firstSubmesh + submeshCount) only use vertex
+    // buffers [firstVertexBuffer, firstVertexBuffer + vertexBufferCount) and
+    // index buffers [firstIndexBuffer, firstIndexBuffer + indexBufferCount),
+    // and no other chunk uses those buffers. Chunks are in submesh order and
+    // together cover every submesh and buffer of the provider.
+    struct Chunk {
+        size_t firstSubmesh = 0;
+        size_t submeshCount = 0;
+        size_t firstVertexBuffer = 0;
+        size_t vertexBufferCount = 0;
+        size_t firstIndexBuffer = 0;
+        size_t indexBufferCount = 0;
+    };
+
     explicit MeshProvider(const std::string_view name) : m_name(name) {}
     virtual ~MeshProvider() {}
     virtual size_t GetVertexBufferCount() = 0;
@@ -75,7 +157,85 @@ public:
     virtual size_t GetSubmeshCount() = 0;
     virtual Submesh GetSubmesh(size_t submeshIndex) = 0;
 
+    //-------------------------------------------------------------------------
+    // The whole provider is a single chunk unless SplitIntoChunks() was called.
+    size_t GetChunkCount() { return m_chunks.empty() ? 1 : m_chunks.size(); }
+    Chunk GetChunk(size_t chunkIndex)
+    {
+        return m_chunks.empty() ? Chunk{ 0, GetSubmeshCount(), 0, GetVertexBufferCount(), 0, GetIndexBufferCount() } : m_chunks[chunkIndex];
+    }
+
+    //-------------------------------------------------------------------------
+    // Called once the buffers of chunk 'chunkIndex' have been filled and will
+    // not be asked for again, so that the provider can drop its copy of them.
+    virtual void ReleaseChunk(size_t /*chunkIndex*/) {}
+
     const std::string_view name() { return m_name; }
 protected:
+    //-------------------------------------------------------------------------
+    // Group the submeshes into chunks of at least 'byteBudget' bytes of
+    // vertex and index data, where the buffers they use allow it. Submeshes
+    // that share buffers with a later submesh (e.g. instances) stay in the
+    // same chunk as it. Must be called once all submeshes are known.
+    void SplitIntoChunks(size_t byteBudget)
+    {
+        m_chunks.clear();
+        const size_t submeshCount = GetSubmeshCount();
+        const size_t vertexBufferCount = GetVertexBufferCount();
+        const size_t indexBufferCount = GetIndexBufferCount();
+
+        // Buffers used by each submesh as half open ranges.
+        std::vector<size_t> firstVertexBuffers(submeshCount), endVertexBuffers(submeshCount), indexBuffers(submeshCount);
+        for (size_t ii = 0; ii < submeshCount; ++ii) {
+            const Submesh submesh = GetSubmesh(ii);
+            firstVertexBuffers[ii] = vertexBufferCount;
+            endVertexBuffers[ii] = 0;
+            for (int jj = 0; jj < submesh.vertexAttributeCount; ++jj) {
+                firstVertexBuffers[ii] = std::min(firstVertexBuffers[ii], size_t(submesh.vertexAttributes[jj].buffer));
+                endVertexBuffers[ii] = std::max(endVertexBuffers[ii], size_t(submesh.vertexAttributes[jj].buffer) + 1);
+            }
+            indexBuffers[ii] = submesh.indexBuffer;
+        }
+
+        // Lowest buffers used by any submesh from 'ii' on, a chunk can only end where none of them reach back into it.
+        std::vector<size_t> laterVertexBuffers(submeshCount + 1, vertexBufferCount), laterIndexBuffers(submeshCount + 1, indexBufferCount);
+        for (size_t ii = submeshCount; ii-- > 0;) {
+            laterVertexBuffers[ii] = std::min(laterVertexBuffers[ii + 1], firstVertexBuffers[ii]);
+            laterIndexBuffers[ii] = std::min(laterIndexBuffers[ii + 1], indexBuffers[ii]);
+        }
+
+        Chunk chunk;
+        size_t endVertexBuffer = 0;
+        size_t endIndexBuffer = 0;
+        size_t chunkBytes = 0;
+        for (size_t ii = 0; ii < submeshCount; ++ii) {
+            for (; endVertexBuffer < endVertexBuffers[ii]; ++endVertexBuffer) {
+                chunkBytes += GetVertexBufferSize(endVertexBuffer);
+            }
+            for (; endIndexBuffer < indexBuffers[ii] + 1; ++endIndexBuffer) {
+                chunkBytes += GetIndexBufferSize(endIndexBuffer);
+            }
+            ++chunk.submeshCount;
+
+            const bool lastSubmesh = (ii + 1 == submeshCount);
+            if (!lastSubmesh && (chunkBytes >= byteBudget) && (laterVertexBuffers[ii + 1] >= endVertexBuffer) &&
+                (laterIndexBuffers[ii + 1] >= endIndexBuffer)) {
+                chunk.vertexBufferCount = endVertexBuffer - chunk.firstVertexBuffer;
+                chunk.indexBufferCount = endIndexBuffer - chunk.firstIndexBuffer;
+                m_chunks.push_back(chunk);
+                chunk = Chunk{ ii + 1, 0, endVertexBuffer, 0, endIndexBuffer, 0 };
+                chunkBytes = 0;
+            }
+        }
+
+        // The last chunk takes any buffers no submesh refers to.
+        chunk.vertexBufferCount = vertexBufferCount - chunk.firstVertexBuffer;
+        chunk.indexBufferCount = indexBufferCount - chunk.firstIndexBuffer;
+        m_chunks.push_back(chunk);
+    }
+
     const std::string m_name;
+
+private:
+    std::vector<Chunk> m_chunks; // Empty if the provider is a single chunk.
 };
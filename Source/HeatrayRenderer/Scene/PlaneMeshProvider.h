@@ -83,15 +83,14 @@ public:
     size_t GetIndexBufferCount() override { return 1; }
     size_t GetIndexBufferSize(size_t bufferIndex) override
     {
-        return 4 * sizeof(int);
+        return 4 * sizeof(uint16_t);
     }
     void FillIndexBuffer(size_t bufferIndex, uint8_t* buffer) override
     {
         assert(buffer);
         // All buffers use the same layout.
-        int indices[4] = { 0, 1, 3, 2 };
-        int* intPtr = reinterpret_cast<int*>(buffer);
-        memcpy(intPtr, indices, GetIndexBufferSize(bufferIndex));
+        uint16_t indices[4] = { 0, 1, 3, 2 };
+        memcpy(buffer, indices, GetIndexBufferSize(bufferIndex));
     }
 
     size_t GetSubmeshCount() override
@@ -129,6 +128,7 @@ public:
         submesh.indexOffset = 0;
         size_t triangleCount = 2;
         submesh.elementCount = 4;
+        submesh.indexType = IndexType::kUInt16;
 
         submesh.drawMode = DrawMode::TriangleStrip;
         submesh.localTransform = glm::mat4(1.0f); // identity.
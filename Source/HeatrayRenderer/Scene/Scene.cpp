@@ -1,59 +1,385 @@
 #include "Scene.h"
 
 #include "AssimpMeshProvider.h"
+#include "GltfMeshProvider.h"
+#include "MeshLod.h"
 #include "MeshProvider.h"
+#include "SceneCacheMeshProvider.h"
 
 #include <HeatrayRenderer/Materials/Material.h>
 #include <RLWrapper/Program.h>
+#include <Utility/Hash.h>
+#include <Utility/Log.h>
+#include <Utility/TextureCache.h>
+#include <Utility/Timer.h>
+
+#include <algorithm>
+#include <filesystem>
+#include <string>
 
 std::shared_ptr<Scene> Scene::create()
 {
 	return std::shared_ptr<Scene>(new Scene());
 }
 
-void Scene::loadFromDisk(const std::string_view path, bool convertToMeters)
+std::shared_ptr<Scene> Scene::createSibling() const
 {
-	m_lighting->clearAllButEnvironment();
+	std::shared_ptr<Scene> scene(new Scene(m_lighting));
+	scene->m_newProgramCreatedCallback = m_newProgramCreatedCallback;
+	scene->m_textureLoadOptions = m_textureLoadOptions;
+	return scene;
+}
+
+void Scene::loadFromDisk(const std::string_view path, bool convertToMeters, VertexLayout vertexLayout, VertexFormat vertexFormat,
+                         MeshOptimization meshOptimization, bool useSceneCache, bool generateLods)
+{
+	// The textures are decoded while they are uploaded by addImport() rather than prefetched.
+	addImport(*importMesh(path, convertToMeters, vertexLayout, vertexFormat, meshOptimization, useSceneCache, generateLods,
+	                      m_textureLoadOptions, nullptr));
+}
+
+std::shared_ptr<SceneImport> Scene::importFromDisk(const std::string_view path, bool convertToMeters, VertexLayout vertexLayout, VertexFormat vertexFormat,
+                                                   MeshOptimization meshOptimization, bool useSceneCache, bool generateLods,
+                                                   const util::TextureLoadOptions &textureOptions, uint64_t loadGeneration,
+                                                   SceneLoadProgress *progress)
+{
+	std::shared_ptr<SceneImport> sceneImport = importMesh(path, convertToMeters, vertexLayout, vertexFormat, meshOptimization, useSceneCache,
+	                                                      generateLods, textureOptions, progress);
+	if (sceneImport->provider->GetSubmeshCount() == 0) {
+		return sceneImport;
+	}
+
+	// Decode the textures now so that only the uploads are left for the OpenRL thread. Only as many as fit the prefetch
+	// budget of the texture cache are held until addImport(), which decodes the rest while uploading them.
+	const std::string assetDirectory = std::filesystem::path(path).parent_path().string();
+	std::vector<util::TextureLoadRequest> textureRequests = materialTextureRequests(sceneImport->materialRecords, assetDirectory, textureOptions);
+	if (progress) {
+		progress->textureCount = uint32_t(textureRequests.size());
+		progress->stage = SceneLoadProgress::Stage::kDecodingTextures;
+	}
+
+	util::TextureCache::instance().prefetch(textureRequests, loadGeneration, [progress](size_t /*index*/, size_t byteCount) {
+		if (progress) {
+			progress->bytesLoaded += byteCount;
+			++progress->texturesDecoded;
+		}
+	});
+
+	return sceneImport;
+}
+
+std::shared_ptr<SceneImport> Scene::importMesh(const std::string_view path, bool convertToMeters, VertexLayout vertexLayout, VertexFormat vertexFormat,
+                                               MeshOptimization meshOptimization, bool useSceneCache, bool generateLods,
+                                               const util::TextureLoadOptions &textureOptions, SceneLoadProgress *progress)
+{
+	util::Timer timer(true);
+
+	std::shared_ptr<SceneImport> sceneImport = std::make_shared<SceneImport>();
+	sceneImport->path = std::string(path);
+	sceneImport->textureOptions = textureOptions;
+	if (progress) {
+		progress->stage = SceneLoadProgress::Stage::kImporting;
+	}
+
+	// glTF assets are memory mapped and used in place, which is faster than both Assimp and the scene cache.
+	// The vertex data is used as stored in the asset so this is skipped if a compact format or reordering was requested.
+	if (GltfMeshProvider::isGltf(path) && (vertexFormat == VertexFormat::kFloat) && (meshOptimization == MeshOptimization::kNone)) {
+		std::unique_ptr<GltfMeshProvider> gltf = std::make_unique<GltfMeshProvider>(path);
+		if (gltf->open(path, convertToMeters)) {
+			sceneImport->materialRecords = gltf->materialRecords();
+			sceneImport->lightRecords = gltf->lightRecords();
+			sceneImport->aabb = gltf->sceneAABB();
+			sceneImport->provider = std::move(gltf);
+			LOG_INFO("Imported %s natively in %f seconds", std::string(path).c_str(), timer.stop());
+		} else {
+			LOG_INFO("Falling back to Assimp for %s", std::string(path).c_str());
+		}
+	}
+
+	// Reuse the preprocessed scene from a previous load if neither the asset nor the import settings have changed.
+	const std::string cachePath = useSceneCache ? SceneCacheMeshProvider::cachePath(path) : std::string();
+	const uint64_t cacheKey = useSceneCache ? SceneCacheMeshProvider::cacheKey(path, AssimpMeshProvider::postProcessFlags(), convertToMeters,
+	                                                                           vertexLayout, vertexFormat, meshOptimization) : 0;
+	bool importedFromCache = false;
+	if (!sceneImport->provider && useSceneCache) {
+		std::unique_ptr<SceneCacheMeshProvider> cache = std::make_unique<SceneCacheMeshProvider>(path);
+		if (cache->open(cachePath, cacheKey)) {
+			sceneImport->materialRecords = cache->materialRecords();
+			sceneImport->lightRecords = cache->lightRecords();
+			sceneImport->aabb = cache->sceneAABB();
+			sceneImport->provider = std::move(cache);
+			importedFromCache = true;
+			LOG_INFO("Imported %s from the scene cache in %f seconds", std::string(path).c_str(), timer.stop());
+		}
+	}
 
 	// We use Assimp to load scene data from disk.
-	AssimpMeshProvider provider(path, convertToMeters, m_lighting);
-	m_aabb = provider.sceneAABB();
+	if (!sceneImport->provider) {
+		std::unique_ptr<AssimpMeshProvider> provider = std::make_unique<AssimpMeshProvider>(path, convertToMeters, vertexLayout, vertexFormat, meshOptimization);
+		if (useSceneCache && (cacheKey != 0) && (provider->GetSubmeshCount() > 0)) {
+			SceneCacheMeshProvider::write(cachePath, cacheKey, path, provider->importedFiles(), *provider, provider->materialRecords(),
+			                              provider->lightRecords(), provider->sceneAABB());
+		}
 
-	auto &materials = provider.GetMaterials();
-	Mesh mesh(&provider, materials, m_newProgramCreatedCallback, glm::mat4(1.0f));
-	bindLighting(mesh);
-	
-	m_meshes.emplace_back(std::move(mesh));
+		sceneImport->materialRecords = provider->materialRecords();
+		sceneImport->lightRecords = provider->lightRecords();
+		sceneImport->aabb = provider->sceneAABB();
+		sceneImport->provider = std::move(provider);
+		LOG_INFO("Imported %s with Assimp in %f seconds", std::string(path).c_str(), timer.stop());
+	}
+
+	// The simplified meshes are cached alongside the scene cache and invalidated by the same changes. Changes to the
+	// files the asset depends on are only detected by the scene cache, so they are regenerated whenever it was rebuilt.
+	if (generateLods && (sceneImport->provider->GetSubmeshCount() > 0)) {
+		const std::string lodPath = (cacheKey != 0) ? SceneCacheMeshProvider::cachePath(path, MeshLod::kFileExtension) : std::string();
+		const uint64_t lodKey = (cacheKey != 0) ? MeshLod::cacheKey(cacheKey) : 0;
+		if ((lodKey != 0) && importedFromCache) {
+			sceneImport->lod = MeshLod::load(lodPath, lodKey);
+		}
+		if (!sceneImport->lod) {
+			sceneImport->lod = MeshLod::generate(*(sceneImport->provider));
+			if (lodKey != 0) {
+				sceneImport->lod->write(lodPath, lodKey);
+			}
+		}
+	}
+
+	if (progress) {
+		MeshProvider &provider = *(sceneImport->provider);
+		uint64_t geometryBytes = 0;
+		for (size_t ii = 0; ii < provider.GetVertexBufferCount(); ++ii) {
+			geometryBytes += provider.GetVertexBufferSize(ii);
+		}
+		for (size_t ii = 0; ii < provider.GetIndexBufferCount(); ++ii) {
+			geometryBytes += provider.GetIndexBufferSize(ii);
+		}
+		progress->meshCount = uint32_t(provider.GetSubmeshCount());
+		progress->bytesLoaded += geometryBytes;
+	}
+
+	return sceneImport;
+}
+
+void Scene::addImport(const SceneImport &sceneImport)
+{
+	// The import is only referenced until this call returns, so the pointer doesn't own it.
+	replaceLights(sceneImport.lightRecords);
+	beginImport(std::shared_ptr<const SceneImport>(std::shared_ptr<const SceneImport>(), &sceneImport));
+	while (!continueImport()) {}
+}
+
+void Scene::beginImport(std::shared_ptr<const SceneImport> sceneImport)
+{
+	m_import.reset();
+
+	m_importTimer = util::Timer(true);
+	const std::string assetDirectory = std::filesystem::path(sceneImport->path).parent_path().string();
+
+	m_aabb = sceneImport->aabb;
+
+	std::vector<std::shared_ptr<Material>> materials = createMaterials(sceneImport->materialRecords, assetDirectory, sceneImport->textureOptions);
+	Mesh mesh(sceneImport->provider.get(), materials, m_newProgramCreatedCallback, glm::mat4(1.0f), sceneImport->lod.get(),
+	          Mesh::Upload::kChunked);
+	m_importMesh = addMeshNode(std::move(mesh), TransformHierarchy::kRootNode);
+	updateTransforms();
+	m_import = std::move(sceneImport);
+}
+
+bool Scene::continueImport()
+{
+	Mesh *mesh = m_import ? m_meshes.get(m_importMesh) : nullptr;
+	if (!mesh) {
+		m_import.reset();
+		return true;
+	}
+
+	// Only the submeshes of the new chunk need the lighting and transforms.
+	const size_t firstSubmesh = mesh->submeshes().size();
+	mesh->uploadNextChunk(m_newProgramCreatedCallback);
+	bindLighting(*mesh, firstSubmesh);
+	uploadWorldTransform(*mesh, m_transforms.worldTransform(m_meshNodes[m_importMesh.index]), firstSubmesh);
+	if (!mesh->complete()) {
+		return false;
+	}
+
+	LOG_INFO("Created the OpenRL resources for %s in %f seconds", m_import->path.c_str(), m_importTimer.stop());
+	m_import.reset();
+
+	// Textures from previously loaded scenes stay cached until now so that reloading a scene can reuse them.
+	util::TextureCache::instance().releaseUnused();
+	return true;
 }
 
-size_t Scene::addMesh(MeshProvider *meshProvider, std::vector<std::shared_ptr<Material>>&& materials, const glm::mat4& transform)
+void Scene::replaceLights(const std::vector<LightRecord> &lightRecords)
+{
+	m_lighting->clearAllButEnvironment();
+	addLights(lightRecords, m_lighting);
+}
+
+Scene::MeshHandle Scene::addMesh(MeshProvider *meshProvider, std::vector<std::shared_ptr<Material>>&& materials, const glm::mat4& transform,
+                                 NodeIndex parent)
 {
 	Mesh mesh(meshProvider, materials, m_newProgramCreatedCallback, transform);
 	bindLighting(mesh);
 	
-	m_meshes.emplace_back(std::move(mesh));
-	return (m_meshes.size() - 1);
+	MeshHandle handle = addMeshNode(std::move(mesh), parent);
+	updateTransforms();
+	return handle;
+}
+
+Scene::MeshHandle Scene::addMeshNode(Mesh &&mesh, NodeIndex parent)
+{
+	// The transform passed to the mesh is already part of its submesh transforms so the node itself starts out as identity.
+	MeshHandle handle = m_meshes.emplace(std::move(mesh));
+	NodeIndex node = m_transforms.addNode(parent, glm::mat4(1.0f));
+	m_nodeMeshes.resize(m_transforms.nodeCount());
+	m_nodeMeshes[node] = handle;
+	m_meshNodes.resize(std::max(m_meshNodes.size(), size_t(handle.index) + 1), TransformHierarchy::kInvalidNode);
+	m_meshNodes[handle.index] = node;
+	return handle;
+}
+
+void Scene::removeMesh(MeshHandle mesh)
+{
+	if (!m_meshes.erase(mesh)) {
+		return;
+	}
+
+	// Mesh nodes never have children, so the node can always be freed. Toggling the ground plane or swapping
+	// meshes in and out therefore reuses the same nodes rather than growing the hierarchy.
+	const NodeIndex node = m_meshNodes[mesh.index];
+	m_transforms.removeNode(node);
+	m_nodeMeshes[node] = MeshHandle();
+	m_meshNodes[mesh.index] = TransformHierarchy::kInvalidNode;
+}
+
+Scene::NodeIndex Scene::addTransformNode(NodeIndex parent, const glm::mat4 &localTransform)
+{
+	NodeIndex node = m_transforms.addNode(parent, localTransform);
+	m_nodeMeshes.resize(m_transforms.nodeCount());
+	return node;
+}
+
+void Scene::updateTransforms()
+{
+	for (NodeIndex node : m_transforms.update()) {
+		// Nodes added with addTransformNode() have no mesh.
+		const Mesh *mesh = m_meshes.get(m_nodeMeshes[node]);
+		if (!mesh) {
+			continue;
+		}
+
+		uploadWorldTransform(*mesh, m_transforms.worldTransform(node));
+	}
+}
+
+void Scene::uploadWorldTransform(const Mesh &mesh, const glm::mat4 &worldTransform, size_t firstSubmesh)
+{
+	for (size_t ii = firstSubmesh; ii < mesh.submeshes().size(); ++ii) {
+		const Mesh::Submesh &submesh = mesh.submeshes()[ii];
+		const openrl::UniformHandle worldFromEntity = submesh.material->uniforms().worldFromEntity;
+		glm::mat4 newTransform = worldTransform * submesh.transform;
+		submesh.primitive->bind();
+		submesh.material->program()->setMatrix4fv(worldFromEntity, &(newTransform[0][0]));
+		submesh.primitive->unbind();
+
+		if (submesh.simplifiedPrimitive) {
+			submesh.simplifiedPrimitive->bind();
+			submesh.material->program()->setMatrix4fv(worldFromEntity, &(newTransform[0][0]));
+			submesh.simplifiedPrimitive->unbind();
+		}
+	}
 }
 
 void Scene::applyTransform(const glm::mat4 &transform)
 {
-	for (auto &mesh : m_meshes) {
-		for (auto &submesh : mesh.submeshes()) {
-			submesh.primitive->bind();
-			int worldFromEntityLocation = submesh.material->program()->getUniformLocation("worldFromEntity");
-			glm::mat4 newTransform = transform * submesh.transform;
-			submesh.material->program()->setMatrix4fv(worldFromEntityLocation, &(newTransform[0][0]));
-			submesh.primitive->unbind();
+	m_transforms.setLocalTransform(TransformHierarchy::kRootNode, transform);
+	updateTransforms();
+}
+
+void Scene::reloadShaders(const std::vector<std::string> &shaders)
+{
+	// Materials can be shared by several meshes, each one is only rebuilt once.
+	std::vector<std::shared_ptr<Material>> rebuiltMaterials;
+	std::vector<std::shared_ptr<Material>> failedMaterials;
+	for (NodeIndex node = 0; node < m_nodeMeshes.size(); ++node) {
+		Mesh *mesh = m_meshes.get(m_nodeMeshes[node]);
+		if (!mesh) {
+			continue;
 		}
+
+		std::vector<std::shared_ptr<Material>> meshMaterials;
+		for (const std::shared_ptr<Material> &material : mesh->materials()) {
+			if (std::find(rebuiltMaterials.begin(), rebuiltMaterials.end(), material) != rebuiltMaterials.end()) {
+				meshMaterials.push_back(material);
+			} else if (std::find(failedMaterials.begin(), failedMaterials.end(), material) != failedMaterials.end()) {
+				continue;
+			} else if (std::any_of(shaders.begin(), shaders.end(), [&](const std::string &shader) { return material->usesShader(shader); })) {
+				LOG_INFO("Rebuilding material %s", std::string(material->name()).c_str());
+				if (material->rebuild()) {
+					rebuiltMaterials.push_back(material);
+					meshMaterials.push_back(material);
+				} else {
+					// The primitives keep using the previous program.
+					LOG_ERROR("Unable to rebuild material %s, keeping the previous program", std::string(material->name()).c_str());
+					failedMaterials.push_back(material);
+				}
+			}
+		}
+		if (meshMaterials.empty()) {
+			continue;
+		}
+
+		mesh->rebuildPrimitives(meshMaterials, m_newProgramCreatedCallback);
+		bindLighting(*mesh);
+
+		// The new primitives start out with the transform the mesh was created with, re-upload the world transform.
+		m_transforms.setLocalTransform(node, m_transforms.localTransform(node));
+	}
+	updateTransforms();
+}
+
+uint64_t Scene::stateHash() const
+{
+	uint64_t hash = util::hashCombine(util::FNV1a(m_aabb.min), util::FNV1a(m_aabb.max));
+	auto combine = [&hash](uint64_t value) { hash = util::hashCombine(hash, value); };
+
+	combine(m_lighting->stateHash());
+	combine(util::FNV1a(m_meshes.size()));
+
+	// Nodes are visited in creation order, which does not depend on where the meshes ended up in the slot map.
+	for (NodeIndex node = 0; node < m_nodeMeshes.size(); ++node) {
+		const Mesh *mesh = m_meshes.get(m_nodeMeshes[node]);
+		if (!mesh) {
+			continue;
+		}
+
+		combine(util::FNV1a(m_transforms.worldTransform(node)));
+		combine(util::FNV1a(mesh->submeshes().size()));
+		for (const std::shared_ptr<Material> &material : mesh->materials()) {
+			combine(material->parameterHash());
+		}
+	}
+
+	return hash;
+}
+
+bool Scene::setSimplified(bool simplified)
+{
+	bool hasSimplifiedMeshes = false;
+	for (auto &mesh : m_meshes) {
+		hasSimplifiedMeshes |= mesh.setSimplified(simplified);
 	}
+	return hasSimplifiedMeshes;
 }
 
-void Scene::bindLighting(const Mesh& mesh)
+void Scene::bindLighting(const Mesh& mesh, size_t firstSubmesh)
 {
 	// Ensure any newly created programs are setup to bind scene lighting data.
-	for (auto& submesh : mesh.submeshes()) {
+	for (size_t ii = firstSubmesh; ii < mesh.submeshes().size(); ++ii) {
+		const Mesh::Submesh &submesh = mesh.submeshes()[ii];
 		submesh.primitive->bind();
-		m_lighting->bindLightingBuffersToProgram(submesh.material->program());
+		m_lighting->bindLightingBuffersToProgram(*submesh.material->program(), submesh.material->uniforms().lighting);
 		submesh.primitive->unbind();
 	}
 }
@@ -10,12 +10,21 @@
 
 #include "Lighting.h"
 #include "Mesh.h"
+#include "MeshProvider.h"
+#include "SceneLoadProgress.h"
+#include "SceneRecords.h"
+#include "TransformHierarchy.h"
 
 #include <Utility/AABB.h>
+#include <Utility/SlotMap.h>
+#include <Utility/TextureLoader.h>
+#include <Utility/Timer.h>
 
 #include <glm/glm/mat4x4.hpp>
 
 #include <functional>
+#include <memory>
+#include <string>
 #include <string_view>
 #include <vector>
 
@@ -24,13 +33,34 @@ namespace openrl {
 class Program;
 } // namespace openrl.
 class Material;
+class MeshLod;
 class MeshProvider;
 
+//-------------------------------------------------------------------------
+// An asset that has been read from disk but not turned into OpenRL objects
+// yet. Created by Scene::importFromDisk() on any thread and added to a scene
+// with Scene::addImport() on the OpenRL thread.
+struct SceneImport {
+	std::string path;
+	std::unique_ptr<MeshProvider> provider; // Owns the geometry (or the mapping of the asset it is read from).
+	std::shared_ptr<MeshLod> lod; // Simplified submeshes of 'provider', nullptr if they were not requested.
+	std::vector<MaterialRecord> materialRecords;
+	std::vector<LightRecord> lightRecords;
+	util::AABB aabb;
+	util::TextureLoadOptions textureOptions;
+};
+
 class Scene
 {
 public:
 	static std::shared_ptr<Scene> create();
-	~Scene() { clearAll(); }
+	~Scene() { clearMeshesAndMaterials(); } // The lighting is released by its last owner, see createSibling().
+
+	//-------------------------------------------------------------------------
+	// Create an empty scene that shares the lighting, new program callback
+	// and texture load options of this one. A scene built in the background
+	// this way can replace this one without rebinding any lighting buffers.
+	std::shared_ptr<Scene> createSibling() const;
 
 	//-------------------------------------------------------------------------
 	// When new programs are created, this callback will be invoked to ensure
@@ -40,24 +70,121 @@ public:
 
 	//-------------------------------------------------------------------------
 	// Load a mesh from disk. It is recommended to use this function instead
-	// of the AssimpMeshProvider directly.
-	void loadFromDisk(const std::string_view path, bool convertToMeters);
+	// of the AssimpMeshProvider directly. If 'useSceneCache' is true then the
+	// imported scene is cached in the user cache directory and subsequent
+	// loads of the unchanged asset bypass Assimp. VertexFormat::kCompact quantizes the
+	// vertex attributes to reduce the memory used by large scenes and
+	// 'meshOptimization' reorders the triangles and vertices of every mesh.
+	// 'generateLods' builds simplified versions of the larger meshes for
+	// setSimplified(), they are cached along with the scene cache.
+	void loadFromDisk(const std::string_view path, bool convertToMeters, VertexLayout vertexLayout = VertexLayout::kInterleaved,
+	                  VertexFormat vertexFormat = VertexFormat::kFloat, MeshOptimization meshOptimization = MeshOptimization::kNone,
+	                  bool useSceneCache = true, bool generateLods = false);
+
+	//-------------------------------------------------------------------------
+	// Read a mesh from disk without creating any OpenRL objects so that this
+	// can happen on a separate thread while the current scene keeps rendering.
+	// The textures referenced by its materials are decoded with
+	// 'textureOptions' as well so that addImport() only needs to upload them,
+	// which keeps all of them in memory until then. They are prefetched for
+	// 'loadGeneration' and stay cached until util::TextureCache::releasePrefetched()
+	// is called for it.
+	// 'progress' (optional) is updated as the import advances. Never returns
+	// nullptr, a failed import holds no submeshes.
+	static std::shared_ptr<SceneImport> importFromDisk(const std::string_view path, bool convertToMeters, VertexLayout vertexLayout,
+	                                                   VertexFormat vertexFormat, MeshOptimization meshOptimization, bool useSceneCache,
+	                                                   bool generateLods, const util::TextureLoadOptions &textureOptions,
+	                                                   uint64_t loadGeneration, SceneLoadProgress *progress = nullptr);
+
+	//-------------------------------------------------------------------------
+	// Replace the non-environment lighting and scene bounds with those of
+	// 'sceneImport' and add its mesh to the scene. Must be called on the
+	// OpenRL thread.
+	void addImport(const SceneImport &sceneImport);
+
+	//-------------------------------------------------------------------------
+	// Add the mesh of an import in steps so that other work on the OpenRL
+	// thread can run in between, e.g. into a scene from createSibling() that
+	// is only swapped in once complete. beginImport() replaces the scene
+	// bounds, creates the materials (uploading their textures) and adds an
+	// empty mesh for 'sceneImport'. Each call to continueImport() then uploads
+	// the next chunk of its provider (see MeshProvider::GetChunk()) and
+	// returns true once the import has been added completely. Beginning
+	// another import or clearing the meshes ends a pending import, keeping the
+	// submeshes added so far. Neither touches the lighting, see replaceLights().
+	void beginImport(std::shared_ptr<const SceneImport> sceneImport);
+	bool continueImport();
+
+	//-------------------------------------------------------------------------
+	// Replace the non-environment lights with 'lightRecords', e.g. those of an
+	// import. Scenes from createSibling() share their lights.
+	void replaceLights(const std::vector<LightRecord> &lightRecords);
+
+	//-------------------------------------------------------------------------
+	// Options used for every texture loaded by loadFromDisk(), e.g. to cap the
+	// resolution of very large textures.
+	void setTextureLoadOptions(const util::TextureLoadOptions &options) { m_textureLoadOptions = options; }
 
 	//-------------------------------------------------------------------------
 	// Add a new mesh to the scene via the various supported MeshProviders.
-	// Returns an index where this mesh is placed within the internal list of
-	// meshes.
-	size_t addMesh(MeshProvider *meshProvider, std::vector<std::shared_ptr<Material>> &&materials, const glm::mat4 &transform);
+	// Returns a handle that identifies this mesh until it is removed, adding
+	// or removing other meshes does not affect it. The mesh is placed below
+	// the transform node 'parent', see addTransformNode().
+	using Meshes = util::SlotMap<Mesh>;
+	using MeshHandle = Meshes::Handle;
+	using NodeIndex = TransformHierarchy::NodeIndex;
+	MeshHandle addMesh(MeshProvider *meshProvider, std::vector<std::shared_ptr<Material>> &&materials, const glm::mat4 &transform,
+	                   NodeIndex parent = TransformHierarchy::kRootNode);
+
+	//-------------------------------------------------------------------------
+	// Erase an already-created mesh based on the handle returned from addMesh().
+	// Handles of meshes that were already removed (or cleared) are ignored. The
+	// transform node of the mesh is freed for the next mesh to reuse.
+	void removeMesh(MeshHandle mesh);
 
 	//-------------------------------------------------------------------------
-	// Erase an already-created mesh based on the index returned from addMesh().
-	void removeMesh(size_t meshIndex) { m_meshes.erase(m_meshes.begin() + meshIndex); }
+	// Add a node to the transform hierarchy of the scene so that all meshes
+	// below it can be moved together. Every mesh hangs off the root node
+	// unless it is given a different parent.
+	NodeIndex addTransformNode(NodeIndex parent, const glm::mat4 &localTransform);
+
+	//-------------------------------------------------------------------------
+	// Move a node relative to its parent. Changes are batched until
+	// updateTransforms(), which only re-uploads the transforms of meshes
+	// below the nodes that changed.
+	void setTransform(NodeIndex node, const glm::mat4 &localTransform) { m_transforms.setLocalTransform(node, localTransform); }
+	void updateTransforms();
 
 	//-------------------------------------------------------------------------
 	// Apply a transform to the scene that will affect all mesh objects.
-    void applyTransform(const glm::mat4 &transform);
+	void applyTransform(const glm::mat4 &transform);
+
+	//-------------------------------------------------------------------------
+	// Rebuild the materials whose programs are built from any of the shader
+	// files 'shaders' and recreate the primitives that use them so that
+	// edited shaders take effect without reloading the scene. Must be called
+	// on the OpenRL thread.
+	void reloadShaders(const std::vector<std::string> &shaders);
 
-	void clearMeshesAndMaterials() { m_meshes.clear(); }
+	//-------------------------------------------------------------------------
+	// Hash of the scene contents that affect the rendered image: the meshes
+	// with their transforms and material parameters, the lighting and the
+	// scene bounds. Geometry is identified by its submesh counts rather than
+	// its contents. Stable between runs of Heatray.
+	uint64_t stateHash() const;
+
+	//-------------------------------------------------------------------------
+	// Trace the simplified meshes generated at load time instead of the full
+	// detail ones. Returns false if the scene has no simplified meshes.
+	bool setSimplified(bool simplified);
+
+	void clearMeshesAndMaterials() {
+		m_import.reset();
+		m_meshes.clear();
+		m_transforms.clear();
+		m_nodeMeshes.assign(1, MeshHandle());
+		m_meshNodes.clear();
+	}
 	void clearLighting() { m_lighting->clear(); }
 	void clearAll() {
 		clearMeshesAndMaterials();
@@ -65,7 +192,7 @@ public:
 	}
 
 	std::shared_ptr<Lighting> lighting() { return m_lighting; }
-	const std::vector<Mesh> &meshes() { return m_meshes; }
+	const Meshes &meshes() { return m_meshes; }
 
 	const util::AABB &aabb() const { return m_aabb; }
 
@@ -73,12 +200,27 @@ private:
 	Scene() {
 		m_lighting = std::shared_ptr<Lighting>(new Lighting);
 	}
-	void bindLighting(const Mesh &mesh);
-
-	std::vector<Mesh> m_meshes;
+	explicit Scene(std::shared_ptr<Lighting> lighting) : m_lighting(std::move(lighting)) {}
+	void bindLighting(const Mesh &mesh, size_t firstSubmesh = 0);
+	void uploadWorldTransform(const Mesh &mesh, const glm::mat4 &worldTransform, size_t firstSubmesh = 0);
+	MeshHandle addMeshNode(Mesh &&mesh, NodeIndex parent);
+	static std::shared_ptr<SceneImport> importMesh(const std::string_view path, bool convertToMeters, VertexLayout vertexLayout,
+	                                               VertexFormat vertexFormat, MeshOptimization meshOptimization, bool useSceneCache,
+	                                               bool generateLods, const util::TextureLoadOptions &textureOptions, SceneLoadProgress *progress);
+
+	Meshes m_meshes;
+	TransformHierarchy m_transforms;
+	std::vector<MeshHandle> m_nodeMeshes = { MeshHandle() }; // Mesh attached to each transform node, if any.
+	std::vector<NodeIndex> m_meshNodes; // Transform node of each mesh, indexed by the slot of its handle.
 	std::shared_ptr<Lighting> m_lighting = nullptr;
 
+	// Import that continueImport() is adding, if any, and its mesh.
+	std::shared_ptr<const SceneImport> m_import;
+	MeshHandle m_importMesh;
+	util::Timer m_importTimer;
+
 	NewProgramCreatedCallback m_newProgramCreatedCallback;
 
 	util::AABB m_aabb; // AABB that encapsulates the scene.
+	util::TextureLoadOptions m_textureLoadOptions;
 };
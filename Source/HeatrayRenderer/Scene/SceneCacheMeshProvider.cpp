@@ -0,0 +1,532 @@
+#include "SceneCacheMeshProvider.h"
+
+#include <Utility/BinaryStream.h>
+#include <Utility/FileIO.h>
+#include <Utility/Hash.h>
+#include <Utility/Log.h>
+#include <Utility/Timer.h>
+
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <stdio.h>
+#include <type_traits>
+
+namespace {
+
+constexpr size_t kBufferAlignment = 16; // Alignment of each buffer within the data section.
+
+static_assert(std::is_trivially_copyable_v<DirectionalLight::Params> &&
+              std::is_trivially_copyable_v<PointLight::Params> &&
+              std::is_trivially_copyable_v<SpotLight::Params>, "Light parameters are written to the cache directly");
+
+//-------------------------------------------------------------------------
+// Identifies the current version of a file from its size and modification
+// time without reading it. Returns 0 if the file does not exist.
+uint64_t fileStamp(const std::filesystem::path& path)
+{
+    std::error_code error;
+    const uintmax_t size = std::filesystem::file_size(path, error);
+    if (error) {
+        return 0;
+    }
+    const std::filesystem::file_time_type modifiedTime = std::filesystem::last_write_time(path, error);
+    if (error) {
+        return 0;
+    }
+
+    const uint64_t stamp = util::hashCombine(size_t(size), int64_t(modifiedTime.time_since_epoch().count()));
+    return (stamp != 0) ? stamp : 1;
+}
+
+std::string absolutePath(const std::filesystem::path& path)
+{
+    std::error_code error;
+    const std::filesystem::path absolute = std::filesystem::absolute(path, error);
+    return (error ? path : absolute).lexically_normal().string();
+}
+
+void writeSubmesh(util::BinaryWriter& writer, const MeshProvider::Submesh& submesh)
+{
+    writer.write(int32_t(submesh.vertexAttributeCount));
+    for (int ii = 0; ii < submesh.vertexAttributeCount; ++ii) {
+        const VertexAttribute& attribute = submesh.vertexAttributes[ii];
+        writer.write(uint32_t(attribute.usage));
+        writer.write(uint32_t(attribute.type));
+        writer.write(int32_t(attribute.buffer));
+        writer.write(int32_t(attribute.componentCount));
+        writer.write(int32_t(attribute.size));
+        writer.write(uint64_t(attribute.offset));
+        writer.write(int32_t(attribute.stride));
+    }
+    writer.write(uint64_t(submesh.indexBuffer));
+    writer.write(uint64_t(submesh.indexOffset));
+    writer.write(uint64_t(submesh.elementCount));
+    writer.write(uint32_t(submesh.indexType));
+    writer.write(uint32_t(submesh.drawMode));
+    writer.write(int32_t(submesh.materialIndex));
+    writer.write(submesh.localTransform);
+    writer.write(submesh.texCoordTransform);
+    writer.writeString(submesh.name);
+}
+
+bool readSubmesh(util::BinaryReader& reader, MeshProvider::Submesh& submesh)
+{
+    int32_t attributeCount = 0;
+    if (!reader.read(attributeCount) || (attributeCount < 0) || (attributeCount > VertexAttributeUsageCount)) {
+        return false;
+    }
+    submesh.vertexAttributeCount = attributeCount;
+    for (int ii = 0; ii < attributeCount; ++ii) {
+        VertexAttribute& attribute = submesh.vertexAttributes[ii];
+        uint32_t usage = 0, type = 0;
+        int32_t buffer = 0, componentCount = 0, size = 0, stride = 0;
+        uint64_t offset = 0;
+        reader.read(usage);
+        reader.read(type);
+        reader.read(buffer);
+        reader.read(componentCount);
+        reader.read(size);
+        reader.read(offset);
+        reader.read(stride);
+        if ((usage >= VertexAttributeUsageCount) || (type > uint32_t(VertexAttributeType::kUnsignedShort))) {
+            return false;
+        }
+        attribute.usage = VertexAttributeUsage(usage);
+        attribute.type = VertexAttributeType(type);
+        attribute.buffer = buffer;
+        attribute.componentCount = componentCount;
+        attribute.size = size;
+        attribute.offset = size_t(offset);
+        attribute.stride = stride;
+    }
+
+    uint64_t indexBuffer = 0, indexOffset = 0, elementCount = 0;
+    uint32_t indexType = 0, drawMode = 0;
+    int32_t materialIndex = -1;
+    reader.read(indexBuffer);
+    reader.read(indexOffset);
+    reader.read(elementCount);
+    reader.read(indexType);
+    reader.read(drawMode);
+    reader.read(materialIndex);
+    reader.read(submesh.localTransform);
+    reader.read(submesh.texCoordTransform);
+    reader.readString(submesh.name);
+
+    submesh.indexBuffer = size_t(indexBuffer);
+    submesh.indexOffset = size_t(indexOffset);
+    submesh.elementCount = size_t(elementCount);
+    submesh.indexType = IndexType(indexType);
+    submesh.drawMode = DrawMode(drawMode);
+    submesh.materialIndex = materialIndex;
+    return reader.valid() && (indexType <= uint32_t(IndexType::kUInt32)) && (drawMode <= uint32_t(DrawMode::TriangleStrip));
+}
+
+void writeMaterial(util::BinaryWriter& writer, const MaterialRecord& material)
+{
+    writer.write(uint32_t(material.type));
+    writer.writeString(material.name);
+    writer.write(material.baseColor);
+    writer.write(material.roughness);
+    writer.write(material.emissiveColor);
+    writer.write(material.metallic);
+    writer.write(material.specularF0);
+    writer.write(material.clearCoat);
+    writer.write(material.clearCoatRoughness);
+    writer.write(uint8_t(material.doubleSided));
+    writer.write(uint8_t(material.alphaMask));
+    writer.write(material.ior);
+    writer.write(material.density);
+    writer.write(uint8_t(material.vertexColors));
+
+    writer.write(uint64_t(material.textures.size()));
+    for (const MaterialRecord::Texture& texture : material.textures) {
+        writer.write(uint32_t(texture.slot));
+        writer.writeString(texture.path);
+        writer.write(uint8_t(texture.convertToLinear));
+    }
+}
+
+bool readMaterial(util::BinaryReader& reader, MaterialRecord& material)
+{
+    uint32_t type = 0;
+    uint8_t doubleSided = 0, alphaMask = 0, vertexColors = 0;
+    reader.read(type);
+    reader.readString(material.name);
+    reader.read(material.baseColor);
+    reader.read(material.roughness);
+    reader.read(material.emissiveColor);
+    reader.read(material.metallic);
+    reader.read(material.specularF0);
+    reader.read(material.clearCoat);
+    reader.read(material.clearCoatRoughness);
+    reader.read(doubleSided);
+    reader.read(alphaMask);
+    reader.read(material.ior);
+    reader.read(material.density);
+    reader.read(vertexColors);
+
+    if (type > uint32_t(Material::Type::Glass)) {
+        return false;
+    }
+    material.type = Material::Type(type);
+    material.doubleSided = (doubleSided != 0);
+    material.alphaMask = (alphaMask != 0);
+    material.vertexColors = (vertexColors != 0);
+
+    uint64_t textureCount = 0;
+    if (!reader.read(textureCount) || (textureCount > reader.remaining())) {
+        return false;
+    }
+    material.textures.resize(size_t(textureCount));
+    for (MaterialRecord::Texture& texture : material.textures) {
+        uint32_t slot = 0;
+        uint8_t convertToLinear = 0;
+        reader.read(slot);
+        reader.readString(texture.path);
+        reader.read(convertToLinear);
+        texture.slot = MaterialRecord::TextureSlot(slot);
+        texture.convertToLinear = (convertToLinear != 0);
+    }
+    return reader.valid();
+}
+
+void writeLight(util::BinaryWriter& writer, const LightRecord& light)
+{
+    writer.write(uint32_t(light.type));
+    writer.writeString(light.name);
+    writer.write(light.directional);
+    writer.write(light.point);
+    writer.write(light.spot);
+}
+
+bool readLight(util::BinaryReader& reader, LightRecord& light)
+{
+    uint32_t type = 0;
+    reader.read(type);
+    reader.readString(light.name);
+    reader.read(light.directional);
+    reader.read(light.point);
+    reader.read(light.spot);
+    if (type > uint32_t(Light::Type::kSpot)) {
+        return false;
+    }
+    light.type = Light::Type(type);
+    return reader.valid();
+}
+
+// Reads a table of buffer ranges, validating each against the data section.
+bool readBufferTable(util::BinaryReader& reader, const uint8_t* data, uint64_t dataSize, std::vector<const uint8_t*>& pointers, std::vector<size_t>& sizes)
+{
+    uint64_t count = 0;
+    if (!reader.read(count) || (count > reader.remaining())) {
+        return false;
+    }
+    for (uint64_t ii = 0; ii < count; ++ii) {
+        uint64_t offset = 0, size = 0;
+        reader.read(offset);
+        reader.read(size);
+        if (!reader.valid() || (offset > dataSize) || (size > (dataSize - offset))) {
+            return false;
+        }
+        pointers.push_back(data + offset);
+        sizes.push_back(size_t(size));
+    }
+    return true;
+}
+
+//-------------------------------------------------------------------------
+// Whether the index range of 'submesh' and the layout of each of its
+// attributes (offset, stride and element size) fit the buffers they refer
+// to. Submeshes of a damaged cache that fail this are never drawn.
+bool submeshFitsBuffers(const MeshProvider::Submesh& submesh, const std::vector<size_t>& vertexBufferSizes,
+                        const std::vector<size_t>& indexBufferSizes)
+{
+    if (submesh.indexBuffer >= indexBufferSizes.size()) {
+        return false;
+    }
+    const size_t indexBufferSize = indexBufferSizes[submesh.indexBuffer];
+    if ((submesh.indexOffset > indexBufferSize) ||
+        (submesh.elementCount > (indexBufferSize - submesh.indexOffset) / indexSize(submesh.indexType))) {
+        return false;
+    }
+
+    for (int ii = 0; ii < submesh.vertexAttributeCount; ++ii) {
+        const VertexAttribute& attribute = submesh.vertexAttributes[ii];
+        if ((attribute.buffer < 0) || (size_t(attribute.buffer) >= vertexBufferSizes.size()) ||
+            (attribute.componentCount < 1) || (attribute.componentCount > 4) ||
+            ((attribute.size != 2) && (attribute.size != 4)) || (attribute.stride < 0)) {
+            return false;
+        }
+        const size_t elementSize = size_t(attribute.componentCount) * size_t(attribute.size);
+        const size_t vertexBufferSize = vertexBufferSizes[attribute.buffer];
+        if (((attribute.stride != 0) && (size_t(attribute.stride) < elementSize)) ||
+            (attribute.offset > vertexBufferSize) || (elementSize > vertexBufferSize - attribute.offset)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+} // namespace.
+
+std::string SceneCacheMeshProvider::cachePath(const std::string_view assetPath, const std::string_view extension)
+{
+    const std::string path = absolutePath(std::filesystem::path(assetPath));
+    char hash[17];
+    snprintf(hash, sizeof(hash), "%016llx", static_cast<unsigned long long>(util::FNV1a(path.data(), path.size())));
+
+    const std::filesystem::path directory = std::filesystem::path(util::userCacheDirectory()) / "scenes";
+    std::error_code error;
+    std::filesystem::create_directories(directory, error);
+    return (directory / (std::filesystem::path(path).stem().string() + "-" + hash + std::string(extension))).string();
+}
+
+uint64_t SceneCacheMeshProvider::cacheKey(const std::string_view assetPath, unsigned int importerFlags, bool convertToMeters,
+                                          VertexLayout vertexLayout, VertexFormat vertexFormat, MeshOptimization meshOptimization)
+{
+    uint64_t key = fileStamp(std::filesystem::path(assetPath));
+    if (key == 0) {
+        return 0;
+    }
+
+    key = util::hashCombine(key, importerFlags);
+    key = util::hashCombine(key, convertToMeters);
+    key = util::hashCombine(key, vertexLayout);
+    key = util::hashCombine(key, vertexFormat);
+    key = util::hashCombine(key, meshOptimization);
+    return key;
+}
+
+bool SceneCacheMeshProvider::write(const std::string& path, uint64_t key, const std::string_view assetPath,
+                                   const std::vector<std::string>& importedFiles, MeshProvider& provider,
+                                   const std::vector<MaterialRecord>& materials, const std::vector<LightRecord>& lights,
+                                   const util::AABB& sceneAABB)
+{
+    util::Timer timer(true);
+
+    // The asset itself is covered by the key, everything else it pulls in is checked when the cache is opened.
+    const std::string asset = absolutePath(std::filesystem::path(assetPath));
+    const std::filesystem::path assetDirectory = std::filesystem::path(asset).parent_path();
+    std::vector<std::string> dependencies;
+    for (const std::string& file : importedFiles) {
+        dependencies.push_back(absolutePath(std::filesystem::path(file)));
+    }
+    for (const MaterialRecord& material : materials) {
+        for (const MaterialRecord::Texture& texture : material.textures) {
+            dependencies.push_back(absolutePath(assetDirectory / texture.path));
+        }
+    }
+    std::sort(dependencies.begin(), dependencies.end());
+    dependencies.erase(std::unique(dependencies.begin(), dependencies.end()), dependencies.end());
+    dependencies.erase(std::remove(dependencies.begin(), dependencies.end(), asset), dependencies.end());
+
+    // Lay out the data section first so that the metadata can refer to each buffer by offset.
+    struct BufferLayout {
+        uint64_t offset = 0;
+        uint64_t size = 0;
+    };
+    uint64_t dataSize = 0;
+    auto layoutBuffer = [&dataSize](size_t size) {
+        BufferLayout layout = { (dataSize + kBufferAlignment - 1) / kBufferAlignment * kBufferAlignment, size };
+        dataSize = layout.offset + layout.size;
+        return layout;
+    };
+
+    std::vector<BufferLayout> vertexBuffers(provider.GetVertexBufferCount());
+    for (size_t ii = 0; ii < vertexBuffers.size(); ++ii) {
+        vertexBuffers[ii] = layoutBuffer(provider.GetVertexBufferSize(ii));
+    }
+    std::vector<BufferLayout> indexBuffers(provider.GetIndexBufferCount());
+    for (size_t ii = 0; ii < indexBuffers.size(); ++ii) {
+        indexBuffers[ii] = layoutBuffer(provider.GetIndexBufferSize(ii));
+    }
+
+    util::BinaryWriter metadata;
+    metadata.write(uint64_t(dependencies.size()));
+    for (const std::string& dependency : dependencies) {
+        metadata.writeString(dependency);
+        metadata.write(fileStamp(std::filesystem::path(dependency)));
+    }
+    metadata.write(sceneAABB.min);
+    metadata.write(sceneAABB.max);
+    for (const std::vector<BufferLayout>* buffers : { &vertexBuffers, &indexBuffers }) {
+        metadata.write(uint64_t(buffers->size()));
+        for (const BufferLayout& buffer : *buffers) {
+            metadata.write(buffer.offset);
+            metadata.write(buffer.size);
+        }
+    }
+    metadata.write(uint64_t(provider.GetSubmeshCount()));
+    for (size_t ii = 0; ii < provider.GetSubmeshCount(); ++ii) {
+        writeSubmesh(metadata, provider.GetSubmesh(ii));
+    }
+    metadata.write(uint64_t(materials.size()));
+    for (const MaterialRecord& material : materials) {
+        writeMaterial(metadata, material);
+    }
+    metadata.write(uint64_t(lights.size()));
+    for (const LightRecord& light : lights) {
+        writeLight(metadata, light);
+    }
+
+    Header header;
+    header.key = key;
+    header.metadataSize = metadata.size();
+    header.dataOffset = (sizeof(Header) + metadata.size() + kDataAlignment - 1) / kDataAlignment * kDataAlignment;
+    header.dataSize = dataSize;
+
+    std::string tempPath = path + ".tmp";
+    {
+        std::ofstream fout(tempPath, std::ios::binary | std::ios::trunc);
+        if (!fout) {
+            LOG_WARNING("Unable to open scene cache %s for writing", tempPath.c_str());
+            return false;
+        }
+
+        fout.write(reinterpret_cast<const char*>(&header), sizeof(Header));
+        fout.write(reinterpret_cast<const char*>(metadata.buffer().data()), metadata.size());
+
+        // Buffers are staged through a single scratch allocation, padded out to their layout offsets.
+        std::vector<uint8_t> scratch;
+        uint64_t position = 0;
+        auto writeBuffer = [&](const BufferLayout& layout, auto fill) {
+            scratch.assign(size_t(layout.offset - position), 0);
+            fout.write(reinterpret_cast<const char*>(scratch.data()), scratch.size());
+            scratch.resize(size_t(layout.size));
+            fill(scratch.data());
+            fout.write(reinterpret_cast<const char*>(scratch.data()), scratch.size());
+            position = layout.offset + layout.size;
+        };
+
+        scratch.assign(size_t(header.dataOffset - sizeof(Header) - metadata.size()), 0);
+        fout.write(reinterpret_cast<const char*>(scratch.data()), scratch.size());
+        for (size_t ii = 0; ii < vertexBuffers.size(); ++ii) {
+            writeBuffer(vertexBuffers[ii], [&](uint8_t* buffer) { provider.FillVertexBuffer(ii, buffer); });
+        }
+        for (size_t ii = 0; ii < indexBuffers.size(); ++ii) {
+            writeBuffer(indexBuffers[ii], [&](uint8_t* buffer) { provider.FillIndexBuffer(ii, buffer); });
+        }
+
+        fout.close();
+        if (!fout) {
+            LOG_WARNING("Failed to write scene cache %s", tempPath.c_str());
+            std::error_code error;
+            std::filesystem::remove(tempPath, error);
+            return false;
+        }
+    }
+
+    std::error_code error;
+    std::filesystem::rename(tempPath, path, error);
+    if (error) {
+        LOG_WARNING("Unable to move scene cache into place at %s: %s", path.c_str(), error.message().c_str());
+        std::filesystem::remove(tempPath, error);
+        return false;
+    }
+
+    LOG_INFO("Wrote scene cache %s (%.2f MB) in %f seconds", path.c_str(), float(header.dataOffset + dataSize) / (1024.0f * 1024.0f), timer.stop());
+    return true;
+}
+
+bool SceneCacheMeshProvider::open(const std::string& path, uint64_t key)
+{
+    if ((key == 0) || !m_file.open(path)) {
+        return false;
+    }
+
+    Header header;
+    if (m_file.size() < sizeof(Header)) {
+        LOG_WARNING("Scene cache %s is truncated - ignoring it", path.c_str());
+        m_file.close();
+        return false;
+    }
+    memcpy(&header, m_file.data(), sizeof(Header));
+
+    if ((header.magic != kMagic) || (header.version != kVersion)) {
+        LOG_INFO("Scene cache %s is from a different version of Heatray - ignoring it", path.c_str());
+        m_file.close();
+        return false;
+    }
+    if (header.key != key) {
+        LOG_INFO("Scene cache %s is out of date - ignoring it", path.c_str());
+        m_file.close();
+        return false;
+    }
+    if ((header.metadataSize > (m_file.size() - sizeof(Header))) || (header.dataOffset > m_file.size()) ||
+        (header.dataSize > (m_file.size() - header.dataOffset))) {
+        LOG_WARNING("Scene cache %s is truncated - ignoring it", path.c_str());
+        m_file.close();
+        return false;
+    }
+
+    const uint8_t* data = m_file.data() + header.dataOffset;
+    util::BinaryReader reader(m_file.data() + sizeof(Header), size_t(header.metadataSize));
+
+    // Missing files are recorded with a stamp of 0, so adding one later invalidates the cache as well.
+    uint64_t dependencyCount = 0;
+    bool valid = reader.read(dependencyCount) && (dependencyCount <= reader.remaining());
+    for (uint64_t ii = 0; valid && (ii < dependencyCount); ++ii) {
+        std::string dependency;
+        uint64_t stamp = 0;
+        valid = reader.readString(dependency) && reader.read(stamp);
+        if (valid && (fileStamp(std::filesystem::path(dependency)) != stamp)) {
+            LOG_INFO("Scene cache %s is out of date (%s changed) - ignoring it", path.c_str(), dependency.c_str());
+            m_file.close();
+            return false;
+        }
+    }
+
+    valid = valid && reader.read(m_sceneAABB.min) && reader.read(m_sceneAABB.max);
+
+    std::vector<const uint8_t*> pointers;
+    std::vector<size_t> vertexBufferSizes;
+    valid = valid && readBufferTable(reader, data, header.dataSize, pointers, vertexBufferSizes);
+    for (size_t ii = 0; valid && (ii < pointers.size()); ++ii) {
+        m_vertexBuffers.push_back({ pointers[ii], vertexBufferSizes[ii] });
+    }
+    pointers.clear();
+    std::vector<size_t> indexBufferSizes;
+    valid = valid && readBufferTable(reader, data, header.dataSize, pointers, indexBufferSizes);
+    for (size_t ii = 0; valid && (ii < pointers.size()); ++ii) {
+        m_indexBuffers.push_back({ pointers[ii], indexBufferSizes[ii] });
+    }
+
+    uint64_t count = 0;
+    valid = valid && reader.read(count) && (count <= reader.remaining());
+    if (valid) {
+        m_submeshes.resize(size_t(count));
+        for (Submesh& submesh : m_submeshes) {
+            valid = valid && readSubmesh(reader, submesh) && submeshFitsBuffers(submesh, vertexBufferSizes, indexBufferSizes);
+        }
+    }
+    valid = valid && reader.read(count) && (count <= reader.remaining());
+    if (valid) {
+        m_materialRecords.resize(size_t(count));
+        for (MaterialRecord& material : m_materialRecords) {
+            valid = valid && readMaterial(reader, material);
+        }
+    }
+    valid = valid && reader.read(count) && (count <= reader.remaining());
+    if (valid) {
+        m_lightRecords.resize(size_t(count));
+        for (LightRecord& light : m_lightRecords) {
+            valid = valid && readLight(reader, light);
+        }
+    }
+
+    if (!valid) {
+        LOG_WARNING("Scene cache %s is corrupt - ignoring it", path.c_str());
+        m_vertexBuffers.clear();
+        m_indexBuffers.clear();
+        m_submeshes.clear();
+        m_materialRecords.clear();
+        m_lightRecords.clear();
+        m_file.close();
+        return false;
+    }
+
+    SplitIntoChunks(util::MappedFile::kStreamChunkSize);
+    return true;
+}
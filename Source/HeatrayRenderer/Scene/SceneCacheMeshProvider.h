@@ -0,0 +1,94 @@
+//
+//  SceneCacheMeshProvider.h
+//  Heatray
+//
+//  Binary cache of a fully imported scene, stored in the user cache
+//  directory (see util::userCacheDirectory()).
+//  The cache holds the final vertex and index buffers, submesh table,
+//  material and light descriptions and the scene AABB so that reloading an
+//  asset skips Assimp entirely. Cache files are memory mapped and the
+//  buffers are streamed straight from the mapping into OpenRL in chunks, so
+//  only a chunk of each buffer is resident in host memory at a time.
+//
+//  Caches are keyed by the path, size and modification time of the asset
+//  along with the import settings so that checking a cache never reads the
+//  asset itself. The same is recorded for the other files the import read
+//  (e.g. a glTF .bin or an .mtl) and for the textures referenced by the
+//  materials, and the cache is ignored if any of them changed.
+//
+//
+
+#pragma once
+
+#include "MappedMeshProvider.h"
+#include "SceneRecords.h"
+
+#include <Utility/AABB.h>
+#include <Utility/MappedFile.h>
+
+#include <stdint.h>
+#include <string>
+#include <string_view>
+#include <vector>
+
+class SceneCacheMeshProvider : public MappedMeshProvider
+{
+public:
+    static constexpr uint32_t kMagic = 0x43535248; // 'HRSC'.
+    static constexpr uint32_t kVersion = 6;
+    static constexpr uint64_t kDataAlignment = 4096; // Alignment of the buffer data within the file.
+    static constexpr char const * kFileExtension = ".hrcache";
+
+    explicit SceneCacheMeshProvider(const std::string_view name) : MappedMeshProvider(name) {}
+    virtual ~SceneCacheMeshProvider() = default;
+
+    //-------------------------------------------------------------------------
+    // Path of the file caching data derived from 'assetPath' with the given
+    // extension. The name is unique to the absolute path of the asset.
+    static std::string cachePath(const std::string_view assetPath, const std::string_view extension = kFileExtension);
+
+    //-------------------------------------------------------------------------
+    // Compute the key identifying the cache for 'assetPath' imported with the
+    // supplied importer flags and settings. Returns 0 if the asset does not
+    // exist.
+    static uint64_t cacheKey(const std::string_view assetPath, unsigned int importerFlags, bool convertToMeters,
+                             VertexLayout vertexLayout, VertexFormat vertexFormat, MeshOptimization meshOptimization);
+
+    //-------------------------------------------------------------------------
+    // Memory map the cache at 'path'. Returns false if the cache does not
+    // exist, is corrupt, was written with a different key or version or any
+    // of the files it depends on changed since.
+    bool open(const std::string& path, uint64_t key);
+
+    //-------------------------------------------------------------------------
+    // Write everything produced by 'provider' for 'assetPath' to a new cache
+    // at 'path'. 'importedFiles' are the files other than the asset that the
+    // import read. The cache is written to a temporary file first and then
+    // moved into place.
+    static bool write(const std::string& path, uint64_t key, const std::string_view assetPath,
+                      const std::vector<std::string>& importedFiles, MeshProvider& provider,
+                      const std::vector<MaterialRecord>& materials, const std::vector<LightRecord>& lights,
+                      const util::AABB& sceneAABB);
+
+    const std::vector<MaterialRecord>& materialRecords() const { return m_materialRecords; }
+    const std::vector<LightRecord>& lightRecords() const { return m_lightRecords; }
+    const util::AABB& sceneAABB() const { return m_sceneAABB; }
+
+private:
+    // On-disk header, followed by the metadata (dependencies, tables and
+    // records) and then the buffer data starting at 'dataOffset'.
+    struct Header {
+        uint32_t magic = kMagic;
+        uint32_t version = kVersion;
+        uint64_t key = 0;
+        uint64_t metadataSize = 0; // In bytes, starting right after the header.
+        uint64_t dataOffset = 0;   // In bytes from the start of the file.
+        uint64_t dataSize = 0;     // In bytes.
+    };
+
+    util::MappedFile m_file;
+
+    std::vector<MaterialRecord> m_materialRecords;
+    std::vector<LightRecord> m_lightRecords;
+    util::AABB m_sceneAABB;
+};
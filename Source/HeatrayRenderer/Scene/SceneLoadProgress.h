@@ -0,0 +1,49 @@
+//
+//  SceneLoadProgress.h
+//  Heatray
+//
+//  Progress of a scene load. Written by the threads performing the load and
+//  safe to poll from any other thread, e.g. by the UI.
+//
+//
+
+#pragma once
+
+#include <atomic>
+#include <stdint.h>
+
+struct SceneLoadProgress {
+    enum class Stage : uint32_t {
+        kIdle,
+        kImporting,         // Reading the asset from disk.
+        kDecodingTextures,  // Decoding the textures referenced by the materials.
+        kCreatingResources, // Creating the OpenRL objects on the OpenRL thread.
+        kDone
+    };
+
+    std::atomic<Stage> stage = Stage::kIdle;
+    std::atomic<uint32_t> meshCount = 0; // Submeshes of the imported asset.
+    std::atomic<uint32_t> textureCount = 0;
+    std::atomic<uint32_t> texturesDecoded = 0;
+    std::atomic<uint64_t> bytesLoaded = 0; // Geometry and decoded texture data.
+
+    void reset()
+    {
+        stage = Stage::kIdle;
+        meshCount = 0;
+        textureCount = 0;
+        texturesDecoded = 0;
+        bytesLoaded = 0;
+    }
+
+    static const char* stageName(Stage stage)
+    {
+        switch (stage) {
+            case Stage::kImporting:         return "Importing";
+            case Stage::kDecodingTextures:  return "Decoding textures";
+            case Stage::kCreatingResources: return "Creating OpenRL resources";
+            case Stage::kDone:              return "Done";
+            default:                        return "Idle";
+        }
+    }
+};
@@ -0,0 +1,165 @@
+#include "SceneRecords.h"
+
+#include "Lighting.h"
+
+#include <HeatrayRenderer/Materials/GlassMaterial.h>
+#include <HeatrayRenderer/Materials/PhysicallyBasedMaterial.h>
+#include <Utility/Log.h>
+#include <Utility/TextureCache.h>
+
+#include <filesystem>
+
+namespace {
+
+std::shared_ptr<openrl::Texture>* textureForSlot(const std::shared_ptr<Material>& material, MaterialRecord::TextureSlot slot)
+{
+    using TextureSlot = MaterialRecord::TextureSlot;
+
+    if (material->type() == Material::Type::Glass) {
+        GlassMaterial::Parameters& params = std::static_pointer_cast<GlassMaterial>(material)->parameters();
+        switch (slot) {
+            case TextureSlot::kBaseColor:         return &params.baseColorTexture;
+            case TextureSlot::kNormalmap:         return &params.normalmap;
+            case TextureSlot::kMetallicRoughness: return &params.metallicRoughnessTexture;
+            default:                              return nullptr;
+        }
+    }
+
+    PhysicallyBasedMaterial::Parameters& params = std::static_pointer_cast<PhysicallyBasedMaterial>(material)->parameters();
+    switch (slot) {
+        case TextureSlot::kBaseColor:          return &params.baseColorTexture;
+        case TextureSlot::kEmissive:           return &params.emissiveTexture;
+        case TextureSlot::kNormalmap:          return &params.normalmap;
+        case TextureSlot::kMetallicRoughness:  return &params.metallicRoughnessTexture;
+        case TextureSlot::kClearCoat:          return &params.clearCoatTexture;
+        case TextureSlot::kClearCoatRoughness: return &params.clearCoatRoughnessTexture;
+        case TextureSlot::kClearCoatNormalmap: return &params.clearCoatNormalmap;
+        default:                               return nullptr;
+    }
+}
+
+bool supportsSlot(Material::Type type, MaterialRecord::TextureSlot slot)
+{
+    using TextureSlot = MaterialRecord::TextureSlot;
+
+    // Must match textureForSlot().
+    if (type == Material::Type::Glass) {
+        return (slot == TextureSlot::kBaseColor) || (slot == TextureSlot::kNormalmap) || (slot == TextureSlot::kMetallicRoughness);
+    }
+    return true;
+}
+
+} // namespace.
+
+std::vector<std::shared_ptr<Material>> createMaterials(const std::vector<MaterialRecord>& records, const std::string_view assetDirectory,
+                                                       const util::TextureLoadOptions& textureOptions)
+{
+    std::vector<std::shared_ptr<Material>> materials;
+    materials.reserve(records.size());
+
+    for (const MaterialRecord& record : records) {
+        if (record.type == Material::Type::Glass) {
+            std::shared_ptr<GlassMaterial> glassMaterial = std::make_shared<GlassMaterial>(record.name);
+            GlassMaterial::Parameters& params = glassMaterial->parameters();
+            params.baseColor = record.baseColor;
+            params.roughness = record.roughness;
+            params.ior = record.ior;
+            params.density = record.density;
+            materials.push_back(glassMaterial);
+        } else {
+            std::shared_ptr<PhysicallyBasedMaterial> pbrMaterial = std::make_shared<PhysicallyBasedMaterial>(record.name);
+            PhysicallyBasedMaterial::Parameters& params = pbrMaterial->parameters();
+            params.baseColor = record.baseColor;
+            params.emissiveColor = record.emissiveColor;
+            params.roughness = record.roughness;
+            params.metallic = record.metallic;
+            params.specularF0 = record.specularF0;
+            params.clearCoat = record.clearCoat;
+            params.clearCoatRoughness = record.clearCoatRoughness;
+            params.doubleSided = record.doubleSided;
+            params.alphaMask = record.alphaMask;
+            materials.push_back(pbrMaterial);
+        }
+
+        if (record.vertexColors) {
+            materials.back()->enableVertexColors();
+        }
+    }
+
+    // Textures shared between materials are only decoded and uploaded once. All remaining textures
+    // are decoded in parallel while this thread uploads them to OpenRL as they become available.
+    std::vector<util::TextureLoadRequest> textureRequests;
+    std::vector<std::shared_ptr<openrl::Texture>*> destinations;
+
+    const std::filesystem::path directory(assetDirectory);
+    for (size_t ii = 0; ii < records.size(); ++ii) {
+        for (const MaterialRecord::Texture& texture : records[ii].textures) {
+            std::shared_ptr<openrl::Texture>* destination = textureForSlot(materials[ii], texture.slot);
+            if (!destination) {
+                LOG_WARNING("Material %s does not support texture %s", records[ii].name.c_str(), texture.path.c_str());
+                continue;
+            }
+
+            textureRequests.push_back({ (directory / texture.path).string(), true, texture.convertToLinear, textureOptions });
+            destinations.push_back(destination);
+        }
+    }
+
+    util::TextureCache& textureCache = util::TextureCache::instance();
+    std::vector<std::shared_ptr<openrl::Texture>> textures = textureCache.getAll(textureRequests);
+    for (size_t ii = 0; ii < textures.size(); ++ii) {
+        *(destinations[ii]) = textures[ii];
+    }
+    textureCache.logStatistics("Scene materials");
+
+    return materials;
+}
+
+std::vector<util::TextureLoadRequest> materialTextureRequests(const std::vector<MaterialRecord>& records, const std::string_view assetDirectory,
+                                                              const util::TextureLoadOptions& textureOptions)
+{
+    std::vector<util::TextureLoadRequest> textureRequests;
+
+    const std::filesystem::path directory(assetDirectory);
+    for (const MaterialRecord& record : records) {
+        for (const MaterialRecord::Texture& texture : record.textures) {
+            if (supportsSlot(record.type, texture.slot)) {
+                textureRequests.push_back({ (directory / texture.path).string(), true, texture.convertToLinear, textureOptions });
+            }
+        }
+    }
+
+    return textureRequests;
+}
+
+void addLights(const std::vector<LightRecord>& records, std::shared_ptr<Lighting> lighting)
+{
+    for (const LightRecord& record : records) {
+        switch (record.type) {
+            case Light::Type::kDirectional:
+            {
+                std::shared_ptr<DirectionalLight> light = lighting->addDirectionalLight(record.name);
+                light->setParams(record.directional);
+                lighting->updateLight(light);
+                break;
+            }
+            case Light::Type::kPoint:
+            {
+                std::shared_ptr<PointLight> light = lighting->addPointLight(record.name);
+                light->setParams(record.point);
+                lighting->updateLight(light);
+                break;
+            }
+            case Light::Type::kSpot:
+            {
+                std::shared_ptr<SpotLight> light = lighting->addSpotLight(record.name);
+                light->setParams(record.spot);
+                lighting->updateLight(light);
+                break;
+            }
+            default:
+                LOG_WARNING("Unsupported light type for light %s", record.name.c_str());
+                break;
+        }
+    }
+}
@@ -0,0 +1,103 @@
+//
+//  SceneRecords.h
+//  Heatray
+//
+//  CPU-side descriptions of the materials and lights of an imported scene.
+//  Providers fill these in without touching OpenRL so that they can be
+//  cached on disk, and the OpenRL objects are then created from them in one
+//  place regardless of where the scene came from.
+//
+//
+
+#pragma once
+
+#include <HeatrayRenderer/Lights/DirectionalLight.h>
+#include <HeatrayRenderer/Lights/PointLight.h>
+#include <HeatrayRenderer/Lights/SpotLight.h>
+#include <HeatrayRenderer/Materials/Material.h>
+#include <Utility/TextureLoader.h>
+
+#include <glm/glm/vec3.hpp>
+
+#include <memory>
+#include <stdint.h>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Forward declarations.
+class Lighting;
+
+struct MaterialRecord {
+    // Material parameter that a texture is bound to.
+    enum class TextureSlot : uint32_t {
+        kBaseColor,
+        kEmissive,
+        kNormalmap,
+        kMetallicRoughness,
+        kClearCoat,
+        kClearCoatRoughness,
+        kClearCoatNormalmap
+    };
+
+    struct Texture {
+        TextureSlot slot = TextureSlot::kBaseColor;
+        std::string path; // Relative to the directory containing the asset.
+        bool convertToLinear = false; // True for color data stored as sRGB.
+    };
+
+    Material::Type type = Material::Type::PBR;
+    std::string name;
+
+    // Parameters shared by all material types.
+    glm::vec3 baseColor = glm::vec3(1.0f);
+    float roughness = 1.0f;
+
+    // PBR parameters.
+    glm::vec3 emissiveColor = glm::vec3(0.0f);
+    float metallic = 0.0f;
+    float specularF0 = 0.5f;
+    float clearCoat = 0.0f;
+    float clearCoatRoughness = 0.0f;
+    bool doubleSided = true;
+    bool alphaMask = false;
+
+    // Glass parameters.
+    float ior = 1.57f;
+    float density = 0.05f;
+
+    bool vertexColors = false; // True if any submesh using this material has vertex colors.
+
+    std::vector<Texture> textures; // Textures are loaded in this order.
+};
+
+struct LightRecord {
+    Light::Type type = Light::Type::kPoint;
+    std::string name;
+
+    // Only the parameters matching 'type' are used.
+    DirectionalLight::Params directional;
+    PointLight::Params point;
+    SpotLight::Params spot;
+};
+
+//-------------------------------------------------------------------------
+// Create the materials described by 'records', uploading any referenced
+// textures (relative to 'assetDirectory') to OpenRL. Must be called on the
+// OpenRL thread. Textures are loaded with 'textureOptions'. The returned
+// materials are in the same order as 'records' and are built when their mesh
+// is created.
+std::vector<std::shared_ptr<Material>> createMaterials(const std::vector<MaterialRecord>& records, const std::string_view assetDirectory,
+                                                       const util::TextureLoadOptions& textureOptions = util::TextureLoadOptions());
+
+//-------------------------------------------------------------------------
+// Get the texture loads that createMaterials() performs for 'records'. Can
+// be called from any thread, e.g. to decode the textures with
+// util::TextureCache::prefetch() before the materials are created.
+std::vector<util::TextureLoadRequest> materialTextureRequests(const std::vector<MaterialRecord>& records, const std::string_view assetDirectory,
+                                                              const util::TextureLoadOptions& textureOptions = util::TextureLoadOptions());
+
+//-------------------------------------------------------------------------
+// Add the lights described by 'records' to 'lighting'. Must be called on
+// the OpenRL thread.
+void addLights(const std::vector<LightRecord>& records, std::shared_ptr<Lighting> lighting);
@@ -13,6 +13,7 @@
 #include "MeshProvider.h"
 
 #include "glm/glm/glm.hpp"
+#include "glm/glm/gtc/constants.hpp"
 
 glm::vec3 CartesianFromSpherical(glm::vec3 const & spherical)
 {
@@ -79,13 +80,21 @@ public:
     size_t GetIndexBufferSize(size_t bufferIndex) override
     {
         size_t triangleCount = 2 * uSlices * vSlices;
-        return 3 * triangleCount * sizeof(int);
+        return 3 * triangleCount * indexSize(indexTypeForVertexCount(vertexCount));
     }
 
     void FillIndexBuffer(size_t bufferIndex, uint8_t *buffer) override
     {
-        int *indexPtr = (int *)buffer;
+        if (indexTypeForVertexCount(vertexCount) == IndexType::kUInt16) {
+            FillIndices((uint16_t *)buffer);
+        } else {
+            FillIndices((uint32_t *)buffer);
+        }
+    }
 
+    template<class Index>
+    void FillIndices(Index *indexPtr)
+    {
         int vSteps = (int)vSlices + 2;
         for (int ii = 0; ii < (int)uSlices; ++ii) {
             for (int jj = 0; jj < vSteps - 1; ++jj) {
@@ -161,6 +170,7 @@ public:
         submesh.indexOffset = 0;
         size_t triangleCount = 2 * uSlices * vSlices;
         submesh.elementCount = 3 * triangleCount;
+        submesh.indexType = indexTypeForVertexCount(vertexCount);
 
         submesh.drawMode = DrawMode::Triangles;
         submesh.localTransform = glm::mat4(1.0f); // identity.
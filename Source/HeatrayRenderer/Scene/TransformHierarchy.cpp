@@ -0,0 +1,109 @@
+#include "TransformHierarchy.h"
+
+#include <glm/glm/glm.hpp>
+
+#include <algorithm>
+#include <assert.h>
+
+TransformHierarchy::NodeIndex TransformHierarchy::addNode(NodeIndex parent, const glm::mat4 &localTransform)
+{
+    assert((parent < m_parents.size()) && !isFree(parent));
+
+    // Only a free node after the parent keeps parents ahead of their children.
+    NodeIndex node = NodeIndex(m_parents.size());
+    auto freeNode = m_freeNodes.upper_bound(parent);
+    if (freeNode != m_freeNodes.end()) {
+        node = *freeNode;
+        m_freeNodes.erase(freeNode);
+        m_parents[node] = parent;
+        m_localTransforms[node] = localTransform;
+        m_dirty[node] = 1;
+    } else {
+        m_parents.push_back(parent);
+        m_localTransforms.push_back(localTransform);
+        m_worldTransforms.push_back(glm::mat4(1.0f));
+        m_dirty.push_back(1);
+        m_childCounts.push_back(0);
+    }
+    ++m_childCounts[parent];
+    m_firstDirtyNode = std::min(m_firstDirtyNode, node);
+    return node;
+}
+
+bool TransformHierarchy::removeNode(NodeIndex node)
+{
+    assert(node < m_parents.size());
+    if ((node == kRootNode) || isFree(node) || (m_childCounts[node] > 0)) {
+        return false;
+    }
+
+    --m_childCounts[m_parents[node]];
+    m_parents[node] = node;
+    m_localTransforms[node] = glm::mat4(1.0f);
+    m_worldTransforms[node] = glm::mat4(1.0f);
+    m_dirty[node] = 0;
+    m_freeNodes.insert(node);
+    return true;
+}
+
+void TransformHierarchy::setLocalTransform(NodeIndex node, const glm::mat4 &localTransform)
+{
+    assert((node < m_parents.size()) && !isFree(node));
+
+    m_localTransforms[node] = localTransform;
+    m_dirty[node] = 1;
+    m_firstDirtyNode = std::min(m_firstDirtyNode, node);
+}
+
+const std::vector<TransformHierarchy::NodeIndex> &TransformHierarchy::update()
+{
+    m_updatedNodes.clear();
+    if (m_firstDirtyNode == kInvalidNode) {
+        return m_updatedNodes;
+    }
+
+    const size_t nodeCount = m_parents.size();
+    const NodeIndex *parents = m_parents.data();
+    const glm::mat4 *localTransforms = m_localTransforms.data();
+    glm::mat4 *worldTransforms = m_worldTransforms.data();
+    uint8_t *dirty = m_dirty.data();
+
+    // The root has no parent to inherit from.
+    NodeIndex first = m_firstDirtyNode;
+    if (first == kRootNode) {
+        worldTransforms[kRootNode] = localTransforms[kRootNode];
+        m_updatedNodes.push_back(kRootNode);
+        first = kRootNode + 1;
+    }
+
+    // Parents come before their children so by the time a node is reached its parent's dirty flag and world
+    // transform are final.
+    for (size_t node = first; node < nodeCount; ++node) {
+        const NodeIndex parent = parents[node];
+        dirty[node] |= dirty[parent];
+        if (dirty[node]) {
+            // glm multiplies matrices as sums of scaled columns, which the compiler vectorizes.
+            worldTransforms[node] = worldTransforms[parent] * localTransforms[node];
+            m_updatedNodes.push_back(NodeIndex(node));
+        }
+    }
+
+    // Flags are cleared afterwards rather than during the pass since children have to see them.
+    for (NodeIndex node : m_updatedNodes) {
+        dirty[node] = 0;
+    }
+    m_firstDirtyNode = kInvalidNode;
+    return m_updatedNodes;
+}
+
+void TransformHierarchy::clear()
+{
+    m_parents.assign(1, kInvalidNode);
+    m_localTransforms.assign(1, glm::mat4(1.0f));
+    m_worldTransforms.assign(1, glm::mat4(1.0f));
+    m_dirty.assign(1, 0);
+    m_childCounts.assign(1, 0);
+    m_freeNodes.clear();
+    m_firstDirtyNode = kInvalidNode;
+    m_updatedNodes.clear();
+}
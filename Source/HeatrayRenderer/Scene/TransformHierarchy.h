@@ -0,0 +1,79 @@
+//
+//  TransformHierarchy.h
+//  Heatray
+//
+//  Tree of local transforms whose world transforms are only recomputed
+//  when they (or one of their ancestors) change.
+//
+//
+
+#pragma once
+
+#include <glm/glm/mat4x4.hpp>
+
+#include <set>
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+class TransformHierarchy
+{
+public:
+    using NodeIndex = uint32_t;
+    static constexpr NodeIndex kRootNode = 0;
+    static constexpr NodeIndex kInvalidNode = ~NodeIndex(0);
+
+    TransformHierarchy() { clear(); }
+    ~TransformHierarchy() = default;
+
+    //-------------------------------------------------------------------------
+    // Add a node below 'parent'. The returned index stays valid until the
+    // node is removed or clear() is called. Indices of removed nodes are
+    // handed out again when they come after 'parent'.
+    NodeIndex addNode(NodeIndex parent, const glm::mat4 &localTransform);
+
+    //-------------------------------------------------------------------------
+    // Free a node that has no children so that a later addNode() can reuse
+    // it. Returns false (and does nothing) for the root, for nodes with
+    // children and for nodes that are already free.
+    bool removeNode(NodeIndex node);
+
+    //-------------------------------------------------------------------------
+    // Change the transform of a node relative to its parent. The world
+    // transforms of the node and everything below it are recomputed by the
+    // next call to update().
+    void setLocalTransform(NodeIndex node, const glm::mat4 &localTransform);
+
+    //-------------------------------------------------------------------------
+    // Recompute the world transforms of every node that changed since the
+    // last update, as well as their descendants. Returns those nodes in
+    // increasing order, the list is valid until the next call to update().
+    const std::vector<NodeIndex> &update();
+
+    //-------------------------------------------------------------------------
+    // Remove everything but the root node, which is reset to identity.
+    void clear();
+
+    const glm::mat4 &localTransform(NodeIndex node) const { return m_localTransforms[node]; }
+    const glm::mat4 &worldTransform(NodeIndex node) const { return m_worldTransforms[node]; }
+    NodeIndex parent(NodeIndex node) const { return m_parents[node]; }
+    bool isFree(NodeIndex node) const { return m_parents[node] == node; }
+
+    // Number of node indices in use, including the free ones.
+    size_t nodeCount() const { return m_parents.size(); }
+    size_t freeNodeCount() const { return m_freeNodes.size(); }
+
+private:
+    // Nodes are stored as separate arrays so that update() only streams through the data it needs. A parent is always
+    // added before its children, which lets update() resolve the whole hierarchy in a single pass over the arrays.
+    // A free node is its own parent and never dirty, so update() passes over it without a separate check.
+    std::vector<NodeIndex> m_parents;
+    std::vector<glm::mat4> m_localTransforms;
+    std::vector<glm::mat4> m_worldTransforms;
+    std::vector<uint8_t> m_dirty;
+    std::vector<uint32_t> m_childCounts;
+    std::set<NodeIndex> m_freeNodes; // Ordered so that addNode() can find a free node after the parent.
+
+    NodeIndex m_firstDirtyNode = kInvalidNode; // Nothing before this node needs to be looked at by update().
+    std::vector<NodeIndex> m_updatedNodes;
+};
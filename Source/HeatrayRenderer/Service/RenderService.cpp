@@ -0,0 +1,652 @@
+#include "RenderService.h"
+
+#include <Utility/FileIO.h>
+#include <Utility/Log.h>
+#include <Utility/Timer.h>
+
+#include <algorithm>
+#include <assert.h>
+#include <errno.h>
+#include <fstream>
+#include <iterator>
+#include <random>
+#include <stdio.h>
+
+#if defined(_WIN32)
+    #ifndef NOMINMAX
+        #define NOMINMAX
+    #endif
+    #include <winsock2.h>
+    #include <ws2tcpip.h>
+#else
+    #include <arpa/inet.h>
+    #include <fcntl.h>
+    #include <netinet/in.h>
+    #include <poll.h>
+    #include <sys/socket.h>
+    #include <sys/stat.h>
+    #include <unistd.h>
+#endif
+
+namespace {
+
+#if defined(_WIN32)
+    constexpr uintptr_t kInvalidSocket = uintptr_t(INVALID_SOCKET);
+#else
+    constexpr int kInvalidSocket = -1;
+#endif
+
+constexpr size_t kMaxRequestLength = 1024 * 1024; // Clients sending lines longer than this are disconnected.
+constexpr size_t kMaxQueuedProgress = 64 * 1024; // Progress events are dropped while more than this is queued for a client.
+constexpr size_t kMaxQueuedOutput = 1024 * 1024; // Clients with more than this queued are disconnected.
+constexpr float kAuthenticationTimeout = 5.0f; // Seconds a client has to send its token before it is disconnected.
+constexpr int kPollTimeoutMs = 100; // How often waiting threads check whether the service is stopping.
+
+bool makeNonBlocking(uintptr_t socket)
+{
+#if defined(_WIN32)
+    u_long nonBlocking = 1;
+    return ioctlsocket(SOCKET(socket), FIONBIO, &nonBlocking) == 0;
+#else
+    const int flags = fcntl(int(socket), F_GETFL, 0);
+    return (flags >= 0) && (fcntl(int(socket), F_SETFL, flags | O_NONBLOCK) == 0);
+#endif
+}
+
+// Wait until 'socket' is ready for any of 'events' (POLLIN, POLLOUT) and return the events that occurred, or 0 on
+// timeout. Unlike select() this works for descriptors of any value, which a long running Heatray may well have.
+short pollSocket(uintptr_t socket, short events, int timeoutMs)
+{
+#if defined(_WIN32)
+    WSAPOLLFD descriptor = { SOCKET(socket), events, 0 };
+    return (WSAPoll(&descriptor, 1, timeoutMs) > 0) ? descriptor.revents : 0;
+#else
+    pollfd descriptor = { int(socket), events, 0 };
+    return (poll(&descriptor, 1, timeoutMs) > 0) ? descriptor.revents : 0;
+#endif
+}
+
+// Whether the last failed send() or recv() only failed because the socket isn't ready.
+bool socketWouldBlock()
+{
+#if defined(_WIN32)
+    return WSAGetLastError() == WSAEWOULDBLOCK;
+#else
+    return (errno == EAGAIN) || (errno == EWOULDBLOCK) || (errno == EINTR);
+#endif
+}
+
+std::string generateToken()
+{
+    std::random_device device;
+    std::string token;
+    for (int ii = 0; ii < 4; ++ii) {
+        char word[9];
+        snprintf(word, sizeof(word), "%08x", uint32_t(device()));
+        token += word;
+    }
+    return token;
+}
+
+bool writeTokenFile(const std::filesystem::path& path, const std::string& token)
+{
+    std::error_code error;
+    std::filesystem::remove(path, error);
+
+#if defined(_WIN32)
+    // %LOCALAPPDATA% is only accessible by the user already.
+    std::ofstream file(path, std::ios::trunc);
+    file << token << "\n";
+    return bool(file);
+#else
+    // Created from scratch so that nobody else can have the file open and it is never readable by anybody but the user.
+    int file = ::open(path.c_str(), O_WRONLY | O_CREAT | O_EXCL | O_NOFOLLOW, S_IRUSR | S_IWUSR);
+    if (file < 0) {
+        return false;
+    }
+    const std::string contents = token + "\n";
+    bool written = (::write(file, contents.data(), contents.size()) == ssize_t(contents.size()));
+    ::close(file);
+    return written;
+#endif
+}
+
+// Compares every character so that the time taken doesn't tell how much of a guess was right.
+bool tokensMatch(const std::string& token, const std::string& candidate)
+{
+    if (token.size() != candidate.size()) {
+        return false;
+    }
+    unsigned char difference = 0;
+    for (size_t ii = 0; ii < token.size(); ++ii) {
+        difference |= static_cast<unsigned char>(token[ii] ^ candidate[ii]);
+    }
+    return difference == 0;
+}
+
+std::string overrideValueToString(const util::JsonValue& value)
+{
+    switch (value.type()) {
+        case util::JsonValue::Type::kString:
+            return value.asString();
+        case util::JsonValue::Type::kBool:
+            return value.asBool() ? "true" : "false";
+        default:
+            return value.serialize();
+    }
+}
+
+} // namespace.
+
+void RenderService::Connection::send(const util::JsonValue& message, bool droppable)
+{
+    std::lock_guard<std::mutex> lock(sendMutex);
+    if (!open || (droppable && (outgoing.size() > kMaxQueuedProgress))) {
+        return;
+    }
+
+    if (outgoing.size() > kMaxQueuedOutput) {
+        // The client stopped reading, its thread notices and closes the connection.
+        open = false;
+        return;
+    }
+
+    outgoing += message.serialize();
+    outgoing.push_back('\n');
+    flush();
+}
+
+void RenderService::Connection::flush()
+{
+    size_t sent = 0;
+    while (open && (sent < outgoing.size())) {
+#if defined(_WIN32)
+        int result = ::send(SOCKET(socket), outgoing.data() + sent, int(outgoing.size() - sent), 0);
+#elif defined(__APPLE__)
+        ssize_t result = ::send(socket, outgoing.data() + sent, outgoing.size() - sent, 0);
+#else
+        ssize_t result = ::send(socket, outgoing.data() + sent, outgoing.size() - sent, MSG_NOSIGNAL);
+#endif
+        if (result > 0) {
+            sent += size_t(result);
+        } else if ((result < 0) && socketWouldBlock()) {
+            break;
+        } else {
+            open = false;
+        }
+    }
+    outgoing.erase(0, sent);
+}
+
+void RenderService::closeSocket(SocketHandle socket)
+{
+#if defined(_WIN32)
+    closesocket(SOCKET(socket));
+#else
+    ::close(socket);
+#endif
+}
+
+std::filesystem::path RenderService::tokenPath(uint16_t port)
+{
+    return std::filesystem::path(util::userCacheDirectory()) / ("service-" + std::to_string(port) + ".token");
+}
+
+bool RenderService::start(const std::filesystem::path& outputDirectory, uint16_t port)
+{
+    assert(!m_running);
+
+    std::error_code error;
+    std::filesystem::create_directories(outputDirectory, error);
+    m_outputDirectory = std::filesystem::weakly_canonical(std::filesystem::absolute(outputDirectory, error), error);
+    if (error || !std::filesystem::is_directory(m_outputDirectory)) {
+        LOG_ERROR("Render service: unable to use output directory %s", outputDirectory.string().c_str());
+        return false;
+    }
+
+#if defined(_WIN32)
+    WSADATA wsaData;
+    if (WSAStartup(MAKEWORD(2, 2), &wsaData) != 0) {
+        LOG_ERROR("Render service: unable to initialize Winsock");
+        return false;
+    }
+#endif
+
+    m_listenSocket = SocketHandle(::socket(AF_INET, SOCK_STREAM, IPPROTO_TCP));
+    if (m_listenSocket == kInvalidSocket) {
+        LOG_ERROR("Render service: unable to create socket");
+        return false;
+    }
+
+    int reuse = 1;
+    setsockopt(m_listenSocket, SOL_SOCKET, SO_REUSEADDR, reinterpret_cast<const char*>(&reuse), sizeof(reuse));
+
+    // Only accept connections from this machine.
+    sockaddr_in address = {};
+    address.sin_family = AF_INET;
+    address.sin_port = htons(port);
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if ((bind(m_listenSocket, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) != 0) ||
+        (listen(m_listenSocket, SOMAXCONN) != 0)) {
+        LOG_ERROR("Render service: unable to listen on port %u", uint32_t(port));
+        closeSocket(m_listenSocket);
+        return false;
+    }
+
+    // A new token for every run, clients that could read the previous one have to read it again.
+    m_token = generateToken();
+    m_tokenPath = tokenPath(port);
+    if (!writeTokenFile(m_tokenPath, m_token)) {
+        LOG_ERROR("Render service: unable to write %s", m_tokenPath.string().c_str());
+        closeSocket(m_listenSocket);
+        return false;
+    }
+
+    m_running = true;
+    m_acceptThread = std::thread(&RenderService::acceptThreadFunc, this);
+
+    LOG_INFO("Render service listening on 127.0.0.1:%u, token in %s, writing to %s", uint32_t(port), m_tokenPath.string().c_str(),
+             m_outputDirectory.string().c_str());
+    return true;
+}
+
+void RenderService::stop()
+{
+    if (!m_running) {
+        return;
+    }
+    m_running = false;
+
+    // The accept thread polls 'm_running', while shutting down the client sockets unblocks
+    // any pending receives.
+    m_acceptThread.join();
+    closeSocket(m_listenSocket);
+
+    std::error_code error;
+    std::filesystem::remove(m_tokenPath, error);
+
+    std::vector<ClientThread> clientThreads;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        for (auto& connection : m_connections) {
+            connection->open = false;
+#if defined(_WIN32)
+            shutdown(SOCKET(connection->socket), SD_BOTH);
+#else
+            shutdown(connection->socket, SHUT_RDWR);
+#endif
+        }
+        clientThreads.swap(m_clientThreads);
+    }
+    for (ClientThread& clientThread : clientThreads) {
+        clientThread.thread.join();
+    }
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_connections.clear();
+    m_queue.clear();
+    m_activeJob.reset();
+
+#if defined(_WIN32)
+    WSACleanup();
+#endif
+}
+
+void RenderService::acceptThreadFunc()
+{
+    while (m_running) {
+        reapClientThreads();
+
+        // Wait for a new client with a timeout so that a shutdown request is noticed promptly.
+        if (pollSocket(m_listenSocket, POLLIN, kPollTimeoutMs) == 0) {
+            continue;
+        }
+
+        SocketHandle clientSocket = SocketHandle(accept(m_listenSocket, nullptr, nullptr));
+        if (clientSocket == kInvalidSocket) {
+            continue;
+        }
+
+#if defined(__APPLE__)
+        // Writes to disconnected clients must not raise SIGPIPE and terminate Heatray.
+        int noSigPipe = 1;
+        setsockopt(clientSocket, SOL_SOCKET, SO_NOSIGPIPE, &noSigPipe, sizeof(noSigPipe));
+#endif
+
+        // Events are sent from the render thread, which must never wait for a client.
+        if (!makeNonBlocking(clientSocket)) {
+            closeSocket(clientSocket);
+            continue;
+        }
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        // Every connection gets a thread, so only a few may be open before they prove that they hold the token.
+        const size_t unauthenticated = size_t(std::count_if(m_connections.begin(), m_connections.end(),
+                                                            [](const auto& other) { return !other->authenticated; }));
+        if (unauthenticated >= kMaxUnauthenticatedConnections) {
+            LOG_WARNING("Render service: refusing a client, %zu connections have not authenticated yet", unauthenticated);
+            closeSocket(clientSocket);
+            continue;
+        }
+
+        auto connection = std::make_shared<Connection>();
+        connection->socket = clientSocket;
+        m_connections.push_back(connection);
+        m_clientThreads.push_back({ std::thread(&RenderService::clientThreadFunc, this, connection), connection });
+    }
+}
+
+size_t RenderService::clientThreadCount() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_clientThreads.size();
+}
+
+void RenderService::reapClientThreads()
+{
+    // Called by the accept thread so that threads of clients which disconnected are joined long before stop().
+    std::vector<ClientThread> finishedThreads;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto finished = std::partition(m_clientThreads.begin(), m_clientThreads.end(),
+                                       [](const ClientThread& clientThread) { return !clientThread.connection->finished; });
+        std::move(finished, m_clientThreads.end(), std::back_inserter(finishedThreads));
+        m_clientThreads.erase(finished, m_clientThreads.end());
+    }
+
+    // The threads have already returned or are about to, so this does not block.
+    for (ClientThread& clientThread : finishedThreads) {
+        clientThread.thread.join();
+    }
+}
+
+void RenderService::clientThreadFunc(std::shared_ptr<Connection> connection)
+{
+    std::string pending;
+    char buffer[4096];
+    util::Timer connectedTimer(true);
+    while (m_running && connection->open) {
+        // Clients that never send their token would otherwise hold on to their slot, see kMaxUnauthenticatedConnections.
+        if (!connection->authenticated && (connectedTimer.getElapsedTime() > kAuthenticationTimeout)) {
+            util::JsonValue error = util::JsonValue::object();
+            error.set("event", "error");
+            error.set("error", "Timed out waiting for the token");
+            connection->send(error);
+            break;
+        }
+
+        // Wait for a request or for room to write queued events, with a timeout so that a shutdown
+        // request or a connection closed by send() is noticed promptly.
+        short events = POLLIN;
+        {
+            std::lock_guard<std::mutex> lock(connection->sendMutex);
+            if (!connection->outgoing.empty()) {
+                events |= POLLOUT;
+            }
+        }
+        const short readyEvents = pollSocket(connection->socket, events, kPollTimeoutMs);
+        if (readyEvents == 0) {
+            continue;
+        }
+
+        if (readyEvents & POLLOUT) {
+            std::lock_guard<std::mutex> lock(connection->sendMutex);
+            connection->flush();
+        }
+        // Errors and hang-ups are picked up by recv().
+        if (!(readyEvents & (POLLIN | POLLHUP | POLLERR))) {
+            continue;
+        }
+
+#if defined(_WIN32)
+        int received = recv(SOCKET(connection->socket), buffer, sizeof(buffer), 0);
+#else
+        ssize_t received = recv(connection->socket, buffer, sizeof(buffer), 0);
+#endif
+        if ((received < 0) && socketWouldBlock()) {
+            continue;
+        }
+        if (received <= 0) {
+            break;
+        }
+        pending.append(buffer, size_t(received));
+
+        // Requests are newline-delimited.
+        bool keepOpen = true;
+        size_t lineEnd = 0;
+        while (keepOpen && ((lineEnd = pending.find('\n')) != std::string::npos)) {
+            std::string line = pending.substr(0, lineEnd);
+            pending.erase(0, lineEnd + 1);
+            if (!line.empty() && (line.back() == '\r')) {
+                line.pop_back();
+            }
+            if (!line.empty()) {
+                keepOpen = handleRequest(connection, line);
+            }
+        }
+        if (!keepOpen) {
+            break;
+        }
+
+        if (pending.size() > kMaxRequestLength) {
+            util::JsonValue error = util::JsonValue::object();
+            error.set("event", "error");
+            error.set("error", "Request too long");
+            connection->send(error);
+            break;
+        }
+    }
+
+    // Jobs submitted by this client are still rendered, there is just nobody left to notify.
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_connections.erase(std::remove(m_connections.begin(), m_connections.end(), connection), m_connections.end());
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(connection->sendMutex);
+        connection->open = false;
+        closeSocket(connection->socket);
+    }
+    connection->finished = true;
+}
+
+bool RenderService::resolveOutputPath(const std::string& output, std::string& outputPath) const
+{
+    const std::filesystem::path relativePath = std::filesystem::path(output).lexically_normal();
+    if (output.empty() || relativePath.has_root_path() || !relativePath.has_filename()) {
+        return false;
+    }
+
+    // Resolving symlinks as well, so that a link inside the output directory can't be used to write elsewhere.
+    std::error_code error;
+    const std::filesystem::path path = std::filesystem::weakly_canonical(m_outputDirectory / relativePath, error);
+    const std::filesystem::path pathInsideOutputDirectory = path.lexically_relative(m_outputDirectory);
+    if (error || pathInsideOutputDirectory.empty() || (*pathInsideOutputDirectory.begin() == "..")) {
+        return false;
+    }
+
+    outputPath = path.string();
+    return true;
+}
+
+bool RenderService::handleRequest(const std::shared_ptr<Connection>& connection, const std::string_view line)
+{
+    // Anything that isn't a JSON request, e.g. the headers of an HTTP request, ends the connection right away.
+    util::JsonValue request;
+    std::string parseError;
+    if (!util::JsonValue::parse(line, request, &parseError) || !request.isObject()) {
+        util::JsonValue error = util::JsonValue::object();
+        error.set("event", "error");
+        error.set("error", parseError.empty() ? std::string("Request must be a JSON object") : parseError);
+        connection->send(error);
+        return false;
+    }
+
+    if (!connection->authenticated) {
+        const util::JsonValue& token = request["token"];
+        if (!token.isString() || !tokensMatch(m_token, token.asString())) {
+            util::JsonValue error = util::JsonValue::object();
+            error.set("event", "error");
+            error.set("error", "Missing or invalid token");
+            connection->send(error);
+            return false;
+        }
+        connection->authenticated = true;
+    }
+
+    const std::string& command = request["command"].asString();
+    util::JsonValue reply = util::JsonValue::object();
+
+    if (command == "submit") {
+        const util::JsonValue& session = request["session"];
+        const util::JsonValue& output = request["output"];
+        if (!session.isString() || !output.isString()) {
+            reply.set("event", "error");
+            reply.set("error", "'session' and 'output' are required");
+            connection->send(reply);
+            return true;
+        }
+
+        QueuedJob queued;
+        if (!resolveOutputPath(output.asString(), queued.job.outputPath)) {
+            reply.set("event", "error");
+            reply.set("error", "'output' must be a relative path inside the output directory");
+            connection->send(reply);
+            return true;
+        }
+        queued.client = connection;
+        queued.job.sessionPath = session.asString();
+        queued.job.priority = request["priority"].asInt(0);
+
+        const util::JsonValue& overrides = request["overrides"];
+        for (size_t i = 0; i < overrides.size(); ++i) {
+            if (overrides.isObject()) {
+                queued.job.overrides.emplace_back(overrides.key(i), overrideValueToString(overrides[i]));
+            }
+        }
+
+        size_t position = 0;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            queued.job.id = m_nextJobId++;
+            for (const QueuedJob& other : m_queue) {
+                if (other.job.priority >= queued.job.priority) {
+                    ++position;
+                }
+            }
+            reply.set("event", "queued");
+            reply.set("job", queued.job.id);
+            m_queue.push_back(std::move(queued));
+        }
+
+        reply.set("position", uint64_t(position));
+    } else if (command == "cancel") {
+        uint64_t jobId = uint64_t(request["job"].asNumber());
+        bool cancelled = false;
+        std::shared_ptr<Connection> submitter;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            auto iter = std::find_if(m_queue.begin(), m_queue.end(), [jobId](const QueuedJob& queued) { return queued.job.id == jobId; });
+            if (iter != m_queue.end()) {
+                submitter = std::move(iter->client);
+                m_queue.erase(iter);
+                cancelled = true;
+            }
+        }
+
+        reply.set("event", cancelled ? "cancelled" : "error");
+        reply.set("job", jobId);
+        if (!cancelled) {
+            reply.set("error", "Only queued jobs can be cancelled");
+        }
+
+        // Any client may cancel a job, the one waiting on it has to hear about it either way.
+        if (submitter && (submitter != connection)) {
+            submitter->send(reply);
+        }
+    } else if (command == "status") {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        reply.set("event", "status");
+        reply.set("queued", uint64_t(m_queue.size()));
+        reply.set("active", m_activeJob ? util::JsonValue(m_activeJob->job.id) : util::JsonValue());
+    } else {
+        reply.set("event", "error");
+        reply.set("error", "Unknown command '" + command + "'");
+    }
+
+    connection->send(reply);
+    return true;
+}
+
+std::optional<RenderService::Job> RenderService::popJob()
+{
+    std::shared_ptr<Connection> client;
+    Job job;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_queue.empty()) {
+            return std::nullopt;
+        }
+
+        // Highest priority wins, ties go to the oldest job. The queue is only ever a handful of
+        // entries long so a linear scan keeps cancellation trivial.
+        auto next = std::min_element(m_queue.begin(), m_queue.end(), [](const QueuedJob& a, const QueuedJob& b) {
+            return (a.job.priority != b.job.priority) ? (a.job.priority > b.job.priority) : (a.job.id < b.job.id);
+        });
+
+        m_activeJob = std::move(*next);
+        m_queue.erase(next);
+
+        client = m_activeJob->client;
+        job = m_activeJob->job;
+    }
+
+    util::JsonValue event = util::JsonValue::object();
+    event.set("event", "started");
+    event.set("job", job.id);
+    client->send(event);
+
+    return job;
+}
+
+std::shared_ptr<RenderService::Connection> RenderService::clientForJob(uint64_t jobId)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_activeJob && (m_activeJob->job.id == jobId)) {
+        return m_activeJob->client;
+    }
+    return nullptr;
+}
+
+void RenderService::reportProgress(uint64_t jobId, size_t pass, size_t totalPasses)
+{
+    if (std::shared_ptr<Connection> client = clientForJob(jobId)) {
+        util::JsonValue event = util::JsonValue::object();
+        event.set("event", "progress");
+        event.set("job", jobId);
+        event.set("pass", uint64_t(pass));
+        event.set("total", uint64_t(totalPasses));
+        client->send(event, true);
+    }
+}
+
+void RenderService::reportComplete(uint64_t jobId, bool success, const std::string_view message)
+{
+    std::shared_ptr<Connection> client = clientForJob(jobId);
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_activeJob && (m_activeJob->job.id == jobId)) {
+            m_activeJob.reset();
+        }
+    }
+
+    if (client) {
+        util::JsonValue event = util::JsonValue::object();
+        event.set("event", success ? "completed" : "failed");
+        event.set("job", jobId);
+        event.set(success ? "output" : "error", message);
+        client->send(event);
+    }
+}
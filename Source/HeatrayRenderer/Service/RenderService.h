@@ -0,0 +1,172 @@
+//
+//  RenderService.h
+//  Heatray
+//
+//  Accepts render jobs from local clients over a loopback TCP socket. Each
+//  request and event is a single line of JSON. Jobs are handed to the
+//  renderer in priority order and clients are sent progress as passes
+//  complete.
+//
+//  Any local process (including a web page POSTing to the port) can reach a
+//  loopback socket, so the first request of every connection has to carry
+//  the token of the running service, which is written to tokenPath() in the
+//  user cache directory and only readable by the user. Connections are
+//  closed on the first request that is not valid JSON or that fails to
+//  authenticate, and when no token arrives within a few seconds. Only
+//  kMaxUnauthenticatedConnections may wait for their token at a time.
+//  Outputs are relative paths inside the output directory the service was
+//  started with.
+//
+//  Events are never sent in a way that blocks the renderer. Each connection
+//  queues what the socket can't take right away and its client thread
+//  writes it out as the client reads. Progress events are dropped while a
+//  client is far behind, and clients that stop reading altogether are
+//  disconnected.
+//
+//  Requests:
+//    {"command":"status","token":"..."} (the first request must carry "token")
+//    {"command":"submit","session":"a.xml","output":"a.exr","priority":0,"overrides":{"MaxRenderPasses":256}}
+//    {"command":"cancel","job":3} (the client that submitted the job is sent "cancelled" as well)
+//    {"command":"status"}
+//
+//  Events:
+//    {"event":"queued","job":3,"position":0}
+//    {"event":"started","job":3}
+//    {"event":"progress","job":3,"pass":12,"total":256}
+//    {"event":"completed","job":3,"output":"/output/directory/a.exr"}
+//    {"event":"failed","job":3,"error":"..."}
+//    {"event":"cancelled","job":3}
+//    {"event":"status","queued":2,"active":3}
+//    {"event":"error","error":"..."}
+//
+
+#pragma once
+
+#include <Utility/Json.h>
+
+#include <atomic>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <stdint.h>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+class RenderService
+{
+public:
+    static constexpr uint16_t kDefaultPort = 47820;
+    static constexpr size_t kMaxUnauthenticatedConnections = 8; // Further clients are refused until one authenticates or is timed out.
+
+    struct Job {
+        uint64_t id = 0;
+        int priority = 0; // Higher priorities are rendered first.
+        std::string sessionPath;
+        std::string outputPath; // Inside the output directory of the service.
+        std::vector<std::pair<std::string, std::string>> overrides; // Session variable name -> value.
+    };
+
+    RenderService() = default;
+    ~RenderService() { stop(); }
+
+    //-------------------------------------------------------------------------
+    // Start listening for clients on 127.0.0.1:'port' and write a new token
+    // to tokenPath('port'). Jobs may only write into 'outputDirectory',
+    // which is created if necessary. Returns false if the socket or the token
+    // file could not be opened.
+    bool start(const std::filesystem::path& outputDirectory, uint16_t port = kDefaultPort);
+
+    //-------------------------------------------------------------------------
+    // Disconnect all clients, stop listening and remove the token file.
+    // Queued jobs are dropped.
+    void stop();
+
+    //-------------------------------------------------------------------------
+    // File that clients read the token of the service listening on 'port' from.
+    static std::filesystem::path tokenPath(uint16_t port);
+
+    //-------------------------------------------------------------------------
+    // Get the next job to render, if any. The highest priority job is returned
+    // first and jobs of equal priority are returned in submission order. The
+    // returned job becomes the active job until reportComplete() is called.
+    std::optional<Job> popJob();
+
+    //-------------------------------------------------------------------------
+    // Notify the client which submitted 'jobId' about the state of the job.
+    void reportProgress(uint64_t jobId, size_t pass, size_t totalPasses);
+    void reportComplete(uint64_t jobId, bool success, const std::string_view message);
+
+    bool running() const { return m_running; }
+
+    //-------------------------------------------------------------------------
+    // Number of client threads that have not been joined yet. Threads of
+    // clients that disconnected are joined shortly afterwards.
+    size_t clientThreadCount() const;
+
+private:
+    // This class is not copyable.
+    RenderService(const RenderService& other) = delete;
+    RenderService& operator=(const RenderService& other) = delete;
+
+#if defined(_WIN32)
+    using SocketHandle = uintptr_t;
+#else
+    using SocketHandle = int;
+#endif
+
+    struct Connection {
+        SocketHandle socket; // Non-blocking.
+        std::mutex sendMutex;
+        std::string outgoing; // Queued events not yet taken by the socket, guarded by 'sendMutex'.
+        std::atomic<bool> open = true;
+        std::atomic<bool> finished = false; // Set once the client thread no longer uses the connection.
+        std::atomic<bool> authenticated = false; // Set by the client thread, counted by the accept thread.
+
+        //-------------------------------------------------------------------------
+        // Queue 'message' and write as much of the queue as the socket takes
+        // without blocking. 'droppable' messages (progress) are skipped while
+        // the queue is long.
+        void send(const util::JsonValue& message, bool droppable = false);
+
+        //-------------------------------------------------------------------------
+        // Write queued events until the socket would block. 'sendMutex' must be
+        // held.
+        void flush();
+    };
+
+    struct ClientThread {
+        std::thread thread;
+        std::shared_ptr<Connection> connection;
+    };
+
+    struct QueuedJob {
+        Job job;
+        std::shared_ptr<Connection> client;
+    };
+
+    void acceptThreadFunc();
+    void clientThreadFunc(std::shared_ptr<Connection> connection);
+    bool handleRequest(const std::shared_ptr<Connection>& connection, const std::string_view line);
+    bool resolveOutputPath(const std::string& output, std::string& outputPath) const;
+    std::shared_ptr<Connection> clientForJob(uint64_t jobId);
+    void reapClientThreads();
+
+    static void closeSocket(SocketHandle socket);
+
+    SocketHandle m_listenSocket = SocketHandle(-1);
+    std::string m_token;
+    std::filesystem::path m_tokenPath;
+    std::filesystem::path m_outputDirectory; // Canonical.
+    std::atomic<bool> m_running = false;
+    std::thread m_acceptThread;
+
+    mutable std::mutex m_mutex; // Guards everything below.
+    std::vector<ClientThread> m_clientThreads;
+    std::vector<std::shared_ptr<Connection>> m_connections;
+    std::vector<QueuedJob> m_queue;
+    std::optional<QueuedJob> m_activeJob;
+    uint64_t m_nextJobId = 1;
+};
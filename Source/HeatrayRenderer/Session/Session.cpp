@@ -269,3 +269,95 @@ void Session::setVariableValue(const SessionVariable& variable, const std::strin
 {
     strcpy(g_sessionVariables[static_cast<size_t>(variable)].value.c, value.data());
 }
+
+// Parse 'value' according to the type of the session variable named 'variableName' without modifying it. Returns
+// the variable, or nullptr if there is no such variable or the value is malformed.
+static Variable* parseVariableValue(const std::string_view variableName, const std::string_view value, Variable::Value& parsedValue)
+{
+    for (size_t ii = 0; ii < static_cast<size_t>(Session::SessionVariable::kNumSessionVariables); ++ii) {
+        Variable& variable = g_sessionVariables[ii];
+        if (variable.name != variableName) {
+            continue;
+        }
+
+        std::string valueString(value);
+        char* end = nullptr;
+        switch (variable.type) {
+            case VariableType::kInt:
+                parsedValue.i = static_cast<int>(strtol(valueString.c_str(), &end, 10));
+                break;
+            case VariableType::kUInt:
+                parsedValue.u = static_cast<uint32_t>(strtoul(valueString.c_str(), &end, 10));
+                break;
+            case VariableType::kFloat:
+                parsedValue.f = strtof(valueString.c_str(), &end);
+                break;
+            case VariableType::kBool:
+                if ((valueString == "true") || (valueString == "1")) {
+                    parsedValue.b = true;
+                } else if ((valueString == "false") || (valueString == "0")) {
+                    parsedValue.b = false;
+                } else {
+                    LOG_ERROR("Invalid value '%s' for session variable %s", valueString.c_str(), variable.name.c_str());
+                    return nullptr;
+                }
+                return &variable;
+            case VariableType::kString:
+                if (valueString.size() >= sizeof(parsedValue.c)) {
+                    LOG_ERROR("Value for session variable %s is too long", variable.name.c_str());
+                    return nullptr;
+                }
+                strcpy(parsedValue.c, valueString.c_str());
+                return &variable;
+        }
+
+        if ((end == valueString.c_str()) || (*end != '\0')) {
+            LOG_ERROR("Invalid value '%s' for session variable %s", valueString.c_str(), variable.name.c_str());
+            return nullptr;
+        }
+        return &variable;
+    }
+
+    LOG_ERROR("Unknown session variable %s", std::string(variableName).c_str());
+    return nullptr;
+}
+
+bool Session::setVariableValue(const std::string_view variableName, const std::string_view value) const
+{
+    Variable::Value parsedValue;
+    Variable* variable = parseVariableValue(variableName, value, parsedValue);
+    if (!variable) {
+        return false;
+    }
+
+    variable->value = parsedValue;
+    return true;
+}
+
+bool Session::validateVariableValues(const VariableValues& values) const
+{
+    Variable::Value parsedValue;
+    for (const auto& [name, value] : values) {
+        if (!parseVariableValue(name, value, parsedValue)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool Session::setVariableValues(const VariableValues& values) const
+{
+    // Everything is parsed before anything is assigned so that a bad value leaves all variables untouched.
+    std::vector<std::pair<Variable*, Variable::Value>> parsedValues(values.size());
+    for (size_t ii = 0; ii < values.size(); ++ii) {
+        parsedValues[ii].first = parseVariableValue(values[ii].first, values[ii].second, parsedValues[ii].second);
+        if (!parsedValues[ii].first) {
+            return false;
+        }
+    }
+
+    for (auto& [variable, parsedValue] : parsedValues) {
+        variable->value = parsedValue;
+    }
+    return true;
+}
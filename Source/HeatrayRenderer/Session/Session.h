@@ -13,6 +13,8 @@
 #include <assert.h>
 #include <string>
 #include <string_view>
+#include <utility>
+#include <vector>
 
 // Session variables that should be present in the session xml file. The parameters are marked as:
 // "Variable Group", "Variable Name" (as it is present in the session file) "VariableType", and "Variable Default Value".
@@ -127,6 +129,20 @@ public:
     void setVariableValue(const SessionVariable& variable, const float value) const;
     void setVariableValue(const SessionVariable& variable, const std::string_view value) const;
 
+    //-------------------------------------------------------------------------
+    // Set the value of a session variable by its name (as it appears in the
+    // session file), parsing 'value' according to the type of the variable.
+    // Returns false if there is no such variable or the value is malformed.
+    bool setVariableValue(const std::string_view variableName, const std::string_view value) const;
+
+    //-------------------------------------------------------------------------
+    // Set several session variables by name. Either all of them are set or,
+    // if any name or value is invalid, none of them are and false is returned.
+    // validateVariableValues() only performs the checks.
+    using VariableValues = std::vector<std::pair<std::string, std::string>>;
+    bool setVariableValues(const VariableValues& values) const;
+    bool validateVariableValues(const VariableValues& values) const;
+
 private:
 
     constexpr static std::string_view s_rootSessionNodeName = "HeatraySession";
@@ -9,9 +9,11 @@
 #pragma once
 
 #include "Error.h"
+#include "MemoryTracker.h"
 
 #include <OpenRL/rl.h>
 
+#include <string>
 #include <string_view>
 
 namespace openrl {
@@ -27,16 +29,20 @@ public:
         if (m_buffer != RL_NULL_BUFFER) {
             RLFunc(rlDeleteBuffers(1, &m_buffer));
             m_buffer = RL_NULL_BUFFER;
+            MemoryTracker::instance().remove(m_category, m_name, m_sizeInBytes);
         }
     }
-    Buffer(const Buffer& other) = default;
-    Buffer& operator=(const Buffer& other) = default;
+
+    // This class is not copyable, every copy would release the RL buffer (and its tracked memory) again.
+    Buffer(const Buffer& other) = delete;
+    Buffer& operator=(const Buffer& other) = delete;
 
     //-------------------------------------------------------------------------
-    // Generates an OpenRL buffer and returns a shared_ptr to it.
+    // Generates an OpenRL buffer and returns a shared_ptr to it. 'name' also
+    // identifies the owner of the buffer in the MemoryTracker.
     static std::shared_ptr<Buffer> create(const RLenum target, const void* data, const size_t sizeInBytes, const std::string_view name = "<unnamed>")
     {
-        Buffer* buffer = new Buffer(target, sizeInBytes, name);
+        Buffer* buffer = new Buffer(target, name);
         buffer->modify(data, sizeInBytes);
         return std::shared_ptr<Buffer>(buffer);
     }
@@ -51,6 +57,7 @@ public:
         RLFunc(rlBufferData(m_target, sizeInBytes, data, m_usage));
         RLFunc(rlBindBuffer(m_target, RL_NULL_BUFFER));
 
+        MemoryTracker::instance().resize(m_category, m_name, m_sizeInBytes, sizeInBytes);
         m_sizeInBytes = sizeInBytes;
     }
 
@@ -58,14 +65,16 @@ public:
     // Getters and setters for various Buffer properties.
     inline bool valid() const { return (m_buffer != RL_NULL_BUFFER); }
     inline RLbuffer buffer() const { return m_buffer; }
+    inline size_t size() const { return m_sizeInBytes; }
     inline void setTarget(const RLenum target) { m_target = target; }
     inline void setUsage(const RLenum usage) { m_usage = usage; }
     inline void bind() const { RLFunc(rlBindBuffer(m_target, m_buffer)); }
     inline void unbind() const { RLFunc(rlBindBuffer(m_target, RL_NULL_BUFFER)); }
-    inline void setAsVertexAttribute(RLint location, RLint numComponents, RLenum dataType, RLsize strideInBytes, RLsize offsetInBytes) const
+    inline void setAsVertexAttribute(RLint location, RLint numComponents, RLenum dataType, RLsize strideInBytes, RLsize offsetInBytes,
+                                     RLboolean normalized = RL_FALSE) const
     {
         RLFunc(rlBindBuffer(m_target, m_buffer));
-        RLFunc(rlVertexAttribBuffer(location, numComponents, dataType, RL_FALSE, strideInBytes, offsetInBytes));
+        RLFunc(rlVertexAttribBuffer(location, numComponents, dataType, normalized, strideInBytes, offsetInBytes));
         RLFunc(rlBindBuffer(m_target, RL_NULL_BUFFER));
     }
 
@@ -77,20 +86,27 @@ public:
     inline void unmapBuffer() const { RLFunc(rlUnmapBuffer(m_target)); }
 
 private:
-    explicit Buffer(const RLenum target, const size_t sizeInBytes, const std::string_view name)
+    explicit Buffer(const RLenum target, const std::string_view name)
         : m_target(target)
-        , m_sizeInBytes(sizeInBytes)
+        , m_category(MemoryTracker::categoryForTarget(target))
+        , m_name(name)
     {
         RLFunc(rlGenBuffers(1, &m_buffer));
         RLFunc(rlBindBuffer(m_target, m_buffer));
-        RLFunc(rlBufferParameterString(m_target, RL_BUFFER_NAME, name.data()));
+        RLFunc(rlBufferParameterString(m_target, RL_BUFFER_NAME, m_name.c_str()));
         RLFunc(rlBindBuffer(m_target, RL_NULL_BUFFER));
+
+        // Storage is only allocated (and tracked) by modify().
+        MemoryTracker::instance().add(m_category, m_name, 0);
     }
 
     RLbuffer m_buffer      = RL_NULL_BUFFER;   // The RL buffer object itself.
     RLenum   m_target      = RL_ARRAY_BUFFER;  // Target type.
     RLenum   m_usage       = RL_STATIC_DRAW;   // How is this buffer to be used? (RL_STATIC_DRAW...).
     size_t   m_sizeInBytes = 0;                // Size of the buffer (bytes).
+
+    MemoryTracker::Category m_category; // Category the buffer is tracked under, based on its initial target.
+    std::string m_name;                 // Name of the buffer and its owner in the MemoryTracker.
 };
 
 } // namespace openrl.
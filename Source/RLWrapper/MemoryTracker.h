@@ -0,0 +1,248 @@
+//
+//  MemoryTracker.h
+//  Heatray
+//
+//  Keeps a running total of the device memory allocated for OpenRL buffers
+//  and textures, grouped by the name of the object that owns them.
+//
+//
+
+#pragma once
+
+#include <OpenRL/rl.h>
+
+#include <algorithm>
+#include <array>
+#include <mutex>
+#include <stdint.h>
+#include <stdio.h>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace openrl {
+
+class MemoryTracker
+{
+public:
+    enum class Category : uint32_t {
+        kArrayBuffer,
+        kIndexBuffer,
+        kUniformBuffer,
+        kPixelPackBuffer,
+        kOtherBuffer,
+        kTexture,
+        kCount
+    };
+
+    static constexpr size_t kCategoryCount = size_t(Category::kCount);
+
+    static MemoryTracker& instance()
+    {
+        static MemoryTracker tracker;
+        return tracker;
+    }
+
+    //-------------------------------------------------------------------------
+    // Record that 'sizeInBytes' were allocated or released for the object
+    // named 'tag'. Allocations with the same category and tag are reported
+    // together, e.g. all vertex buffers loaded from one asset, which may hold
+    // many meshes. Array buffers hold vertices as well as other per-object
+    // data such as lights. Can be called from any thread.
+    void add(Category category, const std::string_view tag, size_t sizeInBytes)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        Consumer& consumer = findConsumer(category, tag);
+        consumer.sizeInBytes += sizeInBytes;
+        ++consumer.allocationCount;
+    }
+
+    void remove(Category category, const std::string_view tag, size_t sizeInBytes)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        Consumer& consumer = findConsumer(category, tag);
+        consumer.sizeInBytes -= std::min(consumer.sizeInBytes, sizeInBytes);
+        consumer.allocationCount -= std::min(consumer.allocationCount, size_t(1));
+        if (consumer.allocationCount == 0) {
+            m_consumers.erase(key(category, tag));
+        }
+    }
+
+    //-------------------------------------------------------------------------
+    // Record that an existing allocation changed size from 'oldSizeInBytes'
+    // to 'newSizeInBytes'.
+    void resize(Category category, const std::string_view tag, size_t oldSizeInBytes, size_t newSizeInBytes)
+    {
+        if (oldSizeInBytes == newSizeInBytes) {
+            return;
+        }
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+        Consumer& consumer = findConsumer(category, tag);
+        consumer.sizeInBytes -= std::min(consumer.sizeInBytes, oldSizeInBytes);
+        consumer.sizeInBytes += newSizeInBytes;
+    }
+
+    struct Consumer {
+        Category category = Category::kOtherBuffer;
+        std::string tag;
+        size_t sizeInBytes = 0;
+        size_t allocationCount = 0;
+    };
+
+    struct Report {
+        std::array<size_t, kCategoryCount> categoryBytes = {};
+        std::array<size_t, kCategoryCount> categoryAllocations = {};
+        size_t totalBytes = 0;
+        size_t totalAllocations = 0;
+        std::vector<Consumer> topConsumers; // Sorted by size, largest first.
+    };
+
+    //-------------------------------------------------------------------------
+    // Totals of all live allocations along with the 'topCount' largest
+    // consumers.
+    Report report(size_t topCount) const
+    {
+        Report report;
+        std::lock_guard<std::mutex> lock(m_mutex);
+        report.topConsumers.reserve(m_consumers.size());
+        for (const auto& iter : m_consumers) {
+            const Consumer& consumer = iter.second;
+            report.categoryBytes[size_t(consumer.category)] += consumer.sizeInBytes;
+            report.categoryAllocations[size_t(consumer.category)] += consumer.allocationCount;
+            report.totalBytes += consumer.sizeInBytes;
+            report.totalAllocations += consumer.allocationCount;
+            report.topConsumers.push_back(consumer);
+        }
+
+        topCount = std::min(topCount, report.topConsumers.size());
+        std::partial_sort(report.topConsumers.begin(), report.topConsumers.begin() + topCount, report.topConsumers.end(),
+                          [](const Consumer& a, const Consumer& b) { return a.sizeInBytes > b.sizeInBytes; });
+        report.topConsumers.resize(topCount);
+        return report;
+    }
+
+    //-------------------------------------------------------------------------
+    // Write report(topCount) to 'path' as JSON. Returns false if the file
+    // could not be written.
+    bool writeReport(const std::string_view path, size_t topCount) const
+    {
+        Report memoryReport = report(topCount);
+
+        FILE* file = fopen(std::string(path).c_str(), "w");
+        if (!file) {
+            return false;
+        }
+
+        fprintf(file, "{\n  \"totalBytes\": %llu,\n  \"totalAllocations\": %llu,\n  \"categories\": {\n",
+                (unsigned long long)memoryReport.totalBytes, (unsigned long long)memoryReport.totalAllocations);
+        for (size_t ii = 0; ii < kCategoryCount; ++ii) {
+            fprintf(file, "    \"%s\": { \"bytes\": %llu, \"allocations\": %llu }%s\n", categoryName(Category(ii)),
+                    (unsigned long long)memoryReport.categoryBytes[ii], (unsigned long long)memoryReport.categoryAllocations[ii],
+                    (ii + 1 < kCategoryCount) ? "," : "");
+        }
+        fprintf(file, "  },\n  \"topConsumers\": [\n");
+        for (size_t ii = 0; ii < memoryReport.topConsumers.size(); ++ii) {
+            const Consumer& consumer = memoryReport.topConsumers[ii];
+            fprintf(file, "    { \"tag\": \"%s\", \"category\": \"%s\", \"bytes\": %llu, \"allocations\": %llu }%s\n",
+                    escape(consumer.tag).c_str(), categoryName(consumer.category), (unsigned long long)consumer.sizeInBytes,
+                    (unsigned long long)consumer.allocationCount, (ii + 1 < memoryReport.topConsumers.size()) ? "," : "");
+        }
+        fprintf(file, "  ]\n}\n");
+
+        return (fclose(file) == 0);
+    }
+
+    static const char* categoryName(Category category)
+    {
+        switch (category) {
+            case Category::kArrayBuffer:     return "Array buffers";
+            case Category::kIndexBuffer:     return "Index buffers";
+            case Category::kUniformBuffer:   return "Uniform buffers";
+            case Category::kPixelPackBuffer: return "Pixel pack buffers";
+            case Category::kTexture:         return "Textures";
+            default:                         return "Other buffers";
+        }
+    }
+
+    static Category categoryForTarget(RLenum target)
+    {
+        switch (target) {
+            case RL_ARRAY_BUFFER:         return Category::kArrayBuffer;
+            case RL_ELEMENT_ARRAY_BUFFER: return Category::kIndexBuffer;
+            case RL_UNIFORM_BLOCK_BUFFER: return Category::kUniformBuffer;
+            case RL_PIXEL_PACK_BUFFER:    return Category::kPixelPackBuffer;
+            default:                      return Category::kOtherBuffer;
+        }
+    }
+
+    //-------------------------------------------------------------------------
+    // Number of channels stored per texel by a texture of 'format'. OpenRL
+    // has no two channel format, 0 is returned for formats it does not know.
+    static size_t channelCount(RLenum format)
+    {
+        switch (format) {
+            case RL_LUMINANCE: return 1;
+            case RL_RGB:       return 3;
+            case RL_RGBA:      return 4;
+            default:           return 0;
+        }
+    }
+
+    //-------------------------------------------------------------------------
+    // Approximate device size of a texture, including its mip chain if it
+    // has one.
+    static size_t textureByteCount(RLenum format, RLenum dataType, RLint width, RLint height, RLint depth, bool mipmapped)
+    {
+        const size_t channelSize = (dataType == RL_FLOAT) ? sizeof(float) : sizeof(uint8_t);
+        const size_t byteCount = size_t(std::max(width, 0)) * size_t(std::max(height, 0)) * size_t(std::max(depth, 1)) * channelCount(format) * channelSize;
+        return mipmapped ? (byteCount + (byteCount / 3)) : byteCount; // A full mip chain adds a third.
+    }
+
+private:
+    MemoryTracker() = default;
+
+    // This class is not copyable.
+    MemoryTracker(const MemoryTracker& other) = delete;
+    MemoryTracker& operator=(const MemoryTracker& other) = delete;
+
+    static std::string key(Category category, const std::string_view tag)
+    {
+        std::string result(1, char('0' + uint32_t(category)));
+        result += tag;
+        return result;
+    }
+
+    Consumer& findConsumer(Category category, const std::string_view tag)
+    {
+        Consumer& consumer = m_consumers[key(category, tag)];
+        if (consumer.tag.empty()) {
+            consumer.category = category;
+            consumer.tag = std::string(tag);
+        }
+        return consumer;
+    }
+
+    static std::string escape(const std::string_view text)
+    {
+        std::string result;
+        result.reserve(text.size());
+        for (char c : text) {
+            if ((c == '"') || (c == '\\')) {
+                result += '\\';
+                result += c;
+            } else if (uint8_t(c) < 0x20) {
+                result += ' ';
+            } else {
+                result += c;
+            }
+        }
+        return result;
+    }
+
+    mutable std::mutex m_mutex; // Guards m_consumers.
+    std::unordered_map<std::string, Consumer> m_consumers; // Keyed by category and tag.
+};
+
+} // namespace openrl.
@@ -15,12 +15,39 @@
 #include "../Utility/Log.h"
 
 #include <OpenRL/rl.h>
+#include <algorithm>
 #include <assert.h>
+#include <functional>
+#include <map>
 #include <memory>
+#include <string>
 #include <string_view>
+#include <vector>
 
 namespace openrl {
 
+//
+// Location of a uniform in a particular program. Resolving the handle once
+// and keeping it around avoids looking the uniform up by name every time it
+// is set.
+//
+
+struct UniformHandle
+{
+    RLint location = -1;
+    bool valid() const { return location != -1; }
+};
+
+//
+// Index of a uniform block in a particular program.
+//
+
+struct UniformBlockHandle
+{
+    RLint index = -1;
+    bool valid() const { return index != -1; }
+};
+
 //
 // Encapsulates an RLSL program.
 //
@@ -71,29 +98,50 @@ public:
         if (!valid()) {
             const char* log = nullptr;
             RLFunc(rlGetProgramString(m_program, RL_LINK_LOG, &log));
-            LOG_ERROR("Linking for program %s failed: \n\t%s", name, log);
+            LOG_ERROR("Linking for program %s failed: \n\t%s", name.data(), log);
             return false;
         }
 
+        cacheLocations();
         return true;
     }
 
     //-------------------------------------------------------------------------
-    // Get the location of a uniform by name.
+    // Get the location of a uniform by name. The locations of all active
+    // uniforms are cached when the program is linked, so OpenRL is only asked
+    // about names it did not report (e.g. individual array elements) and
+    // only the first time.
     inline RLint getUniformLocation(const std::string_view name) const
     {
-        RLint location = RLFunc(rlGetUniformLocation(m_program, name.data()));
-        return location;
+        auto iter = m_uniformLocations.find(name);
+        if (iter == m_uniformLocations.end()) {
+            const std::string uniformName(name);
+            RLint location = RLFunc(rlGetUniformLocation(m_program, uniformName.c_str()));
+            iter = m_uniformLocations.emplace(uniformName, location).first;
+        }
+        return iter->second;
     }
 
     //-------------------------------------------------------------------------
-    // Get the index of a uniform block by name.
+    // Get the index of a uniform block by name. Cached the same way as the
+    // uniform locations.
     inline RLint getUniformBlockIndex(const std::string_view name) const
     {
-        RLint index = RLFunc(rlGetUniformBlockIndex(m_program, name.data()));
-        return index;
+        auto iter = m_uniformBlockIndices.find(name);
+        if (iter == m_uniformBlockIndices.end()) {
+            const std::string blockName(name);
+            RLint index = RLFunc(rlGetUniformBlockIndex(m_program, blockName.c_str()));
+            iter = m_uniformBlockIndices.emplace(blockName, index).first;
+        }
+        return iter->second;
     }
 
+    //-------------------------------------------------------------------------
+    // Typed versions of the above for uniforms that are set over and over,
+    // e.g. every pass. Handles stay valid until the program is linked again.
+    inline UniformHandle uniform(const std::string_view name) const { return UniformHandle{ getUniformLocation(name) }; }
+    inline UniformBlockHandle uniformBlock(const std::string_view name) const { return UniformBlockHandle{ getUniformBlockIndex(name) }; }
+
     //-------------------------------------------------------------------------
     // Set a uniform block at a particular index.
     inline void setUniformBlock(const RLint blockIndex, const RLbuffer buffer) const
@@ -125,6 +173,19 @@ public:
         RLFunc(rlUniformp(location, primitive)); 
     }
 
+    //-------------------------------------------------------------------------
+    // Same setters taking handles.
+    inline void setUniformBlock(const UniformBlockHandle block, const RLbuffer buffer) const { setUniformBlock(block.index, buffer); }
+    inline void set1i(const UniformHandle uniform, const int i) const { set1i(uniform.location, i); }
+    inline void set1f(const UniformHandle uniform, const float f) const { set1f(uniform.location, f); }
+    inline void set2fv(const UniformHandle uniform, const float* f) const { set2fv(uniform.location, f); }
+    inline void set2iv(const UniformHandle uniform, const int* i) const { set2iv(uniform.location, i); }
+    inline void set3fv(const UniformHandle uniform, const float* f) const { set3fv(uniform.location, f); }
+    inline void set4fv(const UniformHandle uniform, const float* f) const { set4fv(uniform.location, f); }
+    inline void set4iv(const UniformHandle uniform, const int* i) const { set4iv(uniform.location, i); }
+    inline void setMatrix4fv(const UniformHandle uniform, const float* f) const { setMatrix4fv(uniform.location, f); }
+    inline void setTexture(const UniformHandle uniform, const std::shared_ptr<Texture> texture) const { setTexture(uniform.location, texture); }
+
     //-------------------------------------------------------------------------
     // Bind this program for use.
     inline void bind() const { RLFunc(rlUseProgram(m_program)); }
@@ -155,8 +216,58 @@ private:
         m_program = RLFunc(rlCreateProgram());
     }
 
+    //-------------------------------------------------------------------------
+    // Ask OpenRL for all active uniforms and uniform blocks of the freshly
+    // linked program and remember where they are.
+    inline void cacheLocations()
+    {
+        m_uniformLocations.clear();
+        m_uniformBlockIndices.clear();
+
+        RLint uniformCount = 0;
+        RLint maxNameLength = 0;
+        RLFunc(rlGetProgramiv(m_program, RL_ACTIVE_UNIFORMS, &uniformCount));
+        RLFunc(rlGetProgramiv(m_program, RL_ACTIVE_UNIFORM_MAX_LENGTH, &maxNameLength));
+        std::vector<char> name(std::max(maxNameLength, RLint(kMaxBlockNameLength)) + 1, '\0');
+        for (RLint ii = 0; ii < uniformCount; ++ii) {
+            RLsize length = 0;
+            RLint size = 0;
+            RLenum type = 0;
+            RLFunc(rlGetActiveUniform(m_program, ii, name.size(), &length, &size, &type, name.data()));
+            std::string uniformName(name.data(), std::min<size_t>(length, name.size() - 1));
+
+            // Arrays are reported by their first element but are usually looked up by their plain name.
+            constexpr std::string_view kFirstElement = "[0]";
+            if ((uniformName.size() > kFirstElement.size()) && uniformName.ends_with(kFirstElement)) {
+                uniformName.resize(uniformName.size() - kFirstElement.size());
+            }
+            RLint location = RLFunc(rlGetUniformLocation(m_program, uniformName.c_str()));
+            m_uniformLocations.emplace(std::move(uniformName), location);
+        }
+
+        RLint blockCount = 0;
+        RLFunc(rlGetProgramiv(m_program, RL_ACTIVE_UNIFORM_BLOCKS, &blockCount));
+        for (RLint ii = 0; ii < blockCount; ++ii) {
+            RLsize length = 0;
+            RLint fieldCount = 0;
+            RLsize blockSize = 0;
+            RLFunc(rlGetActiveUniformBlock(m_program, ii, name.size(), &length, name.data(), &fieldCount, &blockSize));
+            std::string blockName(name.data(), std::min<size_t>(length, name.size() - 1));
+            RLint index = RLFunc(rlGetUniformBlockIndex(m_program, blockName.c_str()));
+            m_uniformBlockIndices.emplace(std::move(blockName), index);
+        }
+    }
+
+    static constexpr size_t kMaxBlockNameLength = 256; // OpenRL has no query for the longest uniform block name.
+
     RLprogram m_program = RL_NULL_PROGRAM; // RL program object.
 
+    // Uniform locations and uniform block indices by name. std::less<> allows lookups by std::string_view without
+    // creating a std::string. Inactive names are cached with -1 the same as active ones.
+    using LocationCache = std::map<std::string, RLint, std::less<>>;
+    mutable LocationCache m_uniformLocations;
+    mutable LocationCache m_uniformBlockIndices;
+
     // We allow for one attached shader per shader type.
     std::shared_ptr<Shader> m_attachedShaders[static_cast<uint8_t>(Shader::ShaderType::kCount)];
 };
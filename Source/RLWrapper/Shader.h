@@ -51,22 +51,22 @@ public:
     static std::shared_ptr<Shader> createFromString(const std::string_view shaderSource, const ShaderType type, const std::string_view name)
     {
         if (shaderSource.length()) {
-            Shader* shader = new Shader(type);
+            std::shared_ptr<Shader> shader(new Shader(type)); // Deleted again if it fails to compile.
             RLFunc(rlShaderString(shader->shader(), RL_SHADER_NAME, name.data()));
 
             const char* s = shaderSource.data();
             RLFunc(rlShaderSource(shader->shader(), 1, &s, nullptr));
 
             if (shader->compile()) {
-                return std::shared_ptr<Shader>(shader);
+                return shader;
             } else {
                 const char* log = nullptr;
                 RLFunc(rlGetShaderString(shader->shader(), RL_COMPILE_LOG, &log));
-                LOG_ERROR("Unable to compile shader %s \n\t%s", name, log);
+                LOG_ERROR("Unable to compile shader %s \n\t%s", name.data(), log);
                 return nullptr;
             }
         } else {
-            LOG_ERROR("Attempting to build shader \"%s\" with an empty source file!", name);
+            LOG_ERROR("Attempting to build shader \"%s\" with an empty source file!", name.data());
         }
 
         return nullptr;
@@ -80,7 +80,7 @@ public:
         assert(shaderSource.size() < MAX_NUM_SHADER_STRINGS);
 
         if (shaderSource.size()) {
-            Shader* shader = new Shader(type);
+            std::shared_ptr<Shader> shader(new Shader(type)); // Deleted again if it fails to compile.
             RLFunc(rlShaderString(shader->shader(), RL_SHADER_NAME, name.data()));
 
             const char* strings[MAX_NUM_SHADER_STRINGS];
@@ -92,15 +92,15 @@ public:
             RLFunc(rlShaderSource(shader->shader(), shaderSource.size(), &strings[0], nullptr));
 
             if (shader->compile()) {
-                return std::shared_ptr<Shader>(shader);
+                return shader;
             } else {
                 const char* log = nullptr;
                 RLFunc(rlGetShaderString(shader->shader(), RL_COMPILE_LOG, &log));
-                LOG_ERROR("Unable to compile %s for %s \n\t%s", m_typeToNameTable[static_cast<const uint8_t>(type)], name, log);
+                LOG_ERROR("Unable to compile %s for %s \n\t%s", m_typeToNameTable[static_cast<const uint8_t>(type)].data(), name.data(), log);
                 return nullptr;
             }
         } else {
-            LOG_ERROR("Attempting to build %s for \"%s\" with an empty source file!", m_typeToNameTable[static_cast<const uint8_t>(type)], name.data());
+            LOG_ERROR("Attempting to build %s for \"%s\" with an empty source file!", m_typeToNameTable[static_cast<const uint8_t>(type)].data(), name.data());
         }
 
         return nullptr;
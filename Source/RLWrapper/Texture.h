@@ -9,10 +9,13 @@
 #pragma once
 
 #include "Error.h"
+#include "MemoryTracker.h"
 
 #include <OpenRL/rl.h>
 #include <assert.h>
 #include <memory>
+#include <string>
+#include <string_view>
 
 namespace openrl {
 
@@ -60,14 +63,18 @@ public:
         if (m_texture != RL_NULL_TEXTURE) {
             RLFunc(rlDeleteTextures(1, &m_texture));
             m_texture = RL_NULL_TEXTURE;
+            MemoryTracker::instance().remove(MemoryTracker::Category::kTexture, m_name, m_sizeInBytes);
         }
     }
 
     //-------------------------------------------------------------------------
-    // Creates a new texture with the passed in data pointer.
-    static std::shared_ptr<Texture> create(const void* data, const Descriptor& desc, const Sampler& sampler, bool generateMips = true)
+    // Creates a new texture with the passed in data pointer. 'name' (e.g. the
+    // path the texture was loaded from) identifies the texture in the
+    // MemoryTracker.
+    static std::shared_ptr<Texture> create(const void* data, const Descriptor& desc, const Sampler& sampler, bool generateMips = true,
+                                           const std::string_view name = "<unnamed>")
     {
-        Texture* texture = new Texture(desc, sampler);
+        Texture* texture = new Texture(desc, sampler, name);
 
         RLFunc(rlBindTexture(RL_TEXTURE_2D, texture->texture()));
 
@@ -87,14 +94,16 @@ public:
         }
         RLFunc(rlBindTexture(RL_TEXTURE_2D, RL_NULL_TEXTURE));
 
+        texture->trackSize(generateMips);
         return std::shared_ptr<Texture>(texture);
     }
 
     //-------------------------------------------------------------------------
     // Creates a new 3D texture with the passed in data-pointer.
-    static std::shared_ptr<Texture> create3D(const void* data, const Descriptor& desc, const Sampler& sampler, bool generateMips = true)
+    static std::shared_ptr<Texture> create3D(const void* data, const Descriptor& desc, const Sampler& sampler, bool generateMips = true,
+                                             const std::string_view name = "<unnamed>")
     {
-        Texture* texture = new Texture(desc, sampler);
+        Texture* texture = new Texture(desc, sampler, name);
 
         RLFunc(rlBindTexture(RL_TEXTURE_3D, texture->texture()));
 
@@ -115,6 +124,7 @@ public:
         }
         RLFunc(rlBindTexture(RL_TEXTURE_3D, RL_NULL_TEXTURE));
 
+        texture->trackSize(generateMips);
         return std::shared_ptr<Texture>(texture);
     }
 
@@ -139,6 +149,7 @@ public:
 
         m_desc.width = newWidth;
         m_desc.height = newHeight;
+        trackSize(false);
     }
 
     //-------------------------------------------------------------------------
@@ -163,6 +174,28 @@ public:
 
         m_desc.width = newWidth;
         m_desc.height = newHeight;
+        m_desc.depth = newDepth;
+        trackSize(false);
+    }
+
+    //-------------------------------------------------------------------------
+    // Replace the contents of the texture with new data. The data must match
+    // the current dimensions and descriptor of this texture.
+    inline void setData(const void* data)
+    {
+        assert(valid());
+
+        RLFunc(rlBindTexture(RL_TEXTURE_2D, m_texture));
+        RLFunc(rlTexImage2D(RL_TEXTURE_2D,
+                            0,
+                            m_desc.internalFormat,
+                            m_desc.width,
+                            m_desc.height,
+                            0,
+                            m_desc.format,
+                            m_desc.dataType,
+                            data));
+        RLFunc(rlBindTexture(RL_TEXTURE_2D, 0));
     }
 
     //-------------------------------------------------------------------------
@@ -170,6 +203,8 @@ public:
     inline const RLint width() const { return m_desc.width; }
     inline const RLint height() const { return m_desc.height; }
     inline RLtexture texture() const { return m_texture; }
+    inline size_t size() const { return m_sizeInBytes; } // Approximate, in bytes.
+    inline const std::string& name() const { return m_name; }
     inline bool valid() const { return (m_texture != RL_NULL_TEXTURE); }
 
     //-------------------------------------------------------------------------
@@ -184,7 +219,7 @@ public:
             Texture::Descriptor desc;
             desc.width = desc.height = 1;
             float whitePixel[4] = { 1.0f, 1.0f, 1.0f, 1.0f };
-            texture = Texture::create(whitePixel, desc, Texture::Sampler(), false);
+            texture = Texture::create(whitePixel, desc, Texture::Sampler(), false, "Dummy texture");
             dummyTexture = texture;
         }
 
@@ -192,11 +227,20 @@ public:
     }
 
 private:
-    explicit Texture(const Descriptor& desc, const Sampler& sampler)
+    explicit Texture(const Descriptor& desc, const Sampler& sampler, const std::string_view name)
         : m_desc(desc)
         , m_sampler(sampler)
+        , m_name(name)
     {
         RLFunc(rlGenTextures(1, &m_texture));
+        MemoryTracker::instance().add(MemoryTracker::Category::kTexture, m_name, 0);
+    }
+
+    inline void trackSize(bool mipmapped)
+    {
+        size_t sizeInBytes = MemoryTracker::textureByteCount(m_desc.format, m_desc.dataType, m_desc.width, m_desc.height, m_desc.depth, mipmapped);
+        MemoryTracker::instance().resize(MemoryTracker::Category::kTexture, m_name, m_sizeInBytes, sizeInBytes);
+        m_sizeInBytes = sizeInBytes;
     }
 
     inline void applySampler(RLenum type = RL_TEXTURE_2D) const
@@ -214,6 +258,9 @@ private:
     RLtexture   m_texture = RL_NULL_TEXTURE; // OpenRL texture object itself.
     Descriptor  m_desc;     // Descriptor used to create the texture.
     Sampler     m_sampler;  // Sampler to use for this texture.
+
+    std::string m_name;            // Owner of the texture in the MemoryTracker.
+    size_t      m_sizeInBytes = 0; // Size reported to the MemoryTracker.
 };
 
 } // namespace openrl
@@ -46,7 +46,7 @@ struct AABB {
     float bottom() const {
         glm::vec3 transformedMin = transform * glm::vec4(min, 1.0f);
         glm::vec3 transformedMax = transform * glm::vec4(max, 1.0f);
-        float floor = center().y - std::fabsf(transformedMax.y - transformedMin.y) * 0.5f;
+        float floor = center().y - std::abs(transformedMax.y - transformedMin.y) * 0.5f;
         return floor;
     }
     
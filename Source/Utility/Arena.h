@@ -0,0 +1,69 @@
+//
+//  Arena.h
+//  Heatray
+//
+//  Monotonic memory resource for data that is built up during a scene load
+//  and released all at once when the load is done.
+//
+//
+
+#pragma once
+
+#include <memory_resource>
+#include <mutex>
+#include <stddef.h>
+
+namespace util {
+
+//-------------------------------------------------------------------------
+// Thread-safe wrapper around std::pmr::monotonic_buffer_resource so that a
+// single arena can be filled by parallelFor() workers. Individual
+// deallocations are ignored, everything is freed when the arena is
+// destroyed. Only suited to allocations that live roughly as long as the
+// arena itself.
+class Arena : public std::pmr::memory_resource
+{
+public:
+    explicit Arena(size_t initialSize = kDefaultInitialSize) : m_resource(initialSize) {}
+
+    size_t allocationCount() const
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_allocationCount;
+    }
+
+    size_t bytesAllocated() const
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_bytesAllocated;
+    }
+
+    static constexpr size_t kDefaultInitialSize = 64 * 1024;
+
+private:
+    // This class is not copyable.
+    Arena(const Arena& other) = delete;
+    Arena& operator=(const Arena& other) = delete;
+
+    void* do_allocate(size_t bytes, size_t alignment) override
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        ++m_allocationCount;
+        m_bytesAllocated += bytes;
+        return m_resource.allocate(bytes, alignment);
+    }
+
+    void do_deallocate(void* /*p*/, size_t /*bytes*/, size_t /*alignment*/) override {}
+
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override
+    {
+        return (this == &other);
+    }
+
+    mutable std::mutex m_mutex; // Guards everything below.
+    std::pmr::monotonic_buffer_resource m_resource;
+    size_t m_allocationCount = 0;
+    size_t m_bytesAllocated = 0;
+};
+
+} // namespace util.
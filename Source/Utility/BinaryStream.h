@@ -0,0 +1,114 @@
+//
+//  BinaryStream.h
+//  Heatray
+//
+//  Helpers for serializing plain data into a byte buffer and reading it
+//  back with bounds checking.
+//
+//
+
+#pragma once
+
+#include <cstring>
+#include <stddef.h>
+#include <stdint.h>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+namespace util {
+
+class BinaryWriter
+{
+public:
+    template<class T>
+    void write(const T& value)
+    {
+        static_assert(std::is_trivially_copyable_v<T>, "Only plain data can be written directly");
+        writeBytes(&value, sizeof(T));
+    }
+
+    void writeString(const std::string_view string)
+    {
+        write(uint64_t(string.size()));
+        writeBytes(string.data(), string.size());
+    }
+
+    void writeBytes(const void* data, size_t size)
+    {
+        const uint8_t* bytes = static_cast<const uint8_t*>(data);
+        m_buffer.insert(m_buffer.end(), bytes, bytes + size);
+    }
+
+    //-------------------------------------------------------------------------
+    // Pad the buffer with zeros until its size is a multiple of 'alignment'.
+    void align(size_t alignment)
+    {
+        m_buffer.resize((m_buffer.size() + alignment - 1) / alignment * alignment, 0);
+    }
+
+    const std::vector<uint8_t>& buffer() const { return m_buffer; }
+    size_t size() const { return m_buffer.size(); }
+
+private:
+    std::vector<uint8_t> m_buffer;
+};
+
+class BinaryReader
+{
+public:
+    BinaryReader(const uint8_t* data, size_t size) : m_data(data), m_size(size) {}
+
+    //-------------------------------------------------------------------------
+    // All read functions return false once the reader has run past the end of
+    // the data. Reading past the end is sticky, so a sequence of reads can be
+    // checked once at the end with valid().
+    template<class T>
+    bool read(T& value)
+    {
+        static_assert(std::is_trivially_copyable_v<T>, "Only plain data can be read directly");
+        const uint8_t* bytes = readBytes(sizeof(T));
+        if (bytes) {
+            std::memcpy(&value, bytes, sizeof(T));
+        }
+        return (bytes != nullptr);
+    }
+
+    bool readString(std::string& string)
+    {
+        uint64_t length = 0;
+        if (!read(length) || (length > remaining())) {
+            m_valid = false;
+            return false;
+        }
+        string.assign(reinterpret_cast<const char*>(readBytes(size_t(length))), size_t(length));
+        return true;
+    }
+
+    //-------------------------------------------------------------------------
+    // Returns a pointer to the next 'size' bytes and advances past them, or
+    // nullptr if there are not enough bytes left.
+    const uint8_t* readBytes(size_t size)
+    {
+        if (!m_valid || (size > remaining())) {
+            m_valid = false;
+            return nullptr;
+        }
+        const uint8_t* bytes = m_data + m_position;
+        m_position += size;
+        return bytes;
+    }
+
+    size_t remaining() const { return m_size - m_position; }
+    size_t position() const { return m_position; }
+    bool valid() const { return m_valid; }
+
+private:
+    const uint8_t* m_data = nullptr;
+    size_t m_size = 0;
+    size_t m_position = 0;
+    bool m_valid = true;
+};
+
+} // namespace util.
@@ -1,32 +1,126 @@
-#include "FileIO.h"
-
-#include "Log.h"
-
-#include <fstream>
-
-namespace util {
-
-bool readTextFile(const std::string_view filename, std::string& content)
-{
-    std::ifstream fin;
-    fin.open(std::string(filename));
-    if (!fin) {
-        // Attempt to look one directory back, just in case.
-        fin.open("../" + std::string(filename));
-        if (!fin) {
-            LOG_ERROR("Unable to open file %s", filename);
-            return false;
-        }
-    }
-
-    // Size the string to get ready for the file.
-    fin.seekg(0, std::ios::end);    // Move the stream to the end of the file.
-    content.reserve(fin.gcount());  // Get the number of characters in the file.
-    fin.seekg(0, std::ios::beg);    // Move the stream back to the beginning of the file.
-
-    content.assign(std::istreambuf_iterator<char>(fin), std::istreambuf_iterator<char>());
-    fin.close();
-    return true;
-}
-
-} // namespace util.
+#include "FileIO.h"
+
+#include "Log.h"
+
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+
+#if defined(_WIN32)
+    #ifndef NOMINMAX
+        #define NOMINMAX
+    #endif
+    #include <windows.h>
+#else
+    #include <fcntl.h>
+    #include <unistd.h>
+#endif
+
+namespace util {
+
+bool readTextFile(const std::string_view filename, std::string& content)
+{
+    std::ifstream fin;
+    fin.open(std::string(filename));
+    if (!fin) {
+        // Attempt to look one directory back, just in case.
+        fin.open("../" + std::string(filename));
+        if (!fin) {
+            LOG_ERROR("Unable to open file %s", std::string(filename).c_str());
+            return false;
+        }
+    }
+
+    // Size the string to get ready for the file.
+    fin.seekg(0, std::ios::end);    // Move the stream to the end of the file.
+    content.reserve(fin.gcount());  // Get the number of characters in the file.
+    fin.seekg(0, std::ios::beg);    // Move the stream back to the beginning of the file.
+
+    content.assign(std::istreambuf_iterator<char>(fin), std::istreambuf_iterator<char>());
+    fin.close();
+    return true;
+}
+
+bool syncFile(const std::string_view path)
+{
+    std::string filename(path);
+
+#if defined(_WIN32)
+    HANDLE file = CreateFileA(filename.c_str(), GENERIC_WRITE, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        return false;
+    }
+    bool result = FlushFileBuffers(file);
+    CloseHandle(file);
+    return result;
+#else
+    int fd = ::open(filename.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+    bool result = (::fsync(fd) == 0);
+    ::close(fd);
+    return result;
+#endif
+}
+
+bool syncDirectory(const std::string_view path)
+{
+#if defined(_WIN32)
+    (void)path;
+    return true;
+#else
+    std::string directory = path.empty() ? std::string(".") : std::string(path);
+    int fd = ::open(directory.c_str(), O_RDONLY | O_DIRECTORY);
+    if (fd < 0) {
+        return false;
+    }
+    bool result = (::fsync(fd) == 0);
+    ::close(fd);
+    return result;
+#endif
+}
+
+const std::string& userCacheDirectory()
+{
+    static const std::string directory = []() {
+        auto fromEnvironment = [](const char* variable) {
+            const char* value = std::getenv(variable);
+            return (value && *value) ? std::filesystem::path(value) : std::filesystem::path();
+        };
+
+#if defined(_WIN32)
+        std::filesystem::path path = fromEnvironment("LOCALAPPDATA");
+        if (!path.empty()) {
+            path /= "Heatray";
+        }
+#elif defined(__APPLE__)
+        std::filesystem::path path = fromEnvironment("HOME");
+        if (!path.empty()) {
+            path = path / "Library" / "Caches" / "Heatray";
+        }
+#else
+        std::filesystem::path path = fromEnvironment("XDG_CACHE_HOME");
+        if (path.empty()) {
+            path = fromEnvironment("HOME");
+            if (!path.empty()) {
+                path /= ".cache";
+            }
+        }
+        if (!path.empty()) {
+            path /= "heatray";
+        }
+#endif
+
+        std::error_code error;
+        if (path.empty() || (!std::filesystem::create_directories(path, error) && error)) {
+            path = "heatray_cache";
+            std::filesystem::create_directories(path, error);
+        }
+        return path.string();
+    }();
+
+    return directory;
+}
+
+} // namespace util.
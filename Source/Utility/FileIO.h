@@ -1,21 +1,40 @@
-//
-//  FileIO.h
-//  Heatray
-//
-//  Simple wrappers around FileIO concepts necessary for loading/saving text files.
-//
-//
-
-#pragma once
-
-#include <string>
-#include <string_view>
-
-namespace util {
- 
-//-------------------------------------------------------------------------
-// Read a text file and return its contents in a string. Returns true if
-// the file was successfully read.
-bool readTextFile(const std::string_view filename, std::string& content);
-
-}  // namespace util.
+//
+//  FileIO.h
+//  Heatray
+//
+//  Simple wrappers around FileIO concepts necessary for loading/saving text files.
+//
+//
+
+#pragma once
+
+#include <string>
+#include <string_view>
+
+namespace util {
+ 
+//-------------------------------------------------------------------------
+// Read a text file and return its contents in a string. Returns true if
+// the file was successfully read.
+bool readTextFile(const std::string_view filename, std::string& content);
+
+//-------------------------------------------------------------------------
+// Flush the contents of a file that has already been written and closed
+// to storage (fsync/FlushFileBuffers). Returns true on success.
+bool syncFile(const std::string_view path);
+
+//-------------------------------------------------------------------------
+// Flush a directory's entries to storage so that a file just renamed into
+// it survives a crash. Only meaningful on POSIX, a no-op on Windows where
+// the rename itself is journaled. Returns true on success.
+bool syncDirectory(const std::string_view path);
+
+//-------------------------------------------------------------------------
+// Directory for files that Heatray can regenerate (e.g. caches and render
+// checkpoints), created on first use. This is $XDG_CACHE_HOME/heatray or
+// ~/.cache/heatray on Linux, ~/Library/Caches/Heatray on macOS and
+// %LOCALAPPDATA%\Heatray on Windows. Falls back to a directory named
+// "heatray_cache" in the working directory if none of those are available.
+const std::string& userCacheDirectory();
+
+}  // namespace util.
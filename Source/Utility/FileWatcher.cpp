@@ -0,0 +1,171 @@
+#include "FileWatcher.h"
+
+#include "Log.h"
+
+#include <filesystem>
+
+#if defined(__linux__)
+    #include <errno.h>
+    #include <string.h>
+    #include <sys/inotify.h>
+    #include <unistd.h>
+#endif
+
+namespace util {
+
+bool FileWatcher::start(const std::string_view directory, const std::string_view extension, float debounceTime)
+{
+    stop();
+
+    m_directory = std::string(directory);
+    m_extension = std::string(extension);
+    m_debounceTime = debounceTime;
+
+#if defined(__linux__)
+    m_inotify = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (m_inotify == -1) {
+        LOG_ERROR("Unable to initialize inotify: %s", strerror(errno));
+        return false;
+    }
+
+    // Editors either write the file in place or write a new file and move it over the old one.
+    if (inotify_add_watch(m_inotify, m_directory.c_str(), IN_CLOSE_WRITE | IN_MODIFY | IN_CREATE | IN_MOVED_TO) == -1) {
+        LOG_ERROR("Unable to watch %s: %s", m_directory.c_str(), strerror(errno));
+        ::close(m_inotify);
+        m_inotify = -1;
+        return false;
+    }
+#else
+    // The first scan only records the current state of the files.
+    bool changed = false;
+    if (!scanDirectory(changed)) {
+        LOG_ERROR("Unable to watch %s", m_directory.c_str());
+        return false;
+    }
+    m_pendingChanges.clear();
+    m_pollTimer.start();
+
+    // Changes are seen up to a poll interval late. Waiting for one more scan makes sure a burst is over.
+    m_debounceTime += kPollInterval;
+#endif
+
+    m_watching = true;
+    return true;
+}
+
+void FileWatcher::stop()
+{
+#if defined(__linux__)
+    if (m_inotify != -1) {
+        ::close(m_inotify);
+        m_inotify = -1;
+    }
+#else
+    m_modifiedTimes.clear();
+    m_pollTimer.stop();
+#endif
+
+    m_pendingChanges.clear();
+    m_quietTimer.stop();
+    m_watching = false;
+}
+
+std::vector<std::string> FileWatcher::poll()
+{
+    if (!m_watching) {
+        return {};
+    }
+
+    if (readChanges()) {
+        m_quietTimer.restart();
+    }
+    if (m_pendingChanges.empty() || (m_quietTimer.getElapsedTime() < m_debounceTime)) {
+        return {};
+    }
+
+    std::vector<std::string> changes(m_pendingChanges.begin(), m_pendingChanges.end());
+    m_pendingChanges.clear();
+    return changes;
+}
+
+bool FileWatcher::matchesExtension(const std::string_view filename) const
+{
+    return (filename.size() >= m_extension.size()) && (filename.substr(filename.size() - m_extension.size()) == m_extension);
+}
+
+#if defined(__linux__)
+
+bool FileWatcher::readChanges()
+{
+    bool changed = false;
+
+    // The descriptor is non-blocking so this stops as soon as there are no more events queued.
+    alignas(inotify_event) char buffer[4096];
+    ssize_t length = 0;
+    while ((length = ::read(m_inotify, buffer, sizeof(buffer))) > 0) {
+        for (char* event = buffer; event < buffer + length;) {
+            const inotify_event* info = reinterpret_cast<const inotify_event*>(event);
+            event += sizeof(inotify_event) + info->len;
+
+            // The name is padded with null characters.
+            const std::string_view filename = (info->len > 0) ? std::string_view(info->name) : std::string_view();
+            if (!filename.empty() && !(info->mask & IN_ISDIR) && matchesExtension(filename)) {
+                m_pendingChanges.emplace(filename);
+                changed = true;
+            }
+        }
+    }
+
+    return changed;
+}
+
+#else
+
+bool FileWatcher::readChanges()
+{
+    if (m_pollTimer.getElapsedTime() < kPollInterval) {
+        return false;
+    }
+    m_pollTimer.restart();
+
+    bool changed = false;
+    scanDirectory(changed);
+    return changed;
+}
+
+bool FileWatcher::scanDirectory(bool& changed)
+{
+    std::error_code error;
+    std::filesystem::directory_iterator iter(m_directory, error);
+    if (error) {
+        return false;
+    }
+
+    for (const std::filesystem::directory_entry& entry : iter) {
+        const std::string filename = entry.path().filename().string();
+        if (!entry.is_regular_file(error) || !matchesExtension(filename)) {
+            continue;
+        }
+
+        const int64_t modifiedTime = int64_t(entry.last_write_time(error).time_since_epoch().count());
+        if (error) {
+            continue;
+        }
+
+        auto [timeIter, inserted] = m_modifiedTimes.try_emplace(filename, modifiedTime);
+        if (!inserted && (timeIter->second != modifiedTime)) {
+            timeIter->second = modifiedTime;
+            inserted = true;
+        }
+        if (inserted) {
+            m_pendingChanges.insert(filename);
+            changed = true;
+        }
+    }
+
+    return true;
+}
+
+#endif
+
+} // namespace util.
@@ -0,0 +1,88 @@
+//
+//  FileWatcher.h
+//  Heatray
+//
+//  Reports files in a directory that have been written to.
+//
+//
+
+#pragma once
+
+#include "Timer.h"
+
+#include <set>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#if !defined(__linux__)
+#include <unordered_map>
+#endif
+
+namespace util {
+
+//-------------------------------------------------------------------------
+// Watches the files directly inside of a directory. Uses inotify on Linux
+// and elsewhere compares modification times every kPollInterval seconds.
+// Changes are only reported once no further change has been seen for the
+// debounce time, so that a burst of writes (e.g. an editor saving a file in
+// several steps or a version control checkout) results in a single report.
+class FileWatcher
+{
+public:
+    static constexpr float kDefaultDebounceTime = 0.2f; // In seconds.
+    static constexpr float kPollInterval = 0.25f; // In seconds, only used without inotify.
+
+    FileWatcher() = default;
+    ~FileWatcher() { stop(); }
+
+    //-------------------------------------------------------------------------
+    // Start watching the files in 'directory' whose names end in 'extension'
+    // (all files if it is empty). Returns false if the directory can't be
+    // watched.
+    bool start(const std::string_view directory, const std::string_view extension, float debounceTime = kDefaultDebounceTime);
+
+    //-------------------------------------------------------------------------
+    // Stop watching, any changes that have not been reported are dropped.
+    void stop();
+
+    //-------------------------------------------------------------------------
+    // Returns the names (relative to the watched directory) of the files that
+    // changed since the last report if the debounce time has passed since the
+    // latest change, otherwise nothing. Meant to be called regularly, e.g.
+    // once per frame.
+    std::vector<std::string> poll();
+
+    bool watching() const { return m_watching; }
+    const std::string& directory() const { return m_directory; }
+
+private:
+    // This class is not copyable.
+    FileWatcher(const FileWatcher& other) = delete;
+    FileWatcher& operator=(const FileWatcher& other) = delete;
+
+    // Adds the files that changed since the last call to m_pendingChanges. Returns true if any did.
+    bool readChanges();
+    bool matchesExtension(const std::string_view filename) const;
+
+    std::string m_directory;
+    std::string m_extension;
+    float m_debounceTime = kDefaultDebounceTime;
+    bool m_watching = false;
+
+    std::set<std::string> m_pendingChanges;
+    Timer m_quietTimer; // Time since the latest change.
+
+#if defined(__linux__)
+    int m_inotify = -1;
+#else
+    // Adds new and modified files to m_pendingChanges, 'changed' is set if there were any. Returns false if the
+    // directory can't be read.
+    bool scanDirectory(bool& changed);
+
+    std::unordered_map<std::string, int64_t> m_modifiedTimes; // key = file name.
+    Timer m_pollTimer;
+#endif
+};
+
+} // namespace util.
@@ -0,0 +1,440 @@
+#include "Json.h"
+
+#include <assert.h>
+#include <cmath>
+#include <cstdlib>
+
+namespace util {
+
+namespace {
+
+class Parser
+{
+public:
+    explicit Parser(const std::string_view text) : m_text(text) {}
+
+    bool parseDocument(JsonValue& value)
+    {
+        skipWhitespace();
+        if (!parseValue(value, 0)) {
+            return false;
+        }
+        skipWhitespace();
+        if (m_position != m_text.size()) {
+            return fail("Unexpected trailing characters");
+        }
+        return true;
+    }
+
+    const std::string& error() const { return m_error; }
+
+private:
+    static constexpr int kMaxDepth = 256;
+
+    bool fail(const char* message)
+    {
+        if (m_error.empty()) {
+            m_error = std::string(message) + " at offset " + std::to_string(m_position);
+        }
+        return false;
+    }
+
+    void skipWhitespace()
+    {
+        while (m_position < m_text.size()) {
+            char c = m_text[m_position];
+            if ((c != ' ') && (c != '\t') && (c != '\n') && (c != '\r')) {
+                break;
+            }
+            ++m_position;
+        }
+    }
+
+    bool consume(char c)
+    {
+        skipWhitespace();
+        if ((m_position < m_text.size()) && (m_text[m_position] == c)) {
+            ++m_position;
+            return true;
+        }
+        return false;
+    }
+
+    bool consumeLiteral(const std::string_view literal)
+    {
+        if (m_text.substr(m_position, literal.size()) == literal) {
+            m_position += literal.size();
+            return true;
+        }
+        return false;
+    }
+
+    bool parseValue(JsonValue& value, int depth)
+    {
+        if (depth > kMaxDepth) {
+            return fail("Document is nested too deeply");
+        }
+
+        skipWhitespace();
+        if (m_position >= m_text.size()) {
+            return fail("Unexpected end of document");
+        }
+
+        char c = m_text[m_position];
+        switch (c) {
+            case '{':
+                return parseObject(value, depth);
+            case '[':
+                return parseArray(value, depth);
+            case '"':
+            {
+                std::string string;
+                if (!parseString(string)) {
+                    return false;
+                }
+                value = JsonValue(std::move(string));
+                return true;
+            }
+            case 't':
+                if (consumeLiteral("true")) {
+                    value = JsonValue(true);
+                    return true;
+                }
+                return fail("Invalid literal");
+            case 'f':
+                if (consumeLiteral("false")) {
+                    value = JsonValue(false);
+                    return true;
+                }
+                return fail("Invalid literal");
+            case 'n':
+                if (consumeLiteral("null")) {
+                    value = JsonValue();
+                    return true;
+                }
+                return fail("Invalid literal");
+            default:
+                return parseNumber(value);
+        }
+    }
+
+    bool parseObject(JsonValue& value, int depth)
+    {
+        ++m_position; // '{'
+        value = JsonValue::object();
+        if (consume('}')) {
+            return true;
+        }
+
+        do {
+            skipWhitespace();
+            if ((m_position >= m_text.size()) || (m_text[m_position] != '"')) {
+                return fail("Expected object key");
+            }
+            std::string key;
+            if (!parseString(key)) {
+                return false;
+            }
+            if (!consume(':')) {
+                return fail("Expected ':'");
+            }
+            JsonValue member;
+            if (!parseValue(member, depth + 1)) {
+                return false;
+            }
+            value.set(key, std::move(member));
+        } while (consume(','));
+
+        if (!consume('}')) {
+            return fail("Expected '}'");
+        }
+        return true;
+    }
+
+    bool parseArray(JsonValue& value, int depth)
+    {
+        ++m_position; // '['
+        value = JsonValue::array();
+        if (consume(']')) {
+            return true;
+        }
+
+        do {
+            JsonValue element;
+            if (!parseValue(element, depth + 1)) {
+                return false;
+            }
+            value.append(std::move(element));
+        } while (consume(','));
+
+        if (!consume(']')) {
+            return fail("Expected ']'");
+        }
+        return true;
+    }
+
+    static void appendUTF8(std::string& out, uint32_t codepoint)
+    {
+        if (codepoint < 0x80) {
+            out.push_back(char(codepoint));
+        } else if (codepoint < 0x800) {
+            out.push_back(char(0xC0 | (codepoint >> 6)));
+            out.push_back(char(0x80 | (codepoint & 0x3F)));
+        } else if (codepoint < 0x10000) {
+            out.push_back(char(0xE0 | (codepoint >> 12)));
+            out.push_back(char(0x80 | ((codepoint >> 6) & 0x3F)));
+            out.push_back(char(0x80 | (codepoint & 0x3F)));
+        } else {
+            out.push_back(char(0xF0 | (codepoint >> 18)));
+            out.push_back(char(0x80 | ((codepoint >> 12) & 0x3F)));
+            out.push_back(char(0x80 | ((codepoint >> 6) & 0x3F)));
+            out.push_back(char(0x80 | (codepoint & 0x3F)));
+        }
+    }
+
+    bool parseHex4(uint32_t& codepoint)
+    {
+        if (m_position + 4 > m_text.size()) {
+            return fail("Truncated unicode escape");
+        }
+        codepoint = 0;
+        for (int i = 0; i < 4; ++i) {
+            char c = m_text[m_position++];
+            codepoint <<= 4;
+            if ((c >= '0') && (c <= '9')) {
+                codepoint |= uint32_t(c - '0');
+            } else if ((c >= 'a') && (c <= 'f')) {
+                codepoint |= uint32_t(c - 'a' + 10);
+            } else if ((c >= 'A') && (c <= 'F')) {
+                codepoint |= uint32_t(c - 'A' + 10);
+            } else {
+                return fail("Invalid unicode escape");
+            }
+        }
+        return true;
+    }
+
+    bool parseString(std::string& out)
+    {
+        ++m_position; // Opening quote.
+        while (m_position < m_text.size()) {
+            char c = m_text[m_position++];
+            if (c == '"') {
+                return true;
+            }
+            if (c != '\\') {
+                out.push_back(c);
+                continue;
+            }
+
+            if (m_position >= m_text.size()) {
+                break;
+            }
+            char escape = m_text[m_position++];
+            switch (escape) {
+                case '"':  out.push_back('"'); break;
+                case '\\': out.push_back('\\'); break;
+                case '/':  out.push_back('/'); break;
+                case 'b':  out.push_back('\b'); break;
+                case 'f':  out.push_back('\f'); break;
+                case 'n':  out.push_back('\n'); break;
+                case 'r':  out.push_back('\r'); break;
+                case 't':  out.push_back('\t'); break;
+                case 'u':
+                {
+                    uint32_t codepoint = 0;
+                    if (!parseHex4(codepoint)) {
+                        return false;
+                    }
+                    // Combine surrogate pairs.
+                    if ((codepoint >= 0xD800) && (codepoint <= 0xDBFF) && consumeLiteral("\\u")) {
+                        uint32_t low = 0;
+                        if (!parseHex4(low)) {
+                            return false;
+                        }
+                        codepoint = 0x10000 + ((codepoint - 0xD800) << 10) + (low - 0xDC00);
+                    }
+                    appendUTF8(out, codepoint);
+                    break;
+                }
+                default:
+                    return fail("Invalid escape sequence");
+            }
+        }
+        return fail("Unterminated string");
+    }
+
+    bool parseNumber(JsonValue& value)
+    {
+        size_t start = m_position;
+        while (m_position < m_text.size()) {
+            char c = m_text[m_position];
+            if (((c >= '0') && (c <= '9')) || (c == '-') || (c == '+') || (c == '.') || (c == 'e') || (c == 'E')) {
+                ++m_position;
+            } else {
+                break;
+            }
+        }
+        if (start == m_position) {
+            return fail("Unexpected character");
+        }
+
+        std::string number(m_text.substr(start, m_position - start));
+        char* end = nullptr;
+        double result = std::strtod(number.c_str(), &end);
+        if (end != number.c_str() + number.size()) {
+            return fail("Invalid number");
+        }
+        value = JsonValue(result);
+        return true;
+    }
+
+    std::string_view m_text;
+    size_t m_position = 0;
+    std::string m_error;
+};
+
+void serializeString(const std::string& string, std::string& out)
+{
+    out.push_back('"');
+    for (char c : string) {
+        switch (c) {
+            case '"':  out += "\\\""; break;
+            case '\\': out += "\\\\"; break;
+            case '\n': out += "\\n"; break;
+            case '\r': out += "\\r"; break;
+            case '\t': out += "\\t"; break;
+            default:
+                if (static_cast<unsigned char>(c) < 0x20) {
+                    static constexpr char kHex[] = "0123456789abcdef";
+                    out += "\\u00";
+                    out.push_back(kHex[(c >> 4) & 0xF]);
+                    out.push_back(kHex[c & 0xF]);
+                } else {
+                    out.push_back(c);
+                }
+                break;
+        }
+    }
+    out.push_back('"');
+}
+
+const JsonValue kNullValue;
+
+} // namespace.
+
+bool JsonValue::parse(const std::string_view text, JsonValue& value, std::string* error)
+{
+    Parser parser(text);
+    if (!parser.parseDocument(value)) {
+        if (error) {
+            *error = parser.error();
+        }
+        value = JsonValue();
+        return false;
+    }
+    return true;
+}
+
+std::string JsonValue::serialize() const
+{
+    std::string out;
+    serialize(out);
+    return out;
+}
+
+void JsonValue::serialize(std::string& out) const
+{
+    switch (m_type) {
+        case Type::kNull:
+            out += "null";
+            break;
+        case Type::kBool:
+            out += m_bool ? "true" : "false";
+            break;
+        case Type::kNumber:
+        {
+            if (!std::isfinite(m_number)) {
+                out += "null"; // JSON has no representation for inf/nan.
+            } else if ((m_number == std::floor(m_number)) && (std::fabs(m_number) < 1e15)) {
+                out += std::to_string(int64_t(m_number));
+            } else {
+                char buffer[32];
+                snprintf(buffer, sizeof(buffer), "%.9g", m_number);
+                out += buffer;
+            }
+            break;
+        }
+        case Type::kString:
+            serializeString(m_string, out);
+            break;
+        case Type::kArray:
+        {
+            out.push_back('[');
+            for (size_t i = 0; i < m_values.size(); ++i) {
+                if (i) {
+                    out.push_back(',');
+                }
+                m_values[i].serialize(out);
+            }
+            out.push_back(']');
+            break;
+        }
+        case Type::kObject:
+        {
+            out.push_back('{');
+            for (size_t i = 0; i < m_values.size(); ++i) {
+                if (i) {
+                    out.push_back(',');
+                }
+                serializeString(m_keys[i], out);
+                out.push_back(':');
+                m_values[i].serialize(out);
+            }
+            out.push_back('}');
+            break;
+        }
+    }
+}
+
+const JsonValue* JsonValue::find(const std::string_view key) const
+{
+    if (m_type != Type::kObject) {
+        return nullptr;
+    }
+    for (size_t i = 0; i < m_keys.size(); ++i) {
+        if (m_keys[i] == key) {
+            return &m_values[i];
+        }
+    }
+    return nullptr;
+}
+
+const JsonValue& JsonValue::operator[](const std::string_view key) const
+{
+    const JsonValue* value = find(key);
+    return value ? *value : kNullValue;
+}
+
+JsonValue& JsonValue::set(const std::string_view key, JsonValue value)
+{
+    assert(m_type == Type::kObject);
+    for (size_t i = 0; i < m_keys.size(); ++i) {
+        if (m_keys[i] == key) {
+            m_values[i] = std::move(value);
+            return m_values[i];
+        }
+    }
+    m_keys.emplace_back(key);
+    m_values.push_back(std::move(value));
+    return m_values.back();
+}
+
+JsonValue& JsonValue::append(JsonValue value)
+{
+    assert(m_type == Type::kArray);
+    m_values.push_back(std::move(value));
+    return m_values.back();
+}
+
+} // namespace util.
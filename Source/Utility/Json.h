@@ -0,0 +1,101 @@
+//
+//  Json.h
+//  Heatray
+//
+//  Minimal JSON document model with a parser and serializer.
+//
+//
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace util {
+
+class JsonValue
+{
+public:
+    enum class Type {
+        kNull,
+        kBool,
+        kNumber,
+        kString,
+        kArray,
+        kObject
+    };
+
+    JsonValue() = default;
+    JsonValue(bool value) : m_type(Type::kBool), m_bool(value) {}
+    JsonValue(int value) : m_type(Type::kNumber), m_number(double(value)) {}
+    JsonValue(uint32_t value) : m_type(Type::kNumber), m_number(double(value)) {}
+    JsonValue(uint64_t value) : m_type(Type::kNumber), m_number(double(value)) {}
+    JsonValue(float value) : m_type(Type::kNumber), m_number(double(value)) {}
+    JsonValue(double value) : m_type(Type::kNumber), m_number(value) {}
+    JsonValue(const char* value) : m_type(Type::kString), m_string(value) {}
+    JsonValue(std::string_view value) : m_type(Type::kString), m_string(value) {}
+    JsonValue(std::string value) : m_type(Type::kString), m_string(std::move(value)) {}
+
+    static JsonValue array() { JsonValue value; value.m_type = Type::kArray; return value; }
+    static JsonValue object() { JsonValue value; value.m_type = Type::kObject; return value; }
+
+    //-------------------------------------------------------------------------
+    // Parse a JSON document. Returns false and fills in 'error' (if supplied)
+    // if the text is not valid JSON.
+    static bool parse(const std::string_view text, JsonValue& value, std::string* error = nullptr);
+
+    //-------------------------------------------------------------------------
+    // Convert this value into compact JSON text.
+    std::string serialize() const;
+
+    inline Type type() const { return m_type; }
+    inline bool isNull() const { return m_type == Type::kNull; }
+    inline bool isBool() const { return m_type == Type::kBool; }
+    inline bool isNumber() const { return m_type == Type::kNumber; }
+    inline bool isString() const { return m_type == Type::kString; }
+    inline bool isArray() const { return m_type == Type::kArray; }
+    inline bool isObject() const { return m_type == Type::kObject; }
+
+    //-------------------------------------------------------------------------
+    // Accessors which return 'fallback' if the value is of a different type.
+    inline bool asBool(bool fallback = false) const { return isBool() ? m_bool : fallback; }
+    inline double asNumber(double fallback = 0.0) const { return isNumber() ? m_number : fallback; }
+    inline int asInt(int fallback = 0) const { return isNumber() ? int(m_number) : fallback; }
+    inline size_t asSize(size_t fallback = 0) const { return isNumber() ? size_t(m_number) : fallback; }
+    inline float asFloat(float fallback = 0.0f) const { return isNumber() ? float(m_number) : fallback; }
+    inline const std::string& asString() const { return m_string; }
+
+    //-------------------------------------------------------------------------
+    // Array and object access. Element count is valid for both arrays and objects.
+    inline size_t size() const { return m_values.size(); }
+    inline const JsonValue& operator[](size_t index) const { return m_values[index]; }
+    inline const std::string& key(size_t index) const { return m_keys[index]; }
+
+    //-------------------------------------------------------------------------
+    // Object member lookup. Returns nullptr (or a null value for operator[])
+    // if there is no member named 'key'.
+    const JsonValue* find(const std::string_view key) const;
+    const JsonValue& operator[](const std::string_view key) const;
+    const JsonValue& operator[](const char* key) const { return (*this)[std::string_view(key)]; }
+    inline bool contains(const std::string_view key) const { return find(key) != nullptr; }
+
+    //-------------------------------------------------------------------------
+    // Mutators for building up documents.
+    JsonValue& set(const std::string_view key, JsonValue value);
+    JsonValue& append(JsonValue value);
+
+private:
+    void serialize(std::string& out) const;
+
+    Type m_type = Type::kNull;
+    bool m_bool = false;
+    double m_number = 0.0;
+    std::string m_string;
+    std::vector<std::string> m_keys; // Only used by objects, parallel to 'm_values'.
+    std::vector<JsonValue> m_values; // Elements of an array or members of an object.
+};
+
+} // namespace util.
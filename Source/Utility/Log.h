@@ -35,8 +35,9 @@ public:
     // Log a message to the installed logger.
     template <class ... Args>
     void log(Type type, const std::string_view format, Args &&... args) {
-        std::string formattedString = util::createStringWithFormat(format, args...);
-        m_instance->addNewItem(formattedString, type);
+        // Formatted on the stack so that logging does not allocate unless the logger stores the message.
+        char formattedString[4096];
+        m_instance->addNewItem(util::formatToBuffer(formattedString, format, args...), type);
     }
 protected:
     Log() = default;
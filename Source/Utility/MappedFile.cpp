@@ -0,0 +1,154 @@
+#include "MappedFile.h"
+
+#include "Log.h"
+
+#include <algorithm>
+#include <cstring>
+#include <string>
+
+#if defined(_WIN32)
+    #ifndef NOMINMAX
+        #define NOMINMAX
+    #endif
+    #include <windows.h>
+#else
+    #include <fcntl.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <unistd.h>
+#endif
+
+namespace util {
+
+MappedFile& MappedFile::operator=(MappedFile&& other) noexcept
+{
+    if (this != &other) {
+        close();
+
+        m_data = other.m_data;
+        m_size = other.m_size;
+        other.m_data = nullptr;
+        other.m_size = 0;
+#if defined(_WIN32)
+        m_fileHandle = other.m_fileHandle;
+        m_mappingHandle = other.m_mappingHandle;
+        other.m_fileHandle = nullptr;
+        other.m_mappingHandle = nullptr;
+#endif
+    }
+
+    return *this;
+}
+
+bool MappedFile::open(const std::string_view path)
+{
+    close();
+
+    std::string filename(path);
+
+#if defined(_WIN32)
+    HANDLE file = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        return false;
+    }
+
+    LARGE_INTEGER fileSize;
+    if (!GetFileSizeEx(file, &fileSize) || (fileSize.QuadPart == 0)) {
+        CloseHandle(file);
+        return false;
+    }
+
+    HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (mapping == nullptr) {
+        CloseHandle(file);
+        LOG_ERROR("Unable to map file %s", filename.c_str());
+        return false;
+    }
+
+    void* data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    if (data == nullptr) {
+        CloseHandle(mapping);
+        CloseHandle(file);
+        LOG_ERROR("Unable to map file %s", filename.c_str());
+        return false;
+    }
+
+    m_fileHandle = file;
+    m_mappingHandle = mapping;
+    m_data = static_cast<const uint8_t*>(data);
+    m_size = static_cast<size_t>(fileSize.QuadPart);
+#else
+    int file = ::open(filename.c_str(), O_RDONLY);
+    if (file < 0) {
+        return false;
+    }
+
+    struct stat fileInfo;
+    if ((fstat(file, &fileInfo) != 0) || (fileInfo.st_size == 0)) {
+        ::close(file);
+        return false;
+    }
+
+    void* data = mmap(nullptr, static_cast<size_t>(fileInfo.st_size), PROT_READ, MAP_PRIVATE, file, 0);
+    ::close(file); // The mapping keeps its own reference to the file.
+    if (data == MAP_FAILED) {
+        LOG_ERROR("Unable to map file %s", filename.c_str());
+        return false;
+    }
+
+    m_data = static_cast<const uint8_t*>(data);
+    m_size = static_cast<size_t>(fileInfo.st_size);
+#endif
+
+    return true;
+}
+
+void MappedFile::close()
+{
+    if (m_data) {
+#if defined(_WIN32)
+        UnmapViewOfFile(m_data);
+        CloseHandle(m_mappingHandle);
+        CloseHandle(m_fileHandle);
+        m_mappingHandle = nullptr;
+        m_fileHandle = nullptr;
+#else
+        munmap(const_cast<uint8_t*>(m_data), m_size);
+#endif
+    }
+
+    m_data = nullptr;
+    m_size = 0;
+}
+
+void MappedFile::streamCopy(uint8_t* destination, const uint8_t* source, size_t size, size_t chunkSize)
+{
+    chunkSize = std::max(chunkSize, size_t(1));
+    for (size_t offset = 0; offset < size; offset += chunkSize) {
+        const size_t count = std::min(chunkSize, size - offset);
+        memcpy(destination + offset, source + offset, count);
+        evict(source + offset, count);
+    }
+}
+
+void MappedFile::evict(const uint8_t* data, size_t size)
+{
+    if (!data || (size == 0)) {
+        return;
+    }
+
+#if defined(_WIN32)
+    // Unlocking pages that are not locked removes them from the working set of the process.
+    VirtualUnlock(const_cast<uint8_t*>(data), size);
+#else
+    // Only whole pages can be released, the partial pages at either end are left alone.
+    static const uintptr_t pageSize = uintptr_t(sysconf(_SC_PAGESIZE));
+    const uintptr_t begin = (reinterpret_cast<uintptr_t>(data) + pageSize - 1) / pageSize * pageSize;
+    const uintptr_t end = (reinterpret_cast<uintptr_t>(data) + size) / pageSize * pageSize;
+    if (end > begin) {
+        madvise(reinterpret_cast<void*>(begin), size_t(end - begin), MADV_DONTNEED);
+    }
+#endif
+}
+
+} // namespace util.
@@ -0,0 +1,68 @@
+//
+//  MappedFile.h
+//  Heatray
+//
+//  Read-only memory mapping of a file on disk.
+//
+//
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string_view>
+#include <utility>
+
+namespace util {
+
+class MappedFile
+{
+public:
+    MappedFile() = default;
+    ~MappedFile() { close(); }
+
+    MappedFile(MappedFile&& other) noexcept { *this = std::move(other); }
+    MappedFile& operator=(MappedFile&& other) noexcept;
+
+    //-------------------------------------------------------------------------
+    // Map the entire file into the address space of this process. Returns
+    // false if the file could not be opened or is empty.
+    bool open(const std::string_view path);
+
+    //-------------------------------------------------------------------------
+    // Unmap the file. Any pointers previously returned by data() become invalid.
+    void close();
+
+    //-------------------------------------------------------------------------
+    // Copy 'size' bytes of mapped data starting at 'source' to 'destination'
+    // 'chunkSize' bytes at a time, evicting each chunk from memory once it has
+    // been copied. This bounds the memory used while streaming buffers that
+    // are larger than what would otherwise fit next to their copy.
+    static constexpr size_t kStreamChunkSize = 64 * 1024 * 1024;
+    static void streamCopy(uint8_t* destination, const uint8_t* source, size_t size, size_t chunkSize = kStreamChunkSize);
+
+    //-------------------------------------------------------------------------
+    // Release the pages of mapped data overlapping [data, data + size) from
+    // the memory of this process. They are read back from disk if accessed
+    // again. 'data' may point into any MappedFile.
+    static void evict(const uint8_t* data, size_t size);
+
+    inline const uint8_t* data() const { return m_data; }
+    inline size_t size() const { return m_size; }
+    inline bool valid() const { return (m_data != nullptr); }
+
+private:
+    // This class is not copyable.
+    MappedFile(const MappedFile& other) = delete;
+    MappedFile& operator=(const MappedFile& other) = delete;
+
+    const uint8_t* m_data = nullptr;
+    size_t m_size = 0;
+
+#if defined(_WIN32)
+    void* m_fileHandle = nullptr;
+    void* m_mappingHandle = nullptr;
+#endif
+};
+
+} // namespace util.
@@ -0,0 +1,539 @@
+#include "MeshOptimizer.h"
+
+#include <algorithm>
+#include <array>
+#include <assert.h>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <memory_resource>
+#include <unordered_map>
+
+namespace util {
+
+namespace {
+
+constexpr uint32_t kInvalidIndex = std::numeric_limits<uint32_t>::max();
+
+//-------------------------------------------------------------------------
+// Symmetric 4x4 matrix holding the sum of the squared distance to a set of
+// planes, stored as the upper 3x3 block, the last column and the corner.
+struct Quadric {
+    double a00 = 0.0, a01 = 0.0, a02 = 0.0, a11 = 0.0, a12 = 0.0, a22 = 0.0;
+    double b0 = 0.0, b1 = 0.0, b2 = 0.0;
+    double c = 0.0;
+
+    Quadric() = default;
+
+    // Plane dot(normal, p) + distance = 0.
+    Quadric(const std::array<double, 3>& normal, double distance)
+    : a00(normal[0] * normal[0]), a01(normal[0] * normal[1]), a02(normal[0] * normal[2])
+    , a11(normal[1] * normal[1]), a12(normal[1] * normal[2]), a22(normal[2] * normal[2])
+    , b0(normal[0] * distance), b1(normal[1] * distance), b2(normal[2] * distance)
+    , c(distance * distance)
+    {}
+
+    Quadric& operator+=(const Quadric& other)
+    {
+        a00 += other.a00; a01 += other.a01; a02 += other.a02;
+        a11 += other.a11; a12 += other.a12; a22 += other.a22;
+        b0 += other.b0; b1 += other.b1; b2 += other.b2;
+        c += other.c;
+        return *this;
+    }
+
+    double error(const std::array<double, 3>& p) const
+    {
+        const double x = p[0], y = p[1], z = p[2];
+        const double result = (a00 * x * x) + (a11 * y * y) + (a22 * z * z) + 2.0 * ((a01 * x * y) + (a02 * x * z) + (a12 * y * z)) +
+                              2.0 * ((b0 * x) + (b1 * y) + (b2 * z)) + c;
+        return std::max(result, 0.0);
+    }
+};
+
+struct PositionHash {
+    size_t operator()(const std::array<float, 3>& position) const
+    {
+        uint32_t bits[3];
+        std::memcpy(bits, position.data(), sizeof(bits));
+        return size_t((bits[0] * 73856093u) ^ (bits[1] * 19349663u) ^ (bits[2] * 83492791u));
+    }
+};
+
+double dot(const std::array<double, 3>& a, const std::array<double, 3>& b)
+{
+    return (a[0] * b[0]) + (a[1] * b[1]) + (a[2] * b[2]);
+}
+
+// Not normalized, the length is twice the area of the triangle.
+std::array<double, 3> triangleNormal(const std::array<double, 3>& p0, const std::array<double, 3>& p1, const std::array<double, 3>& p2)
+{
+    const std::array<double, 3> e0 = { p1[0] - p0[0], p1[1] - p0[1], p1[2] - p0[2] };
+    const std::array<double, 3> e1 = { p2[0] - p0[0], p2[1] - p0[1], p2[2] - p0[2] };
+    return { (e0[1] * e1[2]) - (e0[2] * e1[1]), (e0[2] * e1[0]) - (e0[0] * e1[2]), (e0[0] * e1[1]) - (e0[1] * e1[0]) };
+}
+
+//-------------------------------------------------------------------------
+// Spread the low 10 bits of 'value' so that there are two zero bits between
+// each of them.
+uint32_t expandBits(uint32_t value)
+{
+    value = (value * 0x00010001u) & 0xFF0000FFu;
+    value = (value * 0x00000101u) & 0x0F00F00Fu;
+    value = (value * 0x00000011u) & 0xC30C30C3u;
+    value = (value * 0x00000005u) & 0x49249249u;
+    return value;
+}
+
+} // namespace.
+
+void optimizeVertexCache(uint32_t* indices, size_t indexCount, size_t vertexCount, size_t cacheSize, std::pmr::memory_resource* scratch)
+{
+    assert((indexCount % 3) == 0);
+    const size_t triangleCount = indexCount / 3;
+    if (triangleCount == 0) {
+        return;
+    }
+
+    // Triangles referencing each vertex, stored as one contiguous run per vertex.
+    std::pmr::vector<uint32_t> liveTriangles(vertexCount, 0, scratch); // Triangles of each vertex that have not been emitted yet.
+    for (size_t ii = 0; ii < indexCount; ++ii) {
+        assert(indices[ii] < vertexCount);
+        ++liveTriangles[indices[ii]];
+    }
+    std::pmr::vector<uint32_t> adjacencyOffsets(vertexCount + 1, 0, scratch);
+    for (size_t ii = 0; ii < vertexCount; ++ii) {
+        adjacencyOffsets[ii + 1] = adjacencyOffsets[ii] + liveTriangles[ii];
+    }
+    std::pmr::vector<uint32_t> adjacency(indexCount, scratch);
+    {
+        std::pmr::vector<uint32_t> cursor(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1, scratch);
+        for (size_t ii = 0; ii < indexCount; ++ii) {
+            adjacency[cursor[indices[ii]]++] = uint32_t(ii / 3);
+        }
+    }
+
+    std::pmr::vector<uint32_t> result(scratch);
+    result.reserve(indexCount);
+    std::pmr::vector<bool> emitted(triangleCount, false, scratch);
+    std::pmr::vector<size_t> cacheTime(vertexCount, 0, scratch); // Time each vertex last entered the cache.
+    std::pmr::vector<uint32_t> deadEnds(scratch); // Recently used vertices to restart from when the fan runs out.
+    std::pmr::vector<uint32_t> candidates(scratch);
+    size_t time = cacheSize + 1;
+    size_t cursor = 0; // Next vertex to consider once there are no dead ends left.
+
+    uint32_t fanning = 0;
+    while (fanning != kInvalidIndex) {
+        // Emit every remaining triangle around the current vertex.
+        candidates.clear();
+        for (uint32_t jj = adjacencyOffsets[fanning]; jj < adjacencyOffsets[fanning + 1]; ++jj) {
+            const uint32_t triangle = adjacency[jj];
+            if (emitted[triangle]) {
+                continue;
+            }
+            emitted[triangle] = true;
+
+            for (size_t corner = 0; corner < 3; ++corner) {
+                const uint32_t vertex = indices[triangle * 3 + corner];
+                result.push_back(vertex);
+                deadEnds.push_back(vertex);
+                candidates.push_back(vertex);
+                --liveTriangles[vertex];
+                if ((time - cacheTime[vertex]) > cacheSize) {
+                    cacheTime[vertex] = time++;
+                }
+            }
+        }
+
+        // Continue with the candidate that is still in the cache and is furthest from being evicted
+        // after fanning around it.
+        fanning = kInvalidIndex;
+        size_t bestPriority = 0;
+        for (uint32_t vertex : candidates) {
+            if (liveTriangles[vertex] == 0) {
+                continue;
+            }
+            size_t priority = 1;
+            if ((time - cacheTime[vertex] + 2 * liveTriangles[vertex]) <= cacheSize) {
+                priority = time - cacheTime[vertex] + 1;
+            }
+            if (priority > bestPriority) {
+                bestPriority = priority;
+                fanning = vertex;
+            }
+        }
+
+        // Otherwise restart from the most recently used vertex with triangles left, or failing that
+        // the next unfinished vertex in input order.
+        while ((fanning == kInvalidIndex) && !deadEnds.empty()) {
+            const uint32_t vertex = deadEnds.back();
+            deadEnds.pop_back();
+            if (liveTriangles[vertex] > 0) {
+                fanning = vertex;
+            }
+        }
+        while ((fanning == kInvalidIndex) && (cursor < vertexCount)) {
+            if (liveTriangles[cursor] > 0) {
+                fanning = uint32_t(cursor);
+            }
+            ++cursor;
+        }
+    }
+
+    assert(result.size() == indexCount);
+    std::copy(result.begin(), result.end(), indices);
+}
+
+void sortTrianglesSpatially(uint32_t* indices, size_t indexCount, const float* positions, size_t positionStride,
+                            std::pmr::memory_resource* scratch)
+{
+    assert((indexCount % 3) == 0);
+    const size_t triangleCount = indexCount / 3;
+    if (triangleCount < 2) {
+        return;
+    }
+
+    auto centroid = [&](size_t triangle, size_t axis) {
+        float sum = 0.0f;
+        for (size_t corner = 0; corner < 3; ++corner) {
+            sum += positions[indices[triangle * 3 + corner] * positionStride + axis];
+        }
+        return sum / 3.0f;
+    };
+
+    float boundsMin[3] = { std::numeric_limits<float>::max(), std::numeric_limits<float>::max(), std::numeric_limits<float>::max() };
+    float boundsMax[3] = { -std::numeric_limits<float>::max(), -std::numeric_limits<float>::max(), -std::numeric_limits<float>::max() };
+    std::pmr::vector<float> centroids(triangleCount * 3, scratch);
+    for (size_t triangle = 0; triangle < triangleCount; ++triangle) {
+        for (size_t axis = 0; axis < 3; ++axis) {
+            const float value = centroid(triangle, axis);
+            centroids[triangle * 3 + axis] = value;
+            boundsMin[axis] = std::min(boundsMin[axis], value);
+            boundsMax[axis] = std::max(boundsMax[axis], value);
+        }
+    }
+
+    // Quantize each centroid to 10 bits per axis of the bounds, using the same scale for every axis
+    // so that the curve is not stretched along thin meshes.
+    const float extent = std::max({ boundsMax[0] - boundsMin[0], boundsMax[1] - boundsMin[1], boundsMax[2] - boundsMin[2] });
+    const float scale = (extent > 0.0f) ? (1023.0f / extent) : 0.0f;
+
+    std::pmr::vector<std::pair<uint32_t, uint32_t>> keys(triangleCount, scratch); // Morton code and triangle.
+    for (size_t triangle = 0; triangle < triangleCount; ++triangle) {
+        uint32_t code = 0;
+        for (size_t axis = 0; axis < 3; ++axis) {
+            const float cell = std::clamp((centroids[triangle * 3 + axis] - boundsMin[axis]) * scale, 0.0f, 1023.0f);
+            code |= expandBits(uint32_t(cell)) << (2 - axis);
+        }
+        keys[triangle] = { code, uint32_t(triangle) };
+    }
+    std::sort(keys.begin(), keys.end());
+
+    std::pmr::vector<uint32_t> result(indexCount, scratch);
+    for (size_t ii = 0; ii < triangleCount; ++ii) {
+        const uint32_t triangle = keys[ii].second;
+        result[ii * 3 + 0] = indices[triangle * 3 + 0];
+        result[ii * 3 + 1] = indices[triangle * 3 + 1];
+        result[ii * 3 + 2] = indices[triangle * 3 + 2];
+    }
+    std::copy(result.begin(), result.end(), indices);
+}
+
+std::pmr::vector<uint32_t> optimizeVertexFetch(uint32_t* indices, size_t indexCount, size_t vertexCount, std::pmr::memory_resource* scratch)
+{
+    std::pmr::vector<uint32_t> remap(vertexCount, kInvalidIndex, scratch);
+    uint32_t nextVertex = 0;
+    for (size_t ii = 0; ii < indexCount; ++ii) {
+        assert(indices[ii] < vertexCount);
+        uint32_t& newIndex = remap[indices[ii]];
+        if (newIndex == kInvalidIndex) {
+            newIndex = nextVertex++;
+        }
+        indices[ii] = newIndex;
+    }
+
+    for (uint32_t& newIndex : remap) {
+        if (newIndex == kInvalidIndex) {
+            newIndex = nextVertex++;
+        }
+    }
+    return remap;
+}
+
+size_t simplifyMesh(uint32_t* indices, size_t indexCount, const float* positions, size_t vertexCount, size_t positionStride,
+                    size_t targetIndexCount, float maxError, float* resultError, std::pmr::memory_resource* scratch)
+{
+    assert((indexCount % 3) == 0);
+    if (resultError) {
+        *resultError = 0.0f;
+    }
+    if (indexCount <= targetIndexCount) {
+        return indexCount;
+    }
+
+    auto position = [positions, positionStride](uint32_t vertex) {
+        const float* p = positions + size_t(vertex) * positionStride;
+        return std::array<double, 3>{ p[0], p[1], p[2] };
+    };
+
+    // Vertices that share a position are welded so that the topology can be analyzed without the
+    // attribute seams, each vertex refers to the first vertex at its position.
+    std::pmr::vector<uint32_t> welded(vertexCount, scratch);
+    std::pmr::vector<uint32_t> weldedCount(vertexCount, 0, scratch);
+    {
+        std::pmr::unordered_map<std::array<float, 3>, uint32_t, PositionHash> firstAtPosition(scratch);
+        firstAtPosition.reserve(vertexCount);
+        for (uint32_t vertex = 0; vertex < vertexCount; ++vertex) {
+            const float* p = positions + size_t(vertex) * positionStride;
+            welded[vertex] = firstAtPosition.emplace(std::array<float, 3>{ p[0], p[1], p[2] }, vertex).first->second;
+            ++weldedCount[welded[vertex]];
+        }
+    }
+
+    // Lock every vertex on a seam as well as every vertex on an edge that is not shared by exactly
+    // two triangles, which keeps borders and holes in place.
+    std::pmr::vector<bool> locked(vertexCount, false, scratch);
+    {
+        std::pmr::unordered_map<uint64_t, uint32_t> edgeUses(scratch);
+        edgeUses.reserve(indexCount);
+        for (size_t ii = 0; ii < indexCount; ii += 3) {
+            for (size_t corner = 0; corner < 3; ++corner) {
+                const uint32_t a = welded[indices[ii + corner]];
+                const uint32_t b = welded[indices[ii + (corner + 1) % 3]];
+                ++edgeUses[(uint64_t(std::min(a, b)) << 32) | std::max(a, b)];
+            }
+        }
+        for (const auto& edge : edgeUses) {
+            if (edge.second != 2) {
+                locked[uint32_t(edge.first >> 32)] = true;
+                locked[uint32_t(edge.first)] = true;
+            }
+        }
+        for (uint32_t vertex = 0; vertex < vertexCount; ++vertex) {
+            locked[vertex] = locked[welded[vertex]] || (weldedCount[welded[vertex]] > 1);
+        }
+    }
+
+    // Sum of the squared distances to the plane of each triangle around a welded vertex.
+    std::pmr::vector<Quadric> quadrics(vertexCount, scratch);
+    std::array<double, 3> boundsMin = { std::numeric_limits<double>::max(), std::numeric_limits<double>::max(), std::numeric_limits<double>::max() };
+    std::array<double, 3> boundsMax = { -std::numeric_limits<double>::max(), -std::numeric_limits<double>::max(), -std::numeric_limits<double>::max() };
+    for (size_t ii = 0; ii < indexCount; ii += 3) {
+        const std::array<double, 3> p0 = position(indices[ii + 0]);
+        const std::array<double, 3> normal = triangleNormal(p0, position(indices[ii + 1]), position(indices[ii + 2]));
+        const double length = std::sqrt(dot(normal, normal));
+        for (size_t corner = 0; corner < 3; ++corner) {
+            const std::array<double, 3> p = position(indices[ii + corner]);
+            for (size_t axis = 0; axis < 3; ++axis) {
+                boundsMin[axis] = std::min(boundsMin[axis], p[axis]);
+                boundsMax[axis] = std::max(boundsMax[axis], p[axis]);
+            }
+        }
+        if (length > 0.0) {
+            const std::array<double, 3> n = { normal[0] / length, normal[1] / length, normal[2] / length };
+            const Quadric plane(n, -dot(n, p0));
+            for (size_t corner = 0; corner < 3; ++corner) {
+                quadrics[welded[indices[ii + corner]]] += plane;
+            }
+        }
+    }
+    const double extent = std::max({ boundsMax[0] - boundsMin[0], boundsMax[1] - boundsMin[1], boundsMax[2] - boundsMin[2] });
+    const double maxCost = (double(maxError) * extent) * (double(maxError) * extent);
+    double worstCost = 0.0;
+
+    struct Collapse {
+        double cost = 0.0;
+        uint32_t from = 0;
+        uint32_t to = 0;
+        bool operator<(const Collapse& other) const { return cost < other.cost; }
+    };
+    std::pmr::vector<Collapse> collapses(scratch);
+    std::pmr::vector<uint32_t> adjacencyOffsets(scratch);
+    std::pmr::vector<uint32_t> adjacency(scratch);
+    std::pmr::vector<uint32_t> cursor(scratch);
+    std::pmr::vector<uint32_t> remap(vertexCount, scratch);
+    std::pmr::vector<bool> touched(vertexCount, scratch);
+    std::pmr::vector<uint64_t> fromLink(scratch);
+    std::pmr::vector<uint64_t> toLink(scratch);
+
+    // Each pass collapses as many edges as possible without collapsing two edges that share a
+    // triangle, since the cost and flip tests of the second one would be out of date.
+    while (indexCount > targetIndexCount) {
+        const size_t triangleCount = indexCount / 3;
+        adjacencyOffsets.assign(vertexCount + 1, 0);
+        for (size_t ii = 0; ii < indexCount; ++ii) {
+            ++adjacencyOffsets[indices[ii] + 1];
+        }
+        for (size_t ii = 0; ii < vertexCount; ++ii) {
+            adjacencyOffsets[ii + 1] += adjacencyOffsets[ii];
+        }
+        adjacency.resize(indexCount);
+        cursor.assign(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+        for (size_t ii = 0; ii < indexCount; ++ii) {
+            adjacency[cursor[indices[ii]]++] = uint32_t(ii / 3);
+        }
+
+        auto cost = [&](uint32_t from, uint32_t to) {
+            Quadric quadric = quadrics[welded[from]];
+            quadric += quadrics[welded[to]];
+            return quadric.error(position(to));
+        };
+
+        // Collapsing 'from' onto 'to' must not flip any of the triangles that are left around 'from'.
+        auto flips = [&](uint32_t from, uint32_t to) {
+            for (uint32_t jj = adjacencyOffsets[from]; jj < adjacencyOffsets[from + 1]; ++jj) {
+                const uint32_t* triangle = indices + size_t(adjacency[jj]) * 3;
+                if ((triangle[0] == to) || (triangle[1] == to) || (triangle[2] == to)) {
+                    continue;
+                }
+                auto moved = [from, to](uint32_t vertex) { return (vertex == from) ? to : vertex; };
+                const std::array<double, 3> before = triangleNormal(position(triangle[0]), position(triangle[1]), position(triangle[2]));
+                const std::array<double, 3> after = triangleNormal(position(moved(triangle[0])), position(moved(triangle[1])), position(moved(triangle[2])));
+                if (dot(before, after) <= 0.0) {
+                    return true;
+                }
+            }
+            return false;
+        };
+
+        // Link condition (Dey et al. 1999): the vertices and edges that 'from' and 'to' are both
+        // connected to must be exactly the opposite vertices of the triangles on the edge between them.
+        // Otherwise the collapse pinches the surface, e.g. folding a tetrahedron into a double sided
+        // triangle. Vertices are compared by position so that seams do not hide a shared neighbour.
+        auto gatherLink = [&](uint32_t center, uint32_t other, std::pmr::vector<uint64_t>& link) {
+            link.clear();
+            for (uint32_t jj = adjacencyOffsets[center]; jj < adjacencyOffsets[center + 1]; ++jj) {
+                const uint32_t* triangle = indices + size_t(adjacency[jj]) * 3;
+                const size_t corner = (triangle[0] == center) ? 0 : ((triangle[1] == center) ? 1 : 2);
+                const uint32_t b = welded[triangle[(corner + 1) % 3]];
+                const uint32_t c = welded[triangle[(corner + 2) % 3]];
+                const uint32_t skipped = welded[other];
+                if ((b != skipped) && (c != skipped)) {
+                    link.push_back((uint64_t(std::min(b, c)) << 32) | std::max(b, c)); // Opposite edge.
+                }
+                for (uint32_t vertex : { b, c }) {
+                    if (vertex != skipped) {
+                        link.push_back((uint64_t(vertex) << 32) | vertex); // Neighbour.
+                    }
+                }
+            }
+            std::sort(link.begin(), link.end());
+            link.erase(std::unique(link.begin(), link.end()), link.end());
+        };
+        auto breaksLink = [&](uint32_t from, uint32_t to) {
+            size_t edgeTriangles = 0;
+            for (uint32_t jj = adjacencyOffsets[from]; jj < adjacencyOffsets[from + 1]; ++jj) {
+                const uint32_t* triangle = indices + size_t(adjacency[jj]) * 3;
+                edgeTriangles += ((triangle[0] == to) || (triangle[1] == to) || (triangle[2] == to)) ? 1 : 0;
+            }
+            gatherLink(from, to, fromLink);
+            gatherLink(to, from, toLink);
+            size_t shared = 0;
+            for (size_t ii = 0, jj = 0; (ii < fromLink.size()) && (jj < toLink.size());) {
+                if (fromLink[ii] == toLink[jj]) {
+                    // A shared edge is never part of the link of the collapsed edge.
+                    if ((fromLink[ii] >> 32) != (fromLink[ii] & 0xFFFFFFFF)) {
+                        return true;
+                    }
+                    ++shared;
+                    ++ii;
+                    ++jj;
+                } else if (fromLink[ii] < toLink[jj]) {
+                    ++ii;
+                } else {
+                    ++jj;
+                }
+            }
+            return shared != edgeTriangles;
+        };
+
+        collapses.clear();
+        for (size_t ii = 0; ii < indexCount; ii += 3) {
+            for (size_t corner = 0; corner < 3; ++corner) {
+                const uint32_t a = indices[ii + corner];
+                const uint32_t b = indices[ii + (corner + 1) % 3];
+                if (a > b) {
+                    continue; // Edges that can be collapsed are shared by two triangles, only consider them once.
+                }
+                const double costFrom = locked[a] ? std::numeric_limits<double>::max() : cost(a, b);
+                const double costTo = locked[b] ? std::numeric_limits<double>::max() : cost(b, a);
+                if (std::min(costFrom, costTo) <= maxCost) {
+                    collapses.push_back((costFrom <= costTo) ? Collapse{ costFrom, a, b } : Collapse{ costTo, b, a });
+                }
+            }
+        }
+        std::sort(collapses.begin(), collapses.end());
+
+        for (uint32_t vertex = 0; vertex < vertexCount; ++vertex) {
+            remap[vertex] = vertex;
+        }
+        std::fill(touched.begin(), touched.end(), false);
+
+        size_t remainingTriangles = triangleCount;
+        size_t collapseCount = 0;
+        for (const Collapse& collapse : collapses) {
+            if ((remainingTriangles * 3) <= targetIndexCount) {
+                break;
+            }
+            if (touched[collapse.from] || touched[collapse.to] || flips(collapse.from, collapse.to) || breaksLink(collapse.from, collapse.to)) {
+                continue;
+            }
+
+            for (uint32_t jj = adjacencyOffsets[collapse.from]; jj < adjacencyOffsets[collapse.from + 1]; ++jj) {
+                const uint32_t* triangle = indices + size_t(adjacency[jj]) * 3;
+                touched[triangle[0]] = touched[triangle[1]] = touched[triangle[2]] = true;
+                remainingTriangles -= ((triangle[0] == collapse.to) || (triangle[1] == collapse.to) || (triangle[2] == collapse.to)) ? 1 : 0;
+            }
+            remap[collapse.from] = collapse.to;
+            quadrics[welded[collapse.to]] += quadrics[welded[collapse.from]];
+            worstCost = std::max(worstCost, collapse.cost);
+            ++collapseCount;
+        }
+        if (collapseCount == 0) {
+            break;
+        }
+
+        // Apply the collapses and drop the triangles that became degenerate.
+        size_t writeIndex = 0;
+        for (size_t ii = 0; ii < indexCount; ii += 3) {
+            const uint32_t a = remap[indices[ii + 0]];
+            const uint32_t b = remap[indices[ii + 1]];
+            const uint32_t c = remap[indices[ii + 2]];
+            if ((a != b) && (b != c) && (c != a)) {
+                indices[writeIndex++] = a;
+                indices[writeIndex++] = b;
+                indices[writeIndex++] = c;
+            }
+        }
+        indexCount = writeIndex;
+    }
+
+    if (resultError && (extent > 0.0)) {
+        *resultError = float(std::sqrt(worstCost) / extent);
+    }
+    return indexCount;
+}
+
+float averageCacheMissRatio(const uint32_t* indices, size_t indexCount, size_t vertexCount, size_t cacheSize, std::pmr::memory_resource* scratch)
+{
+    const size_t triangleCount = indexCount / 3;
+    if (triangleCount == 0) {
+        return 0.0f;
+    }
+
+    // A vertex is in the FIFO cache if fewer than 'cacheSize' vertices were added after it.
+    std::pmr::vector<size_t> insertedAt(vertexCount, 0, scratch);
+    size_t insertions = 0;
+    size_t misses = 0;
+    for (size_t ii = 0; ii < indexCount; ++ii) {
+        assert(indices[ii] < vertexCount);
+        size_t& inserted = insertedAt[indices[ii]];
+        if ((inserted == 0) || ((insertions - inserted) >= cacheSize)) {
+            inserted = ++insertions;
+            ++misses;
+        }
+    }
+    return float(misses) / float(triangleCount);
+}
+
+} // namespace util.
@@ -0,0 +1,73 @@
+//
+//  MeshOptimizer.h
+//  Heatray
+//
+//  Triangle and vertex reordering of indexed triangle lists to improve the
+//  memory locality of the vertex and index data.
+//
+//  Every function takes a 'scratch' memory resource that its temporary
+//  tables are allocated from, e.g. a util::Arena or a
+//  std::pmr::monotonic_buffer_resource owned by the caller.
+//
+//
+
+#pragma once
+
+#include <memory_resource>
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+namespace util {
+
+constexpr size_t kDefaultVertexCacheSize = 16;
+
+//-------------------------------------------------------------------------
+// Reorder the triangles in 'indices' so that consecutive triangles reuse
+// recently referenced vertices (Tipsify, Sander et al. 2007). 'cacheSize' is
+// the number of vertices assumed to fit in the cache. Runs in linear time.
+void optimizeVertexCache(uint32_t* indices, size_t indexCount, size_t vertexCount, size_t cacheSize = kDefaultVertexCacheSize,
+                         std::pmr::memory_resource* scratch = std::pmr::get_default_resource());
+
+//-------------------------------------------------------------------------
+// Reorder the triangles in 'indices' along a Morton curve through their
+// centroids so that triangles close in space are close in memory, which
+// helps acceleration structure builds and traversal. 'positions' holds
+// three floats for every vertex referenced by 'indices', with consecutive
+// vertices 'positionStride' floats apart.
+void sortTrianglesSpatially(uint32_t* indices, size_t indexCount, const float* positions, size_t positionStride,
+                            std::pmr::memory_resource* scratch = std::pmr::get_default_resource());
+
+//-------------------------------------------------------------------------
+// Number the vertices in the order they are first referenced by 'indices'
+// and rewrite 'indices' to use the new numbering. Unreferenced vertices are
+// moved to the end, keeping their relative order. Returns the remap table,
+// allocated from 'scratch', the new index of vertex ii is result[ii].
+std::pmr::vector<uint32_t> optimizeVertexFetch(uint32_t* indices, size_t indexCount, size_t vertexCount,
+                                               std::pmr::memory_resource* scratch = std::pmr::get_default_resource());
+
+//-------------------------------------------------------------------------
+// Remove triangles from 'indices' by collapsing edges in the order of least
+// quadric error (Garland and Heckbert 1997) until at most 'targetIndexCount'
+// indices are left or the next collapse would move the surface by more than
+// 'maxError', relative to the extent of the mesh. Vertices are only ever
+// collapsed onto a neighbour so the result uses the same vertices. Vertices
+// on a border or an attribute seam (several vertices at the same position)
+// are never removed, and neither are edges whose collapse would fail the
+// link condition and make the surface non-manifold. The result is written
+// to the front of 'indices' and its size is returned. 'resultError'
+// (optional) receives the relative error of the result, an upper bound of
+// the distance between each vertex and the planes of the triangles it
+// replaced.
+size_t simplifyMesh(uint32_t* indices, size_t indexCount, const float* positions, size_t vertexCount, size_t positionStride,
+                    size_t targetIndexCount, float maxError, float* resultError = nullptr,
+                    std::pmr::memory_resource* scratch = std::pmr::get_default_resource());
+
+//-------------------------------------------------------------------------
+// Average number of vertices that miss a FIFO cache of 'cacheSize' entries
+// per triangle (ACMR). 3 is the worst case and values approaching 0.5 are
+// close to optimal for regular meshes.
+float averageCacheMissRatio(const uint32_t* indices, size_t indexCount, size_t vertexCount, size_t cacheSize = kDefaultVertexCacheSize,
+                            std::pmr::memory_resource* scratch = std::pmr::get_default_resource());
+
+} // namespace util.
@@ -0,0 +1,63 @@
+//
+//  ParallelFor.h
+//  Heatray
+//
+//  Runs a function over a range of indices on a set of worker threads.
+//
+//
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <stddef.h>
+#include <thread>
+#include <vector>
+
+namespace util {
+
+//-------------------------------------------------------------------------
+// Number of worker threads that parallelFor() will use for 'count' items.
+inline size_t parallelWorkerCount(size_t count)
+{
+    size_t hardwareThreads = std::max<size_t>(1, std::thread::hardware_concurrency());
+    return std::max<size_t>(1, std::min(count, hardwareThreads));
+}
+
+//-------------------------------------------------------------------------
+// Invoke 'function(index, workerIndex)' for every index in [0, count). Indices
+// are handed out dynamically so uneven workloads are balanced across the
+// workers. 'workerIndex' is in [0, parallelWorkerCount(count)) and can be used
+// to address per-worker scratch data. Blocks until all indices are processed.
+template<class Function>
+void parallelFor(size_t count, Function&& function)
+{
+    const size_t workerCount = parallelWorkerCount(count);
+    if (workerCount == 1) {
+        for (size_t index = 0; index < count; ++index) {
+            function(index, size_t(0));
+        }
+        return;
+    }
+
+    std::atomic<size_t> nextIndex = 0;
+    auto worker = [&](size_t workerIndex) {
+        for (size_t index = nextIndex++; index < count; index = nextIndex++) {
+            function(index, workerIndex);
+        }
+    };
+
+    // The calling thread acts as the final worker.
+    std::vector<std::thread> threads;
+    threads.reserve(workerCount - 1);
+    for (size_t workerIndex = 0; workerIndex < workerCount - 1; ++workerIndex) {
+        threads.emplace_back(worker, workerIndex);
+    }
+    worker(workerCount - 1);
+
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+}
+
+} // namespace util.
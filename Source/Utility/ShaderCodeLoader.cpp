@@ -3,10 +3,17 @@
 #include "FileIO.h"
 
 #include <RLWrapper/Shader.h>
+#include <Utility/BinaryStream.h>
 #include <Utility/Hash.h>
+#include <Utility/Log.h>
+#include <Utility/MappedFile.h>
 
+#include <algorithm>
 #include <assert.h>
+#include <filesystem>
+#include <fstream>
 #include <set>
+#include <stdio.h>
 #include <string_view>
 #include <vector>
 #include <unordered_map>
@@ -20,18 +27,232 @@ namespace {
 // We keep track of all full shaders read by these utility functions. If we're asked to load
 // the same shader twice, the second time will just used the cached version.
 std::unordered_map<size_t, std::vector<std::string>> shaderCache;
+
+// Programs built by buildSharedProgram(), keyed by the hash of their complete source code.
+std::unordered_map<size_t, std::weak_ptr<openrl::Program>> programCache;
+
+// Preprocessed shaders are also kept on disk between runs, in the user cache directory rather than next to the
+// shaders so that the source tree stays clean. An entry is reused as long as the contents of the shader and of
+// everything it includes are unchanged, which is assumed without reading a file if its size and modification time
+// still match. Changes are only written out by flushShaderCache().
+constexpr uint32_t kShaderCacheMagic = 0x44485348; // 'HSHD'.
+constexpr uint32_t kShaderCacheVersion = 1;
+
+struct SourceFile {
+    std::string path;
+    uint64_t size = 0;
+    int64_t modifiedTime = 0;
+    uint64_t contentHash = 0;
+};
+
+struct PreprocessedShader {
+    std::vector<SourceFile> files; // The shader itself and all of its transitive includes.
+    std::vector<std::string> sourceCode;
+};
+
+std::unordered_map<std::string, PreprocessedShader> diskCache; // key = full path of the shader.
+bool diskCacheRead = false;
+bool diskCacheDirty = false; // Set when 'diskCache' differs from the file.
+
+// Same lookup as readTextFile(), which also tries one directory back.
+std::string resolvePath(const std::string_view path)
+{
+    std::error_code error;
+    if (std::filesystem::exists(path, error)) {
+        return std::string(path);
+    }
+    return "../" + std::string(path);
+}
+
+bool fileStatus(const std::string_view path, uint64_t& size, int64_t& modifiedTime)
+{
+    std::error_code error;
+    const std::string resolvedPath = resolvePath(path);
+    size = std::filesystem::file_size(resolvedPath, error);
+    if (error) {
+        return false;
+    }
+    modifiedTime = int64_t(std::filesystem::last_write_time(resolvedPath, error).time_since_epoch().count());
+    return !error;
+}
+
+void readShaderCache()
+{
+    diskCacheRead = true;
+
+    const std::string path = shaderCachePath();
+    util::MappedFile file;
+    if (!file.open(path)) {
+        return;
+    }
+
+    util::BinaryReader reader(file.data(), file.size());
+    uint32_t magic = 0;
+    uint32_t version = 0;
+    uint64_t shaderCount = 0;
+    if (!reader.read(magic) || !reader.read(version) || (magic != kShaderCacheMagic) || (version != kShaderCacheVersion) || !reader.read(shaderCount)) {
+        LOG_INFO("Shader cache %s is out of date - ignoring it", path.c_str());
+        return;
+    }
+
+    for (uint64_t ii = 0; (ii < shaderCount) && reader.valid(); ++ii) {
+        std::string shaderPath;
+        PreprocessedShader shader;
+        uint64_t count = 0;
+        reader.readString(shaderPath);
+        if (reader.read(count) && (count <= reader.remaining())) {
+            shader.files.resize(size_t(count));
+            for (SourceFile& sourceFile : shader.files) {
+                reader.readString(sourceFile.path);
+                reader.read(sourceFile.size);
+                reader.read(sourceFile.modifiedTime);
+                reader.read(sourceFile.contentHash);
+            }
+        }
+        if (reader.read(count) && (count <= reader.remaining())) {
+            shader.sourceCode.resize(size_t(count));
+            for (std::string& code : shader.sourceCode) {
+                reader.readString(code);
+            }
+        }
+        if (reader.valid()) {
+            diskCache[shaderPath] = std::move(shader);
+        }
+    }
+
+    if (!reader.valid()) {
+        LOG_WARNING("Shader cache %s is corrupt - ignoring it", path.c_str());
+        diskCache.clear();
+        return;
+    }
+    LOG_INFO("Read %zu preprocessed shaders from %s", diskCache.size(), path.c_str());
+}
+
+void writeShaderCache()
+{
+    util::BinaryWriter writer;
+    writer.write(kShaderCacheMagic);
+    writer.write(kShaderCacheVersion);
+    writer.write(uint64_t(diskCache.size()));
+    for (const auto& [shaderPath, shader] : diskCache) {
+        writer.writeString(shaderPath);
+        writer.write(uint64_t(shader.files.size()));
+        for (const SourceFile& sourceFile : shader.files) {
+            writer.writeString(sourceFile.path);
+            writer.write(sourceFile.size);
+            writer.write(sourceFile.modifiedTime);
+            writer.write(sourceFile.contentHash);
+        }
+        writer.write(uint64_t(shader.sourceCode.size()));
+        for (const std::string& code : shader.sourceCode) {
+            writer.writeString(code);
+        }
+    }
+
+    // Failing to write the cache only costs time on the next run.
+    const std::string path = shaderCachePath();
+    const std::string tempPath = path + ".tmp";
+    {
+        std::ofstream fout(tempPath, std::ios::binary | std::ios::trunc);
+        fout.write(reinterpret_cast<const char*>(writer.buffer().data()), writer.size());
+        fout.close();
+        if (!fout) {
+            LOG_WARNING("Failed to write shader cache %s", tempPath.c_str());
+            std::error_code error;
+            std::filesystem::remove(tempPath, error);
+            return;
+        }
+    }
+
+    std::error_code error;
+    std::filesystem::rename(tempPath, path, error);
+    if (error) {
+        LOG_WARNING("Unable to move shader cache into place at %s: %s", path.c_str(), error.message().c_str());
+        std::filesystem::remove(tempPath, error);
+    }
+}
+
+// Returns false if any file the shader was preprocessed from has changed. Files that were only touched get their
+// size and modification time updated, in which case 'touched' is set.
+bool revalidate(PreprocessedShader& shader, bool& touched)
+{
+    for (SourceFile& sourceFile : shader.files) {
+        uint64_t size = 0;
+        int64_t modifiedTime = 0;
+        if (!fileStatus(sourceFile.path, size, modifiedTime)) {
+            return false;
+        }
+        if ((size == sourceFile.size) && (modifiedTime == sourceFile.modifiedTime)) {
+            continue;
+        }
+
+        std::string content;
+        if ((size != sourceFile.size) || !readTextFile(sourceFile.path, content) ||
+            (FNV1a(content.data(), content.size()) != sourceFile.contentHash)) {
+            return false;
+        }
+        sourceFile.modifiedTime = modifiedTime;
+        touched = true;
+    }
+    return true;
+}
+
+// Returns nullptr if either shader fails to compile or the program fails to link, which happens routinely while a
+// shader is being edited with hot reloading. The RLWrapper logs the reason.
+std::shared_ptr<openrl::Program> linkProgram(const std::vector<std::string>& vertexShaderSource, const std::vector<std::string>& rayShaderSource, const std::string_view name)
+{
+    std::shared_ptr<openrl::Shader> vertex = openrl::Shader::createFromMultipleStrings(vertexShaderSource, openrl::Shader::ShaderType::kVertex, name);
+    if (!vertex) {
+        return nullptr;
+    }
+
+    std::shared_ptr<openrl::Shader> ray = openrl::Shader::createFromMultipleStrings(rayShaderSource, openrl::Shader::ShaderType::kRay, name);
+    if (!ray) {
+        return nullptr;
+    }
+
+    std::shared_ptr<openrl::Program> program = openrl::Program::create();
+    program->attach(vertex);
+    program->attach(ray);
+    if (!program->link(name)) {
+        return nullptr;
+    }
+
+    return program;
+}
+
+void loadProgramSource(const std::string_view vertexShaderPath, const std::string_view rayShaderPath, const std::string_view shaderPrefix,
+                       std::vector<std::string>& vertexShaderSource, std::vector<std::string>& rayShaderSource)
+{
+    if (shaderPrefix.size()) {
+        vertexShaderSource.emplace_back(std::string{shaderPrefix});
+        rayShaderSource.emplace_back(std::string{shaderPrefix});
+    }
+    util::loadShaderSourceFile(vertexShaderPath, vertexShaderSource);
+    util::loadShaderSourceFile(rayShaderPath, rayShaderSource);
+}
 } // empty namespace.
 
 // This function recursively adds the shader code to the passed-in vector. For each file it reads, it searches for "#include" and then
 // calls itself with the new filename etc etc. Note that it just looks for "#include" directly, this means that if there is an include
-// statement anywhere (even in comments) then it will try to process it!
-bool loadShaderSourceFileRecursive(const std::string_view filename, std::vector<std::string>& finalSourceCode, HashTable &filesRead)
+// statement anywhere (even in comments) then it will try to process it! Every file that is read is recorded in 'files'.
+bool loadShaderSourceFileRecursive(const std::string_view filename, std::vector<std::string>& finalSourceCode, HashTable &filesRead,
+                                   std::vector<SourceFile>& files)
 {
     std::string sourceCode;
     if (readTextFile(filename.data(), sourceCode)) {
-        // Check the source code for any "#include" files.
+        SourceFile sourceFile;
+        sourceFile.path = std::string(filename);
+        sourceFile.contentHash = FNV1a(sourceCode.data(), sourceCode.size());
+        fileStatus(filename, sourceFile.size, sourceFile.modifiedTime);
+        files.push_back(std::move(sourceFile));
+
+        // Copy the source code up to each "#include" in a single pass, the included files come before it in the final code.
+        std::string strippedCode;
+        strippedCode.reserve(sourceCode.size());
+        size_t copiedOffset = 0;
         size_t offset = 0;
-        while ((offset = sourceCode.find("#include", 0)) != std::string::npos) {
+        while ((offset = sourceCode.find("#include", offset)) != std::string::npos) {
             // Should be formatted something like: #include "shader.rlsl"
             size_t nameStartOffset = sourceCode.find("\"", offset);
             assert(nameStartOffset != std::string::npos);
@@ -39,8 +260,9 @@ bool loadShaderSourceFileRecursive(const std::string_view filename, std::vector<
             assert(nameEndOffset != std::string::npos);
             std::string shaderName = sourceCode.substr(nameStartOffset + 1, nameEndOffset - nameStartOffset - 1);
 
-            // Get rid of the "#include "blah.rlsl" in the source code.
-            sourceCode.erase(offset, nameEndOffset - offset + 1);
+            // Leave out the "#include "blah.rlsl" from the source code.
+            strippedCode.append(sourceCode, copiedOffset, offset - copiedOffset);
+            offset = copiedOffset = nameEndOffset + 1;
 
             if (filesRead.find(shaderName) != filesRead.end()) {
                 // We've already added this source file to the final shader code.
@@ -50,12 +272,13 @@ bool loadShaderSourceFileRecursive(const std::string_view filename, std::vector<
 
             std::string nextFile{kShaderDir};
             nextFile.append(shaderName);
-            if (!loadShaderSourceFileRecursive(nextFile, finalSourceCode, filesRead)) {
+            if (!loadShaderSourceFileRecursive(nextFile, finalSourceCode, filesRead, files)) {
                 return false;
             }
         }
+        strippedCode.append(sourceCode, copiedOffset, std::string::npos);
 
-        finalSourceCode.push_back(sourceCode);
+        finalSourceCode.push_back(std::move(strippedCode));
 
         return true;
     }
@@ -77,19 +300,93 @@ bool loadShaderSourceFile(const std::string_view filepath, std::vector<std::stri
         }
     }
 
-    HashTable filesRead;
     std::string fullPath;
     fullPath.append(kShaderDir);
     fullPath.append(filepath);
-    bool result = loadShaderSourceFileRecursive(fullPath, finalSourceCode, filesRead);
+
+    // Next try the preprocessed shaders from previous runs.
+    if (!diskCacheRead) {
+        readShaderCache();
+    }
+    auto iter = diskCache.find(fullPath);
+    if (iter != diskCache.end()) {
+        bool touched = false;
+        if (revalidate(iter->second, touched)) {
+            diskCacheDirty = diskCacheDirty || touched;
+            shaderCache[shaderHash] = iter->second.sourceCode;
+            finalSourceCode.insert(finalSourceCode.end(), iter->second.sourceCode.begin(), iter->second.sourceCode.end());
+            return true;
+        }
+        diskCache.erase(iter);
+    }
+
+    // Only the code of this shader is cached, not whatever the caller already put in 'finalSourceCode' (e.g. a prefix).
+    HashTable filesRead;
+    PreprocessedShader shader;
+    bool result = loadShaderSourceFileRecursive(fullPath, shader.sourceCode, filesRead, shader.files);
     if (result) {
-        // Update the shader cache.
-        shaderCache[shaderHash] = finalSourceCode;
+        // Update the shader caches.
+        shaderCache[shaderHash] = shader.sourceCode;
+        finalSourceCode.insert(finalSourceCode.end(), shader.sourceCode.begin(), shader.sourceCode.end());
+        diskCache[fullPath] = std::move(shader);
+        diskCacheDirty = true;
     }
 
     return result;
 }
 
+std::vector<std::string> invalidateShaderSources(const std::vector<std::string>& changedFiles)
+{
+    // Every shader loaded by this process is in the disk cache along with all of the files it was preprocessed from,
+    // which makes it the include dependency graph of the loaded shaders.
+    std::vector<std::string> affectedShaders;
+    for (auto iter = diskCache.begin(); iter != diskCache.end();) {
+        const std::vector<SourceFile>& files = iter->second.files;
+        const bool affected = std::any_of(files.begin(), files.end(), [&](const SourceFile& sourceFile) {
+            const std::string_view name = std::string_view(sourceFile.path).substr(kShaderDir.size());
+            return std::find(changedFiles.begin(), changedFiles.end(), name) != changedFiles.end();
+        });
+        if (!affected) {
+            ++iter;
+            continue;
+        }
+
+        const std::string_view shaderName = std::string_view(iter->first).substr(kShaderDir.size());
+        shaderCache.erase(hashCombine(0, shaderName));
+        affectedShaders.emplace_back(shaderName);
+        iter = diskCache.erase(iter);
+        diskCacheDirty = true;
+    }
+
+    return affectedShaders;
+}
+
+void flushShaderCache()
+{
+    if (diskCacheDirty) {
+        writeShaderCache();
+        diskCacheDirty = false;
+    }
+}
+
+std::string shaderCachePath()
+{
+    std::error_code error;
+    const std::filesystem::path shaderDirectory = std::filesystem::absolute(resolvePath(kShaderDir), error).lexically_normal();
+    const std::string directoryName = shaderDirectory.generic_string();
+    char fileName[64];
+    snprintf(fileName, sizeof(fileName), "shaders-%016llx.hrshaders", static_cast<unsigned long long>(FNV1a(directoryName.data(), directoryName.size())));
+    return (std::filesystem::path(userCacheDirectory()) / fileName).string();
+}
+
+void clearShaderSourceCache()
+{
+    shaderCache.clear();
+    diskCache.clear();
+    diskCacheRead = false;
+    diskCacheDirty = false;
+}
+
 std::shared_ptr<openrl::Program> buildProgram(const std::string_view vertexShaderPath, const std::string_view rayShaderPath, const std::string_view name, const std::string_view shaderPrefix)
 {
     assert(vertexShaderPath.data());
@@ -97,34 +394,53 @@ std::shared_ptr<openrl::Program> buildProgram(const std::string_view vertexShade
     assert(name.data());
     
     std::vector<std::string> vertexShaderSource;
-    if (shaderPrefix.size()) {
-        vertexShaderSource.emplace_back(std::string{shaderPrefix});
-    }
-    util::loadShaderSourceFile(vertexShaderPath, vertexShaderSource);
-    std::shared_ptr<openrl::Shader> vertex = openrl::Shader::createFromMultipleStrings(vertexShaderSource, openrl::Shader::ShaderType::kVertex, name);
-    if (!vertex) {
-        assert(0 && "Unable to create vertex shader");
-    }
+    std::vector<std::string> rayShaderSource;
+    loadProgramSource(vertexShaderPath, rayShaderPath, shaderPrefix, vertexShaderSource, rayShaderSource);
+    return linkProgram(vertexShaderSource, rayShaderSource, name);
+}
+
+std::shared_ptr<openrl::Program> buildSharedProgram(const std::string_view vertexShaderPath, const std::string_view rayShaderPath, const std::string_view name, const std::string_view shaderPrefix)
+{
+    assert(vertexShaderPath.data());
+    assert(rayShaderPath.data());
+    assert(name.data());
 
+    std::vector<std::string> vertexShaderSource;
     std::vector<std::string> rayShaderSource;
-    if (shaderPrefix.size()) {
-        rayShaderSource.emplace_back(std::string{shaderPrefix});
+    loadProgramSource(vertexShaderPath, rayShaderPath, shaderPrefix, vertexShaderSource, rayShaderSource);
+
+    // The prefix is part of both sources so it is covered by hashing them. The separator keeps the vertex and ray
+    // sources from being interchangeable.
+    size_t programHash = 0;
+    for (const std::string& source : vertexShaderSource) {
+        programHash = hashCombine(programHash, source);
     }
-    util::loadShaderSourceFile(rayShaderPath, rayShaderSource);
-    std::shared_ptr<openrl::Shader> ray = openrl::Shader::createFromMultipleStrings(rayShaderSource, openrl::Shader::ShaderType::kRay, name);
-    if (!ray) {
-        assert(0 && "Unable to create ray shader");
+    programHash = hashCombine(programHash, rayShaderSource.size());
+    for (const std::string& source : rayShaderSource) {
+        programHash = hashCombine(programHash, source);
     }
 
-    std::shared_ptr<openrl::Program> program = openrl::Program::create();
-    program->attach(vertex);
-    program->attach(ray);
-    if (!program->link(name)) {
-        assert(0 && "Unable to create program");
-        return nullptr;
+    auto iter = programCache.find(programHash);
+    if (iter != programCache.end()) {
+        if (std::shared_ptr<openrl::Program> program = iter->second.lock()) {
+            return program;
+        }
     }
 
+    // Entries of programs that were released since the last miss are dropped here rather than leaking one entry per
+    // variant ever built, which adds up when scenes are loaded one after another.
+    std::erase_if(programCache, [](const auto& entry) { return entry.second.expired(); });
+
+    std::shared_ptr<openrl::Program> program = linkProgram(vertexShaderSource, rayShaderSource, name);
+    if (program) {
+        programCache[programHash] = program;
+    }
     return program;
 }
 
+size_t sharedProgramCacheSize()
+{
+    return programCache.size();
+}
+
 } // namespace util.
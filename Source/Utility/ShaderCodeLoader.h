@@ -20,12 +20,51 @@ namespace util {
 
 //-------------------------------------------------------------------------
 // Load a shader source file and resolve any "#include" statements. Each
-// source file will be placed in the resulting vector.
+// source file will be placed in the resulting vector. The preprocessed
+// source is cached in util::userCacheDirectory() and reused by later runs
+// until the shader or any file it includes changes, see flushShaderCache().
 bool loadShaderSourceFile(const std::string_view filepath, std::vector<std::string> &finalSourceCode);
 
+//-------------------------------------------------------------------------
+// Forget the preprocessed source of every loaded shader that is one of, or
+// includes one of, 'changedFiles' so that loading it again reads the files
+// from disk. Returns the affected shaders. All file names are relative to
+// the shader directory, the same as for 'loadShaderSourceFile()'.
+std::vector<std::string> invalidateShaderSources(const std::vector<std::string> &changedFiles);
+
+//-------------------------------------------------------------------------
+// Write the preprocessed shaders to the disk cache if anything changed
+// since the last flush. Call once a batch of shaders has been loaded (e.g.
+// a scene) and at shutdown rather than after every shader.
+void flushShaderCache();
+
+//-------------------------------------------------------------------------
+// File the preprocessed shaders are cached in. Every shader directory gets
+// its own file in util::userCacheDirectory().
+std::string shaderCachePath();
+
+//-------------------------------------------------------------------------
+// Forget every preprocessed shader held in memory without flushing, so that
+// the next load starts from the disk cache as if Heatray had just started.
+void clearShaderSourceCache();
+
 //-------------------------------------------------------------------------
 // Convenience function to build a program directly given shader paths.
-// This function internally uses 'loadShaderSourceFile()'.
+// This function internally uses 'loadShaderSourceFile()'. Returns nullptr
+// if the shaders fail to compile or link.
 std::shared_ptr<openrl::Program> buildProgram(const std::string_view vertexShaderPath, const std::string_view rayShaderPath, const std::string_view name, const std::string_view shaderPrefix = "");
 
+//-------------------------------------------------------------------------
+// Same as 'buildProgram()' except that programs are shared between callers
+// whose shader sources and prefix are identical, so only the first one pays
+// for compiling and linking. Only suited to programs whose per-object state
+// (uniform values and blocks) is set while an RLprimitive is bound. A
+// program is released once nobody holds on to it anymore.
+std::shared_ptr<openrl::Program> buildSharedProgram(const std::string_view vertexShaderPath, const std::string_view rayShaderPath, const std::string_view name, const std::string_view shaderPrefix = "");
+
+//-------------------------------------------------------------------------
+// Number of programs remembered by 'buildSharedProgram()', including ones
+// that were released since it last had to build a program.
+size_t sharedProgramCacheSize();
+
 } // namespace util.
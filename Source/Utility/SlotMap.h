@@ -0,0 +1,153 @@
+//
+//  SlotMap.h
+//  Heatray
+//
+//  Container that hands out stable generational handles to its elements.
+//
+//
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <utility>
+#include <vector>
+
+namespace util {
+
+//-------------------------------------------------------------------------
+// Elements are stored contiguously (in no particular order) for iteration
+// and are referenced from outside through handles that stay valid until
+// the element is erased. Adding and erasing are O(1): erasing moves the
+// last element into the hole rather than shifting the ones after it. A
+// handle to an erased element is detected via the generation of its slot,
+// which is bumped every time the slot is freed.
+template<class T>
+class SlotMap
+{
+public:
+    struct Handle {
+        uint32_t index = kInvalidIndex;
+        uint32_t generation = 0; // Slot generations start at 1 so a default constructed handle is never valid.
+
+        bool operator==(const Handle& other) const { return (index == other.index) && (generation == other.generation); }
+        bool operator!=(const Handle& other) const { return !(*this == other); }
+    };
+
+    using iterator = typename std::vector<T>::iterator;
+    using const_iterator = typename std::vector<T>::const_iterator;
+
+    //-------------------------------------------------------------------------
+    // Construct a new element in place and return its handle.
+    template<class... Args>
+    Handle emplace(Args&&... args)
+    {
+        uint32_t slotIndex = m_freeSlot;
+        if (slotIndex == kInvalidIndex) {
+            slotIndex = uint32_t(m_slots.size());
+            m_slots.push_back(Slot());
+        } else {
+            m_freeSlot = m_slots[slotIndex].valueIndex;
+        }
+
+        Slot& slot = m_slots[slotIndex];
+        slot.valueIndex = uint32_t(m_values.size());
+        m_values.emplace_back(std::forward<Args>(args)...);
+        m_valueSlots.push_back(slotIndex);
+
+        return Handle{ slotIndex, slot.generation };
+    }
+
+    //-------------------------------------------------------------------------
+    // Destroy the element referenced by 'handle'. Returns false if the handle
+    // was not valid.
+    bool erase(Handle handle)
+    {
+        if (!contains(handle)) {
+            return false;
+        }
+
+        Slot& slot = m_slots[handle.index];
+        const uint32_t valueIndex = slot.valueIndex;
+        const uint32_t lastIndex = uint32_t(m_values.size() - 1);
+        if (valueIndex != lastIndex) {
+            m_values[valueIndex] = std::move(m_values[lastIndex]);
+            m_valueSlots[valueIndex] = m_valueSlots[lastIndex];
+            m_slots[m_valueSlots[valueIndex]].valueIndex = valueIndex;
+        }
+        m_values.pop_back();
+        m_valueSlots.pop_back();
+
+        freeSlot(handle.index);
+        return true;
+    }
+
+    //-------------------------------------------------------------------------
+    // Returns true if 'handle' references an element of this map.
+    bool contains(Handle handle) const
+    {
+        if ((handle.index >= m_slots.size()) || (m_slots[handle.index].generation != handle.generation)) {
+            return false;
+        }
+        // Free slots link to each other through 'valueIndex' so it has to point back at the slot as well.
+        const uint32_t valueIndex = m_slots[handle.index].valueIndex;
+        return (valueIndex < m_valueSlots.size()) && (m_valueSlots[valueIndex] == handle.index);
+    }
+
+    //-------------------------------------------------------------------------
+    // Returns nullptr if 'handle' is not valid. The pointer is invalidated by
+    // the next call to emplace() or erase().
+    T* get(Handle handle) { return contains(handle) ? &m_values[m_slots[handle.index].valueIndex] : nullptr; }
+    const T* get(Handle handle) const { return contains(handle) ? &m_values[m_slots[handle.index].valueIndex] : nullptr; }
+
+    //-------------------------------------------------------------------------
+    // Erase all elements. Handles to them are invalidated as if erased one
+    // by one.
+    void clear()
+    {
+        for (uint32_t slotIndex : m_valueSlots) {
+            freeSlot(slotIndex);
+        }
+        m_values.clear();
+        m_valueSlots.clear();
+    }
+
+    void reserve(size_t count)
+    {
+        m_values.reserve(count);
+        m_valueSlots.reserve(count);
+        m_slots.reserve(count);
+    }
+
+    size_t size() const { return m_values.size(); }
+    bool empty() const { return m_values.empty(); }
+
+    // Iteration visits the elements in storage order, which changes whenever an element is erased.
+    iterator begin() { return m_values.begin(); }
+    iterator end() { return m_values.end(); }
+    const_iterator begin() const { return m_values.begin(); }
+    const_iterator end() const { return m_values.end(); }
+
+    static constexpr uint32_t kInvalidIndex = ~uint32_t(0);
+
+private:
+    struct Slot {
+        uint32_t valueIndex = kInvalidIndex; // Into m_values if in use, otherwise the next free slot.
+        uint32_t generation = 1;
+    };
+
+    void freeSlot(uint32_t slotIndex)
+    {
+        Slot& slot = m_slots[slotIndex];
+        slot.generation = (slot.generation == ~uint32_t(0)) ? 1 : (slot.generation + 1);
+        slot.valueIndex = m_freeSlot;
+        m_freeSlot = slotIndex;
+    }
+
+    std::vector<T> m_values;
+    std::vector<uint32_t> m_valueSlots; // Slot of each element of m_values.
+    std::vector<Slot> m_slots;
+    uint32_t m_freeSlot = kInvalidIndex; // Head of the list of free slots.
+};
+
+} // namespace util.
@@ -8,23 +8,30 @@
 
 #pragma once
 
+#include <algorithm>
 #include <assert.h>
+#include <stdio.h>
 #include <string>
 #include <string_view>
 
 namespace util {
 
+//-------------------------------------------------------------------------
+// Format into 'buffer' using printf-style syntax without allocating. The
+// result is truncated if it does not fit.
+template <size_t N, class ... Args>
+inline std::string_view formatToBuffer(char (&buffer)[N], const std::string_view format, Args &&... args) {
+    int length = snprintf(buffer, N, format.data(), args...);
+    assert(length < int(N));
+    return std::string_view(buffer, (length < 0) ? 0 : std::min(size_t(length), N - 1));
+}
+
 //-------------------------------------------------------------------------
 // Create a string using printf-style syntax.
 template <class ... Args>
 inline std::string createStringWithFormat(const std::string_view format, Args &&... args) {
-    std::string out;
-    char str[4096] = { 0 };
-    int length = snprintf(str, 4095, format.data(), args...);
-    assert(length < 4096);
-    out = str;
-
-    return out;
+    char str[4096];
+    return std::string(formatToBuffer(str, format, args...));
 }
 
 }  // namespace util.
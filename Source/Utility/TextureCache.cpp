@@ -0,0 +1,294 @@
+#include "TextureCache.h"
+
+#include "Log.h"
+
+#include <algorithm>
+#include <filesystem>
+
+namespace util {
+
+namespace {
+
+std::string cacheKey(const std::string_view path, bool generateMips, bool convertToLinear, const TextureLoadOptions& options)
+{
+    // Different spellings of the same file (relative paths, "..", etc) must map to the same entry.
+    std::error_code error;
+    std::filesystem::path canonicalPath = std::filesystem::weakly_canonical(std::filesystem::path(path), error);
+    if (error) {
+        canonicalPath = std::filesystem::path(path).lexically_normal();
+    }
+
+    std::string key = canonicalPath.string();
+    key += generateMips ? "|mips" : "|nomips";
+    key += convertToLinear ? "|linear" : "|raw";
+    key += "|max" + std::to_string(options.maxDimension);
+    key += "|storage" + std::to_string(uint32_t(options.storage));
+    return key;
+}
+
+} // namespace.
+
+TextureCache& TextureCache::instance()
+{
+    static TextureCache cache;
+    return cache;
+}
+
+TextureCache::Request TextureCache::request(const std::string_view path, bool generateMips, bool convertToLinear, const TextureLoadOptions& options)
+{
+    Request request;
+    request.key = cacheKey(path, generateMips, convertToLinear, options);
+    request.generateMips = generateMips;
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    ++m_requestCount;
+
+    auto iter = m_entries.find(request.key);
+    if (iter != m_entries.end()) {
+        ++m_hitCount;
+        if (iter->second.uploaded) {
+            m_bytesSaved += iter->second.byteCount;
+            request.texture = iter->second.texture;
+        } else {
+            request.decoded = iter->second.decoded;
+        }
+        return request;
+    }
+
+    Entry& entry = m_entries[request.key];
+    entry.decoded = loadTextureAsync(path, generateMips, convertToLinear, options).share();
+    request.decoded = entry.decoded;
+    return request;
+}
+
+std::shared_ptr<openrl::Texture> TextureCache::resolve(const Request& request)
+{
+    if (request.texture || !request.decoded.valid()) {
+        return request.texture;
+    }
+
+    // Only the first request for a texture uploads it, all later ones share the result.
+    auto findUploaded = [this, &request](std::shared_ptr<openrl::Texture>& texture) {
+        auto iter = m_entries.find(request.key);
+        if ((iter != m_entries.end()) && iter->second.uploaded) {
+            m_bytesSaved += iter->second.byteCount;
+            texture = iter->second.texture;
+            return true;
+        }
+        return false;
+    };
+
+    std::shared_ptr<openrl::Texture> texture = nullptr;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (findUploaded(texture)) {
+            return texture;
+        }
+    }
+
+    const LoadedTexture& loadedTexture = request.decoded.get();
+    if (loadedTexture.pixels) {
+        const std::string_view path = std::string_view(request.key).substr(0, request.key.find('|')); // The key starts with the canonical path.
+        texture = openrl::Texture::create(loadedTexture.pixels.get(), loadedTexture.desc, loadedTexture.sampler, request.generateMips, path);
+    }
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    Entry& entry = m_entries[request.key];
+    entry.texture = texture;
+    entry.byteCount = loadedTexture.pixels ? textureByteCount(loadedTexture.desc) : 0;
+    entry.uploaded = true;
+    entry.decoded = std::shared_future<LoadedTexture>(); // The pixels are no longer needed once uploaded.
+    return texture;
+}
+
+std::vector<std::shared_ptr<openrl::Texture>> TextureCache::getAll(const std::vector<TextureLoadRequest>& requests, size_t queueDepth)
+{
+    std::vector<std::shared_ptr<openrl::Texture>> textures(requests.size(), nullptr);
+
+    // Split the requests into ones the cache can already answer (or that are being decoded by
+    // request()) and distinct textures that still need to go through the decode pipeline.
+    std::vector<std::string> keys(requests.size());
+    std::vector<Request> inFlight;
+    std::vector<TextureLoadRequest> pending;
+    std::vector<std::string> pendingKeys;
+    std::unordered_map<std::string, size_t> pendingIndices;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        for (size_t ii = 0; ii < requests.size(); ++ii) {
+            const TextureLoadRequest& loadRequest = requests[ii];
+            keys[ii] = cacheKey(loadRequest.path, loadRequest.generateMips, loadRequest.convertToLinear, loadRequest.options);
+            ++m_requestCount;
+
+            auto iter = m_entries.find(keys[ii]);
+            if (iter != m_entries.end()) {
+                ++m_hitCount;
+                if (iter->second.uploaded) {
+                    m_bytesSaved += iter->second.byteCount;
+                    textures[ii] = iter->second.texture;
+                } else {
+                    inFlight.push_back({ keys[ii], loadRequest.generateMips, iter->second.decoded, nullptr });
+                }
+            } else if (pendingIndices.find(keys[ii]) != pendingIndices.end()) {
+                ++m_hitCount; // Bytes saved are counted once the texture has been uploaded below.
+            } else {
+                pendingIndices[keys[ii]] = pending.size();
+                pending.push_back(loadRequest);
+                pendingKeys.push_back(keys[ii]);
+            }
+        }
+    }
+
+    for (const Request& request : inFlight) {
+        resolve(request);
+    }
+
+    loadTexturesPipelined(pending, queueDepth, [this, &pending, &pendingKeys](size_t index, LoadedTexture& loadedTexture) {
+        std::shared_ptr<openrl::Texture> texture = nullptr;
+        if (loadedTexture.pixels) {
+            texture = openrl::Texture::create(loadedTexture.pixels.get(), loadedTexture.desc, loadedTexture.sampler, pending[index].generateMips,
+                                              pending[index].path);
+        }
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+        Entry& entry = m_entries[pendingKeys[index]];
+        entry.texture = texture;
+        entry.byteCount = loadedTexture.pixels ? textureByteCount(loadedTexture.desc) : 0;
+        entry.uploaded = true;
+    });
+
+    // Everything requested is now uploaded, fill in the textures that were not already known.
+    std::lock_guard<std::mutex> lock(m_mutex);
+    std::vector<bool> firstUse(pendingKeys.size(), true);
+    for (size_t ii = 0; ii < requests.size(); ++ii) {
+        if (textures[ii]) {
+            continue;
+        }
+
+        const Entry& entry = m_entries[keys[ii]];
+        textures[ii] = entry.texture;
+
+        auto pendingIter = pendingIndices.find(keys[ii]);
+        if (pendingIter != pendingIndices.end()) {
+            if (!firstUse[pendingIter->second]) {
+                m_bytesSaved += entry.byteCount;
+            }
+            firstUse[pendingIter->second] = false;
+        }
+    }
+
+    return textures;
+}
+
+void TextureCache::prefetch(const std::vector<TextureLoadRequest>& requests, uint64_t generation, PrefetchCallback decoded, size_t queueDepth,
+                            size_t byteBudget)
+{
+    const size_t batchSize = std::max(queueDepth, size_t(1));
+    size_t prefetchedBytes = 0;
+    size_t next = 0;
+    while ((next < requests.size()) && (prefetchedBytes < byteBudget)) {
+        // Requests for textures that are already known are reported right away, the rest of the batch get an entry
+        // whose future is fulfilled as soon as the pipeline has decoded them.
+        std::vector<size_t> known;
+        std::vector<TextureLoadRequest> pending;
+        std::vector<size_t> pendingIndices; // Index into 'requests' of each pending texture.
+        std::vector<std::promise<LoadedTexture>> promises;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (generation <= m_releasedGeneration) {
+                return; // The load was abandoned before its textures were needed.
+            }
+
+            for (; (next < requests.size()) && (pending.size() < batchSize); ++next) {
+                const TextureLoadRequest& loadRequest = requests[next];
+                std::string key = cacheKey(loadRequest.path, loadRequest.generateMips, loadRequest.convertToLinear, loadRequest.options);
+                auto iter = m_entries.find(key);
+                if (iter != m_entries.end()) {
+                    // Keep a texture that an earlier load prefetched around for this one as well.
+                    if (!iter->second.uploaded && (iter->second.generation != 0)) {
+                        iter->second.generation = std::max(iter->second.generation, generation);
+                    }
+                    known.push_back(next);
+                    continue;
+                }
+
+                promises.emplace_back();
+                Entry& entry = m_entries[key];
+                entry.decoded = promises.back().get_future().share();
+                entry.generation = generation;
+                pending.push_back(loadRequest);
+                pendingIndices.push_back(next);
+            }
+        }
+
+        if (decoded) {
+            for (size_t index : known) {
+                decoded(index, 0);
+            }
+        }
+
+        loadTexturesPipelined(pending, queueDepth, [&decoded, &pendingIndices, &promises, &prefetchedBytes](size_t index, LoadedTexture& loadedTexture) {
+            size_t byteCount = loadedTexture.pixels ? textureByteCount(loadedTexture.desc) : 0;
+            prefetchedBytes += byteCount;
+            promises[index].set_value(std::move(loadedTexture));
+            if (decoded) {
+                decoded(pendingIndices[index], byteCount);
+            }
+        });
+    }
+}
+
+void TextureCache::releasePrefetched(uint64_t generation)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_releasedGeneration = std::max(m_releasedGeneration, generation);
+
+    // Entries that are still being decoded can be dropped as well, prefetch() keeps fulfilling their promises.
+    for (auto iter = m_entries.begin(); iter != m_entries.end();) {
+        const Entry& entry = iter->second;
+        if (!entry.uploaded && (entry.generation != 0) && (entry.generation <= m_releasedGeneration)) {
+            iter = m_entries.erase(iter);
+        } else {
+            ++iter;
+        }
+    }
+}
+
+void TextureCache::releaseUnused()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for (auto iter = m_entries.begin(); iter != m_entries.end();) {
+        const Entry& entry = iter->second;
+        if (entry.uploaded && (!entry.texture || (entry.texture.use_count() == 1))) {
+            iter = m_entries.erase(iter);
+        } else {
+            ++iter;
+        }
+    }
+}
+
+void TextureCache::clear()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_entries.clear();
+}
+
+TextureCache::Statistics TextureCache::statistics() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return { m_requestCount, m_hitCount, m_bytesSaved };
+}
+
+void TextureCache::logStatistics(const std::string_view label)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_requestCount > 0) {
+        LOG_INFO("%s: texture cache hit %llu of %llu requests (%.1f%%), saved %.2f MB of decoding and uploads", std::string(label).c_str(),
+                 (unsigned long long)m_hitCount, (unsigned long long)m_requestCount, 100.0 * double(m_hitCount) / double(m_requestCount),
+                 double(m_bytesSaved) / (1024.0 * 1024.0));
+    }
+    m_requestCount = 0;
+    m_hitCount = 0;
+    m_bytesSaved = 0;
+}
+
+} // namespace util.
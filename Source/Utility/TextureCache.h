@@ -0,0 +1,157 @@
+//
+//  TextureCache.h
+//  Heatray
+//
+//  Deduplicates texture loads so that a file referenced by many materials
+//  is only decoded and uploaded to OpenRL once.
+//
+//
+
+#pragma once
+
+#include "TextureLoader.h"
+
+#include <RLWrapper/Texture.h>
+
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <stdint.h>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace util {
+
+class TextureCache
+{
+public:
+    static TextureCache& instance();
+
+    // Decoded pixel data prefetch() holds for a scene load before it leaves
+    // the remaining textures to be decoded while they are uploaded.
+    static constexpr size_t kDefaultPrefetchByteBudget = size_t(256) * 1024 * 1024;
+
+    //-------------------------------------------------------------------------
+    // Handle to a pending or completed load returned by request().
+    struct Request {
+        std::string key;
+        bool generateMips = true;
+        std::shared_future<LoadedTexture> decoded;
+        std::shared_ptr<openrl::Texture> texture = nullptr; // Set if the texture was already uploaded.
+    };
+
+    //-------------------------------------------------------------------------
+    // Start decoding 'path' on a separate thread unless the same file with
+    // the same options has already been requested, in which case the
+    // existing (possibly in-flight) load is shared. Can be called from any
+    // thread.
+    Request request(const std::string_view path, bool generateMips, bool convertToLinear,
+                    const TextureLoadOptions& options = TextureLoadOptions());
+
+    //-------------------------------------------------------------------------
+    // Wait for the decode of 'request' to complete and upload it to OpenRL
+    // unless another request for the same texture already has. Must be called
+    // on the OpenRL thread. Returns nullptr if the texture failed to load.
+    std::shared_ptr<openrl::Texture> resolve(const Request& request);
+
+    //-------------------------------------------------------------------------
+    // Synchronous version of request() followed by resolve().
+    std::shared_ptr<openrl::Texture> get(const std::string_view path, bool generateMips, bool convertToLinear,
+                                         const TextureLoadOptions& options = TextureLoadOptions())
+    {
+        return resolve(request(path, generateMips, convertToLinear, options));
+    }
+
+    //-------------------------------------------------------------------------
+    // Get the textures for all 'requests', decoding the ones that are not
+    // cached yet with loadTexturesPipelined(). Each distinct texture is only
+    // decoded once even if it appears several times in 'requests'. Must be
+    // called on the OpenRL thread. The result is in the same order as
+    // 'requests' and holds nullptr for textures that failed to load.
+    std::vector<std::shared_ptr<openrl::Texture>> getAll(const std::vector<TextureLoadRequest>& requests,
+                                                         size_t queueDepth = kDefaultTextureQueueDepth);
+
+    //-------------------------------------------------------------------------
+    // Decode the textures for 'requests' that are not cached yet on the
+    // calling thread with loadTexturesPipelined() but do not upload them, so
+    // that a later getAll() on the OpenRL thread only needs to upload them.
+    // 'generation' identifies the scene load the textures are for (starting
+    // at 1), the decoded textures are kept until releasePrefetched() is called
+    // for it. Can be called from any thread.
+    //
+    // Requests are handled in order, 'queueDepth' textures at a time, and
+    // once the textures decoded by this call hold 'byteBudget' bytes the
+    // remaining requests are skipped. getAll() decodes those while it uploads
+    // them, 'queueDepth' at a time. The pixel data held at any point is
+    // therefore at most 'byteBudget' plus one batch of textures, which are
+    // already reduced to TextureLoadOptions::maxDimension when decoded.
+    //
+    // 'decoded' is invoked on the calling thread with the index of each
+    // request that was handled once it is cached or decoded, along with the
+    // number of bytes that were decoded for it.
+    using PrefetchCallback = std::function<void(size_t index, size_t byteCount)>;
+    void prefetch(const std::vector<TextureLoadRequest>& requests, uint64_t generation, PrefetchCallback decoded = nullptr,
+                  size_t queueDepth = kDefaultTextureQueueDepth, size_t byteBudget = kDefaultPrefetchByteBudget);
+
+    //-------------------------------------------------------------------------
+    // The scene load 'generation' and all earlier ones have either been added
+    // or abandoned. Drop the textures they prefetched that were never
+    // requested, and skip prefetches that are still to come for them. Can be
+    // called from any thread.
+    void releasePrefetched(uint64_t generation);
+
+    //-------------------------------------------------------------------------
+    // Drop every uploaded texture that is no longer referenced outside of the
+    // cache. Textures prefetched for a scene load are kept until
+    // releasePrefetched() is called for it, so that a load which is still in
+    // progress does not lose them. Must be called on the OpenRL thread.
+    void releaseUnused();
+
+    //-------------------------------------------------------------------------
+    // Drop all cached textures. Must be called on the OpenRL thread before
+    // the OpenRL context is destroyed.
+    void clear();
+
+    struct Statistics {
+        uint64_t requestCount = 0;
+        uint64_t hitCount = 0;
+        uint64_t bytesSaved = 0; // Decoding and uploads that were not needed.
+    };
+
+    //-------------------------------------------------------------------------
+    // Counters accumulated since the last call to logStatistics().
+    Statistics statistics() const;
+
+    //-------------------------------------------------------------------------
+    // Log the hit rate and the number of bytes that did not need to be
+    // decoded and uploaded since the last call, then reset the counters.
+    void logStatistics(const std::string_view label);
+
+private:
+    TextureCache() = default;
+
+    // This class is not copyable.
+    TextureCache(const TextureCache& other) = delete;
+    TextureCache& operator=(const TextureCache& other) = delete;
+
+    struct Entry {
+        std::shared_future<LoadedTexture> decoded; // Released once the texture has been uploaded.
+        std::shared_ptr<openrl::Texture> texture = nullptr;
+        size_t byteCount = 0; // Size of the decoded pixel data.
+        uint64_t generation = 0; // Latest scene load that prefetched the texture, 0 if it was never prefetched.
+        bool uploaded = false;
+    };
+
+    mutable std::mutex m_mutex; // Guards everything below.
+    std::unordered_map<std::string, Entry> m_entries;
+    uint64_t m_releasedGeneration = 0; // Latest generation passed to releasePrefetched().
+
+    uint64_t m_requestCount = 0;
+    uint64_t m_hitCount = 0;
+    uint64_t m_bytesSaved = 0;
+};
+
+} // namespace util.
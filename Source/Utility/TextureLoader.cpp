@@ -1,6 +1,8 @@
 #include "TextureLoader.h"
 
 #include "Log.h"
+#include "ParallelFor.h"
+#include "Timer.h"
 
 #include <FreeImage/FreeImage.h>
 
@@ -8,13 +10,233 @@
 #include "stb/stb_image.h"
 
 #include <assert.h>
+#include <algorithm>
+#include <array>
 #include <cmath>
+#include <cstring>
+#include <condition_variable>
 #include <filesystem>
 #include <fstream>
+#include <mutex>
+#include <thread>
 
 namespace util {
 
-void loadTextureInternal(LoadedTexture& loadedTexture, const std::string_view path, bool generateMips, bool convertToLinear)
+namespace {
+
+//-------------------------------------------------------------------------
+// sRGB->linear conversion of a single 8bit channel, truncated back to 8bits.
+uint8_t srgbToLinear(uint8_t value)
+{
+    constexpr static float MAX_BYTE_VALUE = 255.0f;
+    constexpr static float SRGB_ALPHA = 0.055f;
+
+    float channelData = float(value) / MAX_BYTE_VALUE;
+
+    // Actual sRGB->linear convertion.
+    if (channelData <= 0.04045f) {
+        channelData /= 12.92f;
+    } else {
+        channelData = std::pow((channelData + SRGB_ALPHA) / (1.0f + SRGB_ALPHA), 2.4f);
+    }
+
+    // Conversion back to an 8bit byte.
+    return uint8_t(channelData * MAX_BYTE_VALUE);
+}
+
+//-------------------------------------------------------------------------
+// Every possible 8bit input run through srgbToLinear(). Built with the same
+// code as the exact path so the two are guaranteed to match bit for bit.
+const std::array<uint8_t, 256>& srgbToLinearTable()
+{
+    static const std::array<uint8_t, 256> table = []() {
+        std::array<uint8_t, 256> values;
+        for (size_t ii = 0; ii < values.size(); ++ii) {
+            values[ii] = srgbToLinear(uint8_t(ii));
+        }
+        return values;
+    }();
+    return table;
+}
+
+int channelCountForFormat(RLenum format)
+{
+    return int(openrl::MemoryTracker::channelCount(format));
+}
+
+//-------------------------------------------------------------------------
+// Box filter a single row or column of 'srcCount' texels into 'dstCount'
+// texels. Strides are in floats between consecutive texels.
+void boxFilter1D(const float* src, size_t srcCount, size_t srcStride, float* dst, size_t dstCount, size_t dstStride, int channelCount)
+{
+    const double scale = double(srcCount) / double(dstCount);
+    for (size_t ii = 0; ii < dstCount; ++ii) {
+        const double start = double(ii) * scale;
+        const double end = std::min(double(ii + 1) * scale, double(srcCount));
+
+        float* texel = dst + (ii * dstStride);
+        for (int channel = 0; channel < channelCount; ++channel) {
+            texel[channel] = 0.0f;
+        }
+
+        double totalWeight = 0.0;
+        for (size_t jj = size_t(start); (jj < srcCount) && (double(jj) < end); ++jj) {
+            const double weight = std::min(end, double(jj + 1)) - std::max(start, double(jj));
+            const float* srcTexel = src + (jj * srcStride);
+            for (int channel = 0; channel < channelCount; ++channel) {
+                texel[channel] += float(weight) * srcTexel[channel];
+            }
+            totalWeight += weight;
+        }
+
+        if (totalWeight > 0.0) {
+            for (int channel = 0; channel < channelCount; ++channel) {
+                texel[channel] = float(double(texel[channel]) / totalWeight);
+            }
+        }
+    }
+}
+
+//-------------------------------------------------------------------------
+// Downsample and/or convert the data type of a freshly loaded texture as
+// requested by 'options', logging the memory used before and after.
+void applyLoadOptions(LoadedTexture& loadedTexture, const std::string_view path, const TextureLoadOptions& options)
+{
+    if (!loadedTexture.pixels) {
+        return;
+    }
+
+    openrl::Texture::Descriptor& desc = loadedTexture.desc;
+    const int channelCount = channelCountForFormat(desc.format);
+    const size_t sourceByteCount = textureByteCount(desc);
+
+    int width = desc.width;
+    int height = desc.height;
+    if ((options.maxDimension > 0) && (uint32_t(std::max(width, height)) > options.maxDimension)) {
+        const double scale = double(options.maxDimension) / double(std::max(width, height));
+        width = std::clamp(int(std::lround(double(width) * scale)), 1, int(options.maxDimension));
+        height = std::clamp(int(std::lround(double(height) * scale)), 1, int(options.maxDimension));
+    }
+
+    RLenum dataType = desc.dataType;
+    if (options.storage == TextureStorage::kUnsignedByte) {
+        dataType = RL_UNSIGNED_BYTE;
+    } else if (options.storage == TextureStorage::kFloat) {
+        dataType = RL_FLOAT;
+    }
+
+    if ((width == desc.width) && (height == desc.height) && (dataType == desc.dataType)) {
+        LOG_INFO("Texture %s: %dx%d, %.2f MB", std::string(path).c_str(), desc.width, desc.height, double(sourceByteCount) / (1024.0 * 1024.0));
+        return;
+    }
+
+    // Filter in floats, with 8bit data normalized to [0, 1].
+    const size_t sourceCount = size_t(desc.width) * size_t(desc.height) * size_t(channelCount);
+    std::vector<float> source(sourceCount);
+    if (desc.dataType == RL_FLOAT) {
+        std::memcpy(source.data(), loadedTexture.pixels.get(), sourceCount * sizeof(float));
+    } else {
+        const uint8_t* bytes = loadedTexture.pixels.get();
+        for (size_t ii = 0; ii < sourceCount; ++ii) {
+            source[ii] = float(bytes[ii]) / 255.0f;
+        }
+    }
+    loadedTexture.pixels = nullptr; // Release the original data as early as possible.
+
+    const int sourceWidth = desc.width;
+    const int sourceHeight = desc.height;
+    std::vector<float> resized;
+    const float* result = source.data();
+    if ((width != sourceWidth) || (height != sourceHeight)) {
+        resized.resize(size_t(width) * size_t(height) * size_t(channelCount));
+        boxFilterResize(source.data(), sourceWidth, sourceHeight, channelCount, resized.data(), width, height);
+        result = resized.data();
+    }
+
+    const size_t count = size_t(width) * size_t(height) * size_t(channelCount);
+    uint8_t* pixels = nullptr;
+    if (dataType == RL_FLOAT) {
+        pixels = static_cast<uint8_t*>(malloc(count * sizeof(float)));
+        std::memcpy(pixels, result, count * sizeof(float));
+    } else {
+        pixels = static_cast<uint8_t*>(malloc(count));
+        for (size_t ii = 0; ii < count; ++ii) {
+            pixels[ii] = uint8_t(std::clamp(result[ii], 0.0f, 1.0f) * 255.0f + 0.5f);
+        }
+    }
+
+    desc.width = width;
+    desc.height = height;
+    desc.dataType = dataType;
+    loadedTexture.pixels = std::shared_ptr<uint8_t>(pixels, [](void *address) {
+        free(address);
+    });
+
+    LOG_INFO("Texture %s: resized from %dx%d (%.2f MB) to %dx%d (%.2f MB)", std::string(path).c_str(),
+             sourceWidth, sourceHeight, double(sourceByteCount) / (1024.0 * 1024.0), width, height, double(textureByteCount(desc)) / (1024.0 * 1024.0));
+}
+
+} // namespace.
+
+size_t textureByteCount(const openrl::Texture::Descriptor& desc)
+{
+    return openrl::MemoryTracker::textureByteCount(desc.format, desc.dataType, desc.width, desc.height, 1, false);
+}
+
+void boxFilterResize(const float* src, int srcWidth, int srcHeight, int channelCount,
+                     float* dst, int dstWidth, int dstHeight)
+{
+    // Separable: filter every row into an intermediate image and then filter its columns.
+    const size_t channels = size_t(channelCount);
+    std::vector<float> horizontal(size_t(dstWidth) * size_t(srcHeight) * channels);
+    for (size_t y = 0; y < size_t(srcHeight); ++y) {
+        boxFilter1D(src + (y * size_t(srcWidth) * channels), size_t(srcWidth), channels,
+                    horizontal.data() + (y * size_t(dstWidth) * channels), size_t(dstWidth), channels, channelCount);
+    }
+
+    const size_t rowStride = size_t(dstWidth) * channels;
+    for (size_t x = 0; x < size_t(dstWidth); ++x) {
+        boxFilter1D(horizontal.data() + (x * channels), size_t(srcHeight), rowStride,
+                    dst + (x * channels), size_t(dstHeight), rowStride, channelCount);
+    }
+}
+
+void convertSRGBToLinear(uint8_t* pixels, size_t pixelCount, int channelCount, SRGBConversion method)
+{
+    // Alter the RGB components of each pixel but leave any alpha channel alone.
+    constexpr static int ALPHA_CHANNEL = 3;
+    const size_t colorChannelCount = size_t(std::min(channelCount, ALPHA_CHANNEL));
+    const size_t stride = size_t(channelCount);
+
+    if (method == SRGBConversion::kExact) {
+        for (size_t i = 0; i < pixelCount; ++i) {
+            uint8_t* pixel = pixels + (i * stride);
+            for (size_t channel = 0; channel < colorChannelCount; ++channel) {
+                pixel[channel] = srgbToLinear(pixel[channel]);
+            }
+        }
+        return;
+    }
+
+    const uint8_t* table = srgbToLinearTable().data();
+    if (colorChannelCount == stride) {
+        // No alpha, every byte is a color channel.
+        const size_t byteCount = pixelCount * stride;
+        for (size_t i = 0; i < byteCount; ++i) {
+            pixels[i] = table[pixels[i]];
+        }
+    } else {
+        for (size_t i = 0; i < pixelCount; ++i) {
+            uint8_t* pixel = pixels + (i * stride);
+            for (size_t channel = 0; channel < colorChannelCount; ++channel) {
+                pixel[channel] = table[pixel[channel]];
+            }
+        }
+    }
+}
+
+void loadTextureInternal(LoadedTexture& loadedTexture, const std::string_view path, bool generateMips, bool convertToLinear,
+                         const TextureLoadOptions& options)
 {
     // Make sure the file exists. It may be one directory back as well.
     std::string finalPath = std::string(path);
@@ -27,7 +249,7 @@ void loadTextureInternal(LoadedTexture& loadedTexture, const std::string_view pa
             finalPath = "../" + finalPath;
             fin.open(finalPath);
             if (!fin) {
-                LOG_ERROR("Unable to find texture %s", path);
+                LOG_ERROR("Unable to find texture %s", std::string(path).c_str());
                 return;
             }
         }
@@ -49,7 +271,7 @@ void loadTextureInternal(LoadedTexture& loadedTexture, const std::string_view pa
         // Get the raw image data from FreeImage.
         FIBITMAP* imageData = FreeImage_Load(format, finalPath.c_str());
         if (!imageData) {
-            LOG_ERROR("Unable to load image %s", path);
+            LOG_ERROR("Unable to load image %s", finalPath.c_str());
             return;
         }
 
@@ -88,49 +310,33 @@ void loadTextureInternal(LoadedTexture& loadedTexture, const std::string_view pa
         int width, height, channelCount;
         stbi_set_flip_vertically_on_load(true);
 
+        // OpenRL has no two channel format, gray + alpha images are expanded to RGBA.
+        int requiredChannelCount = 0;
+        if (stbi_info(finalPath.c_str(), &width, &height, &channelCount) && (channelCount == 2)) {
+            requiredChannelCount = 4;
+        }
+
         unsigned char* pixels;
         bool isHDR = stbi_is_hdr(finalPath.c_str());
         if (isHDR) {
-            pixels = (unsigned char*)stbi_loadf(finalPath.c_str(), &width, &height, &channelCount, 0);
-            if (!pixels) {
-                LOG_ERROR("Unable to load texture %s", path);
-                return;
-            }
+            pixels = (unsigned char*)stbi_loadf(finalPath.c_str(), &width, &height, &channelCount, requiredChannelCount);
         } else {
-            pixels = stbi_load(finalPath.c_str(), &width, &height, &channelCount, 0);
-            if (!pixels) {
-                LOG_ERROR("Unable to load texture %s", path);
-                return;
-            }
+            pixels = stbi_load(finalPath.c_str(), &width, &height, &channelCount, requiredChannelCount);
+        }
+        if (!pixels) {
+            LOG_ERROR("Unable to load texture %s", finalPath.c_str());
+            return;
+        }
+        if (requiredChannelCount != 0) {
+            channelCount = requiredChannelCount;
+        }
 
-            if (convertToLinear) {
-                LOG_INFO("Converting from sRGB to Linear");
-                // Convert from sRGB to linear. Note: it's assumed that any non-HDR immage is sRGB encoded however
-                // we want linear colors for rendering.
-                constexpr static size_t ALPHA_CHANNEL = 3;
-                constexpr static float MAX_BYTE_VALUE = 255.0f;
-                constexpr static float SRGB_ALPHA = 0.055f;
-                for (size_t i = 0; i < width * height; ++i) {
-                    // For each pixel, we alter the RGB components but leave any alpha channel alone.
-                    for (size_t channel = 0; channel < channelCount; ++channel) {
-                        if (channel != ALPHA_CHANNEL) {
-                            size_t pixelIndex = (i * channelCount) + channel;
-                            float channelData = float(pixels[pixelIndex]) / MAX_BYTE_VALUE;
-
-                            // Actual sRGB->linear convertion.
-                            if (channelData <= 0.04045f) {
-                                channelData /= 12.92f;
-                            } else {
-                                channelData = std::powf((channelData + SRGB_ALPHA) / (1.0f + SRGB_ALPHA), 2.4f);
-                            }
-
-                            // Conversion back to an 8bit byte.
-                            pixels[pixelIndex] = uint8_t(channelData * MAX_BYTE_VALUE);
-                        }
-                    }
-                }
-                LOG_INFO("\tDONE");
-            }
+        if (!isHDR && convertToLinear) {
+            LOG_INFO("Converting from sRGB to Linear");
+            // Convert from sRGB to linear. Note: it's assumed that any non-HDR immage is sRGB encoded however
+            // we want linear colors for rendering.
+            convertSRGBToLinear(pixels, size_t(width) * size_t(height), channelCount);
+            LOG_INFO("\tDONE");
         }
 
         loadedTexture.desc.width = width;
@@ -156,33 +362,135 @@ void loadTextureInternal(LoadedTexture& loadedTexture, const std::string_view pa
             free(address);
         });
     }
+
+    applyLoadOptions(loadedTexture, path, options);
 }
 
-std::future<LoadedTexture> loadTextureAsync(const std::string_view path, bool generateMips, bool convertToLinear)
+std::future<LoadedTexture> loadTextureAsync(const std::string_view path, bool generateMips, bool convertToLinear, const TextureLoadOptions& options)
 {
     std::shared_ptr<uint8_t> pixels = nullptr;
     std::string filepath = std::string(path);
-    return std::async([pixels, filepath, generateMips, convertToLinear]() {
+    return std::async([pixels, filepath, generateMips, convertToLinear, options]() {
         LoadedTexture loadedTexture;
-        loadTextureInternal(loadedTexture, filepath.c_str(), generateMips, convertToLinear);
+        loadTextureInternal(loadedTexture, filepath.c_str(), generateMips, convertToLinear, options);
         return loadedTexture;
     });
 }
 
-std::shared_ptr<openrl::Texture> loadTexture(const std::string_view path, bool generateMips, bool convertToLinear)
+std::shared_ptr<openrl::Texture> loadTexture(const std::string_view path, bool generateMips, bool convertToLinear, const TextureLoadOptions& options)
 {
     LoadedTexture loadedTexture;
-    loadTextureInternal(loadedTexture, path, generateMips, convertToLinear);
+    loadTextureInternal(loadedTexture, path, generateMips, convertToLinear, options);
     std::shared_ptr<openrl::Texture> texture = nullptr;
 
     if (loadedTexture.pixels) {
-        texture = openrl::Texture::create(loadedTexture.pixels.get(), loadedTexture.desc, loadedTexture.sampler, generateMips);
+        texture = openrl::Texture::create(loadedTexture.pixels.get(), loadedTexture.desc, loadedTexture.sampler, generateMips, path);
         assert(texture->valid());
     }
 
     return texture;
 }
 
+void loadTexturesPipelined(const std::vector<TextureLoadRequest>& requests, size_t queueDepth,
+                           const std::function<void(size_t index, LoadedTexture& loadedTexture)>& upload)
+{
+    const size_t count = requests.size();
+    if (count == 0) {
+        return;
+    }
+
+    queueDepth = std::max<size_t>(1, queueDepth);
+
+    // Workers only decode textures within 'queueDepth' of the texture currently being uploaded,
+    // so more workers than that would just sit idle.
+    const size_t workerCount = std::min(parallelWorkerCount(count), queueDepth);
+
+    std::mutex mutex; // Guards everything below.
+    std::condition_variable decodedCondition; // Signalled when a worker finishes decoding a texture.
+    std::condition_variable uploadedCondition; // Signalled when the consumer frees up a queue slot.
+    std::vector<LoadedTexture> decodedTextures(count);
+    std::vector<bool> decoded(count, false);
+    size_t nextDecode = 0;
+    size_t nextUpload = 0;
+
+    auto worker = [&]() {
+        while (true) {
+            size_t index = 0;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                uploadedCondition.wait(lock, [&]() {
+                    return (nextDecode >= count) || (nextDecode < nextUpload + queueDepth);
+                });
+                if (nextDecode >= count) {
+                    return;
+                }
+                index = nextDecode++;
+            }
+
+            LoadedTexture loadedTexture;
+            loadTextureInternal(loadedTexture, requests[index].path, requests[index].generateMips, requests[index].convertToLinear,
+                                requests[index].options);
+
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                decodedTextures[index] = std::move(loadedTexture);
+                decoded[index] = true;
+            }
+            decodedCondition.notify_one();
+        }
+    };
+
+    std::vector<std::thread> workers;
+    workers.reserve(workerCount);
+    for (size_t ii = 0; ii < workerCount; ++ii) {
+        workers.emplace_back(worker);
+    }
+
+    // The calling thread is the only consumer, which keeps the uploads in submission order.
+    for (size_t index = 0; index < count; ++index) {
+        LoadedTexture loadedTexture;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            decodedCondition.wait(lock, [&]() { return decoded[index]; });
+            loadedTexture = std::move(decodedTextures[index]);
+        }
+
+        upload(index, loadedTexture);
+        loadedTexture.pixels = nullptr;
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            nextUpload = index + 1;
+        }
+        uploadedCondition.notify_all();
+    }
+
+    for (std::thread& thread : workers) {
+        thread.join();
+    }
+}
+
+std::vector<std::shared_ptr<openrl::Texture>> loadTextures(const std::vector<TextureLoadRequest>& requests, size_t queueDepth)
+{
+    util::Timer timer(true);
+
+    std::vector<std::shared_ptr<openrl::Texture>> textures(requests.size(), nullptr);
+    loadTexturesPipelined(requests, queueDepth, [&requests, &textures](size_t index, LoadedTexture& loadedTexture) {
+        if (loadedTexture.pixels) {
+            textures[index] = openrl::Texture::create(loadedTexture.pixels.get(), loadedTexture.desc, loadedTexture.sampler, requests[index].generateMips,
+                                                      requests[index].path);
+            assert(textures[index]->valid());
+        }
+    });
+
+    if (!requests.empty()) {
+        LOG_INFO("Loaded %zu textures on %zu decode threads (queue depth %zu) in %f seconds", requests.size(),
+                 std::min(parallelWorkerCount(requests.size()), std::max<size_t>(1, queueDepth)), queueDepth, timer.stop());
+    }
+
+    return textures;
+}
+
 uint8_t* loadLDRTexturePixels(const std::string_view path, int& width, int& height, int& channelCount)
 {
     stbi_uc* pixels = stbi_load(path.data(), &width, &height, &channelCount, 0);
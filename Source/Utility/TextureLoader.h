@@ -10,8 +10,12 @@
 
 #include <RLWrapper/Texture.h>
 
+#include <functional>
 #include <future>
+#include <stdint.h>
+#include <string>
 #include <string_view>
+#include <vector>
 
 namespace util {
 
@@ -21,14 +25,84 @@ struct LoadedTexture {
 	openrl::Texture::Descriptor desc;
 };
 
+// Data type that loaded textures are stored as in OpenRL.
+enum class TextureStorage : uint32_t {
+    kSource,       // Whatever the file contains (8bit for LDR images, float for HDR images).
+    kUnsignedByte, // 8bits per channel. Float data is clamped to [0, 1].
+    kFloat         // 32bit float per channel.
+};
+
+struct TextureLoadOptions {
+    uint32_t maxDimension = 0; // Textures larger than this in either dimension are downsampled to fit. 0 means no limit.
+    TextureStorage storage = TextureStorage::kSource;
+
+    bool operator==(const TextureLoadOptions& other) const = default;
+};
+
 //-------------------------------------------------------------------------
 // Load a texture off disk. Can specify both relative and absolute paths.
-std::shared_ptr<openrl::Texture> loadTexture(const std::string_view path, bool generateMips = true, bool convertToLinear = true);
+std::shared_ptr<openrl::Texture> loadTexture(const std::string_view path, bool generateMips = true, bool convertToLinear = true,
+                                             const TextureLoadOptions& options = TextureLoadOptions());
 
 //-------------------------------------------------------------------------
 // Use async tasks to load the texture. The resulting future can be used
 // to query when the texture has finished loading.
-std::future<LoadedTexture> loadTextureAsync(const std::string_view path, bool generateMips, bool convertToLinear);
+std::future<LoadedTexture> loadTextureAsync(const std::string_view path, bool generateMips, bool convertToLinear,
+                                            const TextureLoadOptions& options = TextureLoadOptions());
+
+//-------------------------------------------------------------------------
+// Size in bytes of the pixel data described by 'desc'.
+size_t textureByteCount(const openrl::Texture::Descriptor& desc);
+
+//-------------------------------------------------------------------------
+// Resize 'channelCount' interleaved float channels from 'srcWidth' x
+// 'srcHeight' to 'dstWidth' x 'dstHeight' with a box filter. Each output
+// texel is the average of the source area it covers, with partially covered
+// source texels weighted by their coverage, so arbitrary (non power of two)
+// reduction ratios are handled without aliasing. Intended for downsampling.
+void boxFilterResize(const float* src, int srcWidth, int srcHeight, int channelCount,
+                     float* dst, int dstWidth, int dstHeight);
+
+struct TextureLoadRequest {
+    std::string path;
+    bool generateMips = true;
+    bool convertToLinear = true;
+    TextureLoadOptions options;
+};
+
+//-------------------------------------------------------------------------
+// Default number of decoded textures that loadTexturesPipelined() keeps in
+// memory while waiting for them to be uploaded.
+constexpr size_t kDefaultTextureQueueDepth = 8;
+
+//-------------------------------------------------------------------------
+// Decode all 'requests' on a pool of worker threads while the calling thread
+// consumes them. 'upload(index, loadedTexture)' is invoked on the calling
+// thread in the same order as 'requests', so it is safe to create OpenRL
+// objects from it when called on the OpenRL thread. At most 'queueDepth'
+// textures are decoded ahead of the one being uploaded, which caps the
+// amount of pixel data held in memory. Blocks until every texture has been
+// passed to 'upload'. Textures that fail to load have no pixels.
+void loadTexturesPipelined(const std::vector<TextureLoadRequest>& requests, size_t queueDepth,
+                           const std::function<void(size_t index, LoadedTexture& loadedTexture)>& upload);
+
+//-------------------------------------------------------------------------
+// Load all 'requests' with loadTexturesPipelined() and create an OpenRL
+// texture for each. Must be called on the OpenRL thread. The result is in
+// the same order as 'requests' and holds nullptr for textures that failed
+// to load.
+std::vector<std::shared_ptr<openrl::Texture>> loadTextures(const std::vector<TextureLoadRequest>& requests,
+                                                           size_t queueDepth = kDefaultTextureQueueDepth);
+
+enum class SRGBConversion {
+    kLookupTable, // 256 entry table, identical results to kExact.
+    kExact        // Evaluates the sRGB curve with powf for every channel.
+};
+
+//-------------------------------------------------------------------------
+// Convert 8bit sRGB encoded pixels to linear in place. The first three
+// channels of each pixel are converted and any alpha channel is left alone.
+void convertSRGBToLinear(uint8_t* pixels, size_t pixelCount, int channelCount, SRGBConversion method = SRGBConversion::kLookupTable);
 
 //-------------------------------------------------------------------------
 // Load LDR pixel data on the CPU. Data must be manually deallocated!
@@ -0,0 +1,109 @@
+//
+//  VertexQuantization.h
+//  Heatray
+//
+//  Encoding helpers for compact vertex attributes: octahedral unit vectors
+//  and 16bit normalized integers. The decode functions mirror what the
+//  shaders do with the encoded data.
+//
+//
+
+#pragma once
+
+#include <glm/glm/glm.hpp>
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <limits>
+#include <stdint.h>
+
+namespace util {
+
+//-------------------------------------------------------------------------
+// Convert a float in [-1, 1] to a signed normalized 16bit integer and back.
+inline int16_t quantizeSnorm16(float value)
+{
+    return int16_t(std::lround(std::clamp(value, -1.0f, 1.0f) * 32767.0f));
+}
+
+inline float dequantizeSnorm16(int16_t value)
+{
+    return std::max(float(value) / 32767.0f, -1.0f);
+}
+
+//-------------------------------------------------------------------------
+// Convert a float in [0, 1] to an unsigned normalized 16bit integer and back.
+inline uint16_t quantizeUnorm16(float value)
+{
+    return uint16_t(std::lround(std::clamp(value, 0.0f, 1.0f) * 65535.0f));
+}
+
+inline float dequantizeUnorm16(uint16_t value)
+{
+    return float(value) / 65535.0f;
+}
+
+//-------------------------------------------------------------------------
+// Map a unit vector onto the octahedron and unfold it into [-1, 1]^2.
+inline glm::vec2 octahedralEncode(glm::vec3 v)
+{
+    v /= (std::abs(v.x) + std::abs(v.y) + std::abs(v.z));
+    glm::vec2 encoded(v.x, v.y);
+    if (v.z < 0.0f) {
+        // Fold the lower hemisphere over the diagonals.
+        encoded = glm::vec2((1.0f - std::abs(v.y)) * (v.x >= 0.0f ? 1.0f : -1.0f),
+                            (1.0f - std::abs(v.x)) * (v.y >= 0.0f ? 1.0f : -1.0f));
+    }
+    return encoded;
+}
+
+//-------------------------------------------------------------------------
+// Inverse of octahedralEncode(). Matches decodeOctahedral() in vertex.rlsl.
+inline glm::vec3 octahedralDecode(glm::vec2 encoded)
+{
+    glm::vec3 v(encoded.x, encoded.y, 1.0f - std::abs(encoded.x) - std::abs(encoded.y));
+    float t = std::max(-v.z, 0.0f);
+    v.x += (v.x >= 0.0f) ? -t : t;
+    v.y += (v.y >= 0.0f) ? -t : t;
+    return glm::normalize(v);
+}
+
+//-------------------------------------------------------------------------
+// Unit vector stored as two octahedral snorm16 components, which is how
+// VertexFormat::kCompact stores normals and tangents.
+inline std::array<int16_t, 2> encodeOctahedralSnorm16(const glm::vec3& v)
+{
+    const glm::vec2 encoded = octahedralEncode(v);
+    return { quantizeSnorm16(encoded.x), quantizeSnorm16(encoded.y) };
+}
+
+inline glm::vec3 decodeOctahedralSnorm16(const std::array<int16_t, 2>& encoded)
+{
+    return octahedralDecode(glm::vec2(dequantizeSnorm16(encoded[0]), dequantizeSnorm16(encoded[1])));
+}
+
+//-------------------------------------------------------------------------
+// Texture coordinates are stored as unorm16 relative to the bounds of the
+// coordinates of their mesh, so that tiling coordinates outside of [0, 1]
+// keep their precision. texCoordTransform() returns the scale (xy) and
+// offset (zw) that vertex.rlsl applies to undo the mapping.
+inline glm::vec4 texCoordTransform(const glm::vec2& uvMin, const glm::vec2& uvMax)
+{
+    const glm::vec2 scale = glm::max(uvMax - uvMin, glm::vec2(std::numeric_limits<float>::min()));
+    return glm::vec4(scale, uvMin);
+}
+
+inline std::array<uint16_t, 2> quantizeTexCoord(const glm::vec2& uv, const glm::vec4& transform)
+{
+    const glm::vec2 normalized = (uv - glm::vec2(transform.z, transform.w)) / glm::vec2(transform.x, transform.y);
+    return { quantizeUnorm16(normalized.x), quantizeUnorm16(normalized.y) };
+}
+
+inline glm::vec2 dequantizeTexCoord(const std::array<uint16_t, 2>& quantized, const glm::vec4& transform)
+{
+    return glm::vec2(dequantizeUnorm16(quantized[0]), dequantizeUnorm16(quantized[1])) * glm::vec2(transform.x, transform.y) +
+           glm::vec2(transform.z, transform.w);
+}
+
+} // namespace util.
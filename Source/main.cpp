@@ -19,6 +19,10 @@
 #include "../3rdParty/glm/glm/glm.hpp"
 
 #include <assert.h>
+#include <cctype>
+#include <cstdlib>
+#include <string>
+#include <string_view>
 
 #if defined(_DEBUG)
     #define HEATRAY_DEBUG 1
@@ -126,6 +130,27 @@ int main(int argc, char **argv)
     heatray.init(kDefaultWindowWidth, kDefaultWindowHeight);
     heatray.resize(kDefaultWindowWidth, kDefaultWindowHeight);
 
+    // "--service [port]" accepts render jobs from local clients, which write their images into the
+    // "--service-output <directory>" (or "renders" in the working directory).
+    {
+        bool startService = false;
+        uint16_t port = RenderService::kDefaultPort;
+        std::string outputDirectory = "renders";
+        for (int iArg = 1; iArg < argc; ++iArg) {
+            if (std::string_view(argv[iArg]) == "--service") {
+                startService = true;
+                if ((iArg + 1 < argc) && std::isdigit(static_cast<unsigned char>(argv[iArg + 1][0]))) {
+                    port = static_cast<uint16_t>(std::atoi(argv[++iArg]));
+                }
+            } else if ((std::string_view(argv[iArg]) == "--service-output") && (iArg + 1 < argc)) {
+                outputDirectory = argv[++iArg];
+            }
+        }
+        if (startService) {
+            heatray.startRenderService(port, outputDirectory);
+        }
+    }
+
     // ImGui setup code.
     {
         IMGUI_CHECKVERSION();
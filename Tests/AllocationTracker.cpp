@@ -0,0 +1,128 @@
+#include "AllocationTracker.h"
+
+#include <atomic>
+#include <new>
+#include <stdlib.h>
+
+namespace {
+
+std::atomic<size_t> g_allocationCount = 0;
+std::atomic<size_t> g_currentBytes = 0;
+std::atomic<size_t> g_peakBytes = 0;
+
+// Every allocation is prefixed with its size so that unsized deletes can be accounted for.
+constexpr size_t kHeaderSize = alignof(max_align_t);
+
+// Over-aligned allocations use a header of 'alignment' bytes to keep the returned pointer aligned.
+size_t headerSize(size_t alignment)
+{
+    return (alignment > kHeaderSize) ? alignment : kHeaderSize;
+}
+
+void* allocate(size_t size, size_t alignment = kHeaderSize)
+{
+    const size_t header = headerSize(alignment);
+    void* block = nullptr;
+    if (alignment > kHeaderSize) {
+        // aligned_alloc() needs the size to be a multiple of the alignment.
+        block = aligned_alloc(alignment, (size + header + alignment - 1) / alignment * alignment);
+    } else {
+        block = malloc(size + header);
+    }
+    if (!block) {
+        return nullptr;
+    }
+    *static_cast<size_t*>(block) = size;
+
+    g_allocationCount.fetch_add(1, std::memory_order_relaxed);
+    const size_t current = g_currentBytes.fetch_add(size, std::memory_order_relaxed) + size;
+    size_t peak = g_peakBytes.load(std::memory_order_relaxed);
+    while ((current > peak) && !g_peakBytes.compare_exchange_weak(peak, current, std::memory_order_relaxed)) {
+    }
+    return static_cast<char*>(block) + header;
+}
+
+void release(void* pointer, size_t alignment = kHeaderSize)
+{
+    if (pointer) {
+        void* block = static_cast<char*>(pointer) - headerSize(alignment);
+        g_currentBytes.fetch_sub(*static_cast<size_t*>(block), std::memory_order_relaxed);
+        free(block);
+    }
+}
+
+} // namespace.
+
+namespace test {
+
+void resetAllocationStats()
+{
+    g_allocationCount = 0;
+    g_peakBytes = g_currentBytes.load();
+}
+
+AllocationStats allocationStats()
+{
+    return { g_allocationCount.load(), g_currentBytes.load(), g_peakBytes.load() };
+}
+
+} // namespace test.
+
+void* operator new(size_t size)
+{
+    if (void* pointer = allocate(size)) {
+        return pointer;
+    }
+    throw std::bad_alloc();
+}
+
+void* operator new[](size_t size)
+{
+    return operator new(size);
+}
+
+void* operator new(size_t size, const std::nothrow_t&) noexcept
+{
+    return allocate(size);
+}
+
+void* operator new[](size_t size, const std::nothrow_t&) noexcept
+{
+    return allocate(size);
+}
+
+void* operator new(size_t size, std::align_val_t alignment)
+{
+    if (void* pointer = allocate(size, size_t(alignment))) {
+        return pointer;
+    }
+    throw std::bad_alloc();
+}
+
+void* operator new[](size_t size, std::align_val_t alignment)
+{
+    return operator new(size, alignment);
+}
+
+void* operator new(size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept
+{
+    return allocate(size, size_t(alignment));
+}
+
+void* operator new[](size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept
+{
+    return allocate(size, size_t(alignment));
+}
+
+void operator delete(void* pointer) noexcept { release(pointer); }
+void operator delete[](void* pointer) noexcept { release(pointer); }
+void operator delete(void* pointer, size_t) noexcept { release(pointer); }
+void operator delete[](void* pointer, size_t) noexcept { release(pointer); }
+void operator delete(void* pointer, const std::nothrow_t&) noexcept { release(pointer); }
+void operator delete[](void* pointer, const std::nothrow_t&) noexcept { release(pointer); }
+void operator delete(void* pointer, std::align_val_t alignment) noexcept { release(pointer, size_t(alignment)); }
+void operator delete[](void* pointer, std::align_val_t alignment) noexcept { release(pointer, size_t(alignment)); }
+void operator delete(void* pointer, size_t, std::align_val_t alignment) noexcept { release(pointer, size_t(alignment)); }
+void operator delete[](void* pointer, size_t, std::align_val_t alignment) noexcept { release(pointer, size_t(alignment)); }
+void operator delete(void* pointer, std::align_val_t alignment, const std::nothrow_t&) noexcept { release(pointer, size_t(alignment)); }
+void operator delete[](void* pointer, std::align_val_t alignment, const std::nothrow_t&) noexcept { release(pointer, size_t(alignment)); }
@@ -0,0 +1,30 @@
+//
+//  AllocationTracker.h
+//  Heatray
+//
+//  Counts the heap allocations made through the global operator new so that
+//  benchmarks can report allocation counts and peak heap usage. Executables
+//  using it must add AllocationTracker.cpp to their sources, which replaces
+//  the global operator new and delete.
+//
+//
+
+#pragma once
+
+#include <stddef.h>
+
+namespace test {
+
+struct AllocationStats {
+    size_t allocationCount = 0; // Since the last resetAllocationStats().
+    size_t currentBytes = 0;    // Currently allocated.
+    size_t peakBytes = 0;       // Highest currentBytes since the last resetAllocationStats().
+};
+
+//-------------------------------------------------------------------------
+// Restart the allocation count and the peak at the current heap usage.
+void resetAllocationStats();
+
+AllocationStats allocationStats();
+
+} // namespace test.
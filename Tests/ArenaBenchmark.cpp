@@ -0,0 +1,112 @@
+#include "AllocationTracker.h"
+#include "TestHarness.h"
+
+#include <Utility/Arena.h>
+#include <Utility/Hash.h>
+#include <Utility/ParallelFor.h>
+#include <Utility/Timer.h>
+
+#include <algorithm>
+#include <limits>
+#include <memory_resource>
+#include <stdint.h>
+#include <vector>
+
+namespace {
+
+// Interleaved position, normal and texture coordinate of a vertex.
+constexpr size_t kFloatsPerVertex = 8;
+
+struct RunResult {
+    float seconds = std::numeric_limits<float>::max(); // Best of all runs.
+    size_t heapAllocations = 0;
+    size_t peakBytes = 0;
+    uint64_t hash = 0;
+};
+
+// Builds the vertex and index buffers of 'meshCount' grids of 'gridSize'^2 quads on every
+// worker, the way AssimpMeshProvider::ProcessMeshes() converts a synthetic scene, with every
+// buffer allocated from 'resource'. The buffers are released together at the end like the
+// provider releases them after the upload.
+RunResult run(size_t meshCount, size_t gridSize, bool useArena)
+{
+    constexpr int kRuns = 5;
+    const size_t verticesPerSide = gridSize + 1;
+    const size_t vertexCount = verticesPerSide * verticesPerSide;
+
+    RunResult result;
+    for (int runIndex = 0; runIndex < kRuns; ++runIndex) {
+        const size_t baseline = test::allocationStats().currentBytes;
+        test::resetAllocationStats();
+        util::Timer timer(true);
+        {
+            util::Arena arena;
+            std::pmr::memory_resource* resource = useArena ? static_cast<std::pmr::memory_resource*>(&arena) : std::pmr::new_delete_resource();
+            std::pmr::vector<std::pmr::vector<float>> vertexBuffers(meshCount, resource);
+            std::pmr::vector<std::pmr::vector<uint16_t>> indexBuffers(meshCount, resource);
+            util::parallelFor(meshCount, [&](size_t meshIndex, size_t /*workerIndex*/) {
+                std::pmr::vector<float>& vertices = vertexBuffers[meshIndex];
+                vertices.reserve(vertexCount * kFloatsPerVertex);
+                for (size_t vertex = 0; vertex < vertexCount; ++vertex) {
+                    const float u = float(vertex % verticesPerSide) / float(gridSize);
+                    const float v = float(vertex / verticesPerSide) / float(gridSize);
+                    const float values[kFloatsPerVertex] = { u, 0.01f * float(meshIndex), v, 0.0f, 1.0f, 0.0f, u, v };
+                    vertices.insert(vertices.end(), values, values + kFloatsPerVertex);
+                }
+
+                std::pmr::vector<uint16_t>& indices = indexBuffers[meshIndex];
+                indices.reserve(gridSize * gridSize * 6);
+                for (size_t y = 0; y < gridSize; ++y) {
+                    for (size_t x = 0; x < gridSize; ++x) {
+                        const uint16_t corner = uint16_t(y * verticesPerSide + x);
+                        const uint16_t quad[6] = { corner, uint16_t(corner + 1), uint16_t(corner + verticesPerSide),
+                                                   uint16_t(corner + 1), uint16_t(corner + verticesPerSide + 1), uint16_t(corner + verticesPerSide) };
+                        indices.insert(indices.end(), quad, quad + 6);
+                    }
+                }
+            });
+
+            uint64_t hash = 0;
+            for (size_t ii = 0; ii < meshCount; ++ii) {
+                hash = util::hashCombine(hash, util::FNV1a(reinterpret_cast<const char*>(vertexBuffers[ii].data()), vertexBuffers[ii].size() * sizeof(float)));
+                hash = util::hashCombine(hash, util::FNV1a(reinterpret_cast<const char*>(indexBuffers[ii].data()), indexBuffers[ii].size() * sizeof(uint16_t)));
+            }
+            result.hash = hash;
+        }
+        result.seconds = std::min(result.seconds, timer.stop());
+
+        const test::AllocationStats stats = test::allocationStats();
+        result.heapAllocations = stats.allocationCount;
+        result.peakBytes = stats.peakBytes - baseline;
+    }
+    return result;
+}
+
+} // namespace.
+
+// Heap allocations and time spent building the buffers of a synthetic scene
+// of many small meshes from the global heap and from a util::Arena, which
+// is what AssimpMeshProvider allocates its converted buffers from.
+int main(int argc, char** argv)
+{
+    test::init();
+
+    const size_t meshCount = std::max<size_t>(size_t(20000 * test::benchmarkScale(argc, argv)), 1);
+    constexpr size_t kGridSize = 8;
+    printf("%zu meshes of %zu triangles on %zu threads\n", meshCount, 2 * kGridSize * kGridSize, util::parallelWorkerCount(meshCount));
+
+    const RunResult heap = run(meshCount, kGridSize, false);
+    const RunResult arena = run(meshCount, kGridSize, true);
+    CHECK(heap.hash == arena.hash);
+
+    // Two buffers per mesh from the heap against a handful of arena blocks.
+    CHECK(heap.heapAllocations >= 2 * meshCount);
+    CHECK(arena.heapAllocations < heap.heapAllocations / 100);
+
+    for (const auto& [name, result] : { std::pair("Heap ", heap), std::pair("Arena", arena) }) {
+        printf("  %s: %.3f s, %8zu heap allocations, %.2f MB peak\n", name, result.seconds, result.heapAllocations,
+               double(result.peakBytes) / (1024.0 * 1024.0));
+    }
+
+    return test::finish();
+}
@@ -0,0 +1,78 @@
+#include "AllocationTracker.h"
+#include "SyntheticScene.h"
+#include "TestHarness.h"
+
+#include <HeatrayRenderer/Scene/AssimpMeshProvider.h>
+#include <Utility/Hash.h>
+#include <Utility/ParallelFor.h>
+#include <Utility/Timer.h>
+
+#include <algorithm>
+#include <filesystem>
+#include <limits>
+#include <vector>
+
+namespace {
+
+// Hash of everything the provider hands to Mesh, used to check that the parallel conversion is deterministic.
+uint64_t providerHash(MeshProvider& provider)
+{
+    uint64_t hash = util::FNV1a(provider.GetSubmeshCount());
+    std::vector<uint8_t> data;
+    for (size_t ii = 0; ii < provider.GetVertexBufferCount(); ++ii) {
+        data.resize(provider.GetVertexBufferSize(ii));
+        provider.FillVertexBuffer(ii, data.data());
+        hash = util::hashCombine(hash, util::FNV1a(reinterpret_cast<const char*>(data.data()), data.size()));
+    }
+    for (size_t ii = 0; ii < provider.GetIndexBufferCount(); ++ii) {
+        data.resize(provider.GetIndexBufferSize(ii));
+        provider.FillIndexBuffer(ii, data.data());
+        hash = util::hashCombine(hash, util::FNV1a(reinterpret_cast<const char*>(data.data()), data.size()));
+    }
+    return hash;
+}
+
+} // namespace.
+
+// Load time of a synthetic scene with many small meshes, which is dominated by the per-mesh conversion.
+int main(int argc, char** argv)
+{
+    test::init();
+
+    test::SyntheticSceneDesc desc;
+    desc.meshCount = std::max<size_t>(size_t(10000 * test::benchmarkScale(argc, argv)), 1);
+    const std::string path = "AssimpLoadBenchmark.gltf";
+    const test::SyntheticSceneStats stats = test::writeSyntheticScene(path, desc);
+
+    constexpr int kRuns = 3;
+    float bestTime = std::numeric_limits<float>::max();
+    uint64_t firstHash = 0;
+    test::AllocationStats loadAllocations;
+    for (int run = 0; run < kRuns; ++run) {
+        const size_t baseline = test::allocationStats().currentBytes;
+        test::resetAllocationStats();
+        util::Timer timer(true);
+        AssimpMeshProvider provider(path, false);
+        bestTime = std::min(bestTime, timer.stop());
+
+        // Includes the allocations made by Assimp itself while importing.
+        loadAllocations = test::allocationStats();
+        loadAllocations.peakBytes -= baseline;
+
+        CHECK(provider.GetSubmeshCount() == stats.meshCount);
+        const uint64_t hash = providerHash(provider);
+        if (run == 0) {
+            firstHash = hash;
+        }
+        CHECK(hash == firstHash);
+    }
+
+    printf("%zu meshes, %zu triangles on %zu threads\n", stats.meshCount, stats.triangleCount, util::parallelWorkerCount(stats.meshCount));
+    printf("  Best load time: %.3f s (%.0f meshes/s)\n", bestTime, double(stats.meshCount) / bestTime);
+    printf("  Heap allocations per load: %zu (%.1f per mesh), %.2f MB peak\n", loadAllocations.allocationCount,
+           double(loadAllocations.allocationCount) / double(stats.meshCount), double(loadAllocations.peakBytes) / (1024.0 * 1024.0));
+
+    std::filesystem::remove(path);
+    std::filesystem::remove("AssimpLoadBenchmark.bin");
+    return test::finish();
+}
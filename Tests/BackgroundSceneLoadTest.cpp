@@ -0,0 +1,377 @@
+#include "MockOpenRL.h"
+#include "SyntheticImage.h"
+#include "TestHarness.h"
+#include "TestMaterial.h"
+
+#include <HeatrayRenderer/Scene/Mesh.h>
+#include <Utility/AsyncTaskQueue.h>
+#include <Utility/TextureCache.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <filesystem>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string.h>
+#include <vector>
+
+// Drives the texture cache and meshes the way PassGenerator does when a scene
+// is loaded in the background: textures are decoded on an import thread while
+// the OpenRL thread keeps rendering, and only the add (or discard) of the
+// import runs on the OpenRL thread, a chunk of its geometry per task.
+
+namespace {
+
+constexpr int kSize = 128;
+constexpr size_t kTextureCount = 12;
+const std::string kDirectory = "BackgroundSceneLoadTestFiles";
+
+using Task = std::function<void()>;
+
+std::string texturePath(size_t index)
+{
+    return kDirectory + "/texture" + std::to_string(index) + ".png";
+}
+
+std::vector<util::TextureLoadRequest> textureRequests(size_t first, size_t count)
+{
+    std::vector<util::TextureLoadRequest> requests;
+    for (size_t ii = first; ii < first + count; ++ii) {
+        requests.push_back({ texturePath(ii), true, true });
+    }
+    return requests;
+}
+
+// Starts every test with an empty cache and cleared counters.
+util::TextureCache& resetCache()
+{
+    util::TextureCache& cache = util::TextureCache::instance();
+    cache.clear();
+    cache.logStatistics("Reset");
+    test::MockOpenRL::instance().reset();
+    return cache;
+}
+
+size_t liveTextures()
+{
+    return test::MockOpenRL::instance().liveTextures();
+}
+
+// Render jobs submitted to the OpenRL thread while an import is decoding.
+class RenderLoop
+{
+public:
+    explicit RenderLoop(util::AsyncTaskQueue<Task>& openRLQueue) : m_openRLQueue(openRLQueue) {}
+
+    // Renders one frame on the OpenRL thread and waits for it, like the main loop does.
+    void renderFrame()
+    {
+        m_openRLQueue.addTask([this]() {
+            rlRenderFrame();
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                ++m_frameCount;
+            }
+            m_frameRendered.notify_all();
+        });
+        m_openRLQueue.finish();
+    }
+
+    // Called by the import thread. Returns false if 'count' more frames were not
+    // rendered within a few seconds, i.e. the OpenRL thread was starved.
+    bool waitForFrames(size_t count)
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        const size_t target = m_frameCount + count;
+        return m_frameRendered.wait_for(lock, std::chrono::seconds(10), [this, target]() { return m_frameCount >= target; });
+    }
+
+private:
+    util::AsyncTaskQueue<Task>& m_openRLQueue;
+    std::mutex m_mutex;
+    std::condition_variable m_frameRendered;
+    size_t m_frameCount = 0;
+};
+
+void testRenderingContinuesDuringImport(util::AsyncTaskQueue<Task>& importQueue, util::AsyncTaskQueue<Task>& openRLQueue)
+{
+    util::TextureCache& cache = resetCache();
+    const size_t baselineTextures = liveTextures();
+
+    RenderLoop renderLoop(openRLQueue);
+    std::atomic<bool> importDone = false;
+    std::atomic<size_t> uploadsDuringImport = 0;
+    bool rendered = true;
+    const std::vector<util::TextureLoadRequest> requests = textureRequests(0, kTextureCount);
+
+    importQueue.addTask([&]() {
+        cache.prefetch(requests, 1, [&](size_t index, size_t) {
+            // Every few textures wait for frames to be rendered, which only happens if the
+            // OpenRL thread is not blocked by the import.
+            if ((index % 4) == 0) {
+                rendered = renderLoop.waitForFrames(2) && rendered;
+            }
+        });
+        uploadsDuringImport = test::MockOpenRL::instance().calls("rlTexImage2D");
+        importDone = true;
+    });
+    while (!importDone) {
+        renderLoop.renderFrame();
+    }
+    importQueue.finish();
+    CHECK(rendered);
+
+    // Decoding never touches OpenRL, the textures are uploaded when the import is added.
+    CHECK(uploadsDuringImport == 0);
+    std::vector<std::shared_ptr<openrl::Texture>> textures;
+    openRLQueue.addTask([&]() {
+        textures = cache.getAll(requests);
+        cache.releasePrefetched(1);
+    });
+    openRLQueue.finish();
+    CHECK(textures.size() == kTextureCount);
+    CHECK(cache.statistics().hitCount == kTextureCount);
+    CHECK(liveTextures() == baselineTextures + kTextureCount);
+
+    textures.clear();
+    cache.clear();
+    CHECK(liveTextures() == baselineTextures);
+}
+
+void testSupersededImport(util::AsyncTaskQueue<Task>& importQueue, util::AsyncTaskQueue<Task>& openRLQueue)
+{
+    util::TextureCache& cache = resetCache();
+    const size_t baselineTextures = liveTextures();
+
+    // The current scene uses the first two textures.
+    std::vector<std::shared_ptr<openrl::Texture>> sceneTextures;
+    openRLQueue.addTask([&]() { sceneTextures = cache.getAll(textureRequests(0, 2)); });
+    openRLQueue.finish();
+
+    // Load 3 is started before load 2 finished decoding, both share textures 4-7. Generations keep
+    // increasing for the lifetime of the cache, like the scene generation of PassGenerator.
+    const std::vector<util::TextureLoadRequest> abandoned = textureRequests(2, 6);
+    const std::vector<util::TextureLoadRequest> current = textureRequests(4, 8);
+    importQueue.addTask([&]() { cache.prefetch(abandoned, 2); });
+    importQueue.addTask([&]() { cache.prefetch(current, 3); });
+    importQueue.finish();
+
+    // Load 2 is discarded on the OpenRL thread and load 3 replaces the scene, which releases the
+    // textures of the old scene before load 3 is added.
+    openRLQueue.addTask([&]() { cache.releasePrefetched(2); });
+    openRLQueue.addTask([&]() {
+        sceneTextures.clear();
+        cache.releaseUnused();
+    });
+    openRLQueue.finish();
+    CHECK(liveTextures() == baselineTextures);
+
+    std::vector<std::shared_ptr<openrl::Texture>> textures;
+    openRLQueue.addTask([&]() {
+        textures = cache.getAll(current);
+        cache.releasePrefetched(3);
+    });
+    openRLQueue.finish();
+
+    // Everything load 3 asked for was still decoded, including the textures shared with load 2.
+    CHECK(cache.statistics().hitCount == current.size());
+    CHECK(test::MockOpenRL::instance().calls("rlTexImage2D") == 2 + current.size());
+
+    // The textures only load 2 used are decoded again when requested.
+    cache.logStatistics("Scene load");
+    std::shared_ptr<openrl::Texture> texture = cache.get(abandoned.front().path, true, true);
+    CHECK(texture && (cache.statistics().hitCount == 0));
+
+    texture = nullptr;
+    textures.clear();
+    cache.clear();
+    CHECK(liveTextures() == baselineTextures);
+}
+
+void testPrefetchIsBounded(util::AsyncTaskQueue<Task>& importQueue, util::AsyncTaskQueue<Task>& openRLQueue)
+{
+    util::TextureCache& cache = resetCache();
+    const size_t baselineTextures = liveTextures();
+
+    // Continues the generations of the loads above. Two textures per batch and a budget of three textures: the second batch goes over it and nothing after that is decoded.
+    constexpr size_t kTextureBytes = size_t(kSize) * kSize * 4;
+    const std::vector<util::TextureLoadRequest> requests = textureRequests(0, kTextureCount);
+    std::vector<size_t> prefetched;
+    size_t prefetchedBytes = 0;
+    importQueue.addTask([&]() {
+        cache.prefetch(requests, 4, [&](size_t index, size_t byteCount) {
+            prefetched.push_back(index);
+            prefetchedBytes += byteCount;
+        }, 2, 3 * kTextureBytes);
+    });
+    importQueue.finish();
+    CHECK((prefetched == std::vector<size_t>{ 0, 1, 2, 3 }));
+    CHECK(prefetchedBytes == 4 * kTextureBytes);
+
+    // Adding the import uploads the prefetched textures and decodes the remaining ones.
+    std::vector<std::shared_ptr<openrl::Texture>> textures;
+    openRLQueue.addTask([&]() {
+        textures = cache.getAll(requests, 2);
+        cache.releasePrefetched(4);
+    });
+    openRLQueue.finish();
+    CHECK(cache.statistics().hitCount == prefetched.size());
+    CHECK(std::all_of(textures.begin(), textures.end(), [](const std::shared_ptr<openrl::Texture>& texture) { return texture != nullptr; }));
+    CHECK(liveTextures() == baselineTextures + kTextureCount);
+
+    textures.clear();
+    cache.clear();
+    CHECK(liveTextures() == baselineTextures);
+}
+
+// A triangle per chunk. Releasing the first chunk calls 'firstChunkReleased', which the test uses to hold
+// the OpenRL thread while it submits a frame.
+class ChunkedProvider : public MeshProvider
+{
+public:
+    explicit ChunkedProvider(size_t chunkCount) : MeshProvider("Chunked"), m_chunkCount(chunkCount) { SplitIntoChunks(1); }
+
+    size_t GetVertexBufferCount() override { return m_chunkCount; }
+    size_t GetVertexBufferSize(size_t) override { return 9 * sizeof(float); }
+    void FillVertexBuffer(size_t, uint8_t *buffer) override { memset(buffer, 0, 9 * sizeof(float)); }
+    size_t GetIndexBufferCount() override { return m_chunkCount; }
+    size_t GetIndexBufferSize(size_t) override { return 3 * sizeof(uint16_t); }
+    void FillIndexBuffer(size_t, uint8_t *buffer) override
+    {
+        const uint16_t indices[3] = { 0, 1, 2 };
+        memcpy(buffer, indices, sizeof(indices));
+    }
+    size_t GetSubmeshCount() override { return m_chunkCount; }
+    Submesh GetSubmesh(size_t submeshIndex) override
+    {
+        Submesh submesh;
+        submesh.vertexAttributeCount = 1;
+        submesh.vertexAttributes[0].buffer = int(submeshIndex);
+        submesh.vertexAttributes[0].componentCount = 3;
+        submesh.vertexAttributes[0].size = sizeof(float);
+        submesh.vertexAttributes[0].stride = 3 * sizeof(float);
+        submesh.indexBuffer = submeshIndex;
+        submesh.elementCount = 3;
+        submesh.indexType = IndexType::kUInt16;
+        return submesh;
+    }
+    void ReleaseChunk(size_t chunkIndex) override
+    {
+        if ((chunkIndex == 0) && firstChunkReleased) {
+            firstChunkReleased();
+        }
+    }
+
+    std::function<void()> firstChunkReleased;
+
+private:
+    const size_t m_chunkCount;
+};
+
+void testRenderingContinuesDuringAdd(util::AsyncTaskQueue<Task>& openRLQueue)
+{
+    util::TextureCache& cache = resetCache();
+    const size_t baselineTextures = liveTextures();
+
+    // Like PassGenerator::runAddSceneImportTask() every task adds one chunk and queues the next one, so it
+    // ends up behind anything submitted while the chunk was added.
+    constexpr size_t kChunkCount = 8;
+    ChunkedProvider provider(kChunkCount);
+    CHECK(provider.GetChunkCount() == kChunkCount);
+    std::function<void(const std::shared_ptr<openrl::Program>)> programCallback = [](const std::shared_ptr<openrl::Program>) {};
+    std::unique_ptr<Mesh> mesh;
+    std::vector<std::shared_ptr<openrl::Texture>> textures;
+    size_t chunksAdded = 0;
+    std::function<void()> addChunk = [&]() {
+        mesh->uploadNextChunk(programCallback);
+        ++chunksAdded;
+        if (!mesh->complete()) {
+            openRLQueue.addTask(Task(addChunk));
+        }
+    };
+
+    // The main loop asks for a frame while the first chunk is being added.
+    std::mutex mutex;
+    std::condition_variable condition;
+    bool addingFirstChunk = false;
+    bool frameRequested = false;
+    provider.firstChunkReleased = [&]() {
+        std::unique_lock<std::mutex> lock(mutex);
+        addingFirstChunk = true;
+        condition.notify_all();
+        condition.wait(lock, [&]() { return frameRequested; });
+    };
+
+    // The first step also uploads the textures of the materials, see Scene::beginImport().
+    openRLQueue.addTask([&]() {
+        textures = cache.getAll(textureRequests(0, 2));
+        std::vector<std::shared_ptr<Material>> materials = { std::make_shared<test::TestMaterial>() };
+        mesh = std::make_unique<Mesh>(&provider, materials, programCallback, glm::mat4(1.0f), nullptr, Mesh::Upload::kChunked);
+        addChunk();
+    });
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        condition.wait(lock, [&]() { return addingFirstChunk; });
+    }
+    size_t chunksAtFrame = 0;
+    openRLQueue.addTask([&]() {
+        rlRenderFrame();
+        chunksAtFrame = chunksAdded;
+    });
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        frameRequested = true;
+    }
+    condition.notify_all();
+    openRLQueue.finish();
+
+    // The frame didn't wait for the rest of the scene.
+    CHECK(chunksAtFrame == 1);
+    CHECK(chunksAdded == kChunkCount);
+    CHECK(mesh->complete() && (mesh->submeshes().size() == kChunkCount));
+    CHECK(textures.size() == 2);
+
+    openRLQueue.addTask([&]() {
+        mesh->destroy();
+        mesh.reset();
+        textures.clear();
+        cache.clear();
+    });
+    openRLQueue.finish();
+    CHECK(liveTextures() == baselineTextures);
+}
+
+} // namespace.
+
+int main(int, char**)
+{
+    test::init();
+
+    std::filesystem::create_directories(kDirectory);
+    for (size_t ii = 0; ii < kTextureCount; ++ii) {
+        const std::vector<uint8_t> pixels = test::makePattern(kSize, kSize, 4, uint32_t(ii));
+        CHECK(test::writePng(texturePath(ii), kSize, kSize, 4, pixels.data()));
+    }
+
+    util::AsyncTaskQueue<Task> importQueue;
+    util::AsyncTaskQueue<Task> openRLQueue;
+    const auto runTask = [](Task& task) {
+        task();
+        return false;
+    };
+    importQueue.init(runTask);
+    openRLQueue.init(runTask);
+
+    testRenderingContinuesDuringImport(importQueue, openRLQueue);
+    testSupersededImport(importQueue, openRLQueue);
+    testPrefetchIsBounded(importQueue, openRLQueue);
+    testRenderingContinuesDuringAdd(openRLQueue);
+
+    importQueue.deinit();
+    openRLQueue.deinit();
+    std::filesystem::remove_all(kDirectory);
+    return test::finish();
+}
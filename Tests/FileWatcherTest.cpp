@@ -0,0 +1,128 @@
+#include "TestHarness.h"
+
+#include <Utility/FileWatcher.h>
+#include <Utility/Timer.h>
+
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+const std::string kDirectory = "FileWatcherTestFiles";
+constexpr float kDebounceTime = 0.1f; // In seconds.
+
+void writeFile(const std::string& name, const std::string& contents)
+{
+    std::ofstream(kDirectory + "/" + name, std::ios::trunc) << contents;
+}
+
+void sleep(float seconds)
+{
+    std::this_thread::sleep_for(std::chrono::duration<float>(seconds));
+}
+
+// Polls like the renderer does once per frame until something is reported or 'timeout' seconds have passed.
+std::vector<std::string> waitForChanges(util::FileWatcher& watcher, float timeout = 5.0f)
+{
+    util::Timer timer(true);
+    std::vector<std::string> changes;
+    while (changes.empty() && (timer.getElapsedTime() < timeout)) {
+        sleep(0.01f);
+        changes = watcher.poll();
+    }
+    return changes;
+}
+
+void testMissingDirectoryCantBeWatched()
+{
+    util::FileWatcher watcher;
+    CHECK(!watcher.start(kDirectory + "/missing", ".rlsl", kDebounceTime));
+    CHECK(!watcher.watching());
+    CHECK(watcher.poll().empty());
+}
+
+void testWrittenFilesAreReported()
+{
+    util::FileWatcher watcher;
+    CHECK(watcher.start(kDirectory, ".rlsl", kDebounceTime));
+    CHECK(watcher.watching());
+
+    // Files with other extensions are ignored.
+    writeFile("ray.rlsl", "void main() {}\n");
+    writeFile("notes.txt", "ignored\n");
+    const std::vector<std::string> expected = { "ray.rlsl" };
+    CHECK(waitForChanges(watcher) == expected);
+
+    // Each change is only reported once.
+    sleep(2.0f * kDebounceTime);
+    CHECK(watcher.poll().empty());
+}
+
+void testBurstIsReportedOnce()
+{
+    util::FileWatcher watcher;
+    CHECK(watcher.start(kDirectory, ".rlsl", kDebounceTime));
+
+    // Nothing is reported while the writes keep coming.
+    for (int ii = 0; ii < 5; ++ii) {
+        writeFile("common.rlsl", "float value() { return " + std::to_string(ii) + ".0; }\n");
+        writeFile("ray.rlsl", "void main() { value(); }\n");
+        sleep(kDebounceTime * 0.2f);
+        CHECK(watcher.poll().empty());
+    }
+
+    const std::vector<std::string> expected = { "common.rlsl", "ray.rlsl" };
+    CHECK(waitForChanges(watcher) == expected);
+}
+
+void testReplacedFileIsReported()
+{
+    util::FileWatcher watcher;
+    CHECK(watcher.start(kDirectory, ".rlsl", kDebounceTime));
+
+    // Editors that save by writing a temporary file and moving it over the original.
+    writeFile("vertex.rlsl.tmp", "void main() {}\n");
+    std::filesystem::rename(kDirectory + "/vertex.rlsl.tmp", kDirectory + "/vertex.rlsl");
+    const std::vector<std::string> expected = { "vertex.rlsl" };
+    CHECK(waitForChanges(watcher) == expected);
+}
+
+void testStopDropsPendingChanges()
+{
+    util::FileWatcher watcher;
+    CHECK(watcher.start(kDirectory, ".rlsl", kDebounceTime));
+    writeFile("ray.rlsl", "void main() { }\n");
+    watcher.poll();
+    watcher.stop();
+    CHECK(!watcher.watching());
+    sleep(2.0f * kDebounceTime);
+    CHECK(watcher.poll().empty());
+
+    // Changes made while not watching are not reported after starting again.
+    CHECK(watcher.start(kDirectory, ".rlsl", kDebounceTime));
+    CHECK(waitForChanges(watcher, 4.0f * util::FileWatcher::kPollInterval).empty());
+}
+
+} // namespace.
+
+int main(int, char**)
+{
+    test::init();
+
+    std::filesystem::remove_all(kDirectory);
+    std::filesystem::create_directories(kDirectory);
+
+    testMissingDirectoryCantBeWatched();
+    testWrittenFilesAreReported();
+    testBurstIsReportedOnce();
+    testReplacedFileIsReported();
+    testStopDropsPendingChanges();
+
+    std::filesystem::remove_all(kDirectory);
+
+    return test::finish();
+}
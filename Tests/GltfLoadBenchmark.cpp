@@ -0,0 +1,110 @@
+#include "AllocationTracker.h"
+#include "SyntheticScene.h"
+#include "TestHarness.h"
+
+#include <HeatrayRenderer/Scene/AssimpMeshProvider.h>
+#include <HeatrayRenderer/Scene/GltfMeshProvider.h>
+#include <Utility/Timer.h>
+
+#include <algorithm>
+#include <filesystem>
+#include <limits>
+#include <memory>
+#include <vector>
+
+namespace {
+
+struct LoadResult {
+    float seconds = std::numeric_limits<float>::max(); // Best of all runs.
+    size_t peakBytes = 0;     // Heap usage during the load and the fill of every buffer.
+    size_t heldBytes = 0;     // Heap still used by the provider once its buffers have been filled.
+    size_t submeshCount = 0;
+    size_t uploadedBytes = 0;
+};
+
+// Loads the asset with 'load' and fills every buffer like Mesh does, into 'staging' which stands in for
+// the mapped OpenRL buffers and is allocated up front so that it does not count towards the peak.
+template <typename Load>
+LoadResult measure(Load&& load, std::vector<uint8_t>& staging)
+{
+    constexpr int kRuns = 3;
+    LoadResult result;
+    for (int run = 0; run < kRuns; ++run) {
+        const size_t baseline = test::allocationStats().currentBytes;
+        test::resetAllocationStats();
+
+        util::Timer timer(true);
+        std::unique_ptr<MeshProvider> provider = load();
+        CHECK(provider != nullptr);
+        if (!provider) {
+            return result;
+        }
+        size_t uploadedBytes = 0;
+        for (size_t ii = 0; ii < provider->GetVertexBufferCount(); ++ii) {
+            CHECK(provider->GetVertexBufferSize(ii) <= staging.size());
+            provider->FillVertexBuffer(ii, staging.data());
+            uploadedBytes += provider->GetVertexBufferSize(ii);
+        }
+        for (size_t ii = 0; ii < provider->GetIndexBufferCount(); ++ii) {
+            CHECK(provider->GetIndexBufferSize(ii) <= staging.size());
+            provider->FillIndexBuffer(ii, staging.data());
+            uploadedBytes += provider->GetIndexBufferSize(ii);
+        }
+        result.seconds = std::min(result.seconds, timer.stop());
+
+        const test::AllocationStats stats = test::allocationStats();
+        result.peakBytes = stats.peakBytes - baseline;
+        result.heldBytes = stats.currentBytes - baseline;
+        result.submeshCount = provider->GetSubmeshCount();
+        result.uploadedBytes = uploadedBytes;
+    }
+    return result;
+}
+
+void print(const char* name, const LoadResult& result)
+{
+    constexpr double kMB = 1024.0 * 1024.0;
+    printf("  %-8s %8.3f s %10.2f MB %10.2f MB %10.2f MB\n", name, result.seconds, double(result.peakBytes) / kMB,
+           double(result.heldBytes) / kMB, double(result.uploadedBytes) / kMB);
+}
+
+} // namespace.
+
+// Load time and peak heap usage of the native glTF loader compared with
+// Assimp. The native loader maps the buffers instead of copying them, so
+// the mapped .bin is reported separately from the heap.
+int main(int argc, char** argv)
+{
+    test::init();
+
+    const std::string directory = "GltfLoadBenchmarkFiles";
+    const std::string path = directory + "/scene.gltf";
+    std::filesystem::create_directories(directory);
+
+    test::SyntheticSceneDesc desc;
+    desc.meshCount = std::max<size_t>(size_t(2000 * test::benchmarkScale(argc, argv)), 1);
+    desc.gridSize = 16;
+    const test::SyntheticSceneStats stats = test::writeSyntheticScene(path, desc);
+
+    // Large enough for any single buffer of either loader, Assimp adds tangents and bitangents.
+    std::vector<uint8_t> staging(std::filesystem::file_size(directory + "/scene.bin") * 2);
+
+    const LoadResult native = measure([&path]() -> std::unique_ptr<MeshProvider> {
+        std::unique_ptr<GltfMeshProvider> provider = std::make_unique<GltfMeshProvider>(path);
+        return provider->open(path, false) ? std::move(provider) : nullptr;
+    }, staging);
+    const LoadResult assimp = measure([&path]() -> std::unique_ptr<MeshProvider> {
+        return std::make_unique<AssimpMeshProvider>(path, false);
+    }, staging);
+    CHECK(native.submeshCount == stats.meshCount);
+    CHECK(assimp.submeshCount == stats.meshCount);
+
+    printf("%zu meshes, %zu triangles, %.2f MB mapped by the native loader\n", stats.meshCount, stats.triangleCount,
+           double(std::filesystem::file_size(directory + "/scene.bin")) / (1024.0 * 1024.0));
+    printf("  %-8s %10s %13s %13s %13s\n", "Loader", "Time", "Peak heap", "Held heap", "Uploaded");
+    print("Native", native);
+    print("Assimp", assimp);
+
+    std::filesystem::remove_all(directory);
+    return test::finish();
+}
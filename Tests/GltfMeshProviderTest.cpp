@@ -0,0 +1,77 @@
+#include "SyntheticScene.h"
+#include "TestHarness.h"
+
+#include <HeatrayRenderer/Scene/GltfMeshProvider.h>
+
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+
+namespace {
+
+const std::string kDirectory = "GltfMeshProviderTestFiles";
+const std::string kAssetPath = kDirectory + "/scene.gltf";
+
+// Adds 'members' (e.g. "\"extensionsUsed\":[...],") to the top level object of the asset.
+void addTopLevelMembers(const std::string& members)
+{
+    std::stringstream contents;
+    contents << std::ifstream(kAssetPath).rdbuf();
+    std::string json = contents.str();
+    json.insert(1, members);
+    std::ofstream(kAssetPath, std::ios::trunc) << json;
+}
+
+void testTexCoordsAreFlipped()
+{
+    test::SyntheticSceneDesc desc;
+    desc.meshCount = 2;
+    test::writeSyntheticScene(kAssetPath, desc);
+
+    GltfMeshProvider provider(kAssetPath);
+    CHECK(provider.open(kAssetPath, false));
+    CHECK(provider.GetSubmeshCount() == 2);
+
+    // The texture coordinates are flipped like Assimp does, to match the vertically flipped textures.
+    for (size_t ii = 0; ii < provider.GetSubmeshCount(); ++ii) {
+        const glm::vec4 transform = provider.GetSubmesh(ii).texCoordTransform;
+        CHECK(transform == glm::vec4(1.0f, -1.0f, 0.0f, 1.0f));
+        const glm::vec2 uv = glm::vec2(0.25f, 0.75f) * glm::vec2(transform.x, transform.y) + glm::vec2(transform.z, transform.w);
+        CHECK(uv == glm::vec2(0.25f, 0.25f));
+    }
+}
+
+void testTextureTransformNeedsAssimp()
+{
+    test::SyntheticSceneDesc desc;
+    test::writeSyntheticScene(kAssetPath, desc);
+    addTopLevelMembers("\"extensionsUsed\":[\"KHR_texture_transform\"],");
+    GltfMeshProvider used(kAssetPath);
+    CHECK(!used.open(kAssetPath, false));
+
+    test::writeSyntheticScene(kAssetPath, desc);
+    addTopLevelMembers("\"extensionsUsed\":[\"KHR_texture_transform\"],\"extensionsRequired\":[\"KHR_texture_transform\"],");
+    GltfMeshProvider required(kAssetPath);
+    CHECK(!required.open(kAssetPath, false));
+
+    // Extensions that only add data which can be ignored are still loaded natively.
+    test::writeSyntheticScene(kAssetPath, desc);
+    addTopLevelMembers("\"extensionsUsed\":[\"KHR_materials_emissive_strength\"],"
+                       "\"extensionsRequired\":[\"KHR_materials_emissive_strength\"],");
+    GltfMeshProvider ignorable(kAssetPath);
+    CHECK(ignorable.open(kAssetPath, false));
+}
+
+} // namespace.
+
+int main(int, char**)
+{
+    test::init();
+
+    std::filesystem::create_directories(kDirectory);
+    testTexCoordsAreFlipped();
+    testTextureTransformNeedsAssimp();
+    std::filesystem::remove_all(kDirectory);
+
+    return test::finish();
+}
@@ -0,0 +1,180 @@
+#include "MockOpenRL.h"
+#include "SyntheticImage.h"
+#include "TestHarness.h"
+
+#include <HeatrayRenderer/Materials/Material.h>
+#include <HeatrayRenderer/Scene/Mesh.h>
+#include <HeatrayRenderer/Scene/SphereMeshProvider.h>
+#include <RLWrapper/Buffer.h>
+#include <RLWrapper/MemoryTracker.h>
+#include <Utility/TextureCache.h>
+#include <Utility/TextureLoader.h>
+
+#include <filesystem>
+#include <type_traits>
+#include <vector>
+
+// Copying a Buffer would delete the RL buffer and remove its memory from the tracker twice.
+static_assert(!std::is_copy_constructible_v<openrl::Buffer> && !std::is_copy_assignable_v<openrl::Buffer>);
+
+namespace {
+
+const std::string kDirectory = "MemoryTrackerTestFiles";
+
+using Category = openrl::MemoryTracker::Category;
+
+// Material with an empty program and constant block, enough for Mesh to
+// create its primitives.
+class TestMaterial : public Material
+{
+public:
+    TestMaterial() : Material("Test material", Material::Type::Glass) {}
+
+    void build() override
+    {
+        m_program = openrl::Program::create();
+        m_program->link("Test program");
+        resolveUniforms();
+        const float constants[4] = {};
+        m_constants = openrl::Buffer::create(RL_UNIFORM_BLOCK_BUFFER, constants, sizeof(constants), "Test material uniform block");
+    }
+    bool rebuild() override { build(); return true; }
+    void modify() override {}
+    uint64_t parameterHash() const override { return 0; }
+
+protected:
+    const std::string_view rayShader() const override { return "test.rlsl"; }
+};
+
+// Bytes and allocations tracked for 'tag' in 'category', zero if there are none.
+openrl::MemoryTracker::Consumer findConsumer(Category category, const std::string& tag)
+{
+    for (const openrl::MemoryTracker::Consumer& consumer : openrl::MemoryTracker::instance().report(SIZE_MAX).topConsumers) {
+        if ((consumer.category == category) && (consumer.tag == tag)) {
+            return consumer;
+        }
+    }
+    return {};
+}
+
+void testTextureByteCounts()
+{
+    CHECK(openrl::MemoryTracker::channelCount(RL_LUMINANCE) == 1);
+    CHECK(openrl::MemoryTracker::channelCount(RL_RGB) == 3);
+    CHECK(openrl::MemoryTracker::channelCount(RL_RGBA) == 4);
+    CHECK(openrl::MemoryTracker::channelCount(0) == 0);
+
+    CHECK(openrl::MemoryTracker::textureByteCount(RL_LUMINANCE, RL_UNSIGNED_BYTE, 16, 8, 0, false) == 16 * 8);
+    CHECK(openrl::MemoryTracker::textureByteCount(RL_RGB, RL_FLOAT, 16, 8, 0, false) == 16 * 8 * 3 * sizeof(float));
+    CHECK(openrl::MemoryTracker::textureByteCount(RL_RGBA, RL_UNSIGNED_BYTE, 16, 8, 2, false) == 16 * 8 * 2 * 4);
+    CHECK(openrl::MemoryTracker::textureByteCount(RL_RGBA, RL_UNSIGNED_BYTE, 16, 8, 0, true) == 16 * 8 * 4 * 4 / 3);
+
+    // The loader reports decoded sizes with the same channel counts.
+    openrl::Texture::Descriptor desc;
+    desc.width = 16;
+    desc.height = 8;
+    desc.format = RL_RGB;
+    desc.dataType = RL_UNSIGNED_BYTE;
+    CHECK(util::textureByteCount(desc) == 16 * 8 * 3);
+}
+
+void testGrayAlphaTexture()
+{
+    // A gray + alpha image is uploaded as RGBA, which is what the tracker counts.
+    constexpr int kWidth = 16;
+    constexpr int kHeight = 8;
+    const std::string path = kDirectory + "/grayAlpha.png";
+    const std::vector<uint8_t> pixels = test::makePattern(kWidth, kHeight, 2);
+    CHECK(test::writePng(path, kWidth, kHeight, 2, pixels.data()));
+
+    util::LoadedTexture loadedTexture = util::loadTextureAsync(path, false, false).get();
+    CHECK(loadedTexture.pixels && (loadedTexture.desc.format == RL_RGBA));
+    if (loadedTexture.pixels) {
+        // The loader flips the image vertically, compare the first row of the file with the last decoded row.
+        const uint8_t* lastRow = loadedTexture.pixels.get() + size_t(kHeight - 1) * kWidth * 4;
+        bool expanded = true;
+        for (size_t x = 0; x < size_t(kWidth); ++x) {
+            const uint8_t gray = pixels[x * 2];
+            const uint8_t alpha = pixels[x * 2 + 1];
+            expanded = expanded && (lastRow[x * 4] == gray) && (lastRow[x * 4 + 1] == gray) && (lastRow[x * 4 + 2] == gray) && (lastRow[x * 4 + 3] == alpha);
+        }
+        CHECK(expanded);
+    }
+    CHECK(util::textureByteCount(loadedTexture.desc) == size_t(kWidth) * kHeight * 4);
+
+    std::shared_ptr<openrl::Texture> texture = util::loadTexture(path, false, false);
+    CHECK(texture);
+    openrl::MemoryTracker::Consumer consumer = findConsumer(Category::kTexture, path);
+    CHECK(consumer.sizeInBytes == size_t(kWidth) * kHeight * 4);
+    CHECK(consumer.allocationCount == 1);
+
+    texture = nullptr;
+    CHECK(findConsumer(Category::kTexture, path).allocationCount == 0);
+}
+
+void testTotalsReturnToZeroAfterUnload()
+{
+    test::MockOpenRL& mock = test::MockOpenRL::instance();
+    openrl::MemoryTracker& tracker = openrl::MemoryTracker::instance();
+    const openrl::MemoryTracker::Report baseline = tracker.report(SIZE_MAX);
+    const size_t liveBuffers = mock.liveBuffers();
+    const size_t liveTextures = mock.liveTextures();
+
+    const std::string texturePath = kDirectory + "/baseColor.png";
+    const std::vector<uint8_t> pixels = test::makePattern(32, 32, 3);
+    CHECK(test::writePng(texturePath, 32, 32, 3, pixels.data()));
+
+    {
+        // A scene made of one asset with a material and a texture.
+        SphereMeshProvider provider(16, 16, 1.0f, "Sphere asset");
+        std::vector<std::shared_ptr<Material>> materials = { std::make_shared<TestMaterial>() };
+        std::function<void(const std::shared_ptr<openrl::Program>)> callback = [](const std::shared_ptr<openrl::Program>) {};
+        Mesh mesh(&provider, materials, callback, glm::mat4(1.0f));
+        std::shared_ptr<openrl::Texture> texture = util::TextureCache::instance().get(texturePath, true, true);
+        CHECK(mesh.valid() && texture);
+
+        // Buffers are tagged with the asset they were loaded from.
+        const openrl::MemoryTracker::Consumer vertexBuffers = findConsumer(Category::kArrayBuffer, "Sphere asset vertex buffer");
+        CHECK(vertexBuffers.allocationCount == provider.GetVertexBufferCount());
+        CHECK(vertexBuffers.sizeInBytes == provider.GetVertexBufferSize(0) + provider.GetVertexBufferSize(1) + provider.GetVertexBufferSize(2));
+        CHECK(findConsumer(Category::kIndexBuffer, "Sphere asset index buffer").sizeInBytes == provider.GetIndexBufferSize(0));
+        CHECK(findConsumer(Category::kUniformBuffer, "Test material uniform block").sizeInBytes == 4 * sizeof(float));
+        // The texture cache tags textures with the resolved path.
+        const std::string resolvedPath = std::filesystem::absolute(texturePath).lexically_normal().string();
+        CHECK(findConsumer(Category::kTexture, resolvedPath).sizeInBytes == 32 * 32 * 3 * 4 / 3);
+
+        const openrl::MemoryTracker::Report loaded = tracker.report(0);
+        CHECK(loaded.totalBytes > baseline.totalBytes);
+        CHECK(loaded.categoryBytes[size_t(Category::kTexture)] > baseline.categoryBytes[size_t(Category::kTexture)]);
+
+        // Unloading the scene releases everything, the texture cache holds the last reference to the texture.
+        mesh.destroy();
+        materials.clear();
+        texture = nullptr;
+        util::TextureCache::instance().releaseUnused();
+    }
+
+    const openrl::MemoryTracker::Report unloaded = tracker.report(SIZE_MAX);
+    CHECK(unloaded.totalBytes == baseline.totalBytes);
+    CHECK(unloaded.totalAllocations == baseline.totalAllocations);
+    CHECK(unloaded.categoryBytes == baseline.categoryBytes);
+    CHECK(unloaded.categoryAllocations == baseline.categoryAllocations);
+    CHECK(unloaded.topConsumers.size() == baseline.topConsumers.size());
+    CHECK(mock.liveBuffers() == liveBuffers);
+    CHECK(mock.liveTextures() == liveTextures);
+}
+
+} // namespace.
+
+int main(int, char**)
+{
+    test::init();
+
+    std::filesystem::create_directories(kDirectory);
+    testTextureByteCounts();
+    testGrayAlphaTexture();
+    testTotalsReturnToZeroAfterUnload();
+    std::filesystem::remove_all(kDirectory);
+
+    return test::finish();
+}
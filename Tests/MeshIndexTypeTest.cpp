@@ -0,0 +1,147 @@
+#include "MockOpenRL.h"
+#include "TestHarness.h"
+
+#include <HeatrayRenderer/Materials/Material.h>
+#include <HeatrayRenderer/Scene/Mesh.h>
+#include <HeatrayRenderer/Scene/PlaneMeshProvider.h>
+#include <HeatrayRenderer/Scene/SphereMeshProvider.h>
+#include <RLWrapper/MemoryTracker.h>
+
+#include <vector>
+
+namespace {
+
+// Material with an empty program and constant block, enough for Mesh to
+// create its primitives.
+class TestMaterial : public Material
+{
+public:
+    TestMaterial() : Material("Test material", Material::Type::Glass) {}
+
+    void build() override
+    {
+        m_program = openrl::Program::create();
+        m_program->link("Test program");
+        resolveUniforms();
+        const float constants[4] = {};
+        m_constants = openrl::Buffer::create(RL_UNIFORM_BLOCK_BUFFER, constants, sizeof(constants), "Test material constants");
+    }
+    bool rebuild() override { build(); return true; }
+    void modify() override {}
+    uint64_t parameterHash() const override { return 0; }
+
+protected:
+    const std::string_view rayShader() const override { return "test.rlsl"; }
+};
+
+size_t trackedIndexBytes()
+{
+    return openrl::MemoryTracker::instance().report(0).categoryBytes[size_t(openrl::MemoryTracker::Category::kIndexBuffer)];
+}
+
+// Submits the single submesh of 'provider' and checks that it is drawn with
+// 'expectedType' indices that match what the provider generated.
+void checkMesh(MeshProvider& provider, size_t vertexCount, RLenum expectedMode, RLenum expectedType, const std::vector<uint32_t>& expectedIndices)
+{
+    test::MockOpenRL& mock = test::MockOpenRL::instance();
+    mock.reset();
+    const size_t liveBuffers = mock.liveBuffers();
+    const size_t indexBytes = trackedIndexBytes();
+
+    std::vector<std::shared_ptr<Material>> materials = { std::make_shared<TestMaterial>() };
+    std::function<void(const std::shared_ptr<openrl::Program>)> callback = [](const std::shared_ptr<openrl::Program>) {};
+    {
+        Mesh mesh(&provider, materials, callback, glm::mat4(1.0f));
+        CHECK(mesh.valid());
+        CHECK(mesh.submeshes().size() == 1);
+        CHECK(mesh.submeshes()[0].indexType == expectedType);
+
+        const std::vector<test::MockOpenRL::DrawCall> drawCalls = mock.drawCalls();
+        CHECK(drawCalls.size() == 1);
+        if (drawCalls.size() == 1) {
+            const test::MockOpenRL::DrawCall& drawCall = drawCalls[0];
+            CHECK(drawCall.mode == expectedMode);
+            CHECK(drawCall.type == expectedType);
+            CHECK(drawCall.count == expectedIndices.size());
+            CHECK(drawCall.indices == expectedIndices);
+
+            bool inRange = true;
+            for (uint32_t index : drawCall.indices) {
+                inRange = inRange && (index < vertexCount);
+            }
+            CHECK(inRange);
+        }
+
+        // Index memory is tracked at the submitted index size.
+        const size_t expectedSize = (expectedType == RL_UNSIGNED_SHORT) ? sizeof(uint16_t) : sizeof(uint32_t);
+        CHECK(trackedIndexBytes() - indexBytes == expectedIndices.size() * expectedSize);
+        mesh.destroy();
+    }
+    materials.clear();
+
+    CHECK(mock.liveBuffers() == liveBuffers);
+    CHECK(trackedIndexBytes() == indexBytes);
+}
+
+std::vector<uint32_t> sphereIndices(SphereMeshProvider& provider, size_t uSlices, size_t vSlices)
+{
+    std::vector<uint32_t> indices(6 * uSlices * vSlices);
+    provider.FillIndices(indices.data());
+    return indices;
+}
+
+void testSmallSphereUses16BitIndices()
+{
+    constexpr size_t kSlices = 32;
+    SphereMeshProvider provider(kSlices, kSlices, 1.0f, "Small sphere");
+    CHECK(provider.GetSubmesh(0).indexType == IndexType::kUInt16);
+    CHECK(provider.GetIndexBufferSize(0) == 6 * kSlices * kSlices * sizeof(uint16_t));
+    checkMesh(provider, (kSlices + 1) * (kSlices + 2), RL_TRIANGLES, RL_UNSIGNED_SHORT, sphereIndices(provider, kSlices, kSlices));
+}
+
+void testLargeSphereUses32BitIndices()
+{
+    // 301 * 302 vertices do not fit into 16 bits.
+    constexpr size_t kSlices = 300;
+    SphereMeshProvider provider(kSlices, kSlices, 1.0f, "Large sphere");
+    CHECK(provider.GetSubmesh(0).indexType == IndexType::kUInt32);
+    CHECK(provider.GetIndexBufferSize(0) == 6 * kSlices * kSlices * sizeof(uint32_t));
+    checkMesh(provider, (kSlices + 1) * (kSlices + 2), RL_TRIANGLES, RL_UNSIGNED_INT, sphereIndices(provider, kSlices, kSlices));
+}
+
+void testPlaneUses16BitIndices()
+{
+    PlaneMeshProvider provider(10, 10, "Plane");
+    const MeshProvider::Submesh submesh = provider.GetSubmesh(0);
+    CHECK(submesh.indexType == IndexType::kUInt16);
+
+    std::vector<uint8_t> bytes(provider.GetIndexBufferSize(0));
+    provider.FillIndexBuffer(0, bytes.data());
+    std::vector<uint32_t> indices(submesh.elementCount);
+    for (size_t ii = 0; ii < indices.size(); ++ii) {
+        indices[ii] = reinterpret_cast<const uint16_t*>(bytes.data())[ii];
+    }
+    checkMesh(provider, 4, RL_TRIANGLE_STRIP, RL_UNSIGNED_SHORT, indices);
+}
+
+void testBoundary()
+{
+    CHECK(indexTypeForVertexCount(size_t(UINT16_MAX) + 1) == IndexType::kUInt16);
+    CHECK(indexTypeForVertexCount(size_t(UINT16_MAX) + 2) == IndexType::kUInt32);
+    CHECK(indexSize(IndexType::kUInt16) == 2);
+    CHECK(indexSize(IndexType::kUInt32) == 4);
+}
+
+} // namespace.
+
+int main(int, char**)
+{
+    test::init();
+
+    testBoundary();
+    testSmallSphereUses16BitIndices();
+    testLargeSphereUses32BitIndices();
+    testPlaneUses16BitIndices();
+
+    return test::finish();
+}
@@ -0,0 +1,52 @@
+#include "SyntheticScene.h"
+#include "TestHarness.h"
+
+#include <HeatrayRenderer/Scene/AssimpMeshProvider.h>
+#include <Utility/Timer.h>
+
+#include <algorithm>
+#include <filesystem>
+
+// Memory report for forest and crowd like scenes: a few unique meshes, each
+// copied and referenced by many nodes. The uploaded vertex and index data is
+// compared with what it would be if every instance had its own geometry.
+int main(int argc, char** argv)
+{
+    test::init();
+
+    const std::string directory = "MeshInstancingBenchmarkFiles";
+    const std::string path = directory + "/scene.gltf";
+    std::filesystem::create_directories(directory);
+
+    test::SyntheticSceneDesc desc;
+    desc.meshCount = 8;
+    desc.gridSize = 32;
+    const size_t maxInstances = std::max<size_t>(size_t(256 * test::benchmarkScale(argc, argv)), 4);
+
+    printf("%zu unique meshes of %zu triangles\n", desc.meshCount, desc.gridSize * desc.gridSize * 2);
+    printf("  %10s %10s %10s %12s %12s %10s\n", "Duplicates", "Instances", "Submeshes", "Shared MB", "Unshared MB", "Load s");
+    for (size_t duplicates : { size_t(0), size_t(3) }) {
+        for (size_t instances = 1; instances <= maxInstances; instances *= 4) {
+            desc.duplicatesPerMesh = duplicates;
+            desc.instancesPerMesh = instances;
+            test::writeSyntheticScene(path, desc);
+
+            util::Timer timer(true);
+            AssimpMeshProvider provider(path, false);
+            const float seconds = timer.stop();
+
+            // All unique meshes have the same size, so every submesh would otherwise upload the same amount.
+            const size_t submeshCount = provider.GetSubmeshCount();
+            const size_t bytes = test::meshProviderBytes(provider);
+            const size_t unsharedBytes = bytes / desc.meshCount * submeshCount;
+            CHECK(submeshCount == desc.meshCount * (duplicates + 1) * instances);
+            CHECK(provider.GetIndexBufferCount() == desc.meshCount);
+
+            printf("  %10zu %10zu %10zu %12.2f %12.2f %10.3f\n", duplicates, instances, submeshCount, double(bytes) / (1024.0 * 1024.0),
+                   double(unsharedBytes) / (1024.0 * 1024.0), seconds);
+        }
+    }
+
+    std::filesystem::remove_all(directory);
+    return test::finish();
+}
@@ -0,0 +1,127 @@
+#include "SyntheticScene.h"
+#include "TestHarness.h"
+
+#include <HeatrayRenderer/Scene/AssimpMeshProvider.h>
+
+#include <filesystem>
+#include <map>
+#include <set>
+#include <vector>
+
+namespace {
+
+const std::string kPath = "MeshInstancingTestFiles/scene.gltf";
+
+struct LoadedScene {
+    size_t submeshCount = 0;
+    size_t vertexBufferCount = 0;
+    size_t indexBufferCount = 0;
+    size_t bytes = 0;
+    std::map<size_t, std::vector<glm::mat4>> transformsByIndexBuffer;
+    bool instancesShareVertexBuffers = true;
+};
+
+LoadedScene load(const test::SyntheticSceneDesc& desc)
+{
+    test::writeSyntheticScene(kPath, desc);
+    AssimpMeshProvider provider(kPath, false);
+
+    LoadedScene scene;
+    scene.submeshCount = provider.GetSubmeshCount();
+    scene.vertexBufferCount = provider.GetVertexBufferCount();
+    scene.indexBufferCount = provider.GetIndexBufferCount();
+    scene.bytes = test::meshProviderBytes(provider);
+
+    // Submeshes drawing the same indices must also read the same vertices.
+    std::map<size_t, int> vertexBufferByIndexBuffer;
+    for (size_t ii = 0; ii < scene.submeshCount; ++ii) {
+        const MeshProvider::Submesh submesh = provider.GetSubmesh(ii);
+        scene.transformsByIndexBuffer[submesh.indexBuffer].push_back(submesh.localTransform);
+        auto [iter, inserted] = vertexBufferByIndexBuffer.emplace(submesh.indexBuffer, submesh.vertexAttributes[0].buffer);
+        scene.instancesShareVertexBuffers = scene.instancesShareVertexBuffers && (inserted || (iter->second == submesh.vertexAttributes[0].buffer));
+    }
+    return scene;
+}
+
+bool distinctTransforms(const std::vector<glm::mat4>& transforms)
+{
+    std::set<std::vector<float>> unique;
+    for (const glm::mat4& transform : transforms) {
+        unique.insert(std::vector<float>(&transform[0][0], &transform[0][0] + 16));
+    }
+    return unique.size() == transforms.size();
+}
+
+void testRepeatedReferencesShareGeometry()
+{
+    test::SyntheticSceneDesc desc;
+    desc.meshCount = 3;
+    const LoadedScene single = load(desc);
+    CHECK(single.submeshCount == 3);
+
+    desc.instancesPerMesh = 5;
+    const LoadedScene instanced = load(desc);
+    CHECK(instanced.submeshCount == 15);
+    CHECK(instanced.vertexBufferCount == single.vertexBufferCount);
+    CHECK(instanced.indexBufferCount == single.indexBufferCount);
+    CHECK(instanced.bytes == single.bytes);
+    CHECK(instanced.instancesShareVertexBuffers);
+
+    // Every instance keeps the transform of its own node.
+    CHECK(instanced.transformsByIndexBuffer.size() == 3);
+    for (const auto& iter : instanced.transformsByIndexBuffer) {
+        CHECK(iter.second.size() == 5);
+        CHECK(distinctTransforms(iter.second));
+    }
+}
+
+void testIdenticalMeshesAreMerged()
+{
+    test::SyntheticSceneDesc desc;
+    desc.meshCount = 3;
+    const LoadedScene unique = load(desc);
+
+    desc.duplicatesPerMesh = 3;
+    const LoadedScene duplicated = load(desc);
+    CHECK(duplicated.submeshCount == 12);
+    CHECK(duplicated.vertexBufferCount == unique.vertexBufferCount);
+    CHECK(duplicated.indexBufferCount == unique.indexBufferCount);
+    CHECK(duplicated.bytes == unique.bytes);
+    CHECK(duplicated.instancesShareVertexBuffers);
+    for (const auto& iter : duplicated.transformsByIndexBuffer) {
+        CHECK(iter.second.size() == 4);
+        CHECK(distinctTransforms(iter.second));
+    }
+}
+
+void testMemoryIsIndependentOfInstanceCount()
+{
+    test::SyntheticSceneDesc desc;
+    desc.meshCount = 2;
+    desc.duplicatesPerMesh = 1;
+    size_t bytes = 0;
+    for (size_t instances : { 1, 2, 8, 32 }) {
+        desc.instancesPerMesh = instances;
+        const LoadedScene scene = load(desc);
+        CHECK(scene.submeshCount == desc.meshCount * (desc.duplicatesPerMesh + 1) * instances);
+        if (bytes == 0) {
+            bytes = scene.bytes;
+        }
+        CHECK(scene.bytes == bytes);
+    }
+}
+
+} // namespace.
+
+int main(int, char**)
+{
+    test::init();
+
+    std::filesystem::create_directories("MeshInstancingTestFiles");
+    testRepeatedReferencesShareGeometry();
+    testIdenticalMeshesAreMerged();
+    testMemoryIsIndependentOfInstanceCount();
+    std::filesystem::remove_all("MeshInstancingTestFiles");
+
+    return test::finish();
+}
@@ -0,0 +1,133 @@
+#include "TestHarness.h"
+
+#include <Utility/Arena.h>
+#include <Utility/MeshOptimizer.h>
+#include <Utility/Timer.h>
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <limits>
+#include <random>
+#include <vector>
+
+namespace {
+
+struct TestMesh {
+    const char* name = "";
+    std::vector<float> positions; // Three floats per vertex.
+    std::vector<uint32_t> indices;
+    size_t vertexCount = 0;
+};
+
+// Grid of 'size'^2 quads bent into a tube, with its triangles in a random order like the output
+// of a converter that does not care about locality.
+TestMesh shuffledTube(size_t size)
+{
+    TestMesh mesh;
+    mesh.name = "Shuffled tube";
+    const size_t verticesPerSide = size + 1;
+    mesh.vertexCount = verticesPerSide * verticesPerSide;
+    for (size_t vertex = 0; vertex < mesh.vertexCount; ++vertex) {
+        const float angle = 6.2831853f * float(vertex % verticesPerSide) / float(size);
+        mesh.positions.insert(mesh.positions.end(), { std::cos(angle), float(vertex / verticesPerSide) / float(size), std::sin(angle) });
+    }
+
+    std::vector<std::array<uint32_t, 3>> triangles;
+    for (size_t y = 0; y < size; ++y) {
+        for (size_t x = 0; x < size; ++x) {
+            const uint32_t corner = uint32_t(y * verticesPerSide + x);
+            const uint32_t next = corner + uint32_t(verticesPerSide);
+            triangles.push_back({ corner, corner + 1, next });
+            triangles.push_back({ corner + 1, next + 1, next });
+        }
+    }
+    std::shuffle(triangles.begin(), triangles.end(), std::mt19937(7));
+    for (const std::array<uint32_t, 3>& triangle : triangles) {
+        mesh.indices.insert(mesh.indices.end(), triangle.begin(), triangle.end());
+    }
+    return mesh;
+}
+
+// The same grid in scanline order, which is already reasonably cache friendly.
+TestMesh scanlineGrid(size_t size)
+{
+    TestMesh mesh = shuffledTube(size);
+    mesh.name = "Scanline grid";
+    mesh.indices.clear();
+    const uint32_t verticesPerSide = uint32_t(size + 1);
+    for (uint32_t y = 0; y < size; ++y) {
+        for (uint32_t x = 0; x < size; ++x) {
+            const uint32_t corner = y * verticesPerSide + x;
+            mesh.indices.insert(mesh.indices.end(), { corner, corner + 1, corner + verticesPerSide, corner + 1, corner + verticesPerSide + 1,
+                                                      corner + verticesPerSide });
+        }
+    }
+    return mesh;
+}
+
+// Best time of running 'optimize' on a fresh copy of the indices, returning the optimized indices.
+template <typename Optimize>
+std::vector<uint32_t> measure(const TestMesh& mesh, Optimize&& optimize, float& bestSeconds)
+{
+    constexpr int kRuns = 3;
+    bestSeconds = std::numeric_limits<float>::max();
+    std::vector<uint32_t> indices;
+    for (int run = 0; run < kRuns; ++run) {
+        indices = mesh.indices;
+        util::Timer timer(true);
+        optimize(indices);
+        bestSeconds = std::min(bestSeconds, timer.stop());
+    }
+    return indices;
+}
+
+} // namespace.
+
+// ACMR (vertex cache misses per triangle) of the in-tree mesh optimizations
+// and how long they take, for a FIFO cache of 16 and 32 entries.
+int main(int argc, char** argv)
+{
+    test::init();
+
+    const size_t size = std::max<size_t>(size_t(256 * std::sqrt(test::benchmarkScale(argc, argv))), 2);
+    for (const TestMesh& mesh : { shuffledTube(size), scanlineGrid(size) }) {
+        const size_t triangleCount = mesh.indices.size() / 3;
+        printf("%s: %zu triangles, %zu vertices\n", mesh.name, triangleCount, mesh.vertexCount);
+
+        auto report = [&mesh, triangleCount](const char* name, const std::vector<uint32_t>& indices, float seconds) {
+            const float acmr16 = util::averageCacheMissRatio(indices.data(), indices.size(), mesh.vertexCount, 16);
+            const float acmr32 = util::averageCacheMissRatio(indices.data(), indices.size(), mesh.vertexCount, 32);
+            if (seconds > 0.0f) {
+                printf("  %-22s ACMR %.3f (16), %.3f (32), %.3f s (%.1f M triangles/s)\n", name, acmr16, acmr32, seconds,
+                       double(triangleCount) / seconds * 1e-6);
+            } else {
+                printf("  %-22s ACMR %.3f (16), %.3f (32)\n", name, acmr16, acmr32);
+            }
+            return acmr16;
+        };
+
+        const float inputRatio = report("Input", mesh.indices, 0.0f);
+
+        float seconds = 0.0f;
+        std::vector<uint32_t> optimized = measure(mesh, [&mesh](std::vector<uint32_t>& indices) {
+            util::optimizeVertexCache(indices.data(), indices.size(), mesh.vertexCount);
+        }, seconds);
+        const float optimizedRatio = report("Vertex cache", optimized, seconds);
+        CHECK(optimizedRatio <= inputRatio);
+        CHECK(optimizedRatio < 0.8f);
+
+        optimized = measure(mesh, [&mesh](std::vector<uint32_t>& indices) {
+            util::Arena scratch;
+            util::optimizeVertexCache(indices.data(), indices.size(), mesh.vertexCount, util::kDefaultVertexCacheSize, &scratch);
+        }, seconds);
+        report("Vertex cache (arena)", optimized, seconds);
+
+        optimized = measure(mesh, [&mesh](std::vector<uint32_t>& indices) {
+            util::sortTrianglesSpatially(indices.data(), indices.size(), mesh.positions.data(), 3);
+        }, seconds);
+        report("Spatial", optimized, seconds);
+    }
+
+    return test::finish();
+}
@@ -0,0 +1,195 @@
+#include "TestHarness.h"
+
+#include <Utility/MeshOptimizer.h>
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <memory_resource>
+#include <random>
+#include <vector>
+
+namespace {
+
+struct TestMesh {
+    std::vector<float> positions; // Three floats per vertex.
+    std::vector<uint32_t> indices;
+    size_t vertexCount = 0;
+};
+
+// Grid of 'size'^2 quads with its triangles in a random order.
+TestMesh shuffledGrid(size_t size, uint32_t seed)
+{
+    TestMesh mesh;
+    const size_t verticesPerSide = size + 1;
+    mesh.vertexCount = verticesPerSide * verticesPerSide;
+    for (size_t vertex = 0; vertex < mesh.vertexCount; ++vertex) {
+        mesh.positions.insert(mesh.positions.end(), { float(vertex % verticesPerSide), 0.0f, float(vertex / verticesPerSide) });
+    }
+
+    std::vector<std::array<uint32_t, 3>> triangles;
+    for (size_t y = 0; y < size; ++y) {
+        for (size_t x = 0; x < size; ++x) {
+            const uint32_t corner = uint32_t(y * verticesPerSide + x);
+            const uint32_t next = corner + uint32_t(verticesPerSide);
+            triangles.push_back({ corner, corner + 1, next });
+            triangles.push_back({ corner + 1, next + 1, next });
+        }
+    }
+    std::shuffle(triangles.begin(), triangles.end(), std::mt19937(seed));
+    for (const std::array<uint32_t, 3>& triangle : triangles) {
+        mesh.indices.insert(mesh.indices.end(), triangle.begin(), triangle.end());
+    }
+    return mesh;
+}
+
+// Triangles of 'indices' rotated so that each starts with its smallest index, which keeps the
+// winding, in sorted order. Two index buffers with the same result hold the same triangles.
+std::vector<std::array<uint32_t, 3>> canonicalTriangles(const std::vector<uint32_t>& indices)
+{
+    std::vector<std::array<uint32_t, 3>> triangles;
+    for (size_t ii = 0; ii < indices.size(); ii += 3) {
+        std::array<uint32_t, 3> triangle = { indices[ii], indices[ii + 1], indices[ii + 2] };
+        std::rotate(triangle.begin(), std::min_element(triangle.begin(), triangle.end()), triangle.end());
+        triangles.push_back(triangle);
+    }
+    std::sort(triangles.begin(), triangles.end());
+    return triangles;
+}
+
+// Memory resource that counts what is allocated through it.
+class CountingResource : public std::pmr::memory_resource
+{
+public:
+    size_t allocationCount = 0;
+    size_t liveBytes = 0;
+
+private:
+    void* do_allocate(size_t bytes, size_t alignment) override
+    {
+        ++allocationCount;
+        liveBytes += bytes;
+        return std::pmr::new_delete_resource()->allocate(bytes, alignment);
+    }
+
+    void do_deallocate(void* p, size_t bytes, size_t alignment) override
+    {
+        liveBytes -= bytes;
+        std::pmr::new_delete_resource()->deallocate(p, bytes, alignment);
+    }
+
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override { return (this == &other); }
+};
+
+void testVertexCachePreservesTopology()
+{
+    TestMesh mesh = shuffledGrid(32, 1);
+    const std::vector<uint32_t> original = mesh.indices;
+    const float inputRatio = util::averageCacheMissRatio(mesh.indices.data(), mesh.indices.size(), mesh.vertexCount);
+
+    CountingResource scratch;
+    util::optimizeVertexCache(mesh.indices.data(), mesh.indices.size(), mesh.vertexCount, util::kDefaultVertexCacheSize, &scratch);
+    CHECK(canonicalTriangles(mesh.indices) == canonicalTriangles(original));
+    CHECK(scratch.allocationCount > 0);
+    CHECK(scratch.liveBytes == 0);
+
+    // A regular grid gets close to one new vertex per two triangles.
+    const float optimizedRatio = util::averageCacheMissRatio(mesh.indices.data(), mesh.indices.size(), mesh.vertexCount);
+    CHECK(inputRatio > 1.5f);
+    CHECK(optimizedRatio < 0.8f);
+}
+
+void testSpatialSortPreservesTopology()
+{
+    TestMesh mesh = shuffledGrid(32, 2);
+    const std::vector<uint32_t> original = mesh.indices;
+
+    CountingResource scratch;
+    util::sortTrianglesSpatially(mesh.indices.data(), mesh.indices.size(), mesh.positions.data(), 3, &scratch);
+    CHECK(canonicalTriangles(mesh.indices) == canonicalTriangles(original));
+    CHECK(scratch.allocationCount > 0);
+    CHECK(scratch.liveBytes == 0);
+
+    // Consecutive triangles are close to each other.
+    float totalDistance = 0.0f;
+    auto centroidX = [&mesh](size_t triangle) {
+        return (mesh.positions[mesh.indices[triangle * 3] * 3] + mesh.positions[mesh.indices[triangle * 3 + 1] * 3] +
+                mesh.positions[mesh.indices[triangle * 3 + 2] * 3]) / 3.0f;
+    };
+    const size_t triangleCount = mesh.indices.size() / 3;
+    for (size_t triangle = 1; triangle < triangleCount; ++triangle) {
+        totalDistance += std::abs(centroidX(triangle) - centroidX(triangle - 1));
+    }
+    CHECK((totalDistance / float(triangleCount - 1)) < 2.0f);
+}
+
+void testVertexFetchRemap()
+{
+    TestMesh mesh = shuffledGrid(16, 3);
+    mesh.vertexCount += 2; // Two vertices that no triangle uses.
+    const std::vector<uint32_t> original = mesh.indices;
+
+    CountingResource scratch;
+    {
+        const std::pmr::vector<uint32_t> remap = util::optimizeVertexFetch(mesh.indices.data(), mesh.indices.size(), mesh.vertexCount, &scratch);
+        CHECK(remap.get_allocator().resource() == &scratch);
+        CHECK(remap.size() == mesh.vertexCount);
+
+        // The remap is a permutation and the triangles are the original ones renumbered.
+        std::vector<uint32_t> sorted(remap.begin(), remap.end());
+        std::sort(sorted.begin(), sorted.end());
+        bool permutation = true;
+        for (size_t ii = 0; ii < sorted.size(); ++ii) {
+            permutation = permutation && (sorted[ii] == ii);
+        }
+        CHECK(permutation);
+
+        bool renumbered = true;
+        for (size_t ii = 0; ii < original.size(); ++ii) {
+            renumbered = renumbered && (mesh.indices[ii] == remap[original[ii]]);
+        }
+        CHECK(renumbered);
+
+        // Vertices are numbered in the order they are first used, unused ones go last.
+        uint32_t nextVertex = 0;
+        bool firstUseOrder = true;
+        for (uint32_t index : mesh.indices) {
+            firstUseOrder = firstUseOrder && (index <= nextVertex);
+            nextVertex = std::max(nextVertex, index + 1);
+        }
+        CHECK(firstUseOrder);
+        CHECK(remap[mesh.vertexCount - 2] == mesh.vertexCount - 2);
+        CHECK(remap[mesh.vertexCount - 1] == mesh.vertexCount - 1);
+    }
+    CHECK(scratch.liveBytes == 0);
+}
+
+void testAverageCacheMissRatio()
+{
+    // Every vertex of a triangle soup misses.
+    const std::vector<uint32_t> soup = { 0, 1, 2, 3, 4, 5, 6, 7, 8 };
+    CHECK(util::averageCacheMissRatio(soup.data(), soup.size(), 9) == 3.0f);
+
+    // A second triangle sharing an edge only adds one vertex.
+    const std::vector<uint32_t> strip = { 0, 1, 2, 2, 1, 3 };
+    CHECK(util::averageCacheMissRatio(strip.data(), strip.size(), 4) == 2.0f);
+
+    // With a cache of 3 entries the first vertex has been evicted by the time it is used again.
+    const std::vector<uint32_t> evicted = { 0, 1, 2, 3, 4, 5, 0, 1, 2 };
+    CHECK(util::averageCacheMissRatio(evicted.data(), evicted.size(), 6, 3) == 3.0f);
+    CHECK(util::averageCacheMissRatio(evicted.data(), evicted.size(), 6, 6) == 2.0f);
+}
+
+} // namespace.
+
+int main(int, char**)
+{
+    test::init();
+
+    testVertexCachePreservesTopology();
+    testSpatialSortPreservesTopology();
+    testVertexFetchRemap();
+    testAverageCacheMissRatio();
+
+    return test::finish();
+}
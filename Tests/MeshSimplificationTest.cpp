@@ -0,0 +1,264 @@
+#include "TestHarness.h"
+
+#include <cstring> // SphereMeshProvider.h uses memcpy without including it.
+
+#include <HeatrayRenderer/Scene/MeshLod.h>
+#include <HeatrayRenderer/Scene/SphereMeshProvider.h>
+#include <Utility/MeshOptimizer.h>
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <map>
+#include <vector>
+
+namespace {
+
+const std::string kDirectory = "MeshSimplificationTestFiles";
+
+struct TestMesh {
+    std::vector<float> positions; // Three floats per vertex.
+    std::vector<uint32_t> indices;
+    size_t vertexCount() const { return positions.size() / 3; }
+};
+
+// Unit square of 'size'^2 quads in the xz plane displaced along y by 'height'.
+template <typename Height>
+TestMesh heightField(size_t size, Height&& height)
+{
+    TestMesh mesh;
+    const uint32_t verticesPerSide = uint32_t(size + 1);
+    for (uint32_t z = 0; z < verticesPerSide; ++z) {
+        for (uint32_t x = 0; x < verticesPerSide; ++x) {
+            const float u = float(x) / float(size);
+            const float v = float(z) / float(size);
+            mesh.positions.insert(mesh.positions.end(), { u, height(u, v), v });
+        }
+    }
+    for (uint32_t z = 0; z < size; ++z) {
+        for (uint32_t x = 0; x < size; ++x) {
+            const uint32_t corner = z * verticesPerSide + x;
+            mesh.indices.insert(mesh.indices.end(), { corner, corner + verticesPerSide, corner + 1, corner + 1, corner + verticesPerSide,
+                                                      corner + verticesPerSide + 1 });
+        }
+    }
+    return mesh;
+}
+
+// Closed cube of 6 * 'size'^2 quads projected onto the unit sphere, without seams.
+TestMesh cubeSphere(size_t size)
+{
+    TestMesh mesh;
+    std::map<std::array<int, 3>, uint32_t> vertices;
+    auto vertex = [&](std::array<int, 3> grid) {
+        auto [iter, inserted] = vertices.emplace(grid, uint32_t(vertices.size()));
+        if (inserted) {
+            const float p[3] = { float(grid[0]) / float(size) * 2.0f - 1.0f, float(grid[1]) / float(size) * 2.0f - 1.0f,
+                                 float(grid[2]) / float(size) * 2.0f - 1.0f };
+            const float length = std::sqrt(p[0] * p[0] + p[1] * p[1] + p[2] * p[2]);
+            mesh.positions.insert(mesh.positions.end(), { p[0] / length, p[1] / length, p[2] / length });
+        }
+        return iter->second;
+    };
+
+    const int n = int(size);
+    for (int axis = 0; axis < 3; ++axis) {
+        for (int side = 0; side < 2; ++side) {
+            for (int a = 0; a < n; ++a) {
+                for (int b = 0; b < n; ++b) {
+                    // Corners of the quad on the face where the coordinate along 'axis' is 0 or n.
+                    auto corner = [&](int da, int db) {
+                        std::array<int, 3> grid;
+                        grid[axis] = side * n;
+                        grid[(axis + 1) % 3] = a + da;
+                        grid[(axis + 2) % 3] = b + db;
+                        return vertex(grid);
+                    };
+                    const uint32_t q[4] = { corner(0, 0), corner(1, 0), corner(1, 1), corner(0, 1) };
+                    if (side == 1) {
+                        mesh.indices.insert(mesh.indices.end(), { q[0], q[1], q[2], q[0], q[2], q[3] });
+                    } else {
+                        mesh.indices.insert(mesh.indices.end(), { q[0], q[2], q[1], q[0], q[3], q[2] });
+                    }
+                }
+            }
+        }
+    }
+    return mesh;
+}
+
+// True if every edge of 'indices' is shared by exactly two triangles that use it in opposite directions.
+bool closedManifold(const uint32_t* indices, size_t indexCount)
+{
+    std::map<std::pair<uint32_t, uint32_t>, int> directedEdges;
+    for (size_t ii = 0; ii < indexCount; ii += 3) {
+        for (size_t corner = 0; corner < 3; ++corner) {
+            const uint32_t a = indices[ii + corner];
+            const uint32_t b = indices[ii + (corner + 1) % 3];
+            if ((a == b) || (++directedEdges[{ a, b }] > 1)) {
+                return false;
+            }
+        }
+    }
+    for (const auto& edge : directedEdges) {
+        if (directedEdges.count({ edge.first.second, edge.first.first }) == 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Largest vertical distance between the vertices of 'original' and the surface of 'simplified', both
+// height fields over the unit square. Returns a negative value if a vertex is not covered.
+float heightFieldDeviation(const TestMesh& original, const uint32_t* indices, size_t indexCount)
+{
+    const std::vector<float>& p = original.positions;
+    float deviation = 0.0f;
+    for (size_t vertex = 0; vertex < original.vertexCount(); ++vertex) {
+        const float x = p[vertex * 3];
+        const float z = p[vertex * 3 + 2];
+        bool covered = false;
+        for (size_t ii = 0; (ii < indexCount) && !covered; ii += 3) {
+            const float* a = &p[indices[ii] * 3];
+            const float* b = &p[indices[ii + 1] * 3];
+            const float* c = &p[indices[ii + 2] * 3];
+            const float area = (b[0] - a[0]) * (c[2] - a[2]) - (c[0] - a[0]) * (b[2] - a[2]);
+            const float wb = ((x - a[0]) * (c[2] - a[2]) - (c[0] - a[0]) * (z - a[2])) / area;
+            const float wc = ((b[0] - a[0]) * (z - a[2]) - (x - a[0]) * (b[2] - a[2])) / area;
+            constexpr float kEpsilon = 1e-5f;
+            if ((wb >= -kEpsilon) && (wc >= -kEpsilon) && ((wb + wc) <= (1.0f + kEpsilon))) {
+                const float height = a[1] + wb * (b[1] - a[1]) + wc * (c[1] - a[1]);
+                deviation = std::max(deviation, std::abs(height - p[vertex * 3 + 1]));
+                covered = true;
+            }
+        }
+        if (!covered) {
+            return -1.0f;
+        }
+    }
+    return deviation;
+}
+
+void testFlatSurfaceReachesTarget()
+{
+    // A plane can be simplified down to its locked border without any error.
+    TestMesh mesh = heightField(32, [](float, float) { return 0.0f; });
+    const size_t targetIndexCount = mesh.indices.size() / 10;
+    float error = 1.0f;
+    const size_t indexCount = util::simplifyMesh(mesh.indices.data(), mesh.indices.size(), mesh.positions.data(), mesh.vertexCount(), 3,
+                                                 targetIndexCount, 0.001f, &error);
+    CHECK(indexCount <= targetIndexCount);
+    CHECK(error < 1e-6f);
+    CHECK(heightFieldDeviation(mesh, mesh.indices.data(), indexCount) == 0.0f);
+}
+
+void testErrorBound()
+{
+    // A smooth bump with 10% of the extent in relief.
+    auto bump = [](float u, float v) { return 0.1f * std::sin(3.14159265f * u) * std::sin(3.14159265f * v); };
+    for (float maxError : { 0.001f, 0.005f, 0.02f }) {
+        TestMesh mesh = heightField(48, bump);
+        const size_t originalIndexCount = mesh.indices.size();
+        float error = 1.0f;
+        const size_t indexCount = util::simplifyMesh(mesh.indices.data(), mesh.indices.size(), mesh.positions.data(), mesh.vertexCount(), 3,
+                                                     0, maxError, &error);
+
+        // The reported error stays within the limit and bounds how far the surface moved, the
+        // extent of the mesh is 1.
+        CHECK(indexCount < originalIndexCount);
+        CHECK(error <= maxError);
+        const float deviation = heightFieldDeviation(mesh, mesh.indices.data(), indexCount);
+        CHECK((deviation >= 0.0f) && (deviation <= maxError));
+    }
+
+    // A larger limit removes more triangles.
+    size_t previousIndexCount = ~size_t(0);
+    for (float maxError : { 0.001f, 0.005f, 0.02f }) {
+        TestMesh mesh = heightField(48, bump);
+        const size_t indexCount = util::simplifyMesh(mesh.indices.data(), mesh.indices.size(), mesh.positions.data(), mesh.vertexCount(), 3,
+                                                     0, maxError);
+        CHECK(indexCount < previousIndexCount);
+        previousIndexCount = indexCount;
+    }
+
+    // Nothing on a curved surface can be collapsed without error.
+    TestMesh mesh = heightField(16, bump);
+    const size_t originalIndexCount = mesh.indices.size();
+    CHECK(util::simplifyMesh(mesh.indices.data(), mesh.indices.size(), mesh.positions.data(), mesh.vertexCount(), 3, 0, 0.0f) ==
+          originalIndexCount);
+}
+
+void testClosedSurfaceStaysManifold()
+{
+    TestMesh mesh = cubeSphere(16);
+    CHECK(closedManifold(mesh.indices.data(), mesh.indices.size()));
+
+    // Without an error limit the surface is simplified as far as the link condition allows.
+    const size_t targetIndexCount = mesh.indices.size() / 4;
+    const size_t indexCount = util::simplifyMesh(mesh.indices.data(), mesh.indices.size(), mesh.positions.data(), mesh.vertexCount(), 3,
+                                                 targetIndexCount, 1.0f);
+    CHECK(indexCount <= targetIndexCount);
+    CHECK(closedManifold(mesh.indices.data(), indexCount));
+
+    const size_t minimalIndexCount = util::simplifyMesh(mesh.indices.data(), indexCount, mesh.positions.data(), mesh.vertexCount(), 3, 0, 1.0f);
+    CHECK(minimalIndexCount >= 4 * 3);
+    CHECK(closedManifold(mesh.indices.data(), minimalIndexCount));
+}
+
+void testTetrahedronIsNotFolded()
+{
+    // Collapsing any edge of a tetrahedron would leave two triangles back to back.
+    TestMesh mesh;
+    mesh.positions = { 0.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f, 0.0f, 1.0f };
+    mesh.indices = { 0, 2, 1, 0, 1, 3, 0, 3, 2, 1, 2, 3 };
+    CHECK(closedManifold(mesh.indices.data(), mesh.indices.size()));
+    CHECK(util::simplifyMesh(mesh.indices.data(), mesh.indices.size(), mesh.positions.data(), mesh.vertexCount(), 3, 0, 10.0f) == 12);
+}
+
+void testLodFileRejectsInvalidIndexType()
+{
+    SphereMeshProvider provider(128, 64, 1.0f, "Sphere");
+    std::shared_ptr<MeshLod> lod = MeshLod::generate(provider);
+    CHECK(lod && (lod->submeshes().size() == 1) && (lod->submeshes()[0].indexBuffer != MeshLod::kFullDetail));
+    if (!lod || lod->submeshes().empty()) {
+        return;
+    }
+    CHECK(lod->submeshes()[0].elementCount <= size_t(float(provider.GetSubmesh(0).elementCount) * MeshLod::kDefaultTriangleRatio) + 3);
+
+    constexpr uint64_t kKey = 42;
+    const std::string path = kDirectory + "/sphere" + MeshLod::kFileExtension;
+    CHECK(lod->write(path, kKey));
+    std::shared_ptr<MeshLod> loaded = MeshLod::load(path, kKey);
+    CHECK(loaded && (loaded->indexBuffers() == lod->indexBuffers()) && (loaded->submeshes()[0].elementCount == lod->submeshes()[0].elementCount));
+
+    // The index type of the only submesh is the last value in the file.
+    std::vector<char> bytes;
+    {
+        std::ifstream fin(path, std::ios::binary);
+        bytes.assign(std::istreambuf_iterator<char>(fin), std::istreambuf_iterator<char>());
+    }
+    const uint32_t invalidType = 7;
+    std::memcpy(bytes.data() + bytes.size() - sizeof(uint32_t), &invalidType, sizeof(uint32_t));
+    std::ofstream(path, std::ios::binary | std::ios::trunc).write(bytes.data(), std::streamsize(bytes.size()));
+    CHECK(MeshLod::load(path, kKey) == nullptr);
+}
+
+} // namespace.
+
+int main(int, char**)
+{
+    test::init();
+
+    std::filesystem::create_directories(kDirectory);
+    testFlatSurfaceReachesTarget();
+    testErrorBound();
+    testClosedSurfaceStaysManifold();
+    testTetrahedronIsNotFolded();
+    testLodFileRejectsInvalidIndexType();
+    std::filesystem::remove_all(kDirectory);
+
+    return test::finish();
+}
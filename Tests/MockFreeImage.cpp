@@ -0,0 +1,27 @@
+// FreeImage is only available as a Windows library. The tests never load
+// .exr or .tiff files, so every FreeImage function used by Heatray reports
+// that the format is unsupported.
+
+#include <FreeImage/FreeImage.h>
+
+extern "C" {
+
+FIBITMAP* DLL_CALLCONV FreeImage_AllocateT(FREE_IMAGE_TYPE, int, int, int, unsigned, unsigned, unsigned) { return nullptr; }
+FIBITMAP* DLL_CALLCONV FreeImage_ConvertToRGBF(FIBITMAP*) { return nullptr; }
+void DLL_CALLCONV FreeImage_DeInitialise(void) {}
+BOOL DLL_CALLCONV FreeImage_FIFSupportsReading(FREE_IMAGE_FORMAT) { return FALSE; }
+BYTE* DLL_CALLCONV FreeImage_GetBits(FIBITMAP*) { return nullptr; }
+FREE_IMAGE_FORMAT DLL_CALLCONV FreeImage_GetFIFFromFilename(const char*) { return FIF_UNKNOWN; }
+FREE_IMAGE_FORMAT DLL_CALLCONV FreeImage_GetFileType(const char*, int) { return FIF_UNKNOWN; }
+const char* DLL_CALLCONV FreeImage_GetFormatFromFIF(FREE_IMAGE_FORMAT) { return ""; }
+unsigned DLL_CALLCONV FreeImage_GetHeight(FIBITMAP*) { return 0; }
+FREE_IMAGE_TYPE DLL_CALLCONV FreeImage_GetImageType(FIBITMAP*) { return FIT_UNKNOWN; }
+BYTE* DLL_CALLCONV FreeImage_GetScanLine(FIBITMAP*, int) { return nullptr; }
+unsigned DLL_CALLCONV FreeImage_GetWidth(FIBITMAP*) { return 0; }
+void DLL_CALLCONV FreeImage_Initialise(BOOL) {}
+FIBITMAP* DLL_CALLCONV FreeImage_Load(FREE_IMAGE_FORMAT, const char*, int) { return nullptr; }
+BOOL DLL_CALLCONV FreeImage_Save(FREE_IMAGE_FORMAT, FIBITMAP*, const char*, int) { return FALSE; }
+void DLL_CALLCONV FreeImage_SetOutputMessage(FreeImage_OutputMessageFunction) {}
+void DLL_CALLCONV FreeImage_Unload(FIBITMAP*) {}
+
+} // extern "C".
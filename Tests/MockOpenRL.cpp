@@ -0,0 +1,503 @@
+#include "MockOpenRL.h"
+
+#include <algorithm>
+#include <mutex>
+#include <stdint.h>
+#include <string.h>
+#include <unordered_map>
+#include <unordered_set>
+
+namespace {
+
+struct ShaderState {
+    std::string source;
+    bool compiled = false;
+};
+
+struct ProgramState {
+    std::vector<uintptr_t> shaders;
+    bool linked = false;
+    std::unordered_map<std::string, RLint> locations; // Uniforms and uniform blocks, assigned on first lookup.
+};
+
+struct State {
+    std::recursive_mutex mutex;
+    std::unordered_map<std::string, size_t> calls;
+    uintptr_t nextHandle = 1;
+
+    std::unordered_set<uintptr_t> textures;
+    std::unordered_set<uintptr_t> framebuffers;
+    std::unordered_set<int> primitives;
+    std::unordered_map<uintptr_t, std::vector<uint8_t>> buffers;
+    std::unordered_map<uintptr_t, size_t> bufferSizes;
+    std::vector<uint8_t> bufferScratch; // Mapped instead of the buffer data if it is not kept.
+    bool keepBufferData = true;
+    std::unordered_map<RLenum, uintptr_t> boundBuffers; // key = target.
+    std::unordered_map<uintptr_t, ShaderState> shaders;
+    std::unordered_map<uintptr_t, ProgramState> programs;
+    std::vector<test::MockOpenRL::DrawCall> drawCalls;
+
+    std::string compileMarker;
+    std::string linkMarker;
+    std::vector<std::string> activeUniforms;
+    std::vector<std::string> activeUniformBlocks;
+};
+
+State& state()
+{
+    static State state;
+    return state;
+}
+
+// Counts the call and keeps the state locked for the rest of the rl* function.
+#define MOCK_CALL()                                                     \
+    State& mock = state();                                              \
+    std::lock_guard<std::recursive_mutex> lock(mock.mutex);             \
+    ++mock.calls[__func__]
+
+template <typename T>
+T newHandle(State& mock)
+{
+    return reinterpret_cast<T>(mock.nextHandle++);
+}
+
+template <typename T>
+uintptr_t id(T handle)
+{
+    return reinterpret_cast<uintptr_t>(handle);
+}
+
+void copyString(const std::string& string, RLsize bufferSize, RLsize* length, char* buffer)
+{
+    const size_t count = std::min<size_t>(string.size(), (bufferSize > 0) ? bufferSize - 1 : 0);
+    if (buffer && (bufferSize > 0)) {
+        memcpy(buffer, string.data(), count);
+        buffer[count] = '\0';
+    }
+    if (length) {
+        *length = count;
+    }
+}
+
+RLint location(ProgramState& program, const char* name)
+{
+    auto iter = program.locations.find(name);
+    if (iter == program.locations.end()) {
+        iter = program.locations.emplace(name, RLint(program.locations.size())).first;
+    }
+    return iter->second;
+}
+
+} // namespace.
+
+namespace test {
+
+MockOpenRL& MockOpenRL::instance()
+{
+    static MockOpenRL mock;
+    return mock;
+}
+
+size_t MockOpenRL::calls(const std::string& name) const
+{
+    std::lock_guard<std::recursive_mutex> lock(state().mutex);
+    auto iter = state().calls.find(name);
+    return (iter != state().calls.end()) ? iter->second : 0;
+}
+
+size_t MockOpenRL::liveTextures() const
+{
+    std::lock_guard<std::recursive_mutex> lock(state().mutex);
+    return state().textures.size();
+}
+
+size_t MockOpenRL::liveBuffers() const
+{
+    std::lock_guard<std::recursive_mutex> lock(state().mutex);
+    return state().buffers.size();
+}
+
+size_t MockOpenRL::livePrograms() const
+{
+    std::lock_guard<std::recursive_mutex> lock(state().mutex);
+    return state().programs.size();
+}
+
+size_t MockOpenRL::liveShaders() const
+{
+    std::lock_guard<std::recursive_mutex> lock(state().mutex);
+    return state().shaders.size();
+}
+
+size_t MockOpenRL::livePrimitives() const
+{
+    std::lock_guard<std::recursive_mutex> lock(state().mutex);
+    return state().primitives.size();
+}
+
+std::vector<MockOpenRL::DrawCall> MockOpenRL::drawCalls() const
+{
+    std::lock_guard<std::recursive_mutex> lock(state().mutex);
+    return state().drawCalls;
+}
+
+size_t MockOpenRL::bufferBytes() const
+{
+    std::lock_guard<std::recursive_mutex> lock(state().mutex);
+    size_t bytes = 0;
+    for (const auto& iter : state().bufferSizes) {
+        bytes += iter.second;
+    }
+    return bytes;
+}
+
+void MockOpenRL::setFailureMarkers(const std::string& compileMarker, const std::string& linkMarker)
+{
+    std::lock_guard<std::recursive_mutex> lock(state().mutex);
+    state().compileMarker = compileMarker;
+    state().linkMarker = linkMarker;
+}
+
+void MockOpenRL::setActiveUniforms(std::vector<std::string> uniforms, std::vector<std::string> uniformBlocks)
+{
+    std::lock_guard<std::recursive_mutex> lock(state().mutex);
+    state().activeUniforms = std::move(uniforms);
+    state().activeUniformBlocks = std::move(uniformBlocks);
+}
+
+void MockOpenRL::setKeepBufferData(bool keep)
+{
+    std::lock_guard<std::recursive_mutex> lock(state().mutex);
+    state().keepBufferData = keep;
+    state().bufferScratch = std::vector<uint8_t>();
+}
+
+void MockOpenRL::reset()
+{
+    std::lock_guard<std::recursive_mutex> lock(state().mutex);
+    state().calls.clear();
+    state().drawCalls.clear();
+}
+
+} // namespace test.
+
+extern "C" {
+
+RLenum rlGetError(void) { return RL_NO_ERROR; }
+
+// Textures.
+void rlGenTextures(RLsize n, RLtexture* textures)
+{
+    MOCK_CALL();
+    for (RLsize ii = 0; ii < n; ++ii) {
+        textures[ii] = newHandle<RLtexture>(mock);
+        mock.textures.insert(id(textures[ii]));
+    }
+}
+
+void rlDeleteTextures(RLsize n, const RLtexture* textures)
+{
+    MOCK_CALL();
+    for (RLsize ii = 0; ii < n; ++ii) {
+        mock.textures.erase(id(textures[ii]));
+    }
+}
+
+void rlBindTexture(RLenum, RLtexture) { MOCK_CALL(); }
+void rlTexParameteri(RLenum, RLenum, RLint) { MOCK_CALL(); }
+void rlTexImage2D(RLenum, RLint, RLenum, RLint, RLint, RLint, RLenum, RLenum, const void*) { MOCK_CALL(); }
+void rlTexImage3D(RLenum, RLint, RLenum, RLint, RLint, RLint, RLint, RLenum, RLenum, const void*) { MOCK_CALL(); }
+void rlGenerateMipmap(RLenum) { MOCK_CALL(); }
+void rlGetTexImage(RLenum, RLint, RLenum, RLenum, RLvoid*) { MOCK_CALL(); }
+
+// Buffers.
+void rlGenBuffers(RLsize n, RLbuffer* buffers)
+{
+    MOCK_CALL();
+    for (RLsize ii = 0; ii < n; ++ii) {
+        buffers[ii] = newHandle<RLbuffer>(mock);
+        mock.buffers[id(buffers[ii])];
+        mock.bufferSizes[id(buffers[ii])] = 0;
+    }
+}
+
+void rlDeleteBuffers(RLsize n, const RLbuffer* buffers)
+{
+    MOCK_CALL();
+    for (RLsize ii = 0; ii < n; ++ii) {
+        mock.buffers.erase(id(buffers[ii]));
+        mock.bufferSizes.erase(id(buffers[ii]));
+    }
+}
+
+void rlBindBuffer(RLenum target, RLbuffer buffer)
+{
+    MOCK_CALL();
+    mock.boundBuffers[target] = id(buffer);
+}
+
+void rlBufferData(RLenum target, RLsize size, const void* data, RLenum)
+{
+    MOCK_CALL();
+    auto iter = mock.buffers.find(mock.boundBuffers[target]);
+    if (iter != mock.buffers.end()) {
+        mock.bufferSizes[iter->first] = size;
+        if (!mock.keepBufferData) {
+            iter->second = std::vector<uint8_t>();
+            return;
+        }
+        iter->second.assign(size, 0);
+        if (data) {
+            memcpy(iter->second.data(), data, size);
+        }
+    }
+}
+
+void rlBufferParameterString(RLenum, RLenum, const char*) { MOCK_CALL(); }
+
+void* rlMapBuffer(RLenum target, RLenum)
+{
+    MOCK_CALL();
+    auto iter = mock.buffers.find(mock.boundBuffers[target]);
+    if ((iter != mock.buffers.end()) && !mock.keepBufferData) {
+        mock.bufferScratch.resize(std::max(mock.bufferScratch.size(), mock.bufferSizes[iter->first]));
+        return mock.bufferScratch.data();
+    }
+    return (iter != mock.buffers.end()) ? iter->second.data() : nullptr;
+}
+
+RLboolean rlUnmapBuffer(RLenum) { MOCK_CALL(); return RL_TRUE; }
+void rlVertexAttribBuffer(RLint, RLint, RLenum, RLboolean, RLsize, RLsize) { MOCK_CALL(); }
+
+// Primitives.
+void rlGenPrimitives(RLsize n, RLprimitive* primitives)
+{
+    MOCK_CALL();
+    for (RLsize ii = 0; ii < n; ++ii) {
+        primitives[ii] = RLprimitive(mock.nextHandle++);
+        mock.primitives.insert(int(primitives[ii]));
+    }
+}
+
+void rlDeletePrimitives(RLsize n, const RLprimitive* primitives)
+{
+    MOCK_CALL();
+    for (RLsize ii = 0; ii < n; ++ii) {
+        mock.primitives.erase(int(primitives[ii]));
+    }
+}
+
+void rlBindPrimitive(RLenum, RLprimitive) { MOCK_CALL(); }
+void rlPrimitiveParameter1i(RLenum, RLenum, RLint) { MOCK_CALL(); }
+void rlDrawElements(RLenum mode, RLsize count, RLenum type, RLsize offset)
+{
+    MOCK_CALL();
+    test::MockOpenRL::DrawCall call{ mode, size_t(count), type, size_t(offset), {} };
+    auto iter = mock.buffers.find(mock.boundBuffers[RL_ELEMENT_ARRAY_BUFFER]);
+    const size_t size = (type == RL_UNSIGNED_SHORT) ? sizeof(uint16_t) : sizeof(uint32_t);
+    if ((iter != mock.buffers.end()) && (offset + count * size <= iter->second.size())) {
+        const uint8_t* data = iter->second.data() + offset;
+        for (size_t ii = 0; ii < count; ++ii) {
+            if (size == sizeof(uint16_t)) {
+                uint16_t index;
+                memcpy(&index, data + ii * size, size);
+                call.indices.push_back(index);
+            } else {
+                uint32_t index;
+                memcpy(&index, data + ii * size, size);
+                call.indices.push_back(index);
+            }
+        }
+    }
+    mock.drawCalls.push_back(std::move(call));
+}
+
+// Framebuffers and frame rendering.
+void rlGenFramebuffers(RLsize n, RLframebuffer* framebuffers)
+{
+    MOCK_CALL();
+    for (RLsize ii = 0; ii < n; ++ii) {
+        framebuffers[ii] = newHandle<RLframebuffer>(mock);
+        mock.framebuffers.insert(id(framebuffers[ii]));
+    }
+}
+
+void rlDeleteFramebuffers(RLsize n, const RLframebuffer* framebuffers)
+{
+    MOCK_CALL();
+    for (RLsize ii = 0; ii < n; ++ii) {
+        mock.framebuffers.erase(id(framebuffers[ii]));
+    }
+}
+
+void rlBindFramebuffer(RLenum, RLframebuffer) { MOCK_CALL(); }
+void rlFramebufferTexture2D(RLenum, RLenum, RLenum, RLtexture, RLint) { MOCK_CALL(); }
+RLenum rlCheckFramebufferStatus(RLenum) { MOCK_CALL(); return RL_FRAMEBUFFER_COMPLETE; }
+void rlClear(RLbitfield) { MOCK_CALL(); }
+void rlFrontFace(RLenum) { MOCK_CALL(); }
+void rlViewport(RLint, RLint, RLint, RLint) { MOCK_CALL(); }
+void rlRenderFrame(void) { MOCK_CALL(); }
+
+// Shaders.
+RLshader rlCreateShader(RLenum)
+{
+    MOCK_CALL();
+    RLshader shader = newHandle<RLshader>(mock);
+    mock.shaders[id(shader)];
+    return shader;
+}
+
+void rlDeleteShader(RLshader shader)
+{
+    MOCK_CALL();
+    mock.shaders.erase(id(shader));
+}
+
+void rlShaderString(RLshader, RLenum, const char*) { MOCK_CALL(); }
+
+void rlShaderSource(RLshader shader, RLsize count, const char* const* strings, const RLsize* lengths)
+{
+    MOCK_CALL();
+    std::string& source = mock.shaders[id(shader)].source;
+    source.clear();
+    for (RLsize ii = 0; ii < count; ++ii) {
+        source.append(strings[ii], lengths ? lengths[ii] : strlen(strings[ii]));
+    }
+}
+
+void rlCompileShader(RLshader shader)
+{
+    MOCK_CALL();
+    ShaderState& shaderState = mock.shaders[id(shader)];
+    shaderState.compiled = mock.compileMarker.empty() || (shaderState.source.find(mock.compileMarker) == std::string::npos);
+}
+
+void rlGetShaderiv(RLshader shader, RLenum pname, RLint* params)
+{
+    MOCK_CALL();
+    *params = ((pname == RL_COMPILE_STATUS) && mock.shaders[id(shader)].compiled) ? RL_TRUE : RL_FALSE;
+}
+
+void rlGetShaderString(RLshader, RLenum, const char** param)
+{
+    MOCK_CALL();
+    *param = "mock compile error";
+}
+
+// Programs.
+RLprogram rlCreateProgram(void)
+{
+    MOCK_CALL();
+    RLprogram program = newHandle<RLprogram>(mock);
+    mock.programs[id(program)];
+    return program;
+}
+
+void rlDeleteProgram(RLprogram program)
+{
+    MOCK_CALL();
+    mock.programs.erase(id(program));
+}
+
+void rlAttachShader(RLprogram program, RLshader shader)
+{
+    MOCK_CALL();
+    mock.programs[id(program)].shaders.push_back(id(shader));
+}
+
+void rlLinkProgram(RLprogram program)
+{
+    MOCK_CALL();
+    ProgramState& programState = mock.programs[id(program)];
+    programState.linked = true;
+    for (uintptr_t shader : programState.shaders) {
+        const ShaderState& shaderState = mock.shaders[shader];
+        if (!shaderState.compiled || (!mock.linkMarker.empty() && (shaderState.source.find(mock.linkMarker) != std::string::npos))) {
+            programState.linked = false;
+        }
+    }
+}
+
+void rlGetProgramiv(RLprogram program, RLenum pname, RLint* params)
+{
+    MOCK_CALL();
+    switch (pname) {
+        case RL_LINK_STATUS:
+            *params = mock.programs[id(program)].linked ? RL_TRUE : RL_FALSE;
+            break;
+        case RL_ACTIVE_UNIFORMS:
+            *params = RLint(mock.activeUniforms.size());
+            break;
+        case RL_ACTIVE_UNIFORM_MAX_LENGTH: {
+            size_t length = 0;
+            for (const std::string& name : mock.activeUniforms) {
+                length = std::max(length, name.size() + 1);
+            }
+            *params = RLint(length);
+            break;
+        }
+        case RL_ACTIVE_UNIFORM_BLOCKS:
+            *params = RLint(mock.activeUniformBlocks.size());
+            break;
+        default:
+            *params = 0;
+            break;
+    }
+}
+
+void rlGetProgramString(RLprogram, RLenum, const char** param)
+{
+    MOCK_CALL();
+    *param = "mock link error";
+}
+
+void rlUseProgram(RLprogram) { MOCK_CALL(); }
+
+void rlGetActiveUniform(RLprogram, RLint index, RLsize bufsize, RLsize* length, RLint* size, RLenum* type, char* name)
+{
+    MOCK_CALL();
+    copyString(mock.activeUniforms[size_t(index)], bufsize, length, name);
+    *size = 1;
+    *type = RL_FLOAT;
+}
+
+void rlGetActiveUniformBlock(RLprogram, RLint index, RLsize bufsize, RLsize* length, char* name, RLint* fieldCount, RLsize* blocksize)
+{
+    MOCK_CALL();
+    copyString(mock.activeUniformBlocks[size_t(index)], bufsize, length, name);
+    *fieldCount = 0;
+    *blocksize = 0;
+}
+
+RLint rlGetUniformLocation(RLprogram program, const char* name)
+{
+    MOCK_CALL();
+    return location(mock.programs[id(program)], name);
+}
+
+RLint rlGetUniformBlockIndex(RLprogram program, const char* name)
+{
+    MOCK_CALL();
+    return location(mock.programs[id(program)], name);
+}
+
+RLint rlGetAttribLocation(RLprogram program, const char* name)
+{
+    MOCK_CALL();
+    return location(mock.programs[id(program)], name);
+}
+
+// Uniforms.
+void rlUniform1f(RLint, RLfloat) { MOCK_CALL(); }
+void rlUniform1i(RLint, RLint) { MOCK_CALL(); }
+void rlUniform2fv(RLint, RLsize, const RLfloat*) { MOCK_CALL(); }
+void rlUniform2iv(RLint, RLsize, const RLint*) { MOCK_CALL(); }
+void rlUniform3fv(RLint, RLsize, const RLfloat*) { MOCK_CALL(); }
+void rlUniform4fv(RLint, RLsize, const RLfloat*) { MOCK_CALL(); }
+void rlUniform4iv(RLint, RLsize, const RLint*) { MOCK_CALL(); }
+void rlUniformMatrix4fv(RLint, RLsize, RLboolean, const RLfloat*) { MOCK_CALL(); }
+void rlUniformBlockBuffer(RLint, RLbuffer) { MOCK_CALL(); }
+void rlUniformp(RLint, RLprimitive) { MOCK_CALL(); }
+void rlUniformt(RLint, RLtexture) { MOCK_CALL(); }
+
+} // extern "C".
@@ -0,0 +1,87 @@
+//
+//  MockOpenRL.h
+//  Heatray
+//
+//  Stand-in for the OpenRL library so that code built on the RLWrapper
+//  classes can be tested without a GPU. Every rl* function used by Heatray
+//  is implemented by MockOpenRL.cpp: objects are handed out and counted,
+//  buffers keep their data so that they can be mapped, and every call is
+//  counted by name so that tests can check what the code under test did.
+//
+//
+
+#pragma once
+
+#include <OpenRL/rl.h>
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+namespace test {
+
+class MockOpenRL
+{
+public:
+    static MockOpenRL& instance();
+
+    //-------------------------------------------------------------------------
+    // Number of calls to the rl* function 'name' (e.g. "rlTexImage2D") since
+    // the last reset().
+    size_t calls(const std::string& name) const;
+
+    //-------------------------------------------------------------------------
+    // Number of objects of each type that were created and not deleted yet.
+    size_t liveTextures() const;
+    size_t liveBuffers() const;
+    size_t livePrograms() const;
+    size_t liveShaders() const;
+    size_t livePrimitives() const;
+
+    //-------------------------------------------------------------------------
+    // Bytes currently held by all buffers, as passed to rlBufferData.
+    size_t bufferBytes() const;
+
+    //-------------------------------------------------------------------------
+    // Every rlDrawElements call since the last reset(), along with the
+    // indices it read from the bound element array buffer.
+    struct DrawCall {
+        RLenum mode = 0;
+        size_t count = 0;
+        RLenum type = 0;
+        size_t offset = 0; // In bytes.
+        std::vector<uint32_t> indices;
+    };
+    std::vector<DrawCall> drawCalls() const;
+
+    //-------------------------------------------------------------------------
+    // Shaders whose source contains 'compileMarker' fail to compile and
+    // programs with a shader containing 'linkMarker' attached fail to link.
+    // Empty markers never fail, which is the default.
+    void setFailureMarkers(const std::string& compileMarker, const std::string& linkMarker);
+
+    //-------------------------------------------------------------------------
+    // Uniforms and uniform blocks that every linked program reports as
+    // active. None by default.
+    void setActiveUniforms(std::vector<std::string> uniforms, std::vector<std::string> uniformBlocks);
+
+    //-------------------------------------------------------------------------
+    // Whether buffers keep their data, the default. Otherwise only their size
+    // is recorded and every mapping shares one scratch allocation, so that
+    // uploads don't add to the memory of the test process.
+    void setKeepBufferData(bool keep);
+
+    //-------------------------------------------------------------------------
+    // Clear the call counts and draw calls. Live objects are kept.
+    void reset();
+
+private:
+    MockOpenRL() = default;
+
+    // This class is not copyable.
+    MockOpenRL(const MockOpenRL& other) = delete;
+    MockOpenRL& operator=(const MockOpenRL& other) = delete;
+};
+
+} // namespace test.
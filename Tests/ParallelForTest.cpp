@@ -0,0 +1,63 @@
+#include "TestHarness.h"
+
+#include <Utility/ParallelFor.h>
+
+#include <atomic>
+#include <vector>
+
+namespace {
+
+void testEveryIndexRunsOnce()
+{
+    for (size_t count : { size_t(0), size_t(1), size_t(7), size_t(10000) }) {
+        std::vector<std::atomic<int>> visits(count);
+        std::atomic<bool> workerInRange = true;
+        const size_t workerCount = util::parallelWorkerCount(count);
+        util::parallelFor(count, [&](size_t index, size_t workerIndex) {
+            ++visits[index];
+            if (workerIndex >= workerCount) {
+                workerInRange = false;
+            }
+        });
+
+        bool once = true;
+        for (const std::atomic<int>& visit : visits) {
+            once = once && (visit == 1);
+        }
+        CHECK(once);
+        CHECK(workerInRange);
+    }
+}
+
+void testOutputSlotsAreDeterministic()
+{
+    // The loaders convert into preallocated per-item slots, so the result must not depend on scheduling.
+    constexpr size_t kCount = 5000;
+    auto run = []() {
+        std::vector<std::vector<size_t>> slots(kCount);
+        util::parallelFor(kCount, [&](size_t index, size_t /*workerIndex*/) {
+            slots[index].resize(index % 17);
+            for (size_t ii = 0; ii < slots[index].size(); ++ii) {
+                slots[index][ii] = index * 31 + ii;
+            }
+        });
+        return slots;
+    };
+
+    const std::vector<std::vector<size_t>> first = run();
+    for (int ii = 0; ii < 4; ++ii) {
+        CHECK(run() == first);
+    }
+}
+
+} // namespace.
+
+int main()
+{
+    test::init();
+
+    testEveryIndexRunsOnce();
+    testOutputSlotsAreDeterministic();
+
+    return test::finish();
+}
@@ -0,0 +1,54 @@
+#include "TestHarness.h"
+
+#include <HeatrayRenderer/RenderCheckpoint.h>
+#include <Utility/Timer.h>
+
+#include <algorithm>
+#include <filesystem>
+#include <vector>
+
+// Measures how long the render thread is blocked by queueing a checkpoint
+// compared to how long the writer thread takes to put it on disk.
+int main(int argc, char** argv)
+{
+    test::init();
+
+    const double scale = test::benchmarkScale(argc, argv);
+    const int32_t width = std::max(int32_t(1920 * scale), 1);
+    const int32_t height = std::max(int32_t(1080 * scale), 1);
+    constexpr int kNumCheckpoints = 8;
+    const std::string path = "RenderCheckpointBenchmark.checkpoint";
+
+    RenderCheckpoint::Header header;
+    header.width = width;
+    header.height = height;
+
+    RenderCheckpoint checkpoint;
+    float copyTime = 0.0f;
+    float queueTime = 0.0f;
+    util::Timer totalTimer(true);
+    for (int ii = 0; ii < kNumCheckpoints; ++ii) {
+        header.sampleIndex = ii;
+
+        // PassGenerator copies the pixels out of the mapped PBO before queueing them.
+        util::Timer timer(true);
+        std::vector<float> pixels(size_t(width) * size_t(height) * 4, float(ii));
+        copyTime += timer.stop();
+
+        timer.start();
+        checkpoint.writeAsync(path, header, std::move(pixels));
+        queueTime += timer.stop();
+    }
+    checkpoint.finish();
+    const float totalTime = totalTimer.stop();
+
+    const double megabytes = double(width) * height * 4 * sizeof(float) / (1024.0 * 1024.0);
+    printf("%d checkpoints of %dx%d (%.1f MB each)\n", kNumCheckpoints, width, height, megabytes);
+    printf("  Render thread: %.3f ms copy + %.3f ms queue per checkpoint\n", 1000.0f * copyTime / kNumCheckpoints,
+           1000.0f * queueTime / kNumCheckpoints);
+    printf("  Writer thread: %.3f ms per checkpoint (%.1f MB/s)\n", 1000.0f * totalTime / kNumCheckpoints,
+           megabytes * kNumCheckpoints / totalTime);
+
+    std::filesystem::remove(path);
+    return test::finish();
+}
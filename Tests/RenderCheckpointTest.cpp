@@ -0,0 +1,152 @@
+#include "TestHarness.h"
+
+#include <HeatrayRenderer/RenderCheckpoint.h>
+
+#include <filesystem>
+#include <fstream>
+#include <vector>
+
+namespace {
+
+constexpr int32_t kWidth = 64;
+constexpr int32_t kHeight = 32;
+constexpr uint64_t kStateHash = 0x1234567890abcdef;
+const std::string kPath = "RenderCheckpointTest.checkpoint";
+
+// Deterministic stand-in for the radiance of one pass of the path tracer.
+float passSample(size_t index, uint32_t pass)
+{
+    return float((index * 7919 + pass * 104729) % 1000) / 1000.0f;
+}
+
+void accumulate(std::vector<float>& pixels, uint32_t firstPass, uint32_t lastPass)
+{
+    for (uint32_t pass = firstPass; pass < lastPass; ++pass) {
+        for (size_t ii = 0; ii < pixels.size(); ++ii) {
+            pixels[ii] += passSample(ii, pass);
+        }
+    }
+}
+
+RenderCheckpoint::Header makeHeader(uint32_t sampleIndex)
+{
+    RenderCheckpoint::Header header;
+    header.width = kWidth;
+    header.height = kHeight;
+    header.sampleIndex = sampleIndex;
+    header.blockPixelSampleX = 1;
+    header.blockPixelSampleY = 2;
+    header.stateHash = kStateHash;
+    return header;
+}
+
+void testResumeMatchesUninterruptedRender()
+{
+    constexpr uint32_t kCheckpointPass = 12;
+    constexpr uint32_t kTotalPasses = 32;
+
+    std::vector<float> uninterrupted(size_t(kWidth) * kHeight * 4, 0.0f);
+    accumulate(uninterrupted, 0, kTotalPasses);
+
+    // Render part of the way and checkpoint.
+    {
+        std::vector<float> pixels(uninterrupted.size(), 0.0f);
+        accumulate(pixels, 0, kCheckpointPass);
+
+        RenderCheckpoint checkpoint;
+        checkpoint.writeAsync(kPath, makeHeader(kCheckpointPass), std::move(pixels));
+        checkpoint.finish();
+    }
+    CHECK(!std::filesystem::exists(kPath + ".tmp"));
+
+    // Resume from the mapping and finish the render.
+    util::MappedFile file;
+    RenderCheckpoint::Header header;
+    const float* mappedPixels = nullptr;
+    CHECK(RenderCheckpoint::open(kPath, kStateHash, kWidth, kHeight, file, header, mappedPixels));
+    if (!mappedPixels) {
+        return;
+    }
+    CHECK(header.sampleIndex == kCheckpointPass);
+    CHECK((header.blockPixelSampleX == 1) && (header.blockPixelSampleY == 2));
+    CHECK((header.pixelDataOffset % RenderCheckpoint::kPixelDataAlignment) == 0);
+
+    std::vector<float> resumed(mappedPixels, mappedPixels + uninterrupted.size());
+    accumulate(resumed, header.sampleIndex, kTotalPasses);
+    CHECK(resumed == uninterrupted);
+}
+
+void testMismatchedCheckpointsAreRejected()
+{
+    {
+        RenderCheckpoint checkpoint;
+        checkpoint.writeAsync(kPath, makeHeader(4), std::vector<float>(size_t(kWidth) * kHeight * 4, 1.0f));
+    } // The destructor flushes the queue.
+
+    util::MappedFile file;
+    RenderCheckpoint::Header header;
+    const float* pixels = nullptr;
+    CHECK(RenderCheckpoint::open(kPath, kStateHash, kWidth, kHeight, file, header, pixels));
+    file.close();
+
+    CHECK(!RenderCheckpoint::open(kPath, kStateHash + 1, kWidth, kHeight, file, header, pixels));
+    CHECK(!RenderCheckpoint::open(kPath, kStateHash, kWidth * 2, kHeight, file, header, pixels));
+    CHECK(!RenderCheckpoint::open("DoesNotExist.checkpoint", kStateHash, kWidth, kHeight, file, header, pixels));
+
+    // A checkpoint that was cut short (e.g. by a full disk) must not be used.
+    const uintmax_t size = std::filesystem::file_size(kPath);
+    std::filesystem::resize_file(kPath, size - 16);
+    CHECK(!RenderCheckpoint::open(kPath, kStateHash, kWidth, kHeight, file, header, pixels));
+
+    {
+        std::ofstream fout(kPath, std::ios::binary | std::ios::trunc);
+        fout << "not a checkpoint";
+    }
+    CHECK(!RenderCheckpoint::open(kPath, kStateHash, kWidth, kHeight, file, header, pixels));
+}
+
+void testLaterCheckpointReplacesEarlierOne()
+{
+    RenderCheckpoint checkpoint;
+    for (uint32_t pass = 1; pass <= 4; ++pass) {
+        checkpoint.writeAsync(kPath, makeHeader(pass * 8), std::vector<float>(size_t(kWidth) * kHeight * 4, float(pass)));
+    }
+    checkpoint.finish();
+
+    util::MappedFile file;
+    RenderCheckpoint::Header header;
+    const float* pixels = nullptr;
+    CHECK(RenderCheckpoint::open(kPath, kStateHash, kWidth, kHeight, file, header, pixels));
+    CHECK(header.sampleIndex == 32);
+    CHECK(pixels && (pixels[0] == 4.0f));
+}
+
+void testFailedReplaceLeavesNoTemporaryFile()
+{
+    // A non-empty directory at the checkpoint path makes the final rename fail.
+    const std::string blockedPath = "RenderCheckpointTest.blocked";
+    std::filesystem::create_directories(blockedPath + "/entry");
+    {
+        RenderCheckpoint checkpoint;
+        checkpoint.writeAsync(blockedPath, makeHeader(8), std::vector<float>(size_t(kWidth) * kHeight * 4, 1.0f));
+        checkpoint.finish();
+    }
+    CHECK(std::filesystem::is_directory(blockedPath));
+    CHECK(!std::filesystem::exists(blockedPath + ".tmp"));
+    std::filesystem::remove_all(blockedPath);
+}
+
+} // namespace.
+
+int main()
+{
+    test::init();
+
+    testResumeMatchesUninterruptedRender();
+    testMismatchedCheckpointsAreRejected();
+    testLaterCheckpointReplacesEarlierOne();
+    testFailedReplaceLeavesNoTemporaryFile();
+
+    std::filesystem::remove(kPath);
+    return test::finish();
+}
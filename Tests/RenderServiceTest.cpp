@@ -0,0 +1,373 @@
+#include "TestHarness.h"
+
+#include <HeatrayRenderer/Service/RenderService.h>
+#include <Utility/Timer.h>
+
+#include <arpa/inet.h>
+#include <filesystem>
+#include <fstream>
+#include <netinet/in.h>
+#include <poll.h>
+#include <stdlib.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+
+const std::string kDirectory = "RenderServiceTestFiles";
+
+// Talks to the service the way a render script would.
+class FakeClient
+{
+public:
+    ~FakeClient() { disconnect(); }
+
+    bool connect(uint16_t port)
+    {
+        m_socket = ::socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+        sockaddr_in address = {};
+        address.sin_family = AF_INET;
+        address.sin_port = htons(port);
+        address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        return ::connect(m_socket, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) == 0;
+    }
+
+    // Connects and sends a first request with the token of the service, the way clients are expected to.
+    bool connectWithToken(uint16_t port)
+    {
+        std::string token;
+        std::ifstream(RenderService::tokenPath(port)) >> token;
+        if (!connect(port)) {
+            return false;
+        }
+        send(R"({"command":"status","token":")" + token + R"("})");
+        return readEvent()["event"].asString() == "status";
+    }
+
+    // True once the service has closed the connection.
+    bool closedByService(int timeoutMs = 2000)
+    {
+        pollfd descriptor = { m_socket, POLLIN, 0 };
+        char buffer[4096];
+        while (poll(&descriptor, 1, timeoutMs) > 0) {
+            ssize_t received = recv(m_socket, buffer, sizeof(buffer), 0);
+            if (received <= 0) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void disconnect()
+    {
+        if (m_socket != -1) {
+            ::close(m_socket);
+            m_socket = -1;
+        }
+    }
+
+    void send(std::string line)
+    {
+        line.push_back('\n');
+        ::send(m_socket, line.data(), line.size(), MSG_NOSIGNAL);
+    }
+
+    // Returns a null value if no event arrives in time.
+    util::JsonValue readEvent(int timeoutMs = 2000)
+    {
+        size_t lineEnd = 0;
+        while ((lineEnd = m_pending.find('\n')) == std::string::npos) {
+            pollfd descriptor = { m_socket, POLLIN, 0 };
+            char buffer[4096];
+            ssize_t received = 0;
+            if ((poll(&descriptor, 1, timeoutMs) <= 0) || ((received = recv(m_socket, buffer, sizeof(buffer), 0)) <= 0)) {
+                return util::JsonValue();
+            }
+            m_pending.append(buffer, size_t(received));
+        }
+
+        util::JsonValue event;
+        util::JsonValue::parse(std::string_view(m_pending).substr(0, lineEnd), event);
+        m_pending.erase(0, lineEnd + 1);
+        return event;
+    }
+
+private:
+    int m_socket = -1;
+    std::string m_pending;
+};
+
+// Stands in for HeatrayRenderer, which pops a job, renders its passes and reports back.
+void renderJob(RenderService& service, const RenderService::Job& job, size_t passes)
+{
+    for (size_t pass = 1; pass <= passes; ++pass) {
+        service.reportProgress(job.id, pass, passes);
+    }
+    service.reportComplete(job.id, true, job.outputPath);
+}
+
+uint16_t startService(RenderService& service)
+{
+    // Avoid failing just because another instance (or an earlier run) holds the port.
+    for (uint16_t port = RenderService::kDefaultPort + 100; port < RenderService::kDefaultPort + 200; ++port) {
+        if (service.start(kDirectory + "/output", port)) {
+            return port;
+        }
+    }
+    return 0;
+}
+
+void testTokenIsOnlyReadableByUser(uint16_t port)
+{
+    struct stat status = {};
+    CHECK(stat(RenderService::tokenPath(port).c_str(), &status) == 0);
+    CHECK((status.st_mode & 0777) == 0600);
+}
+
+void testUnauthenticatedClientsAreDisconnected(uint16_t port)
+{
+    // No token.
+    {
+        FakeClient client;
+        CHECK(client.connect(port));
+        client.send(R"({"command":"submit","session":"a.xml","output":"a.exr"})");
+        CHECK(client.readEvent()["event"].asString() == "error");
+        CHECK(client.closedByService());
+    }
+
+    // Wrong token.
+    {
+        FakeClient client;
+        CHECK(client.connect(port));
+        client.send(R"({"command":"status","token":"00000000000000000000000000000000"})");
+        CHECK(client.readEvent()["event"].asString() == "error");
+        CHECK(client.closedByService());
+    }
+
+    // A browser posting to the port, the body is never looked at.
+    {
+        FakeClient client;
+        CHECK(client.connect(port));
+        client.send("POST / HTTP/1.1\r\nHost: 127.0.0.1\r\nContent-Type: text/plain\r\n\r\n"
+                    R"({"command":"submit","session":"a.xml","output":"a.exr"})");
+        CHECK(client.readEvent()["event"].asString() == "error");
+        CHECK(client.closedByService());
+    }
+
+    // Authenticated clients are disconnected as well once they send something that isn't JSON.
+    {
+        FakeClient client;
+        CHECK(client.connectWithToken(port));
+        client.send("this is not json");
+        CHECK(client.readEvent()["event"].asString() == "error");
+        CHECK(client.closedByService());
+    }
+}
+
+void testOutputsStayInOutputDirectory(RenderService& service, uint16_t port)
+{
+    FakeClient client;
+    CHECK(client.connectWithToken(port));
+
+    const std::string outsidePaths[] = { "../escape.exr", "nested/../../escape.exr", "/tmp/escape.exr", "", "nested/", "link/escape.exr" };
+    for (const std::string& output : outsidePaths) {
+        client.send(R"({"command":"submit","session":"a.xml","output":")" + output + R"("})");
+        util::JsonValue reply = client.readEvent();
+        CHECK(reply["event"].asString() == "error");
+    }
+    CHECK(!service.popJob());
+
+    client.send(R"({"command":"submit","session":"a.xml","output":"nested/../inside.exr"})");
+    CHECK(client.readEvent()["event"].asString() == "queued");
+    std::optional<RenderService::Job> job = service.popJob();
+    CHECK(job && (std::filesystem::path(job->outputPath) == std::filesystem::canonical(kDirectory + "/output") / "inside.exr"));
+    if (job) {
+        service.reportComplete(job->id, false, "Not rendered");
+        CHECK(client.readEvent()["event"].asString() == "started");
+        CHECK(client.readEvent()["event"].asString() == "failed");
+    }
+}
+
+void testJobsAreRenderedByPriority(RenderService& service, uint16_t port)
+{
+    FakeClient client;
+    CHECK(client.connectWithToken(port));
+
+    client.send(R"({"command":"submit","session":"low.xml","output":"low.exr"})");
+    util::JsonValue low = client.readEvent();
+    CHECK(low["event"].asString() == "queued");
+    CHECK(low["position"].asInt(-1) == 0);
+
+    client.send(R"({"command":"submit","session":"high.xml","output":"high.exr","priority":5,)"
+                R"("overrides":{"MaxRenderPasses":256,"InteractiveMode":false,"Scene":"Sponza"}})");
+    util::JsonValue high = client.readEvent();
+    CHECK(high["position"].asInt(-1) == 0);
+
+    client.send(R"({"command":"submit","session":"dropped.xml","output":"dropped.exr"})");
+    util::JsonValue dropped = client.readEvent();
+    CHECK(dropped["position"].asInt(-1) == 2);
+
+    client.send(R"({"command":"cancel","job":)" + dropped["job"].serialize() + "}");
+    CHECK(client.readEvent()["event"].asString() == "cancelled");
+
+    client.send(R"({"command":"status"})");
+    util::JsonValue status = client.readEvent();
+    CHECK(status["queued"].asInt() == 2);
+    CHECK(status["active"].isNull());
+
+    // The renderer picks up the higher priority job first even though it was submitted later.
+    std::optional<RenderService::Job> job = service.popJob();
+    CHECK(job && (job->id == uint64_t(high["job"].asNumber())));
+    if (job) {
+        CHECK(job->sessionPath == "high.xml");
+        CHECK(job->overrides.size() == 3);
+        CHECK((job->overrides.size() == 3) && (job->overrides[0] == std::make_pair(std::string("MaxRenderPasses"), std::string("256"))));
+        CHECK((job->overrides.size() == 3) && (job->overrides[1].second == "false") && (job->overrides[2].second == "Sponza"));
+
+        renderJob(service, *job, 3);
+        CHECK(client.readEvent()["event"].asString() == "started");
+        for (size_t pass = 1; pass <= 3; ++pass) {
+            util::JsonValue progress = client.readEvent();
+            CHECK((progress["event"].asString() == "progress") && (progress["pass"].asSize() == pass) && (progress["total"].asSize() == 3));
+        }
+        util::JsonValue completed = client.readEvent();
+        CHECK((completed["event"].asString() == "completed") && (std::filesystem::path(completed["output"].asString()).filename() == "high.exr"));
+    }
+
+    job = service.popJob();
+    CHECK(job && (job->sessionPath == "low.xml"));
+    if (job) {
+        renderJob(service, *job, 1);
+        CHECK(client.readEvent()["event"].asString() == "started");
+        CHECK(client.readEvent()["event"].asString() == "progress");
+        CHECK(client.readEvent()["event"].asString() == "completed");
+    }
+
+    // The cancelled job is never handed out.
+    CHECK(!service.popJob());
+}
+
+void testCancellingNotifiesTheSubmitter(RenderService& service, uint16_t port)
+{
+    FakeClient submitter;
+    FakeClient canceller;
+    CHECK(submitter.connectWithToken(port));
+    CHECK(canceller.connectWithToken(port));
+
+    submitter.send(R"({"command":"submit","session":"other.xml","output":"other.exr"})");
+    util::JsonValue queued = submitter.readEvent();
+    CHECK(queued["event"].asString() == "queued");
+
+    canceller.send(R"({"command":"cancel","job":)" + queued["job"].serialize() + "}");
+    util::JsonValue reply = canceller.readEvent();
+    CHECK((reply["event"].asString() == "cancelled") && (reply["job"].asNumber() == queued["job"].asNumber()));
+
+    // The client that submitted the job isn't left waiting for it to start.
+    util::JsonValue event = submitter.readEvent();
+    CHECK((event["event"].asString() == "cancelled") && (event["job"].asNumber() == queued["job"].asNumber()));
+    CHECK(!service.popJob());
+}
+
+void testSlowClientsDoNotBlockTheRenderer(RenderService& service, uint16_t port)
+{
+    FakeClient client;
+    CHECK(client.connectWithToken(port));
+    client.send(R"({"command":"submit","session":"slow.xml","output":"slow.exr"})");
+    CHECK(client.readEvent()["event"].asString() == "queued");
+
+    // Far more progress than the socket buffers hold while the client isn't reading.
+    constexpr size_t kPasses = 200000;
+    std::optional<RenderService::Job> job = service.popJob();
+    CHECK(job.has_value());
+    if (!job) {
+        return;
+    }
+    util::Timer timer(true);
+    renderJob(service, *job, kPasses);
+    CHECK(timer.getElapsedTime() < 5.0f);
+
+    // Progress may have been dropped, but what arrives is in order and the job still completes.
+    CHECK(client.readEvent()["event"].asString() == "started");
+    size_t lastPass = 0, progressCount = 0;
+    util::JsonValue event;
+    while ((event = client.readEvent())["event"].asString() == "progress") {
+        CHECK(event["pass"].asSize() > lastPass);
+        lastPass = event["pass"].asSize();
+        ++progressCount;
+    }
+    CHECK(event["event"].asString() == "completed");
+    CHECK(progressCount > 0);
+}
+
+void testDisconnectedClientsAreReaped(RenderService& service, uint16_t port)
+{
+    for (int ii = 0; ii < 32; ++ii) {
+        FakeClient client;
+        CHECK(client.connectWithToken(port));
+    }
+
+    // Every client thread has to be joined again without stopping the service.
+    util::Timer timer(true);
+    while ((service.clientThreadCount() > 0) && (timer.getElapsedTime() < 5.0f)) {
+        usleep(10 * 1000);
+    }
+    CHECK(service.clientThreadCount() == 0);
+}
+
+void testUnauthenticatedClientsAreLimited(uint16_t port)
+{
+    // Clients that connect and then say nothing.
+    FakeClient silentClients[RenderService::kMaxUnauthenticatedConnections];
+    for (FakeClient& client : silentClients) {
+        CHECK(client.connect(port));
+    }
+
+    FakeClient refused;
+    CHECK(refused.connect(port));
+    CHECK(refused.closedByService());
+
+    // They are disconnected once they have had long enough to send the token, after which clients are accepted again.
+    for (FakeClient& client : silentClients) {
+        CHECK(client.readEvent(10000)["event"].asString() == "error");
+        CHECK(client.closedByService());
+    }
+    FakeClient client;
+    CHECK(client.connectWithToken(port));
+}
+
+} // namespace.
+
+int main()
+{
+    std::filesystem::remove_all(kDirectory);
+    std::filesystem::create_directories(kDirectory + "/output");
+#if defined(__linux__)
+    // The token file goes to the user cache directory.
+    setenv("XDG_CACHE_HOME", (std::filesystem::current_path() / kDirectory / "cache").string().c_str(), 1);
+#endif
+    test::init();
+
+    // A link that points out of the output directory must not be usable to write there.
+    std::filesystem::create_directory_symlink(std::filesystem::absolute(kDirectory), kDirectory + "/output/link");
+
+    RenderService service;
+    const uint16_t port = startService(service);
+    CHECK(port != 0);
+    if (port != 0) {
+        testTokenIsOnlyReadableByUser(port);
+        testUnauthenticatedClientsAreDisconnected(port);
+        testOutputsStayInOutputDirectory(service, port);
+        testJobsAreRenderedByPriority(service, port);
+        testCancellingNotifiesTheSubmitter(service, port);
+        testSlowClientsDoNotBlockTheRenderer(service, port);
+        testDisconnectedClientsAreReaped(service, port);
+        testUnauthenticatedClientsAreLimited(port);
+    }
+    service.stop();
+    CHECK(!std::filesystem::exists(RenderService::tokenPath(port)));
+
+    std::filesystem::remove_all(kDirectory);
+
+    return test::finish();
+}
@@ -0,0 +1,45 @@
+#include "SyntheticImage.h"
+#include "TestHarness.h"
+
+#include <Utility/TextureLoader.h>
+#include <Utility/Timer.h>
+
+#include <algorithm>
+#include <limits>
+#include <vector>
+
+// Throughput of the sRGB->linear conversion of 8bit textures with the lookup
+// table and with powf for each channel count.
+int main(int argc, char** argv)
+{
+    test::init();
+
+    const int size = std::max(int(2048 * test::benchmarkScale(argc, argv)), 16);
+    printf("%d x %d pixels\n", size, size);
+
+    for (int channelCount = 1; channelCount <= 4; ++channelCount) {
+        const std::vector<uint8_t> source = test::makePattern(size, size, channelCount);
+        const size_t pixelCount = size_t(size) * size_t(size);
+
+        float seconds[2] = {};
+        std::vector<uint8_t> results[2];
+        const util::SRGBConversion methods[2] = { util::SRGBConversion::kExact, util::SRGBConversion::kLookupTable };
+        for (int method = 0; method < 2; ++method) {
+            constexpr int kRuns = 3;
+            seconds[method] = std::numeric_limits<float>::max();
+            for (int run = 0; run < kRuns; ++run) {
+                results[method] = source;
+                util::Timer timer(true);
+                util::convertSRGBToLinear(results[method].data(), pixelCount, channelCount, methods[method]);
+                seconds[method] = std::min(seconds[method], timer.stop());
+            }
+        }
+        CHECK(results[0] == results[1]);
+
+        const double megabytes = double(source.size()) / (1024.0 * 1024.0);
+        printf("  %d channel(s): powf %.1f MB/s, lookup table %.1f MB/s (%.1fx)\n", channelCount, megabytes / seconds[0],
+               megabytes / seconds[1], seconds[0] / seconds[1]);
+    }
+
+    return test::finish();
+}
@@ -0,0 +1,72 @@
+#include "TestHarness.h"
+
+#include <Utility/TextureLoader.h>
+
+#include <cmath>
+#include <vector>
+
+namespace {
+
+// The conversion TextureLoader used before the lookup table was added, evaluated with powf for every channel.
+uint8_t referenceSRGBToLinear(uint8_t value)
+{
+    float channelData = float(value) / 255.0f;
+    if (channelData <= 0.04045f) {
+        channelData /= 12.92f;
+    } else {
+        channelData = powf((channelData + 0.055f) / (1.0f + 0.055f), 2.4f);
+    }
+    return uint8_t(channelData * 255.0f);
+}
+
+// Every byte value appears in every channel of the buffer.
+std::vector<uint8_t> allByteValues(int channelCount)
+{
+    std::vector<uint8_t> pixels(256 * size_t(channelCount));
+    for (size_t ii = 0; ii < pixels.size(); ++ii) {
+        pixels[ii] = uint8_t(ii / size_t(channelCount) + ii % size_t(channelCount) * 67);
+    }
+    return pixels;
+}
+
+void testMethodsMatchReference(int channelCount)
+{
+    const std::vector<uint8_t> source = allByteValues(channelCount);
+    std::vector<uint8_t> table = source;
+    std::vector<uint8_t> exact = source;
+    util::convertSRGBToLinear(table.data(), 256, channelCount, util::SRGBConversion::kLookupTable);
+    util::convertSRGBToLinear(exact.data(), 256, channelCount, util::SRGBConversion::kExact);
+    CHECK(table == exact);
+
+    // Only the color channels are converted, a fourth channel is alpha.
+    bool matchesReference = true;
+    for (size_t ii = 0; ii < source.size(); ++ii) {
+        const bool isAlpha = (ii % size_t(channelCount)) == 3;
+        const uint8_t expected = isAlpha ? source[ii] : referenceSRGBToLinear(source[ii]);
+        matchesReference = matchesReference && (table[ii] == expected);
+    }
+    CHECK(matchesReference);
+}
+
+void testEndpoints()
+{
+    uint8_t pixels[3] = { 0, 10, 255 };
+    util::convertSRGBToLinear(pixels, 1, 3);
+    CHECK(pixels[0] == 0);
+    CHECK(pixels[1] == referenceSRGBToLinear(10));
+    CHECK(pixels[2] == 255);
+}
+
+} // namespace.
+
+int main(int, char**)
+{
+    test::init();
+
+    for (int channelCount = 1; channelCount <= 4; ++channelCount) {
+        testMethodsMatchReference(channelCount);
+    }
+    testEndpoints();
+
+    return test::finish();
+}
@@ -0,0 +1,114 @@
+#include "SyntheticScene.h"
+#include "TestHarness.h"
+
+#include <HeatrayRenderer/Scene/GltfMeshProvider.h>
+#include <HeatrayRenderer/Scene/SceneCacheMeshProvider.h>
+#include <Utility/Hash.h>
+#include <Utility/MappedFile.h>
+#include <Utility/Timer.h>
+
+#include <algorithm>
+#include <filesystem>
+#include <limits>
+#include <stdlib.h>
+#include <vector>
+
+namespace {
+
+uint64_t sceneKey(const std::string& path)
+{
+    return SceneCacheMeshProvider::cacheKey(path, 0, false, VertexLayout::kInterleaved, VertexFormat::kFloat, MeshOptimization::kNone);
+}
+
+// Reads every buffer the way Mesh does when uploading them.
+size_t fillAll(MeshProvider& provider)
+{
+    std::vector<uint8_t> data;
+    size_t bytes = 0;
+    for (size_t ii = 0; ii < provider.GetVertexBufferCount(); ++ii) {
+        data.resize(provider.GetVertexBufferSize(ii));
+        provider.FillVertexBuffer(ii, data.data());
+        bytes += data.size();
+    }
+    for (size_t ii = 0; ii < provider.GetIndexBufferCount(); ++ii) {
+        data.resize(provider.GetIndexBufferSize(ii));
+        provider.FillIndexBuffer(ii, data.data());
+        bytes += data.size();
+    }
+    return bytes;
+}
+
+} // namespace.
+
+// Cold loads import the asset and write the scene cache, warm loads check the
+// key and read everything back from the cache. Also compares checking the key
+// against hashing the contents of the asset and its buffer.
+int main(int argc, char** argv)
+{
+#if defined(__linux__)
+    setenv("XDG_CACHE_HOME", (std::filesystem::current_path() / "SceneCacheBenchmarkCache").string().c_str(), 1);
+#endif
+    test::init();
+
+    test::SyntheticSceneDesc desc;
+    desc.meshCount = std::max<size_t>(size_t(2000 * test::benchmarkScale(argc, argv)), 1);
+    desc.gridSize = 16;
+    const std::string path = "SceneCacheBenchmark.gltf";
+    const std::string binPath = "SceneCacheBenchmark.bin";
+    const test::SyntheticSceneStats stats = test::writeSyntheticScene(path, desc);
+    const std::string cachePath = SceneCacheMeshProvider::cachePath(path);
+
+    constexpr int kRuns = 3;
+    float coldTime = std::numeric_limits<float>::max();
+    float warmTime = std::numeric_limits<float>::max();
+    float keyTime = std::numeric_limits<float>::max();
+    float contentHashTime = std::numeric_limits<float>::max();
+    size_t bytes = 0;
+    for (int run = 0; run < kRuns; ++run) {
+        std::filesystem::remove(cachePath);
+
+        util::Timer timer(true);
+        {
+            GltfMeshProvider source(path);
+            CHECK(source.open(path, false));
+            CHECK(SceneCacheMeshProvider::write(cachePath, sceneKey(path), path, { binPath }, source, source.materialRecords(),
+                                                source.lightRecords(), source.sceneAABB()));
+            bytes = fillAll(source);
+        }
+        coldTime = std::min(coldTime, timer.stop());
+
+        timer.start();
+        {
+            SceneCacheMeshProvider cache(path);
+            CHECK(cache.open(cachePath, sceneKey(path)));
+            CHECK(cache.GetSubmeshCount() == stats.nodeCount);
+            CHECK(fillAll(cache) == bytes);
+        }
+        warmTime = std::min(warmTime, timer.stop());
+
+        timer.start();
+        CHECK(sceneKey(path) != 0);
+        keyTime = std::min(keyTime, timer.stop());
+
+        timer.start();
+        uint64_t hash = 0;
+        for (const std::string& file : { path, binPath }) {
+            util::MappedFile mapped;
+            CHECK(mapped.open(file));
+            hash = util::hashCombine(hash, util::FNV1a(reinterpret_cast<const char*>(mapped.data()), mapped.size()));
+        }
+        CHECK(hash != 0);
+        contentHashTime = std::min(contentHashTime, timer.stop());
+    }
+
+    printf("%zu meshes, %zu triangles, %.2f MB of geometry\n", stats.meshCount, stats.triangleCount, double(bytes) / (1024.0 * 1024.0));
+    printf("  Cold load (import + write cache): %.3f s\n", coldTime);
+    printf("  Warm load (read cache):           %.3f s\n", warmTime);
+    printf("  Cache key:                        %.6f s\n", keyTime);
+    printf("  Hashing the asset contents:       %.6f s\n", contentHashTime);
+
+    std::filesystem::remove(cachePath);
+    std::filesystem::remove(path);
+    std::filesystem::remove(binPath);
+    return test::finish();
+}
@@ -0,0 +1,247 @@
+#include "SyntheticScene.h"
+#include "TestHarness.h"
+
+#include <HeatrayRenderer/Scene/GltfMeshProvider.h>
+#include <HeatrayRenderer/Scene/SceneCacheMeshProvider.h>
+#include <Utility/FileIO.h>
+
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <stdlib.h>
+#include <vector>
+
+namespace {
+
+const std::string kAssetPath = "SceneCacheTest.gltf";
+const std::string kBinPath = "SceneCacheTest.bin";
+
+uint64_t sceneKey(const std::string& path)
+{
+    return SceneCacheMeshProvider::cacheKey(path, 0, false, VertexLayout::kInterleaved, VertexFormat::kFloat, MeshOptimization::kNone);
+}
+
+std::vector<uint8_t> providerData(MeshProvider& provider)
+{
+    std::vector<uint8_t> data;
+    for (size_t ii = 0; ii < provider.GetVertexBufferCount(); ++ii) {
+        const size_t offset = data.size();
+        data.resize(offset + provider.GetVertexBufferSize(ii));
+        provider.FillVertexBuffer(ii, data.data() + offset);
+    }
+    for (size_t ii = 0; ii < provider.GetIndexBufferCount(); ++ii) {
+        const size_t offset = data.size();
+        data.resize(offset + provider.GetIndexBufferSize(ii));
+        provider.FillIndexBuffer(ii, data.data() + offset);
+    }
+    return data;
+}
+
+// Moves the modification time of 'path' forward without changing its contents.
+void touch(const std::string& path)
+{
+    std::filesystem::last_write_time(path, std::filesystem::last_write_time(path) + std::chrono::seconds(2));
+}
+
+// Imports the synthetic scene and writes its cache, returning the cache path.
+std::string writeCache(const std::vector<MaterialRecord>* materials = nullptr)
+{
+    GltfMeshProvider source(kAssetPath);
+    CHECK(source.open(kAssetPath, false));
+
+    const std::string cachePath = SceneCacheMeshProvider::cachePath(kAssetPath);
+    CHECK(SceneCacheMeshProvider::write(cachePath, sceneKey(kAssetPath), kAssetPath, { kBinPath }, source,
+                                        materials ? *materials : source.materialRecords(), source.lightRecords(), source.sceneAABB()));
+    return cachePath;
+}
+
+void testCacheMatchesImport()
+{
+    GltfMeshProvider source(kAssetPath);
+    CHECK(source.open(kAssetPath, false));
+    const std::string cachePath = writeCache();
+
+    SceneCacheMeshProvider cache(kAssetPath);
+    CHECK(cache.open(cachePath, sceneKey(kAssetPath)));
+    CHECK(cache.GetSubmeshCount() == source.GetSubmeshCount());
+    CHECK(providerData(cache) == providerData(source));
+    CHECK(cache.materialRecords().size() == source.materialRecords().size());
+    CHECK(cache.sceneAABB().min == source.sceneAABB().min);
+    CHECK(cache.sceneAABB().max == source.sceneAABB().max);
+}
+
+void testCacheLocation()
+{
+    // Caches never end up next to the asset.
+    const std::string cachePath = SceneCacheMeshProvider::cachePath(kAssetPath);
+    CHECK(cachePath.rfind(util::userCacheDirectory(), 0) == 0);
+    CHECK(std::filesystem::path(cachePath).extension() == SceneCacheMeshProvider::kFileExtension);
+    CHECK(cachePath == SceneCacheMeshProvider::cachePath(std::filesystem::absolute(kAssetPath).string()));
+
+    // Assets with the same name in different directories get different caches.
+    CHECK(cachePath != SceneCacheMeshProvider::cachePath("Other/" + kAssetPath));
+    CHECK(SceneCacheMeshProvider::cachePath(kAssetPath, ".hrlod") != cachePath);
+}
+
+void testKey()
+{
+    const uint64_t key = sceneKey(kAssetPath);
+    CHECK(key != 0);
+    CHECK(key == sceneKey(kAssetPath));
+    CHECK(sceneKey("Missing.gltf") == 0);
+
+    // Every import setting is part of the key.
+    CHECK(key != SceneCacheMeshProvider::cacheKey(kAssetPath, 1, false, VertexLayout::kInterleaved, VertexFormat::kFloat, MeshOptimization::kNone));
+    CHECK(key != SceneCacheMeshProvider::cacheKey(kAssetPath, 0, true, VertexLayout::kInterleaved, VertexFormat::kFloat, MeshOptimization::kNone));
+    CHECK(key != SceneCacheMeshProvider::cacheKey(kAssetPath, 0, false, VertexLayout::kSeparate, VertexFormat::kFloat, MeshOptimization::kNone));
+    CHECK(key != SceneCacheMeshProvider::cacheKey(kAssetPath, 0, false, VertexLayout::kInterleaved, VertexFormat::kCompact, MeshOptimization::kNone));
+    CHECK(key != SceneCacheMeshProvider::cacheKey(kAssetPath, 0, false, VertexLayout::kInterleaved, VertexFormat::kFloat, MeshOptimization::kVertexCache));
+}
+
+void testAssetChangeInvalidatesCache()
+{
+    const std::string cachePath = writeCache();
+    const uint64_t key = sceneKey(kAssetPath);
+
+    touch(kAssetPath);
+    CHECK(sceneKey(kAssetPath) != key);
+    SceneCacheMeshProvider cache(kAssetPath);
+    CHECK(!cache.open(cachePath, sceneKey(kAssetPath)));
+}
+
+void testBufferChangeInvalidatesCache()
+{
+    const std::string cachePath = writeCache();
+
+    // The key only covers the asset itself, the .bin is checked when the cache is opened.
+    touch(kBinPath);
+    SceneCacheMeshProvider cache(kAssetPath);
+    CHECK(!cache.open(cachePath, sceneKey(kAssetPath)));
+
+    SceneCacheMeshProvider rewritten(kAssetPath);
+    CHECK(rewritten.open(writeCache(), sceneKey(kAssetPath)));
+}
+
+void testTextureChangeInvalidatesCache()
+{
+    const std::string texturePath = "SceneCacheTestAlbedo.png";
+    std::filesystem::remove(texturePath);
+
+    GltfMeshProvider source(kAssetPath);
+    CHECK(source.open(kAssetPath, false));
+    std::vector<MaterialRecord> materials = source.materialRecords();
+    CHECK(!materials.empty());
+    materials[0].textures.push_back({ MaterialRecord::TextureSlot::kBaseColor, texturePath, true });
+
+    // A texture that is missing when the cache is written invalidates it once it shows up.
+    std::string cachePath = writeCache(&materials);
+    {
+        SceneCacheMeshProvider cache(kAssetPath);
+        CHECK(cache.open(cachePath, sceneKey(kAssetPath)));
+        CHECK(cache.materialRecords()[0].textures.size() == 1);
+    }
+    std::ofstream(texturePath) << "not really a png";
+    {
+        SceneCacheMeshProvider cache(kAssetPath);
+        CHECK(!cache.open(cachePath, sceneKey(kAssetPath)));
+    }
+
+    cachePath = writeCache(&materials);
+    touch(texturePath);
+    {
+        SceneCacheMeshProvider cache(kAssetPath);
+        CHECK(!cache.open(cachePath, sceneKey(kAssetPath)));
+    }
+    std::filesystem::remove(texturePath);
+}
+
+// One triangle whose submesh can be given ranges that do not fit its buffers.
+class TriangleProvider : public MeshProvider
+{
+public:
+    TriangleProvider() : MeshProvider("Triangle")
+    {
+        m_submesh.vertexAttributeCount = 1;
+        m_submesh.vertexAttributes[0].componentCount = 3;
+        m_submesh.vertexAttributes[0].size = sizeof(float);
+        m_submesh.vertexAttributes[0].buffer = 0;
+        m_submesh.vertexAttributes[0].stride = 3 * sizeof(float);
+        m_submesh.elementCount = 3;
+    }
+
+    size_t GetVertexBufferCount() override { return 1; }
+    size_t GetVertexBufferSize(size_t) override { return 9 * sizeof(float); }
+    void FillVertexBuffer(size_t, uint8_t* buffer) override { std::fill_n(buffer, GetVertexBufferSize(0), uint8_t(0)); }
+    size_t GetIndexBufferCount() override { return 1; }
+    size_t GetIndexBufferSize(size_t) override { return 3 * sizeof(uint32_t); }
+    void FillIndexBuffer(size_t, uint8_t* buffer) override { std::fill_n(buffer, GetIndexBufferSize(0), uint8_t(0)); }
+    size_t GetSubmeshCount() override { return 1; }
+    Submesh GetSubmesh(size_t) override { return m_submesh; }
+
+    Submesh m_submesh;
+};
+
+bool openTriangleCache(const TriangleProvider& provider)
+{
+    const std::string cachePath = SceneCacheMeshProvider::cachePath(kAssetPath);
+    TriangleProvider source = provider;
+    CHECK(SceneCacheMeshProvider::write(cachePath, sceneKey(kAssetPath), kAssetPath, {}, source, {}, {}, util::AABB()));
+
+    SceneCacheMeshProvider cache(kAssetPath);
+    return cache.open(cachePath, sceneKey(kAssetPath));
+}
+
+void testOutOfRangeSubmeshesAreRejected()
+{
+    CHECK(openTriangleCache(TriangleProvider()));
+
+    TriangleProvider tooManyIndices;
+    tooManyIndices.m_submesh.elementCount = 4;
+    CHECK(!openTriangleCache(tooManyIndices));
+
+    TriangleProvider indexOffsetPastEnd;
+    indexOffsetPastEnd.m_submesh.indexOffset = sizeof(uint32_t);
+    CHECK(!openTriangleCache(indexOffsetPastEnd));
+
+    TriangleProvider attributePastEnd;
+    attributePastEnd.m_submesh.vertexAttributes[0].offset = 7 * sizeof(float);
+    CHECK(!openTriangleCache(attributePastEnd));
+
+    TriangleProvider overlappingStride;
+    overlappingStride.m_submesh.vertexAttributes[0].stride = sizeof(float);
+    CHECK(!openTriangleCache(overlappingStride));
+
+    TriangleProvider missingBuffer;
+    missingBuffer.m_submesh.vertexAttributes[0].buffer = 1;
+    CHECK(!openTriangleCache(missingBuffer));
+}
+
+} // namespace.
+
+int main(int, char**)
+{
+#if defined(__linux__)
+    // Keep the caches written by the test out of the user's cache directory.
+    setenv("XDG_CACHE_HOME", (std::filesystem::current_path() / "SceneCacheTestCache").string().c_str(), 1);
+#endif
+    test::init();
+
+    test::SyntheticSceneDesc desc;
+    desc.meshCount = 4;
+    desc.instancesPerMesh = 2;
+    test::writeSyntheticScene(kAssetPath, desc);
+
+    testCacheMatchesImport();
+    testCacheLocation();
+    testKey();
+    testAssetChangeInvalidatesCache();
+    testBufferChangeInvalidatesCache();
+    testTextureChangeInvalidatesCache();
+    testOutOfRangeSubmeshesAreRejected();
+
+    std::filesystem::remove(SceneCacheMeshProvider::cachePath(kAssetPath));
+    std::filesystem::remove(kAssetPath);
+    std::filesystem::remove(kBinPath);
+    return test::finish();
+}
@@ -0,0 +1,92 @@
+#include "TestHarness.h"
+
+#include <Utility/ShaderCodeLoader.h>
+#include <Utility/Timer.h>
+
+#include <algorithm>
+#include <filesystem>
+#include <limits>
+#include <stdlib.h>
+#include <string>
+#include <vector>
+
+// Time spent preprocessing Heatray's shaders at startup without the disk
+// cache, with it, and for loads that hit the in-memory cache.
+
+namespace {
+
+const std::string kDirectory = "ShaderCacheBenchmarkFiles";
+
+// Best time of loading every shader in 'shaders' 'repeat' times, after calling 'prepare' before each run.
+template <typename Prepare>
+float loadAll(const std::vector<std::string>& shaders, size_t repeat, Prepare&& prepare, size_t& lineCount)
+{
+    constexpr int kRuns = 5;
+    float bestSeconds = std::numeric_limits<float>::max();
+    for (int run = 0; run < kRuns; ++run) {
+        prepare();
+        lineCount = 0;
+        util::Timer timer(true);
+        for (size_t ii = 0; ii < repeat; ++ii) {
+            for (const std::string& shader : shaders) {
+                std::vector<std::string> sourceCode;
+                CHECK(util::loadShaderSourceFile(shader, sourceCode));
+                for (const std::string& code : sourceCode) {
+                    lineCount += size_t(std::count(code.begin(), code.end(), '\n'));
+                }
+            }
+        }
+        bestSeconds = std::min(bestSeconds, timer.stop());
+    }
+    return bestSeconds;
+}
+
+} // namespace.
+
+int main(int argc, char** argv)
+{
+    const std::filesystem::path workingDirectory = std::filesystem::current_path();
+    std::filesystem::remove_all(kDirectory);
+    std::filesystem::create_directories(kDirectory + "/Resources");
+#if defined(__linux__)
+    setenv("XDG_CACHE_HOME", (workingDirectory / kDirectory / "cache").string().c_str(), 1);
+#endif
+    test::init();
+
+    // Work on a copy of the shaders so that the benchmark can be run from anywhere.
+    std::filesystem::copy(HEATRAY_SHADER_DIRECTORY, kDirectory + "/Resources/shaders", std::filesystem::copy_options::recursive);
+    std::filesystem::current_path(kDirectory);
+    std::vector<std::string> shaders;
+    for (const auto& entry : std::filesystem::directory_iterator("Resources/shaders")) {
+        if (entry.path().extension() == ".rlsl") {
+            shaders.push_back(entry.path().filename().string());
+        }
+    }
+    std::sort(shaders.begin(), shaders.end());
+    const size_t repeat = std::max<size_t>(size_t(10 * test::benchmarkScale(argc, argv)), 1);
+
+    size_t coldLines = 0;
+    const float coldSeconds = loadAll(shaders, 1, [] {
+        util::clearShaderSourceCache();
+        std::filesystem::remove(util::shaderCachePath());
+    }, coldLines);
+    util::flushShaderCache();
+
+    size_t warmLines = 0;
+    const float warmSeconds = loadAll(shaders, 1, [] { util::clearShaderSourceCache(); }, warmLines);
+    CHECK(warmLines == coldLines);
+
+    size_t memoryLines = 0;
+    const float memorySeconds = loadAll(shaders, repeat, [] {}, memoryLines) / float(repeat);
+
+    printf("%zu shaders, %zu preprocessed lines\n", shaders.size(), coldLines);
+    printf("  Preprocessing from source: %.3f ms\n", coldSeconds * 1000.0f);
+    printf("  From the disk cache      : %.3f ms\n", warmSeconds * 1000.0f);
+    printf("  From the memory cache    : %.3f ms\n", memorySeconds * 1000.0f);
+
+    std::filesystem::remove(util::shaderCachePath());
+    std::filesystem::current_path(workingDirectory);
+    std::filesystem::remove_all(kDirectory);
+
+    return test::finish();
+}
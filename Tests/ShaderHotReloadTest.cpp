@@ -0,0 +1,198 @@
+#include "MockOpenRL.h"
+#include "TestHarness.h"
+
+#include <HeatrayRenderer/Lights/DirectionalLight.h>
+#include <HeatrayRenderer/Lights/PointLight.h>
+#include <HeatrayRenderer/Materials/GlassMaterial.h>
+#include <HeatrayRenderer/Scene/Lighting.h>
+#include <Utility/ShaderCodeLoader.h>
+
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <stdlib.h>
+#include <string>
+#include <vector>
+
+// Edits shaders the way PassGenerator::reloadShaders() reacts to them:
+// the changed files are invalidated and the materials and lights built from
+// the affected shaders are rebuilt, against the mocked OpenRL compiler.
+
+namespace {
+
+const std::string kDirectory = "ShaderHotReloadTestFiles";
+const std::string kCompileError = "COMPILE_ERROR";
+const std::string kLinkError = "LINK_ERROR";
+
+void writeShader(const std::string& name, const std::string& source)
+{
+    std::ofstream("Resources/shaders/" + name, std::ios::trunc) << source;
+}
+
+void testInvalidateShaderSources()
+{
+    std::vector<std::string> sourceCode;
+    CHECK(util::loadShaderSourceFile("glass.rlsl", sourceCode));
+    CHECK(util::loadShaderSourceFile("vertex.rlsl", sourceCode));
+    CHECK(util::loadShaderSourceFile("pointLight.rlsl", sourceCode));
+
+    // Every shader that includes a changed file directly or through another include is reported, once.
+    std::vector<std::string> affected = util::invalidateShaderSources({ "common.rlsl", "brdf.rlsl" });
+    std::sort(affected.begin(), affected.end());
+    CHECK((affected == std::vector<std::string>{ "glass.rlsl", "pointLight.rlsl" }));
+
+    // Invalidated shaders are no longer known until they are loaded again.
+    CHECK(util::invalidateShaderSources({ "common.rlsl" }).empty());
+    CHECK(util::invalidateShaderSources({ "vertex.rlsl" }) == std::vector<std::string>{ "vertex.rlsl" });
+    CHECK(util::invalidateShaderSources({ "unknown.rlsl" }).empty());
+}
+
+void testFailedRebuildKeepsProgram()
+{
+    test::MockOpenRL& mock = test::MockOpenRL::instance();
+    mock.setFailureMarkers(kCompileError, kLinkError);
+
+    GlassMaterial material("Glass");
+    material.build();
+    const std::shared_ptr<openrl::Program> program = material.program();
+    const std::shared_ptr<openrl::Buffer> uniformBlock = material.uniformBlock();
+    CHECK(program && uniformBlock);
+
+    // A typo in an include: the shader fails to compile, no assert fires and the material keeps what it had.
+    writeShader("brdf.rlsl", "float brdf() { " + kCompileError + " }\n");
+    CHECK(util::invalidateShaderSources({ "brdf.rlsl" }) == std::vector<std::string>{ "glass.rlsl" });
+    mock.reset();
+    CHECK(!material.rebuild());
+    CHECK(mock.calls("rlCompileShader") == 2);
+    CHECK(mock.calls("rlLinkProgram") == 0);
+    CHECK(material.program() == program);
+    CHECK(material.uniformBlock() == uniformBlock);
+
+    // The same for a program that compiles but doesn't link.
+    writeShader("brdf.rlsl", "float brdf() { " + kLinkError + " }\n");
+    util::invalidateShaderSources({ "brdf.rlsl" });
+    mock.reset();
+    CHECK(!material.rebuild());
+    CHECK(mock.calls("rlLinkProgram") == 1);
+    CHECK(material.program() == program);
+    CHECK(material.uniformBlock() == uniformBlock);
+
+    // Fixing the shader gives the material a new program.
+    writeShader("brdf.rlsl", "float brdf() { return 0.5; }\n");
+    util::invalidateShaderSources({ "brdf.rlsl" });
+    CHECK(material.rebuild());
+    CHECK(material.program() && (material.program() != program));
+    CHECK(material.uniformBlock() && (material.uniformBlock() != uniformBlock));
+
+    // Nothing changed, so rebuilding again shares the program that was just built.
+    const std::shared_ptr<openrl::Program> rebuiltProgram = material.program();
+    mock.reset();
+    CHECK(material.rebuild());
+    CHECK(material.program() == rebuiltProgram);
+    CHECK(mock.calls("rlCompileShader") == 0);
+
+    mock.setFailureMarkers("", "");
+}
+
+void testFailedBuildReturnsNoProgram()
+{
+    test::MockOpenRL& mock = test::MockOpenRL::instance();
+    mock.setFailureMarkers(kCompileError, kLinkError);
+
+    writeShader("broken.rlsl", "void main() { " + kCompileError + " }\n");
+    CHECK(util::buildProgram("vertex.rlsl", "broken.rlsl", "Broken") == nullptr);
+    CHECK(util::buildSharedProgram("vertex.rlsl", "broken.rlsl", "Broken") == nullptr);
+
+    writeShader("broken.rlsl", "void main() { " + kLinkError + " }\n");
+    util::invalidateShaderSources({ "broken.rlsl" });
+    CHECK(util::buildSharedProgram("vertex.rlsl", "broken.rlsl", "Broken") == nullptr);
+
+    // Failed programs are not remembered, the next attempt builds the program again.
+    writeShader("broken.rlsl", "void main() {}\n");
+    util::invalidateShaderSources({ "broken.rlsl" });
+    mock.reset();
+    CHECK(util::buildSharedProgram("vertex.rlsl", "broken.rlsl", "Broken") != nullptr);
+    CHECK(mock.calls("rlLinkProgram") == 1);
+
+    mock.setFailureMarkers("", "");
+}
+
+void testLightsAreRebuilt()
+{
+    test::MockOpenRL& mock = test::MockOpenRL::instance();
+    mock.setFailureMarkers(kCompileError, kLinkError);
+    mock.setActiveUniforms({ "lightIndex" }, {});
+
+    Lighting lighting;
+    size_t lightsSetUp = 0;
+    lighting.installLightCreatedCallback([&lightsSetUp](std::shared_ptr<Light>) { ++lightsSetUp; });
+    std::shared_ptr<DirectionalLight> directionalLight = lighting.addDirectionalLight("Directional");
+    std::shared_ptr<PointLight> pointLight = lighting.addPointLight("Point");
+    CHECK(directionalLight && pointLight && (lightsSetUp == 2));
+    const std::shared_ptr<openrl::Program> directionalProgram = directionalLight->program();
+    const std::shared_ptr<openrl::Program> program = pointLight->program();
+    std::shared_ptr<openrl::Primitive> primitive = pointLight->primitive();
+
+    // A broken edit leaves the light as it was.
+    writeShader("pointLight.rlsl", "void main() { " + kCompileError + " }\n");
+    std::vector<std::string> shaders = util::invalidateShaderSources({ "pointLight.rlsl" });
+    CHECK(shaders == std::vector<std::string>{ "pointLight.rlsl" });
+    lighting.reloadShaders(shaders);
+    CHECK((pointLight->program() == program) && (pointLight->primitive() == primitive));
+    CHECK(lightsSetUp == 2);
+
+    // Only the light built from the edited shader gets a new program and primitive, set up like a newly added light.
+    writeShader("pointLight.rlsl", "#include \"brdf.rlsl\"\nvoid main() { accumulate(vec3(2.0 * brdf())); }\n");
+    shaders = util::invalidateShaderSources({ "pointLight.rlsl" });
+    const size_t livePrimitives = mock.livePrimitives();
+    mock.reset();
+    lighting.reloadShaders(shaders);
+    CHECK(pointLight->program() && (pointLight->program() != program));
+    CHECK(pointLight->primitive() && (pointLight->primitive() != primitive));
+    CHECK(directionalLight->program() == directionalProgram);
+    CHECK(mock.calls("rlUniform1i") == 1); // The light index.
+    CHECK(mock.calls("rlMapBuffer") == 1); // The point light buffer, which now refers to the new primitive.
+    CHECK(lightsSetUp == 3);
+
+    // The light no longer holds on to the previous primitive.
+    primitive.reset();
+    CHECK(mock.livePrimitives() == livePrimitives);
+
+    mock.setActiveUniforms({}, {});
+    mock.setFailureMarkers("", "");
+}
+
+} // namespace.
+
+int main(int, char**)
+{
+    const std::filesystem::path workingDirectory = std::filesystem::current_path();
+    std::filesystem::remove_all(kDirectory);
+    std::filesystem::create_directories(kDirectory + "/Resources/shaders");
+#if defined(__linux__)
+    // Keep the cache written by the test out of the user's cache directory.
+    setenv("XDG_CACHE_HOME", (workingDirectory / kDirectory / "cache").string().c_str(), 1);
+#endif
+    test::init();
+
+    // The shader loader reads from Resources/shaders/ below the working directory.
+    std::filesystem::current_path(kDirectory);
+    writeShader("brdf.rlsl", "float brdf() { return 1.0; }\n");
+    writeShader("common.rlsl", "#include \"brdf.rlsl\"\nvec3 shade() { return vec3(brdf()); }\n");
+    writeShader("vertex.rlsl", "attribute vec3 position;\nvoid main() { rl_Position = vec4(position, 1.0); }\n");
+    writeShader("glass.rlsl", "#include \"common.rlsl\"\nvoid main() { accumulate(shade()); }\n");
+    writeShader("pointLight.rlsl", "#include \"brdf.rlsl\"\nvoid main() { accumulate(vec3(brdf())); }\n");
+    writeShader("directionalLight.rlsl", "void main() { accumulate(vec3(1.0)); }\n");
+    writeShader("passthrough.rlsl", "void main() {}\n");
+
+    testInvalidateShaderSources();
+    testFailedRebuildKeepsProgram();
+    testFailedBuildReturnsNoProgram();
+    testLightsAreRebuilt();
+
+    std::filesystem::current_path(workingDirectory);
+    std::filesystem::remove_all(kDirectory);
+
+    return test::finish();
+}
@@ -0,0 +1,114 @@
+#include "MockOpenRL.h"
+#include "TestHarness.h"
+
+#include <Utility/ShaderCodeLoader.h>
+
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Builds the programs of many materials through util::buildSharedProgram()
+// against the mocked OpenRL compiler and counts how often it was invoked.
+
+namespace {
+
+const std::string kDirectory = "ShaderProgramCacheTestFiles";
+
+void writeShader(const std::string& name, const std::string& source)
+{
+    std::ofstream("Resources/shaders/" + name, std::ios::trunc) << source;
+}
+
+// Define prefix of a material, the way PhysicallyBasedMaterial builds it from the textures it has.
+std::string prefix(size_t variant)
+{
+    std::string result;
+    if (variant & 1) {
+        result += "#define HAS_BASE_COLOR_TEXTURE\n";
+    }
+    if (variant & 2) {
+        result += "#define HAS_NORMALMAP\n";
+    }
+    return result;
+}
+
+void testMaterialsShareVariants()
+{
+    test::MockOpenRL& mock = test::MockOpenRL::instance();
+    mock.reset();
+
+    // 1000 materials with 4 distinct define sets.
+    constexpr size_t kMaterialCount = 1000;
+    constexpr size_t kVariantCount = 4;
+    std::vector<std::shared_ptr<openrl::Program>> programs;
+    for (size_t ii = 0; ii < kMaterialCount; ++ii) {
+        programs.push_back(util::buildSharedProgram("vertex.rlsl", "ray.rlsl", "Material " + std::to_string(ii), prefix(ii % kVariantCount)));
+        CHECK(programs.back());
+    }
+
+    // A vertex and a ray shader per variant.
+    CHECK(mock.calls("rlCompileShader") == 2 * kVariantCount);
+    CHECK(mock.calls("rlLinkProgram") == kVariantCount);
+    CHECK(mock.livePrograms() == kVariantCount);
+
+    for (size_t ii = 0; ii < kMaterialCount; ++ii) {
+        CHECK(programs[ii] == programs[ii % kVariantCount]);
+    }
+    for (size_t ii = 1; ii < kVariantCount; ++ii) {
+        CHECK(programs[ii] != programs[0]);
+    }
+
+    // Unshared programs are always compiled.
+    mock.reset();
+    std::shared_ptr<openrl::Program> unshared = util::buildProgram("vertex.rlsl", "ray.rlsl", "Unshared", prefix(0));
+    CHECK(unshared && (unshared != programs[0]));
+    CHECK(mock.calls("rlCompileShader") == 2);
+}
+
+void testReleasedProgramsArePruned()
+{
+    test::MockOpenRL& mock = test::MockOpenRL::instance();
+    const size_t livePrograms = mock.livePrograms();
+    {
+        std::vector<std::shared_ptr<openrl::Program>> programs;
+        for (size_t ii = 0; ii < 16; ++ii) {
+            programs.push_back(util::buildSharedProgram("vertex.rlsl", "ray.rlsl", "Scene A", "#define VARIANT " + std::to_string(ii) + "\n"));
+        }
+        CHECK(mock.livePrograms() == livePrograms + 16);
+        CHECK(util::sharedProgramCacheSize() >= 16);
+    }
+    CHECK(mock.livePrograms() == livePrograms);
+
+    // A released program is built again rather than resurrected.
+    mock.reset();
+    std::shared_ptr<openrl::Program> program = util::buildSharedProgram("vertex.rlsl", "ray.rlsl", "Scene B", "#define VARIANT 0\n");
+    CHECK(program && (mock.calls("rlLinkProgram") == 1));
+
+    // Building it dropped the entries of every released program, only the new one is left.
+    CHECK(util::sharedProgramCacheSize() == 1);
+}
+
+} // namespace.
+
+int main(int, char**)
+{
+    test::init();
+
+    // The shader loader reads from Resources/shaders/ below the working directory.
+    const std::filesystem::path workingDirectory = std::filesystem::current_path();
+    std::filesystem::create_directories(kDirectory + "/Resources/shaders");
+    std::filesystem::current_path(kDirectory);
+    writeShader("common.rlsl", "vec3 shade() { return vec3(1.0); }\n");
+    writeShader("vertex.rlsl", "attribute vec3 position;\nvoid main() { rl_Position = vec4(position, 1.0); }\n");
+    writeShader("ray.rlsl", "#include \"common.rlsl\"\nvoid main() { accumulate(shade()); }\n");
+
+    testMaterialsShareVariants();
+    testReleasedProgramsArePruned();
+
+    std::filesystem::current_path(workingDirectory);
+    std::filesystem::remove_all(kDirectory);
+
+    return test::finish();
+}
@@ -0,0 +1,201 @@
+#include "TestHarness.h"
+
+#include <Utility/FileIO.h>
+#include <Utility/ShaderCodeLoader.h>
+
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <stdlib.h>
+#include <string>
+#include <vector>
+
+// Checks when the disk cache of preprocessed shaders is written, reused and
+// invalidated. util::clearShaderSourceCache() stands in for restarting
+// Heatray between loads.
+
+namespace {
+
+const std::string kDirectory = "ShaderSourceCacheTestFiles";
+
+void writeShader(const std::string& name, const std::string& source)
+{
+    std::ofstream("Resources/shaders/" + name, std::ios::trunc) << source;
+}
+
+// Preprocessed source of 'name' in one string, empty if it failed to load. The line of an #include is left empty.
+std::string load(const std::string& name)
+{
+    std::vector<std::string> sourceCode;
+    if (!util::loadShaderSourceFile(name, sourceCode)) {
+        return std::string();
+    }
+    std::string result;
+    for (const std::string& code : sourceCode) {
+        result += code;
+    }
+    return result;
+}
+
+void restart()
+{
+    util::clearShaderSourceCache();
+}
+
+std::filesystem::file_time_type modifiedTime(const std::string& path)
+{
+    return std::filesystem::last_write_time(path);
+}
+
+void testCacheIsOnlyWrittenOnFlush()
+{
+    const std::string cachePath = util::shaderCachePath();
+    CHECK(std::filesystem::path(cachePath).parent_path() == std::filesystem::path(util::userCacheDirectory()));
+    CHECK(!std::filesystem::exists(cachePath));
+
+    CHECK(load("ray.rlsl") == "float shade() { return 1.0; }\n\nvoid main() { shade(); }\n");
+    CHECK(!std::filesystem::exists(cachePath));
+    util::flushShaderCache();
+    CHECK(std::filesystem::exists(cachePath));
+
+    // Nothing is written next to the shaders.
+    for (const auto& entry : std::filesystem::directory_iterator("Resources/shaders")) {
+        CHECK(entry.path().extension() == ".rlsl");
+    }
+
+    // Loading another shader does not touch the file until the next flush.
+    const uintmax_t size = std::filesystem::file_size(cachePath);
+    CHECK(!load("vertex.rlsl").empty());
+    CHECK(std::filesystem::file_size(cachePath) == size);
+    util::flushShaderCache();
+    CHECK(std::filesystem::file_size(cachePath) > size);
+
+    // Flushing without changes does not write anything.
+    const std::filesystem::file_time_type oldTime = modifiedTime(cachePath) - std::chrono::hours(1);
+    std::filesystem::last_write_time(cachePath, oldTime);
+    CHECK(!load("ray.rlsl").empty());
+    util::flushShaderCache();
+    CHECK(modifiedTime(cachePath) == oldTime);
+}
+
+void testUnchangedFilesAreNotRead()
+{
+    restart();
+
+    // An edit that keeps both the size and the modification time goes unnoticed, which shows that the source comes
+    // from the cache without reading the files.
+    const std::filesystem::file_time_type time = modifiedTime("Resources/shaders/common.rlsl");
+    writeShader("common.rlsl", "float shade() { return 2.0; }\n");
+    std::filesystem::last_write_time("Resources/shaders/common.rlsl", time);
+    CHECK(load("ray.rlsl") == "float shade() { return 1.0; }\n\nvoid main() { shade(); }\n");
+
+    writeShader("common.rlsl", "float shade() { return 1.0; }\n");
+    std::filesystem::last_write_time("Resources/shaders/common.rlsl", time);
+}
+
+void testChangedIncludeInvalidates()
+{
+    // A different size.
+    restart();
+    writeShader("common.rlsl", "float shade() { return 10.0; }\n");
+    CHECK(load("ray.rlsl") == "float shade() { return 10.0; }\n\nvoid main() { shade(); }\n");
+    util::flushShaderCache();
+
+    // The same size with a new modification time, caught by the content hash.
+    restart();
+    writeShader("common.rlsl", "float shade() { return 20.0; }\n");
+    std::filesystem::last_write_time("Resources/shaders/common.rlsl", modifiedTime("Resources/shaders/common.rlsl") + std::chrono::seconds(2));
+    CHECK(load("ray.rlsl") == "float shade() { return 20.0; }\n\nvoid main() { shade(); }\n");
+    util::flushShaderCache();
+
+    // The shader itself changes.
+    restart();
+    writeShader("ray.rlsl", "#include \"common.rlsl\"\nvoid main() { shade(); shade(); }\n");
+    CHECK(load("ray.rlsl") == "float shade() { return 20.0; }\n\nvoid main() { shade(); shade(); }\n");
+    util::flushShaderCache();
+}
+
+void testTouchedFileIsRevalidated()
+{
+    // Only the modification time changed: the cached source is still used and the new time is remembered.
+    restart();
+    const std::string cachePath = util::shaderCachePath();
+    const std::filesystem::file_time_type cacheTime = modifiedTime(cachePath) - std::chrono::hours(1);
+    std::filesystem::last_write_time(cachePath, cacheTime);
+    std::filesystem::last_write_time("Resources/shaders/common.rlsl", modifiedTime("Resources/shaders/common.rlsl") + std::chrono::seconds(2));
+    CHECK(load("ray.rlsl") == "float shade() { return 20.0; }\n\nvoid main() { shade(); shade(); }\n");
+    util::flushShaderCache();
+    CHECK(modifiedTime(cachePath) != cacheTime);
+}
+
+void testDeletedIncludeFailsToLoad()
+{
+    restart();
+    std::filesystem::rename("Resources/shaders/common.rlsl", "common.rlsl");
+    CHECK(load("ray.rlsl").empty());
+    std::filesystem::rename("common.rlsl", "Resources/shaders/common.rlsl");
+    CHECK(!load("ray.rlsl").empty());
+    util::flushShaderCache();
+}
+
+void testInvalidateShaderSources()
+{
+    restart();
+    CHECK(!load("ray.rlsl").empty());
+    CHECK(!load("vertex.rlsl").empty());
+
+    // Only the shaders that include the changed file are affected.
+    const std::vector<std::string> affected = util::invalidateShaderSources({ "common.rlsl" });
+    CHECK(affected == std::vector<std::string>{ "ray.rlsl" });
+    CHECK(util::invalidateShaderSources({ "unknown.rlsl" }).empty());
+
+    writeShader("common.rlsl", "float shade() { return 3.0; }\n");
+    CHECK(load("ray.rlsl") == "float shade() { return 3.0; }\n\nvoid main() { shade(); shade(); }\n");
+    CHECK(load("vertex.rlsl") == "void main() {}\n");
+    util::flushShaderCache();
+}
+
+void testCorruptCacheIsIgnored()
+{
+    std::ofstream(util::shaderCachePath(), std::ios::binary | std::ios::trunc) << "HSHDgarbage";
+    restart();
+    CHECK(load("ray.rlsl") == "float shade() { return 3.0; }\n\nvoid main() { shade(); shade(); }\n");
+    util::flushShaderCache();
+
+    restart();
+    CHECK(load("ray.rlsl") == "float shade() { return 3.0; }\n\nvoid main() { shade(); shade(); }\n");
+}
+
+} // namespace.
+
+int main(int, char**)
+{
+    const std::filesystem::path workingDirectory = std::filesystem::current_path();
+    std::filesystem::remove_all(kDirectory);
+    std::filesystem::create_directories(kDirectory + "/Resources/shaders");
+#if defined(__linux__)
+    // Keep the cache written by the test out of the user's cache directory.
+    setenv("XDG_CACHE_HOME", (workingDirectory / kDirectory / "cache").string().c_str(), 1);
+#endif
+    test::init();
+
+    // The shader loader reads from Resources/shaders/ below the working directory.
+    std::filesystem::current_path(kDirectory);
+    writeShader("common.rlsl", "float shade() { return 1.0; }\n");
+    writeShader("ray.rlsl", "#include \"common.rlsl\"\nvoid main() { shade(); }\n");
+    writeShader("vertex.rlsl", "void main() {}\n");
+
+    testCacheIsOnlyWrittenOnFlush();
+    testUnchangedFilesAreNotRead();
+    testChangedIncludeInvalidates();
+    testTouchedFileIsRevalidated();
+    testDeletedIncludeFailsToLoad();
+    testInvalidateShaderSources();
+    testCorruptCacheIsIgnored();
+
+    std::filesystem::remove(util::shaderCachePath());
+    std::filesystem::current_path(workingDirectory);
+    std::filesystem::remove_all(kDirectory);
+
+    return test::finish();
+}
@@ -0,0 +1,134 @@
+#include "TestHarness.h"
+
+#include <Utility/SlotMap.h>
+#include <Utility/Timer.h>
+
+#include <algorithm>
+#include <limits>
+#include <random>
+#include <unordered_map>
+#include <vector>
+
+namespace {
+
+// Roughly what Scene keeps per mesh besides its RL objects.
+struct Payload {
+    float transform[16] = {};
+    uint64_t id = 0;
+};
+
+struct RunResult {
+    float addSeconds = std::numeric_limits<float>::max(); // Best of all runs.
+    float removeSeconds = std::numeric_limits<float>::max();
+    float iterateSeconds = std::numeric_limits<float>::max();
+    uint64_t checksum = 0;
+};
+
+// Adds 'count' elements, removes half of them in random order, adds them back and iterates
+// over everything, through the interface of 'Container'.
+template <typename Container>
+RunResult run(size_t count)
+{
+    constexpr int kRuns = 5;
+    RunResult result;
+    for (int runIndex = 0; runIndex < kRuns; ++runIndex) {
+        Container container;
+        std::vector<typename Container::Handle> handles(count);
+
+        util::Timer timer(true);
+        for (size_t ii = 0; ii < count; ++ii) {
+            handles[ii] = container.add(ii);
+        }
+        result.addSeconds = std::min(result.addSeconds, timer.stop());
+
+        std::vector<size_t> order(count);
+        for (size_t ii = 0; ii < count; ++ii) {
+            order[ii] = ii;
+        }
+        std::shuffle(order.begin(), order.end(), std::mt19937(1));
+        order.resize(count / 2);
+
+        timer.start();
+        for (size_t ii : order) {
+            container.remove(handles[ii]);
+        }
+        for (size_t ii : order) {
+            handles[ii] = container.add(ii);
+        }
+        result.removeSeconds = std::min(result.removeSeconds, timer.stop());
+
+        timer.start();
+        result.checksum = container.checksum();
+        result.iterateSeconds = std::min(result.iterateSeconds, timer.stop());
+    }
+    return result;
+}
+
+struct SlotMapContainer {
+    using Handle = util::SlotMap<Payload>::Handle;
+    util::SlotMap<Payload> map;
+
+    Handle add(uint64_t id)
+    {
+        Payload payload;
+        payload.id = id;
+        return map.emplace(payload);
+    }
+    void remove(Handle handle) { map.erase(handle); }
+    uint64_t checksum() const
+    {
+        uint64_t sum = 0;
+        for (const Payload& payload : map) {
+            sum += payload.id;
+        }
+        return sum;
+    }
+};
+
+// Stable ids without a slot map, e.g. a counter and a hash map.
+struct HashMapContainer {
+    using Handle = uint64_t;
+    std::unordered_map<uint64_t, Payload> map;
+    uint64_t nextHandle = 0;
+
+    Handle add(uint64_t id)
+    {
+        Payload payload;
+        payload.id = id;
+        map.emplace(nextHandle, payload);
+        return nextHandle++;
+    }
+    void remove(Handle handle) { map.erase(handle); }
+    uint64_t checksum() const
+    {
+        uint64_t sum = 0;
+        for (const auto& entry : map) {
+            sum += entry.second.id;
+        }
+        return sum;
+    }
+};
+
+} // namespace.
+
+// Adding and removing meshes through util::SlotMap, which Scene stores its
+// meshes in, against a hash map keyed by a counter.
+int main(int argc, char** argv)
+{
+    test::init();
+
+    const size_t count = std::max<size_t>(size_t(100000 * test::benchmarkScale(argc, argv)), 2);
+    printf("%zu elements of %zu bytes, half of them removed and added back\n", count, sizeof(Payload));
+
+    const RunResult slotMap = run<SlotMapContainer>(count);
+    const RunResult hashMap = run<HashMapContainer>(count);
+    CHECK(slotMap.checksum == hashMap.checksum);
+    CHECK(slotMap.checksum == uint64_t(count) * (count - 1) / 2);
+
+    for (const auto& [name, result] : { std::pair("Slot map", slotMap), std::pair("Hash map", hashMap) }) {
+        printf("  %s: add %.2f ms, remove and re-add %.2f ms, iterate %.3f ms\n", name, result.addSeconds * 1000.0f,
+               result.removeSeconds * 1000.0f, result.iterateSeconds * 1000.0f);
+    }
+
+    return test::finish();
+}
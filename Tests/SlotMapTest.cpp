@@ -0,0 +1,145 @@
+#include "TestHarness.h"
+
+#include <Utility/SlotMap.h>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace {
+
+using Map = util::SlotMap<std::string>;
+
+void testDefaultHandleIsInvalid()
+{
+    Map map;
+    CHECK(!map.contains(Map::Handle()));
+    CHECK(map.get(Map::Handle()) == nullptr);
+
+    map.emplace("first");
+    CHECK(!map.contains(Map::Handle()));
+    CHECK(!map.erase(Map::Handle()));
+    CHECK(map.size() == 1);
+}
+
+void testStaleHandleAfterErase()
+{
+    Map map;
+    const Map::Handle handle = map.emplace("mesh");
+    CHECK(map.contains(handle) && (*map.get(handle) == "mesh"));
+
+    CHECK(map.erase(handle));
+    CHECK(!map.contains(handle));
+    CHECK(map.get(handle) == nullptr);
+    CHECK(!map.erase(handle));
+    CHECK(map.empty());
+}
+
+void testGenerationBumpOnReuse()
+{
+    Map map;
+    const Map::Handle first = map.emplace("first");
+    map.erase(first);
+
+    // The freed slot is reused with a new generation, so the old handle does not alias the new element.
+    const Map::Handle second = map.emplace("second");
+    CHECK(second.index == first.index);
+    CHECK(second.generation == first.generation + 1);
+    CHECK(second != first);
+    CHECK(!map.contains(first));
+    CHECK(map.get(first) == nullptr);
+    CHECK(map.contains(second) && (*map.get(second) == "second"));
+}
+
+void testEraseMovesLastElement()
+{
+    Map map;
+    std::vector<Map::Handle> handles;
+    for (int ii = 0; ii < 5; ++ii) {
+        handles.push_back(map.emplace(std::to_string(ii)));
+    }
+
+    // Erasing from the middle fills the hole with the last element instead of shifting the rest.
+    map.erase(handles[1]);
+    CHECK(map.size() == 4);
+    const std::vector<std::string> expected = { "0", "4", "2", "3" };
+    CHECK(std::vector<std::string>(map.begin(), map.end()) == expected);
+
+    // Every other handle still finds its element, including the one that moved.
+    for (int ii = 0; ii < 5; ++ii) {
+        if (ii != 1) {
+            CHECK(map.get(handles[ii]) && (*map.get(handles[ii]) == std::to_string(ii)));
+        }
+    }
+
+    // Erasing the last element does not move anything.
+    map.erase(handles[3]);
+    const std::vector<std::string> expectedAfterLast = { "0", "4", "2" };
+    CHECK(std::vector<std::string>(map.begin(), map.end()) == expectedAfterLast);
+    CHECK(*map.get(handles[4]) == "4");
+}
+
+void testClear()
+{
+    Map map;
+    std::vector<Map::Handle> handles;
+    for (int ii = 0; ii < 4; ++ii) {
+        handles.push_back(map.emplace(std::to_string(ii)));
+    }
+    map.clear();
+    CHECK(map.empty() && (map.begin() == map.end()));
+    for (const Map::Handle& handle : handles) {
+        CHECK(!map.contains(handle));
+    }
+
+    // Cleared slots are reused with new generations.
+    std::vector<Map::Handle> newHandles;
+    for (int ii = 0; ii < 4; ++ii) {
+        newHandles.push_back(map.emplace("new " + std::to_string(ii)));
+    }
+    for (int ii = 0; ii < 4; ++ii) {
+        CHECK(newHandles[ii].index < 4);
+        CHECK(!map.contains(handles[ii]));
+        CHECK(*map.get(newHandles[ii]) == "new " + std::to_string(ii));
+    }
+}
+
+void testMoveOnlyElementsAreDestroyed()
+{
+    // Elements that own resources (like a Mesh) are moved, never copied, and destroyed when erased.
+    util::SlotMap<std::unique_ptr<int>> map;
+    std::shared_ptr<int> alive = std::make_shared<int>(0);
+    std::weak_ptr<int> watch = alive;
+    struct Owner {
+        std::shared_ptr<int> value;
+    };
+    util::SlotMap<Owner> owners;
+    const auto first = owners.emplace(Owner{ alive });
+    const auto second = owners.emplace(Owner{ std::make_shared<int>(1) });
+    alive = nullptr;
+    CHECK(!watch.expired());
+    owners.erase(first);
+    CHECK(watch.expired());
+    CHECK(*owners.get(second)->value == 1);
+
+    const auto handle = map.emplace(std::make_unique<int>(7));
+    map.emplace(std::make_unique<int>(8));
+    map.erase(handle);
+    CHECK((map.size() == 1) && (**map.begin() == 8));
+}
+
+} // namespace.
+
+int main(int, char**)
+{
+    test::init();
+
+    testDefaultHandleIsInvalid();
+    testStaleHandleAfterErase();
+    testGenerationBumpOnReuse();
+    testEraseMovesLastElement();
+    testClear();
+    testMoveOnlyElementsAreDestroyed();
+
+    return test::finish();
+}
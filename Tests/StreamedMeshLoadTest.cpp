@@ -0,0 +1,386 @@
+#include "MockOpenRL.h"
+#include "SyntheticScene.h"
+#include "TestHarness.h"
+#include "TestMaterial.h"
+
+#include <HeatrayRenderer/Scene/GltfMeshProvider.h>
+#include <HeatrayRenderer/Scene/Mesh.h>
+#include <Utility/MappedFile.h>
+
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <stdint.h>
+#include <string.h>
+#include <string>
+#include <vector>
+
+// Uploads a synthetic scene from a mapped glTF through a single staging
+// buffer, the way Mesh copies each buffer into OpenRL, and checks that the
+// resident memory of the process grows by at most a chunk while the whole
+// scene is streamed. A 200M triangle scene is then submitted through Mesh a
+// provider chunk at a time against the mocked OpenRL, which doesn't keep the
+// buffer data, to check that only one chunk of it is ever held in memory.
+// Peak memory is only measured on Linux, elsewhere the test just streams the
+// scenes.
+
+namespace {
+
+const std::string kDirectory = "StreamedMeshLoadTestFiles";
+
+#if defined(__linux__)
+// Value of 'field' (e.g. "VmHWM:") in /proc/self/status in bytes, 0 if it is missing.
+size_t statusBytes(const std::string& field)
+{
+    std::ifstream status("/proc/self/status");
+    std::string line;
+    while (std::getline(status, line)) {
+        if (line.compare(0, field.size(), field) == 0) {
+            return size_t(std::stoull(line.substr(field.size()))) * 1024;
+        }
+    }
+    return 0;
+}
+
+// Resets VmHWM to the current resident set size.
+bool resetPeakResidentBytes()
+{
+    std::ofstream clearRefs("/proc/self/clear_refs");
+    clearRefs << "5";
+    clearRefs.close();
+    return bool(clearRefs);
+}
+#endif
+
+void testPeakMemoryIsBoundedByChunk()
+{
+    // 16 meshes of 2 x 256^2 triangles, about 58 MB of geometry.
+    test::SyntheticSceneDesc desc;
+    desc.meshCount = 16;
+    desc.gridSize = 256;
+    const std::string path = kDirectory + "/scene.gltf";
+    const test::SyntheticSceneStats stats = test::writeSyntheticScene(path, desc);
+
+    GltfMeshProvider provider(path);
+    CHECK(provider.open(path, false));
+    CHECK(provider.GetSubmeshCount() == stats.meshCount);
+
+    size_t largestBuffer = 0;
+    for (size_t ii = 0; ii < provider.GetVertexBufferCount(); ++ii) {
+        largestBuffer = std::max(largestBuffer, provider.GetVertexBufferSize(ii));
+    }
+    for (size_t ii = 0; ii < provider.GetIndexBufferCount(); ++ii) {
+        largestBuffer = std::max(largestBuffer, provider.GetIndexBufferSize(ii));
+    }
+    const size_t sceneBytes = test::meshProviderBytes(provider);
+    CHECK(sceneBytes > 8 * largestBuffer);
+
+    // The staging buffer is touched up front so that only the mapped source shows up below.
+    std::vector<uint8_t> staging(largestBuffer, 0);
+#if defined(__linux__)
+    const bool measure = resetPeakResidentBytes();
+    const size_t residentBytes = statusBytes("VmRSS:");
+#endif
+
+    size_t streamedBytes = 0;
+    for (size_t ii = 0; ii < provider.GetVertexBufferCount(); ++ii) {
+        provider.FillVertexBuffer(ii, staging.data());
+        streamedBytes += provider.GetVertexBufferSize(ii);
+    }
+    for (size_t ii = 0; ii < provider.GetIndexBufferCount(); ++ii) {
+        provider.FillIndexBuffer(ii, staging.data());
+        streamedBytes += provider.GetIndexBufferSize(ii);
+    }
+    CHECK(streamedBytes == sceneBytes);
+
+#if defined(__linux__)
+    if (measure) {
+        // Every buffer is smaller than a chunk, so at most one of them is resident at a time. Allow a few
+        // MB for the partial pages left at the ends of each buffer and for the allocator.
+        const size_t peakGrowth = statusBytes("VmHWM:") - std::min(statusBytes("VmHWM:"), residentBytes);
+        const size_t bound = std::min(largestBuffer, util::MappedFile::kStreamChunkSize) + 4 * 1024 * 1024;
+        CHECK(peakGrowth <= bound);
+        CHECK(bound < sceneBytes / 4);
+    }
+#endif
+}
+
+// Grids with a vertex and an index buffer each whose data is only generated
+// once their chunk is first filled and freed again when it is released,
+// like a provider reading its submeshes from an asset piece by piece.
+class GeneratedGridProvider : public MeshProvider
+{
+public:
+    GeneratedGridProvider(size_t meshCount, size_t gridSize, size_t chunkBytes) :
+        MeshProvider("Generated grids"), m_gridSize(gridSize), m_vertexData(meshCount), m_indexData(meshCount)
+    {
+        SplitIntoChunks(chunkBytes);
+        m_generated.resize(GetChunkCount(), false);
+    }
+
+    size_t GetVertexBufferCount() override { return m_vertexData.size(); }
+    size_t GetVertexBufferSize(size_t) override { return (m_gridSize + 1) * (m_gridSize + 1) * 3 * sizeof(float); }
+    void FillVertexBuffer(size_t bufferIndex, uint8_t *buffer) override
+    {
+        generate(bufferIndex);
+        memcpy(buffer, m_vertexData[bufferIndex].data(), GetVertexBufferSize(bufferIndex));
+    }
+
+    size_t GetIndexBufferCount() override { return m_indexData.size(); }
+    size_t GetIndexBufferSize(size_t) override { return m_gridSize * m_gridSize * 6 * sizeof(uint32_t); }
+    void FillIndexBuffer(size_t bufferIndex, uint8_t *buffer) override
+    {
+        generate(bufferIndex);
+        memcpy(buffer, m_indexData[bufferIndex].data(), GetIndexBufferSize(bufferIndex));
+    }
+
+    size_t GetSubmeshCount() override { return m_vertexData.size(); }
+    Submesh GetSubmesh(size_t submeshIndex) override
+    {
+        Submesh submesh;
+        submesh.vertexAttributeCount = 1;
+        submesh.vertexAttributes[0].usage = VertexAttributeUsage_Position;
+        submesh.vertexAttributes[0].buffer = int(submeshIndex);
+        submesh.vertexAttributes[0].componentCount = 3;
+        submesh.vertexAttributes[0].size = sizeof(float);
+        submesh.vertexAttributes[0].stride = 3 * sizeof(float);
+        submesh.indexBuffer = submeshIndex;
+        submesh.elementCount = m_gridSize * m_gridSize * 6;
+        submesh.indexType = IndexType::kUInt32;
+        submesh.name = "Grid " + std::to_string(submeshIndex);
+        return submesh;
+    }
+
+    void ReleaseChunk(size_t chunkIndex) override
+    {
+#if defined(__linux__)
+        // The data of the provider peaks right before a chunk is freed.
+        m_peakResidentBytes = std::max(m_peakResidentBytes, statusBytes("VmRSS:"));
+#endif
+        const Chunk chunk = GetChunk(chunkIndex);
+        for (size_t ii = chunk.firstSubmesh; ii < chunk.firstSubmesh + chunk.submeshCount; ++ii) {
+            m_vertexData[ii] = std::vector<float>();
+            m_indexData[ii] = std::vector<uint32_t>();
+        }
+        --m_liveChunks;
+        ++m_releasedChunks;
+    }
+
+    size_t maxLiveChunks() const { return m_maxLiveChunks; }
+    size_t releasedChunks() const { return m_releasedChunks; }
+    size_t peakResidentBytes() const { return m_peakResidentBytes; }
+
+private:
+    void generate(size_t submeshIndex)
+    {
+        size_t chunkIndex = 0;
+        while (GetChunk(chunkIndex).firstSubmesh + GetChunk(chunkIndex).submeshCount <= submeshIndex) {
+            ++chunkIndex;
+        }
+        if (m_generated[chunkIndex]) {
+            return;
+        }
+        m_generated[chunkIndex] = true;
+        m_maxLiveChunks = std::max(m_maxLiveChunks, ++m_liveChunks);
+
+        const Chunk chunk = GetChunk(chunkIndex);
+        const size_t verticesPerSide = m_gridSize + 1;
+        for (size_t ii = chunk.firstSubmesh; ii < chunk.firstSubmesh + chunk.submeshCount; ++ii) {
+            std::vector<float>& positions = m_vertexData[ii];
+            positions.resize(verticesPerSide * verticesPerSide * 3);
+            for (size_t vertex = 0; vertex < verticesPerSide * verticesPerSide; ++vertex) {
+                positions[vertex * 3 + 0] = float(vertex % verticesPerSide);
+                positions[vertex * 3 + 1] = float(ii);
+                positions[vertex * 3 + 2] = float(vertex / verticesPerSide);
+            }
+            std::vector<uint32_t>& indices = m_indexData[ii];
+            indices.reserve(m_gridSize * m_gridSize * 6);
+            for (uint32_t y = 0; y < m_gridSize; ++y) {
+                for (uint32_t x = 0; x < m_gridSize; ++x) {
+                    const uint32_t corner = y * uint32_t(verticesPerSide) + x;
+                    const uint32_t quad[6] = { corner, corner + 1, corner + uint32_t(verticesPerSide),
+                                               corner + 1, corner + uint32_t(verticesPerSide) + 1, corner + uint32_t(verticesPerSide) };
+                    indices.insert(indices.end(), quad, quad + 6);
+                }
+            }
+        }
+    }
+
+    const size_t m_gridSize;
+    std::vector<std::vector<float>> m_vertexData;
+    std::vector<std::vector<uint32_t>> m_indexData;
+    std::vector<bool> m_generated; // Per chunk.
+    size_t m_liveChunks = 0;
+    size_t m_maxLiveChunks = 0;
+    size_t m_releasedChunks = 0;
+    size_t m_peakResidentBytes = 0;
+};
+
+// Two submeshes per vertex buffer, e.g. instances, with their own index buffers.
+class SharedBufferProvider : public MeshProvider
+{
+public:
+    SharedBufferProvider(size_t submeshCount, size_t chunkBytes) : MeshProvider("Shared buffers"), m_submeshCount(submeshCount)
+    {
+        SplitIntoChunks(chunkBytes);
+    }
+
+    size_t GetVertexBufferCount() override { return (m_submeshCount + 1) / 2; }
+    size_t GetVertexBufferSize(size_t) override { return 1024; }
+    void FillVertexBuffer(size_t, uint8_t *buffer) override { memset(buffer, 0, 1024); }
+    size_t GetIndexBufferCount() override { return m_submeshCount; }
+    size_t GetIndexBufferSize(size_t) override { return 1024; }
+    void FillIndexBuffer(size_t, uint8_t *buffer) override { memset(buffer, 0, 1024); }
+    size_t GetSubmeshCount() override { return m_submeshCount; }
+    Submesh GetSubmesh(size_t submeshIndex) override
+    {
+        Submesh submesh;
+        submesh.vertexAttributeCount = 1;
+        submesh.vertexAttributes[0].buffer = int(submeshIndex / 2);
+        submesh.vertexAttributes[0].componentCount = 3;
+        submesh.vertexAttributes[0].size = sizeof(float);
+        submesh.vertexAttributes[0].stride = 3 * sizeof(float);
+        submesh.indexBuffer = submeshIndex;
+        submesh.elementCount = 3;
+        return submesh;
+    }
+
+private:
+    const size_t m_submeshCount;
+};
+
+void testChunksKeepSharedBuffersTogether()
+{
+    // Without a split the provider is a single chunk.
+    GeneratedGridProvider whole(4, 4, SIZE_MAX);
+    CHECK(whole.GetChunkCount() == 1);
+
+    // Every chunk would only hold a single submesh by size, but pairs of them share a vertex buffer.
+    SharedBufferProvider provider(7, 1);
+    CHECK(provider.GetChunkCount() == 4);
+    size_t nextSubmesh = 0, nextVertexBuffer = 0, nextIndexBuffer = 0;
+    for (size_t ii = 0; ii < provider.GetChunkCount(); ++ii) {
+        const MeshProvider::Chunk chunk = provider.GetChunk(ii);
+        CHECK(chunk.firstSubmesh == nextSubmesh && chunk.firstVertexBuffer == nextVertexBuffer && chunk.firstIndexBuffer == nextIndexBuffer);
+        CHECK(chunk.submeshCount == ((ii < 3) ? 2 : 1) && chunk.vertexBufferCount == 1);
+        nextSubmesh += chunk.submeshCount;
+        nextVertexBuffer += chunk.vertexBufferCount;
+        nextIndexBuffer += chunk.indexBufferCount;
+    }
+    CHECK(nextSubmesh == 7 && nextVertexBuffer == 4 && nextIndexBuffer == 7);
+}
+
+void testMeshUploadIsBoundedByChunk()
+{
+    // 1526 meshes of 2 x 256^2 triangles, 200M triangles and about 3.5 GB of geometry, handed out in chunks
+    // of 16 MB. Only one chunk is ever generated and the mock drops the buffer data, so this stays cheap.
+    constexpr size_t kMeshCount = 1526;
+    constexpr size_t kGridSize = 256;
+    constexpr size_t kChunkBytes = 16 * 1024 * 1024;
+    GeneratedGridProvider provider(kMeshCount, kGridSize, kChunkBytes);
+    const size_t sceneBytes = test::meshProviderBytes(provider);
+    const size_t submeshBytes = provider.GetVertexBufferSize(0) + provider.GetIndexBufferSize(0);
+    CHECK(provider.GetChunkCount() > 16);
+    CHECK(kMeshCount * kGridSize * kGridSize * 2 >= 200'000'000);
+
+    test::MockOpenRL& mock = test::MockOpenRL::instance();
+    mock.setKeepBufferData(false);
+    const size_t bufferBytes = mock.bufferBytes();
+
+    std::shared_ptr<test::TestMaterial> material = std::make_shared<test::TestMaterial>();
+    std::vector<std::shared_ptr<Material>> materials = { material };
+    std::function<void(const std::shared_ptr<openrl::Program>)> callback = [](const std::shared_ptr<openrl::Program>) {};
+#if defined(__linux__)
+    const bool measure = resetPeakResidentBytes();
+    const size_t residentBytes = statusBytes("VmRSS:");
+#endif
+
+    // Submesh by submesh as the chunks are uploaded.
+    Mesh mesh(&provider, materials, callback, glm::mat4(1.0f), nullptr, Mesh::Upload::kChunked);
+    CHECK(mesh.submeshes().empty());
+    size_t chunkCount = 0;
+    while (!mesh.complete()) {
+        mesh.uploadNextChunk(callback);
+        ++chunkCount;
+        CHECK(mesh.submeshes().size() == provider.GetChunk(chunkCount - 1).firstSubmesh + provider.GetChunk(chunkCount - 1).submeshCount);
+    }
+    CHECK(chunkCount == provider.GetChunkCount());
+    CHECK(provider.releasedChunks() == chunkCount);
+    CHECK(provider.maxLiveChunks() == 1);
+    CHECK(mesh.submeshes().size() == kMeshCount);
+    CHECK(mock.bufferBytes() - bufferBytes >= sceneBytes);
+
+#if defined(__linux__)
+    if (measure) {
+        // VmHWM is not updated when freed memory is unmapped, so the samples taken by the provider count as well.
+        // A chunk holds at least the budget. It ends with the submesh that reaches the budget, the mocked mapping
+        // is as large as the largest buffer and a few MB are left for the allocator and the submeshes and
+        // primitives of the mesh.
+        const size_t peakBytes = std::max(statusBytes("VmHWM:"), provider.peakResidentBytes());
+        const size_t peakGrowth = peakBytes - std::min(peakBytes, residentBytes);
+        const size_t bound = kChunkBytes + 2 * submeshBytes + 8 * 1024 * 1024;
+        CHECK(peakGrowth >= kChunkBytes);
+        CHECK(peakGrowth <= bound);
+        CHECK(bound < sceneBytes / 16);
+    }
+#endif
+
+    mesh.destroy();
+    mock.setKeepBufferData(true);
+}
+
+void testStreamCopyInChunks()
+{
+    // A buffer larger than the chunk size is copied and released a chunk at a time.
+    const std::string path = kDirectory + "/buffer.bin";
+    constexpr size_t kSize = 24 * 1024 * 1024;
+    constexpr size_t kChunkSize = 1024 * 1024;
+    {
+        std::vector<uint8_t> bytes(kSize);
+        for (size_t ii = 0; ii < kSize; ++ii) {
+            bytes[ii] = uint8_t((ii * 2654435761u) >> 24);
+        }
+        std::ofstream(path, std::ios::binary | std::ios::trunc).write(reinterpret_cast<const char*>(bytes.data()), std::streamsize(kSize));
+    }
+
+    util::MappedFile file;
+    CHECK(file.open(path));
+    std::vector<uint8_t> copy(kSize, 0);
+#if defined(__linux__)
+    const bool measure = resetPeakResidentBytes();
+    const size_t residentBytes = statusBytes("VmRSS:");
+#endif
+
+    util::MappedFile::streamCopy(copy.data(), file.data(), file.size(), kChunkSize);
+
+#if defined(__linux__)
+    if (measure) {
+        const size_t peakGrowth = statusBytes("VmHWM:") - std::min(statusBytes("VmHWM:"), residentBytes);
+        CHECK(peakGrowth <= 4 * kChunkSize);
+    }
+#endif
+
+    bool equal = true;
+    for (size_t ii = 0; ii < kSize; ii += 4093) {
+        equal = equal && (copy[ii] == uint8_t((ii * 2654435761u) >> 24));
+    }
+    CHECK(equal);
+}
+
+} // namespace.
+
+int main(int, char**)
+{
+    test::init();
+
+    std::filesystem::create_directories(kDirectory);
+    // Runs first so that memory freed by the other tests can't hide the chunks from the resident set.
+    testMeshUploadIsBoundedByChunk();
+    testChunksKeepSharedBuffersTogether();
+    testPeakMemoryIsBoundedByChunk();
+    testStreamCopyInChunks();
+    std::filesystem::remove_all(kDirectory);
+
+    return test::finish();
+}
@@ -0,0 +1,268 @@
+//
+//  SyntheticImage.h
+//  Heatray
+//
+//  Writes small image files for the texture loading tests and benchmarks,
+//  so that they do not depend on images being checked in.
+//
+//
+
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <stddef.h>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+namespace test {
+
+namespace detail {
+
+inline void writeBigEndian(std::vector<uint8_t>& out, uint32_t value)
+{
+    out.push_back(uint8_t(value >> 24));
+    out.push_back(uint8_t(value >> 16));
+    out.push_back(uint8_t(value >> 8));
+    out.push_back(uint8_t(value));
+}
+
+inline uint32_t crc32(const uint8_t* data, size_t size)
+{
+    uint32_t crc = 0xffffffff;
+    for (size_t ii = 0; ii < size; ++ii) {
+        crc ^= data[ii];
+        for (int bit = 0; bit < 8; ++bit) {
+            crc = (crc >> 1) ^ (0xedb88320 & (0 - (crc & 1)));
+        }
+    }
+    return ~crc;
+}
+
+inline void writePngChunk(std::vector<uint8_t>& out, const char* type, const std::vector<uint8_t>& data)
+{
+    writeBigEndian(out, uint32_t(data.size()));
+    const size_t start = out.size();
+    out.insert(out.end(), type, type + 4);
+    out.insert(out.end(), data.begin(), data.end());
+    writeBigEndian(out, crc32(out.data() + start, out.size() - start));
+}
+
+// Writes a bit stream MSB first with the byte stuffing JPEG entropy coded data needs.
+class JpegBitWriter
+{
+public:
+    explicit JpegBitWriter(std::vector<uint8_t>& out) : m_out(out) {}
+
+    void write(uint32_t bits, int count)
+    {
+        for (int bit = count - 1; bit >= 0; --bit) {
+            m_byte = uint8_t((m_byte << 1) | ((bits >> bit) & 1));
+            if (++m_bitCount == 8) {
+                flushByte();
+            }
+        }
+    }
+
+    // Pads the last byte with ones.
+    void finish()
+    {
+        while (m_bitCount != 0) {
+            write(1, 1);
+        }
+    }
+
+private:
+    void flushByte()
+    {
+        m_out.push_back(m_byte);
+        if (m_byte == 0xff) {
+            m_out.push_back(0);
+        }
+        m_byte = 0;
+        m_bitCount = 0;
+    }
+
+    std::vector<uint8_t>& m_out;
+    uint8_t m_byte = 0;
+    int m_bitCount = 0;
+};
+
+inline void writeJpegSegment(std::vector<uint8_t>& out, uint8_t marker, const std::vector<uint8_t>& data)
+{
+    out.insert(out.end(), { 0xff, marker, uint8_t((data.size() + 2) >> 8), uint8_t(data.size() + 2) });
+    out.insert(out.end(), data.begin(), data.end());
+}
+
+} // namespace detail.
+
+//-------------------------------------------------------------------------
+// Deterministic 8bit test pattern with 'channelCount' interleaved channels.
+inline std::vector<uint8_t> makePattern(int width, int height, int channelCount, uint32_t seed = 0)
+{
+    std::vector<uint8_t> pixels(size_t(width) * size_t(height) * size_t(channelCount));
+    for (size_t ii = 0; ii < pixels.size(); ++ii) {
+        pixels[ii] = uint8_t((ii * 2654435761u + seed * 40503u) >> 13);
+    }
+    return pixels;
+}
+
+//-------------------------------------------------------------------------
+// Write 8bit 'pixels' with 1 to 4 interleaved channels to 'path' as a PNG.
+// The image data is stored without compression, which keeps the writer
+// trivial while still going through the regular PNG decoder.
+inline bool writePng(const std::string& path, int width, int height, int channelCount, const uint8_t* pixels)
+{
+    static constexpr uint8_t kColorTypes[] = { 0, 4, 2, 6 }; // Gray, gray + alpha, RGB, RGBA.
+
+    std::vector<uint8_t> png = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1a, '\n' };
+
+    std::vector<uint8_t> header;
+    detail::writeBigEndian(header, uint32_t(width));
+    detail::writeBigEndian(header, uint32_t(height));
+    header.insert(header.end(), { 8, kColorTypes[channelCount - 1], 0, 0, 0 });
+    detail::writePngChunk(png, "IHDR", header);
+
+    // Every row starts with filter type 0 (none).
+    const size_t rowSize = size_t(width) * size_t(channelCount);
+    std::vector<uint8_t> raw;
+    raw.reserve((rowSize + 1) * size_t(height));
+    for (int y = 0; y < height; ++y) {
+        raw.push_back(0);
+        raw.insert(raw.end(), pixels + y * rowSize, pixels + (y + 1) * rowSize);
+    }
+
+    // zlib stream made of stored deflate blocks.
+    std::vector<uint8_t> zlib = { 0x78, 0x01 };
+    constexpr size_t kMaxBlockSize = 65535;
+    for (size_t offset = 0; (offset < raw.size()) || (offset == 0); offset += kMaxBlockSize) {
+        const size_t size = std::min(kMaxBlockSize, raw.size() - offset);
+        const bool last = (offset + size == raw.size());
+        zlib.insert(zlib.end(), { uint8_t(last ? 1 : 0), uint8_t(size), uint8_t(size >> 8), uint8_t(~size), uint8_t(~size >> 8) });
+        zlib.insert(zlib.end(), raw.begin() + offset, raw.begin() + offset + size);
+    }
+    uint32_t a = 1, b = 0;
+    for (uint8_t value : raw) {
+        a = (a + value) % 65521;
+        b = (b + a) % 65521;
+    }
+    detail::writeBigEndian(zlib, (b << 16) | a);
+    detail::writePngChunk(png, "IDAT", zlib);
+    detail::writePngChunk(png, "IEND", {});
+
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    file.write(reinterpret_cast<const char*>(png.data()), std::streamsize(png.size()));
+    return bool(file);
+}
+
+//-------------------------------------------------------------------------
+// Write 8bit RGB 'pixels' to 'path' as a baseline JPEG. Only the DC
+// coefficient of each 8x8 block is stored, so the decoded image is the
+// block averages of 'pixels', but the file still goes through the full
+// JPEG decoder (Huffman decoding, dequantization, IDCT and YCbCr to RGB).
+// 'width' and 'height' must be multiples of 8.
+inline bool writeJpeg(const std::string& path, int width, int height, const uint8_t* pixels)
+{
+    // Standard luminance DC table. The AC table only holds the end of block code.
+    static constexpr uint8_t kDCCounts[16] = { 0, 1, 5, 1, 1, 1, 1, 1, 1, 0, 0, 0, 0, 0, 0, 0 };
+    static constexpr uint8_t kACCounts[16] = { 1, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0 };
+
+    // Canonical Huffman codes of the DC categories 0-11.
+    uint16_t dcCodes[12] = {};
+    uint8_t dcLengths[12] = {};
+    for (uint32_t length = 1, code = 0, symbol = 0; length <= 16; ++length, code <<= 1) {
+        for (uint32_t ii = 0; ii < kDCCounts[length - 1]; ++ii, ++code, ++symbol) {
+            dcCodes[symbol] = uint16_t(code);
+            dcLengths[symbol] = uint8_t(length);
+        }
+    }
+
+    std::vector<uint8_t> jpeg = { 0xff, 0xd8 };
+
+    std::vector<uint8_t> quantization(65, 1); // Table 0, every coefficient quantized by 1.
+    quantization[0] = 0;
+    detail::writeJpegSegment(jpeg, 0xdb, quantization);
+
+    detail::writeJpegSegment(jpeg, 0xc0, { 8, uint8_t(height >> 8), uint8_t(height), uint8_t(width >> 8), uint8_t(width), 3,
+                                           1, 0x11, 0, 2, 0x11, 0, 3, 0x11, 0 });
+
+    std::vector<uint8_t> huffman = { 0x00 };
+    huffman.insert(huffman.end(), kDCCounts, kDCCounts + 16);
+    for (uint8_t symbol = 0; symbol < 12; ++symbol) {
+        huffman.push_back(symbol);
+    }
+    huffman.push_back(0x10);
+    huffman.insert(huffman.end(), kACCounts, kACCounts + 16);
+    huffman.push_back(0x00); // End of block.
+    detail::writeJpegSegment(jpeg, 0xc4, huffman);
+
+    detail::writeJpegSegment(jpeg, 0xda, { 3, 1, 0x00, 2, 0x00, 3, 0x00, 0, 63, 0 });
+
+    detail::JpegBitWriter writer(jpeg);
+    int previousDC[3] = {};
+    for (int blockY = 0; blockY < height; blockY += 8) {
+        for (int blockX = 0; blockX < width; blockX += 8) {
+            float sums[3] = {};
+            for (int y = blockY; y < blockY + 8; ++y) {
+                for (int x = blockX; x < blockX + 8; ++x) {
+                    const uint8_t* pixel = pixels + (size_t(y) * size_t(width) + size_t(x)) * 3;
+                    const float r = pixel[0], g = pixel[1], b = pixel[2];
+                    sums[0] += 0.299f * r + 0.587f * g + 0.114f * b - 128.0f;
+                    sums[1] += -0.168736f * r - 0.331264f * g + 0.5f * b;
+                    sums[2] += 0.5f * r - 0.418688f * g - 0.081312f * b;
+                }
+            }
+
+            for (int component = 0; component < 3; ++component) {
+                // The DC coefficient of the forward DCT is the sum of the level shifted samples divided by 8.
+                const int dc = int(std::lround(sums[component] / 8.0f));
+                const int difference = dc - previousDC[component];
+                previousDC[component] = dc;
+
+                int category = 0;
+                while ((1 << category) <= std::abs(difference)) {
+                    ++category;
+                }
+                writer.write(dcCodes[category], dcLengths[category]);
+                if (category > 0) {
+                    writer.write(uint32_t((difference < 0) ? (difference - 1) : difference) & ((1u << category) - 1), category);
+                }
+                writer.write(0, 1); // End of block.
+            }
+        }
+    }
+    writer.finish();
+    jpeg.insert(jpeg.end(), { 0xff, 0xd9 });
+
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    file.write(reinterpret_cast<const char*>(jpeg.data()), std::streamsize(jpeg.size()));
+    return bool(file);
+}
+
+//-------------------------------------------------------------------------
+// Write float RGB 'pixels' to 'path' as an uncompressed Radiance HDR file.
+inline bool writeHdr(const std::string& path, int width, int height, const float* pixels)
+{
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    file << "#?RADIANCE\nFORMAT=32-bit_rle_rgbe\n\n-Y " << height << " +X " << width << "\n";
+
+    std::vector<uint8_t> rgbe(size_t(width) * size_t(height) * 4, 0);
+    for (size_t ii = 0; ii < size_t(width) * size_t(height); ++ii) {
+        const float* pixel = pixels + ii * 3;
+        const float maxComponent = std::max({ pixel[0], pixel[1], pixel[2] });
+        if (maxComponent >= 1e-32f) {
+            int exponent = 0;
+            const float scale = std::frexp(maxComponent, &exponent) * 256.0f / maxComponent;
+            rgbe[ii * 4 + 0] = uint8_t(pixel[0] * scale);
+            rgbe[ii * 4 + 1] = uint8_t(pixel[1] * scale);
+            rgbe[ii * 4 + 2] = uint8_t(pixel[2] * scale);
+            rgbe[ii * 4 + 3] = uint8_t(exponent + 128);
+        }
+    }
+    file.write(reinterpret_cast<const char*>(rgbe.data()), std::streamsize(rgbe.size()));
+    return bool(file);
+}
+
+} // namespace test.
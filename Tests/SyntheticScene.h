@@ -0,0 +1,147 @@
+//
+//  SyntheticScene.h
+//  Heatray
+//
+//  Writes glTF scenes of a configurable size for the loader tests and
+//  benchmarks, so that they do not depend on large assets being checked in.
+//
+//
+
+#pragma once
+
+#include <HeatrayRenderer/Scene/MeshProvider.h>
+
+#include <fstream>
+#include <stddef.h>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+namespace test {
+
+struct SyntheticSceneDesc {
+    size_t meshCount = 1;           // Meshes with unique geometry.
+    size_t duplicatesPerMesh = 0;   // Extra meshes with geometry identical to each unique mesh.
+    size_t instancesPerMesh = 1;    // Nodes referencing each mesh.
+    size_t gridSize = 4;            // Each mesh is a grid of gridSize^2 quads.
+};
+
+struct SyntheticSceneStats {
+    size_t meshCount = 0;     // Including duplicates.
+    size_t nodeCount = 0;
+    size_t vertexCount = 0;   // Of all meshes, not counting instances.
+    size_t triangleCount = 0; // Of all meshes, not counting instances.
+};
+
+//-------------------------------------------------------------------------
+// Write 'desc' to 'path' (a .gltf file) with its buffer in a .bin file next
+// to it. Every mesh has positions, normals and texture coordinates.
+inline SyntheticSceneStats writeSyntheticScene(const std::string& path, const SyntheticSceneDesc& desc)
+{
+    const size_t verticesPerSide = desc.gridSize + 1;
+    const size_t vertexCount = verticesPerSide * verticesPerSide;
+    const size_t indexCount = desc.gridSize * desc.gridSize * 6;
+
+    std::vector<uint32_t> indices;
+    indices.reserve(indexCount);
+    for (uint32_t y = 0; y < desc.gridSize; ++y) {
+        for (uint32_t x = 0; x < desc.gridSize; ++x) {
+            const uint32_t corner = y * uint32_t(verticesPerSide) + x;
+            const uint32_t quad[6] = { corner, corner + 1, corner + uint32_t(verticesPerSide),
+                                       corner + 1, corner + uint32_t(verticesPerSide) + 1, corner + uint32_t(verticesPerSide) };
+            indices.insert(indices.end(), quad, quad + 6);
+        }
+    }
+
+    const std::string binPath = path.substr(0, path.rfind('.')) + ".bin";
+    const std::string binName = binPath.substr(binPath.find_last_of("/\\") + 1);
+    std::ofstream bin(binPath, std::ios::binary | std::ios::trunc);
+
+    std::string bufferViews;
+    std::string accessors;
+    std::string meshes;
+    size_t byteOffset = 0;
+    size_t accessorCount = 0;
+    auto addView = [&](const void* data, size_t size, const std::string& accessor) {
+        bin.write(reinterpret_cast<const char*>(data), std::streamsize(size));
+        bufferViews += std::string(bufferViews.empty() ? "" : ",") + "{\"buffer\":0,\"byteOffset\":" + std::to_string(byteOffset) +
+                       ",\"byteLength\":" + std::to_string(size) + "}";
+        accessors += std::string(accessors.empty() ? "" : ",") + "{\"bufferView\":" + std::to_string(accessorCount) + "," + accessor + "}";
+        byteOffset += size;
+        return accessorCount++;
+    };
+
+    SyntheticSceneStats stats;
+    std::vector<float> positions(vertexCount * 3), normals(vertexCount * 3), texCoords(vertexCount * 2);
+    for (size_t meshIndex = 0; meshIndex < desc.meshCount; ++meshIndex) {
+        // Every unique mesh is a slightly different height field so that none of them hash the same.
+        const float height = 0.01f * float(meshIndex + 1);
+        for (size_t vertex = 0; vertex < vertexCount; ++vertex) {
+            const float u = float(vertex % verticesPerSide) / float(desc.gridSize);
+            const float v = float(vertex / verticesPerSide) / float(desc.gridSize);
+            positions[vertex * 3 + 0] = u;
+            positions[vertex * 3 + 1] = height * u * v;
+            positions[vertex * 3 + 2] = v;
+            normals[vertex * 3 + 0] = 0.0f;
+            normals[vertex * 3 + 1] = 1.0f;
+            normals[vertex * 3 + 2] = 0.0f;
+            texCoords[vertex * 2 + 0] = u;
+            texCoords[vertex * 2 + 1] = v;
+        }
+
+        for (size_t copy = 0; copy <= desc.duplicatesPerMesh; ++copy) {
+            const std::string count = "\"count\":" + std::to_string(vertexCount);
+            const size_t position = addView(positions.data(), positions.size() * sizeof(float),
+                                            "\"componentType\":5126,\"type\":\"VEC3\"," + count + ",\"min\":[0,0,0],\"max\":[1," +
+                                            std::to_string(height) + ",1]");
+            const size_t normal = addView(normals.data(), normals.size() * sizeof(float), "\"componentType\":5126,\"type\":\"VEC3\"," + count);
+            const size_t texCoord = addView(texCoords.data(), texCoords.size() * sizeof(float), "\"componentType\":5126,\"type\":\"VEC2\"," + count);
+            const size_t index = addView(indices.data(), indices.size() * sizeof(uint32_t),
+                                         "\"componentType\":5125,\"type\":\"SCALAR\",\"count\":" + std::to_string(indexCount));
+
+            meshes += std::string(meshes.empty() ? "" : ",") + "{\"primitives\":[{\"attributes\":{\"POSITION\":" + std::to_string(position) +
+                      ",\"NORMAL\":" + std::to_string(normal) + ",\"TEXCOORD_0\":" + std::to_string(texCoord) + "},\"indices\":" +
+                      std::to_string(index) + ",\"material\":0}]}";
+            ++stats.meshCount;
+            stats.vertexCount += vertexCount;
+            stats.triangleCount += indexCount / 3;
+        }
+    }
+    bin.close();
+
+    // Instances are spread out on a grid so that the scene has a sensible bounding box.
+    std::string nodes;
+    std::string sceneNodes;
+    for (size_t meshIndex = 0; meshIndex < stats.meshCount; ++meshIndex) {
+        for (size_t instance = 0; instance < desc.instancesPerMesh; ++instance) {
+            const size_t node = stats.nodeCount++;
+            nodes += std::string(nodes.empty() ? "" : ",") + "{\"mesh\":" + std::to_string(meshIndex) + ",\"translation\":[" +
+                     std::to_string(2 * (node % 100)) + ",0," + std::to_string(2 * (node / 100)) + "]}";
+            sceneNodes += std::string(sceneNodes.empty() ? "" : ",") + std::to_string(node);
+        }
+    }
+
+    std::ofstream gltf(path, std::ios::trunc);
+    gltf << "{\"asset\":{\"version\":\"2.0\"},\"scene\":0,\"scenes\":[{\"nodes\":[" << sceneNodes << "]}],"
+         << "\"nodes\":[" << nodes << "],\"meshes\":[" << meshes << "],"
+         << "\"materials\":[{\"pbrMetallicRoughness\":{\"baseColorFactor\":[0.8,0.8,0.8,1],\"metallicFactor\":0,\"roughnessFactor\":0.5}}],"
+         << "\"accessors\":[" << accessors << "],\"bufferViews\":[" << bufferViews << "],"
+         << "\"buffers\":[{\"uri\":\"" << binName << "\",\"byteLength\":" << byteOffset << "}]}";
+    return stats;
+}
+
+//-------------------------------------------------------------------------
+// Bytes of vertex and index data that 'provider' would upload to OpenRL.
+inline size_t meshProviderBytes(MeshProvider& provider)
+{
+    size_t bytes = 0;
+    for (size_t ii = 0; ii < provider.GetVertexBufferCount(); ++ii) {
+        bytes += provider.GetVertexBufferSize(ii);
+    }
+    for (size_t ii = 0; ii < provider.GetIndexBufferCount(); ++ii) {
+        bytes += provider.GetIndexBufferSize(ii);
+    }
+    return bytes;
+}
+
+} // namespace test.
@@ -0,0 +1,62 @@
+//
+//  TestHarness.h
+//  Heatray
+//
+//  Minimal helpers shared by the unit tests and benchmarks. Every test is a
+//  standalone executable which returns non-zero if any CHECK failed.
+//
+//
+
+#pragma once
+
+#include <Utility/ConsoleLog.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+
+namespace test {
+
+inline int& failureCount()
+{
+    static int count = 0;
+    return count;
+}
+
+//-------------------------------------------------------------------------
+// Must be called at the start of main(). Installs the log used by the code
+// under test and makes sure output is not lost if a test crashes.
+inline void init()
+{
+    setvbuf(stdout, nullptr, _IONBF, 0);
+    util::ConsoleLog::install();
+}
+
+//-------------------------------------------------------------------------
+// Returned from main().
+inline int finish()
+{
+    if (failureCount() > 0) {
+        printf("%d check(s) failed\n", failureCount());
+        return EXIT_FAILURE;
+    }
+    printf("All checks passed\n");
+    return EXIT_SUCCESS;
+}
+
+//-------------------------------------------------------------------------
+// Benchmarks take an optional scale factor as their first argument so that
+// ctest runs them quickly while larger runs can still be done by hand.
+inline double benchmarkScale(int argc, char** argv)
+{
+    return (argc > 1) ? atof(argv[1]) : 1.0;
+}
+
+} // namespace test.
+
+#define CHECK(condition)                                                                  \
+    do {                                                                                  \
+        if (!(condition)) {                                                               \
+            printf("%s(%d): CHECK(%s) failed\n", __FILE__, __LINE__, #condition);         \
+            ++test::failureCount();                                                       \
+        }                                                                                 \
+    } while (false)
@@ -0,0 +1,49 @@
+//
+//  TestMaterial.h
+//  Heatray
+//
+//  Material with a trivial program for the tests that build meshes against
+//  the mocked OpenRL, so that they do not depend on the shaders on disk.
+//
+//
+
+#pragma once
+
+#include <HeatrayRenderer/Materials/Material.h>
+#include <RLWrapper/Buffer.h>
+#include <RLWrapper/Program.h>
+
+#include <string_view>
+
+namespace test {
+
+class TestMaterial : public Material
+{
+public:
+    TestMaterial() : Material("Test material", Material::Type::Glass) {}
+
+    // Every mesh builds its materials again. Like util::buildSharedProgram() the program is only linked the first time.
+    void build() override
+    {
+        if (!m_program) {
+            m_program = openrl::Program::create();
+            m_program->link("Test program");
+        }
+        resolveUniforms();
+        const float constants[4] = {};
+        m_constants = openrl::Buffer::create(RL_UNIFORM_BLOCK_BUFFER, constants, sizeof(constants), "Test material uniform block");
+    }
+    bool rebuild() override
+    {
+        m_program.reset();
+        build();
+        return true;
+    }
+    void modify() override {}
+    uint64_t parameterHash() const override { return 0; }
+
+protected:
+    const std::string_view rayShader() const override { return "test.rlsl"; }
+};
+
+} // namespace test.
@@ -0,0 +1,206 @@
+#include "MockOpenRL.h"
+#include "SyntheticImage.h"
+#include "TestHarness.h"
+
+#include <Utility/TextureCache.h>
+
+#include <filesystem>
+#include <vector>
+
+namespace {
+
+constexpr int kSize = 16;
+const std::string kDirectory = "TextureCacheTestFiles";
+
+std::string texturePath(const std::string& name)
+{
+    return kDirectory + "/" + name + ".png";
+}
+
+size_t uploads()
+{
+    return test::MockOpenRL::instance().calls("rlTexImage2D");
+}
+
+// Starts every test with an empty cache and cleared counters.
+util::TextureCache& resetCache()
+{
+    util::TextureCache& cache = util::TextureCache::instance();
+    cache.clear();
+    cache.logStatistics("Reset");
+    test::MockOpenRL::instance().reset();
+    return cache;
+}
+
+void testRepeatedGetUploadsOnce()
+{
+    util::TextureCache& cache = resetCache();
+
+    std::shared_ptr<openrl::Texture> first = cache.get(texturePath("a"), true, false);
+    std::shared_ptr<openrl::Texture> second = cache.get(texturePath("a"), true, false);
+    CHECK(first && (first == second));
+    CHECK(uploads() == 1);
+
+    const util::TextureCache::Statistics statistics = cache.statistics();
+    CHECK(statistics.requestCount == 2);
+    CHECK(statistics.hitCount == 1);
+    CHECK(statistics.bytesSaved == size_t(kSize) * kSize * 3);
+}
+
+void testKeyIncludesPathSpellingAndOptions()
+{
+    util::TextureCache& cache = resetCache();
+
+    std::shared_ptr<openrl::Texture> texture = cache.get(texturePath("a"), true, false);
+    CHECK(cache.get(kDirectory + "/../" + texturePath("a"), true, false) == texture);
+    CHECK(cache.get("./" + texturePath("a"), true, false) == texture);
+    CHECK(uploads() == 1);
+
+    // Any option that changes the uploaded texture needs its own entry.
+    CHECK(cache.get(texturePath("a"), false, false) != texture);
+    CHECK(cache.get(texturePath("a"), true, true) != texture);
+    util::TextureLoadOptions options;
+    options.maxDimension = kSize / 2;
+    CHECK(cache.get(texturePath("a"), true, false, options) != texture);
+    CHECK(uploads() == 4);
+    CHECK(cache.statistics().hitCount == 2);
+}
+
+void testGetAllDeduplicates()
+{
+    util::TextureCache& cache = resetCache();
+    std::shared_ptr<openrl::Texture> cached = cache.get(texturePath("a"), true, false);
+
+    const std::vector<util::TextureLoadRequest> requests = {
+        { texturePath("a"), true, false }, { texturePath("b"), true, false }, { texturePath("b"), true, false },
+        { texturePath("c"), true, false }, { texturePath("b"), true, false },
+    };
+    std::vector<std::shared_ptr<openrl::Texture>> textures = cache.getAll(requests);
+    CHECK(textures.size() == requests.size());
+    CHECK(textures[0] == cached);
+    CHECK(textures[1] && (textures[1] == textures[2]) && (textures[1] == textures[4]));
+    CHECK(textures[3] && (textures[3] != textures[1]));
+
+    // 'a' was uploaded by get(), 'b' and 'c' once each by getAll().
+    CHECK(uploads() == 3);
+    const util::TextureCache::Statistics statistics = cache.statistics();
+    CHECK(statistics.requestCount == 6);
+    CHECK(statistics.hitCount == 3);
+    CHECK(statistics.bytesSaved == 3 * size_t(kSize) * kSize * 3);
+}
+
+void testPrefetchOnlyUploadsOnRequest()
+{
+    util::TextureCache& cache = resetCache();
+
+    const std::vector<util::TextureLoadRequest> requests = { { texturePath("a"), true, false }, { texturePath("b"), true, false } };
+    size_t decodedBytes = 0;
+    cache.prefetch(requests, 1, [&decodedBytes](size_t, size_t byteCount) { decodedBytes += byteCount; });
+    CHECK(decodedBytes == 2 * size_t(kSize) * kSize * 3);
+    CHECK(uploads() == 0);
+
+    std::vector<std::shared_ptr<openrl::Texture>> textures = cache.getAll(requests);
+    CHECK(textures[0] && textures[1]);
+    CHECK(uploads() == 2);
+    CHECK(cache.statistics().hitCount == 2);
+}
+
+void testPrefetchedTexturesSurviveUntilReleased()
+{
+    util::TextureCache& cache = resetCache();
+
+    // A scene that finishes loading releases unused textures while the next load (generation 3) has already
+    // prefetched its textures. They must still be there when that load is added.
+    const std::vector<util::TextureLoadRequest> requests = { { texturePath("a"), true, false }, { texturePath("b"), true, false } };
+    cache.prefetch(requests, 3);
+    cache.releaseUnused();
+    cache.releasePrefetched(2);
+    std::vector<std::shared_ptr<openrl::Texture>> textures = cache.getAll(requests);
+    CHECK(textures[0] && textures[1]);
+    CHECK(uploads() == 2);
+    CHECK(cache.statistics().hitCount == 2);
+
+    // Releasing the generation keeps textures that were uploaded and are in use.
+    cache.releasePrefetched(3);
+    CHECK(cache.get(texturePath("a"), true, false) == textures[0]);
+    CHECK(uploads() == 2);
+}
+
+void testAbandonedPrefetchesAreReleased()
+{
+    util::TextureCache& cache = resetCache();
+
+    // Generation 4 is abandoned after decoding, generation 5 shares texture 'b' with it.
+    cache.prefetch({ { texturePath("a"), true, false }, { texturePath("b"), true, false } }, 4);
+    cache.prefetch({ { texturePath("b"), true, false }, { texturePath("c"), true, false } }, 5);
+    cache.releasePrefetched(4);
+
+    // 'a' has to be decoded again while 'b' and 'c' are still prefetched.
+    cache.logStatistics("Prefetched");
+    cache.getAll({ { texturePath("a"), true, false }, { texturePath("b"), true, false }, { texturePath("c"), true, false } });
+    CHECK(cache.statistics().hitCount == 2);
+
+    // Prefetches for a generation that was already released are skipped.
+    size_t reported = 0;
+    cache.prefetch({ { texturePath("missing"), true, false } }, 5, [&reported](size_t, size_t) { ++reported; });
+    cache.releasePrefetched(5);
+    cache.prefetch({ { texturePath("missing"), true, false } }, 5, [&reported](size_t, size_t) { ++reported; });
+    CHECK(reported == 1);
+    cache.logStatistics("Skipped");
+    CHECK(!cache.get(texturePath("missing"), true, false));
+    CHECK(cache.statistics().hitCount == 0);
+}
+
+void testMissingTexture()
+{
+    util::TextureCache& cache = resetCache();
+    CHECK(!cache.get(texturePath("missing"), true, false));
+    CHECK(uploads() == 0);
+}
+
+void testReleaseUnused()
+{
+    util::TextureCache& cache = resetCache();
+    const size_t liveTextures = test::MockOpenRL::instance().liveTextures();
+
+    std::shared_ptr<openrl::Texture> kept = cache.get(texturePath("a"), true, false);
+    cache.get(texturePath("b"), true, false);
+    CHECK(test::MockOpenRL::instance().liveTextures() == liveTextures + 2);
+
+    // Only the texture referenced outside of the cache survives.
+    cache.releaseUnused();
+    CHECK(test::MockOpenRL::instance().liveTextures() == liveTextures + 1);
+    CHECK(cache.get(texturePath("a"), true, false) == kept);
+    cache.get(texturePath("b"), true, false);
+    CHECK(uploads() == 3);
+
+    kept = nullptr;
+    cache.clear();
+    CHECK(test::MockOpenRL::instance().liveTextures() == liveTextures);
+}
+
+} // namespace.
+
+int main(int, char**)
+{
+    test::init();
+
+    std::filesystem::create_directories(kDirectory);
+    uint32_t seed = 0;
+    for (const char* name : { "a", "b", "c" }) {
+        const std::vector<uint8_t> pixels = test::makePattern(kSize, kSize, 3, seed++);
+        CHECK(test::writePng(texturePath(name), kSize, kSize, 3, pixels.data()));
+    }
+
+    testRepeatedGetUploadsOnce();
+    testKeyIncludesPathSpellingAndOptions();
+    testGetAllDeduplicates();
+    testPrefetchOnlyUploadsOnRequest();
+    testPrefetchedTexturesSurviveUntilReleased();
+    testAbandonedPrefetchesAreReleased();
+    testMissingTexture();
+    testReleaseUnused();
+
+    std::filesystem::remove_all(kDirectory);
+    return test::finish();
+}
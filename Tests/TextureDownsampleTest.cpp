@@ -0,0 +1,175 @@
+#include "SyntheticImage.h"
+#include "TestHarness.h"
+
+#include <Utility/TextureLoader.h>
+
+#include <cmath>
+#include <filesystem>
+#include <numeric>
+#include <vector>
+
+namespace {
+
+bool nearlyEqual(float a, float b)
+{
+    return std::fabs(a - b) <= 1e-5f * std::max(1.0f, std::fabs(b));
+}
+
+std::vector<float> resize(const std::vector<float>& src, int srcWidth, int srcHeight, int channelCount, int dstWidth, int dstHeight)
+{
+    std::vector<float> dst(size_t(dstWidth) * size_t(dstHeight) * size_t(channelCount), -1.0f);
+    util::boxFilterResize(src.data(), srcWidth, srcHeight, channelCount, dst.data(), dstWidth, dstHeight);
+    return dst;
+}
+
+void testSameSizeIsCopy()
+{
+    std::vector<float> src(7 * 5 * 3);
+    std::iota(src.begin(), src.end(), 0.0f);
+    CHECK(resize(src, 7, 5, 3, 7, 5) == src);
+}
+
+void testConstantImageStaysConstant()
+{
+    // Arbitrary ratios must not introduce any ringing or darkening at the borders.
+    const std::vector<float> src(37 * 23 * 2, 0.25f);
+    for (auto [width, height] : { std::pair(8, 5), std::pair(36, 22), std::pair(1, 1), std::pair(19, 23) }) {
+        bool constant = true;
+        for (float value : resize(src, 37, 23, 2, width, height)) {
+            constant = constant && nearlyEqual(value, 0.25f);
+        }
+        CHECK(constant);
+    }
+}
+
+void testHalvingAveragesBlocks()
+{
+    const int width = 8, height = 6;
+    std::vector<float> src(size_t(width) * height);
+    for (size_t ii = 0; ii < src.size(); ++ii) {
+        src[ii] = float((ii * 37) % 11);
+    }
+
+    const std::vector<float> dst = resize(src, width, height, 1, width / 2, height / 2);
+    bool averaged = true;
+    for (int y = 0; y < height / 2; ++y) {
+        for (int x = 0; x < width / 2; ++x) {
+            const float expected = (src[(2 * y) * width + 2 * x] + src[(2 * y) * width + 2 * x + 1] +
+                                    src[(2 * y + 1) * width + 2 * x] + src[(2 * y + 1) * width + 2 * x + 1]) / 4.0f;
+            averaged = averaged && nearlyEqual(dst[y * (width / 2) + x], expected);
+        }
+    }
+    CHECK(averaged);
+}
+
+void testPartialCoverageIsWeighted()
+{
+    // Each output texel covers one and a half source texels.
+    const std::vector<float> row = resize({ 0.0f, 3.0f, 6.0f }, 3, 1, 1, 2, 1);
+    CHECK(nearlyEqual(row[0], (0.0f * 1.0f + 3.0f * 0.5f) / 1.5f));
+    CHECK(nearlyEqual(row[1], (3.0f * 0.5f + 6.0f * 1.0f) / 1.5f));
+
+    const std::vector<float> column = resize({ 0.0f, 3.0f, 6.0f }, 1, 3, 1, 1, 2);
+    CHECK(nearlyEqual(column[0], row[0]));
+    CHECK(nearlyEqual(column[1], row[1]));
+}
+
+void testAverageIsPreserved()
+{
+    const int width = 30, height = 20;
+    std::vector<float> src(size_t(width) * height);
+    for (size_t ii = 0; ii < src.size(); ++ii) {
+        src[ii] = float((ii * 7919) % 101) / 100.0f;
+    }
+    const double sourceMean = std::accumulate(src.begin(), src.end(), 0.0) / double(src.size());
+
+    for (auto [dstWidth, dstHeight] : { std::pair(10, 5), std::pair(7, 3), std::pair(13, 11) }) {
+        const std::vector<float> dst = resize(src, width, height, 1, dstWidth, dstHeight);
+        const double mean = std::accumulate(dst.begin(), dst.end(), 0.0) / double(dst.size());
+        CHECK(std::fabs(mean - sourceMean) < 1e-4);
+    }
+}
+
+void testChannelsAreIndependent()
+{
+    const int width = 9, height = 9;
+    std::vector<float> src(size_t(width) * height * 3);
+    for (size_t ii = 0; ii < size_t(width) * height; ++ii) {
+        src[ii * 3 + 0] = float(ii % 5);
+        src[ii * 3 + 1] = 0.5f;
+        src[ii * 3 + 2] = float(ii % 5);
+    }
+
+    const std::vector<float> dst = resize(src, width, height, 3, 4, 4);
+    bool independent = true;
+    for (size_t ii = 0; ii < 16; ++ii) {
+        independent = independent && nearlyEqual(dst[ii * 3 + 1], 0.5f) && (dst[ii * 3 + 0] == dst[ii * 3 + 2]);
+    }
+    CHECK(independent);
+}
+
+void testLoaderDownsamplesToMaxDimension()
+{
+    const std::string path = "TextureDownsampleTest.png";
+    const int width = 32, height = 16, channelCount = 3;
+    const std::vector<uint8_t> pixels = test::makePattern(width, height, channelCount);
+    CHECK(test::writePng(path, width, height, channelCount, pixels.data()));
+
+    util::TextureLoadOptions options;
+    options.maxDimension = 8;
+    util::LoadedTexture loaded = util::loadTextureAsync(path, false, false, options).get();
+    CHECK(loaded.pixels != nullptr);
+    CHECK((loaded.desc.width == 8) && (loaded.desc.height == 4));
+    CHECK(loaded.desc.dataType == RL_UNSIGNED_BYTE);
+
+    // Each output texel is the rounded average of a 4x4 block. Images are flipped vertically when loaded.
+    bool averaged = (loaded.pixels != nullptr);
+    for (int y = 0; averaged && (y < 4); ++y) {
+        for (int x = 0; x < 8; ++x) {
+            for (int channel = 0; channel < channelCount; ++channel) {
+                float sum = 0.0f;
+                for (int yy = 0; yy < 4; ++yy) {
+                    for (int xx = 0; xx < 4; ++xx) {
+                        const int sourceRow = height - 1 - (y * 4 + yy);
+                        sum += float(pixels[(size_t(sourceRow) * width + size_t(x * 4 + xx)) * channelCount + channel]) / 255.0f;
+                    }
+                }
+                const int expected = int(sum / 16.0f * 255.0f + 0.5f);
+                const int actual = loaded.pixels.get()[(size_t(y) * 8 + size_t(x)) * channelCount + channel];
+                averaged = averaged && (std::abs(actual - expected) <= 1);
+            }
+        }
+    }
+    CHECK(averaged);
+
+    // Storing as float keeps the filtered values unquantized.
+    options.storage = util::TextureStorage::kFloat;
+    loaded = util::loadTextureAsync(path, false, false, options).get();
+    CHECK(loaded.desc.dataType == RL_FLOAT);
+    CHECK(util::textureByteCount(loaded.desc) == 8 * 4 * channelCount * sizeof(float));
+
+    // Textures that already fit are left alone.
+    options = util::TextureLoadOptions();
+    options.maxDimension = 32;
+    loaded = util::loadTextureAsync(path, false, false, options).get();
+    CHECK((loaded.desc.width == width) && (loaded.desc.height == height));
+
+    std::filesystem::remove(path);
+}
+
+} // namespace.
+
+int main(int, char**)
+{
+    test::init();
+
+    testSameSizeIsCopy();
+    testConstantImageStaysConstant();
+    testHalvingAveragesBlocks();
+    testPartialCoverageIsWeighted();
+    testAverageIsPreserved();
+    testChannelsAreIndependent();
+    testLoaderDownsamplesToMaxDimension();
+
+    return test::finish();
+}
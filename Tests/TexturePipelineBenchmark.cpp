@@ -0,0 +1,122 @@
+#include "SyntheticImage.h"
+#include "TestHarness.h"
+
+#include <Utility/Hash.h>
+#include <Utility/ParallelFor.h>
+#include <Utility/TextureLoader.h>
+#include <Utility/Timer.h>
+
+#include <algorithm>
+#include <filesystem>
+#include <limits>
+#include <vector>
+
+namespace {
+
+const std::string kDirectory = "TexturePipelineBenchmarkFiles";
+
+// Writes 'count' textures cycling through PNG, JPEG and HDR files.
+std::vector<util::TextureLoadRequest> writeTextures(size_t count, int size)
+{
+    std::filesystem::create_directories(kDirectory);
+
+    std::vector<util::TextureLoadRequest> requests;
+    std::vector<float> hdrPixels(size_t(size) * size_t(size) * 3);
+    for (size_t ii = 0; ii < count; ++ii) {
+        const std::vector<uint8_t> pixels = test::makePattern(size, size, 3, uint32_t(ii));
+        std::string path = kDirectory + "/texture" + std::to_string(ii);
+        switch (ii % 3) {
+            case 0:
+                path += ".png";
+                CHECK(test::writePng(path, size, size, 3, pixels.data()));
+                break;
+            case 1:
+                path += ".jpg";
+                CHECK(test::writeJpeg(path, size, size, pixels.data()));
+                break;
+            default:
+                path += ".hdr";
+                for (size_t channel = 0; channel < hdrPixels.size(); ++channel) {
+                    hdrPixels[channel] = float(pixels[channel]) / 16.0f;
+                }
+                CHECK(test::writeHdr(path, size, size, hdrPixels.data()));
+                break;
+        }
+
+        // Color textures are converted to linear and mipmapped, like the base color textures of a scene.
+        requests.push_back({ path, true, (ii % 3) != 2, util::TextureLoadOptions() });
+    }
+    return requests;
+}
+
+struct RunResult {
+    float seconds = 0.0f;
+    size_t bytes = 0;
+    size_t largestTexture = 0; // In bytes.
+    uint64_t hash = 0;
+    bool inOrder = true;
+};
+
+// Stands in for the upload by reading every decoded byte on the consuming thread.
+RunResult run(const std::vector<util::TextureLoadRequest>& requests, size_t queueDepth)
+{
+    RunResult result;
+    size_t expectedIndex = 0;
+    util::Timer timer(true);
+    util::loadTexturesPipelined(requests, queueDepth, [&](size_t index, util::LoadedTexture& loadedTexture) {
+        result.inOrder = result.inOrder && (index == expectedIndex++);
+        if (loadedTexture.pixels) {
+            const size_t byteCount = util::textureByteCount(loadedTexture.desc);
+            result.bytes += byteCount;
+            result.largestTexture = std::max(result.largestTexture, byteCount);
+            result.hash = util::hashCombine(result.hash, util::FNV1a(reinterpret_cast<const char*>(loadedTexture.pixels.get()), byteCount));
+        }
+    });
+    result.seconds = timer.stop();
+    result.inOrder = result.inOrder && (expectedIndex == requests.size());
+    return result;
+}
+
+} // namespace.
+
+// Decode throughput of loadTexturesPipelined() over a directory of PNG, JPEG
+// and HDR files for several queue depths. A depth of 1 decodes and uploads
+// one texture at a time and a depth of 2 matches the previous double
+// buffered loader.
+int main(int argc, char** argv)
+{
+    test::init();
+
+    const size_t count = std::max<size_t>(size_t(48 * test::benchmarkScale(argc, argv)), 3);
+    constexpr int kSize = 512;
+    const std::vector<util::TextureLoadRequest> requests = writeTextures(count, kSize);
+
+    printf("%zu textures (%d x %d PNG, JPEG and HDR), up to %zu decode threads\n", count, kSize, kSize, util::parallelWorkerCount(count));
+
+    uint64_t referenceHash = 0;
+    for (size_t queueDepth : { size_t(1), size_t(2), util::kDefaultTextureQueueDepth, 2 * util::kDefaultTextureQueueDepth }) {
+        constexpr int kRuns = 3;
+        RunResult best;
+        best.seconds = std::numeric_limits<float>::max();
+        for (int runIndex = 0; runIndex < kRuns; ++runIndex) {
+            RunResult result = run(requests, queueDepth);
+            CHECK(result.inOrder);
+            if (referenceHash == 0) {
+                referenceHash = result.hash;
+            }
+            CHECK(result.hash == referenceHash);
+            if (result.seconds < best.seconds) {
+                best = result;
+            }
+        }
+
+        // At most 'queueDepth' decoded textures are held at once.
+        const size_t peakBytes = std::min(queueDepth, count) * best.largestTexture;
+        printf("  Queue depth %2zu: %.3f s (%.1f textures/s, %.1f MB/s decoded), at most %.1f MB of decoded pixels held\n", queueDepth,
+               best.seconds, double(count) / best.seconds, double(best.bytes) / (1024.0 * 1024.0) / best.seconds,
+               double(peakBytes) / (1024.0 * 1024.0));
+    }
+
+    std::filesystem::remove_all(kDirectory);
+    return test::finish();
+}
@@ -0,0 +1,81 @@
+#include "TestHarness.h"
+
+#include <HeatrayRenderer/Scene/TransformHierarchy.h>
+#include <Utility/Timer.h>
+
+#include <glm/glm/gtc/matrix_transform.hpp>
+
+#include <algorithm>
+#include <limits>
+#include <random>
+#include <vector>
+
+// Frames of a hierarchy of 100k nodes, groups of 100 meshes below the root,
+// where 1% of the nodes move every frame. Compares TransformHierarchy::update()
+// against recomputing every world transform.
+int main(int argc, char** argv)
+{
+    test::init();
+
+    using NodeIndex = TransformHierarchy::NodeIndex;
+    const size_t nodeCount = std::max<size_t>(size_t(100000 * test::benchmarkScale(argc, argv)), 200);
+    constexpr size_t kGroupSize = 100;
+
+    TransformHierarchy hierarchy;
+    NodeIndex group = TransformHierarchy::kRootNode;
+    for (size_t ii = 1; ii < nodeCount; ++ii) {
+        const glm::mat4 local = glm::translate(glm::mat4(1.0f), glm::vec3(float(ii % kGroupSize), 0.0f, float(ii / kGroupSize)));
+        if ((ii % kGroupSize) == 1) {
+            group = hierarchy.addNode(TransformHierarchy::kRootNode, local);
+        } else {
+            hierarchy.addNode(group, local);
+        }
+    }
+    hierarchy.update();
+
+    // The same nodes move every frame so both variants do the same work.
+    std::vector<NodeIndex> moving(hierarchy.nodeCount() - 1);
+    for (size_t ii = 0; ii < moving.size(); ++ii) {
+        moving[ii] = NodeIndex(ii + 1);
+    }
+    std::shuffle(moving.begin(), moving.end(), std::mt19937(3));
+    moving.resize(moving.size() / 100);
+
+    constexpr int kFrames = 50;
+    float incrementalSeconds = std::numeric_limits<float>::max();
+    size_t updatedNodes = 0;
+    for (int frame = 0; frame < kFrames; ++frame) {
+        const glm::mat4 offset = glm::translate(glm::mat4(1.0f), glm::vec3(0.0f, float(frame), 0.0f));
+        util::Timer timer(true);
+        for (NodeIndex node : moving) {
+            hierarchy.setLocalTransform(node, offset * hierarchy.localTransform(node));
+        }
+        updatedNodes = hierarchy.update().size();
+        incrementalSeconds = std::min(incrementalSeconds, timer.stop());
+    }
+
+    // Recompute everything from the same local transforms, e.g. what a scene without dirty tracking does.
+    std::vector<glm::mat4> worldTransforms(hierarchy.nodeCount());
+    float fullSeconds = std::numeric_limits<float>::max();
+    for (int frame = 0; frame < kFrames; ++frame) {
+        util::Timer timer(true);
+        worldTransforms[TransformHierarchy::kRootNode] = hierarchy.localTransform(TransformHierarchy::kRootNode);
+        for (size_t node = 1; node < worldTransforms.size(); ++node) {
+            worldTransforms[node] = worldTransforms[hierarchy.parent(NodeIndex(node))] * hierarchy.localTransform(NodeIndex(node));
+        }
+        fullSeconds = std::min(fullSeconds, timer.stop());
+    }
+
+    bool equal = true;
+    for (size_t node = 0; node < worldTransforms.size(); ++node) {
+        equal = equal && (worldTransforms[node] == hierarchy.worldTransform(NodeIndex(node)));
+    }
+    CHECK(equal);
+    CHECK(updatedNodes < hierarchy.nodeCount() / 10);
+
+    printf("%zu nodes, %zu moved per frame\n", hierarchy.nodeCount(), moving.size());
+    printf("  Dirty propagation: %.3f ms per frame, %zu world transforms updated\n", incrementalSeconds * 1000.0f, updatedNodes);
+    printf("  Full recompute   : %.3f ms per frame, %zu world transforms updated\n", fullSeconds * 1000.0f, worldTransforms.size());
+
+    return test::finish();
+}
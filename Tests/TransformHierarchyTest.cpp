@@ -0,0 +1,149 @@
+#include "TestHarness.h"
+
+#include <HeatrayRenderer/Scene/TransformHierarchy.h>
+
+#include <glm/glm/gtc/matrix_transform.hpp>
+
+#include <vector>
+
+namespace {
+
+using NodeIndex = TransformHierarchy::NodeIndex;
+
+glm::mat4 translation(float x, float y, float z)
+{
+    return glm::translate(glm::mat4(1.0f), glm::vec3(x, y, z));
+}
+
+glm::vec3 origin(const glm::mat4& transform)
+{
+    return glm::vec3(transform[3]);
+}
+
+void testWorldTransformsAreComposed()
+{
+    TransformHierarchy hierarchy;
+    const NodeIndex parent = hierarchy.addNode(TransformHierarchy::kRootNode, translation(1.0f, 0.0f, 0.0f));
+    const NodeIndex child = hierarchy.addNode(parent, glm::scale(translation(0.0f, 2.0f, 0.0f), glm::vec3(2.0f)));
+    const NodeIndex grandChild = hierarchy.addNode(child, translation(0.0f, 0.0f, 3.0f));
+
+    const std::vector<NodeIndex> expected = { parent, child, grandChild };
+    CHECK(hierarchy.update() == expected);
+    CHECK(origin(hierarchy.worldTransform(parent)) == glm::vec3(1.0f, 0.0f, 0.0f));
+    CHECK(origin(hierarchy.worldTransform(child)) == glm::vec3(1.0f, 2.0f, 0.0f));
+    CHECK(origin(hierarchy.worldTransform(grandChild)) == glm::vec3(1.0f, 2.0f, 6.0f));
+
+    // Nothing changed, nothing is updated.
+    CHECK(hierarchy.update().empty());
+}
+
+void testOnlyChangedSubtreesAreUpdated()
+{
+    TransformHierarchy hierarchy;
+    const NodeIndex left = hierarchy.addNode(TransformHierarchy::kRootNode, glm::mat4(1.0f));
+    const NodeIndex right = hierarchy.addNode(TransformHierarchy::kRootNode, glm::mat4(1.0f));
+    const NodeIndex leftChild = hierarchy.addNode(left, translation(1.0f, 0.0f, 0.0f));
+    const NodeIndex rightChild = hierarchy.addNode(right, translation(0.0f, 1.0f, 0.0f));
+    hierarchy.update();
+
+    hierarchy.setLocalTransform(left, translation(0.0f, 0.0f, 5.0f));
+    const std::vector<NodeIndex> expected = { left, leftChild };
+    CHECK(hierarchy.update() == expected);
+    CHECK(origin(hierarchy.worldTransform(leftChild)) == glm::vec3(1.0f, 0.0f, 5.0f));
+    CHECK(origin(hierarchy.worldTransform(rightChild)) == glm::vec3(0.0f, 1.0f, 0.0f));
+
+    // Moving the root updates everything.
+    hierarchy.setLocalTransform(TransformHierarchy::kRootNode, translation(0.0f, 10.0f, 0.0f));
+    CHECK(hierarchy.update().size() == hierarchy.nodeCount());
+    CHECK(origin(hierarchy.worldTransform(rightChild)) == glm::vec3(0.0f, 11.0f, 0.0f));
+}
+
+void testRemovedNodesAreReused()
+{
+    TransformHierarchy hierarchy;
+    const NodeIndex group = hierarchy.addNode(TransformHierarchy::kRootNode, translation(1.0f, 0.0f, 0.0f));
+    const NodeIndex leaf = hierarchy.addNode(group, glm::mat4(1.0f));
+    const NodeIndex other = hierarchy.addNode(TransformHierarchy::kRootNode, glm::mat4(1.0f));
+    hierarchy.update();
+
+    // Only leaves can be removed, and only once.
+    CHECK(!hierarchy.removeNode(TransformHierarchy::kRootNode));
+    CHECK(!hierarchy.removeNode(group));
+    CHECK(hierarchy.removeNode(leaf));
+    CHECK(!hierarchy.removeNode(leaf));
+    CHECK(hierarchy.isFree(leaf) && (hierarchy.freeNodeCount() == 1));
+
+    // A free node is skipped by update() even when its former parent moves.
+    hierarchy.setLocalTransform(group, translation(2.0f, 0.0f, 0.0f));
+    const std::vector<NodeIndex> expected = { group };
+    CHECK(hierarchy.update() == expected);
+
+    // The group has no children left and can be removed too.
+    CHECK(hierarchy.removeNode(group));
+
+    // Adding a node below the root reuses the first free node.
+    const size_t nodeCount = hierarchy.nodeCount();
+    const NodeIndex reused = hierarchy.addNode(TransformHierarchy::kRootNode, translation(0.0f, 3.0f, 0.0f));
+    CHECK(reused == group);
+    CHECK(hierarchy.nodeCount() == nodeCount);
+    CHECK(hierarchy.parent(reused) == TransformHierarchy::kRootNode);
+
+    // A free node before the parent is not reused since parents have to come before their children.
+    const NodeIndex child = hierarchy.addNode(other, translation(0.0f, 0.0f, 1.0f));
+    CHECK(child > other);
+    CHECK(hierarchy.nodeCount() == nodeCount + 1);
+    CHECK(hierarchy.isFree(leaf));
+
+    hierarchy.setLocalTransform(TransformHierarchy::kRootNode, translation(0.0f, 0.0f, 10.0f));
+    hierarchy.update();
+    CHECK(origin(hierarchy.worldTransform(reused)) == glm::vec3(0.0f, 3.0f, 10.0f));
+    CHECK(origin(hierarchy.worldTransform(child)) == glm::vec3(0.0f, 0.0f, 11.0f));
+}
+
+void testRepeatedAddAndRemoveDoesNotGrow()
+{
+    // Like toggling the ground plane on and off.
+    TransformHierarchy hierarchy;
+    for (int ii = 0; ii < 8; ++ii) {
+        hierarchy.addNode(TransformHierarchy::kRootNode, glm::mat4(1.0f));
+    }
+    const size_t nodeCount = hierarchy.nodeCount();
+    for (int ii = 0; ii < 100; ++ii) {
+        const NodeIndex node = hierarchy.addNode(TransformHierarchy::kRootNode, translation(float(ii), 0.0f, 0.0f));
+        hierarchy.update();
+        CHECK(origin(hierarchy.worldTransform(node)) == glm::vec3(float(ii), 0.0f, 0.0f));
+        CHECK(hierarchy.removeNode(node));
+    }
+    CHECK(hierarchy.nodeCount() == nodeCount + 1);
+}
+
+void testClear()
+{
+    TransformHierarchy hierarchy;
+    const NodeIndex node = hierarchy.addNode(TransformHierarchy::kRootNode, translation(1.0f, 0.0f, 0.0f));
+    hierarchy.addNode(node, glm::mat4(1.0f));
+    hierarchy.removeNode(hierarchy.addNode(TransformHierarchy::kRootNode, glm::mat4(1.0f)));
+    hierarchy.setLocalTransform(TransformHierarchy::kRootNode, translation(1.0f, 0.0f, 0.0f));
+
+    hierarchy.clear();
+    CHECK(hierarchy.nodeCount() == 1);
+    CHECK(hierarchy.freeNodeCount() == 0);
+    CHECK(hierarchy.localTransform(TransformHierarchy::kRootNode) == glm::mat4(1.0f));
+    CHECK(hierarchy.update().empty());
+    CHECK(hierarchy.addNode(TransformHierarchy::kRootNode, glm::mat4(1.0f)) == 1);
+}
+
+} // namespace.
+
+int main(int, char**)
+{
+    test::init();
+
+    testWorldTransformsAreComposed();
+    testOnlyChangedSubtreesAreUpdated();
+    testRemovedNodesAreReused();
+    testRepeatedAddAndRemoveDoesNotGrow();
+    testClear();
+
+    return test::finish();
+}
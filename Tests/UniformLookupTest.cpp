@@ -0,0 +1,136 @@
+#include "MockOpenRL.h"
+#include "TestHarness.h"
+#include "TestMaterial.h"
+
+#include <HeatrayRenderer/Scene/Mesh.h>
+#include <HeatrayRenderer/Scene/PlaneMeshProvider.h>
+#include <RLWrapper/Program.h>
+
+#include <memory>
+#include <vector>
+
+// Counts how often uniforms and uniform blocks are looked up by name in the
+// mocked OpenRL driver while programs are linked, meshes are submitted and
+// transforms are updated.
+
+namespace {
+
+const std::vector<std::string> kActiveUniforms = { "worldFromEntity", "texCoordTransform", "lightIndex", "colors[0]" };
+const std::vector<std::string> kActiveUniformBlocks = { "Material", "EnvironmentLight", "PointLights" };
+
+size_t uniformLookups()
+{
+    return test::MockOpenRL::instance().calls("rlGetUniformLocation");
+}
+
+size_t uniformBlockLookups()
+{
+    return test::MockOpenRL::instance().calls("rlGetUniformBlockIndex");
+}
+
+void testLinkResolvesActiveUniforms()
+{
+    test::MockOpenRL& mock = test::MockOpenRL::instance();
+    mock.reset();
+
+    // Linking asks for every active uniform and uniform block once.
+    std::shared_ptr<openrl::Program> program = openrl::Program::create();
+    CHECK(program->link("Lookup test"));
+    CHECK(uniformLookups() == kActiveUniforms.size());
+    CHECK(uniformBlockLookups() == kActiveUniformBlocks.size());
+
+    // After that neither names nor handles reach the driver, arrays are found by their plain name.
+    mock.reset();
+    const openrl::UniformHandle worldFromEntity = program->uniform("worldFromEntity");
+    CHECK(worldFromEntity.valid());
+    CHECK(program->getUniformLocation("worldFromEntity") == worldFromEntity.location);
+    CHECK(program->uniform("colors").valid());
+    CHECK(program->uniformBlock("PointLights").valid());
+    for (int ii = 0; ii < 1000; ++ii) {
+        const float matrix[16] = {};
+        program->setMatrix4fv(worldFromEntity, matrix);
+    }
+    CHECK(mock.calls("rlUniformMatrix4fv") == 1000);
+    CHECK(uniformLookups() == 0);
+    CHECK(uniformBlockLookups() == 0);
+
+    // Names that were not reported go to the driver once.
+    program->uniform("colors[1]");
+    program->uniform("colors[1]");
+    program->uniformBlock("SpotLights");
+    program->uniformBlock("SpotLights");
+    CHECK(uniformLookups() == 1);
+    CHECK(uniformBlockLookups() == 1);
+
+    // Linking again starts over.
+    mock.reset();
+    CHECK(program->link("Lookup test"));
+    CHECK(uniformLookups() == kActiveUniforms.size());
+    program->uniform("colors[1]");
+    CHECK(uniformLookups() == kActiveUniforms.size() + 1);
+}
+
+void testMaterialUniformsAreResolvedOnce()
+{
+    test::MockOpenRL& mock = test::MockOpenRL::instance();
+    std::shared_ptr<test::TestMaterial> material = std::make_shared<test::TestMaterial>();
+    material->build();
+
+    const Material::Uniforms& uniforms = material->uniforms();
+    CHECK(uniforms.worldFromEntity.valid() && uniforms.texCoordTransform.valid() && uniforms.material.valid());
+    CHECK(uniforms.lighting.environmentLight.valid() && uniforms.lighting.pointLights.valid());
+    CHECK(uniforms.lighting.environmentLight.index != uniforms.lighting.pointLights.index);
+
+    // Submitting meshes, which builds the material each time, uses the resolved handles.
+    mock.reset();
+    PlaneMeshProvider provider(10, 10, "Plane");
+    std::function<void(const std::shared_ptr<openrl::Program>)> callback = [](const std::shared_ptr<openrl::Program>) {};
+    std::vector<std::unique_ptr<Mesh>> meshes;
+    for (int ii = 0; ii < 100; ++ii) {
+        std::vector<std::shared_ptr<Material>> materials = { material }; // Taken over by the mesh.
+        meshes.push_back(std::make_unique<Mesh>(&provider, materials, callback, glm::mat4(1.0f)));
+    }
+    CHECK(mock.calls("rlUniformMatrix4fv") == meshes.size());
+    CHECK(mock.calls("rlUniform4fv") == meshes.size());
+    CHECK(mock.calls("rlUniformBlockBuffer") == meshes.size());
+    CHECK(uniformLookups() == 0);
+    CHECK(uniformBlockLookups() == 0);
+
+    // Frames of moving every mesh the way Scene::updateTransforms() does.
+    mock.reset();
+    for (int frame = 0; frame < 100; ++frame) {
+        const glm::mat4 transform = glm::mat4(float(frame));
+        for (const std::unique_ptr<Mesh>& mesh : meshes) {
+            for (const Mesh::Submesh& submesh : mesh->submeshes()) {
+                submesh.primitive->bind();
+                submesh.material->program()->setMatrix4fv(submesh.material->uniforms().worldFromEntity, &(transform[0][0]));
+                submesh.primitive->unbind();
+            }
+        }
+    }
+    CHECK(mock.calls("rlUniformMatrix4fv") == 100 * meshes.size());
+    CHECK(uniformLookups() == 0);
+
+    // Rebuilding resolves the handles of the new program.
+    mock.reset();
+    CHECK(material->rebuild());
+    CHECK(uniformLookups() == kActiveUniforms.size());
+    CHECK(material->uniforms().worldFromEntity.valid());
+
+    for (const std::unique_ptr<Mesh>& mesh : meshes) {
+        mesh->destroy();
+    }
+}
+
+} // namespace.
+
+int main(int, char**)
+{
+    test::init();
+    test::MockOpenRL::instance().setActiveUniforms(kActiveUniforms, kActiveUniformBlocks);
+
+    testLinkResolvesActiveUniforms();
+    testMaterialUniformsAreResolvedOnce();
+
+    return test::finish();
+}
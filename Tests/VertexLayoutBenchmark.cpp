@@ -0,0 +1,100 @@
+#include "SyntheticScene.h"
+#include "TestHarness.h"
+
+#include <HeatrayRenderer/Scene/AssimpMeshProvider.h>
+#include <Utility/Timer.h>
+
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <limits>
+#include <vector>
+
+namespace {
+
+struct LayoutResult {
+    float loadTime = std::numeric_limits<float>::max();
+    size_t vertexBufferCount = 0;
+    size_t bytes = 0;
+    std::vector<std::vector<float>> attributes; // Every attribute of every submesh, tightly packed.
+};
+
+LayoutResult load(const std::string& path, VertexLayout layout)
+{
+    LayoutResult result;
+    for (int run = 0; run < 3; ++run) {
+        util::Timer timer(true);
+        AssimpMeshProvider provider(path, false, layout);
+        result.loadTime = std::min(result.loadTime, timer.stop());
+
+        if (run > 0) {
+            continue;
+        }
+        result.vertexBufferCount = provider.GetVertexBufferCount();
+        result.bytes = test::meshProviderBytes(provider);
+
+        // Read every attribute back through the offset and stride that Mesh would hand to OpenRL.
+        std::vector<std::vector<uint8_t>> buffers(provider.GetVertexBufferCount());
+        for (size_t ii = 0; ii < buffers.size(); ++ii) {
+            buffers[ii].resize(provider.GetVertexBufferSize(ii));
+            provider.FillVertexBuffer(ii, buffers[ii].data());
+        }
+        for (size_t submeshIndex = 0; submeshIndex < provider.GetSubmeshCount(); ++submeshIndex) {
+            const MeshProvider::Submesh submesh = provider.GetSubmesh(submeshIndex);
+
+            // The vertex count is not part of the submesh, the indices tell how many vertices are used.
+            std::vector<uint8_t> indices(provider.GetIndexBufferSize(submesh.indexBuffer));
+            provider.FillIndexBuffer(submesh.indexBuffer, indices.data());
+            uint32_t vertexCount = 0;
+            for (size_t ii = 0; ii < submesh.elementCount; ++ii) {
+                uint32_t index = 0;
+                memcpy(&index, indices.data() + submesh.indexOffset + ii * indexSize(submesh.indexType), indexSize(submesh.indexType));
+                vertexCount = std::max(vertexCount, index + 1);
+            }
+
+            for (int ii = 0; ii < submesh.vertexAttributeCount; ++ii) {
+                const VertexAttribute& attribute = submesh.vertexAttributes[ii];
+                const std::vector<uint8_t>& buffer = buffers[attribute.buffer];
+                std::vector<float> values(size_t(vertexCount) * attribute.componentCount);
+                for (uint32_t vertex = 0; vertex < vertexCount; ++vertex) {
+                    memcpy(&values[size_t(vertex) * attribute.componentCount], buffer.data() + attribute.offset + size_t(vertex) * attribute.stride,
+                           size_t(attribute.componentCount) * attribute.size);
+                }
+                result.attributes.push_back(std::move(values));
+            }
+        }
+    }
+    return result;
+}
+
+} // namespace.
+
+// Compares one buffer per attribute with one interleaved buffer per submesh.
+int main(int argc, char** argv)
+{
+    test::init();
+
+    test::SyntheticSceneDesc desc;
+    desc.meshCount = std::max<size_t>(size_t(2000 * test::benchmarkScale(argc, argv)), 1);
+    desc.gridSize = 16;
+    const std::string path = "VertexLayoutBenchmark.gltf";
+    const test::SyntheticSceneStats stats = test::writeSyntheticScene(path, desc);
+
+    const LayoutResult separate = load(path, VertexLayout::kSeparate);
+    const LayoutResult interleaved = load(path, VertexLayout::kInterleaved);
+
+    // Both layouts must describe exactly the same vertices.
+    CHECK(separate.bytes == interleaved.bytes);
+    CHECK(separate.attributes.size() == interleaved.attributes.size());
+    CHECK(interleaved.vertexBufferCount == stats.meshCount);
+    bool sameAttributes = (separate.attributes == interleaved.attributes) && !separate.attributes.empty();
+    CHECK(sameAttributes);
+
+    printf("%zu meshes, %zu vertices\n", stats.meshCount, stats.vertexCount);
+    printf("  Separate:    %.3f s, %zu vertex buffers, %.2f MB\n", separate.loadTime, separate.vertexBufferCount, separate.bytes / (1024.0 * 1024.0));
+    printf("  Interleaved: %.3f s, %zu vertex buffers, %.2f MB\n", interleaved.loadTime, interleaved.vertexBufferCount, interleaved.bytes / (1024.0 * 1024.0));
+
+    std::filesystem::remove(path);
+    std::filesystem::remove("VertexLayoutBenchmark.bin");
+    return test::finish();
+}
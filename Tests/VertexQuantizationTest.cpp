@@ -0,0 +1,161 @@
+#include "TestHarness.h"
+
+#include <Utility/VertexQuantization.h>
+
+#include <cmath>
+#include <random>
+#include <vector>
+
+namespace {
+
+// Unit vectors covering the axes, the octahedron's edges and folds, and random directions in both hemispheres.
+std::vector<glm::vec3> unitVectors()
+{
+    std::vector<glm::vec3> vectors = {
+        { 1, 0, 0 }, { -1, 0, 0 }, { 0, 1, 0 }, { 0, -1, 0 }, { 0, 0, 1 }, { 0, 0, -1 },
+        { 1, 1, 0 }, { 1, -1, 0 }, { -1, 1, 0 }, { -1, -1, 0 }, { 1, 0, -1 }, { 0, -1, -1 },
+        { 1, 1, 1 }, { -1, -1, -1 }, { 1, -1, -1 }, { 1e-4f, 1e-4f, -1 },
+    };
+    std::mt19937 generator(7);
+    std::normal_distribution<float> distribution;
+    for (int ii = 0; ii < 10000; ++ii) {
+        vectors.emplace_back(distribution(generator), distribution(generator), distribution(generator));
+    }
+    for (glm::vec3& v : vectors) {
+        v = glm::normalize(v);
+    }
+    return vectors;
+}
+
+// Angle between unit vectors 'a' and 'b', accurate for small angles unlike acos(dot(a, b)).
+float angle(const glm::vec3& a, const glm::vec3& b)
+{
+    return std::atan2(glm::length(glm::cross(a, b)), glm::dot(a, b));
+}
+
+void testSnorm16()
+{
+    CHECK(util::quantizeSnorm16(0.0f) == 0);
+    CHECK(util::quantizeSnorm16(1.0f) == 32767);
+    CHECK(util::quantizeSnorm16(-1.0f) == -32767);
+    CHECK(util::quantizeSnorm16(2.0f) == 32767);
+    CHECK(util::quantizeSnorm16(-2.0f) == -32767);
+    CHECK(util::dequantizeSnorm16(-32768) == -1.0f);
+    CHECK(util::dequantizeSnorm16(32767) == 1.0f);
+
+    float maxError = 0.0f;
+    for (int ii = -1000; ii <= 1000; ++ii) {
+        const float value = float(ii) / 1000.0f;
+        maxError = std::max(maxError, std::abs(util::dequantizeSnorm16(util::quantizeSnorm16(value)) - value));
+    }
+    CHECK(maxError <= 0.5f / 32767.0f + 1e-7f);
+}
+
+void testUnorm16()
+{
+    CHECK(util::quantizeUnorm16(0.0f) == 0);
+    CHECK(util::quantizeUnorm16(1.0f) == 65535);
+    CHECK(util::quantizeUnorm16(-0.5f) == 0);
+    CHECK(util::quantizeUnorm16(1.5f) == 65535);
+
+    float maxError = 0.0f;
+    for (int ii = 0; ii <= 1000; ++ii) {
+        const float value = float(ii) / 1000.0f;
+        maxError = std::max(maxError, std::abs(util::dequantizeUnorm16(util::quantizeUnorm16(value)) - value));
+    }
+    CHECK(maxError <= 0.5f / 65535.0f + 1e-7f);
+}
+
+void testOctahedralRoundTrip()
+{
+    float maxUnquantizedError = 0.0f;
+    float maxAngle = 0.0f;
+    bool unitLength = true;
+    for (const glm::vec3& v : unitVectors()) {
+        const glm::vec2 encoded = util::octahedralEncode(v);
+        unitLength = unitLength && (std::abs(encoded.x) <= 1.0f) && (std::abs(encoded.y) <= 1.0f);
+        maxUnquantizedError = std::max(maxUnquantizedError, glm::length(util::octahedralDecode(encoded) - v));
+
+        const glm::vec3 decoded = util::decodeOctahedralSnorm16(util::encodeOctahedralSnorm16(v));
+        unitLength = unitLength && (std::abs(glm::length(decoded) - 1.0f) < 1e-5f);
+        maxAngle = std::max(maxAngle, angle(decoded, v));
+    }
+    CHECK(unitLength);
+    CHECK(maxUnquantizedError < 1e-5f);
+
+    // Two 16bit components keep every direction within a few thousandths of a degree.
+    CHECK(glm::degrees(maxAngle) < 0.01f);
+}
+
+void testTangentFrameSurvives()
+{
+    // Compact vertices drop the bitangent and rebuild it as cross(normal, tangent), so the decoded
+    // tangent must stay perpendicular to the decoded normal.
+    std::mt19937 generator(11);
+    std::normal_distribution<float> distribution;
+    float maxDot = 0.0f;
+    for (int ii = 0; ii < 10000; ++ii) {
+        const glm::vec3 normal = glm::normalize(glm::vec3(distribution(generator), distribution(generator), distribution(generator)));
+        glm::vec3 tangent = glm::vec3(distribution(generator), distribution(generator), distribution(generator));
+        tangent = glm::normalize(tangent - normal * glm::dot(normal, tangent));
+
+        const glm::vec3 decodedNormal = util::decodeOctahedralSnorm16(util::encodeOctahedralSnorm16(normal));
+        const glm::vec3 decodedTangent = util::decodeOctahedralSnorm16(util::encodeOctahedralSnorm16(tangent));
+        maxDot = std::max(maxDot, std::abs(glm::dot(decodedNormal, decodedTangent)));
+    }
+    CHECK(maxDot < 1e-3f);
+}
+
+void testTexCoordTransform()
+{
+    // Tiling coordinates well outside of [0, 1].
+    const glm::vec2 uvMin(-3.5f, 2.0f);
+    const glm::vec2 uvMax(7.25f, 2.5f);
+    const glm::vec4 transform = util::texCoordTransform(uvMin, uvMax);
+    CHECK(transform == glm::vec4(10.75f, 0.5f, -3.5f, 2.0f));
+
+    // The bounds map onto the ends of the unorm16 range.
+    CHECK((util::quantizeTexCoord(uvMin, transform) == std::array<uint16_t, 2>{ 0, 0 }));
+    CHECK((util::quantizeTexCoord(uvMax, transform) == std::array<uint16_t, 2>{ 65535, 65535 }));
+
+    // The error is relative to the extent of the coordinates on each axis, not their magnitude.
+    glm::vec2 maxError(0.0f);
+    for (int ii = 0; ii <= 1000; ++ii) {
+        const float t = float(ii) / 1000.0f;
+        const glm::vec2 uv = glm::mix(uvMin, uvMax, glm::vec2(t, 1.0f - t));
+        maxError = glm::max(maxError, glm::abs(util::dequantizeTexCoord(util::quantizeTexCoord(uv, transform), transform) - uv));
+    }
+    CHECK(maxError.x <= 10.75f * 0.5f / 65535.0f + 1e-5f);
+    CHECK(maxError.y <= 0.5f * 0.5f / 65535.0f + 1e-6f);
+}
+
+void testDegenerateTexCoords()
+{
+    // All coordinates equal along an axis must not divide by zero and must decode exactly.
+    const glm::vec2 uv(0.25f, -1.0f);
+    const glm::vec4 transform = util::texCoordTransform(uv, uv);
+    CHECK(transform.x > 0.0f && transform.y > 0.0f);
+    const glm::vec2 decoded = util::dequantizeTexCoord(util::quantizeTexCoord(uv, transform), transform);
+    CHECK(decoded == uv);
+
+    const glm::vec4 column = util::texCoordTransform(glm::vec2(0.5f, 0.0f), glm::vec2(0.5f, 4.0f));
+    const glm::vec2 top = util::dequantizeTexCoord(util::quantizeTexCoord(glm::vec2(0.5f, 4.0f), column), column);
+    CHECK(top.x == 0.5f);
+    CHECK(std::abs(top.y - 4.0f) < 1e-6f);
+}
+
+} // namespace.
+
+int main(int, char**)
+{
+    test::init();
+
+    testSnorm16();
+    testUnorm16();
+    testOctahedralRoundTrip();
+    testTangentFrameSurvives();
+    testTexCoordTransform();
+    testDegenerateTexCoords();
+
+    return test::finish();
+}